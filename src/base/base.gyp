@@ -171,6 +171,7 @@
         'file_util_unittest.cc',
         'file_version_info_unittest.cc',
         'gmock_unittest.cc',
+        'hash_unittest.cc',
         'id_map_unittest.cc',
         'i18n/break_iterator_unittest.cc',
         'i18n/char_iterator_unittest.cc',
@@ -182,6 +183,8 @@
         'i18n/string_search_unittest.cc',
         'i18n/time_formatting_unittest.cc',
         'json/json_reader_unittest.cc',
+        'json/json_stream_reader_unittest.cc',
+        'json/json_stream_writer_unittest.cc',
         'json/json_writer_unittest.cc',
         'json/string_escape_unittest.cc',
         'lazy_instance_unittest.cc',
@@ -231,6 +234,7 @@
         'synchronization/cancellation_flag_unittest.cc',
         'synchronization/condition_variable_unittest.cc',
         'synchronization/lock_unittest.cc',
+        'synchronization/mpsc_queue_unittest.cc',
         'synchronization/waitable_event_unittest.cc',
         'synchronization/waitable_event_watcher_unittest.cc',
         'sys_info_unittest.cc',
@@ -384,6 +388,30 @@
         }],
       ],
     },
+    {
+      'target_name': 'base_perftests',
+      'type': 'executable',
+      'dependencies': [
+        'base',
+        'test_support_perf',
+        '../testing/gtest.gyp:gtest',
+      ],
+      'sources': [
+        'debug/trace_event_perftest.cc',
+        'json/json_reader_perftest.cc',
+        'message_loop_perftest.cc',
+        'metrics/histogram_perftest.cc',
+        'threading/worker_pool_posix_perftest.cc',
+        'tracked_objects_perftest.cc',
+      ],
+      'conditions': [
+        ['OS == "win"', {
+          'sources!': [
+            'threading/worker_pool_posix_perftest.cc',
+          ],
+        }],
+      ],
+    },
     {
       'target_name': 'test_support_base',
       'type': 'static_library',
@@ -36,6 +36,15 @@ namespace debug {
 const size_t kTraceEventBufferSize = 500000;
 const size_t kTraceEventBatchSize = 1000;
 
+// Number of events a thread records before handing them off to the TraceLog,
+// and the number of such chunks that fit in the trace buffer.
+const int kTraceEventChunkSize = 128;
+const int kTraceEventMaxChunks = kTraceEventBufferSize / kTraceEventChunkSize;
+
+// The ids of the events recorded by a thread wrap around at this value.
+const int kTraceEventMaxId = kint32max / kTraceEventChunkSize *
+                             kTraceEventChunkSize;
+
 #define TRACE_EVENT_MAX_CATEGORIES 100
 
 static TraceCategory g_categories[TRACE_EVENT_MAX_CATEGORIES] = {
@@ -53,9 +62,6 @@ static const TraceCategory* const g_category_metadata =
     &g_categories[2];
 static int g_category_index = 3; // skip initial 3 categories
 
-// Flag to indicate whether we captured the current thread name
-static ThreadLocalBoolean g_current_thread_name_captured;
-
 ////////////////////////////////////////////////////////////////////////////////
 //
 // TraceValue
@@ -136,6 +142,10 @@ const char* GetPhaseStr(TraceEventPhase phase) {
 
 size_t GetAllocLength(const char* str) { return str ? strlen(str) + 1 : 0; }
 
+bool IsRecordedBefore(const TraceEvent& lhs, const TraceEvent& rhs) {
+  return lhs.timestamp() < rhs.timestamp();
+}
+
 // Copies |*member| into |*buffer|, sets |*member| to point to this new
 // location, and then advances |*buffer| by the amount written.
 void CopyTraceEventParameter(char** buffer,
@@ -271,11 +281,139 @@ TraceLog* TraceLog::GetInstance() {
   return Singleton<TraceLog, StaticMemorySingletonTraits<TraceLog> >::get();
 }
 
+// The events of a chunk are written by the thread that records them, in
+// order, and published by incrementing |size_|. They can be collected under
+// TraceLog::lock_ while the chunk is still being filled: |consumed_| is the
+// number of events already collected. Once full, the chunk is handed off to the
+// TraceLog, and is then only accessed under the lock.
+class TraceLog::EventChunk {
+ public:
+  explicit EventChunk(int first_id)
+      : first_id_(first_id),
+        size_(0),
+        consumed_(0),
+        next_(NULL) {
+    for (int i = 0; i < kTraceEventChunkSize; ++i)
+      dropped_[i] = 0;
+  }
+
+  EventChunk* next() const { return next_; }
+  void set_next(EventChunk* next) { next_ = next; }
+
+  // The following methods are called by the recording thread.
+
+  bool IsFull() const {
+    return subtle::NoBarrier_Load(&size_) == kTraceEventChunkSize;
+  }
+
+  // Returns the id of the event.
+  int AddEvent(const TraceEvent& event) {
+    int index = subtle::NoBarrier_Load(&size_);
+    DCHECK_LT(index, kTraceEventChunkSize);
+    events_[index] = event;
+    subtle::Release_Store(&size_, index + 1);
+    return first_id_ + index;
+  }
+
+  // Returns the event |id| if it is in this chunk and hasn't been collected
+  // yet, or NULL.
+  const TraceEvent* GetUncollectedEvent(int id) const {
+    int index = id - first_id_;
+    if (index < 0 || index >= subtle::NoBarrier_Load(&size_) ||
+        index < subtle::Acquire_Load(&consumed_)) {
+      return NULL;
+    }
+    return &events_[index];
+  }
+
+  // Keeps the event |id|, returned by GetUncollectedEvent(), from being
+  // collected. The event is still collected if that happened in the meantime.
+  void DropEvent(int id) {
+    subtle::Release_Store(&dropped_[id - first_id_], 1);
+  }
+
+  // Called under TraceLog::lock_. Appends the events which haven't been
+  // collected yet to |events|.
+  void CollectEvents(std::vector<TraceEvent>* events) {
+    int size = subtle::Acquire_Load(&size_);
+    int consumed = subtle::NoBarrier_Load(&consumed_);
+    subtle::Release_Store(&consumed_, size);
+    for (int index = consumed; index < size; ++index) {
+      if (!subtle::Acquire_Load(&dropped_[index]))
+        events->push_back(events_[index]);
+    }
+  }
+
+ private:
+  const int first_id_;
+  TraceEvent events_[kTraceEventChunkSize];
+  subtle::Atomic32 dropped_[kTraceEventChunkSize];
+  subtle::Atomic32 size_;
+  subtle::Atomic32 consumed_;
+  EventChunk* next_;
+
+  DISALLOW_COPY_AND_ASSIGN(EventChunk);
+};
+
+// Only used by its thread, except for the chunk being filled, which the
+// TraceLog reads under its lock to collect the events.
+class TraceLog::ThreadEventBuffer {
+ public:
+  ThreadEventBuffer()
+      : process_id_(static_cast<unsigned long>(base::GetCurrentProcId())),
+        thread_id_(PlatformThread::CurrentId()),
+        chunk_(0),
+        next_chunk_id_(0) {
+  }
+
+  ~ThreadEventBuffer() {
+    delete chunk();
+  }
+
+  unsigned long process_id() const { return process_id_; }
+  PlatformThreadId thread_id() const { return thread_id_; }
+
+  EventChunk* chunk() const {
+    return reinterpret_cast<EventChunk*>(subtle::Acquire_Load(&chunk_));
+  }
+  void set_chunk(EventChunk* chunk) {
+    subtle::Release_Store(&chunk_, reinterpret_cast<subtle::AtomicWord>(chunk));
+  }
+
+  // Returns the id of the first event of a new chunk.
+  int TakeChunkId() {
+    int id = next_chunk_id_;
+    next_chunk_id_ = (next_chunk_id_ + kTraceEventChunkSize) % kTraceEventMaxId;
+    return id;
+  }
+
+ private:
+  const unsigned long process_id_;
+  const PlatformThreadId thread_id_;
+  subtle::AtomicWord chunk_;
+  int next_chunk_id_;
+
+  DISALLOW_COPY_AND_ASSIGN(ThreadEventBuffer);
+};
+
 TraceLog::TraceLog()
-    : enabled_(false) {
+    : enabled_(false),
+      buffer_mode_(RECORD_UNTIL_FULL),
+      thread_event_buffer_(&TraceLog::OnThreadExit),
+      handed_off_chunks_(0),
+      num_chunks_(0),
+      buffer_full_(0) {
 }
 
 TraceLog::~TraceLog() {
+  // The threads which are still running no longer delete their buffer.
+  thread_event_buffer_.Free();
+  {
+    AutoLock lock(lock_);
+    TakeHandedOffChunks();
+  }
+  STLDeleteElements(&full_chunks_);
+  STLDeleteElements(&thread_event_buffers_);
 }
 
 const TraceCategory* TraceLog::GetCategory(const char* name) {
@@ -392,12 +530,21 @@ void TraceLog::SetEnabled(bool enabled) {
 }
 
 float TraceLog::GetBufferPercentFull() const {
-  return (float)((double)logged_events_.size()/(double)kTraceEventBufferSize);
+  int num_chunks = std::min(subtle::NoBarrier_Load(&num_chunks_),
+                            kTraceEventMaxChunks);
+  return (float)((double)num_chunks/(double)kTraceEventMaxChunks);
+}
+
+void TraceLog::SetBufferMode(BufferMode mode) {
+  AutoLock lock(lock_);
+  DCHECK(!enabled_);
+  buffer_mode_ = mode;
 }
 
 void TraceLog::SetOutputCallback(const TraceLog::OutputCallback& cb) {
   AutoLock lock(lock_);
   output_callback_ = cb;
+  CollectEvents();
   logged_events_.clear();
 }
 
@@ -411,8 +558,10 @@ void TraceLog::Flush() {
   OutputCallback output_callback_copy;
   {
     AutoLock lock(lock_);
+    CollectEvents();
     previous_logged_events.swap(logged_events_);
     output_callback_copy = output_callback_;
+    subtle::NoBarrier_Store(&buffer_full_, 0);
   }  // release lock
 
   if (output_callback_copy.is_null())
@@ -445,76 +594,45 @@ int TraceLog::AddTraceEvent(TraceEventPhase phase,
 #else
   TimeTicks now = TimeTicks::Now();
 #endif
-  BufferFullCallback buffer_full_callback_copy;
-  int ret_begin_id = -1;
-  {
-    AutoLock lock(lock_);
-    if (!category->enabled)
-      return -1;
-    if (logged_events_.size() >= kTraceEventBufferSize)
+  if (!category->enabled)
+    return -1;
+
+  ThreadEventBuffer* buffer = GetThreadEventBuffer();
+  EventChunk* chunk = buffer->chunk();
+
+  if (threshold_begin_id > -1) {
+    DCHECK(phase == base::debug::TRACE_EVENT_PHASE_END);
+    // The begin event can only be dropped while it is in the chunk being
+    // filled and hasn't been collected; otherwise the end event is added.
+    const TraceEvent* begin_event =
+        chunk ? chunk->GetUncollectedEvent(threshold_begin_id) : NULL;
+    // Determine whether to drop the begin/end pair.
+    if (begin_event &&
+        now - begin_event->timestamp() <
+            TimeDelta::FromMicroseconds(threshold)) {
+      // Remove begin event and do not add end event.
+      chunk->DropEvent(threshold_begin_id);
       return -1;
-
-    PlatformThreadId thread_id = PlatformThread::CurrentId();
-
-    // Record the name of the calling thread, if not done already.
-    if (!g_current_thread_name_captured.Get()) {
-      g_current_thread_name_captured.Set(true);
-      const char* cur_name = PlatformThread::GetName();
-      base::hash_map<PlatformThreadId, std::string>::iterator existing_name =
-          thread_names_.find(thread_id);
-      if (existing_name == thread_names_.end()) {
-        // This is a new thread id, and a new name.
-        thread_names_[thread_id] = cur_name ? cur_name : "";
-      } else if(cur_name != NULL) {
-        // This is a thread id that we've seen before, but potentially with a
-        // new name.
-        std::vector<std::string> existing_names;
-        Tokenize(existing_name->second, std::string(","), &existing_names);
-        bool found = std::find(existing_names.begin(),
-                               existing_names.end(),
-                               cur_name) != existing_names.end();
-        if (!found) {
-          existing_names.push_back(cur_name);
-          thread_names_[thread_id] =
-              JoinString(existing_names, ',');
-        }
-      }
     }
+  }
 
-    if (threshold_begin_id > -1) {
-      DCHECK(phase == base::debug::TRACE_EVENT_PHASE_END);
-      size_t begin_i = static_cast<size_t>(threshold_begin_id);
-      // Return now if there has been a flush since the begin event was posted.
-      if (begin_i >= logged_events_.size())
-        return -1;
-      // Determine whether to drop the begin/end pair.
-      TimeDelta elapsed = now - logged_events_[begin_i].timestamp();
-      if (elapsed < TimeDelta::FromMicroseconds(threshold)) {
-        // Remove begin event and do not add end event.
-        // This will be expensive if there have been other events in the
-        // mean time (should be rare).
-        logged_events_.erase(logged_events_.begin() + begin_i);
-        return -1;
-      }
-    }
-    ret_begin_id = static_cast<int>(logged_events_.size());
-    logged_events_.push_back(
-        TraceEvent(static_cast<unsigned long>(base::GetCurrentProcId()),
-                   thread_id,
-                   now, phase, category, name,
-                   arg1_name, arg1_val,
-                   arg2_name, arg2_val,
-                   flags & EVENT_FLAG_COPY));
-
-    if (logged_events_.size() == kTraceEventBufferSize) {
-      buffer_full_callback_copy = buffer_full_callback_;
+  if (!chunk || chunk->IsFull()) {
+    if (chunk) {
+      buffer->set_chunk(NULL);
+      HandOffChunk(chunk);
     }
-  }  // release lock
-
-  if (!buffer_full_callback_copy.is_null())
-    buffer_full_callback_copy.Run();
-
-  return ret_begin_id;
+    chunk = NewChunk(buffer);
+    if (!chunk)
+      return -1;
+    buffer->set_chunk(chunk);
+  }
+  return chunk->AddEvent(
+      TraceEvent(buffer->process_id(),
+                 buffer->thread_id(),
+                 now, phase, category, name,
+                 arg1_name, arg1_val,
+                 arg2_name, arg2_val,
+                 flags & EVENT_FLAG_COPY));
 }
 
 void TraceLog::AddTraceEventEtw(TraceEventPhase phase,
@@ -544,6 +662,7 @@ void TraceLog::AddTraceEventEtw(TraceEventPhase phase,
 
 void TraceLog::AddCurrentMetadataEvents() {
   lock_.AssertAcquired();
+  CollectEvents();
   for(base::hash_map<PlatformThreadId, std::string>::iterator it =
           thread_names_.begin();
       it != thread_names_.end();
@@ -560,6 +679,162 @@ void TraceLog::AddCurrentMetadataEvents() {
   }
 }
 
+size_t TraceLog::GetEventsSize() {
+  AutoLock lock(lock_);
+  CollectEvents();
+  return logged_events_.size();
+}
+
+TraceLog::ThreadEventBuffer* TraceLog::GetThreadEventBuffer() {
+  ThreadEventBuffer* buffer =
+      static_cast<ThreadEventBuffer*>(thread_event_buffer_.Get());
+  if (buffer)
+    return buffer;
+
+  buffer = new ThreadEventBuffer;
+  thread_event_buffer_.Set(buffer);
+  PlatformThreadId thread_id = buffer->thread_id();
+
+  AutoLock lock(lock_);
+  thread_event_buffers_.push_back(buffer);
+
+  // Record the name of the calling thread.
+  const char* cur_name = PlatformThread::GetName();
+  base::hash_map<PlatformThreadId, std::string>::iterator existing_name =
+      thread_names_.find(thread_id);
+  if (existing_name == thread_names_.end()) {
+    // This is a new thread id, and a new name.
+    thread_names_[thread_id] = cur_name ? cur_name : "";
+  } else if(cur_name != NULL) {
+    // This is a thread id that we've seen before, but potentially with a
+    // new name.
+    std::vector<std::string> existing_names;
+    Tokenize(existing_name->second, std::string(","), &existing_names);
+    bool found = std::find(existing_names.begin(),
+                           existing_names.end(),
+                           cur_name) != existing_names.end();
+    if (!found) {
+      existing_names.push_back(cur_name);
+      thread_names_[thread_id] =
+          JoinString(existing_names, ',');
+    }
+  }
+  return buffer;
+}
+
+// static
+void TraceLog::OnThreadExit(void* buffer) {
+  GetInstance()->DeleteThreadEventBuffer(
+      static_cast<ThreadEventBuffer*>(buffer));
+}
+
+void TraceLog::DeleteThreadEventBuffer(ThreadEventBuffer* buffer) {
+  AutoLock lock(lock_);
+  EventChunk* chunk = buffer->chunk();
+  if (chunk) {
+    buffer->set_chunk(NULL);
+    // Keep the chunks of the thread in order.
+    TakeHandedOffChunks();
+    full_chunks_.push_back(chunk);
+  }
+  thread_event_buffers_.erase(std::find(thread_event_buffers_.begin(),
+                                        thread_event_buffers_.end(), buffer));
+  delete buffer;
+}
+
+TraceLog::EventChunk* TraceLog::NewChunk(ThreadEventBuffer* buffer) {
+  int num_chunks = subtle::NoBarrier_AtomicIncrement(&num_chunks_, 1);
+  if (buffer_mode_ == RECORD_UNTIL_FULL && num_chunks > kTraceEventMaxChunks) {
+    subtle::NoBarrier_AtomicIncrement(&num_chunks_, -1);
+    if (subtle::NoBarrier_CompareAndSwap(&buffer_full_, 0, 1) == 0) {
+      BufferFullCallback buffer_full_callback_copy;
+      {
+        AutoLock lock(lock_);
+        buffer_full_callback_copy = buffer_full_callback_;
+      }  // release lock
+      if (!buffer_full_callback_copy.is_null())
+        buffer_full_callback_copy.Run();
+    }
+    return NULL;
+  }
+  return new EventChunk(buffer->TakeChunkId());
+}
+
+void TraceLog::HandOffChunk(EventChunk* chunk) {
+  subtle::AtomicWord head;
+  do {
+    head = subtle::NoBarrier_Load(&handed_off_chunks_);
+    chunk->set_next(reinterpret_cast<EventChunk*>(head));
+  } while (subtle::Release_CompareAndSwap(
+               &handed_off_chunks_, head,
+               reinterpret_cast<subtle::AtomicWord>(chunk)) != head);
+
+  if (buffer_mode_ == RECORD_CONTINUOUSLY &&
+      subtle::NoBarrier_Load(&num_chunks_) > kTraceEventMaxChunks) {
+    DiscardOldestChunks();
+  }
+}
+
+void TraceLog::TakeHandedOffChunks() {
+  lock_.AssertAcquired();
+  EventChunk* chunk = reinterpret_cast<EventChunk*>(
+      subtle::NoBarrier_AtomicExchange(&handed_off_chunks_, 0));
+  subtle::MemoryBarrier();
+  size_t first_new = full_chunks_.size();
+  for (; chunk; chunk = chunk->next())
+    full_chunks_.push_back(chunk);
+  std::reverse(full_chunks_.begin() + first_new, full_chunks_.end());
+}
+
+void TraceLog::DiscardOldestChunks() {
+  // Recording threads never wait for the lock.
+  if (!lock_.Try())
+    return;
+  TakeHandedOffChunks();
+  while (!full_chunks_.empty() &&
+         subtle::NoBarrier_Load(&num_chunks_) > kTraceEventMaxChunks) {
+    delete full_chunks_.front();
+    full_chunks_.pop_front();
+    subtle::NoBarrier_AtomicIncrement(&num_chunks_, -1);
+  }
+  lock_.Release();
+}
+
+void TraceLog::CollectEvents() {
+  lock_.AssertAcquired();
+  size_t first_new = logged_events_.size();
+
+  TakeHandedOffChunks();
+  for (std::deque<EventChunk*>::iterator it = full_chunks_.begin();
+       it != full_chunks_.end(); ++it) {
+    (*it)->CollectEvents(&logged_events_);
+    delete *it;
+  }
+  subtle::NoBarrier_AtomicIncrement(&num_chunks_,
+                                    -static_cast<int>(full_chunks_.size()));
+  full_chunks_.clear();
+
+  // The chunks still being filled are collected in place.
+  for (std::vector<ThreadEventBuffer*>::iterator it =
+           thread_event_buffers_.begin();
+       it != thread_event_buffers_.end(); ++it) {
+    EventChunk* chunk = (*it)->chunk();
+    if (chunk)
+      chunk->CollectEvents(&logged_events_);
+  }
+
+  // Interleave the events of the threads as they were recorded.
+  std::stable_sort(logged_events_.begin() + first_new, logged_events_.end(),
+                   &IsRecordedBefore);
+
+  if (buffer_mode_ == RECORD_CONTINUOUSLY &&
+      logged_events_.size() > kTraceEventBufferSize) {
+    logged_events_.erase(
+        logged_events_.begin(),
+        logged_events_.end() - kTraceEventBufferSize);
+  }
+}
+
 void TraceLog::DeleteForTesting() {
   DeleteTraceLogForTesting::Delete();
 }
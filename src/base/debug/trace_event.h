@@ -76,16 +76,21 @@
 //
 // Then the category.enabled flag is checked. This is a volatile bool, and
 // not intended to be multithread safe. It optimizes access to AddTraceEvent
-// which is threadsafe internally via TraceLog::lock_. The enabled flag may
-// cause some threads to incorrectly call or skip calling AddTraceEvent near
-// the time of the system being enabled or disabled. This is acceptable as
-// we tolerate some data loss while the system is being enabled/disabled and
-// because AddTraceEvent is threadsafe internally and checks the enabled state
-// again under lock.
+// which is threadsafe internally. The enabled flag may cause some threads to
+// incorrectly call or skip calling AddTraceEvent near the time of the system
+// being enabled or disabled. This is acceptable as we tolerate some data loss
+// while the system is being enabled/disabled and because AddTraceEvent is
+// threadsafe internally and checks the enabled state again.
+//
+// AddTraceEvent records the event in a buffer of the calling thread, without
+// taking any lock. Full buffers are handed off to the TraceLog with atomic
+// operations, and the events are gathered from all the threads when the
+// TraceLog is flushed. TraceLog::lock_ is only taken the first time a thread
+// records an event, and when the buffer limit is reached.
 //
 // Without the use of these static category pointers and enabled flags all
-// trace points would carry a significant performance cost of aquiring a lock
-// and resolving the category.
+// trace points would carry a significant performance cost of resolving the
+// category.
 //
 // ANNOTATE_BENIGN_RACE is used to suppress the warning on the static category
 // pointers.
@@ -97,14 +102,17 @@
 
 #include "build/build_config.h"
 
+#include <deque>
 #include <string>
 #include <vector>
 
+#include "base/atomicops.h"
 #include "base/callback.h"
 #include "base/hash_tables.h"
 #include "base/memory/singleton.h"
 #include "base/string_util.h"
 #include "base/third_party/dynamic_annotations/dynamic_annotations.h"
+#include "base/threading/thread_local_storage.h"
 #include "base/timer.h"
 
 // By default, const char* argument values are assumed to have long-lived scope
@@ -523,6 +531,15 @@ class BASE_EXPORT TraceLog {
     EVENT_FLAG_COPY = 1<<0
   };
 
+  // What to do once the trace buffer holds as many events as it can.
+  enum BufferMode {
+    // Drop the new events, and run the BufferFullCallback.
+    RECORD_UNTIL_FULL,
+    // Discard the oldest events, so that tracing can be left enabled and the
+    // most recent events flushed at any time.
+    RECORD_CONTINUOUSLY
+  };
+
   static TraceLog* GetInstance();
 
   // Get set of known categories. This can change as new code paths are reached.
@@ -547,6 +564,9 @@ class BASE_EXPORT TraceLog {
 
   float GetBufferPercentFull() const;
 
+  // Defaults to RECORD_UNTIL_FULL. Must be called while tracing is disabled.
+  void SetBufferMode(BufferMode mode);
+
   // When enough events are collected, they are handed (in bulk) to
   // the output callback. If no callback is set, the output will be
   // silently dropped. The callback must be thread safe.
@@ -556,7 +576,8 @@ class BASE_EXPORT TraceLog {
 
   // The trace buffer does not flush dynamically, so when it fills up,
   // subsequent trace events will be dropped. This callback is generated when
-  // the trace buffer is full. The callback must be thread safe.
+  // the trace buffer is full, unless it records continuously. The callback
+  // must be thread safe.
   typedef base::Callback<void(void)> BufferFullCallback;
   void SetBufferFullCallback(const BufferFullCallback& cb);
 
@@ -567,8 +588,8 @@ class BASE_EXPORT TraceLog {
   static const TraceCategory* GetCategory(const char* name);
 
   // Called by TRACE_EVENT* macros, don't call this directly.
-  // Returns the index in the internal vector of the event if it was added, or
-  //         -1 if the event was not added.
+  // Returns an id of the event, unique within the calling thread, if it was
+  //         added, or -1 if the event was not added.
   // On end events, the return value of the begin event can be specified along
   // with a threshold in microseconds. If the elapsed time between begin and end
   // is less than the threshold, the begin/end event pair is dropped.
@@ -599,8 +620,9 @@ class BASE_EXPORT TraceLog {
   // Allows resurrecting our singleton instance post-AtExit processing.
   static void Resurrect();
 
-  // Allow tests to inspect TraceEvents.
-  size_t GetEventsSize() const { return logged_events_.size(); }
+  // Allow tests to inspect TraceEvents. GetEventsSize() gathers the events
+  // recorded by all the threads.
+  size_t GetEventsSize();
   const TraceEvent& GetEventAt(size_t index) const {
     DCHECK(index < logged_events_.size());
     return logged_events_[index];
@@ -611,18 +633,73 @@ class BASE_EXPORT TraceLog {
   // by the Singleton class.
   friend struct StaticMemorySingletonTraits<TraceLog>;
 
+  // A fixed number of events recorded by a thread.
+  class EventChunk;
+  // The events being recorded by a thread.
+  class ThreadEventBuffer;
+
   TraceLog();
   ~TraceLog();
   const TraceCategory* GetCategoryInternal(const char* name);
   void AddCurrentMetadataEvents();
 
-  // TODO(nduca): switch to per-thread trace buffers to reduce thread
-  // synchronization.
+  // Returns the buffer of the calling thread, creating it if needed.
+  ThreadEventBuffer* GetThreadEventBuffer();
+
+  // Destructor of |thread_event_buffer_|, which deletes the buffer of a thread
+  // that exits.
+  static void OnThreadExit(void* buffer);
+
+  // Moves the chunk being filled by |buffer| to |full_chunks_|, so that its
+  // events are collected and the chunk is freed by the next flush, and deletes
+  // |buffer|.
+  void DeleteThreadEventBuffer(ThreadEventBuffer* buffer);
+
+  // Returns a new chunk for |buffer|, or NULL if the trace buffer is full.
+  EventChunk* NewChunk(ThreadEventBuffer* buffer);
+
+  // Hands |chunk|, which is full, off to |handed_off_chunks_|.
+  void HandOffChunk(EventChunk* chunk);
+
+  // Moves the chunks of |handed_off_chunks_| to |full_chunks_|. Must be called
+  // under |lock_|.
+  void TakeHandedOffChunks();
+
+  // Discards the oldest full chunks while there are too many chunks, unless
+  // another thread holds |lock_|.
+  void DiscardOldestChunks();
+
+  // Appends the events recorded by all the threads since the last call to
+  // |logged_events_|. Must be called under |lock_|.
+  void CollectEvents();
+
   Lock lock_;
   bool enabled_;
+  BufferMode buffer_mode_;
   OutputCallback output_callback_;
   BufferFullCallback buffer_full_callback_;
+
+  // The events that have been collected from the threads, and not flushed
+  // yet.
   std::vector<TraceEvent> logged_events_;
+
+  // The buffers of the running threads which have recorded events. They are
+  // deleted when their thread exits, or with the TraceLog.
+  ThreadLocalStorage::Slot thread_event_buffer_;
+  std::vector<ThreadEventBuffer*> thread_event_buffers_;
+
+  // Singly linked list of the full chunks handed off by the threads, most
+  // recent first. The threads push onto it with atomic operations, and the
+  // chunks are moved to |full_chunks_|, oldest first, under |lock_|.
+  subtle::AtomicWord handed_off_chunks_;
+  std::deque<EventChunk*> full_chunks_;
+
+  // Number of chunks allocated for the threads and not yet collected, which
+  // bounds the size of the trace buffer.
+  subtle::Atomic32 num_chunks_;
+
+  // Set once the BufferFullCallback has been run, until the next flush.
+  subtle::Atomic32 buffer_full_;
   std::vector<std::string> included_categories_;
   std::vector<std::string> excluded_categories_;
 
@@ -0,0 +1,95 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <string>
+
+#include "base/debug/trace_event.h"
+#include "base/perftimer.h"
+#include "base/stringprintf.h"
+#include "base/threading/simple_thread.h"
+#include "base/time.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace base {
+namespace debug {
+
+namespace {
+
+// Fits in the trace buffer, so that no event is dropped.
+const int kTotalEvents = 400 * 1000;
+const int kMaxThreads = 16;
+
+// Recording an event with tracing enabled must not cost more than this, so
+// that tracing can be left on while profiling.
+const double kMaxNanosecondsPerEvent = 500;
+
+class EventRecorder : public DelegateSimpleThread::Delegate {
+ public:
+  explicit EventRecorder(int num_events) : num_events_(num_events) {}
+
+  virtual void Run() {
+    for (int i = 0; i < num_events_; ++i) {
+      TRACE_EVENT_INSTANT1("perf", "event", "i", i);
+    }
+  }
+
+ private:
+  int num_events_;
+
+  DISALLOW_COPY_AND_ASSIGN(EventRecorder);
+};
+
+// Records kTotalEvents events, split among |num_threads| threads, and returns
+// the time spent per event, in nanoseconds.
+double RecordEvents(int num_threads, int num_events) {
+  int events_per_thread = num_events / num_threads;
+  EventRecorder recorder(events_per_thread);
+  DelegateSimpleThreadPool threads("recorder", num_threads);
+  threads.AddWork(&recorder, num_threads);
+
+  PerfTimer timer;
+  threads.Start();
+  threads.JoinAll();
+  return timer.Elapsed().InMicroseconds() * 1000.0 /
+      (events_per_thread * num_threads);
+}
+
+}  // namespace
+
+TEST(TraceEventPerfTest, Disabled) {
+  TraceLog::GetInstance()->SetEnabled(false);
+  LogPerfResult("TraceEvent_disabled", RecordEvents(1, kTotalEvents),
+                "ns/event");
+}
+
+TEST(TraceEventPerfTest, Enabled) {
+  TraceLog* trace_log = TraceLog::GetInstance();
+  for (int threads = 1; threads <= kMaxThreads; threads *= 4) {
+    trace_log->SetEnabled(true);
+    double ns_per_event = RecordEvents(threads, kTotalEvents);
+    trace_log->SetEnabled(false);
+    LogPerfResult(StringPrintf("TraceEvent_%d_threads", threads).c_str(),
+                  ns_per_event, "ns/event");
+    EXPECT_LT(ns_per_event, kMaxNanosecondsPerEvent);
+  }
+}
+
+// Records several times as many events as the buffer holds.
+TEST(TraceEventPerfTest, RecordContinuously) {
+  TraceLog* trace_log = TraceLog::GetInstance();
+  trace_log->SetBufferMode(TraceLog::RECORD_CONTINUOUSLY);
+  for (int threads = 1; threads <= kMaxThreads; threads *= 4) {
+    trace_log->SetEnabled(true);
+    double ns_per_event = RecordEvents(threads, 5 * kTotalEvents);
+    trace_log->SetEnabled(false);
+    LogPerfResult(
+        StringPrintf("TraceEvent_continuous_%d_threads", threads).c_str(),
+        ns_per_event, "ns/event");
+    EXPECT_LT(ns_per_event, kMaxNanosecondsPerEvent);
+  }
+  trace_log->SetBufferMode(TraceLog::RECORD_UNTIL_FULL);
+}
+
+}  // namespace debug
+}  // namespace base
@@ -619,6 +619,83 @@ TEST_F(TraceEventTestFixture, DataCapturedThreshold) {
   EXPECT_NOT_FIND_BE_("4thresholdlong2");
 }
 
+// Test that a thresholded event is kept whole once its begin event has been
+// handed off by the thread, however short it is.
+TEST_F(TraceEventTestFixture, DataCapturedThresholdManyNestedEvents) {
+  ManualTestSetUp();
+  TraceLog::GetInstance()->SetEnabled(true);
+
+  {
+    TRACE_EVENT_IF_LONGER_THAN0(100000000, "time", "threshold many nested");
+    TraceManyInstantEvents(0, 1000, NULL);
+  }
+  {
+    TRACE_EVENT_IF_LONGER_THAN0(100000000, "time", "threshold few nested");
+    TraceManyInstantEvents(0, 1, NULL);
+  }
+
+  TraceLog::GetInstance()->SetEnabled(false);
+
+  EXPECT_FIND_BE_("threshold many nested");
+  EXPECT_NOT_FIND_BE_("threshold few nested");
+}
+
+void CountBufferFull(int* count) {
+  ++*count;
+}
+
+// Test that events are dropped once the buffer is full, until it is flushed.
+TEST_F(TraceEventTestFixture, BufferFull) {
+  ManualTestSetUp();
+  TraceLog* tracer = TraceLog::GetInstance();
+  // The events are not parsed.
+  tracer->SetOutputCallback(TraceLog::OutputCallback());
+  int buffer_full_count = 0;
+  tracer->SetBufferFullCallback(base::Bind(&CountBufferFull,
+                                           &buffer_full_count));
+  tracer->SetEnabled(true);
+
+  const int num_events = 600000;
+  TraceManyInstantEvents(0, num_events, NULL);
+  EXPECT_EQ(1, buffer_full_count);
+  EXPECT_EQ(1.0f, tracer->GetBufferPercentFull());
+  size_t num_logged_events = tracer->GetEventsSize();
+  EXPECT_GT(num_logged_events, static_cast<size_t>(num_events / 2));
+  EXPECT_LT(num_logged_events, static_cast<size_t>(num_events));
+
+  tracer->Flush();
+  TRACE_EVENT_INSTANT0("all", "after flush");
+  ASSERT_EQ(1u, tracer->GetEventsSize());
+  EXPECT_STREQ("after flush", tracer->GetEventAt(0).name());
+  tracer->SetEnabled(false);
+  EXPECT_EQ(1, buffer_full_count);
+}
+
+// Test that the oldest events are discarded when recording continuously.
+TEST_F(TraceEventTestFixture, RecordContinuously) {
+  ManualTestSetUp();
+  TraceLog* tracer = TraceLog::GetInstance();
+  tracer->SetOutputCallback(TraceLog::OutputCallback());
+  int buffer_full_count = 0;
+  tracer->SetBufferFullCallback(base::Bind(&CountBufferFull,
+                                           &buffer_full_count));
+  tracer->SetBufferMode(TraceLog::RECORD_CONTINUOUSLY);
+  tracer->SetEnabled(true);
+
+  const int num_events = 600000;
+  TRACE_EVENT_INSTANT0("all", "first");
+  TraceManyInstantEvents(0, num_events, NULL);
+  TRACE_EVENT_INSTANT0("all", "last");
+  EXPECT_EQ(0, buffer_full_count);
+
+  size_t num_logged_events = tracer->GetEventsSize();
+  EXPECT_GT(num_logged_events, static_cast<size_t>(num_events / 2));
+  EXPECT_LT(num_logged_events, static_cast<size_t>(num_events));
+  EXPECT_STRNE("first", tracer->GetEventAt(0).name());
+  EXPECT_STREQ("last", tracer->GetEventAt(num_logged_events - 1).name());
+  tracer->SetEnabled(false);
+}
+
 // Test that static strings are not copied.
 TEST_F(TraceEventTestFixture, StaticStringVsString) {
   ManualTestSetUp();
@@ -724,6 +801,36 @@ TEST_F(TraceEventTestFixture, DataCapturedManyThreads) {
                                            num_threads, num_events);
 }
 
+// Test that the events of threads which exited are still collected, and that
+// their chunks no longer count against the buffer once they are.
+TEST_F(TraceEventTestFixture, ThreadExit) {
+  ManualTestSetUp();
+  TraceLog* tracer = TraceLog::GetInstance();
+  tracer->SetOutputCallback(TraceLog::OutputCallback());
+  tracer->SetEnabled(true);
+
+  // Each thread fills only part of a chunk.
+  const int num_threads = 8;
+  const int num_events = 10;
+  for (int i = 0; i < num_threads; i++) {
+    Thread thread(StringPrintf("Thread %d", i).c_str());
+    WaitableEvent task_complete_event(false, false);
+    thread.Start();
+    thread.message_loop()->PostTask(
+        FROM_HERE, base::Bind(&TraceManyInstantEvents,
+                              i, num_events, &task_complete_event));
+    task_complete_event.Wait();
+    thread.Stop();
+  }
+
+  EXPECT_GT(tracer->GetBufferPercentFull(), 0.0f);
+  // The threads record a few more events of their own.
+  EXPECT_LE(static_cast<size_t>(num_threads * num_events),
+            tracer->GetEventsSize());
+  EXPECT_EQ(0.0f, tracer->GetBufferPercentFull());
+  tracer->SetEnabled(false);
+}
+
 // Test that thread and process names show up in the trace
 TEST_F(TraceEventTestFixture, ThreadNames) {
   ManualTestSetUp();
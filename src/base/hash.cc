@@ -0,0 +1,16 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/hash.h"
+
+namespace base {
+
+uint32 HashFNV1a(const char* data, size_t length) {
+  uint32 hash = kFNV1aOffsetBasis;
+  for (size_t i = 0; i < length; ++i)
+    hash = HashFNV1aByte(hash, static_cast<uint8>(data[i]));
+  return hash;
+}
+
+}  // namespace base
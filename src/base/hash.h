@@ -0,0 +1,34 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef BASE_HASH_H_
+#define BASE_HASH_H_
+#pragma once
+
+#include <stddef.h>
+
+#include "base/base_export.h"
+#include "base/basictypes.h"
+
+namespace base {
+
+// The 32-bit FNV-1a hash (http://www.isthe.com/chongo/tech/comp/fnv/). It is
+// fast and spreads short strings well, but it is not a cryptographic hash.
+
+// Initial value of the hash.
+const uint32 kFNV1aOffsetBasis = 2166136261U;
+
+// Adds |byte| to |hash|. Callers that need to transform the input on the fly
+// (for instance, to fold the case of letters) can hash one byte at a time,
+// starting with kFNV1aOffsetBasis.
+inline uint32 HashFNV1aByte(uint32 hash, uint8 byte) {
+  return (hash ^ byte) * 16777619U;
+}
+
+// Computes the FNV-1a hash of the |length| bytes in |data|.
+BASE_EXPORT uint32 HashFNV1a(const char* data, size_t length);
+
+}  // namespace base
+
+#endif  // BASE_HASH_H_
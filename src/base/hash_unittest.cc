@@ -0,0 +1,28 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/hash.h"
+
+#include <string>
+
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace base {
+
+TEST(HashTest, FNV1aKnownValues) {
+  // Test vectors from the reference implementation.
+  EXPECT_EQ(0x811c9dc5U, HashFNV1a("", 0));
+  EXPECT_EQ(0xe40c292cU, HashFNV1a("a", 1));
+  EXPECT_EQ(0xbf9cf968U, HashFNV1a("foobar", 6));
+}
+
+TEST(HashTest, FNV1aBytesMatchHash) {
+  const std::string input("Content-Type\0 with a nul", 24);
+  uint32 hash = kFNV1aOffsetBasis;
+  for (size_t i = 0; i < input.size(); ++i)
+    hash = HashFNV1aByte(hash, static_cast<uint8>(input[i]));
+  EXPECT_EQ(HashFNV1a(input.data(), input.size()), hash);
+}
+
+}  // namespace base
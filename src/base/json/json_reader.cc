@@ -4,20 +4,22 @@
 
 #include "base/json/json_reader.h"
 
+#include <string.h>
+
 #include "base/float_util.h"
 #include "base/logging.h"
 #include "base/memory/scoped_ptr.h"
 #include "base/stringprintf.h"
 #include "base/string_number_conversions.h"
 #include "base/string_util.h"
-#include "base/utf_string_conversions.h"
+#include "base/utf_string_conversion_utils.h"
 #include "base/values.h"
 
 namespace {
 
-const wchar_t kNullString[] = L"null";
-const wchar_t kTrueString[] = L"true";
-const wchar_t kFalseString[] = L"false";
+const char kNullString[] = "null";
+const char kTrueString[] = "true";
+const char kFalseString[] = "false";
 
 const int kStackLimit = 100;
 
@@ -25,11 +27,11 @@ const int kStackLimit = 100;
 // token.  The method returns false if there is no valid integer at the end of
 // the token.
 bool ReadInt(base::JSONReader::Token& token, bool can_have_leading_zeros) {
-  wchar_t first = token.NextChar();
+  char first = token.NextChar();
   int len = 0;
 
   // Read in more digits.
-  wchar_t c = first;
+  char c = first;
   while ('\0' != c && IsAsciiDigit(c)) {
     ++token.length;
     ++len;
@@ -50,7 +52,7 @@ bool ReadInt(base::JSONReader::Token& token, bool can_have_leading_zeros) {
 // the method returns false.
 bool ReadHexDigits(base::JSONReader::Token& token, int digits) {
   for (int i = 1; i <= digits; ++i) {
-    wchar_t c = *(token.begin + token.length + i);
+    char c = *(token.begin + token.length + i);
     if ('\0' == c)
       return false;
     if (!IsHexDigit(c))
@@ -61,6 +63,23 @@ bool ReadHexDigits(base::JSONReader::Token& token, int digits) {
   return true;
 }
 
+// Returns the value of the |digits| hex digits at |pos|, which
+// ParseStringToken has checked.
+uint32 HexDigitsToInt(const char* pos, int digits) {
+  uint32 value = 0;
+  for (int i = 0; i < digits; ++i)
+    value = (value << 4) + HexDigitToInt(pos[i]);
+  return value;
+}
+
+bool IsLeadSurrogate(uint32 code_unit) {
+  return code_unit >= 0xD800 && code_unit <= 0xDBFF;
+}
+
+bool IsTrailSurrogate(uint32 code_unit) {
+  return code_unit >= 0xDC00 && code_unit <= 0xDFFF;
+}
+
 }  // namespace
 
 namespace base {
@@ -155,19 +174,16 @@ Value* JSONReader::JsonToValue(const std::string& json, bool check_root,
     return NULL;
   }
 
-  // The conversion from UTF8 to wstring removes null bytes for us
-  // (a good thing).
-  std::wstring json_wide(UTF8ToWide(json));
-  start_pos_ = json_wide.c_str();
-
-  // When the input JSON string starts with a UTF-8 Byte-Order-Mark
-  // (0xEF, 0xBB, 0xBF), the UTF8ToWide() function converts it to a Unicode
-  // BOM (U+FEFF). To avoid the JSONReader::BuildValue() function from
-  // mis-treating a Unicode BOM as an invalid character and returning NULL,
-  // skip a converted Unicode BOM if it exists.
-  if (!json_wide.empty() && start_pos_[0] == 0xFEFF) {
-    ++start_pos_;
-  }
+  // Parse the UTF-8 input in place; converting a large document to another
+  // encoding first would double the memory it takes.  Parsing stops at the
+  // first null byte.
+  start_pos_ = json.c_str();
+
+  // To avoid the JSONReader::BuildValue() function from mis-treating a UTF-8
+  // Byte-Order-Mark (0xEF, 0xBB, 0xBF) as an invalid character and returning
+  // NULL, skip it if it exists.
+  if (json.compare(0, 3, "\xEF\xBB\xBF") == 0)
+    start_pos_ += 3;
 
   json_pos_ = start_pos_;
   allow_trailing_comma_ = allow_trailing_comma;
@@ -241,10 +257,13 @@ Value* JSONReader::BuildValue(bool is_root) {
       break;
 
     case Token::STRING:
-      node.reset(DecodeString(token));
-      if (!node.get())
-        return NULL;
-      break;
+      {
+        std::string decoded;
+        if (!DecodeString(token, &decoded))
+          return NULL;
+        node.reset(Value::CreateStringValue(decoded));
+        break;
+      }
 
     case Token::ARRAY_BEGIN:
       {
@@ -289,21 +308,17 @@ Value* JSONReader::BuildValue(bool is_root) {
         json_pos_ += token.length;
         token = ParseToken();
 
-        node.reset(new DictionaryValue);
+        DictionaryValue* dict = new DictionaryValue;
+        node.reset(dict);
+        std::string dict_key;
         while (token.type != Token::OBJECT_END) {
           if (token.type != Token::STRING) {
             SetErrorCode(JSON_UNQUOTED_DICTIONARY_KEY, json_pos_);
             return NULL;
           }
-          scoped_ptr<Value> dict_key_value(DecodeString(token));
-          if (!dict_key_value.get())
+          if (!DecodeString(token, &dict_key))
             return NULL;
 
-          // Convert the key into a wstring.
-          std::string dict_key;
-          bool success = dict_key_value->GetAsString(&dict_key);
-          DCHECK(success);
-
           json_pos_ += token.length;
           token = ParseToken();
           if (token.type != Token::OBJECT_PAIR_SEPARATOR)
@@ -314,8 +329,9 @@ Value* JSONReader::BuildValue(bool is_root) {
           Value* dict_value = BuildValue(false);
           if (!dict_value)
             return NULL;
-          static_cast<DictionaryValue*>(node.get())->SetWithoutPathExpansion(
-              dict_key, dict_value);
+          // Sorting the entries once the object is complete is much cheaper
+          // than inserting each of them in order.
+          dict->AppendUnsorted(&dict_key, dict_value);
 
           // After a key/value pair, we expect a comma or the end of the
           // object.
@@ -341,6 +357,7 @@ Value* JSONReader::BuildValue(bool is_root) {
         if (token.type != Token::OBJECT_END)
           return NULL;
 
+        dict->SortEntries();
         break;
       }
 
@@ -358,7 +375,7 @@ JSONReader::Token JSONReader::ParseNumberToken() {
   // We just grab the number here.  We validate the size in DecodeNumber.
   // According   to RFC4627, a valid number is: [minus] int [frac] [exp]
   Token token(Token::NUMBER, json_pos_, 0);
-  wchar_t c = *json_pos_;
+  char c = *json_pos_;
   if ('-' == c) {
     ++token.length;
     c = token.NextChar();
@@ -392,14 +409,14 @@ JSONReader::Token JSONReader::ParseNumberToken() {
 }
 
 Value* JSONReader::DecodeNumber(const Token& token) {
-  const std::wstring num_string(token.begin, token.length);
+  const std::string num_string(token.begin, token.length);
 
   int num_int;
-  if (StringToInt(WideToUTF8(num_string), &num_int))
+  if (StringToInt(num_string, &num_int))
     return Value::CreateIntegerValue(num_int);
 
   double num_double;
-  if (StringToDouble(WideToUTF8(num_string), &num_double) &&
+  if (StringToDouble(num_string, &num_double) &&
       base::IsFinite(num_double))
     return Value::CreateDoubleValue(num_double);
 
@@ -408,7 +425,7 @@ Value* JSONReader::DecodeNumber(const Token& token) {
 
 JSONReader::Token JSONReader::ParseStringToken() {
   Token token(Token::STRING, json_pos_, 1);
-  wchar_t c = token.NextChar();
+  char c = token.NextChar();
   while ('\0' != c) {
     if ('\\' == c) {
       ++token.length;
@@ -451,65 +468,83 @@ JSONReader::Token JSONReader::ParseStringToken() {
   return Token::CreateInvalidToken();
 }
 
-Value* JSONReader::DecodeString(const Token& token) {
-  std::wstring decoded_str;
-  decoded_str.reserve(token.length - 2);
+bool JSONReader::DecodeString(const Token& token, std::string* decoded) {
+  const char* begin = token.begin + 1;
+  const char* end = token.begin + token.length - 1;
+  // Most strings have no escapes; the input is UTF-8 already.
+  if (!memchr(begin, '\\', end - begin)) {
+    decoded->assign(begin, end);
+    return true;
+  }
 
-  for (int i = 1; i < token.length - 1; ++i) {
-    wchar_t c = *(token.begin + i);
-    if ('\\' == c) {
-      ++i;
-      c = *(token.begin + i);
-      switch (c) {
-        case '"':
-        case '/':
-        case '\\':
-          decoded_str.push_back(c);
-          break;
-        case 'b':
-          decoded_str.push_back('\b');
-          break;
-        case 'f':
-          decoded_str.push_back('\f');
-          break;
-        case 'n':
-          decoded_str.push_back('\n');
-          break;
-        case 'r':
-          decoded_str.push_back('\r');
-          break;
-        case 't':
-          decoded_str.push_back('\t');
-          break;
-        case 'v':
-          decoded_str.push_back('\v');
-          break;
+  decoded->clear();
+  decoded->reserve(end - begin);
+  for (const char* pos = begin; pos < end; ++pos) {
+    char c = *pos;
+    if ('\\' != c) {
+      // Not escaped
+      decoded->push_back(c);
+      continue;
+    }
+    ++pos;
+    c = *pos;
+    switch (c) {
+      case '"':
+      case '/':
+      case '\\':
+        decoded->push_back(c);
+        break;
+      case 'b':
+        decoded->push_back('\b');
+        break;
+      case 'f':
+        decoded->push_back('\f');
+        break;
+      case 'n':
+        decoded->push_back('\n');
+        break;
+      case 'r':
+        decoded->push_back('\r');
+        break;
+      case 't':
+        decoded->push_back('\t');
+        break;
+      case 'v':
+        decoded->push_back('\v');
+        break;
 
-        case 'x':
-          decoded_str.push_back((HexDigitToInt(*(token.begin + i + 1)) << 4) +
-                                HexDigitToInt(*(token.begin + i + 2)));
-          i += 2;
-          break;
-        case 'u':
-          decoded_str.push_back((HexDigitToInt(*(token.begin + i + 1)) << 12 ) +
-                                (HexDigitToInt(*(token.begin + i + 2)) << 8) +
-                                (HexDigitToInt(*(token.begin + i + 3)) << 4) +
-                                HexDigitToInt(*(token.begin + i + 4)));
-          i += 4;
+      case 'x':
+        WriteUnicodeCharacter(HexDigitsToInt(pos + 1, 2), decoded);
+        pos += 2;
+        break;
+      case 'u':
+        {
+          // \u escapes are UTF-16 code units; combine surrogate pairs.
+          uint32 code_point = HexDigitsToInt(pos + 1, 4);
+          pos += 4;
+          if (IsLeadSurrogate(code_point) && end - pos > 6 &&
+              pos[1] == '\\' && pos[2] == 'u') {
+            uint32 trail = HexDigitsToInt(pos + 3, 4);
+            if (IsTrailSurrogate(trail)) {
+              code_point =
+                  0x10000 + ((code_point - 0xD800) << 10) + (trail - 0xDC00);
+              pos += 6;
+            }
+          }
+          if (!IsValidCodepoint(code_point))
+            code_point = 0xFFFD;
+          WriteUnicodeCharacter(code_point, decoded);
           break;
+        }
 
-        default:
-          // We should only have valid strings at this point.  If not,
-          // ParseStringToken didn't do it's job.
-          NOTREACHED();
-          return NULL;
-      }
-    } else {
-      // Not escaped
-      decoded_str.push_back(c);
+      default:
+        // We should only have valid strings at this point.  If not,
+        // ParseStringToken didn't do it's job.
+        NOTREACHED();
+        return false;
     }
   }
-  return Value::CreateStringValue(WideToUTF16Hack(decoded_str));
+  return true;
 }
 
 JSONReader::Token JSONReader::ParseToken() {
@@ -606,7 +641,7 @@ bool JSONReader::EatComment() {
   if ('/' != *json_pos_)
     return false;
 
-  wchar_t next_char = *(json_pos_ + 1);
+  char next_char = *(json_pos_ + 1);
   if ('/' == next_char) {
     // Line comment, read until \n or \r
     json_pos_ += 2;
@@ -636,17 +671,18 @@ bool JSONReader::EatComment() {
   return true;
 }
 
-bool JSONReader::NextStringMatch(const wchar_t* str, size_t length) {
-  return wcsncmp(json_pos_, str, length) == 0;
+bool JSONReader::NextStringMatch(const char* str, size_t length) {
+  return strncmp(json_pos_, str, length) == 0;
 }
 
 void JSONReader::SetErrorCode(JsonParseError error,
-                              const wchar_t* error_pos) {
+                              const char* error_pos) {
   int line_number = 1;
   int column_number = 1;
 
-  // Figure out the line and column the error occured at.
-  for (const wchar_t* pos = start_pos_; pos != error_pos; ++pos) {
+  // Figure out the line and column the error occured at.  Columns count
+  // characters, so skip the continuation bytes of UTF-8 sequences.
+  for (const char* pos = start_pos_; pos != error_pos; ++pos) {
     if (*pos == '\0') {
       NOTREACHED();
       return;
@@ -655,7 +691,7 @@ void JSONReader::SetErrorCode(JsonParseError error,
     if (*pos == '\n') {
       ++line_number;
       column_number = 1;
-    } else {
+    } else if ((*pos & 0xC0) != 0x80) {
       ++column_number;
     }
   }
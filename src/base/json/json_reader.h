@@ -18,8 +18,8 @@
 //   UTF-8 string for the JSONReader::JsonToValue() function may start with a
 //   UTF-8 BOM (0xEF, 0xBB, 0xBF).
 //   To avoid the function from mis-treating a UTF-8 BOM as an invalid
-//   character, the function skips a Unicode BOM at the beginning of the
-//   Unicode string (converted from the input UTF-8 string) before parsing it.
+//   character, the function skips a UTF-8 BOM at the beginning of the input
+//   before parsing it.
 //
 // TODO(tc): Add a parsing option to to relax object keys being wrapped in
 //   double quotes
@@ -65,11 +65,11 @@ class BASE_EXPORT JSONReader {
      INVALID_TOKEN,
     };
 
-    Token(Type t, const wchar_t* b, int len)
+    Token(Type t, const char* b, int len)
         : type(t), begin(b), length(len) {}
 
     // Get the character that's one past the end of this token.
-    wchar_t NextChar() {
+    char NextChar() {
       return *(begin + length);
     }
 
@@ -80,7 +80,7 @@ class BASE_EXPORT JSONReader {
     Type type;
 
     // A pointer into JSONReader::json_pos_ that's the beginning of this token.
-    const wchar_t* begin;
+    const char* begin;
 
     // End should be one char past the end of the token.
     int length;
@@ -152,6 +152,9 @@ class BASE_EXPORT JSONReader {
   FRIEND_TEST(JSONReaderTest, Reading);
   FRIEND_TEST(JSONReaderTest, ErrorMessages);
 
+  // JSONStreamReader decodes strings and formats error messages like we do.
+  friend class JSONStreamReader;
+
   static std::string FormatErrorMessage(int line, int column,
                                         const std::string& description);
 
@@ -173,12 +176,14 @@ class BASE_EXPORT JSONReader {
   // Parses a sequence of characters into a Token::STRING. If the sequence of
   // characters is not a valid string, returns a Token::INVALID_TOKEN. Note
   // that DecodeString is used to actually decode the escaped string into an
-  // actual wstring.
+  // actual UTF-8 string.
   Token ParseStringToken();
 
-  // Convert the substring into a value string.  This should always succeed
-  // (otherwise ParseStringToken would have failed).
-  Value* DecodeString(const Token& token);
+  // Decodes the escape sequences of the string that |token| holds into
+  // |decoded|.  This should always succeed (otherwise ParseStringToken would
+  // have failed).  Strings without escapes are copied as is, since the input
+  // is already UTF-8.
+  static bool DecodeString(const Token& token, std::string* decoded);
 
   // Grabs the next token in the JSON stream.  This does not increment the
   // stream so it can be used to look ahead at the next token.
@@ -192,17 +197,18 @@ class BASE_EXPORT JSONReader {
   bool EatComment();
 
   // Checks if |json_pos_| matches str.
-  bool NextStringMatch(const wchar_t* str, size_t length);
+  bool NextStringMatch(const char* str, size_t length);
 
   // Sets the error code that will be returned to the caller. The current
   // line and column are determined and added into the final message.
-  void SetErrorCode(const JsonParseError error, const wchar_t* error_pos);
+  void SetErrorCode(const JsonParseError error, const char* error_pos);
 
-  // Pointer to the starting position in the input string.
-  const wchar_t* start_pos_;
+  // Pointer to the starting position in the input string.  The input is parsed
+  // in place, without converting it to another encoding first.
+  const char* start_pos_;
 
   // Pointer to the current position in the input string.
-  const wchar_t* json_pos_;
+  const char* json_pos_;
 
   // Used to keep track of how many nested lists/dicts there are.
   int stack_depth_;
@@ -0,0 +1,295 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <stdlib.h>
+
+#include <new>
+#include <string>
+
+#include "base/atomicops.h"
+#include "base/file_util.h"
+#include "base/json/json_reader.h"
+#include "base/json/json_stream_reader.h"
+#include "base/json/json_stream_writer.h"
+#include "base/json/json_writer.h"
+#include "base/memory/scoped_ptr.h"
+#include "base/perftimer.h"
+#include "base/scoped_temp_dir.h"
+#include "base/stringprintf.h"
+#include "base/values.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace {
+
+// Every allocation of the test binary goes through the operators below, which
+// keep |kHeaderSize| bytes in front of the block to remember its size.
+const size_t kHeaderSize = 16;
+
+base::subtle::AtomicWord g_allocations = 0;
+base::subtle::AtomicWord g_live_bytes = 0;
+base::subtle::AtomicWord g_peak_bytes = 0;
+
+void* CountedAlloc(size_t size) {
+  char* block = static_cast<char*>(malloc(size + kHeaderSize));
+  if (!block)
+    abort();
+  *reinterpret_cast<size_t*>(block) = size;
+
+  base::subtle::NoBarrier_AtomicIncrement(&g_allocations, 1);
+  base::subtle::AtomicWord live =
+      base::subtle::NoBarrier_AtomicIncrement(&g_live_bytes, size);
+  base::subtle::AtomicWord peak = base::subtle::NoBarrier_Load(&g_peak_bytes);
+  while (live > peak) {
+    base::subtle::AtomicWord old_peak =
+        base::subtle::NoBarrier_CompareAndSwap(&g_peak_bytes, peak, live);
+    if (old_peak == peak)
+      break;
+    peak = old_peak;
+  }
+  return block + kHeaderSize;
+}
+
+void CountedFree(void* ptr) {
+  if (!ptr)
+    return;
+  char* block = static_cast<char*>(ptr) - kHeaderSize;
+  base::subtle::AtomicWord size = *reinterpret_cast<size_t*>(block);
+  base::subtle::NoBarrier_AtomicIncrement(&g_live_bytes, -size);
+  free(block);
+}
+
+}  // namespace
+
+void* operator new(size_t size) {
+  return CountedAlloc(size);
+}
+
+void* operator new[](size_t size) {
+  return CountedAlloc(size);
+}
+
+void operator delete(void* ptr) {
+  CountedFree(ptr);
+}
+
+void operator delete[](void* ptr) {
+  CountedFree(ptr);
+}
+
+namespace base {
+
+namespace {
+
+// Appends a bookmark-like object, with its keys in the order a hand-written
+// file would have them rather than sorted.
+void AppendBookmark(int id, std::string* json) {
+  StringAppendF(json,
+                "{\"url\":\"http://www.example.com/%d/index.html?q=%x\","
+                "\"name\":\"Example page number %d \\u00e9t\\u00e9\","
+                "\"type\":\"url\",\"id\":\"%d\","
+                "\"date_added\":\"12958%011d\",\"visits\":%d,"
+                "\"score\":%d.%d,\"starred\":%s}",
+                id, id * 7919, id, id, id, id % 97, id % 13, id % 10,
+                id % 3 ? "true" : "false");
+}
+
+// Returns a document of about |size| bytes that looks like the bookmarks and
+// preferences files: a long list of small objects, and a large dictionary
+// keyed by ids.
+std::string MakeDocument(size_t size) {
+  std::string json("{\"version\":1,\"roots\":{\"other\":{\"children\":[");
+  int id = 0;
+  while (json.size() < size / 2) {
+    if (id)
+      json.push_back(',');
+    AppendBookmark(id++, &json);
+  }
+  json.append("],\"type\":\"folder\",\"name\":\"Other\"}},"
+              "\"sites\":{");
+  bool first = true;
+  while (json.size() < size) {
+    if (!first)
+      json.push_back(',');
+    first = false;
+    // Ids hash the keys out of order.
+    StringAppendF(&json, "\"site-%08x\":", (id++ * 2654435761U));
+    AppendBookmark(id, &json);
+  }
+  json.append("}}");
+  return json;
+}
+
+// Measures the time, the peak heap and the number of allocations between its
+// construction and Log().
+class HeapPerfTimer {
+ public:
+  HeapPerfTimer()
+      : start_bytes_(base::subtle::NoBarrier_Load(&g_live_bytes)),
+        start_allocations_(base::subtle::NoBarrier_Load(&g_allocations)) {
+    base::subtle::NoBarrier_Store(&g_peak_bytes, start_bytes_);
+  }
+
+  // Logs the results as |name|_time, |name|_peak_heap and |name|_allocations.
+  void Log(const std::string& name) {
+    double ms = timer_.Elapsed().InMillisecondsF();
+    double peak_mb =
+        (base::subtle::NoBarrier_Load(&g_peak_bytes) - start_bytes_) /
+        (1024.0 * 1024.0);
+    int allocations = static_cast<int>(
+        base::subtle::NoBarrier_Load(&g_allocations) - start_allocations_);
+    LogPerfResult((name + "_time").c_str(), ms, "ms");
+    LogPerfResult((name + "_peak_heap").c_str(), peak_mb, "MB");
+    LogPerfResult((name + "_allocations").c_str(), allocations, "allocations");
+  }
+
+ private:
+  const base::subtle::AtomicWord start_bytes_;
+  const base::subtle::AtomicWord start_allocations_;
+  PerfTimer timer_;
+
+  DISALLOW_COPY_AND_ASSIGN(HeapPerfTimer);
+};
+
+// Counts the values of a document, so that the streaming parser has a
+// consumer that does a minimum of work.
+class ValueCounter : public JSONStreamReader::Delegate {
+ public:
+  ValueCounter() : count_(0) {}
+
+  int count() const { return count_; }
+
+  virtual void OnObjectBegin() { ++count_; }
+  virtual void OnObjectKey(const std::string& key) {}
+  virtual void OnObjectEnd() {}
+  virtual void OnArrayBegin() { ++count_; }
+  virtual void OnArrayEnd() {}
+  virtual void OnString(const std::string& value) { ++count_; }
+  virtual void OnInteger(int value) { ++count_; }
+  virtual void OnDouble(double value) { ++count_; }
+  virtual void OnBoolean(bool value) { ++count_; }
+  virtual void OnNull() { ++count_; }
+
+ private:
+  int count_;
+
+  DISALLOW_COPY_AND_ASSIGN(ValueCounter);
+};
+
+// The size of the chunks the streaming benchmarks read files in.
+const size_t kChunkSize = 64 * 1024;
+
+// Parses a document of |megabytes| MB and logs the time it took, the heap it
+// used at most on top of the input, and the number of allocations.
+void RunBenchmark(int megabytes) {
+  std::string json = MakeDocument(megabytes * 1024 * 1024);
+
+  HeapPerfTimer timer;
+  scoped_ptr<Value> root(JSONReader::Read(json, false));
+  timer.Log(StringPrintf("JSONReader_parse_%dMB", megabytes));
+  ASSERT_TRUE(root.get());
+  ASSERT_TRUE(root->IsType(Value::TYPE_DICTIONARY));
+
+  // Free the tree before the next, larger document is built.
+  PerfTimer free_timer;
+  root.reset();
+  LogPerfResult(StringPrintf("JSONReader_free_%dMB", megabytes).c_str(),
+                free_timer.Elapsed().InMillisecondsF(), "ms");
+}
+
+// Reads a file of |megabytes| MB whole and parses it into a tree, then reads
+// it in chunks with JSONStreamReader.
+void RunReadFileBenchmark(int megabytes) {
+  ScopedTempDir temp_dir;
+  ASSERT_TRUE(temp_dir.CreateUniqueTempDir());
+  FilePath path = temp_dir.path().AppendASCII("document.json");
+  {
+    std::string json = MakeDocument(megabytes * 1024 * 1024);
+    ASSERT_EQ(static_cast<int>(json.size()),
+              file_util::WriteFile(path, json.data(), json.size()));
+  }
+
+  {
+    HeapPerfTimer timer;
+    std::string json;
+    ASSERT_TRUE(file_util::ReadFileToString(path, &json));
+    scoped_ptr<Value> root(JSONReader::Read(json, false));
+    timer.Log(StringPrintf("JSONReader_read_file_%dMB", megabytes));
+    ASSERT_TRUE(root.get());
+  }
+
+  {
+    HeapPerfTimer timer;
+    FILE* file = file_util::OpenFile(path, "rb");
+    ASSERT_TRUE(file);
+    ValueCounter counter;
+    JSONStreamReader reader(&counter, false);
+    scoped_array<char> buffer(new char[kChunkSize]);
+    size_t length;
+    bool success = true;
+    while (success && (length = fread(buffer.get(), 1, kChunkSize, file)) > 0)
+      success = reader.Parse(buffer.get(), length);
+    success = success && reader.Finish();
+    file_util::CloseFile(file);
+    timer.Log(StringPrintf("JSONStreamReader_read_file_%dMB", megabytes));
+    ASSERT_TRUE(success) << reader.GetErrorMessage();
+    ASSERT_GT(counter.count(), 0);
+  }
+}
+
+// Writes a tree of |megabytes| MB to a file with JSONWriter, then with
+// JSONStreamWriter.
+void RunWriteFileBenchmark(int megabytes) {
+  ScopedTempDir temp_dir;
+  ASSERT_TRUE(temp_dir.CreateUniqueTempDir());
+  FilePath path = temp_dir.path().AppendASCII("document.json");
+  scoped_ptr<Value> root(
+      JSONReader::Read(MakeDocument(megabytes * 1024 * 1024), false));
+  ASSERT_TRUE(root.get());
+
+  {
+    HeapPerfTimer timer;
+    std::string json;
+    JSONWriter::Write(root.get(), false, &json);
+    ASSERT_EQ(static_cast<int>(json.size()),
+              file_util::WriteFile(path, json.data(), json.size()));
+    timer.Log(StringPrintf("JSONWriter_write_file_%dMB", megabytes));
+  }
+
+  {
+    HeapPerfTimer timer;
+    FILE* file = file_util::OpenFile(path, "wb");
+    ASSERT_TRUE(file);
+    JSONStreamWriter::FileOutput output(file);
+    JSONStreamWriter writer(&output, false);
+    writer.WriteValue(root.get());
+    bool success = writer.Flush();
+    file_util::CloseFile(file);
+    timer.Log(StringPrintf("JSONStreamWriter_write_file_%dMB", megabytes));
+    ASSERT_TRUE(success);
+  }
+}
+
+}  // namespace
+
+TEST(JSONReaderPerfTest, Read) {
+  RunBenchmark(1);
+  RunBenchmark(10);
+  RunBenchmark(50);
+}
+
+// The streaming API is measured here as well, since the allocations can only
+// be counted in one file of the binary.
+TEST(JSONStreamPerfTest, ReadFile) {
+  RunReadFileBenchmark(1);
+  RunReadFileBenchmark(10);
+  RunReadFileBenchmark(50);
+}
+
+TEST(JSONStreamPerfTest, WriteFile) {
+  RunWriteFileBenchmark(1);
+  RunWriteFileBenchmark(10);
+  RunWriteFileBenchmark(50);
+}
+
+}  // namespace base
@@ -200,6 +200,14 @@ TEST(JSONReaderTest, Reading) {
   ASSERT_TRUE(root->GetAsString(&str_val));
   ASSERT_EQ(std::wstring(L"A\0\x1234", 3), UTF8ToWide(str_val));
 
+  // Test a surrogate pair, and a lone surrogate, which isn't a character.
+  root.reset(JSONReader().JsonToValue("\"\\ud83d\\ude00\\ud83d\"", false,
+                                      false));
+  ASSERT_TRUE(root.get());
+  str_val.clear();
+  ASSERT_TRUE(root->GetAsString(&str_val));
+  ASSERT_EQ("\xF0\x9F\x98\x80\xEF\xBF\xBD", str_val);
+
   // Test invalid strings
   root.reset(JSONReader().JsonToValue("\"no closing quote", false, false));
   ASSERT_FALSE(root.get());
@@ -377,6 +385,23 @@ TEST(JSONReaderTest, Reading) {
                                                          &integer_value));
   EXPECT_EQ(1, integer_value);
 
+  // Keys don't have to be sorted; the last value of a duplicate key wins.
+  root.reset(JSONReader::Read(
+      "{\"c\":1,\"b\":2,\"a\":3,\"b\":{\"z\":4,\"y\":5,\"z\":6}}",
+      false));
+  ASSERT_TRUE(root.get());
+  ASSERT_TRUE(root->IsType(Value::TYPE_DICTIONARY));
+  dict_val = static_cast<DictionaryValue*>(root.get());
+  EXPECT_EQ(3U, dict_val->size());
+  DictionaryValue::key_iterator key = dict_val->begin_keys();
+  EXPECT_EQ("a", *key);
+  EXPECT_EQ("b", *++key);
+  EXPECT_EQ("c", *++key);
+  EXPECT_TRUE(dict_val->GetInteger("b.z", &integer_value));
+  EXPECT_EQ(6, integer_value);
+  EXPECT_TRUE(dict_val->GetInteger("b.y", &integer_value));
+  EXPECT_EQ(5, integer_value);
+
   root.reset(JSONReader::Read("{\"a\":{\"b\":2},\"a.b\":1}", false));
   ASSERT_TRUE(root.get());
   ASSERT_TRUE(root->IsType(Value::TYPE_DICTIONARY));
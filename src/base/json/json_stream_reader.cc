@@ -0,0 +1,567 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/json/json_stream_reader.h"
+
+#include <string.h>
+
+#include <algorithm>
+
+#include "base/float_util.h"
+#include "base/logging.h"
+#include "base/string_number_conversions.h"
+#include "base/string_util.h"
+
+namespace {
+
+typedef base::JSONReader::Token Token;
+
+const char kNullString[] = "null";
+const char kTrueString[] = "true";
+const char kFalseString[] = "false";
+const char kUTF8ByteOrderMark[] = "\xEF\xBB\xBF";
+
+const size_t kStackLimit = 100;
+
+bool IsNumberChar(char c) {
+  return IsAsciiDigit(c) || c == '-' || c == '+' || c == '.' || c == 'e' ||
+      c == 'E';
+}
+
+// Reads the digits at |*pos|, like ReadInt() in json_reader.cc.
+bool ReadInt(const char** pos, const char* end, bool can_have_leading_zeros) {
+  const char* first = *pos;
+  while (*pos < end && IsAsciiDigit(**pos))
+    ++*pos;
+  int len = *pos - first;
+  // We need at least 1 digit.
+  if (len == 0)
+    return false;
+  return can_have_leading_zeros || len == 1 || *first != '0';
+}
+
+// Returns whether [begin, end) is a number: [minus] int [frac] [exp].
+bool IsValidNumber(const char* begin, const char* end) {
+  const char* pos = begin;
+  if (pos < end && *pos == '-')
+    ++pos;
+  if (!ReadInt(&pos, end, false))
+    return false;
+  if (pos < end && *pos == '.') {
+    ++pos;
+    if (!ReadInt(&pos, end, true))
+      return false;
+  }
+  if (pos < end && (*pos == 'e' || *pos == 'E')) {
+    ++pos;
+    if (pos < end && (*pos == '-' || *pos == '+'))
+      ++pos;
+    if (!ReadInt(&pos, end, true))
+      return false;
+  }
+  return pos == end;
+}
+
+bool IsASCIIRange(const char* begin, const char* end) {
+  for (const char* pos = begin; pos < end; ++pos) {
+    if (*pos & 0x80)
+      return false;
+  }
+  return true;
+}
+
+// Returns the position of the first "*/" in [begin, end), or NULL.
+const char* FindBlockCommentEnd(const char* begin, const char* end) {
+  for (const char* pos = begin; pos + 1 < end; ++pos) {
+    if (pos[0] == '*' && pos[1] == '/')
+      return pos;
+  }
+  return NULL;
+}
+
+}  // namespace
+
+namespace base {
+
+JSONStreamReader::JSONStreamReader(Delegate* delegate,
+                                   bool allow_trailing_comma)
+    : delegate_(delegate),
+      allow_trailing_comma_(allow_trailing_comma),
+      state_(STATE_ROOT),
+      scanned_(0),
+      checked_bom_(false),
+      counted_pos_(NULL),
+      line_(1),
+      column_(1),
+      error_code_(JSONReader::JSON_NO_ERROR),
+      error_line_(0),
+      error_col_(0) {
+  DCHECK(delegate);
+}
+
+JSONStreamReader::~JSONStreamReader() {
+}
+
+bool JSONStreamReader::Parse(const char* data, size_t length) {
+  if (state_ == STATE_ERROR)
+    return false;
+
+  // Parse the chunk directly, unless a token was cut by the previous one.
+  const char* begin = data;
+  const char* end = data + length;
+  bool buffered = !pending_.empty() || !checked_bom_;
+  if (buffered) {
+    pending_.append(data, length);
+    begin = pending_.data();
+    end = begin + pending_.size();
+  }
+
+  if (!checked_bom_) {
+    // Wait until we know whether the document starts with a BOM.
+    if (pending_.size() < arraysize(kUTF8ByteOrderMark) - 1 &&
+        memcmp(begin, kUTF8ByteOrderMark, pending_.size()) == 0)
+      return true;
+    checked_bom_ = true;
+    if (pending_.compare(0, arraysize(kUTF8ByteOrderMark) - 1,
+                         kUTF8ByteOrderMark) == 0)
+      begin += arraysize(kUTF8ByteOrderMark) - 1;
+  }
+
+  counted_pos_ = begin;
+  const char* parsed = ParseTokens(begin, end, false);
+  if (state_ == STATE_ERROR) {
+    pending_.clear();
+    return false;
+  }
+  UpdatePosition(parsed);
+
+  if (buffered)
+    pending_.erase(0, parsed - pending_.data());
+  else
+    pending_.assign(parsed, end);
+  return true;
+}
+
+bool JSONStreamReader::Finish() {
+  if (state_ == STATE_ERROR)
+    return false;
+  checked_bom_ = true;
+
+  const char* begin = pending_.data();
+  const char* end = begin + pending_.size();
+  counted_pos_ = begin;
+  const char* parsed = ParseTokens(begin, end, true);
+  if (state_ == STATE_ERROR) {
+    pending_.clear();
+    return false;
+  }
+  if (state_ != STATE_DONE) {
+    // The root token must be an array or an object.
+    if (state_ == STATE_ROOT)
+      SetErrorCode(JSONReader::JSON_BAD_ROOT_ELEMENT_TYPE, parsed);
+    else
+      SetErrorCode(JSONReader::JSON_SYNTAX_ERROR, parsed);
+    pending_.clear();
+    return false;
+  }
+  pending_.clear();
+  return true;
+}
+
+std::string JSONStreamReader::GetErrorMessage() const {
+  return JSONReader::FormatErrorMessage(
+      error_line_, error_col_, JSONReader::ErrorCodeToString(error_code_));
+}
+
+const char* JSONStreamReader::ParseTokens(const char* begin,
+                                          const char* end,
+                                          bool at_end) {
+  const char* pos = begin;
+  while (true) {
+    // Skip whitespace and comments.
+    while (pos < end) {
+      if (*pos == ' ' || *pos == '\n' || *pos == '\r' || *pos == '\t') {
+        ++pos;
+        continue;
+      }
+      if (*pos != '/')
+        break;
+      // TODO(tc): This isn't in the RFC so it should be a parser flag.
+      if (pos + 1 == end) {
+        if (!at_end)
+          return pos;
+        break;
+      }
+      if (pos[1] == '/') {
+        // Line comment, read until \n or \r
+        const char* eol = pos + 2;
+        while (eol < end && *eol != '\n' && *eol != '\r')
+          ++eol;
+        if (eol == end && !at_end)
+          return pos;
+        pos = std::min(eol + 1, end);
+      } else if (pos[1] == '*') {
+        // Block comment, read until */
+        const char* comment_end = FindBlockCommentEnd(pos + 2, end);
+        if (!comment_end && !at_end)
+          return pos;
+        pos = comment_end ? comment_end + 2 : end;
+      } else {
+        break;
+      }
+    }
+    if (pos == end)
+      return pos;
+
+    Token::Type type = Token::INVALID_TOKEN;
+    int length = 1;
+    switch (*pos) {
+      case '[':
+        type = Token::ARRAY_BEGIN;
+        break;
+      case ']':
+        type = Token::ARRAY_END;
+        break;
+      case ',':
+        type = Token::LIST_SEPARATOR;
+        break;
+      case '{':
+        type = Token::OBJECT_BEGIN;
+        break;
+      case '}':
+        type = Token::OBJECT_END;
+        break;
+      case ':':
+        type = Token::OBJECT_PAIR_SEPARATOR;
+        break;
+
+      case 'n':
+      case 't':
+      case 'f':
+        {
+          const char* literal = *pos == 'n' ? kNullString :
+                                *pos == 't' ? kTrueString : kFalseString;
+          length = strlen(literal);
+          if (end - pos < length) {
+            // Wait for the rest of a literal that could match.
+            if (!at_end && strncmp(pos, literal, end - pos) == 0)
+              return pos;
+          } else if (strncmp(pos, literal, length) == 0) {
+            type = *pos == 'n' ? Token::NULL_TOKEN :
+                   *pos == 't' ? Token::BOOL_TRUE : Token::BOOL_FALSE;
+          }
+          break;
+        }
+
+      case '0':
+      case '1':
+      case '2':
+      case '3':
+      case '4':
+      case '5':
+      case '6':
+      case '7':
+      case '8':
+      case '9':
+      case '-':
+        {
+          // Take all the characters that can be part of a number; whatever
+          // follows a number must be a separator anyway.
+          const char* number_end = pos + 1;
+          while (number_end < end && IsNumberChar(*number_end))
+            ++number_end;
+          if (number_end == end && !at_end)
+            return pos;
+          length = number_end - pos;
+          if (IsValidNumber(pos, number_end))
+            type = Token::NUMBER;
+          break;
+        }
+
+      case '"':
+        length = ScanString(pos, end);
+        if (length < 0)
+          return pos;
+        if (length == 0) {
+          if (!at_end)
+            return pos;
+          length = 1;
+        } else {
+          type = Token::STRING;
+        }
+        break;
+    }
+
+    if (!HandleToken(type, pos, length))
+      return pos;
+    pos += length;
+  }
+}
+
+bool JSONStreamReader::HandleToken(Token::Type type,
+                                   const char* begin,
+                                   int length) {
+  switch (state_) {
+    case STATE_ROOT:
+      // The root token must be an array or an object.
+      if (type != Token::OBJECT_BEGIN && type != Token::ARRAY_BEGIN) {
+        SetErrorCode(JSONReader::JSON_BAD_ROOT_ELEMENT_TYPE, begin);
+        return false;
+      }
+      return HandleValue(type, begin, length);
+
+    case STATE_VALUE:
+    case STATE_ARRAY_FIRST_VALUE:
+    case STATE_ARRAY_VALUE:
+      if (type != Token::ARRAY_END || state_ == STATE_VALUE)
+        return HandleValue(type, begin, length);
+      // Trailing commas are invalid according to the JSON RFC, but some
+      // consumers need the parsing leniency, so handle accordingly.
+      if (state_ == STATE_ARRAY_VALUE && !allow_trailing_comma_) {
+        SetErrorCode(JSONReader::JSON_TRAILING_COMMA, begin);
+        return false;
+      }
+      containers_.pop_back();
+      delegate_->OnArrayEnd();
+      EndValue();
+      return true;
+
+    case STATE_OBJECT_FIRST_KEY:
+    case STATE_OBJECT_KEY:
+      if (type == Token::OBJECT_END) {
+        if (state_ == STATE_OBJECT_KEY && !allow_trailing_comma_) {
+          SetErrorCode(JSONReader::JSON_TRAILING_COMMA, begin);
+          return false;
+        }
+        containers_.pop_back();
+        delegate_->OnObjectEnd();
+        EndValue();
+        return true;
+      }
+      if (type != Token::STRING) {
+        SetErrorCode(JSONReader::JSON_UNQUOTED_DICTIONARY_KEY, begin);
+        return false;
+      }
+      if (!JSONReader::DecodeString(Token(type, begin, length), &decoded_)) {
+        SetErrorCode(JSONReader::JSON_SYNTAX_ERROR, begin);
+        return false;
+      }
+      delegate_->OnObjectKey(decoded_);
+      state_ = STATE_OBJECT_PAIR_SEPARATOR;
+      return true;
+
+    case STATE_OBJECT_PAIR_SEPARATOR:
+      if (type != Token::OBJECT_PAIR_SEPARATOR)
+        break;
+      state_ = STATE_VALUE;
+      return true;
+
+    case STATE_OBJECT_SEPARATOR_OR_END:
+      if (type == Token::LIST_SEPARATOR) {
+        state_ = STATE_OBJECT_KEY;
+        return true;
+      }
+      if (type != Token::OBJECT_END)
+        break;
+      containers_.pop_back();
+      delegate_->OnObjectEnd();
+      EndValue();
+      return true;
+
+    case STATE_ARRAY_SEPARATOR_OR_END:
+      if (type == Token::LIST_SEPARATOR) {
+        state_ = STATE_ARRAY_VALUE;
+        return true;
+      }
+      if (type != Token::ARRAY_END)
+        break;
+      containers_.pop_back();
+      delegate_->OnArrayEnd();
+      EndValue();
+      return true;
+
+    case STATE_DONE:
+      SetErrorCode(JSONReader::JSON_UNEXPECTED_DATA_AFTER_ROOT, begin);
+      return false;
+
+    case STATE_ERROR:
+      NOTREACHED();
+      return false;
+  }
+
+  SetErrorCode(JSONReader::JSON_SYNTAX_ERROR, begin);
+  return false;
+}
+
+bool JSONStreamReader::HandleValue(Token::Type type,
+                                   const char* begin,
+                                   int length) {
+  if (containers_.size() >= kStackLimit) {
+    SetErrorCode(JSONReader::JSON_TOO_MUCH_NESTING, begin);
+    return false;
+  }
+
+  switch (type) {
+    case Token::OBJECT_BEGIN:
+      containers_.push_back('{');
+      delegate_->OnObjectBegin();
+      state_ = STATE_OBJECT_FIRST_KEY;
+      return true;
+
+    case Token::ARRAY_BEGIN:
+      containers_.push_back('[');
+      delegate_->OnArrayBegin();
+      state_ = STATE_ARRAY_FIRST_VALUE;
+      return true;
+
+    case Token::STRING:
+      if (!JSONReader::DecodeString(Token(type, begin, length), &decoded_))
+        break;
+      delegate_->OnString(decoded_);
+      EndValue();
+      return true;
+
+    case Token::NUMBER:
+      if (!HandleNumber(begin, length))
+        break;
+      EndValue();
+      return true;
+
+    case Token::BOOL_TRUE:
+    case Token::BOOL_FALSE:
+      delegate_->OnBoolean(type == Token::BOOL_TRUE);
+      EndValue();
+      return true;
+
+    case Token::NULL_TOKEN:
+      delegate_->OnNull();
+      EndValue();
+      return true;
+
+    default:
+      // We got a token that's not a value.
+      break;
+  }
+
+  SetErrorCode(JSONReader::JSON_SYNTAX_ERROR, begin);
+  return false;
+}
+
+void JSONStreamReader::EndValue() {
+  if (containers_.empty())
+    state_ = STATE_DONE;
+  else if (containers_.back() == '{')
+    state_ = STATE_OBJECT_SEPARATOR_OR_END;
+  else
+    state_ = STATE_ARRAY_SEPARATOR_OR_END;
+}
+
+bool JSONStreamReader::HandleNumber(const char* begin, int length) {
+  const std::string num_string(begin, length);
+
+  int num_int;
+  if (StringToInt(num_string, &num_int)) {
+    delegate_->OnInteger(num_int);
+    return true;
+  }
+
+  double num_double;
+  if (StringToDouble(num_string, &num_double) && base::IsFinite(num_double)) {
+    delegate_->OnDouble(num_double);
+    return true;
+  }
+
+  return false;
+}
+
+int JSONStreamReader::ScanString(const char* begin, const char* end) {
+  int available = end - begin;
+  int i = std::max(scanned_, 1);
+  while (i < available) {
+    char c = begin[i];
+    if ('"' == c) {
+      scanned_ = 0;
+      // The input must be in UTF-8.
+      if (!IsASCIIRange(begin + 1, begin + i) &&
+          !IsStringUTF8(std::string(begin + 1, i - 1))) {
+        SetErrorCode(JSONReader::JSON_UNSUPPORTED_ENCODING, begin);
+        return -1;
+      }
+      return i + 1;
+    }
+    if ('\0' == c) {
+      SetErrorCode(JSONReader::JSON_SYNTAX_ERROR, begin);
+      return -1;
+    }
+    if ('\\' != c) {
+      ++i;
+      continue;
+    }
+
+    // Make sure the escaped char is valid.  Check the digits that are there
+    // already even if the escape is cut.
+    int digits = 0;
+    if (i + 1 < available) {
+      switch (begin[i + 1]) {
+        case 'x':
+          digits = 2;
+          break;
+        case 'u':
+          digits = 4;
+          break;
+        case '\\':
+        case '/':
+        case 'b':
+        case 'f':
+        case 'n':
+        case 'r':
+        case 't':
+        case 'v':
+        case '"':
+          break;
+        default:
+          SetErrorCode(JSONReader::JSON_INVALID_ESCAPE, begin + i + 1);
+          return -1;
+      }
+    }
+    for (int j = i + 2; j < i + 2 + digits && j < available; ++j) {
+      if (!IsHexDigit(begin[j])) {
+        SetErrorCode(JSONReader::JSON_INVALID_ESCAPE, begin + i + 1);
+        return -1;
+      }
+    }
+    if (i + 2 + digits > available)
+      break;
+    i += 2 + digits;
+  }
+
+  // Resume at the cut escape sequence, if any, when more input comes.
+  scanned_ = i;
+  return 0;
+}
+
+void JSONStreamReader::UpdatePosition(const char* end) {
+  for (const char* pos = counted_pos_; pos < end; ++pos) {
+    if (*pos == '\n') {
+      ++line_;
+      column_ = 1;
+    } else if ((*pos & 0xC0) != 0x80) {
+      // Columns count characters, so skip the continuation bytes of UTF-8
+      // sequences.
+      ++column_;
+    }
+  }
+  counted_pos_ = end;
+}
+
+void JSONStreamReader::SetErrorCode(JSONReader::JsonParseError error,
+                                    const char* error_pos) {
+  UpdatePosition(error_pos);
+  error_line_ = line_;
+  error_col_ = column_;
+  error_code_ = error;
+  state_ = STATE_ERROR;
+}
+
+}  // namespace base
@@ -0,0 +1,178 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// A streaming JSON parser.  Unlike JSONReader, which builds a Value tree of
+// the whole document, JSONStreamReader reports what it parses to a Delegate
+// as it goes, and takes its input in chunks of any size.  Memory use doesn't
+// grow with the size of the document, only with its nesting and the length
+// of its largest token.
+//
+// It accepts the same documents as JSONReader::Read(): the root must be an
+// object or an array, comments are skipped, and nesting is limited to 100
+// levels.
+//
+// Example, counting the URLs in a bookmarks file read in chunks:
+//
+//   class URLCounter : public JSONStreamReader::Delegate {
+//     ...
+//     virtual void OnObjectKey(const std::string& key) {
+//       in_url_ = key == "url";
+//     }
+//     virtual void OnString(const std::string& value) {
+//       if (in_url_)
+//         ++count_;
+//     }
+//   };
+//
+//   URLCounter counter;
+//   JSONStreamReader reader(&counter, false);
+//   while ((length = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+//     if (!reader.Parse(buffer, length))
+//       break;
+//   }
+//   if (!reader.Finish())
+//     LOG(ERROR) << reader.GetErrorMessage();
+
+#ifndef BASE_JSON_JSON_STREAM_READER_H_
+#define BASE_JSON_JSON_STREAM_READER_H_
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "base/base_export.h"
+#include "base/basictypes.h"
+#include "base/json/json_reader.h"
+
+namespace base {
+
+class BASE_EXPORT JSONStreamReader {
+ public:
+  // Receives the contents of the document in order.  Object members are
+  // reported as OnObjectKey() followed by the events of the value.  The
+  // strings are only valid during the call.
+  class Delegate {
+   public:
+    virtual ~Delegate() {}
+
+    virtual void OnObjectBegin() = 0;
+    virtual void OnObjectKey(const std::string& key) = 0;
+    virtual void OnObjectEnd() = 0;
+    virtual void OnArrayBegin() = 0;
+    virtual void OnArrayEnd() = 0;
+    virtual void OnString(const std::string& value) = 0;
+    virtual void OnInteger(int value) = 0;
+    virtual void OnDouble(double value) = 0;
+    virtual void OnBoolean(bool value) = 0;
+    virtual void OnNull() = 0;
+  };
+
+  // If |allow_trailing_comma| is true, we will ignore trailing commas in
+  // objects and arrays even though this goes against the RFC.
+  JSONStreamReader(Delegate* delegate, bool allow_trailing_comma);
+  ~JSONStreamReader();
+
+  // Parses the next |length| bytes of the document, reporting the values
+  // they complete to the delegate.  A token cut by the end of the chunk is
+  // kept until the next call.  Returns false if the document is invalid; the
+  // reader ignores any input after that.
+  bool Parse(const char* data, size_t length);
+
+  // Signals the end of the document.  Returns false if it is invalid or
+  // incomplete.
+  bool Finish();
+
+  // Returns the error code if the document is invalid, JSON_NO_ERROR
+  // otherwise.
+  JSONReader::JsonParseError error_code() const { return error_code_; }
+
+  // Converts error_code_ to a human-readable string, including line and column
+  // numbers if appropriate, like JSONReader::GetErrorMessage().
+  std::string GetErrorMessage() const;
+
+ private:
+  // What the parser expects next.
+  enum State {
+    STATE_ROOT,                      // The root object or array.
+    STATE_VALUE,                     // A value after a ':'.
+    STATE_OBJECT_FIRST_KEY,          // A key or '}' after '{'.
+    STATE_OBJECT_KEY,                // A key after ','.
+    STATE_OBJECT_PAIR_SEPARATOR,     // ':' after a key.
+    STATE_OBJECT_SEPARATOR_OR_END,   // ',' or '}' after a member.
+    STATE_ARRAY_FIRST_VALUE,         // A value or ']' after '['.
+    STATE_ARRAY_VALUE,               // A value after ','.
+    STATE_ARRAY_SEPARATOR_OR_END,    // ',' or ']' after a value.
+    STATE_DONE,                      // Nothing but whitespace.
+    STATE_ERROR,
+  };
+
+  // Parses the tokens in [begin, end) and returns the end of the last
+  // complete one.  If |at_end| is false, a token that reaches |end| may be
+  // incomplete, and is left for the next call.
+  const char* ParseTokens(const char* begin, const char* end, bool at_end);
+
+  // Handles the complete token at [begin, begin + length).  Returns false on
+  // errors.
+  bool HandleToken(JSONReader::Token::Type type, const char* begin,
+                   int length);
+
+  // Handles the first token of a value.
+  bool HandleValue(JSONReader::Token::Type type, const char* begin,
+                   int length);
+
+  // Moves to the state that follows a complete value.
+  void EndValue();
+
+  // Decodes the number at [begin, begin + length) and reports it.
+  bool HandleNumber(const char* begin, int length);
+
+  // Returns the length of the string token at |begin|, 0 if it reaches |end|,
+  // or -1 if it is invalid.  |scanned_| remembers how much of an incomplete
+  // string was checked, so that a long string isn't scanned again for each
+  // chunk.
+  int ScanString(const char* begin, const char* end);
+
+  // Counts the lines and columns of [counted_pos_, end), which has been
+  // parsed.
+  void UpdatePosition(const char* end);
+
+  // Sets the error code that will be returned to the caller, and the line
+  // and column of |error_pos|.
+  void SetErrorCode(JSONReader::JsonParseError error, const char* error_pos);
+
+  Delegate* delegate_;
+  bool allow_trailing_comma_;
+
+  State state_;
+
+  // The objects ('{') and arrays ('[') the parser is in.
+  std::vector<char> containers_;
+
+  // The input that follows the last complete token, and how much of the
+  // string at its start has already been checked.
+  std::string pending_;
+  int scanned_;
+
+  // Whether the start of the document has been checked for a UTF-8 BOM.
+  bool checked_bom_;
+
+  // The line and column of |counted_pos_|, the end of the input counted so
+  // far.
+  const char* counted_pos_;
+  int line_;
+  int column_;
+
+  // Reused for the decoded strings.
+  std::string decoded_;
+
+  JSONReader::JsonParseError error_code_;
+  int error_line_;
+  int error_col_;
+
+  DISALLOW_COPY_AND_ASSIGN(JSONStreamReader);
+};
+
+}  // namespace base
+
+#endif  // BASE_JSON_JSON_STREAM_READER_H_
@@ -0,0 +1,285 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/json/json_stream_reader.h"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "base/memory/scoped_ptr.h"
+#include "base/stringprintf.h"
+#include "base/values.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace base {
+
+namespace {
+
+// Builds a Value tree from the events, like JSONReader would.
+class ValueBuilder : public JSONStreamReader::Delegate {
+ public:
+  ValueBuilder() {}
+
+  Value* root() { return root_.get(); }
+
+  virtual void OnObjectBegin() {
+    Value* object = new DictionaryValue;
+    Add(object);
+    containers_.push_back(object);
+  }
+  virtual void OnObjectKey(const std::string& key) { key_ = key; }
+  virtual void OnObjectEnd() { containers_.pop_back(); }
+  virtual void OnArrayBegin() {
+    Value* array = new ListValue;
+    Add(array);
+    containers_.push_back(array);
+  }
+  virtual void OnArrayEnd() { containers_.pop_back(); }
+  virtual void OnString(const std::string& value) {
+    Add(Value::CreateStringValue(value));
+  }
+  virtual void OnInteger(int value) { Add(Value::CreateIntegerValue(value)); }
+  virtual void OnDouble(double value) { Add(Value::CreateDoubleValue(value)); }
+  virtual void OnBoolean(bool value) { Add(Value::CreateBooleanValue(value)); }
+  virtual void OnNull() { Add(Value::CreateNullValue()); }
+
+ private:
+  void Add(Value* value) {
+    if (containers_.empty()) {
+      root_.reset(value);
+    } else if (containers_.back()->IsType(Value::TYPE_DICTIONARY)) {
+      static_cast<DictionaryValue*>(containers_.back())->
+          SetWithoutPathExpansion(key_, value);
+    } else {
+      static_cast<ListValue*>(containers_.back())->Append(value);
+    }
+  }
+
+  scoped_ptr<Value> root_;
+  std::vector<Value*> containers_;
+  std::string key_;
+
+  DISALLOW_COPY_AND_ASSIGN(ValueBuilder);
+};
+
+// Records the events as a string.
+class EventRecorder : public JSONStreamReader::Delegate {
+ public:
+  EventRecorder() {}
+
+  const std::string& events() const { return events_; }
+
+  virtual void OnObjectBegin() { events_.append("{"); }
+  virtual void OnObjectKey(const std::string& key) {
+    events_.append(key + ":");
+  }
+  virtual void OnObjectEnd() { events_.append("}"); }
+  virtual void OnArrayBegin() { events_.append("["); }
+  virtual void OnArrayEnd() { events_.append("]"); }
+  virtual void OnString(const std::string& value) {
+    events_.append("'" + value + "' ");
+  }
+  virtual void OnInteger(int value) { StringAppendF(&events_, "%d ", value); }
+  virtual void OnDouble(double value) {
+    StringAppendF(&events_, "%.1f ", value);
+  }
+  virtual void OnBoolean(bool value) {
+    events_.append(value ? "true " : "false ");
+  }
+  virtual void OnNull() { events_.append("null "); }
+
+ private:
+  std::string events_;
+
+  DISALLOW_COPY_AND_ASSIGN(EventRecorder);
+};
+
+// Parses |json| in chunks of |chunk_size| bytes.
+bool ParseInChunks(JSONStreamReader* reader, const std::string& json,
+                   size_t chunk_size) {
+  for (size_t i = 0; i < json.size(); i += chunk_size) {
+    if (!reader->Parse(json.data() + i, std::min(chunk_size, json.size() - i)))
+      return false;
+  }
+  return reader->Finish();
+}
+
+}  // namespace
+
+TEST(JSONStreamReaderTest, Events) {
+  EventRecorder recorder;
+  JSONStreamReader reader(&recorder, false);
+  std::string json("{\"b\": [1, -2.5e1, \"x\\ty\", true, false, null, {}],"
+                   " \"a\": {\"c\": []}}");
+  EXPECT_TRUE(ParseInChunks(&reader, json, json.size()));
+  // The keys are reported in the order of the document.
+  EXPECT_EQ("{b:[1 -25.0 'x\ty' true false null {}]a:{c:[]}}",
+            recorder.events());
+  EXPECT_EQ(JSONReader::JSON_NO_ERROR, reader.error_code());
+  EXPECT_EQ("", reader.GetErrorMessage());
+}
+
+// Checks that the documents JSONReader reads are read the same, whatever the
+// size of the chunks.
+TEST(JSONStreamReaderTest, SameAsJSONReader) {
+  const char* const kDocuments[] = {
+    "[]",
+    "{}",
+    "  [true, false, null] ",
+    "\xEF\xBB\xBF{\"a\": 1}",
+    "[1, 0, -1, 2147483647, -2147483648, 2147483648, 1.5, -0.5e-3, 4E+2]",
+    "{\"number\":9.87654321, \"null\":null , \"\\x53\" : \"str\" }",
+    "{\"inner\":{\"array\":[true]},\"false\":false,\"d\":{}}",
+    "{\"a.b\":3,\"c\":2,\"d.e.f\":{\"g.h.i.j\":1}}",
+    "{\"a\":1, \"b\":2, \"a\":3}",
+    "[\"\\\"\\\\\\/\\b\\f\\n\\r\\t\\v\", \"\\x41\\u00e9\\ud83d\\ude00\"]",
+    "[\"caf\xC3\xA9\", \"\xE2\x82\xAC\"]",
+    "// comment\n[1, /* comment */ 2 // comment\r\n, 3] /* trailing */",
+    "[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]",
+  };
+
+  for (size_t i = 0; i < arraysize(kDocuments); ++i) {
+    SCOPED_TRACE(kDocuments[i]);
+    std::string json(kDocuments[i]);
+    scoped_ptr<Value> expected(JSONReader::Read(json, false));
+    ASSERT_TRUE(expected.get());
+
+    for (size_t chunk_size = 1; chunk_size <= json.size(); ++chunk_size) {
+      ValueBuilder builder;
+      JSONStreamReader reader(&builder, false);
+      ASSERT_TRUE(ParseInChunks(&reader, json, chunk_size)) << chunk_size;
+      ASSERT_TRUE(builder.root());
+      EXPECT_TRUE(expected->Equals(builder.root())) << chunk_size;
+    }
+  }
+}
+
+TEST(JSONStreamReaderTest, TrailingComma) {
+  const char* const kDocuments[] = {
+    "[true, false, null, ]",
+    "{\"a\": 1, }",
+  };
+
+  for (size_t i = 0; i < arraysize(kDocuments); ++i) {
+    SCOPED_TRACE(kDocuments[i]);
+    EventRecorder recorder;
+    JSONStreamReader reader(&recorder, false);
+    EXPECT_FALSE(ParseInChunks(&reader, kDocuments[i], 1));
+    EXPECT_EQ(JSONReader::JSON_TRAILING_COMMA, reader.error_code());
+
+    ValueBuilder builder;
+    JSONStreamReader lenient_reader(&builder, true);
+    EXPECT_TRUE(ParseInChunks(&lenient_reader, kDocuments[i], 1));
+    scoped_ptr<Value> expected(JSONReader::Read(kDocuments[i], true));
+    ASSERT_TRUE(builder.root());
+    EXPECT_TRUE(expected->Equals(builder.root()));
+  }
+}
+
+TEST(JSONStreamReaderTest, Errors) {
+  const struct {
+    const char* json;
+    JSONReader::JsonParseError error;
+  } kCases[] = {
+    { "", JSONReader::JSON_BAD_ROOT_ELEMENT_TYPE },
+    { "42", JSONReader::JSON_BAD_ROOT_ELEMENT_TYPE },
+    { "[1] [2]", JSONReader::JSON_UNEXPECTED_DATA_AFTER_ROOT },
+    { "{foo: 1}", JSONReader::JSON_UNQUOTED_DICTIONARY_KEY },
+    { "[\"xxx\\xq\"]", JSONReader::JSON_INVALID_ESCAPE },
+    { "[\"xxx\\uq\"]", JSONReader::JSON_INVALID_ESCAPE },
+    { "[\"xxx\\q\"]", JSONReader::JSON_INVALID_ESCAPE },
+    { "[\"\xFF\"]", JSONReader::JSON_UNSUPPORTED_ENCODING },
+    { "[1", JSONReader::JSON_SYNTAX_ERROR },
+    { "[\"no closing quote]", JSONReader::JSON_SYNTAX_ERROR },
+    { "[1 2]", JSONReader::JSON_SYNTAX_ERROR },
+    { "[01]", JSONReader::JSON_SYNTAX_ERROR },
+    { "[1.]", JSONReader::JSON_SYNTAX_ERROR },
+    { "[1e999]", JSONReader::JSON_SYNTAX_ERROR },
+    { "[nul]", JSONReader::JSON_SYNTAX_ERROR },
+    { "[truex]", JSONReader::JSON_SYNTAX_ERROR },
+    { "{\"a\" 1}", JSONReader::JSON_SYNTAX_ERROR },
+    { "{\"a\": 1 \"b\": 2}", JSONReader::JSON_SYNTAX_ERROR },
+  };
+
+  for (size_t i = 0; i < arraysize(kCases); ++i) {
+    SCOPED_TRACE(kCases[i].json);
+    std::string json(kCases[i].json);
+    int error_code = 0;
+    std::string error_message;
+    EXPECT_FALSE(JSONReader::ReadAndReturnError(json, false, &error_code,
+                                                &error_message));
+    EXPECT_EQ(kCases[i].error, error_code);
+
+    for (size_t chunk_size = 1; chunk_size <= json.size() + 1; ++chunk_size) {
+      EventRecorder recorder;
+      JSONStreamReader reader(&recorder, false);
+      EXPECT_FALSE(ParseInChunks(&reader, json, chunk_size));
+      EXPECT_EQ(kCases[i].error, reader.error_code());
+      // The reader stays in error.
+      EXPECT_FALSE(reader.Parse("[]", 2));
+      EXPECT_FALSE(reader.Finish());
+    }
+  }
+}
+
+TEST(JSONStreamReaderTest, ErrorMessages) {
+  const struct {
+    const char* json;
+    const char* message;
+  } kCases[] = {
+    { "[42]\n{}", "Line: 2, column: 1, Unexpected data after root element." },
+    { "{\"\xC3\xA9\": 1,\n  foo: 2}",
+      "Line: 2, column: 3, Dictionary keys must be quoted." },
+    { "[\"\xE2\x82\xAC\\q\"]", "Line: 1, column: 5, Invalid escape sequence." },
+    { "[1, 2, ]", "Line: 1, column: 8, Trailing comma not allowed." },
+  };
+
+  for (size_t i = 0; i < arraysize(kCases); ++i) {
+    SCOPED_TRACE(kCases[i].json);
+    std::string json(kCases[i].json);
+    std::string error_message;
+    EXPECT_FALSE(JSONReader::ReadAndReturnError(json, false, NULL,
+                                                &error_message));
+    EXPECT_EQ(kCases[i].message, error_message);
+
+    for (size_t chunk_size = 1; chunk_size <= json.size(); ++chunk_size) {
+      EventRecorder recorder;
+      JSONStreamReader reader(&recorder, false);
+      EXPECT_FALSE(ParseInChunks(&reader, json, chunk_size));
+      EXPECT_EQ(kCases[i].message, reader.GetErrorMessage());
+    }
+  }
+}
+
+TEST(JSONStreamReaderTest, TooMuchNesting) {
+  std::string json = std::string(100, '[') + std::string(100, ']');
+  EventRecorder recorder;
+  JSONStreamReader reader(&recorder, false);
+  EXPECT_TRUE(ParseInChunks(&reader, json, 7));
+
+  json = std::string(101, '[') + std::string(101, ']');
+  JSONStreamReader nested_reader(&recorder, false);
+  EXPECT_FALSE(ParseInChunks(&nested_reader, json, 7));
+  EXPECT_EQ(JSONReader::JSON_TOO_MUCH_NESTING, nested_reader.error_code());
+}
+
+// A long string cut into many chunks.
+TEST(JSONStreamReaderTest, LongString) {
+  std::string value;
+  for (int i = 0; i < 10000; ++i)
+    value.append(i % 10 ? "x" : "\\u00e9");
+  std::string json = "[\"" + value + "\"]";
+
+  EventRecorder recorder;
+  JSONStreamReader reader(&recorder, false);
+  EXPECT_TRUE(ParseInChunks(&reader, json, 3));
+
+  std::string expected;
+  for (int i = 0; i < 10000; ++i)
+    expected.append(i % 10 ? "x" : "\xC3\xA9");
+  EXPECT_EQ("['" + expected + "' ]", recorder.events());
+}
+
+}  // namespace base
@@ -0,0 +1,194 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/json/json_stream_writer.h"
+
+#include "base/logging.h"
+#include "base/stringprintf.h"
+#include "base/values.h"
+
+namespace base {
+
+namespace {
+
+// Same as in json_writer.cc.
+#if defined(OS_WIN)
+const char kPrettyPrintLineEnding[] = "\r\n";
+#else
+const char kPrettyPrintLineEnding[] = "\n";
+#endif
+
+// The output is passed on in chunks of about this size.
+const size_t kFlushSize = 64 * 1024;
+
+}  // namespace
+
+JSONStreamWriter::FileOutput::FileOutput(FILE* file) : file_(file) {
+  DCHECK(file);
+}
+
+JSONStreamWriter::FileOutput::~FileOutput() {
+}
+
+bool JSONStreamWriter::FileOutput::Write(const char* data, size_t length) {
+  return fwrite(data, 1, length, file_) == length;
+}
+
+JSONStreamWriter::JSONStreamWriter(Output* output, bool pretty_print)
+    : output_(output),
+      pretty_print_(pretty_print),
+      object_depth_(0),
+      failed_(false),
+      writer_(pretty_print, &buffer_) {
+  DCHECK(output);
+  buffer_.reserve(kFlushSize + 1024);
+}
+
+JSONStreamWriter::~JSONStreamWriter() {
+  DCHECK(buffer_.empty() || failed_) << "Flush() wasn't called.";
+}
+
+void JSONStreamWriter::BeginObject() {
+  BeginValue();
+  buffer_.push_back('{');
+  if (pretty_print_)
+    buffer_.append(kPrettyPrintLineEnding);
+  Container container = { true, false };
+  containers_.push_back(container);
+  ++object_depth_;
+}
+
+void JSONStreamWriter::EndObject() {
+  DCHECK(!containers_.empty() && containers_.back().is_object);
+  containers_.pop_back();
+  --object_depth_;
+  if (pretty_print_) {
+    buffer_.append(kPrettyPrintLineEnding);
+    writer_.IndentLine(object_depth_);
+  }
+  buffer_.push_back('}');
+  EndValue();
+}
+
+void JSONStreamWriter::BeginArray() {
+  BeginValue();
+  buffer_.push_back('[');
+  if (pretty_print_)
+    buffer_.push_back(' ');
+  Container container = { false, false };
+  containers_.push_back(container);
+}
+
+void JSONStreamWriter::EndArray() {
+  DCHECK(!containers_.empty() && !containers_.back().is_object);
+  containers_.pop_back();
+  if (pretty_print_)
+    buffer_.push_back(' ');
+  buffer_.push_back(']');
+  EndValue();
+}
+
+void JSONStreamWriter::WriteKey(const std::string& key) {
+  DCHECK(!containers_.empty() && containers_.back().is_object);
+  Container& object = containers_.back();
+  if (object.has_entries) {
+    buffer_.push_back(',');
+    if (pretty_print_)
+      buffer_.append(kPrettyPrintLineEnding);
+  }
+  object.has_entries = true;
+
+  if (pretty_print_)
+    writer_.IndentLine(object_depth_);
+  writer_.AppendQuotedString(key);
+  buffer_.append(pretty_print_ ? ": " : ":");
+}
+
+void JSONStreamWriter::WriteString(const std::string& value) {
+  BeginValue();
+  writer_.AppendQuotedString(value);
+  EndValue();
+}
+
+void JSONStreamWriter::WriteInteger(int value) {
+  BeginValue();
+  base::StringAppendF(&buffer_, "%d", value);
+  EndValue();
+}
+
+void JSONStreamWriter::WriteDouble(double value) {
+  // Let JSONWriter format the number, so that it reads back as a double.
+  FundamentalValue double_value(value);
+  WriteValue(&double_value);
+}
+
+void JSONStreamWriter::WriteBoolean(bool value) {
+  BeginValue();
+  buffer_.append(value ? "true" : "false");
+  EndValue();
+}
+
+void JSONStreamWriter::WriteNull() {
+  BeginValue();
+  buffer_.append("null");
+  EndValue();
+}
+
+void JSONStreamWriter::WriteValue(const Value* value) {
+  // Write the children one by one, so that the output of a large tree is
+  // passed on in chunks too.
+  if (value->IsType(Value::TYPE_DICTIONARY)) {
+    const DictionaryValue* dict = static_cast<const DictionaryValue*>(value);
+    BeginObject();
+    for (DictionaryValue::key_iterator key_itr = dict->begin_keys();
+         key_itr != dict->end_keys(); ++key_itr) {
+      Value* child = NULL;
+      bool result = dict->GetWithoutPathExpansion(*key_itr, &child);
+      DCHECK(result);
+      WriteKey(*key_itr);
+      WriteValue(child);
+    }
+    EndObject();
+  } else if (value->IsType(Value::TYPE_LIST)) {
+    const ListValue* list = static_cast<const ListValue*>(value);
+    BeginArray();
+    for (ListValue::const_iterator it = list->begin(); it != list->end();
+         ++it)
+      WriteValue(*it);
+    EndArray();
+  } else {
+    BeginValue();
+    writer_.BuildJSONString(value, object_depth_, true);
+    EndValue();
+  }
+}
+
+bool JSONStreamWriter::Flush() {
+  if (!failed_ && !buffer_.empty())
+    failed_ = !output_->Write(buffer_.data(), buffer_.size());
+  buffer_.clear();
+  return !failed_;
+}
+
+void JSONStreamWriter::BeginValue() {
+  if (containers_.empty() || containers_.back().is_object)
+    return;
+
+  Container& array = containers_.back();
+  if (array.has_entries) {
+    buffer_.push_back(',');
+    if (pretty_print_)
+      buffer_.push_back(' ');
+  }
+  array.has_entries = true;
+}
+
+void JSONStreamWriter::EndValue() {
+  if (containers_.empty() && pretty_print_)
+    buffer_.append(kPrettyPrintLineEnding);
+  if (buffer_.size() >= kFlushSize)
+    Flush();
+}
+
+}  // namespace base
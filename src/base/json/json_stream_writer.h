@@ -0,0 +1,134 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// A streaming JSON writer.  Unlike JSONWriter, which serializes a whole Value
+// tree into one string, JSONStreamWriter takes the document one value at a
+// time and passes it on to an Output in chunks, so that a large document
+// never has to be held in memory.  The output is the same as what JSONWriter
+// would produce for the same values.
+//
+// Example, writing a list of bookmarks to a file:
+//
+//   JSONStreamWriter::FileOutput output(file);
+//   JSONStreamWriter writer(&output, false);
+//   writer.BeginArray();
+//   for (size_t i = 0; i < bookmarks.size(); ++i) {
+//     writer.BeginObject();
+//     writer.WriteKey("title");
+//     writer.WriteString(bookmarks[i].title);
+//     writer.WriteKey("url");
+//     writer.WriteString(bookmarks[i].url);
+//     writer.EndObject();
+//   }
+//   writer.EndArray();
+//   if (!writer.Flush())
+//     LOG(ERROR) << "Could not write the bookmarks.";
+
+#ifndef BASE_JSON_JSON_STREAM_WRITER_H_
+#define BASE_JSON_JSON_STREAM_WRITER_H_
+#pragma once
+
+#include <stdio.h>
+
+#include <string>
+#include <vector>
+
+#include "base/base_export.h"
+#include "base/basictypes.h"
+#include "base/json/json_writer.h"
+
+namespace base {
+
+class Value;
+
+class BASE_EXPORT JSONStreamWriter {
+ public:
+  // Receives the output in chunks.  Network code can write them into an
+  // IOBuffer.
+  class Output {
+   public:
+    virtual ~Output() {}
+
+    // Returns false if the data could not be written.  The writer stops
+    // writing after that.
+    virtual bool Write(const char* data, size_t length) = 0;
+  };
+
+  // Writes to |file|, which stays owned by the caller.
+  class BASE_EXPORT FileOutput : public Output {
+   public:
+    explicit FileOutput(FILE* file);
+    virtual ~FileOutput();
+
+    virtual bool Write(const char* data, size_t length);
+
+   private:
+    FILE* file_;
+
+    DISALLOW_COPY_AND_ASSIGN(FileOutput);
+  };
+
+  // If |pretty_print| is true, the output is formatted like
+  // JSONWriter::Write() formats it.
+  JSONStreamWriter(Output* output, bool pretty_print);
+  ~JSONStreamWriter();
+
+  // Starts and ends an object or a list.  In an object, each value must
+  // follow a call to WriteKey().
+  void BeginObject();
+  void EndObject();
+  void BeginArray();
+  void EndArray();
+
+  // Writes the key of the next object member.
+  void WriteKey(const std::string& key);
+
+  void WriteString(const std::string& value);
+  void WriteInteger(int value);
+  void WriteDouble(double value);
+  void WriteBoolean(bool value);
+  void WriteNull();
+
+  // Writes |value| and its children, like JSONWriter::Write() would.
+  void WriteValue(const Value* value);
+
+  // Passes the output that is still buffered to the Output.  Must be called
+  // once the document is complete.  Returns false if the Output failed.
+  bool Flush();
+
+ private:
+  // An object or list that hasn't been ended yet.
+  struct Container {
+    bool is_object;
+    bool has_entries;
+  };
+
+  // Writes the separator that goes before a value.
+  void BeginValue();
+
+  // Ends the document after the root value, and flushes the output when
+  // enough of it is buffered.
+  void EndValue();
+
+  Output* output_;
+  bool pretty_print_;
+
+  // The containers the writer is in, and how many of them are objects.
+  std::vector<Container> containers_;
+  int object_depth_;
+
+  // Set once the Output fails.
+  bool failed_;
+
+  // The output that hasn't been passed to |output_| yet, which |writer_|
+  // formats values into.
+  std::string buffer_;
+  JSONWriter writer_;
+
+  DISALLOW_COPY_AND_ASSIGN(JSONStreamWriter);
+};
+
+}  // namespace base
+
+#endif  // BASE_JSON_JSON_STREAM_WRITER_H_
@@ -0,0 +1,183 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/json/json_stream_writer.h"
+
+#include <string>
+
+#include "base/file_util.h"
+#include "base/json/json_writer.h"
+#include "base/memory/scoped_ptr.h"
+#include "base/scoped_temp_dir.h"
+#include "base/stringprintf.h"
+#include "base/values.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace base {
+
+namespace {
+
+// Collects the output, and fails once |max_writes| chunks were written.
+class StringOutput : public JSONStreamWriter::Output {
+ public:
+  explicit StringOutput(int max_writes)
+      : max_writes_(max_writes),
+        writes_(0) {}
+
+  const std::string& data() const { return data_; }
+  int writes() const { return writes_; }
+
+  virtual bool Write(const char* data, size_t length) {
+    if (writes_ == max_writes_)
+      return false;
+    ++writes_;
+    data_.append(data, length);
+    return true;
+  }
+
+ private:
+  const int max_writes_;
+  int writes_;
+  std::string data_;
+
+  DISALLOW_COPY_AND_ASSIGN(StringOutput);
+};
+
+// Writes the same document as MakeDocument() builds.
+void WriteDocument(JSONStreamWriter* writer) {
+  writer->BeginObject();
+  writer->WriteKey("a");
+  writer->WriteDouble(1.0);
+  writer->WriteKey("b");
+  writer->BeginArray();
+  writer->WriteInteger(-2);
+  writer->WriteString("quote \" and \xE2\x82\xAC");
+  writer->BeginObject();
+  writer->EndObject();
+  writer->BeginArray();
+  writer->EndArray();
+  writer->BeginObject();
+  writer->WriteKey("c");
+  writer->WriteBoolean(true);
+  writer->WriteKey("d");
+  writer->BeginArray();
+  writer->WriteNull();
+  writer->EndArray();
+  writer->EndObject();
+  writer->EndArray();
+  writer->WriteKey("e");
+  writer->WriteDouble(-0.5);
+  writer->EndObject();
+}
+
+Value* MakeDocument() {
+  DictionaryValue* document = new DictionaryValue;
+  document->SetDouble("a", 1.0);
+  ListValue* list = new ListValue;
+  document->Set("b", list);
+  list->Append(Value::CreateIntegerValue(-2));
+  list->Append(Value::CreateStringValue("quote \" and \xE2\x82\xAC"));
+  list->Append(new DictionaryValue);
+  list->Append(new ListValue);
+  DictionaryValue* inner = new DictionaryValue;
+  list->Append(inner);
+  inner->SetBoolean("c", true);
+  ListValue* inner_list = new ListValue;
+  inner->Set("d", inner_list);
+  inner_list->Append(Value::CreateNullValue());
+  document->SetDouble("e", -0.5);
+  return document;
+}
+
+}  // namespace
+
+TEST(JSONStreamWriterTest, SameAsJSONWriter) {
+  scoped_ptr<Value> document(MakeDocument());
+  for (int pretty_print = 0; pretty_print <= 1; ++pretty_print) {
+    std::string expected;
+    JSONWriter::Write(document.get(), pretty_print != 0, &expected);
+
+    StringOutput output(-1);
+    JSONStreamWriter writer(&output, pretty_print != 0);
+    WriteDocument(&writer);
+    EXPECT_TRUE(writer.Flush());
+    EXPECT_EQ(expected, output.data());
+
+    // Values can be written whole, at any depth.
+    StringOutput value_output(-1);
+    JSONStreamWriter value_writer(&value_output, pretty_print != 0);
+    value_writer.BeginObject();
+    value_writer.WriteKey("document");
+    value_writer.WriteValue(document.get());
+    value_writer.WriteKey("list");
+    value_writer.BeginArray();
+    value_writer.WriteValue(document.get());
+    value_writer.EndArray();
+    value_writer.EndObject();
+    EXPECT_TRUE(value_writer.Flush());
+
+    DictionaryValue outer;
+    outer.Set("document", document->DeepCopy());
+    ListValue* list = new ListValue;
+    list->Append(document->DeepCopy());
+    outer.Set("list", list);
+    JSONWriter::Write(&outer, pretty_print != 0, &expected);
+    EXPECT_EQ(expected, value_output.data());
+  }
+}
+
+TEST(JSONStreamWriterTest, Chunks) {
+  // Write enough to be passed on in several chunks before Flush().
+  const int kEntries = 50000;
+  StringOutput output(-1);
+  JSONStreamWriter writer(&output, false);
+  ListValue list;
+  writer.BeginArray();
+  for (int i = 0; i < kEntries; ++i) {
+    std::string entry = StringPrintf("entry %d", i);
+    writer.WriteString(entry);
+    list.Append(Value::CreateStringValue(entry));
+  }
+  writer.EndArray();
+  EXPECT_GT(output.writes(), 1);
+  EXPECT_TRUE(writer.Flush());
+
+  std::string expected;
+  JSONWriter::Write(&list, false, &expected);
+  EXPECT_EQ(expected, output.data());
+}
+
+TEST(JSONStreamWriterTest, OutputFailure) {
+  StringOutput output(1);
+  JSONStreamWriter writer(&output, false);
+  writer.BeginArray();
+  for (int i = 0; i < 50000; ++i)
+    writer.WriteString("entry");
+  writer.EndArray();
+  EXPECT_FALSE(writer.Flush());
+  EXPECT_EQ(1, output.writes());
+}
+
+TEST(JSONStreamWriterTest, FileOutput) {
+  ScopedTempDir temp_dir;
+  ASSERT_TRUE(temp_dir.CreateUniqueTempDir());
+  FilePath path = temp_dir.path().AppendASCII("document.json");
+
+  FILE* file = file_util::OpenFile(path, "wb");
+  ASSERT_TRUE(file);
+  JSONStreamWriter::FileOutput output(file);
+  JSONStreamWriter writer(&output, true);
+  WriteDocument(&writer);
+  EXPECT_TRUE(writer.Flush());
+  ASSERT_TRUE(file_util::CloseFile(file));
+
+  scoped_ptr<Value> document(MakeDocument());
+  std::string expected;
+  JSONWriter::Write(document.get(), true, &expected);
+  std::string contents;
+  ASSERT_TRUE(file_util::ReadFileToString(path, &contents));
+  EXPECT_EQ(expected, contents);
+}
+
+}  // namespace base
@@ -40,6 +40,9 @@ class BASE_EXPORT JSONWriter {
   static const char* kEmptyArray;
 
  private:
+  // JSONStreamWriter formats values with a JSONWriter.
+  friend class JSONStreamWriter;
+
   JSONWriter(bool pretty_print, std::string* json);
 
   // Called recursively to build the JSON string.  Whe completed, value is
@@ -16,6 +16,7 @@
 #include "base/message_loop_proxy_impl.h"
 #include "base/message_pump_default.h"
 #include "base/metrics/histogram.h"
+#include "base/synchronization/mpsc_queue.h"
 #include "base/third_party/dynamic_annotations/dynamic_annotations.h"
 #include "base/threading/thread_local.h"
 #include "base/time.h"
@@ -112,6 +113,72 @@ static LPTOP_LEVEL_EXCEPTION_FILTER GetTopSEHFilter() {
 
 //------------------------------------------------------------------------------
 
+// Posting threads push onto an MPSCQueue without taking a lock.  A flag tracks
+// whether the loop's thread has already been asked to look at the queue, so
+// that only the first post after the queue was drained calls ScheduleWork().
+class MessageLoop::IncomingTaskQueue
+    : public base::RefCountedThreadSafe<MessageLoop::IncomingTaskQueue> {
+ public:
+  explicit IncomingTaskQueue(base::MessagePump* pump)
+      : wakeup_scheduled_(0),
+        pump_(pump) {
+  }
+
+  // Possibly called on a background thread!  See AddToIncomingQueue().
+  void AddTask(PendingTask* pending_task) {
+    queue_.Push(new Node(*pending_task));
+    pending_task->task.Reset();
+
+    // The flag is only cleared by ReloadWorkQueue() right before it drains the
+    // queue, so if it is already set, the loop is guaranteed to look at the
+    // queue again after our push.
+    if (base::subtle::Release_CompareAndSwap(&wakeup_scheduled_, 0, 1) != 0)
+      return;  // Someone else should have started the sub-pump.
+    if (pump_)
+      pump_->ScheduleWork();
+  }
+
+  // Moves every task that is completely posted to the back of |work_queue|.
+  void ReloadWorkQueue(TaskQueue* work_queue) {
+    base::subtle::NoBarrier_Store(&wakeup_scheduled_, 0);
+    // Pushes after this point must see the cleared flag and schedule work.
+    base::subtle::MemoryBarrier();
+    while (Node* node = queue_.Pop()) {
+      work_queue->push(node->pending_task);
+      delete node;
+    }
+  }
+
+  bool IsEmpty() const {
+    return queue_.IsEmpty();
+  }
+
+ private:
+  friend class base::RefCountedThreadSafe<IncomingTaskQueue>;
+
+  struct Node : public base::MPSCQueueNode {
+    explicit Node(const PendingTask& pending_task)
+        : pending_task(pending_task) {
+    }
+
+    PendingTask pending_task;
+  };
+
+  ~IncomingTaskQueue() {
+    // Tasks posted while the loop was being destroyed never ran.
+    while (Node* node = queue_.Pop())
+      delete node;
+  }
+
+  base::MPSCQueue<Node> queue_;
+  base::subtle::Atomic32 wakeup_scheduled_;
+  scoped_refptr<base::MessagePump> pump_;
+
+  DISALLOW_COPY_AND_ASSIGN(IncomingTaskQueue);
+};
+
+//------------------------------------------------------------------------------
+
 MessageLoop::TaskObserver::TaskObserver() {
 }
 
@@ -178,6 +245,8 @@ MessageLoop::MessageLoop(Type type)
     DCHECK_EQ(TYPE_DEFAULT, type_);
     pump_ = new base::MessagePumpDefault();
   }
+
+  incoming_queue_ = new IncomingTaskQueue(pump_);
 }
 
 MessageLoop::~MessageLoop() {
@@ -400,9 +469,9 @@ void MessageLoop::RemoveTaskObserver(TaskObserver* task_observer) {
 }
 
 void MessageLoop::AssertIdle() const {
-  // We only check |incoming_queue_|, since we don't want to lock |work_queue_|.
-  base::AutoLock lock(incoming_queue_lock_);
-  DCHECK(incoming_queue_.empty());
+  // We only check |incoming_queue_|, since |work_queue_| belongs to the thread
+  // running this loop.
+  DCHECK(incoming_queue_->IsEmpty());
 }
 
 //------------------------------------------------------------------------------
@@ -484,7 +553,8 @@ void MessageLoop::RunTask(const PendingTask& pending_task) {
   HistogramEvent(kTaskRunEvent);
 
 #if defined(TRACK_ALL_TASK_OBJECTS)
-  TimeTicks start_of_run = tracked_objects::ThreadData::Now();
+  TimeTicks start_of_run =
+      tracked_objects::ThreadData::NowIfSampled(pending_task.post_births);
 #endif  // defined(TRACK_ALL_TASK_OBJECTS)
 
   FOR_EACH_OBSERVER(TaskObserver, task_observers_,
@@ -532,14 +602,8 @@ void MessageLoop::ReloadWorkQueue() {
   if (!work_queue_.empty())
     return;  // Wait till we *really* need to lock and load.
 
-  // Acquire all we can from the inter-thread queue with one lock acquisition.
-  {
-    base::AutoLock lock(incoming_queue_lock_);
-    if (incoming_queue_.empty())
-      return;
-    incoming_queue_.Swap(&work_queue_);  // Constant time
-    DCHECK(incoming_queue_.empty());
-  }
+  // Acquire all we can from the inter-thread queue.
+  incoming_queue_->ReloadWorkQueue(&work_queue_);
 }
 
 bool MessageLoop::DeletePendingTasks() {
@@ -629,24 +693,12 @@ void MessageLoop::AddToIncomingQueue(PendingTask* pending_task) {
   // directly, as it could starve handling of foreign threads.  Put every task
   // into this queue.
 
-  scoped_refptr<base::MessagePump> pump;
-  {
-    base::AutoLock locked(incoming_queue_lock_);
-
-    bool was_empty = incoming_queue_.empty();
-    incoming_queue_.push(*pending_task);
-    pending_task->task.Reset();
-    if (!was_empty)
-      return;  // Someone else should have started the sub-pump.
-
-    pump = pump_;
-  }
   // Since the incoming_queue_ may contain a task that destroys this message
-  // loop, we cannot exit incoming_queue_lock_ until we are done with |this|.
-  // We use a stack-based reference to the message pump so that we can call
-  // ScheduleWork outside of incoming_queue_lock_.
-
-  pump->ScheduleWork();
+  // loop, we cannot touch |this| once the task is queued.  We use a
+  // stack-based reference to the queue, which also keeps the message pump
+  // alive, so that the post can complete after |this| is gone.
+  scoped_refptr<IncomingTaskQueue> incoming_queue(incoming_queue_);
+  incoming_queue->AddTask(pending_task);
 }
 
 //------------------------------------------------------------------------------
@@ -737,6 +789,11 @@ bool MessageLoop::DoIdleWork() {
   if (ProcessNextDelayedNonNestableTask())
     return true;
 
+#if defined(TRACK_ALL_TASK_OBJECTS)
+  // Let other threads see the tasks that ran, before going to sleep.
+  tracked_objects::ThreadData::MergePendingDeathsIfActive();
+#endif  // defined(TRACK_ALL_TASK_OBJECTS)
+
   if (state_->quit_received)
     pump_->Quit();
 
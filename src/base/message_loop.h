@@ -453,6 +453,10 @@ class BASE_EXPORT MessageLoop : public base::MessagePump::Delegate {
 
   typedef std::priority_queue<PendingTask> DelayedTaskQueue;
 
+  // Lock-free queue that collects the tasks posted from any thread until this
+  // loop's thread moves them into work_queue_.  See message_loop.cc.
+  class IncomingTaskQueue;
+
 #if defined(OS_WIN)
   base::MessagePumpWin* pump_win() {
     return static_cast<base::MessagePumpWin*>(pump_.get());
@@ -500,8 +504,8 @@ class BASE_EXPORT MessageLoop : public base::MessagePump::Delegate {
   void AddToIncomingQueue(PendingTask* pending_task);
 
   // Load tasks from the incoming_queue_ into work_queue_ if the latter is
-  // empty.  The former requires a lock to access, while the latter is directly
-  // accessible on this thread.
+  // empty.  The former is shared with posting threads, while the latter is
+  // directly accessible on this thread.
   void ReloadWorkQueue();
 
   // Delete tasks that haven't run yet without running them.  Used in the
@@ -557,13 +561,12 @@ class BASE_EXPORT MessageLoop : public base::MessagePump::Delegate {
   // A profiling histogram showing the counts of various messages and events.
   base::Histogram* message_histogram_;
 
-  // A null terminated list which creates an incoming_queue of tasks that are
-  // acquired under a mutex for processing on this instance's thread. These
-  // tasks have not yet been sorted out into items for our work_queue_ vs items
-  // that will be handled by the TimerManager.
-  TaskQueue incoming_queue_;
-  // Protect access to incoming_queue_.
-  mutable base::Lock incoming_queue_lock_;
+  // Tasks posted to this instance from any thread, waiting to be picked up by
+  // this instance's thread. These tasks have not yet been sorted out into
+  // items for our work_queue_ vs items that will be handled by the
+  // TimerManager.  Posting threads hold a reference while they post, so the
+  // queue outlives this instance if a posted task destroys it.
+  scoped_refptr<IncomingTaskQueue> incoming_queue_;
 
   RunState* state_;
 
@@ -0,0 +1,166 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <string>
+
+#include "base/atomicops.h"
+#include "base/bind.h"
+#include "base/message_loop.h"
+#include "base/perftimer.h"
+#include "base/stringprintf.h"
+#include "base/synchronization/waitable_event.h"
+#include "base/threading/platform_thread.h"
+#include "base/threading/simple_thread.h"
+#include "base/threading/thread.h"
+#include "base/time.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace base {
+
+namespace {
+
+const int kTotalPosts = 200 * 1000;
+const int kMaxPosters = 32;
+const int kNumWakeups = 500;
+
+// Runs on the target loop; counts the tasks and the time they spent queued.
+// Only touched on the target thread, except for |done_|.
+class PostRecorder {
+ public:
+  explicit PostRecorder(int num_tasks)
+      : remaining_(num_tasks),
+        done_(true, false),
+        num_samples_(0) {}
+
+  void RunTask(TimeTicks posted_time) {
+    TimeDelta delay = TimeTicks::Now() - posted_time;
+    total_delay_ += delay;
+    if (delay > max_delay_)
+      max_delay_ = delay;
+    num_samples_++;
+    if (--remaining_ == 0)
+      done_.Signal();
+  }
+
+  void Wait() { done_.Wait(); }
+
+  double MeanDelayMicroseconds() const {
+    return total_delay_.InMicroseconds() / static_cast<double>(num_samples_);
+  }
+  double MaxDelayMicroseconds() const {
+    return static_cast<double>(max_delay_.InMicroseconds());
+  }
+
+ private:
+  int remaining_;
+  WaitableEvent done_;
+  TimeDelta total_delay_;
+  TimeDelta max_delay_;
+  int num_samples_;
+
+  DISALLOW_COPY_AND_ASSIGN(PostRecorder);
+};
+
+class Poster : public DelegateSimpleThread::Delegate {
+ public:
+  Poster(MessageLoop* target, PostRecorder* recorder, int num_posts)
+      : target_(target),
+        recorder_(recorder),
+        num_posts_(num_posts) {}
+
+  virtual void Run() {
+    for (int i = 0; i < num_posts_; ++i) {
+      target_->PostTask(FROM_HERE, Bind(&PostRecorder::RunTask,
+                                        Unretained(recorder_),
+                                        TimeTicks::Now()));
+    }
+  }
+
+ private:
+  MessageLoop* target_;
+  PostRecorder* recorder_;
+  int num_posts_;
+
+  DISALLOW_COPY_AND_ASSIGN(Poster);
+};
+
+// Posts kTotalPosts tasks to the loop of |target|, split among |num_posters|
+// threads, and logs the rate and the queueing delay.
+void RunPostBenchmark(const char* loop_name, Thread* target,
+                      int num_posters) {
+  int posts_per_poster = kTotalPosts / num_posters;
+  PostRecorder recorder(posts_per_poster * num_posters);
+  Poster poster(target->message_loop(), &recorder, posts_per_poster);
+  DelegateSimpleThreadPool posters("poster", num_posters);
+  posters.AddWork(&poster, num_posters);
+
+  PerfTimer timer;
+  posters.Start();
+  posters.JoinAll();
+  recorder.Wait();
+  TimeDelta elapsed = timer.Elapsed();
+
+  std::string name = StringPrintf("%s_%d_posters", loop_name, num_posters);
+  LogPerfResult((name + "_rate").c_str(),
+                posts_per_poster * num_posters / elapsed.InSecondsF(),
+                "posts/s");
+  LogPerfResult((name + "_mean_delay").c_str(),
+                recorder.MeanDelayMicroseconds(), "us");
+  LogPerfResult((name + "_max_delay").c_str(),
+                recorder.MaxDelayMicroseconds(), "us");
+}
+
+void RecordWakeup(TimeTicks posted_time, TimeDelta* delay,
+                  WaitableEvent* done) {
+  *delay = TimeTicks::Now() - posted_time;
+  done->Signal();
+}
+
+// Measures how long an idle loop takes to run a task posted to it.
+void RunWakeupBenchmark(const char* loop_name, Thread* target) {
+  WaitableEvent done(false, false);
+  TimeDelta total;
+  TimeDelta max;
+  for (int i = 0; i < kNumWakeups; ++i) {
+    // Give the loop time to go back to sleep in its pump.
+    PlatformThread::Sleep(1);
+    TimeDelta delay;
+    target->message_loop()->PostTask(
+        FROM_HERE, Bind(&RecordWakeup, TimeTicks::Now(), &delay, &done));
+    done.Wait();
+    total += delay;
+    if (delay > max)
+      max = delay;
+  }
+
+  std::string name = StringPrintf("%s_wakeup", loop_name);
+  LogPerfResult((name + "_mean").c_str(),
+                total.InMicroseconds() / static_cast<double>(kNumWakeups),
+                "us");
+  LogPerfResult((name + "_max").c_str(),
+                static_cast<double>(max.InMicroseconds()), "us");
+}
+
+void RunAllBenchmarks(const char* loop_name, MessageLoop::Type type) {
+  Thread target(loop_name);
+  Thread::Options options;
+  options.message_loop_type = type;
+  ASSERT_TRUE(target.StartWithOptions(options));
+
+  for (int posters = 1; posters <= kMaxPosters; posters *= 2)
+    RunPostBenchmark(loop_name, &target, posters);
+  RunWakeupBenchmark(loop_name, &target);
+}
+
+}  // namespace
+
+TEST(MessageLoopPerfTest, DefaultLoop) {
+  RunAllBenchmarks("default_loop", MessageLoop::TYPE_DEFAULT);
+}
+
+TEST(MessageLoopPerfTest, IOLoop) {
+  RunAllBenchmarks("io_loop", MessageLoop::TYPE_IO);
+}
+
+}  // namespace base
@@ -10,6 +10,7 @@
 #include "base/eintr_wrapper.h"
 #include "base/logging.h"
 #include "base/memory/ref_counted.h"
+#include "base/memory/scoped_vector.h"
 #include "base/message_loop.h"
 #include "base/task.h"
 #include "base/threading/platform_thread.h"
@@ -1695,3 +1696,60 @@ TEST(MessageLoopTest, DestructionObserverTest) {
   EXPECT_TRUE(task_destroyed);
   EXPECT_TRUE(destruction_observer_called);
 }
+
+namespace {
+
+// Checks that the tasks posted by each thread run in the order in which that
+// thread posted them, and quits the loop once all of them have run.
+class PostOrderRecorder {
+ public:
+  PostOrderRecorder(int num_threads, int tasks_per_thread)
+      : last_seen_(num_threads, -1),
+        remaining_(num_threads * tasks_per_thread) {
+  }
+
+  void Record(int thread_index, int sequence) {
+    EXPECT_EQ(last_seen_[thread_index] + 1, sequence);
+    last_seen_[thread_index] = sequence;
+    if (--remaining_ == 0)
+      MessageLoop::current()->Quit();
+  }
+
+  int last_seen(int thread_index) const { return last_seen_[thread_index]; }
+
+ private:
+  std::vector<int> last_seen_;
+  int remaining_;
+};
+
+void PostRecordTasks(MessageLoop* target, PostOrderRecorder* recorder,
+                     int thread_index, int num_tasks) {
+  for (int i = 0; i < num_tasks; ++i) {
+    target->PostTask(FROM_HERE, base::Bind(&PostOrderRecorder::Record,
+                                           base::Unretained(recorder),
+                                           thread_index, i));
+  }
+}
+
+}  // namespace
+
+TEST(MessageLoopTest, PostTaskFromManyThreads) {
+  const int kNumThreads = 8;
+  const int kTasksPerThread = 1000;
+
+  MessageLoop loop;
+  PostOrderRecorder recorder(kNumThreads, kTasksPerThread);
+  ScopedVector<Thread> threads;
+  for (int i = 0; i < kNumThreads; ++i) {
+    Thread* thread = new Thread("PostTaskFromManyThreads");
+    ASSERT_TRUE(thread->Start());
+    threads.push_back(thread);
+    thread->message_loop()->PostTask(
+        FROM_HERE,
+        base::Bind(&PostRecordTasks, &loop, &recorder, i, kTasksPerThread));
+  }
+  loop.Run();
+
+  for (int i = 0; i < kNumThreads; ++i)
+    EXPECT_EQ(kTasksPerThread - 1, recorder.last_seen(i));
+}
@@ -15,13 +15,100 @@
 #include <string>
 
 #include "base/debug/leak_annotations.h"
+#include "base/hash.h"
+#include "base/lazy_instance.h"
 #include "base/logging.h"
+#include "base/memory/scoped_ptr.h"
 #include "base/pickle.h"
 #include "base/stringprintf.h"
 #include "base/synchronization/lock.h"
+#include "base/threading/thread_local.h"
 
 namespace base {
 
+namespace {
+
+// The sample shard used by the current thread, plus one, so that it is NULL
+// until the thread records its first sample.
+LazyInstance<ThreadLocalPointer<void>,
+             LeakyLazyInstanceTraits<ThreadLocalPointer<void> > >
+    g_thread_sample_shard(LINKER_INITIALIZED);
+
+// Used to spread the threads over the sample shards.
+subtle::Atomic32 g_sample_shard_sequence = 0;
+
+}  // namespace
+
+// The counters are only updated with atomic increments, so a snapshot taken
+// while a sample is being recorded may see it in its bucket but not yet in
+// |redundant_count_| (see FindCorruption()).
+class Histogram::SampleShard {
+ public:
+  explicit SampleShard(size_t bucket_count)
+      : counts_(new subtle::Atomic32[bucket_count]),
+        redundant_count_(0) {
+    for (size_t index = 0; index < bucket_count; ++index)
+      counts_[index] = 0;
+#if defined(ARCH_CPU_64_BITS)
+    sum_ = 0;
+#else
+    sum_low_ = 0;
+    sum_high_ = 0;
+#endif
+  }
+
+  void Accumulate(Sample value, Count count, size_t index) {
+    subtle::NoBarrier_AtomicIncrement(&counts_[index], count);
+    subtle::NoBarrier_AtomicIncrement(&redundant_count_, count);
+#if defined(ARCH_CPU_64_BITS)
+    subtle::NoBarrier_AtomicIncrement(&sum_, static_cast<int64>(value) * count);
+#else
+    // Propagate the carry, or the borrow, of the low word.
+    int32 delta = value * count;
+    uint32 low = static_cast<uint32>(
+        subtle::NoBarrier_AtomicIncrement(&sum_low_, delta));
+    uint32 previous_low = low - static_cast<uint32>(delta);
+    if (delta > 0 && low < previous_low)
+      subtle::NoBarrier_AtomicIncrement(&sum_high_, 1);
+    else if (delta < 0 && low > previous_low)
+      subtle::NoBarrier_AtomicIncrement(&sum_high_, -1);
+#endif
+  }
+
+  Count counts(size_t index) const {
+    return subtle::NoBarrier_Load(&counts_[index]);
+  }
+
+  int64 sum() const {
+#if defined(ARCH_CPU_64_BITS)
+    return subtle::NoBarrier_Load(&sum_);
+#else
+    // May be off by a carry if it happens while the words are read.
+    uint32 low = static_cast<uint32>(subtle::NoBarrier_Load(&sum_low_));
+    int64 high = subtle::NoBarrier_Load(&sum_high_);
+    return (high << 32) + low;
+#endif
+  }
+
+  Count redundant_count() const {
+    return subtle::NoBarrier_Load(&redundant_count_);
+  }
+
+ private:
+  scoped_array<subtle::Atomic32> counts_;
+  subtle::Atomic32 redundant_count_;
+#if defined(ARCH_CPU_64_BITS)
+  subtle::Atomic64 sum_;
+#else
+  // There are no 64-bit atomic operations on 32-bit CPUs, so the sum is kept in
+  // two words.
+  subtle::Atomic32 sum_low_;
+  subtle::Atomic32 sum_high_;
+#endif
+
+  DISALLOW_COPY_AND_ASSIGN(SampleShard);
+};
+
 // Static table of checksums for all possible 8 bit bytes.
 const uint32 Histogram::kCrcTable[256] = {0x0, 0x77073096L, 0xee0e612cL,
 0x990951baL, 0x76dc419L, 0x706af48fL, 0xe963a535L, 0x9e6495a3L, 0xedb8832L,
@@ -375,6 +462,16 @@ size_t Histogram::bucket_count() const {
 void Histogram::SnapshotSample(SampleSet* sample) const {
   // Note locking not done in this version!!!
   *sample = sample_;
+  for (size_t i = 0; i < kSampleShardCount; ++i) {
+    const SampleShard* shard = reinterpret_cast<const SampleShard*>(
+        subtle::Acquire_Load(&sample_shards_[i]));
+    if (!shard)
+      continue;
+    for (size_t index = 0; index < sample->counts_.size(); ++index)
+      sample->counts_[index] += shard->counts(index);
+    sample->sum_ += shard->sum();
+    sample->redundant_count_ += shard->redundant_count();
+  }
 }
 
 bool Histogram::HasConstructorArguments(Sample minimum,
@@ -431,6 +528,9 @@ Histogram::~Histogram() {
 
   // Just to make sure most derived class did this properly...
   DCHECK(ValidateBucketRanges());
+
+  for (size_t i = 0; i < kSampleShardCount; ++i)
+    delete reinterpret_cast<SampleShard*>(sample_shards_[i]);
 }
 
 // Calculate what range of values are held in each bucket.
@@ -526,8 +626,33 @@ const std::string Histogram::GetAsciiBucketRange(size_t i) const {
 
 // Update histogram data with new sample.
 void Histogram::Accumulate(Sample value, Count count, size_t index) {
-  // Note locking not done in this version!!!
-  sample_.Accumulate(value, count, index);
+  DCHECK(count == 1 || count == -1);
+  GetSampleShard()->Accumulate(value, count, index);
+}
+
+Histogram::SampleShard* Histogram::GetSampleShard() {
+  ThreadLocalPointer<void>& thread_shard = g_thread_sample_shard.Get();
+  uintptr_t shard_index = reinterpret_cast<uintptr_t>(thread_shard.Get());
+  if (!shard_index) {
+    shard_index = static_cast<uint32>(
+        subtle::NoBarrier_AtomicIncrement(&g_sample_shard_sequence, 1)) %
+        kSampleShardCount + 1;
+    thread_shard.Set(reinterpret_cast<void*>(shard_index));
+  }
+  subtle::AtomicWord* slot = &sample_shards_[shard_index - 1];
+
+  SampleShard* shard =
+      reinterpret_cast<SampleShard*>(subtle::Acquire_Load(slot));
+  if (shard)
+    return shard;
+  // Another thread using the same shard may be allocating it too.
+  shard = new SampleShard(bucket_count());
+  if (subtle::Release_CompareAndSwap(
+          slot, 0, reinterpret_cast<subtle::AtomicWord>(shard)) != 0) {
+    delete shard;
+    shard = reinterpret_cast<SampleShard*>(subtle::Acquire_Load(slot));
+  }
+  return shard;
 }
 
 void Histogram::SetBucketRange(size_t i, Sample value) {
@@ -556,6 +681,8 @@ uint32 Histogram::CalculateRangeChecksum() const {
 
 void Histogram::Initialize() {
   sample_.Resize(*this);
+  for (size_t i = 0; i < kSampleShardCount; ++i)
+    sample_shards_[i] = 0;
   if (declared_min_ < 1)
     declared_min_ = 1;
   if (declared_max_ > kSampleType_MAX - 1)
@@ -1024,6 +1151,8 @@ StatisticsRecorder::~StatisticsRecorder() {
     base::AutoLock auto_lock(*lock_);
     histograms = histograms_;
     histograms_ = NULL;
+    for (size_t slot = 0; slot < kIndexSize; ++slot)
+      subtle::NoBarrier_Store(&index_[slot], 0);
   }
   delete histograms;
   // We don't delete lock_ on purpose to avoid having to properly protect
@@ -1059,6 +1188,7 @@ Histogram* StatisticsRecorder::RegisterOrDeleteDuplicate(Histogram* histogram) {
   // Avoid overwriting a previous registration.
   if (histograms_->end() == it) {
     (*histograms_)[name] = histogram;
+    AddToIndex(histogram);
     ANNOTATE_LEAKING_OBJECT_PTR(histogram);  // see crbug.com/79322
   } else {
     delete histogram;  // We already have one by this name.
@@ -1122,6 +1252,21 @@ bool StatisticsRecorder::FindHistogram(const std::string& name,
                                        Histogram** histogram) {
   if (lock_ == NULL)
     return false;
+
+  // Registered histograms are never removed from |index_| while the recorder
+  // is alive, so reaching an empty slot means that |name| isn't registered.
+  size_t first_slot = IndexSlot(name);
+  for (size_t probe = 0; probe < kMaxIndexProbes; ++probe) {
+    Histogram* indexed_histogram = reinterpret_cast<Histogram*>(
+        subtle::Acquire_Load(&index_[(first_slot + probe) % kIndexSize]));
+    if (!indexed_histogram)
+      return false;
+    if (indexed_histogram->histogram_name() == name) {
+      *histogram = indexed_histogram;
+      return true;
+    }
+  }
+
   base::AutoLock auto_lock(*lock_);
   if (!histograms_)
     return false;
@@ -1132,6 +1277,25 @@ bool StatisticsRecorder::FindHistogram(const std::string& name,
   return true;
 }
 
+// private static
+size_t StatisticsRecorder::IndexSlot(const std::string& name) {
+  return HashFNV1a(name.data(), name.size()) % kIndexSize;
+}
+
+// private static
+void StatisticsRecorder::AddToIndex(Histogram* histogram) {
+  lock_->AssertAcquired();
+  size_t first_slot = IndexSlot(histogram->histogram_name());
+  for (size_t probe = 0; probe < kMaxIndexProbes; ++probe) {
+    subtle::AtomicWord* slot = &index_[(first_slot + probe) % kIndexSize];
+    if (!subtle::NoBarrier_Load(slot)) {
+      subtle::Release_Store(slot,
+                            reinterpret_cast<subtle::AtomicWord>(histogram));
+      return;
+    }
+  }
+}
+
 // private static
 void StatisticsRecorder::GetSnapshot(const std::string& query,
                                      Histograms* snapshot) {
@@ -1153,6 +1317,8 @@ StatisticsRecorder::HistogramMap* StatisticsRecorder::histograms_ = NULL;
 // static
 base::Lock* StatisticsRecorder::lock_ = NULL;
 // static
+subtle::AtomicWord StatisticsRecorder::index_[StatisticsRecorder::kIndexSize];
+// static
 bool StatisticsRecorder::dump_on_exit_ = false;
 
 }  // namespace base
@@ -417,6 +417,8 @@ class BASE_EXPORT Histogram {
     // Allow tests to corrupt our innards for testing purposes.
     FRIEND_TEST(HistogramTest, CorruptSampleCounts);
 
+    friend class Histogram;  // To merge the sample shards into snapshots.
+
     // To help identify memory corruption, we reduntantly save the number of
     // samples we've accumulated into all of our buckets.  We can compare this
     // count to the sum of the counts in all buckets, and detect problems.  Note
@@ -503,8 +505,8 @@ class BASE_EXPORT Histogram {
   virtual Sample ranges(size_t i) const;
   uint32 range_checksum() const { return range_checksum_; }
   virtual size_t bucket_count() const;
-  // Snapshot the current complete set of sample data.
-  // Override with atomic/locked snapshot if needed.
+  // Snapshot the current complete set of sample data.  The samples being
+  // recorded on other threads at the same time may be only partially counted.
   virtual void SnapshotSample(SampleSet* sample) const;
 
   virtual bool HasConstructorArguments(Sample minimum, Sample maximum,
@@ -572,9 +574,21 @@ class BASE_EXPORT Histogram {
 
   friend class StatisticsRecorder;  // To allow it to delete duplicates.
 
+  // The counters of the samples recorded by the threads using a shard.
+  class SampleShard;
+
+  // Samples are recorded in one of kSampleShardCount shards, with atomic
+  // increments, so that threads recording samples in the same histogram at the
+  // same time don't contend for the same counters.  Each thread always uses
+  // the same shard, which is allocated when it records its first sample.
+  static const size_t kSampleShardCount = 16;
+
   // Post constructor initialization.
   void Initialize();
 
+  // Returns the shard in which the current thread records its samples.
+  SampleShard* GetSampleShard();
+
   // Checksum function for accumulating range values into a checksum.
   static uint32 Crc32(uint32 sum, Sample range);
 
@@ -631,8 +645,12 @@ class BASE_EXPORT Histogram {
   uint32 range_checksum_;
 
   // Finally, provide the state that changes with the addition of each new
-  // sample.
+  // sample.  |sample_| holds the samples added with AddSampleSet(), and the
+  // samples recorded in this process are in |sample_shards_|, which point to
+  // SampleShards (or are NULL until a thread using the shard records a
+  // sample).  SnapshotSample() merges them.
   SampleSet sample_;
+  subtle::AtomicWord sample_shards_[kSampleShardCount];
 
   DISALLOW_COPY_AND_ASSIGN(Histogram);
 };
@@ -775,8 +793,9 @@ class BASE_EXPORT StatisticsRecorder {
   static void GetHistograms(Histograms* output);
 
   // Find a histogram by name. It matches the exact name. This method is thread
-  // safe.  If a matching histogram is not found, then the |histogram| is
-  // not changed.
+  // safe, and doesn't take any lock unless an unusually large number of
+  // histograms are registered.  If a matching histogram is not found, then the
+  // |histogram| is not changed.
   static bool FindHistogram(const std::string& query, Histogram** histogram);
 
   static bool dump_on_exit() { return dump_on_exit_; }
@@ -799,6 +818,23 @@ class BASE_EXPORT StatisticsRecorder {
   // lock protects access to the above map.
   static base::Lock* lock_;
 
+  // Open addressing hash table of the registered histograms, keyed by their
+  // names, that FindHistogram() reads without taking |lock_|.  The slots point
+  // to the histograms, or are NULL.  They are only set, under |lock_|, when a
+  // histogram is registered, and cleared when the recorder is destroyed.  A
+  // histogram that can't be stored within kMaxIndexProbes slots of its hash is
+  // only found in |histograms_|.
+  static const size_t kIndexSize = 4096;
+  static const size_t kMaxIndexProbes = 8;
+  static subtle::AtomicWord index_[kIndexSize];
+
+  // Returns the first slot of |index_| to probe for |name|.
+  static size_t IndexSlot(const std::string& name);
+
+  // Adds |histogram| to |index_|, if there is room for it.  Must be called
+  // under |lock_|.
+  static void AddToIndex(Histogram* histogram);
+
   // Dump all known histograms to log.
   static bool dump_on_exit_;
 
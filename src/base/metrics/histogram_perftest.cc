@@ -0,0 +1,89 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <string>
+
+#include "base/metrics/histogram.h"
+#include "base/perftimer.h"
+#include "base/stringprintf.h"
+#include "base/threading/simple_thread.h"
+#include "base/time.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace base {
+
+namespace {
+
+const int kTotalSamples = 4 * 1000 * 1000;
+const int kMaxThreads = 16;
+
+// Records samples either in a histogram it got once, like the UMA_HISTOGRAM_*
+// macros do, or in the histogram looked up by name for each sample.
+class Recorder : public DelegateSimpleThread::Delegate {
+ public:
+  Recorder(const std::string& name, bool lookup, int num_samples)
+      : name_(name),
+        lookup_(lookup),
+        num_samples_(num_samples) {}
+
+  virtual void Run() {
+    Histogram* histogram = GetHistogram();
+    for (int i = 0; i < num_samples_; ++i) {
+      if (lookup_)
+        histogram = GetHistogram();
+      histogram->Add(i & 1023);
+    }
+  }
+
+ private:
+  Histogram* GetHistogram() {
+    return Histogram::FactoryGet(name_, 1, 1000, 50, Histogram::kNoFlags);
+  }
+
+  const std::string name_;
+  const bool lookup_;
+  const int num_samples_;
+
+  DISALLOW_COPY_AND_ASSIGN(Recorder);
+};
+
+// Records kTotalSamples samples in a single histogram, split among
+// |num_threads| threads, and logs the time spent per sample.
+void RunBenchmark(const char* test_name, bool lookup, int num_threads) {
+  std::string name = StringPrintf("%s_%d_threads", test_name, num_threads);
+  int samples_per_thread = kTotalSamples / num_threads;
+  Recorder recorder(name, lookup, samples_per_thread);
+  DelegateSimpleThreadPool threads("recorder", num_threads);
+  threads.AddWork(&recorder, num_threads);
+
+  PerfTimer timer;
+  threads.Start();
+  threads.JoinAll();
+  TimeDelta elapsed = timer.Elapsed();
+
+  LogPerfResult(name.c_str(),
+                elapsed.InMicroseconds() * 1000.0 / kTotalSamples,
+                "ns/sample");
+
+  Histogram::SampleSet snapshot;
+  Histogram::FactoryGet(name, 1, 1000, 50, Histogram::kNoFlags)->
+      SnapshotSample(&snapshot);
+  EXPECT_EQ(samples_per_thread * num_threads, snapshot.TotalCount());
+}
+
+}  // namespace
+
+TEST(HistogramPerfTest, Add) {
+  StatisticsRecorder recorder;
+  for (int threads = 1; threads <= kMaxThreads; threads *= 2)
+    RunBenchmark("Histogram_add", false, threads);
+}
+
+TEST(HistogramPerfTest, FactoryGetAndAdd) {
+  StatisticsRecorder recorder;
+  for (int threads = 1; threads <= kMaxThreads; threads *= 2)
+    RunBenchmark("Histogram_factory_get_add", true, threads);
+}
+
+}  // namespace base
@@ -9,6 +9,8 @@
 
 #include "base/memory/scoped_ptr.h"
 #include "base/metrics/histogram.h"
+#include "base/stringprintf.h"
+#include "base/threading/simple_thread.h"
 #include "base/time.h"
 #include "testing/gtest/include/gtest/gtest.h"
 
@@ -347,6 +349,102 @@ TEST(HistogramTest, BucketPlacementTest) {
     EXPECT_EQ(i + 1, sample.counts(i));
 }
 
+// Adds |num_samples| samples, with values 0 to |num_samples| - 1.
+class SampleAdder : public DelegateSimpleThread::Delegate {
+ public:
+  SampleAdder(Histogram* histogram, int num_samples)
+      : histogram_(histogram),
+        num_samples_(num_samples) {}
+
+  virtual void Run() {
+    for (int i = 0; i < num_samples_; ++i)
+      histogram_->Add(i);
+  }
+
+ private:
+  Histogram* histogram_;
+  int num_samples_;
+};
+
+// Samples recorded on many threads at the same time must all be counted.
+TEST(HistogramTest, MultithreadedAddTest) {
+  const int kNumThreads = 20;  // More threads than sample shards.
+  const int kNumSamples = 10000;
+  Histogram* histogram(LinearHistogram::FactoryGet(
+      "MultithreadedHistogram", 1, kNumSamples, kNumSamples + 1,
+      Histogram::kNoFlags));
+
+  SampleAdder adder(histogram, kNumSamples);
+  DelegateSimpleThreadPool threads("adder", kNumThreads);
+  threads.AddWork(&adder, kNumThreads);
+  threads.Start();
+  threads.JoinAll();
+
+  Histogram::SampleSet sample;
+  histogram->SnapshotSample(&sample);
+  EXPECT_EQ(0, histogram->FindCorruption(sample));
+  EXPECT_EQ(kNumThreads * kNumSamples, sample.TotalCount());
+  EXPECT_EQ(kNumThreads * kNumSamples, sample.redundant_count());
+  EXPECT_EQ(static_cast<int64>(kNumThreads) * kNumSamples *
+                (kNumSamples - 1) / 2,
+            sample.sum());
+  for (int i = 0; i < kNumSamples; ++i)
+    EXPECT_EQ(kNumThreads, sample.counts(i));
+}
+
+// Samples added from another histogram are merged with the recorded ones.
+TEST(HistogramTest, AddSampleSetTest) {
+  Histogram* histogram(Histogram::FactoryGet(
+      "Histogram", 1, 64, 8, Histogram::kNoFlags));  // As per header file.
+  histogram->Add(3);
+  histogram->Add(40);
+
+  Histogram::SampleSet other;
+  other.Resize(*histogram);
+  other.Accumulate(3, 1, 2);
+  other.Accumulate(0, 1, 0);
+  histogram->AddSampleSet(other);
+
+  Histogram::SampleSet sample;
+  histogram->SnapshotSample(&sample);
+  EXPECT_EQ(0, histogram->FindCorruption(sample));
+  EXPECT_EQ(4, sample.redundant_count());
+  EXPECT_EQ(46, sample.sum());
+  EXPECT_EQ(1, sample.counts(0));
+  EXPECT_EQ(2, sample.counts(2));
+  EXPECT_EQ(1, sample.counts(6));
+}
+
+// Lookups must find every registered histogram, even when there are too many
+// of them to be found without locking.
+TEST(HistogramTest, FindHistogramTest) {
+  const int kNumHistograms = 10000;
+  std::vector<Histogram*> histograms;
+  {
+    StatisticsRecorder recorder;
+    for (int i = 0; i < kNumHistograms; ++i) {
+      histograms.push_back(Histogram::FactoryGet(
+          StringPrintf("FindHistogram%d", i), 1, 10, 3, Histogram::kNoFlags));
+    }
+
+    for (int i = 0; i < kNumHistograms; ++i) {
+      Histogram* histogram = NULL;
+      EXPECT_TRUE(StatisticsRecorder::FindHistogram(
+          StringPrintf("FindHistogram%d", i), &histogram));
+      EXPECT_EQ(histograms[i], histogram);
+    }
+    Histogram* histogram = NULL;
+    EXPECT_FALSE(StatisticsRecorder::FindHistogram("FindHistogram",
+                                                   &histogram));
+    EXPECT_EQ(reinterpret_cast<Histogram*>(NULL), histogram);
+  }
+
+  // Nothing is found once the recorder is gone.
+  Histogram* histogram = NULL;
+  EXPECT_FALSE(StatisticsRecorder::FindHistogram("FindHistogram0", &histogram));
+  EXPECT_EQ(reinterpret_cast<Histogram*>(NULL), histogram);
+}
+
 }  // namespace
 
 //------------------------------------------------------------------------------
@@ -357,12 +455,12 @@ TEST(HistogramTest, CorruptSampleCounts) {
   Histogram* histogram(Histogram::FactoryGet(
       "Histogram", 1, 64, 8, Histogram::kNoFlags));  // As per header file.
 
-  EXPECT_EQ(0, histogram->sample_.redundant_count());
+  Histogram::SampleSet snapshot;
+  histogram->SnapshotSample(&snapshot);
+  EXPECT_EQ(0, snapshot.redundant_count());
   histogram->Add(20);  // Add some samples.
   histogram->Add(40);
-  EXPECT_EQ(2, histogram->sample_.redundant_count());
 
-  Histogram::SampleSet snapshot;
   histogram->SnapshotSample(&snapshot);
   EXPECT_EQ(Histogram::NO_INCONSISTENCIES, 0);
   EXPECT_EQ(0, histogram->FindCorruption(snapshot));  // No default corruption.
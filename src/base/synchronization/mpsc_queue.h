@@ -0,0 +1,135 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef BASE_SYNCHRONIZATION_MPSC_QUEUE_H_
+#define BASE_SYNCHRONIZATION_MPSC_QUEUE_H_
+#pragma once
+
+#include "base/atomicops.h"
+#include "base/basictypes.h"
+#include "base/logging.h"
+
+namespace base {
+
+// Base class for the elements of an MPSCQueue.  The queue links its elements
+// through this node, so pushing never allocates.
+class MPSCQueueNode {
+ public:
+  MPSCQueueNode() : next_(0) {}
+
+ private:
+  template <typename T> friend class MPSCQueue;
+
+  MPSCQueueNode* next() const {
+    return reinterpret_cast<MPSCQueueNode*>(subtle::Acquire_Load(&next_));
+  }
+
+  subtle::AtomicWord next_;
+
+  DISALLOW_COPY_AND_ASSIGN(MPSCQueueNode);
+};
+
+// MPSCQueue is an intrusive, unbounded FIFO queue that any number of threads
+// may Push() to without taking a lock, while a single consumer thread Pop()s.
+// A push is one atomic exchange and never waits for other threads.
+//
+// T must derive from MPSCQueueNode.  The queue does not own its elements:
+// whoever pops an element is responsible for it, and elements left in the
+// queue when it is destroyed are not deleted.
+//
+// Pop() may return NULL while the queue is not empty, if the producer of the
+// next element has not finished linking it in yet.  Consumers that need to
+// see every element must have producers signal them after Push() returns, and
+// call Pop() again when signaled.
+//
+// Example:
+//   struct Item : public MPSCQueueNode { int value; };
+//   MPSCQueue<Item> queue;
+//   queue.Push(new Item);         // On any thread.
+//   while (Item* item = queue.Pop())  // On the consumer thread.
+//     delete item;
+template <typename T>
+class MPSCQueue {
+ public:
+  MPSCQueue()
+      : head_(&stub_),
+        tail_(reinterpret_cast<subtle::AtomicWord>(&stub_)) {
+  }
+
+  ~MPSCQueue() {
+    DCHECK(IsEmpty()) << "Elements left in the queue are leaked.";
+  }
+
+  // Appends |element|.  May be called on any thread.
+  void Push(T* element) {
+    PushNode(element);
+  }
+
+  // Removes and returns the oldest element, or NULL if there is none ready.
+  // Must only be called on the consumer thread.
+  T* Pop() {
+    MPSCQueueNode* head = head_;
+    MPSCQueueNode* next = head->next();
+    if (head == &stub_) {
+      if (!next)
+        return NULL;
+      head_ = next;
+      head = next;
+      next = next->next();
+    }
+    if (next) {
+      head_ = next;
+      return static_cast<T*>(head);
+    }
+    MPSCQueueNode* tail =
+        reinterpret_cast<MPSCQueueNode*>(subtle::Acquire_Load(&tail_));
+    if (head != tail)
+      return NULL;  // A producer is midway through linking a new element.
+    // |head| is the last element.  Put the stub back behind it so that |head|
+    // can be handed out without leaving the queue without a node.
+    PushNode(&stub_);
+    next = head->next();
+    if (next) {
+      head_ = next;
+      return static_cast<T*>(head);
+    }
+    return NULL;
+  }
+
+  // Returns true if no element has been pushed that was not popped yet.  Must
+  // only be called on the consumer thread.
+  bool IsEmpty() const {
+    return head_ == &stub_ && !stub_.next() &&
+        subtle::Acquire_Load(&tail_) ==
+            reinterpret_cast<subtle::AtomicWord>(&stub_);
+  }
+
+ private:
+  void PushNode(MPSCQueueNode* node) {
+    subtle::NoBarrier_Store(&node->next_, 0);
+    // The next producer links its node through |node| as soon as the exchange
+    // below makes it the tail, so |node| has to be cleared before that.
+    subtle::MemoryBarrier();
+    MPSCQueueNode* previous = reinterpret_cast<MPSCQueueNode*>(
+        subtle::NoBarrier_AtomicExchange(
+            &tail_, reinterpret_cast<subtle::AtomicWord>(node)));
+    subtle::Release_Store(&previous->next_,
+                          reinterpret_cast<subtle::AtomicWord>(node));
+  }
+
+  // Placeholder node, so that the queue always contains at least one node.
+  MPSCQueueNode stub_;
+
+  // Oldest node.  Only accessed by the consumer.
+  MPSCQueueNode* head_;
+
+  // Newest node.  Swapped by producers.
+  subtle::AtomicWord tail_;
+
+  DISALLOW_COPY_AND_ASSIGN(MPSCQueue);
+};
+
+}  // namespace base
+
+#endif  // BASE_SYNCHRONIZATION_MPSC_QUEUE_H_
@@ -0,0 +1,133 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/synchronization/mpsc_queue.h"
+
+#include <vector>
+
+#include "base/memory/scoped_vector.h"
+#include "base/threading/platform_thread.h"
+#include "base/threading/simple_thread.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace base {
+
+namespace {
+
+struct Item : public MPSCQueueNode {
+  Item(int producer, int sequence) : producer(producer), sequence(sequence) {}
+
+  int producer;
+  int sequence;
+};
+
+class Producer : public DelegateSimpleThread::Delegate {
+ public:
+  Producer(MPSCQueue<Item>* queue, int index, int num_items)
+      : queue_(queue),
+        index_(index),
+        num_items_(num_items) {}
+
+  virtual void Run() {
+    for (int i = 0; i < num_items_; ++i)
+      queue_->Push(new Item(index_, i));
+  }
+
+ private:
+  MPSCQueue<Item>* queue_;
+  int index_;
+  int num_items_;
+
+  DISALLOW_COPY_AND_ASSIGN(Producer);
+};
+
+}  // namespace
+
+TEST(MPSCQueueTest, Empty) {
+  MPSCQueue<Item> queue;
+  EXPECT_TRUE(queue.IsEmpty());
+  EXPECT_TRUE(queue.Pop() == NULL);
+  EXPECT_TRUE(queue.IsEmpty());
+}
+
+TEST(MPSCQueueTest, SingleThreadFIFO) {
+  MPSCQueue<Item> queue;
+  for (int i = 0; i < 10; ++i)
+    queue.Push(new Item(0, i));
+  EXPECT_FALSE(queue.IsEmpty());
+
+  for (int i = 0; i < 10; ++i) {
+    Item* item = queue.Pop();
+    ASSERT_TRUE(item != NULL);
+    EXPECT_EQ(i, item->sequence);
+    delete item;
+  }
+  EXPECT_TRUE(queue.Pop() == NULL);
+  EXPECT_TRUE(queue.IsEmpty());
+
+  // The queue keeps working after it was drained.
+  queue.Push(new Item(0, 10));
+  Item* item = queue.Pop();
+  ASSERT_TRUE(item != NULL);
+  EXPECT_EQ(10, item->sequence);
+  delete item;
+  EXPECT_TRUE(queue.IsEmpty());
+}
+
+TEST(MPSCQueueTest, InterleavedPushAndPop) {
+  MPSCQueue<Item> queue;
+  int next_expected = 0;
+  for (int i = 0; i < 100; ++i) {
+    queue.Push(new Item(0, i));
+    if (i % 3 == 0) {
+      Item* item = queue.Pop();
+      ASSERT_TRUE(item != NULL);
+      EXPECT_EQ(next_expected++, item->sequence);
+      delete item;
+    }
+  }
+  while (Item* item = queue.Pop()) {
+    EXPECT_EQ(next_expected++, item->sequence);
+    delete item;
+  }
+  EXPECT_EQ(100, next_expected);
+  EXPECT_TRUE(queue.IsEmpty());
+}
+
+TEST(MPSCQueueTest, ManyProducers) {
+  const int kNumProducers = 8;
+  const int kItemsPerProducer = 10000;
+
+  MPSCQueue<Item> queue;
+  ScopedVector<Producer> producers;
+  DelegateSimpleThreadPool pool("mpsc_producer", kNumProducers);
+  for (int i = 0; i < kNumProducers; ++i) {
+    producers.push_back(new Producer(&queue, i, kItemsPerProducer));
+    pool.AddWork(producers[i]);
+  }
+  pool.Start();
+
+  // Pop concurrently with the producers; items of each producer must come out
+  // in the order they were pushed.
+  std::vector<int> next_sequence(kNumProducers, 0);
+  int remaining = kNumProducers * kItemsPerProducer;
+  while (remaining > 0) {
+    Item* item = queue.Pop();
+    if (!item) {
+      PlatformThread::YieldCurrentThread();
+      continue;
+    }
+    EXPECT_EQ(next_sequence[item->producer]++, item->sequence);
+    delete item;
+    remaining--;
+  }
+  pool.JoinAll();
+
+  EXPECT_TRUE(queue.Pop() == NULL);
+  EXPECT_TRUE(queue.IsEmpty());
+  for (int i = 0; i < kNumProducers; ++i)
+    EXPECT_EQ(kItemsPerProducer, next_sequence[i]);
+}
+
+}  // namespace base
@@ -10,6 +10,7 @@
 #include "base/logging.h"
 #include "base/memory/ref_counted.h"
 #include "base/stringprintf.h"
+#include "base/sys_info.h"
 #include "base/task.h"
 #include "base/threading/platform_thread.h"
 #include "base/threading/worker_pool.h"
@@ -23,6 +24,19 @@ const int kIdleSecondsBeforeExit = 10 * 60;
 // A stack size of 64 KB is too small for the CERT_PKIXVerifyCert
 // function of NSS because of NSS bug 439169.
 const int kWorkerThreadStackSize = 128 * 1024;
+// Workers look at the slow lane first for one in this many tasks, so that a
+// steady stream of short tasks can't starve the slow ones.
+const uint32 kSlowLaneFirstInterval = 4;
+
+// Cheap per-thread generator used to pick the shards to steal from.
+uint32 NextRandom(uint32* state) {
+  uint32 x = *state;
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  *state = x;
+  return x;
+}
 
 class WorkerPoolImpl {
  public:
@@ -35,12 +49,14 @@ class WorkerPoolImpl {
                 const base::Closure& task, bool task_is_slow);
 
  private:
-  scoped_refptr<base::PosixDynamicThreadPool> pool_;
+  scoped_refptr<base::PosixWorkStealingThreadPool> pool_;
 };
 
 WorkerPoolImpl::WorkerPoolImpl()
-    : pool_(new base::PosixDynamicThreadPool("WorkerPool",
-                                             kIdleSecondsBeforeExit)) {
+    : pool_(new base::PosixWorkStealingThreadPool(
+          "WorkerPool",
+          kIdleSecondsBeforeExit,
+          base::SysInfo::NumberOfProcessors())) {
 }
 
 WorkerPoolImpl::~WorkerPoolImpl() {
@@ -49,12 +65,12 @@ WorkerPoolImpl::~WorkerPoolImpl() {
 
 void WorkerPoolImpl::PostTask(const tracked_objects::Location& from_here,
                               Task* task, bool task_is_slow) {
-  pool_->PostTask(from_here, task);
+  pool_->PostTask(from_here, task, task_is_slow);
 }
 
 void WorkerPoolImpl::PostTask(const tracked_objects::Location& from_here,
                               const base::Closure& task, bool task_is_slow) {
-  pool_->PostTask(from_here, task);
+  pool_->PostTask(from_here, task, task_is_slow);
 }
 
 base::LazyInstance<WorkerPoolImpl> g_lazy_worker_pool(base::LINKER_INITIALIZED);
@@ -89,7 +105,8 @@ void WorkerThread::ThreadMain() {
         "src_func", pending_task.posted_from.function_name());
 
 #if defined(TRACK_ALL_TASK_OBJECTS)
-    TimeTicks start_of_run = tracked_objects::ThreadData::Now();
+    TimeTicks start_of_run =
+        tracked_objects::ThreadData::NowIfSampled(pending_task.post_births);
 #endif  // defined(TRACK_ALL_TASK_OBJECTS)
     pending_task.task.Run();
 #if defined(TRACK_ALL_TASK_OBJECTS)
@@ -102,6 +119,59 @@ void WorkerThread::ThreadMain() {
   delete this;
 }
 
+class StealingWorkerThread : public PlatformThread::Delegate {
+ public:
+  StealingWorkerThread(const std::string& name_prefix,
+                       int home_shard,
+                       base::PosixWorkStealingThreadPool* pool)
+      : name_prefix_(name_prefix),
+        home_shard_(home_shard),
+        pool_(pool) {}
+
+  virtual void ThreadMain();
+
+ private:
+  const std::string name_prefix_;
+  const int home_shard_;
+  scoped_refptr<base::PosixWorkStealingThreadPool> pool_;
+
+  DISALLOW_COPY_AND_ASSIGN(StealingWorkerThread);
+};
+
+void StealingWorkerThread::ThreadMain() {
+  const std::string name = base::StringPrintf(
+      "%s/%d", name_prefix_.c_str(), PlatformThread::CurrentId());
+  PlatformThread::SetName(name.c_str());
+
+  // Any non-zero seed works; mix in the thread id so that workers do not all
+  // probe the same victims.
+  uint32 random_state =
+      (static_cast<uint32>(PlatformThread::CurrentId()) * 2654435761U) | 1;
+
+  for (;;) {
+    PosixWorkStealingThreadPool::PendingTask pending_task =
+        pool_->WaitForTask(home_shard_, &random_state);
+    if (pending_task.task.is_null())
+      break;
+    UNSHIPPED_TRACE_EVENT2("task", "StealingWorkerThread::ThreadMain::Run",
+        "src_file", pending_task.posted_from.file_name(),
+        "src_func", pending_task.posted_from.function_name());
+
+#if defined(TRACK_ALL_TASK_OBJECTS)
+    TimeTicks start_of_run =
+        tracked_objects::ThreadData::NowIfSampled(pending_task.post_births);
+#endif  // defined(TRACK_ALL_TASK_OBJECTS)
+    pending_task.task.Run();
+#if defined(TRACK_ALL_TASK_OBJECTS)
+    tracked_objects::ThreadData::TallyADeathIfActive(pending_task.post_births,
+        pending_task.time_posted, TimeTicks(), start_of_run);
+#endif  // defined(TRACK_ALL_TASK_OBJECTS)
+  }
+
+  // The StealingWorkerThread is non-joinable, so it deletes itself.
+  delete this;
+}
+
 }  // namespace
 
 bool WorkerPool::PostTask(const tracked_objects::Location& from_here,
@@ -123,7 +193,7 @@ PosixDynamicThreadPool::PendingTask::PendingTask(
       task(task) {
 #if defined(TRACK_ALL_TASK_OBJECTS)
   post_births = tracked_objects::ThreadData::TallyABirthIfActive(posted_from);
-  time_posted = tracked_objects::ThreadData::Now();
+  time_posted = tracked_objects::ThreadData::NowIfSampled(post_births);
 #endif  // defined(TRACK_ALL_TASK_OBJECTS)
 }
 
@@ -225,4 +295,207 @@ PosixDynamicThreadPool::PendingTask PosixDynamicThreadPool::WaitForTask() {
   return pending_task;
 }
 
+PosixWorkStealingThreadPool::Shard::Shard() {
+}
+
+PosixWorkStealingThreadPool::Shard::~Shard() {
+}
+
+PosixWorkStealingThreadPool::PosixWorkStealingThreadPool(
+    const std::string& name_prefix,
+    int idle_seconds_before_exit,
+    int num_shards)
+    : name_prefix_(name_prefix),
+      idle_seconds_before_exit_(idle_seconds_before_exit),
+      num_pending_tasks_(0),
+      num_idle_threads_(0),
+      num_threads_(0),
+      terminated_(0),
+      next_worker_id_(0),
+      idle_cv_(&idle_lock_),
+      num_wakeups_(0),
+      num_idle_threads_cv_(NULL) {
+  DCHECK_GT(num_shards, 0);
+  for (int i = 0; i < num_shards; ++i)
+    shards_.push_back(new Shard);
+}
+
+PosixWorkStealingThreadPool::~PosixWorkStealingThreadPool() {
+}
+
+void PosixWorkStealingThreadPool::Terminate() {
+  {
+    AutoLock locked(idle_lock_);
+    DCHECK(!subtle::Acquire_Load(&terminated_))
+        << "Thread pool is already terminated.";
+    subtle::Release_Store(&terminated_, 1);
+  }
+  idle_cv_.Broadcast();
+}
+
+void PosixWorkStealingThreadPool::PostTask(
+    const tracked_objects::Location& from_here,
+    Task* task,
+    bool task_is_slow) {
+  PendingTask pending_task(from_here,
+                           base::Bind(&subtle::TaskClosureAdapter::Run,
+                                      new subtle::TaskClosureAdapter(task)));
+  // See PosixDynamicThreadPool::PostTask() for why the closure is handed off
+  // destructively.
+  AddTask(&pending_task, task_is_slow);
+}
+
+void PosixWorkStealingThreadPool::PostTask(
+    const tracked_objects::Location& from_here,
+    const base::Closure& task,
+    bool task_is_slow) {
+  PendingTask pending_task(from_here, task);
+  AddTask(&pending_task, task_is_slow);
+}
+
+void PosixWorkStealingThreadPool::AddTask(PendingTask* pending_task,
+                                          bool task_is_slow) {
+  DCHECK(!subtle::Acquire_Load(&terminated_)) <<
+      "This thread pool is already terminated.  Do not post new tasks.";
+
+  // Posting threads stick to one shard, so distinct producers rarely contend.
+  Shard* shard = shards_[
+      static_cast<uint32>(PlatformThread::CurrentId()) % shards_.size()];
+  {
+    AutoLock locked(shard->lock);
+    if (task_is_slow)
+      shard->slow_tasks.push_back(*pending_task);
+    else
+      shard->fast_tasks.push_back(*pending_task);
+    pending_task->task.Reset();
+  }
+
+  // This increment must be visible before we look for idle workers, and
+  // WaitForWork() checks for pending tasks only after advertising itself as
+  // idle, so the new task cannot be missed by both sides.
+  subtle::Barrier_AtomicIncrement(&num_pending_tasks_, 1);
+  WakeOrStartWorker();
+}
+
+PosixWorkStealingThreadPool::PendingTask
+PosixWorkStealingThreadPool::WaitForTask(int home_shard,
+                                         uint32* random_state) {
+  const int num_shards = static_cast<int>(shards_.size());
+  for (;;) {
+    if (subtle::Acquire_Load(&terminated_))
+      return PendingTask(FROM_HERE, base::Closure());
+
+    if (subtle::Acquire_Load(&num_pending_tasks_) > 0) {
+      // Visit the home shard first, then the others in a random rotation.
+      const int first_victim =
+          num_shards > 1 ? NextRandom(random_state) % (num_shards - 1) : 0;
+      // Short tasks are preferred over slow ones, most of the time.
+      const int first_lane =
+          NextRandom(random_state) % kSlowLaneFirstInterval == 0 ? 1 : 0;
+      for (int i_lane = 0; i_lane < 2; ++i_lane) {
+        const int lane = first_lane ^ i_lane;
+        for (int i = 0; i < num_shards; ++i) {
+          int index = home_shard;
+          if (i > 0) {
+            index = (home_shard + 1 + (first_victim + i - 1) % (num_shards - 1))
+                % num_shards;
+          }
+          Shard* shard = shards_[index];
+          AutoLock locked(shard->lock);
+          std::deque<PendingTask>* queue =
+              lane == 0 ? &shard->fast_tasks : &shard->slow_tasks;
+          if (queue->empty())
+            continue;
+          PendingTask pending_task = queue->front();
+          queue->pop_front();
+          subtle::Barrier_AtomicIncrement(&num_pending_tasks_, -1);
+          return pending_task;
+        }
+      }
+    }
+
+    if (!WaitForWork()) {
+      // We waited for work, but there's still no work.  Return NULL to signal
+      // the thread to terminate.
+      return PendingTask(FROM_HERE, base::Closure());
+    }
+  }
+}
+
+bool PosixWorkStealingThreadPool::WaitForWork() {
+  AutoLock locked(idle_lock_);
+
+  subtle::Barrier_AtomicIncrement(&num_idle_threads_, 1);
+  if (num_idle_threads_cv_.get())
+    num_idle_threads_cv_->Signal();
+
+  // A task may have been posted before we advertised ourselves as idle.  Take
+  // our advertisement back and go look for it.  If a poster already claimed
+  // it, a wakeup is on its way and we have to wait for it below.
+  if (subtle::Acquire_Load(&num_pending_tasks_) > 0 && TryClaimIdleWorker())
+    return true;
+
+  const TimeTicks deadline = TimeTicks::Now() +
+      TimeDelta::FromSeconds(idle_seconds_before_exit_);
+  while (num_wakeups_ == 0) {
+    if (subtle::Acquire_Load(&terminated_))
+      return false;
+    TimeDelta remaining = deadline - TimeTicks::Now();
+    if (remaining <= TimeDelta()) {
+      // Stop counting this thread before retracting its advertisement, so
+      // that a poster that fails to claim it knows it has to start a thread.
+      subtle::Barrier_AtomicIncrement(&num_threads_, -1);
+      if (TryClaimIdleWorker())
+        return false;
+      subtle::Barrier_AtomicIncrement(&num_threads_, 1);
+      while (num_wakeups_ == 0 && !subtle::Acquire_Load(&terminated_))
+        idle_cv_.Wait();
+      break;
+    }
+    idle_cv_.TimedWait(remaining);
+  }
+
+  if (subtle::Acquire_Load(&terminated_))
+    return false;
+  num_wakeups_--;
+  return true;
+}
+
+void PosixWorkStealingThreadPool::WakeOrStartWorker() {
+  if (TryClaimIdleWorker()) {
+    AutoLock locked(idle_lock_);
+    num_wakeups_++;
+    idle_cv_.Signal();
+    return;
+  }
+
+  // Every worker is busy, and any of them may be blocked on the new task, so
+  // the pool grows like PosixDynamicThreadPool does.
+  StartWorker();
+}
+
+bool PosixWorkStealingThreadPool::TryClaimIdleWorker() {
+  for (;;) {
+    subtle::Atomic32 num_idle = subtle::Acquire_Load(&num_idle_threads_);
+    if (num_idle <= 0)
+      return false;
+    if (subtle::Acquire_CompareAndSwap(&num_idle_threads_, num_idle,
+                                       num_idle - 1) == num_idle) {
+      return true;
+    }
+  }
+}
+
+void PosixWorkStealingThreadPool::StartWorker() {
+  subtle::Atomic32 worker_id =
+      subtle::NoBarrier_AtomicIncrement(&next_worker_id_, 1);
+  subtle::Barrier_AtomicIncrement(&num_threads_, 1);
+
+  // The new PlatformThread will take ownership of the StealingWorkerThread
+  // object, which will delete itself on exit.
+  StealingWorkerThread* worker = new StealingWorkerThread(
+      name_prefix_, static_cast<uint32>(worker_id) % shards_.size(), this);
+  PlatformThread::CreateNonJoinable(kWorkerThreadStackSize, worker);
+}
+
 }  // namespace base
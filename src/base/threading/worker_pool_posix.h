@@ -17,6 +17,16 @@
 // worker threads exit.  The owner of PosixDynamicThreadPool should likewise
 // maintain a scoped_refptr to the PosixDynamicThreadPool instance.
 //
+// PosixWorkStealingThreadPool is the pool actually used by WorkerPool.  It
+// keeps the same non-joinable, self-deleting worker threads, but replaces the
+// single lock-protected task queue with a set of independently locked shards.
+// Producers push onto a shard picked from their thread id, and workers drain
+// their home shard before stealing from randomly chosen shards.  Each shard
+// keeps two lanes so that short tasks are never queued behind tasks that were
+// posted with |task_is_slow|.  Like PosixDynamicThreadPool, it starts a new
+// thread whenever a task is posted while no worker is idle, so tasks that
+// block on other tasks can't deadlock it.
+//
 // NOTE: The classes defined in this file are only meant for use by the POSIX
 // implementation of WorkerPool.  No one else should be using these classes.
 // These symbols are exported in a header purely for testing purposes.
@@ -25,15 +35,18 @@
 #define BASE_THREADING_WORKER_POOL_POSIX_H_
 #pragma once
 
+#include <deque>
 #include <queue>
 #include <string>
 
+#include "base/atomicops.h"
 #include "base/basictypes.h"
 #include "base/callback.h"
 #include "base/location.h"
 #include "base/time.h"
 #include "base/memory/ref_counted.h"
 #include "base/memory/scoped_ptr.h"
+#include "base/memory/scoped_vector.h"
 #include "base/synchronization/condition_variable.h"
 #include "base/synchronization/lock.h"
 #include "base/threading/platform_thread.h"
@@ -118,6 +131,103 @@ class BASE_EXPORT PosixDynamicThreadPool
   DISALLOW_COPY_AND_ASSIGN(PosixDynamicThreadPool);
 };
 
+class BASE_EXPORT PosixWorkStealingThreadPool
+    : public RefCountedThreadSafe<PosixWorkStealingThreadPool> {
+ public:
+  class PosixWorkStealingThreadPoolPeer;
+
+  typedef PosixDynamicThreadPool::PendingTask PendingTask;
+
+  // All worker threads will share the same |name_prefix|.  They will exit after
+  // |idle_seconds_before_exit|.  Tasks are spread over |num_shards| queues.
+  PosixWorkStealingThreadPool(const std::string& name_prefix,
+                              int idle_seconds_before_exit,
+                              int num_shards);
+  ~PosixWorkStealingThreadPool();
+
+  // Indicates that the thread pool is going away.  Stops handing out tasks to
+  // worker threads.  Wakes up all the idle threads to let them exit.
+  void Terminate();
+
+  // Adds |task| to the thread pool.  PosixWorkStealingThreadPool assumes
+  // ownership of |task|.
+  //
+  // TODO(ajwong): Remove this compatibility API once the Task -> Closure
+  // migration is finished.
+  void PostTask(const tracked_objects::Location& from_here, Task* task,
+                bool task_is_slow);
+
+  // Adds |task| to the thread pool.
+  void PostTask(const tracked_objects::Location& from_here,
+                const base::Closure& task, bool task_is_slow);
+
+  // Worker thread method that looks for work, starting with the shard at
+  // |home_shard| and stealing from the other shards if it is empty.  Waits for
+  // up to |idle_seconds_before_exit| for more work.  |random_state| is the
+  // worker's private generator used to pick victims, and to pick the lane to
+  // look at first.  Returns a task with a null closure if the worker should
+  // exit.
+  PendingTask WaitForTask(int home_shard, uint32* random_state);
+
+ private:
+  friend class PosixWorkStealingThreadPoolPeer;
+
+  // The queues of one shard.  Each shard is allocated separately so that
+  // the locks of different shards do not share cache lines.
+  struct Shard {
+    Shard();
+    ~Shard();
+
+    Lock lock;  // Protects the two queues below.
+    std::deque<PendingTask> fast_tasks;
+    std::deque<PendingTask> slow_tasks;
+  };
+
+  // Adds pending_task to the shard of the calling thread.  This function will
+  // clear |pending_task->task|.
+  void AddTask(PendingTask* pending_task, bool task_is_slow);
+
+  // Blocks the calling worker until a task is posted or the idle timeout
+  // expires.  Returns false if the worker should exit.
+  bool WaitForWork();
+
+  // Wakes an idle worker if there is one.  Otherwise starts a new worker.
+  void WakeOrStartWorker();
+
+  // Reserves one idle worker, which will be woken up by the caller.
+  bool TryClaimIdleWorker();
+
+  void StartWorker();
+
+  const std::string name_prefix_;
+  const int idle_seconds_before_exit_;
+
+  ScopedVector<Shard> shards_;
+
+  // Number of tasks queued in all the shards.
+  subtle::Atomic32 num_pending_tasks_;
+  // Number of idle workers that have not been claimed by a poster yet.
+  subtle::Atomic32 num_idle_threads_;
+  // Number of live workers.
+  subtle::Atomic32 num_threads_;
+  subtle::Atomic32 terminated_;
+  // Next worker id, used to spread home shards.
+  subtle::Atomic32 next_worker_id_;
+
+  Lock idle_lock_;  // Protects |num_wakeups_|.
+  // Signal()s idle worker threads to let them know more tasks are available.
+  // Also used for Broadcast()'ing to worker threads to let them know the pool
+  // is being deleted and they can exit.
+  ConditionVariable idle_cv_;
+  // Number of claimed idle workers that still have to wake up.
+  int num_wakeups_;
+  // Only used for tests to ensure correct thread ordering.  It will always be
+  // NULL in non-test code.  Signaled whenever a worker becomes idle.
+  scoped_ptr<ConditionVariable> num_idle_threads_cv_;
+
+  DISALLOW_COPY_AND_ASSIGN(PosixWorkStealingThreadPool);
+};
+
 }  // namespace base
 
 #endif  // BASE_THREADING_WORKER_POOL_POSIX_H_
@@ -0,0 +1,167 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/threading/worker_pool_posix.h"
+
+#include "base/atomicops.h"
+#include "base/bind.h"
+#include "base/perftimer.h"
+#include "base/stringprintf.h"
+#include "base/synchronization/lock.h"
+#include "base/synchronization/waitable_event.h"
+#include "base/sys_info.h"
+#include "base/threading/simple_thread.h"
+#include "base/time.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace base {
+
+namespace {
+
+const int kTotalTasks = 64 * 1000;
+const int kMaxProducers = 64;
+
+// Hides the differences between the two pools from the benchmark.
+class PoolAdapter {
+ public:
+  virtual ~PoolAdapter() {}
+  virtual void PostTask(const Closure& task) = 0;
+  virtual void Terminate() = 0;
+};
+
+class DynamicPoolAdapter : public PoolAdapter {
+ public:
+  DynamicPoolAdapter()
+      : pool_(new PosixDynamicThreadPool("perf_dynamic", 60)) {}
+
+  virtual void PostTask(const Closure& task) {
+    pool_->PostTask(FROM_HERE, task);
+  }
+  virtual void Terminate() { pool_->Terminate(); }
+
+ private:
+  scoped_refptr<PosixDynamicThreadPool> pool_;
+};
+
+class StealingPoolAdapter : public PoolAdapter {
+ public:
+  StealingPoolAdapter()
+      : pool_(new PosixWorkStealingThreadPool(
+            "perf_stealing", 60, SysInfo::NumberOfProcessors())) {}
+
+  virtual void PostTask(const Closure& task) {
+    pool_->PostTask(FROM_HERE, task, false);
+  }
+  virtual void Terminate() { pool_->Terminate(); }
+
+ private:
+  scoped_refptr<PosixWorkStealingThreadPool> pool_;
+};
+
+// Counts completed tasks and how long they were queued.
+class Recorder {
+ public:
+  explicit Recorder(int num_tasks)
+      : remaining_(num_tasks),
+        done_(true, false),
+        num_samples_(0) {}
+
+  void RunTask(TimeTicks posted_time) {
+    TimeDelta delay = TimeTicks::Now() - posted_time;
+    {
+      AutoLock locked(lock_);
+      total_delay_ += delay;
+      if (delay > max_delay_)
+        max_delay_ = delay;
+      num_samples_++;
+    }
+    if (subtle::Barrier_AtomicIncrement(&remaining_, -1) == 0)
+      done_.Signal();
+  }
+
+  void Wait() { done_.Wait(); }
+
+  double MeanDelayMicroseconds() const {
+    return total_delay_.InMicroseconds() / static_cast<double>(num_samples_);
+  }
+  double MaxDelayMicroseconds() const {
+    return static_cast<double>(max_delay_.InMicroseconds());
+  }
+
+ private:
+  subtle::Atomic32 remaining_;
+  WaitableEvent done_;
+  Lock lock_;
+  TimeDelta total_delay_;
+  TimeDelta max_delay_;
+  int num_samples_;
+
+  DISALLOW_COPY_AND_ASSIGN(Recorder);
+};
+
+class Producer : public DelegateSimpleThread::Delegate {
+ public:
+  Producer(PoolAdapter* pool, Recorder* recorder, int num_tasks)
+      : pool_(pool),
+        recorder_(recorder),
+        num_tasks_(num_tasks) {}
+
+  virtual void Run() {
+    for (int i = 0; i < num_tasks_; ++i) {
+      pool_->PostTask(Bind(&Recorder::RunTask, Unretained(recorder_),
+                           TimeTicks::Now()));
+    }
+  }
+
+ private:
+  PoolAdapter* pool_;
+  Recorder* recorder_;
+  int num_tasks_;
+
+  DISALLOW_COPY_AND_ASSIGN(Producer);
+};
+
+// Posts kTotalTasks tasks to |pool|, split among |num_producers| threads, and
+// logs the throughput and the queueing delay.
+void RunBenchmark(const char* pool_name, PoolAdapter* pool,
+                  int num_producers) {
+  int tasks_per_producer = kTotalTasks / num_producers;
+  Recorder recorder(tasks_per_producer * num_producers);
+  Producer producer(pool, &recorder, tasks_per_producer);
+  DelegateSimpleThreadPool producers("producer", num_producers);
+  producers.AddWork(&producer, num_producers);
+
+  PerfTimer timer;
+  producers.Start();
+  producers.JoinAll();
+  recorder.Wait();
+  TimeDelta elapsed = timer.Elapsed();
+
+  std::string name = StringPrintf("%s_%d_producers", pool_name, num_producers);
+  LogPerfResult((name + "_throughput").c_str(),
+                tasks_per_producer * num_producers / elapsed.InMillisecondsF(),
+                "tasks/ms");
+  LogPerfResult((name + "_mean_delay").c_str(),
+                recorder.MeanDelayMicroseconds(), "us");
+  LogPerfResult((name + "_max_delay").c_str(),
+                recorder.MaxDelayMicroseconds(), "us");
+}
+
+}  // namespace
+
+TEST(WorkerPoolPosixPerfTest, DynamicThreadPool) {
+  DynamicPoolAdapter pool;
+  for (int producers = 1; producers <= kMaxProducers; producers *= 2)
+    RunBenchmark("dynamic_pool", &pool, producers);
+  pool.Terminate();
+}
+
+TEST(WorkerPoolPosixPerfTest, WorkStealingThreadPool) {
+  StealingPoolAdapter pool;
+  for (int producers = 1; producers <= kMaxProducers; producers *= 2)
+    RunBenchmark("stealing_pool", &pool, producers);
+  pool.Terminate();
+}
+
+}  // namespace base
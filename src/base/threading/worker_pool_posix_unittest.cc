@@ -6,10 +6,12 @@
 
 #include <set>
 
+#include "base/bind.h"
 #include "base/synchronization/condition_variable.h"
 #include "base/synchronization/lock.h"
 #include "base/task.h"
 #include "base/threading/platform_thread.h"
+#include "base/threading/simple_thread.h"
 #include "base/synchronization/waitable_event.h"
 #include "testing/gtest/include/gtest/gtest.h"
 
@@ -42,6 +44,36 @@ class PosixDynamicThreadPool::PosixDynamicThreadPoolPeer {
   DISALLOW_COPY_AND_ASSIGN(PosixDynamicThreadPoolPeer);
 };
 
+// Peer class to provide passthrough access to PosixWorkStealingThreadPool
+// internals.
+class PosixWorkStealingThreadPool::PosixWorkStealingThreadPoolPeer {
+ public:
+  explicit PosixWorkStealingThreadPoolPeer(PosixWorkStealingThreadPool* pool)
+      : pool_(pool) {}
+
+  Lock* lock() { return &pool_->idle_lock_; }
+  int num_idle_threads() const {
+    return subtle::Acquire_Load(&pool_->num_idle_threads_);
+  }
+  int num_threads() const {
+    return subtle::Acquire_Load(&pool_->num_threads_);
+  }
+  int num_pending_tasks() const {
+    return subtle::Acquire_Load(&pool_->num_pending_tasks_);
+  }
+  ConditionVariable* num_idle_threads_cv() {
+    return pool_->num_idle_threads_cv_.get();
+  }
+  void set_num_idle_threads_cv(ConditionVariable* cv) {
+    pool_->num_idle_threads_cv_.reset(cv);
+  }
+
+ private:
+  PosixWorkStealingThreadPool* pool_;
+
+  DISALLOW_COPY_AND_ASSIGN(PosixWorkStealingThreadPoolPeer);
+};
+
 namespace {
 
 // IncrementingTask's main purpose is to increment a counter.  It also updates a
@@ -177,6 +209,109 @@ class PosixDynamicThreadPoolTest : public testing::Test {
   base::WaitableEvent start_;
 };
 
+class PosixWorkStealingThreadPoolTest : public testing::Test {
+ protected:
+  PosixWorkStealingThreadPoolTest()
+      : counter_(0),
+        num_waiting_to_start_(0),
+        num_waiting_to_start_cv_(&num_waiting_to_start_lock_),
+        counter_cv_(&counter_lock_),
+        start_(true, false) {}
+
+  virtual void TearDown() {
+    // Wake up the idle threads so they can terminate.
+    if (pool_.get()) pool_->Terminate();
+  }
+
+  void CreatePool(int num_shards) {
+    pool_ = new base::PosixWorkStealingThreadPool(
+        "stealing_pool", 60*60, num_shards);
+    peer_.reset(
+        new PosixWorkStealingThreadPool::PosixWorkStealingThreadPoolPeer(
+            pool_.get()));
+    peer_->set_num_idle_threads_cv(new ConditionVariable(peer_->lock()));
+  }
+
+  void WaitForTasksToStart(int num_tasks) {
+    base::AutoLock num_waiting_to_start_locked(num_waiting_to_start_lock_);
+    while (num_waiting_to_start_ < num_tasks) {
+      num_waiting_to_start_cv_.Wait();
+    }
+  }
+
+  void WaitForIdleThreads(int num_idle_threads) {
+    base::AutoLock pool_locked(*peer_->lock());
+    while (peer_->num_idle_threads() < num_idle_threads) {
+      peer_->num_idle_threads_cv()->Wait();
+    }
+  }
+
+  void WaitForCounter(int value) {
+    base::AutoLock counter_locked(counter_lock_);
+    while (counter_ < value) {
+      counter_cv_.Wait();
+    }
+  }
+
+  void CountingTask() {
+    {
+      base::AutoLock unique_threads_locked(unique_threads_lock_);
+      unique_threads_.insert(PlatformThread::CurrentId());
+    }
+    base::AutoLock counter_locked(counter_lock_);
+    counter_++;
+    counter_cv_.Broadcast();
+  }
+
+  base::Closure CreateCountingClosure() {
+    return base::Bind(&PosixWorkStealingThreadPoolTest::CountingTask,
+                      base::Unretained(this));
+  }
+
+  Task* CreateNewBlockingIncrementingTask() {
+    return new BlockingIncrementingTask(
+        &counter_lock_, &counter_, &unique_threads_lock_, &unique_threads_,
+        &num_waiting_to_start_lock_, &num_waiting_to_start_,
+        &num_waiting_to_start_cv_, &start_);
+  }
+
+  scoped_refptr<base::PosixWorkStealingThreadPool> pool_;
+  scoped_ptr<base::PosixWorkStealingThreadPool::PosixWorkStealingThreadPoolPeer>
+      peer_;
+  Lock counter_lock_;
+  int counter_;
+  Lock unique_threads_lock_;
+  std::set<PlatformThreadId> unique_threads_;
+  Lock num_waiting_to_start_lock_;
+  int num_waiting_to_start_;
+  ConditionVariable num_waiting_to_start_cv_;
+  ConditionVariable counter_cv_;
+  base::WaitableEvent start_;
+};
+
+// Posts |num_tasks| closures to |pool| from its own thread.
+class PostingDelegate : public DelegateSimpleThread::Delegate {
+ public:
+  PostingDelegate(PosixWorkStealingThreadPool* pool,
+                  const base::Closure& task,
+                  int num_tasks)
+      : pool_(pool),
+        task_(task),
+        num_tasks_(num_tasks) {}
+
+  virtual void Run() {
+    for (int i = 0; i < num_tasks_; ++i)
+      pool_->PostTask(FROM_HERE, task_, false);
+  }
+
+ private:
+  PosixWorkStealingThreadPool* pool_;
+  base::Closure task_;
+  int num_tasks_;
+
+  DISALLOW_COPY_AND_ASSIGN(PostingDelegate);
+};
+
 }  // namespace
 
 TEST_F(PosixDynamicThreadPoolTest, Basic) {
@@ -267,4 +402,106 @@ TEST_F(PosixDynamicThreadPoolTest, Complex) {
   EXPECT_EQ(4, counter_);
 }
 
+TEST_F(PosixWorkStealingThreadPoolTest, Basic) {
+  CreatePool(4);
+  EXPECT_EQ(0, peer_->num_threads());
+
+  // Add one task and wait for it to be completed.
+  pool_->PostTask(FROM_HERE, CreateCountingClosure(), false);
+
+  WaitForIdleThreads(1);
+
+  EXPECT_EQ(1U, unique_threads_.size()) <<
+      "There should be only one thread allocated for one task.";
+  EXPECT_EQ(1, peer_->num_threads());
+  EXPECT_EQ(1, peer_->num_idle_threads());
+  EXPECT_EQ(0, peer_->num_pending_tasks());
+  EXPECT_EQ(1, counter_);
+}
+
+TEST_F(PosixWorkStealingThreadPoolTest, ReuseIdle) {
+  CreatePool(4);
+  pool_->PostTask(FROM_HERE, CreateCountingClosure(), false);
+  WaitForIdleThreads(1);
+
+  // The idle worker picks up the next task instead of a new thread starting.
+  pool_->PostTask(FROM_HERE, CreateCountingClosure(), false);
+  WaitForCounter(2);
+  WaitForIdleThreads(1);
+
+  EXPECT_EQ(1U, unique_threads_.size());
+  EXPECT_EQ(1, peer_->num_threads());
+}
+
+TEST_F(PosixWorkStealingThreadPoolTest, SlowTasksGetTheirOwnThreads) {
+  // All four have to be running at the same time for this test to finish.
+  CreatePool(2);
+  for (int i = 0; i < 4; ++i)
+    pool_->PostTask(FROM_HERE, CreateNewBlockingIncrementingTask(), true);
+
+  WaitForTasksToStart(4);
+  start_.Signal();
+  WaitForIdleThreads(4);
+
+  EXPECT_EQ(4U, unique_threads_.size());
+  EXPECT_EQ(4, peer_->num_threads());
+  EXPECT_EQ(4, counter_);
+}
+
+TEST_F(PosixWorkStealingThreadPoolTest, BlockedFastTasksGetNewThreads) {
+  // Each fast task blocks until all of them are running, so the pool has to
+  // keep growing past the number of shards instead of queueing them.
+  const int kNumTasks = 20;
+  CreatePool(2);
+  for (int i = 0; i < kNumTasks; ++i)
+    pool_->PostTask(FROM_HERE, CreateNewBlockingIncrementingTask(), false);
+
+  WaitForTasksToStart(kNumTasks);
+  EXPECT_EQ(kNumTasks, peer_->num_threads());
+
+  start_.Signal();
+  WaitForIdleThreads(kNumTasks);
+
+  EXPECT_EQ(kNumTasks, counter_);
+  EXPECT_EQ(static_cast<size_t>(kNumTasks), unique_threads_.size());
+}
+
+TEST_F(PosixWorkStealingThreadPoolTest, FastTasksDoNotWaitForSlowTasks) {
+  CreatePool(2);
+  pool_->PostTask(FROM_HERE, CreateNewBlockingIncrementingTask(), true);
+  pool_->PostTask(FROM_HERE, CreateNewBlockingIncrementingTask(), true);
+  WaitForTasksToStart(2);
+
+  // Both slow tasks are still blocked, yet short tasks get to run. Each one
+  // is posted once the previous worker went idle, so a single thread is
+  // started for them.
+  for (int i = 0; i < 3; ++i) {
+    pool_->PostTask(FROM_HERE, CreateCountingClosure(), false);
+    WaitForCounter(i + 1);
+    WaitForIdleThreads(1);
+  }
+
+  start_.Signal();
+  WaitForIdleThreads(3);
+
+  EXPECT_EQ(5, counter_);
+  EXPECT_EQ(3, peer_->num_threads());
+}
+
+TEST_F(PosixWorkStealingThreadPoolTest, ManyProducers) {
+  const int kNumProducers = 8;
+  const int kTasksPerProducer = 100;
+  CreatePool(4);
+
+  PostingDelegate delegate(pool_.get(), CreateCountingClosure(),
+                           kTasksPerProducer);
+  DelegateSimpleThreadPool producers("producer", kNumProducers);
+  producers.AddWork(&delegate, kNumProducers);
+  producers.Start();
+  producers.JoinAll();
+
+  WaitForCounter(kNumProducers * kTasksPerProducer);
+  EXPECT_EQ(kNumProducers * kTasksPerProducer, counter_);
+}
+
 }  // namespace base
@@ -22,7 +22,7 @@ struct PendingTask {
         task(task) {
 #if defined(TRACK_ALL_TASK_OBJECTS)
     post_births = tracked_objects::ThreadData::TallyABirthIfActive(posted_from);
-    time_posted = tracked_objects::ThreadData::Now();
+    time_posted = tracked_objects::ThreadData::NowIfSampled(post_births);
 #endif  // defined(TRACK_ALL_TASK_OBJECTS)
   }
 
@@ -48,7 +48,8 @@ DWORD CALLBACK WorkItemCallback(void* param) {
                          "src_func", pending_task->posted_from.function_name());
 
 #if defined(TRACK_ALL_TASK_OBJECTS)
-  TimeTicks start_of_run = tracked_objects::ThreadData::Now();
+  TimeTicks start_of_run =
+      tracked_objects::ThreadData::NowIfSampled(pending_task->post_births);
 #endif  // defined(TRACK_ALL_TASK_OBJECTS)
   pending_task->task.Run();
 #if defined(TRACK_ALL_TASK_OBJECTS)
@@ -6,8 +6,12 @@
 
 #include <math.h>
 
+#include <algorithm>
+
+#include "base/bits.h"
 #include "base/format_macros.h"
 #include "base/message_loop.h"
+#include "base/string_number_conversions.h"
 #include "base/string_util.h"
 #include "base/stringprintf.h"
 #include "base/threading/thread_restrictions.h"
@@ -28,6 +32,74 @@ AutoTracking::State AutoTracking::state_ = AutoTracking::kNeverBeenRun;
 // static
 int ThreadData::thread_number_counter = 0;
 
+namespace {
+
+// The number of deaths a thread tallies before merging them into the data that
+// other threads can see.
+const int kMaxPendingDeaths = 64;
+
+// The longest time a thread that keeps running tasks waits before merging its
+// pending deaths.
+const int kMaxSecondsBetweenMerges = 1;
+
+// Appends " p<percentile>:<duration>ms" to |output|, with a tenth of a
+// millisecond resolution since most tasks take less than a millisecond.
+void WritePercentile(int percentile, const TimeDelta& duration,
+                     std::string* output) {
+  base::StringAppendF(output, " p%d:%.1fms", percentile,
+                      duration.InMillisecondsF());
+}
+
+}  // namespace
+
+//------------------------------------------------------------------------------
+// Duration distributions estimate percentiles from power of two buckets.
+
+DurationDistribution::DurationDistribution() {
+  Clear();
+}
+
+void DurationDistribution::Record(const TimeDelta& duration) {
+  int64 microseconds = duration.InMicroseconds();
+  int bucket = 0;
+  if (microseconds > 0) {
+    uint32 clamped =
+        static_cast<uint32>(std::min<int64>(microseconds, kuint32max));
+    bucket = std::min(1 + base::bits::Log2Floor(clamped), kBucketCount - 1);
+  }
+  ++counts_[bucket];
+}
+
+TimeDelta DurationDistribution::Percentile(int percentile) const {
+  DCHECK_GE(percentile, 0);
+  DCHECK_LE(percentile, 100);
+  int64 total = 0;
+  for (int i = 0; i < kBucketCount; ++i)
+    total += counts_[i];
+  if (!total)
+    return TimeDelta();
+
+  // The rank of the sample at the percentile, counting from 1.
+  int64 rank = std::max<int64>(1, (total * percentile + 99) / 100);
+  int64 seen = 0;
+  int bucket = 0;
+  for (; bucket < kBucketCount - 1; ++bucket) {
+    seen += counts_[bucket];
+    if (seen >= rank)
+      break;
+  }
+  return TimeDelta::FromMicroseconds(GG_INT64_C(1) << bucket);
+}
+
+void DurationDistribution::Add(const DurationDistribution& other) {
+  for (int i = 0; i < kBucketCount; ++i)
+    counts_[i] += other.counts_[i];
+}
+
+void DurationDistribution::Clear() {
+  memset(counts_, 0, sizeof(counts_));
+}
+
 //------------------------------------------------------------------------------
 // Death data tallies durations when a death takes place.
 
@@ -36,6 +108,8 @@ void DeathData::RecordDeath(const TimeDelta& queue_duration,
   ++count_;
   queue_duration_ += queue_duration;
   run_duration_ += run_duration;
+  queue_distribution_.Record(queue_duration);
+  run_distribution_.Record(run_duration);
 }
 
 int DeathData::AverageMsRunDuration() const {
@@ -50,6 +124,8 @@ void DeathData::AddDeathData(const DeathData& other) {
   count_ += other.count_;
   queue_duration_ += other.queue_duration_;
   run_duration_ += other.run_duration_;
+  queue_distribution_.Add(other.queue_distribution_);
+  run_distribution_.Add(other.run_distribution_);
 }
 
 void DeathData::Write(std::string* output) const {
@@ -57,18 +133,25 @@ void DeathData::Write(std::string* output) const {
     return;
   base::StringAppendF(output, "%s:%d, ",
                       (count_ == 1) ? "Life" : "Lives", count_);
-  base::StringAppendF(output, "Run:%"PRId64"ms(%dms/life) ",
+  base::StringAppendF(output, "Run:%"PRId64"ms(%dms/life",
                       run_duration_.InMilliseconds(),
                       AverageMsRunDuration());
-  base::StringAppendF(output, "Queue:%"PRId64"ms(%dms/life) ",
+  WritePercentile(50, RunDurationPercentile(50), output);
+  WritePercentile(99, RunDurationPercentile(99), output);
+  base::StringAppendF(output, ") Queue:%"PRId64"ms(%dms/life",
                       queue_duration_.InMilliseconds(),
                       AverageMsQueueDuration());
+  WritePercentile(50, QueueDurationPercentile(50), output);
+  WritePercentile(99, QueueDurationPercentile(99), output);
+  output->append(") ");
 }
 
 void DeathData::Clear() {
   count_ = 0;
   queue_duration_ = TimeDelta();
   run_duration_ = TimeDelta();
+  queue_distribution_.Clear();
+  run_distribution_.Clear();
 }
 
 //------------------------------------------------------------------------------
@@ -92,12 +175,25 @@ base::Lock ThreadData::list_lock_;
 // static
 ThreadData::Status ThreadData::status_ = ThreadData::UNINITIALIZED;
 
-ThreadData::ThreadData(const std::string& suggested_name) : next_(NULL) {
+// static
+int ThreadData::sampling_interval_ = 1;
+
+ThreadData::ThreadData(const std::string& suggested_name)
+    : next_(NULL),
+      pending_death_count_(0),
+      discard_pending_deaths_(false),
+      births_until_sample_(1),
+      random_state_(static_cast<uint32>(reinterpret_cast<uintptr_t>(this))) {
   DCHECK_GE(suggested_name.size(), 0u);
   thread_name_ = suggested_name;
 }
 
-ThreadData::ThreadData() : next_(NULL) {
+ThreadData::ThreadData()
+    : next_(NULL),
+      pending_death_count_(0),
+      discard_pending_deaths_(false),
+      births_until_sample_(1),
+      random_state_(static_cast<uint32>(reinterpret_cast<uintptr_t>(this))) {
   int thread_number;
   {
     base::AutoLock lock(list_lock_);
@@ -169,6 +265,11 @@ void ThreadData::WriteHTML(const std::string& query, std::string* output) {
   Comparator comparator;
   comparator.ParseQuery(query);
 
+  if (sampling_interval_ > 1) {
+    base::StringAppendF(output, "Sampling one in %d tasks.<br><br>",
+                        sampling_interval_);
+  }
+
   // Filter out acceptable (matching) instances.
   DataCollector::Collection match_array;
   for (DataCollector::Collection::iterator it = collection->begin();
@@ -192,6 +293,8 @@ void ThreadData::WriteHTML(const std::string& query, std::string* output) {
     "<li><b>TotalDuration</b> Summed durations in ms of Run() times."
     "<li><b>AverageQueueDuration</b> Average duration in ms of queueing time."
     "<li><b>TotalQueueDuration</b> Summed durations in ms of Run() times."
+    "<li><b>PercentileDuration</b> 99th percentile of Run() times."
+    "<li><b>PercentileQueueDuration</b> 99th percentile of queueing times."
     "<li><b>Birth</b> Thread on which the task was constructed."
     "<li><b>Death</b> Thread on which the task was run and deleted."
     "<li><b>File</b> File in which the task was contructed."
@@ -211,11 +314,20 @@ void ThreadData::WriteHTML(const std::string& query, std::string* output) {
     " thread, and then by death thread, and would aggregate data for each pair"
     " of lifetime events."
     "</ul>"
+    "Each thread publishes the deaths of its tasks in batches: at least every"
+    " second while it keeps running tasks, when its message loop goes idle,"
+    " and when it exits. Until then, its most recent tasks are counted as still"
+    " alive. Worker threads have no message loop, so an idle worker thread may"
+    " hold on to its last deaths until it exits.<br><br>"
     " The data can be reset to zero (discarding all births, deaths, etc.) using"
     " <b>about:tracking/reset</b>. The existing stats will be displayed, but"
     " the internal stats will be set to zero, and start accumulating afresh."
     " This option is very helpful if you only wish to consider tasks created"
     " after some point in time.<br><br>"
+    "To lower the cost of tracking, only one in N tasks can be tracked using"
+    " <b>about:tracking/sample=N</b>. The counts then only include the tracked"
+    " tasks. Use <b>about:tracking/sample=1</b> to track all of them again."
+    "<br><br>"
     "If you wish to monitor Renderer events, be sure to run in --single-process"
     " mode.";
   output->append(help_string);
@@ -279,15 +391,56 @@ Births* ThreadData::TallyABirth(const Location& location) {
 
 void ThreadData::TallyADeath(const Births& the_birth,
                              const TimeDelta& queue_duration,
-                             const TimeDelta& run_duration) {
-  DeathMap::iterator it = death_map_.find(&the_birth);
-  if (it != death_map_.end()) {
-    it->second.RecordDeath(queue_duration, run_duration);
-    return;
+                             const TimeDelta& run_duration,
+                             const base::TimeTicks& end_of_run) {
+  // No other thread reads pending_death_map_, so it needs no lock.
+  DeathMap::iterator it = pending_death_map_.find(&the_birth);
+  if (it == pending_death_map_.end())
+    it = pending_death_map_.insert(std::make_pair(&the_birth,
+                                                  DeathData())).first;
+  if (!it->second.count())
+    pending_deaths_.push_back(&*it);
+  it->second.RecordDeath(queue_duration, run_duration);
+
+  if (++pending_death_count_ >= kMaxPendingDeaths ||
+      end_of_run - last_merge_time_ >=
+          TimeDelta::FromSeconds(kMaxSecondsBetweenMerges))
+    MergePendingDeaths(end_of_run);
+}
+
+void ThreadData::MergePendingDeaths(const base::TimeTicks& now) {
+  {
+    base::AutoLock lock(lock_);  // Lock since the map may get relocated now.
+    // The data was reset from another thread since the last merge.
+    if (discard_pending_deaths_) {
+      discard_pending_deaths_ = false;
+    } else {
+      for (size_t i = 0; i < pending_deaths_.size(); ++i)
+        death_map_[pending_deaths_[i]->first].AddDeathData(
+            pending_deaths_[i]->second);
+    }
   }
+  for (size_t i = 0; i < pending_deaths_.size(); ++i)
+    pending_deaths_[i]->second.Clear();
+  pending_deaths_.clear();
+  pending_death_count_ = 0;
+  last_merge_time_ = now;
+}
 
-  base::AutoLock lock(lock_);  // Lock since the map may get relocated now.
-  death_map_[&the_birth].RecordDeath(queue_duration, run_duration);
+bool ThreadData::ShouldSampleBirth() {
+  int interval = sampling_interval_;
+  if (interval <= 1)
+    return true;
+  if (--births_until_sample_ > 0)
+    return false;
+  // Sample after a random number of births, between 1 and 2 * interval - 1, so
+  // that tasks posted in a repeating pattern are not always (or never)
+  // sampled.  A xorshift generator is plenty for this.
+  random_state_ ^= random_state_ << 13;
+  random_state_ ^= random_state_ >> 17;
+  random_state_ ^= random_state_ << 5;
+  births_until_sample_ = 1 + random_state_ % (2 * interval - 1);
+  return true;
 }
 
 // static
@@ -298,7 +451,7 @@ Births* ThreadData::TallyABirthIfActive(const Location& location) {
   if (!IsActive())
     return NULL;
   ThreadData* current_thread_data = Get();
-  if (!current_thread_data)
+  if (!current_thread_data || !current_thread_data->ShouldSampleBirth())
     return NULL;
   return current_thread_data->TallyABirth(location);
 #endif
@@ -326,12 +479,35 @@ void ThreadData::TallyADeathIfActive(const Births* the_birth,
   // have for non-delayed tasks, and we consistently call it queueing delay.
   base::TimeTicks effective_post_time =
       (delayed_start_time.is_null()) ? time_posted : delayed_start_time;
+  base::TimeTicks end_of_run = Now();
   base::TimeDelta queue_duration = start_of_run - effective_post_time;
-  base::TimeDelta run_duration = Now() - start_of_run;
-  current_thread_data->TallyADeath(*the_birth, queue_duration, run_duration);
+  base::TimeDelta run_duration = end_of_run - start_of_run;
+  current_thread_data->TallyADeath(*the_birth, queue_duration, run_duration,
+                                   end_of_run);
+#endif
+}
+
+// static
+void ThreadData::MergePendingDeathsIfActive() {
+#if !defined(TRACK_ALL_TASK_OBJECTS)
+  return;  // Not compiled in.
+#else
+  if (!IsActive())
+    return;
+  // Don't register a ThreadData for a thread that never tallied anything.
+  ThreadData* current_thread_data = static_cast<ThreadData*>(tls_index_.Get());
+  if (current_thread_data && current_thread_data->pending_death_count_)
+    current_thread_data->MergePendingDeaths(Now());
 #endif
 }
 
+// static
+void ThreadData::OnThreadTermination(void* thread_data) {
+  // The instance stays in the list, so its deaths must not be lost.
+  if (thread_data)
+    static_cast<ThreadData*>(thread_data)->MergePendingDeaths(Now());
+}
+
 // static
 ThreadData* ThreadData::first() {
   base::AutoLock lock(list_lock_);
@@ -348,10 +524,20 @@ void ThreadData::SnapshotBirthMap(BirthMap *output) const {
 
 // This may be called from another thread.
 void ThreadData::SnapshotDeathMap(DeathMap *output) const {
-  base::AutoLock lock(lock_);
-  for (DeathMap::const_iterator it = death_map_.begin();
-       it != death_map_.end(); ++it)
-    (*output)[it->first] = it->second;
+  {
+    base::AutoLock lock(lock_);
+    for (DeathMap::const_iterator it = death_map_.begin();
+         it != death_map_.end(); ++it)
+      (*output)[it->first] = it->second;
+  }
+
+  // Only this thread may read its own pending deaths.  Other threads see them
+  // once they are merged.
+  if (tls_index_.Get() != this || discard_pending_deaths_)
+    return;
+  for (size_t i = 0; i < pending_deaths_.size(); ++i)
+    (*output)[pending_deaths_[i]->first].AddDeathData(
+        pending_deaths_[i]->second);
 }
 
 // static
@@ -369,11 +555,27 @@ void ThreadData::Reset() {
   for (DeathMap::iterator it = death_map_.begin();
        it != death_map_.end(); ++it)
     it->second.Clear();
+  if (tls_index_.Get() == this) {
+    for (size_t i = 0; i < pending_deaths_.size(); ++i)
+      pending_deaths_[i]->second.Clear();
+    pending_deaths_.clear();
+    pending_death_count_ = 0;
+  } else {
+    // The pending deaths can only be cleared on their thread, so they are
+    // dropped by the next merge instead.
+    discard_pending_deaths_ = true;
+  }
   for (BirthMap::iterator it = birth_map_.begin();
        it != birth_map_.end(); ++it)
     it->second->Clear();
 }
 
+// static
+void ThreadData::SetSamplingInterval(int interval) {
+  DCHECK_GE(interval, 1);
+  sampling_interval_ = interval;
+}
+
 // static
 bool ThreadData::StartTracking(bool status) {
 #if !defined(TRACK_ALL_TASK_OBJECTS)
@@ -387,7 +589,7 @@ bool ThreadData::StartTracking(bool status) {
   }
   base::AutoLock lock(list_lock_);
   DCHECK_EQ(UNINITIALIZED, status_);
-  CHECK(tls_index_.Initialize(NULL));
+  CHECK(tls_index_.Initialize(&ThreadData::OnThreadTermination));
   status_ = ACTIVE;
   return true;
 #endif
@@ -407,6 +609,13 @@ base::TimeTicks ThreadData::Now() {
   return base::TimeTicks();  // Super fast when disabled, or not compiled in.
 }
 
+// static
+base::TimeTicks ThreadData::NowIfSampled(const Births* births) {
+  if (!births)
+    return base::TimeTicks();  // The death won't be tallied.
+  return Now();
+}
+
 // static
 void ThreadData::ShutdownSingleThreadedCleanup() {
   // We must be single threaded... but be careful anyway.
@@ -428,6 +637,8 @@ void ThreadData::ShutdownSingleThreadedCleanup() {
       delete it->second;  // Delete the Birth Records.
     next_thread_data->birth_map_.clear();
     next_thread_data->death_map_.clear();
+    next_thread_data->pending_death_map_.clear();
+    next_thread_data->pending_deaths_.clear();
     delete next_thread_data;  // Includes all Death Records.
   }
 
@@ -707,6 +918,24 @@ bool Comparator::operator()(const Snapshot& left,
         return left.queue_duration() > right.queue_duration();
       break;
 
+    case PERCENTILE_RUN_DURATION:
+      if (!left.count() || !right.count())
+        break;
+      if (left.death_data().RunDurationPercentile(99) !=
+          right.death_data().RunDurationPercentile(99))
+        return left.death_data().RunDurationPercentile(99) >
+            right.death_data().RunDurationPercentile(99);
+      break;
+
+    case PERCENTILE_QUEUE_DURATION:
+      if (!left.count() || !right.count())
+        break;
+      if (left.death_data().QueueDurationPercentile(99) !=
+          right.death_data().QueueDurationPercentile(99))
+        return left.death_data().QueueDurationPercentile(99) >
+            right.death_data().QueueDurationPercentile(99);
+      break;
+
     default:
       break;
   }
@@ -758,6 +987,8 @@ bool Comparator::Equivalent(const Snapshot& left,
     case TOTAL_RUN_DURATION:
     case AVERAGE_QUEUE_DURATION:
     case TOTAL_QUEUE_DURATION:
+    case PERCENTILE_RUN_DURATION:
+    case PERCENTILE_QUEUE_DURATION:
       // We don't produce separate aggretation when only counts or times differ.
       break;
 
@@ -854,6 +1085,8 @@ void Comparator::ParseKeyphrase(const std::string& key_phrase) {
     key_map["duration"]             = AVERAGE_RUN_DURATION;
     key_map["totalqueueduration"]   = TOTAL_QUEUE_DURATION;
     key_map["averagequeueduration"] = AVERAGE_QUEUE_DURATION;
+    key_map["percentileduration"]   = PERCENTILE_RUN_DURATION;
+    key_map["percentilequeueduration"] = PERCENTILE_QUEUE_DURATION;
     key_map["birth"]                = BIRTH_THREAD;
     key_map["death"]                = DEATH_THREAD;
     key_map["file"]                 = BIRTH_FILE;
@@ -862,6 +1095,7 @@ void Comparator::ParseKeyphrase(const std::string& key_phrase) {
 
     // Immediate commands that do not involve setting sort order.
     key_map["reset"]     = RESET_ALL_DATA;
+    key_map["sample"]    = SET_SAMPLING_INTERVAL;
   }
 
   std::string required;
@@ -876,10 +1110,15 @@ void Comparator::ParseKeyphrase(const std::string& key_phrase) {
   KeyMap::iterator it = key_map.find(keyword);
   if (key_map.end() == it)
     return;  // Unknown keyword.
-  if (it->second == RESET_ALL_DATA)
+  if (it->second == RESET_ALL_DATA) {
     ThreadData::ResetAllThreadData();
-  else
+  } else if (it->second == SET_SAMPLING_INTERVAL) {
+    int interval;
+    if (base::StringToInt(required, &interval) && interval >= 1)
+      ThreadData::SetSamplingInterval(interval);
+  } else {
     SetTiebreaker(key_map[keyword], required);
+  }
 }
 
 bool Comparator::ParseQuery(const std::string& query) {
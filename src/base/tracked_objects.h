@@ -84,7 +84,24 @@
 // the instance as it is destroyed (dies).  By maintaining a single place to
 // aggregate this running sum *only* for the given thread, we avoid the need to
 // lock such DeathData instances. (i.e., these accumulated stats in a DeathData
-// instance are exclusively updated by the singular owning thread).
+// instance are exclusively updated by the singular owning thread).  Besides the
+// sums, a DeathData keeps a coarse distribution of the run and queue durations,
+// so that percentiles can be displayed for each birth place.
+//
+// Deaths are first tallied in a map that only the owning thread ever reads, so
+// they are recorded without any lock.  Every kMaxPendingDeaths deaths, or
+// when a second has elapsed since the last merge, the pending tallies are
+// merged (under a lock) into the map that other threads snapshot.  They are
+// also merged when the thread's message loop goes idle, and when the thread
+// exits.  Deaths that have not been merged yet are only visible to snapshots
+// taken on the owning thread; elsewhere, their objects appear to still be
+// alive.
+//
+// To keep the overhead low enough to leave tracking enabled, only one birth in
+// (on average) every sampling interval is tracked.  The choice is made on the
+// birth thread with a randomized countdown, so it needs no lock.  Objects
+// whose birth was not sampled get no Births pointer, and their death is not
+// tallied either, so the displayed counts are those of the sampled objects.
 //
 // With the above lifecycle description complete, the major remaining detail is
 // explaining how each thread maintains a list of DeathData instances, and of
@@ -213,6 +230,35 @@ class BASE_EXPORT Births: public BirthOnThread {
   DISALLOW_COPY_AND_ASSIGN(Births);
 };
 
+//------------------------------------------------------------------------------
+// A coarse distribution of durations, used to estimate percentiles without
+// keeping every sample.  Bucket 0 counts durations under 1us, bucket i counts
+// durations in [2^(i-1), 2^i) us, and the last bucket also counts all the
+// longer durations.
+
+class BASE_EXPORT DurationDistribution {
+ public:
+  DurationDistribution();
+
+  void Record(const base::TimeDelta& duration);
+
+  // Returns an upper bound of the |percentile|th percentile (0 to 100) of the
+  // recorded durations, which is at most twice the actual value.  Returns
+  // zero if nothing was recorded.
+  base::TimeDelta Percentile(int percentile) const;
+
+  // Accumulate the counts from other into this.
+  void Add(const DurationDistribution& other);
+
+  void Clear();
+
+ private:
+  // The last bucket starts at 2^30us, about 18 minutes.
+  enum { kBucketCount = 32 };
+
+  int counts_[kBucketCount];
+};
+
 //------------------------------------------------------------------------------
 // Basic info summarizing multiple destructions of an object with a single
 // birthplace (fixed Location).  Used both on specific threads, and also used
@@ -239,9 +285,15 @@ class BASE_EXPORT DeathData {
   int AverageMsRunDuration() const;
   base::TimeDelta queue_duration() const { return queue_duration_; }
   int AverageMsQueueDuration() const;
+  base::TimeDelta RunDurationPercentile(int percentile) const {
+    return run_distribution_.Percentile(percentile);
+  }
+  base::TimeDelta QueueDurationPercentile(int percentile) const {
+    return queue_distribution_.Percentile(percentile);
+  }
 
-  // Accumulate metrics from other into this.  This method is never used on
-  // realtime statistics, and only used in snapshots and aggregatinos.
+  // Accumulate metrics from other into this.  This method is only used in
+  // snapshots and aggregatinos, and to merge a thread's pending deaths.
   void AddDeathData(const DeathData& other);
 
   // Simple print of internal state.
@@ -254,6 +306,8 @@ class BASE_EXPORT DeathData {
   int count_;                       // Number of destructions.
   base::TimeDelta run_duration_;    // Sum of all Run()time durations.
   base::TimeDelta queue_duration_;  // Sum of all queue time durations.
+  DurationDistribution run_distribution_;
+  DurationDistribution queue_distribution_;
 };
 
 //------------------------------------------------------------------------------
@@ -395,9 +449,12 @@ class BASE_EXPORT Comparator {
     TOTAL_RUN_DURATION = 128,
     AVERAGE_QUEUE_DURATION = 256,
     TOTAL_QUEUE_DURATION = 512,
+    PERCENTILE_RUN_DURATION = 1024,
+    PERCENTILE_QUEUE_DURATION = 2048,
 
     // Imediate action keywords.
     RESET_ALL_DATA = -1,
+    SET_SAMPLING_INTERVAL = -2,
   };
 
   explicit Comparator();
@@ -509,14 +566,19 @@ class BASE_EXPORT ThreadData {
   // In this thread's data, record a new birth.
   Births* TallyABirth(const Location& location);
 
-  // Find a place to record a death on this thread.
+  // Find a place to record a death on this thread.  The death is tallied in
+  // this thread's pending deaths, which are merged into the death map when
+  // enough of them accumulated, or when the last merge happened more than a
+  // second before |end_of_run|.
   void TallyADeath(const Births& the_birth,
                    const base::TimeDelta& queue_duration,
-                   const base::TimeDelta& duration);
+                   const base::TimeDelta& duration,
+                   const base::TimeTicks& end_of_run);
 
   // Helper methods to only tally if the current thread has tracking active.
   //
-  // TallyABirthIfActive will returns NULL if the birth cannot be tallied.
+  // TallyABirthIfActive will returns NULL if the birth cannot be tallied, or
+  // was not sampled.
   static Births* TallyABirthIfActive(const Location& location);
 
   // Record the end of a timed run of an object.  The |the_birth| is the record
@@ -531,6 +593,11 @@ class BASE_EXPORT ThreadData {
                                   const base::TimeTicks& delayed_start_time,
                                   const base::TimeTicks& start_of_run);
 
+  // Merges the deaths that the current thread has not merged yet, so that
+  // snapshots taken on other threads see them.  Called when the thread's
+  // message loop goes idle.
+  static void MergePendingDeathsIfActive();
+
   // (Thread safe) Get start of list of instances.
   static ThreadData* first();
   // Iterate through the null terminated list of instances.
@@ -540,7 +607,9 @@ class BASE_EXPORT ThreadData {
 
   // Using our lock, make a copy of the specified maps.  These calls may arrive
   // from non-local threads, and are used to quickly scan data from all threads
-  // in order to build an HTML page for about:tracking.
+  // in order to build an HTML page for about:tracking.  When called on the
+  // thread that owns this instance, SnapshotDeathMap() also includes the deaths
+  // that have not been merged yet.
   void SnapshotBirthMap(BirthMap *output) const;
   void SnapshotDeathMap(DeathMap *output) const;
 
@@ -551,8 +620,14 @@ class BASE_EXPORT ThreadData {
   static void ResetAllThreadData();
 
   // Using our lock to protect the iteration, Clear all birth and death data.
+  // Deaths that other threads have not merged yet are kept.
   void Reset();
 
+  // Track only one in (on average) |interval| births, and the corresponding
+  // deaths.  An interval of 1, the default, tracks every object.
+  static void SetSamplingInterval(int interval);
+  static int sampling_interval() { return sampling_interval_; }
+
   // Set internal status_ to either become ACTIVE, or later, to be SHUTDOWN,
   // based on argument being true or false respectively.
   // IF tracking is not compiled in, this function will return false.
@@ -565,6 +640,11 @@ class BASE_EXPORT ThreadData {
   // the code).
   static base::TimeTicks Now();
 
+  // Like Now(), but returns a null time when |births| is NULL, i.e., when the
+  // birth of the object was not tallied, and its death will not be either.
+  // This avoids getting the time for the objects that are not sampled.
+  static base::TimeTicks NowIfSampled(const Births* births);
+
   // WARNING: ONLY call this function when you are running single threaded
   // (again) and all message loops and threads have terminated.  Until that
   // point some threads may still attempt to write into our data structures.
@@ -585,6 +665,19 @@ class BASE_EXPORT ThreadData {
   // shutting down).
   static ThreadData* RegisterCurrentContext(ThreadData* unregistered);
 
+  // Returns true if the next birth on this thread should be tallied, according
+  // to the sampling interval.
+  bool ShouldSampleBirth();
+
+  // Moves the pending deaths into death_map_, or drops them if the data was
+  // reset from another thread since the last merge.  Must be called on the
+  // thread that owns this instance, or when that thread exits.
+  void MergePendingDeaths(const base::TimeTicks& now);
+
+  // Merges the pending deaths of a thread that exits.  This is the destructor
+  // of tls_index_.
+  static void OnThreadTermination(void* thread_data);
+
   // Current allowable states of the tracking system.  The states always
   // proceed towards SHUTDOWN, and never go backwards.
   enum Status {
@@ -604,6 +697,10 @@ class BASE_EXPORT ThreadData {
   // We set status_ to SHUTDOWN when we shut down the tracking service.
   static Status status_;
 
+  // One in (on average) sampling_interval_ births is tallied.  This is read
+  // without a lock: a thread may use a stale value for one more sample.
+  static int sampling_interval_;
+
   // Link to next instance (null terminated list). Used to globally track all
   // registered instances (corresponds to all registered threads where we keep
   // data).
@@ -625,6 +722,31 @@ class BASE_EXPORT ThreadData {
   // locking before reading it.
   DeathMap death_map_;
 
+  // The deaths that have not been merged into death_map_ yet.  This map is
+  // only accessed on the thread that owns this instance, without a lock.  Its
+  // entries are cleared rather than erased by a merge, so that they are not
+  // allocated again.
+  DeathMap pending_death_map_;
+
+  // The entries of pending_death_map_ that have a non-zero count, which are
+  // the only ones that need to be merged.
+  std::vector<DeathMap::value_type*> pending_deaths_;
+
+  // The number of deaths in pending_death_map_.
+  int pending_death_count_;
+
+  // Set under lock_ when another thread resets the data, since only this thread
+  // can clear the pending deaths.
+  bool discard_pending_deaths_;
+
+  // The time of the last merge of the pending deaths.
+  base::TimeTicks last_merge_time_;
+
+  // The number of births left until the next one that is sampled, and the
+  // state of the random number generator used to pick that number.
+  int births_until_sample_;
+  uint32 random_state_;
+
   // Lock to protect *some* access to BirthMap and DeathMap.  The maps are
   // regularly read and written on this thread, but may only be read from other
   // threads.  To support this, we acquire this lock if we are writing from this
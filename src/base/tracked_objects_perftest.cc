@@ -0,0 +1,81 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/tracked_objects.h"
+
+#include "base/perftimer.h"
+#include "base/stringprintf.h"
+#include "base/threading/simple_thread.h"
+#include "base/time.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace tracked_objects {
+
+namespace {
+
+const int kTotalTasks = 2 * 1000 * 1000;
+const int kMaxThreads = 16;
+
+// Tallies the births and deaths of tasks posted from a few locations, like a
+// MessageLoop running them does.
+class TaskTallier : public base::DelegateSimpleThread::Delegate {
+ public:
+  explicit TaskTallier(int num_tasks) : num_tasks_(num_tasks) {}
+
+  virtual void Run() {
+    const Location locations[] = {
+      FROM_HERE, FROM_HERE, FROM_HERE, FROM_HERE,
+      FROM_HERE, FROM_HERE, FROM_HERE, FROM_HERE,
+    };
+    for (int i = 0; i < num_tasks_; ++i) {
+      Births* births = ThreadData::TallyABirthIfActive(
+          locations[i % arraysize(locations)]);
+      base::TimeTicks time_posted = ThreadData::NowIfSampled(births);
+      base::TimeTicks start_of_run = ThreadData::NowIfSampled(births);
+      ThreadData::TallyADeathIfActive(births, time_posted, base::TimeTicks(),
+                                      start_of_run);
+    }
+  }
+
+ private:
+  int num_tasks_;
+
+  DISALLOW_COPY_AND_ASSIGN(TaskTallier);
+};
+
+// Tallies kTotalTasks tasks, split among |num_threads| threads, and logs the
+// time spent per task.
+void RunBenchmark(int sampling_interval, int num_threads) {
+  if (!ThreadData::StartTracking(true))
+    return;
+  ThreadData::SetSamplingInterval(sampling_interval);
+
+  int tasks_per_thread = kTotalTasks / num_threads;
+  TaskTallier tallier(tasks_per_thread);
+  base::DelegateSimpleThreadPool threads("tallier", num_threads);
+  threads.AddWork(&tallier, num_threads);
+
+  PerfTimer timer;
+  threads.Start();
+  threads.JoinAll();
+  LogPerfResult(base::StringPrintf("TrackedObjects_sample_%d_%d_threads",
+                                   sampling_interval, num_threads).c_str(),
+                timer.Elapsed().InMicroseconds() * 1000.0 / kTotalTasks,
+                "ns/task");
+
+  ThreadData::SetSamplingInterval(1);
+  ThreadData::ShutdownSingleThreadedCleanup();
+}
+
+}  // namespace
+
+TEST(TrackedObjectsPerfTest, TallyBirthAndDeath) {
+  for (int threads = 1; threads <= kMaxThreads; threads *= 4) {
+    RunBenchmark(1, threads);
+    RunBenchmark(10, threads);
+    RunBenchmark(100, threads);
+  }
+}
+
+}  // namespace tracked_objects
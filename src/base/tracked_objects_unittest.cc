@@ -7,6 +7,8 @@
 #include "base/tracked_objects.h"
 
 #include "base/message_loop.h"
+#include "base/synchronization/waitable_event.h"
+#include "base/threading/simple_thread.h"
 #include "base/time.h"
 #include "testing/gtest/include/gtest/gtest.h"
 
@@ -97,4 +99,232 @@ TEST_F(TrackedObjectsTest, TinyStartupShutdown) {
   ThreadData::ShutdownSingleThreadedCleanup();
 }
 
+
+TEST_F(TrackedObjectsTest, DeathDataPercentiles) {
+  DeathData data;
+  EXPECT_EQ(base::TimeDelta(), data.RunDurationPercentile(50));
+
+  for (int i = 1; i <= 100; ++i) {
+    data.RecordDeath(base::TimeDelta::FromMicroseconds(10),
+                     base::TimeDelta::FromMilliseconds(i));
+  }
+  EXPECT_EQ(100, data.count());
+
+  // The percentiles are upper bounds, at most twice the actual values.
+  base::TimeDelta median = data.RunDurationPercentile(50);
+  EXPECT_LE(base::TimeDelta::FromMilliseconds(50), median);
+  EXPECT_GT(base::TimeDelta::FromMilliseconds(100), median);
+  base::TimeDelta p99 = data.RunDurationPercentile(99);
+  EXPECT_LE(base::TimeDelta::FromMilliseconds(99), p99);
+  EXPECT_GT(base::TimeDelta::FromMilliseconds(198), p99);
+  EXPECT_LE(p99, data.RunDurationPercentile(100));
+  EXPECT_EQ(base::TimeDelta::FromMicroseconds(16),
+            data.QueueDurationPercentile(99));
+
+  // Aggregations keep the distributions.
+  DeathData other;
+  for (int i = 0; i < 1000; ++i) {
+    other.RecordDeath(base::TimeDelta::FromMilliseconds(1),
+                      base::TimeDelta());
+  }
+  other.AddDeathData(data);
+  EXPECT_EQ(1100, other.count());
+  EXPECT_EQ(base::TimeDelta::FromMicroseconds(1),
+            other.RunDurationPercentile(50));
+  EXPECT_EQ(p99, other.RunDurationPercentile(100));
+  EXPECT_EQ(base::TimeDelta::FromMicroseconds(1024),
+            other.QueueDurationPercentile(50));
+
+  other.Clear();
+  EXPECT_EQ(base::TimeDelta(), other.RunDurationPercentile(99));
+}
+
+TEST_F(TrackedObjectsTest, SamplingInterval) {
+  if (!ThreadData::StartTracking(true))
+    return;
+
+  const int kBirths = 10000;
+  ThreadData::SetSamplingInterval(10);
+  const Location& location = FROM_HERE;
+  int sampled = 0;
+  for (int i = 0; i < kBirths; ++i) {
+    const Births* births = ThreadData::TallyABirthIfActive(location);
+    if (!births) {
+      EXPECT_TRUE(ThreadData::NowIfSampled(births).is_null());
+      ThreadData::TallyADeathIfActive(births, base::TimeTicks(),
+                                      base::TimeTicks(), base::TimeTicks());
+      continue;
+    }
+    ++sampled;
+    base::TimeTicks start_of_run = ThreadData::NowIfSampled(births);
+    EXPECT_FALSE(start_of_run.is_null());
+    ThreadData::TallyADeathIfActive(births, start_of_run, base::TimeTicks(),
+                                    start_of_run);
+  }
+  ThreadData::SetSamplingInterval(1);
+
+  // About one birth in ten was sampled, and only those births and their deaths
+  // were tallied.
+  EXPECT_LT(kBirths / 20, sampled);
+  EXPECT_GT(kBirths / 5, sampled);
+  ThreadData::BirthMap birth_map;
+  ThreadData::Get()->SnapshotBirthMap(&birth_map);
+  ASSERT_EQ(1u, birth_map.size());
+  EXPECT_EQ(sampled, birth_map.begin()->second->birth_count());
+  ThreadData::DeathMap death_map;
+  ThreadData::Get()->SnapshotDeathMap(&death_map);
+  ASSERT_EQ(1u, death_map.size());
+  EXPECT_EQ(sampled, death_map.begin()->second.count());
+
+  // Every birth is tallied again.
+  EXPECT_TRUE(ThreadData::TallyABirthIfActive(location));
+  EXPECT_TRUE(ThreadData::TallyABirthIfActive(location));
+
+  ThreadData::ShutdownSingleThreadedCleanup();
+}
+
+namespace {
+
+// Tallies the birth and death of |count| objects on its own thread.
+void TallyDeaths(int count) {
+  for (int i = 0; i < count; ++i) {
+    const Births* births = ThreadData::TallyABirthIfActive(FROM_HERE);
+    base::TimeTicks now = ThreadData::Now();
+    ThreadData::TallyADeathIfActive(births, now, base::TimeTicks(), now);
+  }
+}
+
+// Tallies deaths on its own thread.  If |idle| is given, the thread then
+// merges its deaths like an idle message loop does, signals |idle|, and waits
+// for |exit| before exiting.
+class TallyingDelegate : public base::DelegateSimpleThread::Delegate {
+ public:
+  explicit TallyingDelegate(int count)
+      : count_(count),
+        thread_data_(NULL),
+        idle_(NULL),
+        exit_(NULL) {}
+
+  TallyingDelegate(int count, base::WaitableEvent* idle,
+                   base::WaitableEvent* exit)
+      : count_(count),
+        thread_data_(NULL),
+        idle_(idle),
+        exit_(exit) {}
+
+  const ThreadData* thread_data() const { return thread_data_; }
+
+  virtual void Run() {
+    TallyDeaths(count_);
+    thread_data_ = ThreadData::Get();
+    if (idle_) {
+      ThreadData::MergePendingDeathsIfActive();
+      idle_->Signal();
+      exit_->Wait();
+    }
+  }
+
+ private:
+  int count_;
+  const ThreadData* thread_data_;
+  base::WaitableEvent* idle_;
+  base::WaitableEvent* exit_;
+};
+
+}  // namespace
+
+TEST_F(TrackedObjectsTest, DeathsMergedFromOtherThread) {
+  if (!ThreadData::StartTracking(true))
+    return;
+
+  // The deaths are merged at least every 64 deaths, and the rest are merged
+  // when the thread exits.
+  const int kDeaths = 100;
+  TallyingDelegate delegate(kDeaths);
+  base::DelegateSimpleThread thread(&delegate, "tallying");
+  thread.Start();
+  thread.Join();
+  ASSERT_TRUE(delegate.thread_data());
+
+  ThreadData::DeathMap death_map;
+  delegate.thread_data()->SnapshotDeathMap(&death_map);
+  ASSERT_EQ(1u, death_map.size());
+  EXPECT_EQ(kDeaths, death_map.begin()->second.count());
+
+  ThreadData::ShutdownSingleThreadedCleanup();
+}
+
+TEST_F(TrackedObjectsTest, DeathsMergedWhenIdle) {
+  if (!ThreadData::StartTracking(true))
+    return;
+
+  const int kDeaths = 10;
+  base::WaitableEvent idle(false, false);
+  base::WaitableEvent exit(false, false);
+  TallyingDelegate delegate(kDeaths, &idle, &exit);
+  base::DelegateSimpleThread thread(&delegate, "tallying");
+  thread.Start();
+  idle.Wait();
+
+  // The thread is still running, but all of its deaths are visible.
+  ThreadData::DeathMap death_map;
+  delegate.thread_data()->SnapshotDeathMap(&death_map);
+  ASSERT_EQ(1u, death_map.size());
+  EXPECT_EQ(kDeaths, death_map.begin()->second.count());
+
+  exit.Signal();
+  thread.Join();
+  ThreadData::ShutdownSingleThreadedCleanup();
+}
+
+namespace {
+
+// Resets the data of all threads from its own thread.
+class ResettingDelegate : public base::DelegateSimpleThread::Delegate {
+ public:
+  virtual void Run() {
+    ThreadData::ResetAllThreadData();
+  }
+};
+
+}  // namespace
+
+TEST_F(TrackedObjectsTest, ResetFromOtherThread) {
+  if (!ThreadData::StartTracking(true))
+    return;
+
+  // The first death is merged right away, the others stay pending.
+  TallyDeaths(10);
+  ThreadData::DeathMap death_map;
+  ThreadData::Get()->SnapshotDeathMap(&death_map);
+  ASSERT_EQ(1u, death_map.size());
+  EXPECT_EQ(10, death_map.begin()->second.count());
+
+  ResettingDelegate delegate;
+  base::DelegateSimpleThread thread(&delegate, "resetting");
+  thread.Start();
+  thread.Join();
+
+  // The pending deaths are not merged back into the data.
+  death_map.clear();
+  ThreadData::Get()->SnapshotDeathMap(&death_map);
+  ASSERT_EQ(1u, death_map.size());
+  EXPECT_EQ(0, death_map.begin()->second.count());
+  ThreadData::MergePendingDeathsIfActive();
+  death_map.clear();
+  ThreadData::Get()->SnapshotDeathMap(&death_map);
+  ASSERT_EQ(1u, death_map.size());
+  EXPECT_EQ(0, death_map.begin()->second.count());
+
+  // The deaths that follow the merge are tallied again.
+  TallyDeaths(1);
+  ThreadData::MergePendingDeathsIfActive();
+  death_map.clear();
+  ThreadData::Get()->SnapshotDeathMap(&death_map);
+  ASSERT_EQ(1u, death_map.size());
+  EXPECT_EQ(1, death_map.begin()->second.count());
+
+  ThreadData::ShutdownSingleThreadedCleanup();
+}
+
 }  // namespace tracked_objects
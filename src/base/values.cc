@@ -13,6 +13,18 @@
 
 namespace {
 
+// Orders the entries of a DictionaryValue by key.
+struct EntryKeyLess {
+  bool operator()(const base::ValueMap::value_type& lhs,
+                  const base::ValueMap::value_type& rhs) const {
+    return lhs.first < rhs.first;
+  }
+  bool operator()(const base::ValueMap::value_type& lhs,
+                  const std::string& rhs) const {
+    return lhs.first < rhs;
+  }
+};
+
 // Make a deep copy of |node|, but don't include empty lists or dictionaries
 // in the copy. It's possible for this function to return NULL and it
 // expects |node| to always be non-NULL.
@@ -347,7 +359,7 @@ DictionaryValue::~DictionaryValue() {
 
 bool DictionaryValue::HasKey(const std::string& key) const {
   DCHECK(IsStringUTF8(key));
-  ValueMap::const_iterator current_entry = dictionary_.find(key);
+  ValueMap::const_iterator current_entry = Find(key);
   DCHECK((current_entry == dictionary_.end()) || current_entry->second);
   return current_entry != dictionary_.end();
 }
@@ -410,14 +422,23 @@ void DictionaryValue::SetString(const std::string& path,
 
 void DictionaryValue::SetWithoutPathExpansion(const std::string& key,
                                               Value* in_value) {
-  // If there's an existing value here, we need to delete it, because
-  // we own all our children.
-  if (HasKey(key)) {
-    DCHECK(dictionary_[key] != in_value);  // This would be bogus
-    delete dictionary_[key];
+  DCHECK(IsStringUTF8(key));
+  // Keys often come in order, e.g. when copying a dictionary.
+  if (dictionary_.empty() || dictionary_.back().first < key) {
+    dictionary_.push_back(std::make_pair(key, in_value));
+    return;
   }
 
-  dictionary_[key] = in_value;
+  ValueMap::iterator entry = LowerBound(key);
+  if (entry != dictionary_.end() && entry->first == key) {
+    // If there's an existing value here, we need to delete it, because
+    // we own all our children.
+    DCHECK(entry->second != in_value);  // This would be bogus
+    delete entry->second;
+    entry->second = in_value;
+    return;
+  }
+  dictionary_.insert(entry, std::make_pair(key, in_value));
 }
 
 bool DictionaryValue::Get(const std::string& path, Value** out_value) const {
@@ -541,7 +562,7 @@ bool DictionaryValue::GetList(const std::string& path,
 bool DictionaryValue::GetWithoutPathExpansion(const std::string& key,
                                               Value** out_value) const {
   DCHECK(IsStringUTF8(key));
-  ValueMap::const_iterator entry_iterator = dictionary_.find(key);
+  ValueMap::const_iterator entry_iterator = Find(key);
   if (entry_iterator == dictionary_.end())
     return false;
 
@@ -635,7 +656,7 @@ bool DictionaryValue::Remove(const std::string& path, Value** out_value) {
 bool DictionaryValue::RemoveWithoutPathExpansion(const std::string& key,
                                                  Value** out_value) {
   DCHECK(IsStringUTF8(key));
-  ValueMap::iterator entry_iterator = dictionary_.find(key);
+  ValueMap::iterator entry_iterator = Find(key);
   if (entry_iterator == dictionary_.end())
     return false;
 
@@ -676,10 +697,12 @@ void DictionaryValue::MergeDictionary(const DictionaryValue* dictionary) {
 DictionaryValue* DictionaryValue::DeepCopy() const {
   DictionaryValue* result = new DictionaryValue;
 
+  // The entries are already sorted.
+  result->dictionary_.reserve(dictionary_.size());
   for (ValueMap::const_iterator current_entry(dictionary_.begin());
        current_entry != dictionary_.end(); ++current_entry) {
-    result->SetWithoutPathExpansion(current_entry->first,
-                                    current_entry->second->DeepCopy());
+    result->dictionary_.push_back(std::make_pair(
+        current_entry->first, current_entry->second->DeepCopy()));
   }
 
   return result;
@@ -691,26 +714,78 @@ bool DictionaryValue::Equals(const Value* other) const {
 
   const DictionaryValue* other_dict =
       static_cast<const DictionaryValue*>(other);
-  key_iterator lhs_it(begin_keys());
-  key_iterator rhs_it(other_dict->begin_keys());
-  while (lhs_it != end_keys() && rhs_it != other_dict->end_keys()) {
-    Value* lhs;
-    Value* rhs;
-    if (*lhs_it != *rhs_it ||
-        !GetWithoutPathExpansion(*lhs_it, &lhs) ||
-        !other_dict->GetWithoutPathExpansion(*rhs_it, &rhs) ||
-        !lhs->Equals(rhs)) {
+  if (dictionary_.size() != other_dict->dictionary_.size())
+    return false;
+
+  for (ValueMap::const_iterator lhs_it(dictionary_.begin()),
+           rhs_it(other_dict->dictionary_.begin());
+       lhs_it != dictionary_.end(); ++lhs_it, ++rhs_it) {
+    if (lhs_it->first != rhs_it->first ||
+        !lhs_it->second->Equals(rhs_it->second))
       return false;
-    }
-    ++lhs_it;
-    ++rhs_it;
   }
-  if (lhs_it != end_keys() || rhs_it != other_dict->end_keys())
-    return false;
 
   return true;
 }
 
+ValueMap::iterator DictionaryValue::LowerBound(const std::string& key) {
+  return std::lower_bound(dictionary_.begin(), dictionary_.end(), key,
+                          EntryKeyLess());
+}
+
+ValueMap::const_iterator DictionaryValue::LowerBound(
+    const std::string& key) const {
+  return std::lower_bound(dictionary_.begin(), dictionary_.end(), key,
+                          EntryKeyLess());
+}
+
+ValueMap::iterator DictionaryValue::Find(const std::string& key) {
+  ValueMap::iterator entry = LowerBound(key);
+  if (entry != dictionary_.end() && entry->first != key)
+    return dictionary_.end();
+  return entry;
+}
+
+ValueMap::const_iterator DictionaryValue::Find(const std::string& key) const {
+  ValueMap::const_iterator entry = LowerBound(key);
+  if (entry != dictionary_.end() && entry->first != key)
+    return dictionary_.end();
+  return entry;
+}
+
+void DictionaryValue::AppendUnsorted(std::string* key, Value* in_value) {
+  dictionary_.push_back(std::make_pair(std::string(), in_value));
+  dictionary_.back().first.swap(*key);
+}
+
+void DictionaryValue::SortEntries() {
+  // JSONWriter writes the keys in order, so most documents need no sorting.
+  bool sorted = true;
+  for (size_t i = 1; sorted && i < dictionary_.size(); ++i)
+    sorted = dictionary_[i - 1].first < dictionary_[i].first;
+  if (sorted)
+    return;
+
+  std::stable_sort(dictionary_.begin(), dictionary_.end(), EntryKeyLess());
+
+  // Keep the last value appended for each key.
+  ValueMap::iterator last_kept = dictionary_.begin();
+  for (ValueMap::iterator entry = dictionary_.begin() + 1;
+       entry != dictionary_.end(); ++entry) {
+    if (entry->first == last_kept->first) {
+      delete last_kept->second;
+      last_kept->second = entry->second;
+    } else {
+      ++last_kept;
+      if (last_kept != entry) {
+        last_kept->first.swap(entry->first);
+        last_kept->second = entry->second;
+      }
+    }
+  }
+  dictionary_.erase(last_kept + 1, dictionary_.end());
+}
+
 ///////////////////// ListValue ////////////////////
 
 ListValue::ListValue() : Value(TYPE_LIST) {
@@ -312,6 +312,31 @@ TEST(ValuesTest, DictionaryRemoval) {
   }
 }
 
+TEST(ValuesTest, DictionaryKeyOrder) {
+  DictionaryValue dict;
+  dict.SetInteger("b", 1);
+  dict.SetInteger("d", 2);
+  dict.SetInteger("a", 3);
+  dict.SetInteger("c", 4);
+  dict.SetInteger("b", 5);
+  EXPECT_EQ(4U, dict.size());
+
+  std::string keys;
+  for (DictionaryValue::key_iterator it = dict.begin_keys();
+       it != dict.end_keys(); ++it)
+    keys += *it;
+  EXPECT_EQ("abcd", keys);
+
+  int value = 0;
+  EXPECT_TRUE(dict.GetInteger("b", &value));
+  EXPECT_EQ(5, value);
+  EXPECT_TRUE(dict.Remove("c", NULL));
+  EXPECT_FALSE(dict.HasKey("c"));
+  EXPECT_TRUE(dict.GetInteger("d", &value));
+  EXPECT_EQ(2, value);
+  EXPECT_EQ(3U, dict.size());
+}
+
 TEST(ValuesTest, DictionaryWithoutPathExpansion) {
   DictionaryValue dict;
   dict.Set("this.is.expanded", Value::CreateNullValue());
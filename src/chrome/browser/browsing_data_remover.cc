@@ -52,6 +52,7 @@
 #include "net/base/transport_security_state.h"
 #include "net/disk_cache/disk_cache.h"
 #include "net/http/http_cache.h"
+#include "net/http/http_network_session.h"
 #include "net/url_request/url_request_context.h"
 #include "net/url_request/url_request_context_getter.h"
 #include "webkit/quota/quota_manager.h"
@@ -433,6 +434,13 @@ void BrowsingDataRemover::DoClearCache(int rv) {
         net::HttpTransactionFactory* factory =
             getter->GetURLRequestContext()->http_transaction_factory();
 
+#if defined(USE_OPENSSL)
+        // The TLS sessions are cached data too.
+        net::HttpNetworkSession* session = factory->GetSession();
+        if (session)
+          session->ssl_session_cache()->Clear();
+#endif
+
         rv = factory->GetCache()->GetBackend(&cache_, &cache_callback_);
         next_cache_state_ = (next_cache_state_ == STATE_CREATE_MAIN) ?
                                 STATE_DELETE_MAIN : STATE_DELETE_MEDIA;
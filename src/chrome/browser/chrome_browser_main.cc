@@ -288,6 +288,13 @@ void InitializeNetworkOptions(const CommandLine& parsed_command_line) {
     net::SpdySessionPool::set_max_sessions_per_domain(value);
   }
 
+  // Connect the sockets that the servers are expected to need ahead of time,
+  // like the other preconnections.
+  if (parsed_command_line.HasSwitch(switches::kEnableSocketWarmUp) &&
+      !parsed_command_line.HasSwitch(switches::kDisablePreconnect)) {
+    net::HttpStreamFactory::set_warm_up_sockets(true);
+  }
+
   SetDnsCertProvenanceCheckerFactory(CreateChromeDnsCertProvenanceChecker);
 
   if (parsed_command_line.HasSwitch(switches::kEnableWebSocketOverSpdy)) {
@@ -179,6 +179,15 @@ net::HostResolver* CreateGlobalHostResolver(net::NetLog* net_log) {
     }
   }
 
+  // The name servers of the system are only queried directly when asked for:
+  // unlike getaddrinfo(), the async resolver doesn't use nsswitch, mDNS or
+  // WINS, and it can't resolve anything until it has read the system config.
+  if (!global_host_resolver &&
+      command_line.HasSwitch(switches::kEnableAsyncDns)) {
+    global_host_resolver =
+      net::CreateSystemAsyncHostResolver(parallelism, net_log);
+  }
+
   if (!global_host_resolver) {
     global_host_resolver =
       net::CreateSystemHostResolver(parallelism, retry_attempts, net_log);
@@ -10,11 +10,21 @@
 #include "base/logging.h"
 #include "base/string_number_conversions.h"
 #include "base/string_util.h"
+#include "base/threading/thread_restrictions.h"
 #include "base/values.h"
 #include "chrome/browser/net/load_timing_observer.h"
 #include "chrome/browser/net/net_log_logger.h"
 #include "chrome/browser/net/passive_log_collector.h"
 #include "chrome/common/chrome_switches.h"
+#include "net/base/net_log_flight_recorder.h"
+
+namespace {
+
+// The number of events kept by the flight recorder, about the last 300
+// requests.
+const size_t kFlightRecorderCapacity = 10000;
+
+}  // namespace
 
 ChromeNetLog::ThreadSafeObserverImpl::ThreadSafeObserverImpl(LogLevel log_level)
     : net_log_(NULL),
@@ -127,6 +137,14 @@ ChromeNetLog::ChromeNetLog()
         command_line->GetSwitchValuePath(switches::kLogNetLog)));
     net_log_logger_->AddAsObserver(this);
   }
+
+  if (command_line->HasSwitch(switches::kNetLogFlightRecorder)) {
+    flight_recorder_path_ =
+        command_line->GetSwitchValuePath(switches::kNetLogFlightRecorder);
+    flight_recorder_.reset(new net::NetLogFlightRecorder(
+        kFlightRecorderCapacity, LOG_ALL_BUT_BYTES));
+    AddThreadSafeObserver(flight_recorder_.get());
+  }
 }
 
 ChromeNetLog::~ChromeNetLog() {
@@ -135,6 +153,17 @@ ChromeNetLog::~ChromeNetLog() {
   if (net_log_logger_.get()) {
     net_log_logger_->RemoveAsObserver();
   }
+  if (flight_recorder_.get()) {
+    RemoveThreadSafeObserver(flight_recorder_.get());
+    DumpFlightRecorder();
+  }
+}
+
+bool ChromeNetLog::DumpFlightRecorder() {
+  if (!flight_recorder_.get() || flight_recorder_path_.empty())
+    return false;
+  base::ThreadRestrictions::ScopedAllowIO allow_io;
+  return flight_recorder_->DumpToFile(flight_recorder_path_);
 }
 
 void ChromeNetLog::AddEntry(EventType type,
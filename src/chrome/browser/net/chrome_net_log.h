@@ -9,6 +9,7 @@
 #include <vector>
 
 #include "base/atomicops.h"
+#include "base/file_path.h"
 #include "base/memory/scoped_ptr.h"
 #include "base/observer_list.h"
 #include "base/synchronization/lock.h"
@@ -19,6 +20,10 @@ class LoadTimingObserver;
 class NetLogLogger;
 class PassiveLogCollector;
 
+namespace net {
+class NetLogFlightRecorder;
+}
+
 // ChromeNetLog is an implementation of NetLog that dispatches network log
 // messages to a list of observers.
 //
@@ -143,6 +148,11 @@ class ChromeNetLog : public net::NetLog {
     return load_timing_observer_.get();
   }
 
+  // Writes the events kept by the flight recorder to the file given by
+  // --net-log-flight-recorder. Returns false if the recorder isn't enabled or
+  // the file can't be written. This is also done on destruction.
+  bool DumpFlightRecorder();
+
  private:
   void AddObserverWhileLockHeld(ThreadSafeObserver* observer);
 
@@ -182,6 +192,10 @@ class ChromeNetLog : public net::NetLog {
   scoped_ptr<LoadTimingObserver> load_timing_observer_;
   scoped_ptr<NetLogLogger> net_log_logger_;
 
+  // Only set when --net-log-flight-recorder is given.
+  scoped_ptr<net::NetLogFlightRecorder> flight_recorder_;
+  FilePath flight_recorder_path_;
+
   // |lock_| must be acquired whenever reading or writing to this.
   ObserverList<ThreadSafeObserver, true> observers_;
 
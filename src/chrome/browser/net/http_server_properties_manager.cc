@@ -171,6 +171,22 @@ HttpServerPropertiesManager::alternate_protocol_map() const {
   return http_server_properties_impl_->alternate_protocol_map();
 }
 
+void HttpServerPropertiesManager::RecordSocketUse(
+    const net::HostPortPair& server,
+    int concurrency,
+    bool idle_socket,
+    base::TimeDelta connect_wait) {
+  DCHECK(BrowserThread::CurrentlyOn(BrowserThread::IO));
+  http_server_properties_impl_->RecordSocketUse(server, concurrency,
+                                                idle_socket, connect_wait);
+}
+
+net::ConnectionStats HttpServerPropertiesManager::GetConnectionStats(
+    const net::HostPortPair& server) {
+  DCHECK(BrowserThread::CurrentlyOn(BrowserThread::IO));
+  return http_server_properties_impl_->GetConnectionStats(server);
+}
+
 //
 // Update spdy_servers (the cached data) with data from preferences.
 //
@@ -109,6 +109,17 @@ class HttpServerPropertiesManager
   virtual const net::AlternateProtocolMap&
       alternate_protocol_map() const OVERRIDE;
 
+  // Records the use of a socket to |server|. The connection stats are not
+  // persisted.
+  virtual void RecordSocketUse(const net::HostPortPair& server,
+                               int concurrency,
+                               bool idle_socket,
+                               base::TimeDelta connect_wait) OVERRIDE;
+
+  // Returns the connection stats of |server|.
+  virtual net::ConnectionStats GetConnectionStats(
+      const net::HostPortPair& server) OVERRIDE;
+
  protected:
   typedef base::RefCountedData<base::ListValue> RefCountedListValue;
   typedef base::RefCountedData<net::AlternateProtocolMap>
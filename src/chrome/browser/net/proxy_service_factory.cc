@@ -91,6 +91,7 @@ net::ProxyService* ProxyServiceFactory::CreateProxyService(
     proxy_service = net::ProxyService::CreateUsingV8ProxyResolver(
         proxy_config_service,
         num_pac_threads,
+        command_line.HasSwitch(switches::kEnablePacResultCache),
         new net::ProxyScriptFetcherImpl(context),
         dhcp_factory.Create(context),
         context->host_resolver(),
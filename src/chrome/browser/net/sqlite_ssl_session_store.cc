@@ -0,0 +1,451 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "chrome/browser/net/sqlite_ssl_session_store.h"
+
+#include <list>
+
+#include "base/basictypes.h"
+#include "base/bind.h"
+#include "base/file_path.h"
+#include "base/file_util.h"
+#include "base/logging.h"
+#include "base/memory/scoped_ptr.h"
+#include "base/stl_util.h"
+#include "base/string_util.h"
+#include "base/threading/thread.h"
+#include "chrome/browser/diagnostics/sqlite_diagnostics.h"
+#include "content/browser/browser_thread.h"
+#include "sql/meta_table.h"
+#include "sql/statement.h"
+#include "sql/transaction.h"
+
+// This class is designed to be shared between any calling threads and the
+// database thread.  It batches operations and commits them on a timer.
+//
+// SQLiteSSLSessionStore::Load is called to load all sessions.  It delegates
+// to Backend::Load, which posts a Backend::LoadAndNotifyOnDBThread task to
+// the DB thread.  That task reads the sessions and posts
+// Backend::NotifyOnIOThread to the IO thread, which passes them to the
+// caller of SQLiteSSLSessionStore::Load.
+class SQLiteSSLSessionStore::Backend
+    : public base::RefCountedThreadSafe<SQLiteSSLSessionStore::Backend> {
+ public:
+  explicit Backend(const FilePath& path)
+      : path_(path),
+        db_(NULL),
+        num_pending_(0),
+        clear_local_state_on_exit_(false) {
+  }
+
+  // Creates or loads the SQLite database.
+  void Load(const LoadedCallback& loaded_callback);
+
+  // Batch a session addition.
+  void AddSession(const net::SSLSessionCache::Session& session);
+
+  // Batch a session deletion.
+  void DeleteSession(const net::SSLSessionCache::Session& session);
+
+  // Commit pending operations as soon as possible.
+  void Flush(Task* completion_task);
+
+  // Commit any pending operations and close the database.  This must be called
+  // before the object is destructed.
+  void Close();
+
+  void SetClearLocalStateOnExit(bool clear_local_state);
+
+ private:
+  friend class base::RefCountedThreadSafe<SQLiteSSLSessionStore::Backend>;
+
+  // You should call Close() before destructing this object.
+  ~Backend() {
+    DCHECK(!db_.get()) << "Close should have already been called.";
+    DCHECK(num_pending_ == 0 && pending_.empty());
+    // The IO thread may have gone away before the sessions were passed on.
+    STLDeleteElements(&sessions_);
+  }
+
+  // Creates or loads the SQLite database on the DB thread, then notifies
+  // the caller of Load() on the IO thread.
+  void LoadAndNotifyOnDBThread(const LoadedCallback& loaded_callback);
+
+  // Reads all the sessions into |sessions_|. Returns false on failure.
+  bool LoadSessions();
+
+  // Passes the sessions that were loaded to |loaded_callback|.
+  void NotifyOnIOThread(const LoadedCallback& loaded_callback);
+
+  // Database upgrade statements.
+  bool EnsureDatabaseVersion();
+
+  class PendingOperation {
+   public:
+    typedef enum {
+      SESSION_ADD,
+      SESSION_DELETE
+    } OperationType;
+
+    PendingOperation(OperationType op,
+                     const net::SSLSessionCache::Session& session)
+        : op_(op), session_(session) {}
+
+    OperationType op() const { return op_; }
+    const net::SSLSessionCache::Session& session() const { return session_; }
+
+   private:
+    OperationType op_;
+    net::SSLSessionCache::Session session_;
+  };
+
+ private:
+  // Batch a session operation (add or delete)
+  void BatchOperation(PendingOperation::OperationType op,
+                      const net::SSLSessionCache::Session& session);
+  // Commit our pending operations to the database.
+  void Commit();
+  // Close() executed on the background thread.
+  void InternalBackgroundClose();
+
+  FilePath path_;
+  scoped_ptr<sql::Connection> db_;
+  sql::MetaTable meta_table_;
+
+  typedef std::list<PendingOperation*> PendingOperationsList;
+  PendingOperationsList pending_;
+  PendingOperationsList::size_type num_pending_;
+  // True if the persistent store should be deleted upon destruction.
+  bool clear_local_state_on_exit_;
+  // The sessions that were loaded and not passed to the callback yet.
+  std::vector<net::SSLSessionCache::Session*> sessions_;
+  // Guard |pending_|, |num_pending_|, |clear_local_state_on_exit_| and
+  // |sessions_|.
+  base::Lock lock_;
+
+  DISALLOW_COPY_AND_ASSIGN(Backend);
+};
+
+// Version number of the database.
+static const int kCurrentVersionNumber = 1;
+static const int kCompatibleVersionNumber = 1;
+
+namespace {
+
+// Initializes the sessions table, returning true on success.
+bool InitTable(sql::Connection* db) {
+  if (!db->DoesTableExist("ssl_sessions")) {
+    if (!db->Execute("CREATE TABLE ssl_sessions ("
+                     "host TEXT NOT NULL,"
+                     "port INTEGER NOT NULL,"
+                     "session BLOB NOT NULL,"
+                     "expires_utc INTEGER NOT NULL,"
+                     "PRIMARY KEY (host, port))"))
+      return false;
+  }
+
+  return true;
+}
+
+}  // namespace
+
+void SQLiteSSLSessionStore::Backend::Load(
+    const LoadedCallback& loaded_callback) {
+  // This function should be called only once per instance.
+  DCHECK(!db_.get());
+  BrowserThread::PostTask(
+      BrowserThread::DB, FROM_HERE,
+      base::Bind(&Backend::LoadAndNotifyOnDBThread, this, loaded_callback));
+}
+
+void SQLiteSSLSessionStore::Backend::LoadAndNotifyOnDBThread(
+    const LoadedCallback& loaded_callback) {
+  DCHECK(BrowserThread::CurrentlyOn(BrowserThread::DB));
+
+  // On failure, the cache starts without sessions.
+  LoadSessions();
+
+  BrowserThread::PostTask(
+      BrowserThread::IO, FROM_HERE,
+      base::Bind(&Backend::NotifyOnIOThread, this, loaded_callback));
+}
+
+void SQLiteSSLSessionStore::Backend::NotifyOnIOThread(
+    const LoadedCallback& loaded_callback) {
+  DCHECK(BrowserThread::CurrentlyOn(BrowserThread::IO));
+
+  std::vector<net::SSLSessionCache::Session*> sessions;
+  {
+    base::AutoLock locked(lock_);
+    sessions.swap(sessions_);
+  }
+
+  loaded_callback.Run(sessions);
+}
+
+bool SQLiteSSLSessionStore::Backend::LoadSessions() {
+  DCHECK(BrowserThread::CurrentlyOn(BrowserThread::DB));
+
+  // Ensure the parent directory for storing sessions is created before reading
+  // from it.
+  const FilePath dir = path_.DirName();
+  if (!file_util::PathExists(dir) && !file_util::CreateDirectory(dir))
+    return false;
+
+  db_.reset(new sql::Connection);
+  if (!db_->Open(path_)) {
+    NOTREACHED() << "Unable to open SSL session DB.";
+    db_.reset();
+    return false;
+  }
+
+  if (!EnsureDatabaseVersion() || !InitTable(db_.get())) {
+    NOTREACHED() << "Unable to open SSL session DB.";
+    db_.reset();
+    return false;
+  }
+
+  db_->Preload();
+
+  // Slurp all the sessions. The expired ones are dropped by the cache.
+  sql::Statement smt(db_->GetUniqueStatement(
+      "SELECT host, port, session, expires_utc FROM ssl_sessions"));
+  if (!smt) {
+    NOTREACHED() << "select statement prep failed";
+    db_.reset();
+    return false;
+  }
+
+  std::vector<net::SSLSessionCache::Session*> sessions;
+  while (smt.Step()) {
+    std::string session_from_db;
+    smt.ColumnBlobAsString(2, &session_from_db);
+    scoped_ptr<net::SSLSessionCache::Session> session(
+        new net::SSLSessionCache::Session(
+            net::HostPortPair(smt.ColumnString(0), smt.ColumnInt(1)),
+            session_from_db,
+            base::Time::FromInternalValue(smt.ColumnInt64(3))));
+    sessions.push_back(session.release());
+  }
+
+  base::AutoLock locked(lock_);
+  sessions_.swap(sessions);
+  return true;
+}
+
+bool SQLiteSSLSessionStore::Backend::EnsureDatabaseVersion() {
+  // Version check.
+  if (!meta_table_.Init(
+      db_.get(), kCurrentVersionNumber, kCompatibleVersionNumber)) {
+    return false;
+  }
+
+  if (meta_table_.GetCompatibleVersionNumber() > kCurrentVersionNumber) {
+    LOG(WARNING) << "SSL session database is too new.";
+    return false;
+  }
+
+  int cur_version = meta_table_.GetVersionNumber();
+
+  // Put future migration cases here.
+
+  // When the version is too old, we just try to continue anyway, there should
+  // not be a released product that makes a database too old for us to handle.
+  LOG_IF(WARNING, cur_version < kCurrentVersionNumber) <<
+      "SSL session database version " << cur_version <<
+      " is too old to handle.";
+
+  return true;
+}
+
+void SQLiteSSLSessionStore::Backend::AddSession(
+    const net::SSLSessionCache::Session& session) {
+  BatchOperation(PendingOperation::SESSION_ADD, session);
+}
+
+void SQLiteSSLSessionStore::Backend::DeleteSession(
+    const net::SSLSessionCache::Session& session) {
+  BatchOperation(PendingOperation::SESSION_DELETE, session);
+}
+
+void SQLiteSSLSessionStore::Backend::BatchOperation(
+    PendingOperation::OperationType op,
+    const net::SSLSessionCache::Session& session) {
+  // Commit every 30 seconds.
+  static const int kCommitIntervalMs = 30 * 1000;
+  // Commit right away if we have more than 512 outstanding operations.
+  static const size_t kCommitAfterBatchSize = 512;
+  DCHECK(!BrowserThread::CurrentlyOn(BrowserThread::DB));
+
+  // We do a full copy of the session here, and hopefully just here.
+  scoped_ptr<PendingOperation> po(new PendingOperation(op, session));
+
+  PendingOperationsList::size_type num_pending;
+  {
+    base::AutoLock locked(lock_);
+    pending_.push_back(po.release());
+    num_pending = ++num_pending_;
+  }
+
+  if (num_pending == 1) {
+    // We've gotten our first entry for this batch, fire off the timer.
+    BrowserThread::PostDelayedTask(
+        BrowserThread::DB, FROM_HERE,
+        NewRunnableMethod(this, &Backend::Commit), kCommitIntervalMs);
+  } else if (num_pending == kCommitAfterBatchSize) {
+    // We've reached a big enough batch, fire off a commit now.
+    BrowserThread::PostTask(
+        BrowserThread::DB, FROM_HERE,
+        NewRunnableMethod(this, &Backend::Commit));
+  }
+}
+
+void SQLiteSSLSessionStore::Backend::Commit() {
+  DCHECK(BrowserThread::CurrentlyOn(BrowserThread::DB));
+
+  PendingOperationsList ops;
+  {
+    base::AutoLock locked(lock_);
+    pending_.swap(ops);
+    num_pending_ = 0;
+  }
+
+  // Maybe an old timer fired or we are already Close()'ed.
+  if (!db_.get() || ops.empty())
+    return;
+
+  sql::Statement add_smt(db_->GetCachedStatement(SQL_FROM_HERE,
+      "INSERT OR REPLACE INTO ssl_sessions (host, port, session, expires_utc) "
+      "VALUES (?,?,?,?)"));
+  if (!add_smt) {
+    NOTREACHED();
+    return;
+  }
+
+  sql::Statement del_smt(db_->GetCachedStatement(SQL_FROM_HERE,
+      "DELETE FROM ssl_sessions WHERE host=? AND port=?"));
+  if (!del_smt) {
+    NOTREACHED();
+    return;
+  }
+
+  sql::Transaction transaction(db_.get());
+  if (!transaction.Begin()) {
+    NOTREACHED();
+    return;
+  }
+  for (PendingOperationsList::iterator it = ops.begin();
+       it != ops.end(); ++it) {
+    // Free the sessions as we commit them to the database.
+    scoped_ptr<PendingOperation> po(*it);
+    const net::HostPortPair& host_and_port = po->session().host_and_port();
+    switch (po->op()) {
+      case PendingOperation::SESSION_ADD: {
+        add_smt.Reset();
+        add_smt.BindString(0, host_and_port.host());
+        add_smt.BindInt(1, host_and_port.port());
+        const std::string& data = po->session().data();
+        add_smt.BindBlob(2, data.data(), data.size());
+        add_smt.BindInt64(3, po->session().expiration().ToInternalValue());
+        if (!add_smt.Run())
+          NOTREACHED() << "Could not add an SSL session to the DB.";
+        break;
+      }
+      case PendingOperation::SESSION_DELETE:
+        del_smt.Reset();
+        del_smt.BindString(0, host_and_port.host());
+        del_smt.BindInt(1, host_and_port.port());
+        if (!del_smt.Run())
+          NOTREACHED() << "Could not delete an SSL session from the DB.";
+        break;
+
+      default:
+        NOTREACHED();
+        break;
+    }
+  }
+  transaction.Commit();
+}
+
+void SQLiteSSLSessionStore::Backend::Flush(Task* completion_task) {
+  DCHECK(!BrowserThread::CurrentlyOn(BrowserThread::DB));
+  BrowserThread::PostTask(
+      BrowserThread::DB, FROM_HERE, NewRunnableMethod(this, &Backend::Commit));
+  if (completion_task) {
+    // We want the completion task to run immediately after Commit() returns.
+    // Posting it from here means there is less chance of another task getting
+    // onto the message queue first, than if we posted it from Commit() itself.
+    BrowserThread::PostTask(BrowserThread::DB, FROM_HERE, completion_task);
+  }
+}
+
+// Fire off a close message to the background thread. We could still have a
+// pending commit timer that will be holding a reference on us, but if/when
+// this fires we will already have been cleaned up and it will be ignored.
+void SQLiteSSLSessionStore::Backend::Close() {
+  DCHECK(!BrowserThread::CurrentlyOn(BrowserThread::DB));
+  // Must close the backend on the background thread.
+  BrowserThread::PostTask(
+      BrowserThread::DB, FROM_HERE,
+      NewRunnableMethod(this, &Backend::InternalBackgroundClose));
+}
+
+void SQLiteSSLSessionStore::Backend::InternalBackgroundClose() {
+  DCHECK(BrowserThread::CurrentlyOn(BrowserThread::DB));
+  // Commit any pending operations
+  Commit();
+
+  db_.reset();
+
+  if (clear_local_state_on_exit_)
+    file_util::Delete(path_, false);
+}
+
+void SQLiteSSLSessionStore::Backend::SetClearLocalStateOnExit(
+    bool clear_local_state) {
+  base::AutoLock locked(lock_);
+  clear_local_state_on_exit_ = clear_local_state;
+}
+
+SQLiteSSLSessionStore::SQLiteSSLSessionStore(const FilePath& path)
+    : backend_(new Backend(path)) {
+}
+
+SQLiteSSLSessionStore::~SQLiteSSLSessionStore() {
+  if (backend_.get()) {
+    backend_->Close();
+    // Release our reference, it will probably still have a reference if the
+    // background thread has not run Close() yet.
+    backend_ = NULL;
+  }
+}
+
+void SQLiteSSLSessionStore::Load(const LoadedCallback& loaded_callback) {
+  backend_->Load(loaded_callback);
+}
+
+void SQLiteSSLSessionStore::AddSession(
+    const net::SSLSessionCache::Session& session) {
+  if (backend_.get())
+    backend_->AddSession(session);
+}
+
+void SQLiteSSLSessionStore::DeleteSession(
+    const net::SSLSessionCache::Session& session) {
+  if (backend_.get())
+    backend_->DeleteSession(session);
+}
+
+void SQLiteSSLSessionStore::SetClearLocalStateOnExit(
+    bool clear_local_state) {
+  if (backend_.get())
+    backend_->SetClearLocalStateOnExit(clear_local_state);
+}
+
+void SQLiteSSLSessionStore::Flush(Task* completion_task) {
+  if (backend_.get())
+    backend_->Flush(completion_task);
+  else if (completion_task)
+    MessageLoop::current()->PostTask(FROM_HERE, completion_task);
+}
@@ -0,0 +1,41 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef CHROME_BROWSER_NET_SQLITE_SSL_SESSION_STORE_H_
+#define CHROME_BROWSER_NET_SQLITE_SSL_SESSION_STORE_H_
+#pragma once
+
+#include "base/compiler_specific.h"
+#include "base/memory/ref_counted.h"
+#include "net/socket/ssl_session_cache.h"
+
+class FilePath;
+
+// Implements the net::SSLSessionCache::PersistentStore interface in terms of
+// a SQLite database. For documentation about the actual member functions
+// consult the documentation of the parent class
+// |net::SSLSessionCache::PersistentStore|.
+class SQLiteSSLSessionStore : public net::SSLSessionCache::PersistentStore {
+ public:
+  explicit SQLiteSSLSessionStore(const FilePath& path);
+  virtual ~SQLiteSSLSessionStore();
+
+  // net::SSLSessionCache::PersistentStore implementation.
+  virtual void Load(const LoadedCallback& loaded_callback) OVERRIDE;
+  virtual void AddSession(const net::SSLSessionCache::Session& session)
+      OVERRIDE;
+  virtual void DeleteSession(const net::SSLSessionCache::Session& session)
+      OVERRIDE;
+  virtual void SetClearLocalStateOnExit(bool clear_local_state) OVERRIDE;
+  virtual void Flush(Task* completion_task) OVERRIDE;
+
+ private:
+  class Backend;
+
+  scoped_refptr<Backend> backend_;
+
+  DISALLOW_COPY_AND_ASSIGN(SQLiteSSLSessionStore);
+};
+
+#endif  // CHROME_BROWSER_NET_SQLITE_SSL_SESSION_STORE_H_
@@ -0,0 +1,125 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <algorithm>
+
+#include "base/bind.h"
+#include "base/file_util.h"
+#include "base/memory/ref_counted.h"
+#include "base/message_loop.h"
+#include "base/scoped_temp_dir.h"
+#include "base/stl_util.h"
+#include "base/synchronization/waitable_event.h"
+#include "base/test/thread_test_helper.h"
+#include "chrome/browser/net/sqlite_ssl_session_store.h"
+#include "chrome/common/chrome_constants.h"
+#include "content/browser/browser_thread.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+class SQLiteSSLSessionStoreTest : public testing::Test {
+ public:
+  SQLiteSSLSessionStoreTest()
+      : db_thread_(BrowserThread::DB),
+        io_thread_(BrowserThread::IO),
+        loaded_event_(false, false),
+        expiration_(base::Time::Now() + base::TimeDelta::FromHours(1)) {
+  }
+
+  void OnLoaded(const std::vector<net::SSLSessionCache::Session*>& sessions) {
+    sessions_ = sessions;
+    loaded_event_.Signal();
+  }
+
+  void Load(std::vector<net::SSLSessionCache::Session*>* sessions) {
+    store_->Load(base::Bind(&SQLiteSSLSessionStoreTest::OnLoaded,
+                            base::Unretained(this)));
+    loaded_event_.Wait();
+    *sessions = sessions_;
+  }
+
+ protected:
+  virtual void SetUp() {
+    db_thread_.Start();
+    io_thread_.Start();
+    ASSERT_TRUE(temp_dir_.CreateUniqueTempDir());
+    store_ = new SQLiteSSLSessionStore(
+        temp_dir_.path().Append(chrome::kSSLSessionFilename));
+    std::vector<net::SSLSessionCache::Session*> sessions;
+    Load(&sessions);
+    ASSERT_EQ(0u, sessions.size());
+    // Make sure the store gets written at least once.
+    store_->AddSession(net::SSLSessionCache::Session(
+        net::HostPortPair("encrypted.google.com", 443), "a", expiration_));
+  }
+
+  // Replaces the store effectively destroying the current one and forcing it
+  // to write its data to disk.
+  void ReopenStore() {
+    store_ = NULL;
+    // Make sure we wait until the destructor has run.
+    scoped_refptr<base::ThreadTestHelper> helper(
+        new base::ThreadTestHelper(
+            BrowserThread::GetMessageLoopProxyForThread(BrowserThread::DB)));
+    ASSERT_TRUE(helper->Run());
+    store_ = new SQLiteSSLSessionStore(
+        temp_dir_.path().Append(chrome::kSSLSessionFilename));
+  }
+
+  BrowserThread db_thread_;
+  BrowserThread io_thread_;
+  base::WaitableEvent loaded_event_;
+  std::vector<net::SSLSessionCache::Session*> sessions_;
+  ScopedTempDir temp_dir_;
+  scoped_refptr<SQLiteSSLSessionStore> store_;
+  base::Time expiration_;
+};
+
+TEST_F(SQLiteSSLSessionStoreTest, RemoveOnDestruction) {
+  store_->SetClearLocalStateOnExit(true);
+  store_ = NULL;
+  // Make sure we wait until the destructor has run.
+  scoped_refptr<base::ThreadTestHelper> helper(
+      new base::ThreadTestHelper(
+          BrowserThread::GetMessageLoopProxyForThread(BrowserThread::DB)));
+  ASSERT_TRUE(helper->Run());
+
+  ASSERT_FALSE(file_util::PathExists(
+      temp_dir_.path().Append(chrome::kSSLSessionFilename)));
+}
+
+// Test if data is stored as expected in the SQLite database.
+TEST_F(SQLiteSSLSessionStoreTest, TestPersistence) {
+  std::vector<net::SSLSessionCache::Session*> sessions;
+  // A new session replaces the previous one of the same server, and the same
+  // host on another port is another server.
+  store_->AddSession(net::SSLSessionCache::Session(
+      net::HostPortPair("encrypted.google.com", 443), "b", expiration_));
+  store_->AddSession(net::SSLSessionCache::Session(
+      net::HostPortPair("encrypted.google.com", 8443), "c", expiration_));
+  ReopenStore();
+
+  // Reload and test for persistence
+  Load(&sessions);
+  ASSERT_EQ(2U, sessions.size());
+  if (sessions[0]->host_and_port().port() != 443)
+    std::swap(sessions[0], sessions[1]);
+  EXPECT_EQ("encrypted.google.com", sessions[0]->host_and_port().host());
+  EXPECT_EQ(443, sessions[0]->host_and_port().port());
+  EXPECT_EQ("b", sessions[0]->data());
+  EXPECT_EQ(expiration_, sessions[0]->expiration());
+  EXPECT_EQ(8443, sessions[1]->host_and_port().port());
+  EXPECT_EQ("c", sessions[1]->data());
+
+  // Now delete a session and check persistence again.
+  store_->DeleteSession(*sessions[0]);
+  ReopenStore();
+  STLDeleteContainerPointers(sessions.begin(), sessions.end());
+  sessions.clear();
+
+  // Reload and check if the session has been removed.
+  Load(&sessions);
+  ASSERT_EQ(1U, sessions.size());
+  EXPECT_EQ(8443, sessions[0]->host_and_port().port());
+  STLDeleteContainerPointers(sessions.begin(), sessions.end());
+}
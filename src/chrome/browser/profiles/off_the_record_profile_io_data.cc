@@ -205,6 +205,7 @@ void OffTheRecordProfileIOData::LazyInitializeInternal(
                          main_context->http_auth_handler_factory(),
                          main_context->network_delegate(),
                          main_context->http_server_properties(),
+                         NULL,  // Don't persist the TLS sessions.
                          main_context->net_log(),
                          main_backend);
 
@@ -396,6 +396,7 @@ void ProfileImpl::DoFinalInit() {
   FilePath origin_bound_cert_path = GetPath();
   origin_bound_cert_path =
       origin_bound_cert_path.Append(chrome::kOBCertFilename);
+  FilePath ssl_session_path = GetPath().Append(chrome::kSSLSessionFilename);
   FilePath cache_path = base_cache_path_;
   int cache_max_size;
   GetCacheParameters(kNormalContext, &cache_path, &cache_max_size);
@@ -415,8 +416,9 @@ void ProfileImpl::DoFinalInit() {
   // Make sure we initialize the ProfileIOData after everything else has been
   // initialized that we might be reading from the IO thread.
 
-  io_data_.Init(cookie_path, origin_bound_cert_path, cache_path,
-                cache_max_size, media_cache_path, media_cache_max_size,
+  io_data_.Init(cookie_path, origin_bound_cert_path, ssl_session_path,
+                cache_path, cache_max_size, media_cache_path,
+                media_cache_max_size,
                 extensions_cookie_path, app_path, predictor_,
                 g_browser_process->local_state(),
                 g_browser_process->io_thread());
@@ -17,6 +17,7 @@
 #include "chrome/browser/net/predictor.h"
 #include "chrome/browser/net/sqlite_origin_bound_cert_store.h"
 #include "chrome/browser/net/sqlite_persistent_cookie_store.h"
+#include "chrome/browser/net/sqlite_ssl_session_store.h"
 #include "chrome/browser/prefs/pref_member.h"
 #include "chrome/browser/profiles/profile.h"
 #include "chrome/common/chrome_constants.h"
@@ -81,6 +82,7 @@ ProfileImplIOData::Handle::~Handle() {
 void ProfileImplIOData::Handle::Init(
       const FilePath& cookie_path,
       const FilePath& origin_bound_cert_path,
+      const FilePath& ssl_session_path,
       const FilePath& cache_path,
       int cache_max_size,
       const FilePath& media_cache_path,
@@ -98,6 +100,7 @@ void ProfileImplIOData::Handle::Init(
 
   lazy_params->cookie_path = cookie_path;
   lazy_params->origin_bound_cert_path = origin_bound_cert_path;
+  lazy_params->ssl_session_path = ssl_session_path;
   lazy_params->cache_path = cache_path;
   lazy_params->cache_max_size = cache_max_size;
   lazy_params->media_cache_path = media_cache_path;
@@ -354,6 +357,20 @@ void ProfileImplIOData::LazyInitializeInternal(
   media_request_context_->set_origin_bound_cert_service(
       origin_bound_cert_service);
 
+  // Setup the TLS session store. Like the cookies, the sessions don't survive
+  // when recording or playing back. Only the OpenSSL sockets use the session
+  // cache, so there is nothing to store with the other SSL libraries.
+  scoped_refptr<SQLiteSSLSessionStore> ssl_session_db;
+#if defined(USE_OPENSSL)
+  if (!record_mode && !playback_mode) {
+    DCHECK(!lazy_params_->ssl_session_path.empty());
+
+    ssl_session_db = new SQLiteSSLSessionStore(lazy_params_->ssl_session_path);
+    ssl_session_db->SetClearLocalStateOnExit(
+        profile_params->clear_local_state_on_exit);
+  }
+#endif
+
   net::HttpCache::DefaultBackend* main_backend =
       new net::HttpCache::DefaultBackend(
           net::DISK_CACHE,
@@ -371,6 +388,7 @@ void ProfileImplIOData::LazyInitializeInternal(
       main_context->http_auth_handler_factory(),
       main_context->network_delegate(),
       main_context->http_server_properties(),
+      ssl_session_db.get(),
       main_context->net_log(),
       main_backend);
 
@@ -37,6 +37,7 @@ class ProfileImplIOData : public ProfileIOData {
     // parameters needed to construct a ChromeURLRequestContextGetter.
     void Init(const FilePath& cookie_path,
               const FilePath& origin_bound_cert_path,
+              const FilePath& ssl_session_path,
               const FilePath& cache_path,
               int cache_max_size,
               const FilePath& media_cache_path,
@@ -108,6 +109,7 @@ class ProfileImplIOData : public ProfileIOData {
     // All of these parameters are intended to be read on the IO thread.
     FilePath cookie_path;
     FilePath origin_bound_cert_path;
+    FilePath ssl_session_path;
     FilePath cache_path;
     int cache_max_size;
     FilePath media_cache_path;
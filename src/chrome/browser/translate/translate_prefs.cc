@@ -4,6 +4,8 @@
 
 #include "chrome/browser/translate/translate_prefs.h"
 
+#include <vector>
+
 #include "base/string_util.h"
 #include "chrome/browser/prefs/pref_service.h"
 #include "chrome/browser/prefs/scoped_user_pref_update.h"
@@ -194,8 +196,13 @@ void TranslatePrefs::MigrateTranslateWhitelists(PrefService* user_prefs) {
   if (!dict || dict->empty())
     return;
   bool save_prefs = false;
+  // Removing a key invalidates the iterators, so iterate over a copy.
+  std::vector<std::string> keys;
   for (DictionaryValue::key_iterator iter(dict->begin_keys());
-       iter != dict->end_keys(); ++iter) {
+       iter != dict->end_keys(); ++iter)
+    keys.push_back(*iter);
+  for (std::vector<std::string>::const_iterator iter(keys.begin());
+       iter != keys.end(); ++iter) {
     ListValue* list = NULL;
     if (!dict->GetList(*iter, &list) || !list)
       break;  // Dictionary has either been migrated or new format.
@@ -398,6 +398,10 @@ const char kDumpHistogramsOnExit[]          = "dump-histograms-on-exit";
 // Enables AeroPeek for each tab. (This switch only works on Windows 7).
 const char kEnableAeroPeekTabs[]            = "enable-aero-peek-tabs";
 
+// Resolve hostnames by sending the DNS queries directly to the name servers of
+// the system, instead of calling getaddrinfo() on worker threads.
+const char kEnableAsyncDns[]                = "enable-async-dns";
+
 // Enable the inclusion of non-standard ports when generating the Kerberos SPN
 // in response to a Negotiate challenge. See HttpAuthHandlerNegotiate::CreateSPN
 // for more background.
@@ -498,6 +502,10 @@ const char kEnableNTPBookmarkFeatures[]     = "enable-ntp-bookmark-features";
 const char kEnableResourceContentSettings[] =
     "enable-resource-content-settings";
 
+// Cache the results of the PAC script by origin for a few minutes. This is only
+// correct for PAC scripts that don't look at the path of the URL.
+const char kEnablePacResultCache[]          = "enable-pac-result-cache";
+
 // Enable panels (always on-top docked pop-up windows).
 const char kEnablePanels[]                  = "enable-panels";
 
@@ -514,6 +522,10 @@ const char kEnableShortcutsProvider[]       = "enable-shortcuts-provider";
 // On platforms that support it, enable smooth scroll animation.
 const char kEnableSmoothScrolling[]         = "enable-smooth-scrolling";
 
+// Connect ahead of time the sockets that the servers are expected to need, as
+// learned from earlier page loads. Has no effect with --disable-preconnect.
+const char kEnableSocketWarmUp[]            = "enable-socket-warm-up";
+
 // Enable syncing extension settings.
 const char kEnableSyncExtensionSettings[]   = "enable-sync-extension-settings";
 
@@ -741,6 +753,12 @@ const char kNaClLoaderCmdPrefix[]           = "nacl-loader-cmd-prefix";
 // Causes the Native Client process to display a dialog on launch.
 const char kNaClStartupDialog[]             = "nacl-startup-dialog";
 
+// Keeps the most recent net log events in memory, and writes them to the
+// given file on exit. The file is in a binary format which
+// net::NetLogFlightRecorder::ConvertToJSON() turns into the events of the
+// --log-net-log file.
+const char kNetLogFlightRecorder[]          = "net-log-flight-recorder";
+
 // Sets the base logging level for the net log.  Log 0 logs the most data.
 // Intended primarily for use with --log-net-log.
 const char kNetLogLevel[]                   = "net-log-level";
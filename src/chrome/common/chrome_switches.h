@@ -118,6 +118,7 @@ extern const char kDomAutomationController[];
 extern const char kDownloadsNewUI[];
 extern const char kDumpHistogramsOnExit[];
 extern const char kEnableAeroPeekTabs[];
+extern const char kEnableAsyncDns[];
 extern const char kEnableAuthNegotiatePort[];
 extern const char kEnableAutofillFeedback[];
 extern const char kEnableAutologin[];
@@ -142,12 +143,14 @@ extern const char kEnableMemoryInfo[];
 extern const char kEnableNaCl[];
 extern const char kEnableNaClDebug[];
 extern const char kEnableNTPBookmarkFeatures[];
+extern const char kEnablePacResultCache[];
 extern const char kEnablePanels[];
 extern const char kEnablePreconnect[];
 extern const char kEnableResourceContentSettings[];
 extern const char kEnableSearchProviderApiV2[];
 extern const char kEnableShortcutsProvider[];
 extern const char kEnableSmoothScrolling[];
+extern const char kEnableSocketWarmUp[];
 // TODO(kalman): Add to about:flags when UI for syncing extension settings has
 // been figured out.
 extern const char kEnableSyncExtensionSettings[];
@@ -207,6 +210,7 @@ extern const char kNaClDebugIP[];
 extern const char kNaClDebugPorts[];
 extern const char kNaClLoaderCmdPrefix[];
 extern const char kNaClStartupDialog[];
+extern const char kNetLogFlightRecorder[];
 extern const char kNetLogLevel[];
 extern const char kNewTabPage[];
 extern const char kNoDefaultBrowserCheck[];
@@ -90,6 +90,7 @@ net::URLRequestContext* ShellURLRequestContextGetter::GetURLRequestContext() {
         url_request_context_->http_auth_handler_factory(),
         NULL,  // network_delegate
         url_request_context_->http_server_properties(),
+        NULL,  // ssl_session_store
         NULL,
         main_backend);
     storage_->set_http_transaction_factory(main_cache);
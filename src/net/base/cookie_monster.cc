@@ -51,6 +51,7 @@
 #include "base/bind.h"
 #include "base/callback.h"
 #include "base/format_macros.h"
+#include "base/hash.h"
 #include "base/logging.h"
 #include "base/memory/scoped_ptr.h"
 #include "base/message_loop.h"
@@ -58,6 +59,7 @@
 #include "base/metrics/histogram.h"
 #include "base/string_tokenizer.h"
 #include "base/string_util.h"
+#include "base/stl_util.h"
 #include "base/stringprintf.h"
 #include "googleurl/src/gurl.h"
 #include "googleurl/src/url_canon.h"
@@ -113,7 +115,7 @@ const int kDefaultAccessUpdateThresholdSeconds = 60;
 struct OrderByCreationTimeDesc {
   bool operator()(const CookieMonster::CookieMap::iterator& a,
                   const CookieMonster::CookieMap::iterator& b) const {
-    return a->second->CreationDate() > b->second->CreationDate();
+    return (*a)->CreationDate() > (*b)->CreationDate();
   }
 };
 
@@ -141,13 +143,13 @@ bool CookieSorter(CookieMonster::CanonicalCookie* cc1,
 bool LRUCookieSorter(const CookieMonster::CookieMap::iterator& it1,
                      const CookieMonster::CookieMap::iterator& it2) {
   // Cookies accessed less recently should be deleted first.
-  if (it1->second->LastAccessDate() != it2->second->LastAccessDate())
-    return it1->second->LastAccessDate() < it2->second->LastAccessDate();
+  if ((*it1)->LastAccessDate() != (*it2)->LastAccessDate())
+    return (*it1)->LastAccessDate() < (*it2)->LastAccessDate();
 
   // In rare cases we might have two cookies with identical last access times.
   // To preserve the stability of the sort, in these cases prefer to delete
   // older cookies over newer ones.  CreationDate() is guaranteed to be unique.
-  return it1->second->CreationDate() < it2->second->CreationDate();
+  return (*it1)->CreationDate() < (*it2)->CreationDate();
 }
 
 // Our strategy to find duplicates is:
@@ -363,7 +365,7 @@ bool FindLeastRecentlyAccessed(
     std::partial_sort(cookie_its->begin(), cookie_its->begin() + num_purge + 1,
                       cookie_its->end(), LRUCookieSorter);
     *lra_removed =
-        (*(cookie_its->begin() + num_purge))->second->LastAccessDate();
+        (**(cookie_its->begin() + num_purge))->LastAccessDate();
     cookie_its->erase(cookie_its->begin() + num_purge, cookie_its->end());
     return true;
   }
@@ -436,8 +438,144 @@ void BuildCookieInfoList(const CanonicalCookieVector& cookies,
   }
 }
 
+// The number of slots of a new table. There are at least twice as many slots
+// as keys.
+const size_t kMinCookieMapSlots = 16;
+
+// Returns the FNV-1a hash of a key of the CookieMap. The slot is picked from
+// the low bits of the hash, so the high bits are folded into them.
+size_t HashCookieKey(const std::string& key) {
+  uint32 hash = base::HashFNV1a(key.data(), key.size());
+  return hash ^ (hash >> 16);
+}
+
 }  // namespace
 
+CookieMonster::CookieMap::Bucket::Bucket(const std::string& key, size_t hash)
+    : key(key),
+      hash(hash),
+      live_cookies(0) {
+}
+
+CookieMonster::CookieMap::Bucket::~Bucket() {
+}
+
+CookieMonster::CookieMap::CookieMap()
+    : buckets_(kMinCookieMapSlots),
+      num_buckets_(0),
+      size_(0) {
+}
+
+CookieMonster::CookieMap::~CookieMap() {
+  STLDeleteElements(&buckets_);
+}
+
+size_t CookieMonster::CookieMap::count(const std::string& key) const {
+  const Bucket* bucket = buckets_[FindSlot(key, HashCookieKey(key))];
+  return bucket ? bucket->live_cookies : 0;
+}
+
+CookieMonster::CookieMapItPair CookieMonster::CookieMap::equal_range(
+    const std::string& key) const {
+  size_t slot = FindSlot(key, HashCookieKey(key));
+  if (!buckets_[slot])
+    return CookieMapItPair(end(), end());
+  return CookieMapItPair(iterator(this, slot, 0), iterator(this, slot + 1, 0));
+}
+
+void CookieMonster::CookieMap::insert(const std::string& key,
+                                      CanonicalCookie* cookie) {
+  DCHECK(cookie);
+  size_t hash = HashCookieKey(key);
+  size_t slot = FindSlot(key, hash);
+  Bucket* bucket = buckets_[slot];
+  if (!bucket) {
+    if ((num_buckets_ + 1) * 2 > buckets_.size()) {
+      Rehash();
+      slot = FindSlot(key, hash);
+    }
+    bucket = new Bucket(key, hash);
+    buckets_[slot] = bucket;
+    ++num_buckets_;
+  } else if (bucket->live_cookies < bucket->cookies->size()) {
+    bucket->cookies->erase(
+        std::remove(bucket->cookies->begin(), bucket->cookies->end(),
+                    static_cast<CanonicalCookie*>(NULL)),
+        bucket->cookies->end());
+  }
+  bucket->cookies->push_back(cookie);
+  ++bucket->live_cookies;
+  ++size_;
+}
+
+void CookieMonster::CookieMap::erase(const iterator& it) {
+  DCHECK_EQ(this, it.map_);
+  Bucket* bucket = buckets_[it.slot_];
+  DCHECK(bucket->cookies[it.index_]);
+  bucket->cookies[it.index_] = NULL;
+  --bucket->live_cookies;
+  --size_;
+  // Trailing erased cookies can go right away, no iterator points to them.
+  while (!bucket->cookies->empty() && !bucket->cookies->back())
+    bucket->cookies->pop_back();
+}
+
+size_t CookieMonster::CookieMap::FindSlot(const std::string& key,
+                                          size_t hash) const {
+  size_t mask = buckets_.size() - 1;
+  for (size_t slot = hash & mask; ; slot = (slot + 1) & mask) {
+    const Bucket* bucket = buckets_[slot];
+    if (!bucket || (bucket->hash == hash && bucket->key == key))
+      return slot;
+  }
+}
+
+void CookieMonster::CookieMap::SkipErased(size_t* slot, size_t* index) const {
+  for (; *slot < buckets_.size(); ++*slot, *index = 0) {
+    const Bucket* bucket = buckets_[*slot];
+    if (!bucket || !bucket->live_cookies)
+      continue;
+    for (; *index < bucket->cookies->size(); ++*index) {
+      if (bucket->cookies[*index])
+        return;
+    }
+  }
+  *index = 0;
+}
+
+void CookieMonster::CookieMap::Rehash() {
+  std::vector<Bucket*> old_buckets;
+  old_buckets.swap(buckets_);
+
+  size_t live_buckets = 0;
+  for (size_t i = 0; i < old_buckets.size(); ++i) {
+    if (old_buckets[i] && old_buckets[i]->live_cookies)
+      ++live_buckets;
+  }
+  // Leave room for as many new keys as there are keys.
+  size_t slots = kMinCookieMapSlots;
+  while (slots < (live_buckets + 1) * 4)
+    slots *= 2;
+  buckets_.resize(slots);
+
+  num_buckets_ = 0;
+  for (size_t i = 0; i < old_buckets.size(); ++i) {
+    Bucket* bucket = old_buckets[i];
+    if (!bucket)
+      continue;
+    if (!bucket->live_cookies) {
+      delete bucket;
+      continue;
+    }
+    size_t mask = slots - 1;
+    size_t slot = bucket->hash & mask;
+    while (buckets_[slot])
+      slot = (slot + 1) & mask;
+    buckets_[slot] = bucket;
+    ++num_buckets_;
+  }
+}
+
 // static
 bool CookieMonster::enable_file_scheme_ = false;
 
@@ -1229,7 +1367,7 @@ CookieList CookieMonster::GetAllCookies() {
   std::vector<CanonicalCookie*> cookie_ptrs;
   cookie_ptrs.reserve(cookies_.size());
   for (CookieMap::iterator it = cookies_.begin(); it != cookies_.end(); ++it)
-    cookie_ptrs.push_back(it->second);
+    cookie_ptrs.push_back(*it);
   std::sort(cookie_ptrs.begin(), cookie_ptrs.end(), CookieSorter);
 
   CookieList cookie_list;
@@ -1288,7 +1426,7 @@ int CookieMonster::DeleteAllCreatedBetween(const Time& delete_begin,
   int num_deleted = 0;
   for (CookieMap::iterator it = cookies_.begin(); it != cookies_.end();) {
     CookieMap::iterator curit = it;
-    CanonicalCookie* cc = curit->second;
+    CanonicalCookie* cc = *curit;
     ++it;
 
     if (cc->CreationDate() >= delete_begin &&
@@ -1321,7 +1459,7 @@ int CookieMonster::DeleteAllForHost(const GURL& url) {
     CookieMap::iterator curit = its.first;
     ++its.first;
 
-    const CanonicalCookie* const cc = curit->second;
+    const CanonicalCookie* const cc = *curit;
 
     // Delete only on a match as a host cookie.
     if (cc->IsHostCookie() && cc->IsDomainMatch(scheme, host)) {
@@ -1339,7 +1477,7 @@ bool CookieMonster::DeleteCanonicalCookie(const CanonicalCookie& cookie) {
   for (CookieMapItPair its = cookies_.equal_range(GetKey(cookie.Domain()));
        its.first != its.second; ++its.first) {
     // The creation date acts as our unique index...
-    if (its.first->second->CreationDate() == cookie.CreationDate()) {
+    if ((*its.first)->CreationDate() == cookie.CreationDate()) {
       InternalDeleteCookie(its.first, true, DELETE_COOKIE_EXPLICIT);
       return true;
     }
@@ -1472,7 +1610,7 @@ void CookieMonster::DeleteCookie(const GURL& url,
   for (CookieMap::iterator it = cookies_.begin(); it != cookies_.end();) {
     CookieMap::iterator curit = it;
     ++it;
-    if (matching_cookies.find(curit->second) != matching_cookies.end()) {
+    if (matching_cookies.find(*curit) != matching_cookies.end()) {
       InternalDeleteCookie(curit, true, DELETE_COOKIE_EXPLICIT);
     }
   }
@@ -1549,12 +1687,15 @@ void CookieMonster::StoreLoadedCookies(
   // and sync'd.
   base::AutoLock autolock(lock_);
 
+  std::set<std::string> keys;
   for (std::vector<CanonicalCookie*>::const_iterator it = cookies.begin();
        it != cookies.end(); ++it) {
     int64 cookie_creation_time = (*it)->CreationDate().ToInternalValue();
 
     if (creation_times_.insert(cookie_creation_time).second) {
-      InternalInsertCookie(GetKey((*it)->Domain()), *it, false);
+      const std::string key(GetKey((*it)->Domain()));
+      InternalInsertCookie(key, *it, false);
+      keys.insert(key);
       const Time cookie_access_time((*it)->LastAccessDate());
       if (earliest_access_time_.is_null() ||
           cookie_access_time < earliest_access_time_)
@@ -1576,10 +1717,10 @@ void CookieMonster::StoreLoadedCookies(
   // none of our other constraints are violated.
   // In particular, the backing store might have given us duplicate cookies.
 
-  // This method could be called multiple times due to priority loading, thus
-  // cookies loaded in previous runs will be validated again, but this is OK
-  // since they are expected to be much fewer than total DB.
-  EnsureCookiesMapIsValid();
+  // This method is called multiple times due to priority loading, so only the
+  // keys of the cookies just loaded are validated: duplicates can only be
+  // found among the cookies of the same key.
+  EnsureCookiesMapIsValid(keys);
 }
 
 void CookieMonster::InvokeQueue() {
@@ -1600,22 +1741,20 @@ void CookieMonster::InvokeQueue() {
   }
 }
 
-void CookieMonster::EnsureCookiesMapIsValid() {
+void CookieMonster::EnsureCookiesMapIsValid(
+    const std::set<std::string>& keys) {
   lock_.AssertAcquired();
 
   int num_duplicates_trimmed = 0;
 
-  // Iterate through all the of the cookies, grouped by host.
-  CookieMap::iterator prev_range_end = cookies_.begin();
-  while (prev_range_end != cookies_.end()) {
-    CookieMap::iterator cur_range_begin = prev_range_end;
-    const std::string key = cur_range_begin->first;  // Keep a copy.
-    CookieMap::iterator cur_range_end = cookies_.upper_bound(key);
-    prev_range_end = cur_range_end;
+  // Iterate through the cookies of every key.
+  for (std::set<std::string>::const_iterator it = keys.begin();
+       it != keys.end(); ++it) {
+    CookieMapItPair its = cookies_.equal_range(*it);
 
     // Ensure no equivalent cookies for this host.
     num_duplicates_trimmed +=
-        TrimDuplicateCookiesForKey(key, cur_range_begin, cur_range_end);
+        TrimDuplicateCookiesForKey(*it, its.first, its.second);
   }
 
   // Record how many duplicates were found in the database.
@@ -1642,8 +1781,8 @@ int CookieMonster::TrimDuplicateCookiesForKey(
   // Iterate through all of the cookies in our range, and insert them into
   // the equivalence map.
   for (CookieMap::iterator it = begin; it != end; ++it) {
-    DCHECK_EQ(key, it->first);
-    CanonicalCookie* cookie = it->second;
+    DCHECK_EQ(key, it.key());
+    CanonicalCookie* cookie = *it;
 
     CookieSignature signature(cookie->Name(), cookie->Domain(),
                               cookie->Path());
@@ -1693,8 +1832,8 @@ int CookieMonster::TrimDuplicateCookiesForKey(
         signature.path.c_str());
 
     // Remove all the cookies identified by |dupes|. It is valid to delete our
-    // list of iterators one at a time, since |cookies_| is a multimap (they
-    // don't invalidate existing iterators following deletion).
+    // list of iterators one at a time, since erasing a cookie from |cookies_|
+    // doesn't invalidate the iterators to the other cookies.
     for (CookieSet::iterator dupes_it = dupes.begin();
          dupes_it != dupes.end();
          ++dupes_it) {
@@ -1734,40 +1873,13 @@ void CookieMonster::FindCookiesForHostAndDomain(
   // want to collect statistics whenever the browser's being used.
   RecordPeriodicStats(current_time);
 
-  if (expiry_and_key_scheme_ == EKS_DISCARD_RECENT_AND_PURGE_DOMAIN) {
-    // Can just dispatch to FindCookiesForKey
-    const std::string key(GetKey(url.host()));
-    FindCookiesForKey(key, url, options, current_time,
-                      update_access_time, cookies);
-  } else {
-    // Need to probe for all domains that might have relevant
-    // cookies for us.
-
-    // Query for the full host, For example: 'a.c.blah.com'.
-    std::string key(GetKey(url.host()));
-    FindCookiesForKey(key, url, options, current_time, update_access_time,
-                      cookies);
-
-    // See if we can search for domain cookies, i.e. if the host has a TLD + 1.
-    const std::string domain(GetEffectiveDomain(url.scheme(), key));
-    if (domain.empty())
-      return;
-    DCHECK_LE(domain.length(), key.length());
-    DCHECK_EQ(0, key.compare(key.length() - domain.length(), domain.length(),
-                             domain));
-
-    // Walk through the string and query at the dot points (GURL should have
-    // canonicalized the dots, so this should be safe).  Stop once we reach the
-    // domain + registry; we can't write cookies past this point, and with some
-    // registrars other domains can, in which case we don't want to read their
-    // cookies.
-    for (key = "." + key; key.length() > domain.length(); ) {
-      FindCookiesForKey(key, url, options, current_time, update_access_time,
-                        cookies);
-      const size_t next_dot = key.find('.', 1);  // Skip over leading dot.
-      key.erase(0, next_dot);
-    }
-  }
+  // With EKS_KEEP_RECENT_AND_PURGE_ETLDP1, the key of the host is its eTLD+1
+  // (or the host itself if it has none), which is also the key of the cookies
+  // of all the domains the host can read cookies from. A single lookup finds
+  // them all.
+  const std::string key(GetKey(url.host()));
+  FindCookiesForKey(key, url, options, current_time, update_access_time,
+                    cookies);
 }
 
 void CookieMonster::FindCookiesForKey(
@@ -1786,7 +1898,7 @@ void CookieMonster::FindCookiesForKey(
   for (CookieMapItPair its = cookies_.equal_range(key);
        its.first != its.second; ) {
     CookieMap::iterator curit = its.first;
-    CanonicalCookie* cc = curit->second;
+    CanonicalCookie* cc = *curit;
     ++its.first;
 
     // If the cookie is expired, delete it.
@@ -1831,7 +1943,7 @@ bool CookieMonster::DeleteAnyEquivalentCookie(const std::string& key,
   for (CookieMapItPair its = cookies_.equal_range(key);
        its.first != its.second; ) {
     CookieMap::iterator curit = its.first;
-    CanonicalCookie* cc = curit->second;
+    CanonicalCookie* cc = *curit;
     ++its.first;
 
     if (ecc.IsEquivalent(*cc)) {
@@ -1858,7 +1970,7 @@ void CookieMonster::InternalInsertCookie(const std::string& key,
 
   if (cc->IsPersistent() && store_ && sync_to_store)
     store_->AddCookie(*cc);
-  cookies_.insert(CookieMap::value_type(key, cc));
+  cookies_.insert(key, cc);
   if (delegate_.get()) {
     delegate_->OnCookieChanged(
         *cc, false, CookieMonster::Delegate::CHANGE_COOKIE_EXPLICIT);
@@ -1990,7 +2102,7 @@ void CookieMonster::InternalDeleteCookie(CookieMap::iterator it,
   if (deletion_cause != DELETE_COOKIE_DONT_RECORD)
     histogram_cookie_deletion_cause_->Add(deletion_cause);
 
-  CanonicalCookie* cc = it->second;
+  CanonicalCookie* cc = *it;
   VLOG(kVlogSetCookies) << "InternalDeleteCookie() cc: " << cc->DebugString();
 
   if (cc->IsPersistent() && store_ && sync_to_store)
@@ -2080,7 +2192,7 @@ int CookieMonster::GarbageCollect(const Time& current,
         earliest_access_time_ = oldest_left;
       } else {
         earliest_access_time_ =
-            (*(cookie_its.begin() + num_evicted))->second->LastAccessDate();
+            (**(cookie_its.begin() + num_evicted))->LastAccessDate();
       }
       num_deleted += num_evicted;
     }
@@ -2103,7 +2215,7 @@ int CookieMonster::GarbageCollectExpired(
     CookieMap::iterator curit = it;
     ++it;
 
-    if (curit->second->IsExpired(current)) {
+    if ((*curit)->IsExpired(current)) {
       InternalDeleteCookie(curit, true, DELETE_COOKIE_EXPIRED);
       ++num_deleted;
     } else if (cookie_its) {
@@ -2123,9 +2235,9 @@ int CookieMonster::GarbageCollectDeleteList(
   for (std::vector<CookieMap::iterator>::iterator it = cookie_its.begin();
        it != cookie_its.end(); it++) {
     if (keep_accessed_after.is_null() ||
-        (*it)->second->LastAccessDate() < keep_accessed_after) {
+        (**it)->LastAccessDate() < keep_accessed_after) {
       histogram_evicted_last_access_minutes_->Add(
-          (current - (*it)->second->LastAccessDate()).InMinutes());
+          (current - (**it)->LastAccessDate()).InMinutes());
       InternalDeleteCookie((*it), true, cause);
       num_deleted++;
     }
@@ -2212,9 +2324,9 @@ void CookieMonster::RecordPeriodicStats(const base::Time& current_time) {
   // More detailed statistics on cookie counts at different granularities.
   TimeTicks beginning_of_time(TimeTicks::Now());
 
-  for (CookieMap::const_iterator it_key = cookies_.begin();
+  for (CookieMap::iterator it_key = cookies_.begin();
        it_key != cookies_.end(); ) {
-    const std::string& key(it_key->first);
+    const std::string& key(it_key.key());
 
     int key_count = 0;
     typedef std::map<std::string, unsigned int> DomainMap;
@@ -2222,10 +2334,10 @@ void CookieMonster::RecordPeriodicStats(const base::Time& current_time) {
     CookieMapItPair its_cookies = cookies_.equal_range(key);
     while (its_cookies.first != its_cookies.second) {
       key_count++;
-      const std::string& cookie_domain(its_cookies.first->second->Domain());
+      const std::string& cookie_domain((*its_cookies.first)->Domain());
       domain_map[cookie_domain]++;
 
-      its_cookies.first++;
+      ++its_cookies.first;
     }
     histogram_etldp1_count_->Add(key_count);
     histogram_domain_per_etldp1_count_->Add(domain_map.size());
@@ -21,6 +21,7 @@
 #include "base/gtest_prod_util.h"
 #include "base/memory/ref_counted.h"
 #include "base/memory/scoped_ptr.h"
+#include "base/stack_container.h"
 #include "base/synchronization/lock.h"
 #include "base/task.h"
 #include "base/time.h"
@@ -106,16 +107,105 @@ class NET_EXPORT CookieMonster : public CookieStore {
   // then the key is just the domain of the cookie.  Eventually, this
   // option will be removed.
 
-  // NOTE(deanm):
-  // I benchmarked hash_multimap vs multimap.  We're going to be query-heavy
-  // so it would seem like hashing would help.  However they were very
-  // close, with multimap being a tiny bit faster.  I think this is because
-  // our map is at max around 1000 entries, and the additional complexity
-  // for the hashing might not overcome the O(log(1000)) for querying
-  // a multimap.  Also, multimap is standard, another reason to use it.
-  // TODO(rdsmith): This benchmark should be re-done now that we're allowing
-  // subtantially more entries in the map.
-  typedef std::multimap<std::string, CanonicalCookie*> CookieMap;
+  // CookieMap is a hash table of the keys, with linear probing, and the
+  // cookies of every key are kept together in a small vector. Finding the
+  // cookies of a key takes a single hash lookup, which matters with the
+  // number of cookies that can be loaded from the backing store (there is no
+  // limit until the first garbage collection). Like a multimap, erasing a
+  // cookie only invalidates the iterators to that cookie, but inserting one
+  // invalidates all iterators. The order of the keys is unspecified.
+  class NET_EXPORT CookieMap {
+   public:
+    class iterator {
+     public:
+      iterator() : map_(NULL), slot_(0), index_(0) {}
+
+      const std::string& key() const { return map_->buckets_[slot_]->key; }
+      CanonicalCookie* operator*() const {
+        return map_->buckets_[slot_]->cookies[index_];
+      }
+
+      iterator& operator++() {
+        ++index_;
+        map_->SkipErased(&slot_, &index_);
+        return *this;
+      }
+
+      bool operator==(const iterator& other) const {
+        return slot_ == other.slot_ && index_ == other.index_;
+      }
+      bool operator!=(const iterator& other) const {
+        return !(*this == other);
+      }
+
+     private:
+      friend class CookieMap;
+
+      iterator(const CookieMap* map, size_t slot, size_t index)
+          : map_(map), slot_(slot), index_(index) {
+        map_->SkipErased(&slot_, &index_);
+      }
+
+      const CookieMap* map_;
+      size_t slot_;
+      size_t index_;
+    };
+
+    CookieMap();
+    // The cookies are not owned by the map.
+    ~CookieMap();
+
+    iterator begin() const { return iterator(this, 0, 0); }
+    iterator end() const { return iterator(this, buckets_.size(), 0); }
+
+    size_t size() const { return size_; }
+
+    // Returns the number of cookies for |key|.
+    size_t count(const std::string& key) const;
+
+    // Returns the range of the cookies for |key|.
+    std::pair<iterator, iterator> equal_range(const std::string& key) const;
+
+    // Adds |cookie| for |key|. Invalidates all iterators.
+    void insert(const std::string& key, CanonicalCookie* cookie);
+
+    // Removes the cookie at |it|. Only |it| is invalidated.
+    void erase(const iterator& it);
+
+   private:
+    // Most keys have a few cookies, which are kept in the bucket itself.
+    static const size_t kInlineCookies = 4;
+
+    // The cookies of a key. Erased cookies are set to NULL until the next
+    // insertion for the key, so that the other iterators stay valid.
+    struct Bucket {
+      Bucket(const std::string& key, size_t hash);
+      ~Bucket();
+
+      std::string key;
+      size_t hash;
+      size_t live_cookies;
+      StackVector<CanonicalCookie*, kInlineCookies> cookies;
+    };
+
+    // Returns the slot of |key|, or of the free slot where it goes.
+    size_t FindSlot(const std::string& key, size_t hash) const;
+
+    // Moves |*slot| and |*index| to the next cookie that isn't erased, or to
+    // end().
+    void SkipErased(size_t* slot, size_t* index) const;
+
+    // Rebuilds the table for one more key, dropping the keys that have no
+    // cookies left.
+    void Rehash();
+
+    // The slots of the table (a power of two of them), NULL when free.
+    std::vector<Bucket*> buckets_;
+    size_t num_buckets_;
+    size_t size_;
+
+    DISALLOW_COPY_AND_ASSIGN(CookieMap);
+  };
   typedef std::pair<CookieMap::iterator, CookieMap::iterator> CookieMapItPair;
 
   // The key and expiry scheme to be used by the monster.
@@ -315,6 +405,7 @@ class NET_EXPORT CookieMonster : public CookieStore {
   FRIEND_TEST_ALL_PREFIXES(CookieMonsterTest, TestTotalGarbageCollection);
   FRIEND_TEST_ALL_PREFIXES(CookieMonsterTest, GarbageCollectionTriggers);
   FRIEND_TEST_ALL_PREFIXES(CookieMonsterTest, TestGCTimes);
+  FRIEND_TEST_ALL_PREFIXES(CookieMonsterTest, TestLargeJarGC);
 
   // For validation of key values.
   FRIEND_TEST_ALL_PREFIXES(CookieMonsterTest, TestDomainTree);
@@ -479,9 +570,10 @@ class NET_EXPORT CookieMonster : public CookieStore {
   // Invokes deferred calls.
   void InvokeQueue();
 
-  // Checks that |cookies_| matches our invariants, and tries to repair any
-  // inconsistencies. (In other words, it does not have duplicate cookies).
-  void EnsureCookiesMapIsValid();
+  // Checks that the cookies of |keys| in |cookies_| match our invariants, and
+  // tries to repair any inconsistencies. (In other words, there are no
+  // duplicate cookies).
+  void EnsureCookiesMapIsValid(const std::set<std::string>& keys);
 
   // Checks for any duplicate cookies for CookieMap key |key| which lie between
   // |begin| and |end|. If any are found, all but the most recent are deleted.
@@ -3,6 +3,7 @@
 // found in the LICENSE file.
 
 #include <algorithm>
+#include <vector>
 
 #include "base/bind.h"
 #include "base/message_loop.h"
@@ -427,4 +428,53 @@ TEST_F(CookieMonsterTest, TestGCTimes) {
   }
 }
 
+// The backing store can hold many more cookies than kMaxCookies, and they are
+// all loaded before the first garbage collection.
+static const int kNumJarCookies = 100000;
+
+TEST_F(CookieMonsterTest, TestLargeJar) {
+  // One cookie for every host, all recently accessed so that none is garbage
+  // collected.
+  scoped_refptr<CookieMonster> cm(
+      CreateMonsterFromStoreForGC(kNumJarCookies, 0, 0));
+  GetCookiesCallback getCookiesCallback;
+  SetCookieCallback setCookieCallback;
+
+  std::vector<GURL> gurls;
+  for (int i = 0; i < kNumCookies; ++i) {
+    gurls.push_back(GURL(base::StringPrintf(
+        "http://h%05d.izzle/path", i * (kNumJarCookies / kNumCookies))));
+  }
+
+  // Import will happen on first access.
+  PerfTimeLogger timer("Cookie_monster_large_jar_load");
+  getCookiesCallback.GetCookies(cm, gurls[0]);
+  timer.Done();
+
+  PerfTimeLogger timer2("Cookie_monster_large_jar_get");
+  for (int i = 0; i < kNumCookies; ++i)
+    EXPECT_EQ("a=1", getCookiesCallback.GetCookies(cm, gurls[i]));
+  timer2.Done();
+
+  PerfTimeLogger timer3("Cookie_monster_large_jar_set");
+  for (int i = 0; i < kNumCookies; ++i)
+    setCookieCallback.SetCookie(cm, gurls[i], "b=2");
+  timer3.Done();
+}
+
+TEST_F(CookieMonsterTest, TestLargeJarGC) {
+  // All the cookies are old enough to be garbage collected, so the first set
+  // brings the jar down to kMaxCookies - kPurgeCookies.
+  scoped_refptr<CookieMonster> cm(
+      CreateMonsterFromStoreForGC(kNumJarCookies, kNumJarCookies,
+                                  CookieMonster::kSafeFromGlobalPurgeDays * 2));
+  GetCookiesCallback getCookiesCallback;
+  SetCookieCallback setCookieCallback;
+  getCookiesCallback.GetCookies(cm, GURL("http://h00000.izzle/path"));
+
+  PerfTimeLogger timer("Cookie_monster_large_jar_gc");
+  setCookieCallback.SetCookie(cm, GURL("http://google.izzle"), "b=2");
+  timer.Done();
+}
+
 }  // namespace
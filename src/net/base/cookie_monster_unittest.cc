@@ -5,7 +5,9 @@
 #include <time.h>
 
 #include <algorithm>
+#include <set>
 #include <string>
+#include <vector>
 
 #include "base/basictypes.h"
 #include "base/bind.h"
@@ -2454,6 +2456,92 @@ TEST_F(CookieMonsterTest, DontImportDuplicateCreationTimes) {
   EXPECT_NE(name1, name2);
 }
 
+// Erasing cookies from a CookieMap must not invalidate the iterators to the
+// other cookies, since the garbage collection deletes lists of iterators.
+TEST(CookieMapTest, EraseKeepsOtherIterators) {
+  std::vector<CookieMonster::CanonicalCookie> cookies(5);
+  CookieMonster::CookieMap map;
+  map.insert("a.com", &cookies[0]);
+  map.insert("b.com", &cookies[1]);
+  map.insert("b.com", &cookies[2]);
+  map.insert("a.com", &cookies[3]);
+  map.insert("c.com", &cookies[4]);
+  EXPECT_EQ(5u, map.size());
+  EXPECT_EQ(2u, map.count("a.com"));
+  EXPECT_EQ(0u, map.count("d.com"));
+
+  // The cookies of a key are kept in insertion order.
+  CookieMonster::CookieMapItPair its = map.equal_range("b.com");
+  ASSERT_TRUE(its.first != its.second);
+  EXPECT_EQ("b.com", its.first.key());
+  EXPECT_EQ(&cookies[1], *its.first);
+  ++its.first;
+  ASSERT_TRUE(its.first != its.second);
+  EXPECT_EQ(&cookies[2], *its.first);
+  ++its.first;
+  EXPECT_TRUE(its.first == its.second);
+
+  std::vector<CookieMonster::CookieMap::iterator> all;
+  for (CookieMonster::CookieMap::iterator it = map.begin(); it != map.end();
+       ++it) {
+    all.push_back(it);
+  }
+  ASSERT_EQ(5u, all.size());
+  std::set<CookieMonster::CanonicalCookie*> left;
+  for (size_t i = 0; i < all.size(); ++i) {
+    if (i % 2)
+      left.insert(*all[i]);
+    else
+      map.erase(all[i]);
+  }
+  EXPECT_EQ(2u, map.size());
+  for (size_t i = 1; i < all.size(); i += 2)
+    EXPECT_EQ(1u, left.count(*all[i]));
+
+  std::set<CookieMonster::CanonicalCookie*> found;
+  for (CookieMonster::CookieMap::iterator it = map.begin(); it != map.end();
+       ++it) {
+    found.insert(*it);
+  }
+  EXPECT_TRUE(left == found);
+}
+
+TEST(CookieMapTest, ManyKeys) {
+  const int kNumKeys = 1000;
+  std::vector<CookieMonster::CanonicalCookie> cookies(kNumKeys * 2);
+  CookieMonster::CookieMap map;
+  for (int i = 0; i < kNumKeys * 2; ++i)
+    map.insert(base::StringPrintf("host%d.com", i % kNumKeys), &cookies[i]);
+  EXPECT_EQ(cookies.size(), map.size());
+
+  // Empty half of the keys, then add as many new ones: the table is rebuilt
+  // without the empty keys.
+  for (int i = 0; i < kNumKeys; i += 2) {
+    CookieMonster::CookieMapItPair its =
+        map.equal_range(base::StringPrintf("host%d.com", i));
+    while (its.first != its.second) {
+      CookieMonster::CookieMap::iterator it = its.first;
+      ++its.first;
+      map.erase(it);
+    }
+  }
+  EXPECT_EQ(cookies.size() / 2, map.size());
+  for (int i = 0; i < kNumKeys; ++i)
+    map.insert(base::StringPrintf("new%d.com", i), &cookies[i]);
+
+  for (int i = 0; i < kNumKeys; ++i) {
+    EXPECT_EQ(i % 2 ? 2u : 0u,
+              map.count(base::StringPrintf("host%d.com", i)));
+    EXPECT_EQ(1u, map.count(base::StringPrintf("new%d.com", i)));
+  }
+  size_t count = 0;
+  for (CookieMonster::CookieMap::iterator it = map.begin(); it != map.end();
+       ++it) {
+    ++count;
+  }
+  EXPECT_EQ(map.size(), count);
+}
+
 TEST_F(CookieMonsterTest, Delegate) {
   scoped_refptr<MockPersistentCookieStore> store(
       new MockPersistentCookieStore);
@@ -41,6 +41,7 @@ static const uint16 kClassIN = 1;
 // dnsrr_resolver.cc:DnsRRIsParsedByWindows.
 static const uint16 kDNS_A = 1;
 static const uint16 kDNS_CNAME = 5;
+static const uint16 kDNS_SOA = 6;
 static const uint16 kDNS_TXT = 16;
 static const uint16 kDNS_AAAA = 28;
 static const uint16 kDNS_CERT = 37;
@@ -88,6 +88,7 @@ static bool DnsRRIsParsedByWindows(uint16 rrtype) {
   // We only cover the types which are defined in dns_util.h
   switch (rrtype) {
     case kDNS_CNAME:
+    case kDNS_SOA:
     case kDNS_TXT:
     case kDNS_DS:
     case kDNS_RRSIG:
@@ -41,6 +41,13 @@ const int kFilterBufSize = 32 * 1024;
 
 namespace net {
 
+namespace {
+
+// Set by tests that count the bytes passed through by filters.
+Filter::PassThroughCounters* g_pass_through_counters = NULL;
+
+}  // namespace
+
 FilterContext::~FilterContext() {
 }
 
@@ -325,6 +332,11 @@ Filter::Filter()
       last_status_(FILTER_NEED_MORE_DATA) {
 }
 
+// static
+void Filter::SetPassThroughCountersForTesting(PassThroughCounters* counters) {
+  g_pass_through_counters = counters;
+}
+
 Filter::FilterStatus Filter::CopyOut(char* dest_buffer, int* dest_len) {
   int out_len;
   int input_len = *dest_len;
@@ -335,6 +347,8 @@ Filter::FilterStatus Filter::CopyOut(char* dest_buffer, int* dest_len) {
 
   out_len = std::min(input_len, stream_data_len_);
   memcpy(dest_buffer, next_stream_data_, out_len);
+  if (g_pass_through_counters)
+    g_pass_through_counters->bytes_copied += out_len;
   *dest_len += out_len;
   stream_data_len_ -= out_len;
   if (0 == stream_data_len_) {
@@ -346,6 +360,10 @@ Filter::FilterStatus Filter::CopyOut(char* dest_buffer, int* dest_len) {
   }
 }
 
+bool Filter::IsPassThrough() const {
+  return false;
+}
+
 // static
 Filter* Filter::InitGZipFilter(FilterType type_id, int buffer_size) {
   scoped_ptr<GZipFilter> gz_filter(new GZipFilter());
@@ -397,6 +415,11 @@ void Filter::InitBuffer(int buffer_size) {
 }
 
 void Filter::PushDataIntoNextFilter() {
+  if (IsPassThrough() && PassStreamBufferToNextFilter()) {
+    last_status_ = FILTER_NEED_MORE_DATA;
+    return;
+  }
+
   IOBuffer* next_buffer = next_filter_->stream_buffer();
   int next_size = next_filter_->stream_buffer_size();
   last_status_ = ReadFilteredData(next_buffer->data(), &next_size);
@@ -404,4 +427,21 @@ void Filter::PushDataIntoNextFilter() {
     next_filter_->FlushStreamBuffer(next_size);
 }
 
+bool Filter::PassStreamBufferToNextFilter() {
+  Filter* next = next_filter_.get();
+  if (!stream_data_len_ || next->stream_data_len_ ||
+      next->stream_buffer_size_ != stream_buffer_size_) {
+    return false;
+  }
+
+  if (g_pass_through_counters)
+    g_pass_through_counters->bytes_handed_over += stream_data_len_;
+  stream_buffer_.swap(next->stream_buffer_);
+  next->next_stream_data_ = next_stream_data_;
+  next->stream_data_len_ = stream_data_len_;
+  next_stream_data_ = NULL;
+  stream_data_len_ = 0;
+  return true;
+}
+
 }  // namespace net
@@ -129,8 +129,22 @@ class NET_EXPORT_PRIVATE Filter {
     FILTER_TYPE_UNSUPPORTED,
   };
 
+  // Bytes that filters passed through unchanged, for tests: |bytes_copied|
+  // were copied by CopyOut() and |bytes_handed_over| were given to the next
+  // filter by exchanging stream buffers.
+  struct PassThroughCounters {
+    PassThroughCounters() : bytes_copied(0), bytes_handed_over(0) {}
+
+    int64 bytes_copied;
+    int64 bytes_handed_over;
+  };
+
   virtual ~Filter();
 
+  // Makes every filter add to |counters| (which may be NULL) from now on. Only
+  // meant to be called by tests; it is not thread safe.
+  static void SetPassThroughCountersForTesting(PassThroughCounters* counters);
+
   // Creates a Filter object.
   // Parameters: Filter_types specifies the type of filter created;
   // filter_context allows filters to acquire additional details needed for
@@ -219,6 +233,12 @@ class NET_EXPORT_PRIVATE Filter {
   // Copy pre-filter data directly to destination buffer without decoding.
   FilterStatus CopyOut(char* dest_buffer, int* dest_len);
 
+  // Returns true if the filter currently copies all its input to its output
+  // unchanged (with CopyOut()). In a chain, the input of such a filter is
+  // handed over to the next filter by exchanging their stream buffers, rather
+  // than being copied.
+  virtual bool IsPassThrough() const;
+
   FilterStatus last_status() const { return last_status_; }
 
   // Buffer to hold the data to be filtered (the input queue).
@@ -257,6 +277,11 @@ class NET_EXPORT_PRIVATE Filter {
   // Helper function to empty our output into the next filter's input.
   void PushDataIntoNextFilter();
 
+  // Helper for PushDataIntoNextFilter() when this filter passes its data
+  // through: swaps stream_buffer_ with the empty stream buffer of the next
+  // filter. Returns false if the buffers can't be exchanged.
+  bool PassStreamBufferToNextFilter();
+
   // Constructs a filter with an internal buffer of the given size.
   // Only meant to be called by unit tests that need to control the buffer size.
   static Filter* FactoryForTests(const std::vector<FilterType>& filter_types,
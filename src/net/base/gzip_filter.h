@@ -51,6 +51,10 @@ class GZipFilter : public Filter {
   // but not produce output yet.
   virtual FilterStatus ReadFilteredData(char* dest_buffer, int* dest_len);
 
+ protected:
+  // Filter implementation.
+  virtual bool IsPassThrough() const;
+
  private:
   enum DecodingStatus {
     DECODING_UNINITIALIZED,
@@ -0,0 +1,187 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#if defined(USE_SYSTEM_ZLIB)
+#include <zlib.h>
+#else
+#include "third_party/zlib/zlib.h"
+#endif
+
+#include "base/file_util.h"
+#include "base/memory/scoped_ptr.h"
+#include "base/path_service.h"
+#include "base/perftimer.h"
+#include "base/stringprintf.h"
+#include "net/base/filter.h"
+#include "net/base/io_buffer.h"
+#include "net/base/mock_filter_context.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace net {
+
+namespace {
+
+const int kNumIterations = 2000;
+
+// The size of the buffer the decoded data is read into, like the buffers of
+// the URLRequest consumers.
+const int kReadBufferSize = 32 * 1024;
+
+// Pages from net/data that are compressed and decoded. A page is repeated
+// |repeat| times; the long page spans several filter buffers, which is when
+// pass-through filters hand their buffers over instead of copying them.
+struct CorpusPage {
+  const char* name;
+  int repeat;
+};
+
+const CorpusPage kCorpus[] = {
+  { "filter_unittests/google.txt", 1 },
+  { "url_request_unittest/BullRunSpeech.txt", 1 },
+  { "url_request_unittest/BullRunSpeech.txt", 8 },
+};
+
+bool ReadCorpusFile(const char* name, std::string* data) {
+  FilePath path;
+  PathService::Get(base::DIR_SOURCE_ROOT, &path);
+  path = path.AppendASCII("net").AppendASCII("data").AppendASCII(name);
+  return file_util::ReadFileToString(path, data);
+}
+
+// Compresses |data| in the gzip format.
+std::string GZip(const std::string& data) {
+  z_stream stream;
+  memset(&stream, 0, sizeof(stream));
+  // 16 makes zlib write the gzip header and footer.
+  EXPECT_EQ(Z_OK, deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED,
+                               MAX_WBITS + 16, 8, Z_DEFAULT_STRATEGY));
+  std::string compressed(deflateBound(&stream, data.size()) + 32, '\0');
+  stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+  stream.avail_in = data.size();
+  stream.next_out = reinterpret_cast<Bytef*>(&compressed[0]);
+  stream.avail_out = compressed.size();
+  EXPECT_EQ(Z_STREAM_END, deflate(&stream, Z_FINISH));
+  compressed.resize(compressed.size() - stream.avail_out);
+  deflateEnd(&stream);
+  return compressed;
+}
+
+// Counts the bytes passed through by the filters while it is alive.
+class ScopedPassThroughCounters {
+ public:
+  ScopedPassThroughCounters() {
+    Filter::SetPassThroughCountersForTesting(&counters_);
+  }
+  ~ScopedPassThroughCounters() {
+    Filter::SetPassThroughCountersForTesting(NULL);
+  }
+
+  void Reset() { counters_ = Filter::PassThroughCounters(); }
+  const Filter::PassThroughCounters& get() const { return counters_; }
+
+ private:
+  Filter::PassThroughCounters counters_;
+
+  DISALLOW_COPY_AND_ASSIGN(ScopedPassThroughCounters);
+};
+
+// Decodes |encoded| with a new chain of |filter_types|, the way URLRequestJob
+// does, and returns the number of decoded bytes.
+int DecodeWithFilterChain(const std::vector<Filter::FilterType>& filter_types,
+                          const FilterContext& filter_context,
+                          const std::string& encoded,
+                          IOBuffer* read_buffer) {
+  scoped_ptr<Filter> filter(Filter::Factory(filter_types, filter_context));
+  EXPECT_TRUE(filter.get());
+  if (!filter.get())
+    return 0;
+
+  int decoded_len = 0;
+  size_t offset = 0;
+  Filter::FilterStatus status = Filter::FILTER_NEED_MORE_DATA;
+  while (status != Filter::FILTER_DONE) {
+    if (status == Filter::FILTER_NEED_MORE_DATA) {
+      if (offset == encoded.size())
+        break;
+      int len = std::min(static_cast<int>(encoded.size() - offset),
+                         filter->stream_buffer_size());
+      memcpy(filter->stream_buffer()->data(), encoded.data() + offset, len);
+      filter->FlushStreamBuffer(len);
+      offset += len;
+    }
+    int len = kReadBufferSize;
+    status = filter->ReadData(read_buffer->data(), &len);
+    EXPECT_NE(Filter::FILTER_ERROR, status);
+    if (status == Filter::FILTER_ERROR)
+      break;
+    decoded_len += len;
+  }
+  return decoded_len;
+}
+
+void RunFilterChainTest(const std::string& test_name,
+                        const std::vector<Filter::FilterType>& filter_types) {
+  MockFilterContext filter_context;
+  scoped_refptr<IOBuffer> read_buffer(new IOBuffer(kReadBufferSize));
+  ScopedPassThroughCounters counters;
+
+  for (size_t i = 0; i < arraysize(kCorpus); ++i) {
+    std::string contents;
+    ASSERT_TRUE(ReadCorpusFile(kCorpus[i].name, &contents));
+    std::string page;
+    for (int j = 0; j < kCorpus[i].repeat; ++j)
+      page.append(contents);
+    std::string encoded = GZip(page);
+
+    counters.Reset();
+    PerfTimer timer;
+    for (int j = 0; j < kNumIterations; ++j) {
+      ASSERT_EQ(static_cast<int>(page.size()),
+                DecodeWithFilterChain(filter_types, filter_context, encoded,
+                                      read_buffer));
+    }
+    double seconds = timer.Elapsed().InSecondsF();
+
+    std::string name = base::StringPrintf(
+        "%s_%s", test_name.c_str(),
+        FilePath().AppendASCII(kCorpus[i].name).BaseName().MaybeAsASCII()
+            .c_str());
+    if (kCorpus[i].repeat > 1)
+      base::StringAppendF(&name, "_x%d", kCorpus[i].repeat);
+    double decoded_bytes = static_cast<double>(page.size()) * kNumIterations;
+    LogPerfResult(name.c_str(), decoded_bytes / seconds / (1024 * 1024),
+                  "MB/s");
+    // Bytes that a filter of the chain copied without decoding them, per byte
+    // of output. Buffers handed over to the next filter are not copies.
+    LogPerfResult((name + "_copies").c_str(),
+                  counters.get().bytes_copied / decoded_bytes, "copies/byte");
+    LogPerfResult((name + "_handed_over").c_str(),
+                  counters.get().bytes_handed_over / decoded_bytes,
+                  "bytes/byte");
+  }
+}
+
+}  // namespace
+
+TEST(GZipFilterPerfTest, GZip) {
+  std::vector<Filter::FilterType> filter_types;
+  filter_types.push_back(Filter::FILTER_TYPE_GZIP);
+  RunFilterChainTest("GZipFilter_gzip", filter_types);
+}
+
+// The tentative gzip filters that are added for the responses of servers that
+// support SDCH pass the data through, see Filter::FixupEncodingTypes().
+TEST(GZipFilterPerfTest, GZipPassThroughChain) {
+  std::vector<Filter::FilterType> filter_types;
+  filter_types.push_back(Filter::FILTER_TYPE_GZIP_HELPING_SDCH);
+  filter_types.push_back(Filter::FILTER_TYPE_GZIP_HELPING_SDCH);
+  filter_types.push_back(Filter::FILTER_TYPE_GZIP);
+  RunFilterChainTest("GZipFilter_gzip_pass_through", filter_types);
+}
+
+}  // namespace net
@@ -239,6 +239,15 @@ class GZipUnitTest : public PlatformTest {
     ASSERT_TRUE(filter_.get());
   }
 
+  void InitFilterChain(const std::vector<Filter::FilterType>& filter_types) {
+    filter_.reset(Filter::Factory(filter_types, filter_context_));
+    ASSERT_TRUE(filter_.get());
+  }
+
+  static Filter* next_filter(Filter* filter) {
+    return filter->next_filter_.get();
+  }
+
   const char* source_buffer() const { return source_buffer_.data(); }
   int source_len() const { return static_cast<int>(source_buffer_.size()); }
 
@@ -394,4 +403,45 @@ TEST_F(GZipUnitTest, DecodeCorruptedHeader) {
   EXPECT_TRUE(code == Filter::FILTER_ERROR);
 }
 
+// Tests that a filter which passes its data through hands its stream buffer
+// over to the next filter of the chain, instead of copying the data.
+TEST_F(GZipUnitTest, PassThroughChainSwapsBuffers) {
+  std::vector<Filter::FilterType> filter_types;
+  filter_types.push_back(Filter::FILTER_TYPE_GZIP_HELPING_SDCH);
+  filter_types.push_back(Filter::FILTER_TYPE_GZIP_HELPING_SDCH);
+  InitFilterChain(filter_types);
+  Filter* first = filter_.get();
+  Filter* second = next_filter(first);
+  ASSERT_TRUE(second);
+  scoped_refptr<IOBuffer> second_buffer = second->stream_buffer();
+
+  // The filters find out that the data isn't gzipped from the first bytes,
+  // which are copied.
+  const int kFirstChunkSize = 100;
+  ASSERT_GT(source_len(), kFirstChunkSize);
+  char decode_buffer[kDefaultBufferSize];
+  int decode_len = 0;
+  const char* source_next = source_buffer();
+  for (int chunk_size = kFirstChunkSize; chunk_size > 0;
+       chunk_size = source_len() - decode_len) {
+    memcpy(filter_->stream_buffer()->data(), source_next, chunk_size);
+    ASSERT_TRUE(filter_->FlushStreamBuffer(chunk_size));
+    source_next += chunk_size;
+
+    Filter::FilterStatus code;
+    do {
+      int len = kDefaultBufferSize - decode_len;
+      code = filter_->ReadData(decode_buffer + decode_len, &len);
+      ASSERT_NE(Filter::FILTER_ERROR, code);
+      decode_len += len;
+    } while (code == Filter::FILTER_OK);
+    EXPECT_EQ(Filter::FILTER_NEED_MORE_DATA, code);
+  }
+  ASSERT_EQ(source_len(), decode_len);
+  EXPECT_EQ(0, memcmp(source_buffer(), decode_buffer, source_len()));
+
+  // The rest of the data was handed over.
+  EXPECT_EQ(second_buffer.get(), first->stream_buffer());
+}
+
 }  // namespace net
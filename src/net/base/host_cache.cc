@@ -54,12 +54,20 @@ HostCache::Entry* HostCache::Set(const Key& key,
                                  int error,
                                  const AddressList& addrlist,
                                  base::TimeTicks now) {
+  return Set(key, error, addrlist, now,
+             error == OK ? success_entry_ttl_ : failure_entry_ttl_);
+}
+
+HostCache::Entry* HostCache::Set(const Key& key,
+                                 int error,
+                                 const AddressList& addrlist,
+                                 base::TimeTicks now,
+                                 base::TimeDelta ttl) {
   DCHECK(CalledOnValidThread());
   if (caching_is_disabled())
     return NULL;
 
-  base::TimeTicks expiration = now +
-      (error == OK ? success_entry_ttl_ : failure_entry_ttl_);
+  base::TimeTicks expiration = now + ttl;
 
   scoped_refptr<Entry>& entry = entries_[key];
   if (!entry) {
@@ -95,6 +95,15 @@ class NET_EXPORT HostCache : NON_EXPORTED_BASE(public base::NonThreadSafe) {
              const AddressList& addrlist,
              base::TimeTicks now);
 
+  // Same as above, but the entry expires after |ttl| instead of the time to
+  // live of the cache. Used for the results of DNS queries, whose records
+  // carry their own TTLs.
+  Entry* Set(const Key& key,
+             int error,
+             const AddressList& addrlist,
+             base::TimeTicks now,
+             base::TimeDelta ttl);
+
   // Empties the cache
   void clear();
 
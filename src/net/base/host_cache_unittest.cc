@@ -84,6 +84,38 @@ TEST(HostCacheTest, Basic) {
   EXPECT_TRUE(cache.Lookup(Key("foobar2.com"), now) == NULL);
 }
 
+// Entries set with their own TTL ignore the TTLs of the cache, so that
+// negative results can be cached even though the cache disallows it.
+TEST(HostCacheTest, ExplicitTTL) {
+  HostCache cache(kMaxCacheEntries, kSuccessEntryTTL, kFailureEntryTTL);
+
+  // Start at t=0.
+  base::TimeTicks now;
+
+  cache.Set(Key("foobar.com"), OK, AddressList(), now,
+            base::TimeDelta::FromSeconds(5));
+  cache.Set(Key("foobar2.com"), ERR_NAME_NOT_RESOLVED, AddressList(), now,
+            base::TimeDelta::FromSeconds(20));
+  EXPECT_EQ(2U, cache.size());
+
+  // Advance to t=4.
+  now += base::TimeDelta::FromSeconds(4);
+  EXPECT_FALSE(cache.Lookup(Key("foobar.com"), now) == NULL);
+  const HostCache::Entry* entry = cache.Lookup(Key("foobar2.com"), now);
+  ASSERT_FALSE(entry == NULL);
+  EXPECT_EQ(ERR_NAME_NOT_RESOLVED, entry->error);
+
+  // Advance to t=5; the positive entry is now expired, the negative one is
+  // not.
+  now += base::TimeDelta::FromSeconds(1);
+  EXPECT_TRUE(cache.Lookup(Key("foobar.com"), now) == NULL);
+  EXPECT_FALSE(cache.Lookup(Key("foobar2.com"), now) == NULL);
+
+  // Advance to t=20; both entries are now expired.
+  now += base::TimeDelta::FromSeconds(15);
+  EXPECT_TRUE(cache.Lookup(Key("foobar2.com"), now) == NULL);
+}
+
 // Try caching entries for a failed resolve attempt -- since we set
 // the TTL of such entries to 0 it won't work.
 TEST(HostCacheTest, NoCacheNegative) {
@@ -227,6 +227,14 @@ NET_EXPORT HostResolver* CreateSystemHostResolver(
 NET_EXPORT HostResolver* CreateAsyncHostResolver(size_t max_concurrent_resolves,
                                                  const IPAddressNumber& dns_ip,
                                                  NetLog* net_log);
+
+// Creates a HostResolver implementation like CreateAsyncHostResolver(), that
+// sends the DNS queries to the name servers of the system configuration and
+// uses its search list and hosts file. It follows the changes of the
+// configuration, and must be created on a thread with an IO message loop.
+NET_EXPORT HostResolver* CreateSystemAsyncHostResolver(
+    size_t max_concurrent_resolves,
+    NetLog* net_log);
 }  // namespace net
 
 #endif  // NET_BASE_HOST_RESOLVER_H_
@@ -0,0 +1,177 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/base/net_log_flight_recorder.h"
+
+#include "base/file_util.h"
+#include "base/json/json_reader.h"
+#include "base/json/json_writer.h"
+#include "base/logging.h"
+#include "base/memory/scoped_ptr.h"
+#include "base/pickle.h"
+#include "base/values.h"
+
+namespace net {
+
+namespace {
+
+// Identifies the dumps, and the layout of their records.
+const uint32 kDumpMagic = 0x4e4c4652;  // "NLFR"
+const int kDumpVersion = 1;
+
+// Event parameters read back from a dump.
+class DumpedParameters : public NetLog::EventParameters {
+ public:
+  explicit DumpedParameters(Value* value) : value_(value) {}
+
+  virtual Value* ToValue() const OVERRIDE {
+    return value_->DeepCopy();
+  }
+
+ private:
+  virtual ~DumpedParameters() {}
+
+  scoped_ptr<Value> value_;
+};
+
+}  // namespace
+
+NetLogFlightRecorder::NetLogFlightRecorder(size_t capacity,
+                                           NetLog::LogLevel log_level)
+    : NetLog::ThreadSafeObserver(log_level),
+      capacity_(capacity),
+      next_(0) {
+  DCHECK_GT(capacity, 0u);
+  records_.reserve(capacity);
+}
+
+NetLogFlightRecorder::~NetLogFlightRecorder() {
+}
+
+void NetLogFlightRecorder::OnAddEntry(NetLog::EventType type,
+                                      const base::TimeTicks& time,
+                                      const NetLog::Source& source,
+                                      NetLog::EventPhase phase,
+                                      NetLog::EventParameters* params) {
+  base::AutoLock lock(lock_);
+  if (records_.size() < capacity_) {
+    records_.push_back(Record());
+    next_ = records_.size() - 1;
+  }
+  Record& record = records_[next_];
+  record.time = time;
+  record.source = source;
+  record.type = type;
+  record.phase = phase;
+  record.params = params;
+  next_ = (next_ + 1) % capacity_;
+}
+
+size_t NetLogFlightRecorder::size() const {
+  base::AutoLock lock(lock_);
+  return records_.size();
+}
+
+void NetLogFlightRecorder::Clear() {
+  base::AutoLock lock(lock_);
+  records_.clear();
+  next_ = 0;
+}
+
+void NetLogFlightRecorder::Serialize(std::string* data) const {
+  Pickle pickle;
+  pickle.WriteUInt32(kDumpMagic);
+  pickle.WriteInt(kDumpVersion);
+  {
+    base::AutoLock lock(lock_);
+    pickle.WriteSize(records_.size());
+    // Until the buffer is full, |next_| is its end and the oldest record is
+    // the first one.
+    size_t first = records_.size() < capacity_ ? 0 : next_;
+    for (size_t i = 0; i < records_.size(); ++i) {
+      const Record& record = records_[(first + i) % records_.size()];
+      pickle.WriteInt64(record.time.ToInternalValue());
+      pickle.WriteUInt32(record.source.id);
+      pickle.WriteInt(static_cast<int>(record.source.type));
+      pickle.WriteInt(static_cast<int>(record.type));
+      pickle.WriteInt(static_cast<int>(record.phase));
+      std::string params_json;
+      if (record.params) {
+        scoped_ptr<Value> value(record.params->ToValue());
+        if (value.get())
+          base::JSONWriter::Write(value.get(), false, &params_json);
+      }
+      pickle.WriteString(params_json);
+    }
+  }
+  data->assign(static_cast<const char*>(pickle.data()), pickle.size());
+}
+
+bool NetLogFlightRecorder::DumpToFile(const FilePath& path) const {
+  std::string data;
+  Serialize(&data);
+  return file_util::WriteFile(path, data.data(), data.size()) ==
+      static_cast<int>(data.size());
+}
+
+// static
+bool NetLogFlightRecorder::ConvertToJSON(const std::string& data,
+                                         std::string* json) {
+  Pickle pickle(data.data(), data.size());
+  void* iter = NULL;
+  uint32 magic;
+  int version;
+  size_t num_records;
+  if (!pickle.ReadUInt32(&iter, &magic) || magic != kDumpMagic ||
+      !pickle.ReadInt(&iter, &version) || version != kDumpVersion ||
+      !pickle.ReadSize(&iter, &num_records)) {
+    return false;
+  }
+
+  json->clear();
+  for (size_t i = 0; i < num_records; ++i) {
+    int64 time;
+    NetLog::Source source;
+    int source_type;
+    int type;
+    int phase;
+    std::string params_json;
+    if (!pickle.ReadInt64(&iter, &time) ||
+        !pickle.ReadUInt32(&iter, &source.id) ||
+        !pickle.ReadInt(&iter, &source_type) ||
+        !pickle.ReadInt(&iter, &type) ||
+        !pickle.ReadInt(&iter, &phase) ||
+        !pickle.ReadString(&iter, &params_json)) {
+      return false;
+    }
+    source.type = static_cast<NetLog::SourceType>(source_type);
+
+    scoped_refptr<NetLog::EventParameters> params;
+    if (!params_json.empty()) {
+      Value* value = base::JSONReader::Read(params_json, false);
+      if (!value)
+        return false;
+      params = new DumpedParameters(value);
+    }
+
+    scoped_ptr<Value> entry(NetLog::EntryToDictionaryValue(
+        static_cast<NetLog::EventType>(type),
+        base::TimeTicks::FromInternalValue(time), source,
+        static_cast<NetLog::EventPhase>(phase), params, false));
+    std::string entry_json;
+    base::JSONWriter::Write(entry.get(), false, &entry_json);
+    json->append(entry_json);
+    json->append(",\n");
+  }
+  return true;
+}
+
+NetLogFlightRecorder::Record::Record()
+    : type(NetLog::TYPE_CANCELLED),
+      phase(NetLog::PHASE_NONE) {
+}
+
+NetLogFlightRecorder::Record::~Record() {}
+
+}  // namespace net
@@ -0,0 +1,91 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef NET_BASE_NET_LOG_FLIGHT_RECORDER_H_
+#define NET_BASE_NET_LOG_FLIGHT_RECORDER_H_
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "base/basictypes.h"
+#include "base/compiler_specific.h"
+#include "base/memory/ref_counted.h"
+#include "base/synchronization/lock.h"
+#include "base/time.h"
+#include "net/base/net_export.h"
+#include "net/base/net_log.h"
+
+class FilePath;
+
+namespace net {
+
+// NetLogFlightRecorder is a NetLog observer that keeps the most recent events
+// in a bounded ring buffer, so that full logging can be left enabled and the
+// events that led to a failure can be dumped after the fact.
+//
+// Recording an event only copies its fixed-size fields and takes a reference
+// to its parameters; the parameters are serialized when the recorder is
+// dumped. The dump is a compact binary file, which ConvertToJSON() turns into
+// the events of the JSON log written by --log-net-log. Since it stores the
+// numeric event and source types, a dump must be converted by the same
+// version that wrote it.
+//
+// This class can be accessed by multiple threads.
+class NET_EXPORT NetLogFlightRecorder : public NetLog::ThreadSafeObserver {
+ public:
+  // Creates a recorder that keeps the last |capacity| events of at least
+  // |log_level|.
+  NetLogFlightRecorder(size_t capacity, NetLog::LogLevel log_level);
+  virtual ~NetLogFlightRecorder();
+
+  // NetLog::ThreadSafeObserver implementation:
+  virtual void OnAddEntry(NetLog::EventType type,
+                          const base::TimeTicks& time,
+                          const NetLog::Source& source,
+                          NetLog::EventPhase phase,
+                          NetLog::EventParameters* params) OVERRIDE;
+
+  // Returns the number of events currently kept.
+  size_t size() const;
+
+  // Drops all the recorded events.
+  void Clear();
+
+  // Serializes the recorded events, oldest first, to |data|.
+  void Serialize(std::string* data) const;
+
+  // Writes the recorded events to |path|. Returns false on failure.
+  bool DumpToFile(const FilePath& path) const;
+
+  // Converts the events serialized in |data| to the format of the "events"
+  // list of NetLogLogger: one JSON dictionary per line, each followed by a
+  // comma. Returns false if |data| is not a valid dump.
+  static bool ConvertToJSON(const std::string& data, std::string* json);
+
+ private:
+  struct Record {
+    Record();
+    ~Record();
+
+    base::TimeTicks time;
+    NetLog::Source source;
+    NetLog::EventType type;
+    NetLog::EventPhase phase;
+    scoped_refptr<NetLog::EventParameters> params;
+  };
+
+  // Ring buffer of |capacity_| records. Once full, |next_| is the oldest one.
+  std::vector<Record> records_;
+  const size_t capacity_;
+  size_t next_;
+
+  mutable base::Lock lock_;
+
+  DISALLOW_COPY_AND_ASSIGN(NetLogFlightRecorder);
+};
+
+}  // namespace net
+
+#endif  // NET_BASE_NET_LOG_FLIGHT_RECORDER_H_
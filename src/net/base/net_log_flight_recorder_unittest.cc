@@ -0,0 +1,134 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/base/net_log_flight_recorder.h"
+
+#include <string>
+#include <vector>
+
+#include "base/file_util.h"
+#include "base/json/json_reader.h"
+#include "base/json/json_writer.h"
+#include "base/memory/scoped_ptr.h"
+#include "base/scoped_temp_dir.h"
+#include "base/string_split.h"
+#include "base/values.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace net {
+
+namespace {
+
+// Adds the event |i| of a fictitious URLRequest to |recorder|.
+void AddEvent(NetLogFlightRecorder* recorder, int i) {
+  scoped_refptr<NetLog::EventParameters> params(
+      new NetLogIntegerParameter("i", i));
+  recorder->OnAddEntry(NetLog::TYPE_URL_REQUEST_START_JOB,
+                       base::TimeTicks::FromInternalValue(1000 + i),
+                       NetLog::Source(NetLog::SOURCE_URL_REQUEST, 7),
+                       i % 2 ? NetLog::PHASE_END : NetLog::PHASE_BEGIN,
+                       i % 3 ? params.get() : NULL);
+}
+
+// Returns the JSON that NetLogLogger writes for the event |i|.
+std::string ExpectedJSON(int i) {
+  scoped_refptr<NetLog::EventParameters> params(
+      new NetLogIntegerParameter("i", i));
+  scoped_ptr<Value> value(NetLog::EntryToDictionaryValue(
+      NetLog::TYPE_URL_REQUEST_START_JOB,
+      base::TimeTicks::FromInternalValue(1000 + i),
+      NetLog::Source(NetLog::SOURCE_URL_REQUEST, 7),
+      i % 2 ? NetLog::PHASE_END : NetLog::PHASE_BEGIN,
+      i % 3 ? params.get() : NULL, false));
+  std::string json;
+  base::JSONWriter::Write(value.get(), false, &json);
+  return json + ",\n";
+}
+
+}  // namespace
+
+TEST(NetLogFlightRecorderTest, ConvertToJSON) {
+  NetLogFlightRecorder recorder(10, NetLog::LOG_ALL_BUT_BYTES);
+  for (int i = 0; i < 5; ++i)
+    AddEvent(&recorder, i);
+  EXPECT_EQ(5u, recorder.size());
+
+  std::string data;
+  recorder.Serialize(&data);
+  std::string json;
+  ASSERT_TRUE(NetLogFlightRecorder::ConvertToJSON(data, &json));
+
+  std::string expected_json;
+  for (int i = 0; i < 5; ++i)
+    expected_json += ExpectedJSON(i);
+  EXPECT_EQ(expected_json, json);
+
+  recorder.Clear();
+  EXPECT_EQ(0u, recorder.size());
+  recorder.Serialize(&data);
+  ASSERT_TRUE(NetLogFlightRecorder::ConvertToJSON(data, &json));
+  EXPECT_EQ("", json);
+}
+
+// Once full, the recorder keeps the most recent events.
+TEST(NetLogFlightRecorderTest, Wraparound) {
+  NetLogFlightRecorder recorder(4, NetLog::LOG_ALL_BUT_BYTES);
+  for (int i = 0; i < 11; ++i)
+    AddEvent(&recorder, i);
+  EXPECT_EQ(4u, recorder.size());
+
+  std::string data;
+  recorder.Serialize(&data);
+  std::string json;
+  ASSERT_TRUE(NetLogFlightRecorder::ConvertToJSON(data, &json));
+  EXPECT_EQ(ExpectedJSON(7) + ExpectedJSON(8) + ExpectedJSON(9) +
+                ExpectedJSON(10),
+            json);
+}
+
+TEST(NetLogFlightRecorderTest, DumpToFile) {
+  ScopedTempDir temp_dir;
+  ASSERT_TRUE(temp_dir.CreateUniqueTempDir());
+  FilePath path = temp_dir.path().AppendASCII("net_log.bin");
+
+  NetLogFlightRecorder recorder(10, NetLog::LOG_ALL_BUT_BYTES);
+  AddEvent(&recorder, 1);
+  AddEvent(&recorder, 2);
+  ASSERT_TRUE(recorder.DumpToFile(path));
+
+  std::string data;
+  ASSERT_TRUE(file_util::ReadFileToString(path, &data));
+  std::string json;
+  ASSERT_TRUE(NetLogFlightRecorder::ConvertToJSON(data, &json));
+  EXPECT_EQ(ExpectedJSON(1) + ExpectedJSON(2), json);
+
+  // Each line can be loaded like the entries of the JSON log.
+  std::vector<std::string> lines;
+  base::SplitString(json, '\n', &lines);
+  ASSERT_EQ(3u, lines.size());
+  ASSERT_EQ(',', lines[0][lines[0].size() - 1]);
+  scoped_ptr<Value> entry(base::JSONReader::Read(
+      lines[0].substr(0, lines[0].size() - 1), false));
+  ASSERT_TRUE(entry.get());
+  ASSERT_TRUE(entry->IsType(Value::TYPE_DICTIONARY));
+  int i = 0;
+  EXPECT_TRUE(static_cast<DictionaryValue*>(entry.get())->GetInteger(
+      "params.i", &i));
+  EXPECT_EQ(1, i);
+}
+
+TEST(NetLogFlightRecorderTest, InvalidDump) {
+  std::string json;
+  EXPECT_FALSE(NetLogFlightRecorder::ConvertToJSON("", &json));
+  EXPECT_FALSE(NetLogFlightRecorder::ConvertToJSON("not a net log", &json));
+
+  NetLogFlightRecorder recorder(10, NetLog::LOG_ALL_BUT_BYTES);
+  AddEvent(&recorder, 1);
+  std::string data;
+  recorder.Serialize(&data);
+  data.resize(data.size() - 4);
+  EXPECT_FALSE(NetLogFlightRecorder::ConvertToJSON(data, &json));
+}
+
+}  // namespace net
@@ -0,0 +1,182 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <string>
+#include <vector>
+
+#include "base/compiler_specific.h"
+#include "base/json/json_writer.h"
+#include "base/memory/scoped_ptr.h"
+#include "base/perftimer.h"
+#include "base/time.h"
+#include "base/values.h"
+#include "net/base/net_log.h"
+#include "net/base/net_log_flight_recorder.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace net {
+
+namespace {
+
+const int kNumRequests = 20000;
+
+// Formats the events as JSON like NetLogLogger does, without the file I/O.
+class JSONObserver : public NetLog::ThreadSafeObserver {
+ public:
+  JSONObserver() : NetLog::ThreadSafeObserver(NetLog::LOG_ALL_BUT_BYTES) {}
+
+  virtual void OnAddEntry(NetLog::EventType type,
+                          const base::TimeTicks& time,
+                          const NetLog::Source& source,
+                          NetLog::EventPhase phase,
+                          NetLog::EventParameters* params) OVERRIDE {
+    scoped_ptr<Value> value(NetLog::EntryToDictionaryValue(
+        type, time, source, phase, params, false));
+    json_.clear();
+    base::JSONWriter::Write(value.get(), false, &json_);
+  }
+
+ private:
+  std::string json_;
+};
+
+struct Event {
+  NetLog::EventType type;
+  NetLog::Source source;
+  NetLog::EventPhase phase;
+  scoped_refptr<NetLog::EventParameters> params;
+};
+
+void AddEvent(std::vector<Event>* events,
+              NetLog::EventType type,
+              const NetLog::Source& source,
+              NetLog::EventPhase phase,
+              NetLog::EventParameters* params) {
+  Event event;
+  event.type = type;
+  event.source = source;
+  event.phase = phase;
+  event.params = params;
+  events->push_back(event);
+}
+
+// Returns the events logged at LOG_ALL_BUT_BYTES by a typical URLRequest
+// that opens a new connection.
+std::vector<Event> URLRequestEvents() {
+  NetLog::Source request(NetLog::SOURCE_URL_REQUEST, 1);
+  NetLog::Source job(NetLog::SOURCE_CONNECT_JOB, 2);
+  NetLog::Source socket(NetLog::SOURCE_SOCKET, 3);
+  scoped_refptr<NetLog::EventParameters> url(new NetLogStringParameter(
+      "url", "http://www.example.com/images/logo.png?size=large"));
+  scoped_refptr<NetLog::EventParameters> host(
+      new NetLogStringParameter("host", "www.example.com:80"));
+  scoped_refptr<NetLog::EventParameters> job_dependency(
+      new NetLogSourceParameter("source_dependency", job));
+  scoped_refptr<NetLog::EventParameters> socket_dependency(
+      new NetLogSourceParameter("source_dependency", socket));
+  scoped_refptr<NetLog::EventParameters> address(
+      new NetLogStringParameter("address", "192.0.2.1:80"));
+  scoped_refptr<NetLog::EventParameters> bytes(
+      new NetLogIntegerParameter("byte_count", 16384));
+
+  std::vector<Event> events;
+  AddEvent(&events, NetLog::TYPE_REQUEST_ALIVE, request,
+           NetLog::PHASE_BEGIN, NULL);
+  AddEvent(&events, NetLog::TYPE_URL_REQUEST_START_JOB, request,
+           NetLog::PHASE_BEGIN, url);
+  AddEvent(&events, NetLog::TYPE_PROXY_SERVICE, request,
+           NetLog::PHASE_BEGIN, NULL);
+  AddEvent(&events, NetLog::TYPE_PROXY_SERVICE, request,
+           NetLog::PHASE_END, NULL);
+  AddEvent(&events, NetLog::TYPE_SOCKET_POOL, request,
+           NetLog::PHASE_BEGIN, NULL);
+  AddEvent(&events, NetLog::TYPE_SOCKET_POOL_CONNECT_JOB, job,
+           NetLog::PHASE_BEGIN, host);
+  AddEvent(&events, NetLog::TYPE_HOST_RESOLVER_IMPL, job,
+           NetLog::PHASE_BEGIN, host);
+  AddEvent(&events, NetLog::TYPE_HOST_RESOLVER_IMPL, job,
+           NetLog::PHASE_END, NULL);
+  AddEvent(&events, NetLog::TYPE_TCP_CONNECT, socket,
+           NetLog::PHASE_BEGIN, address);
+  AddEvent(&events, NetLog::TYPE_TCP_CONNECT_ATTEMPT, socket,
+           NetLog::PHASE_BEGIN, address);
+  AddEvent(&events, NetLog::TYPE_TCP_CONNECT_ATTEMPT, socket,
+           NetLog::PHASE_END, NULL);
+  AddEvent(&events, NetLog::TYPE_TCP_CONNECT, socket,
+           NetLog::PHASE_END, NULL);
+  AddEvent(&events, NetLog::TYPE_SOCKET_POOL_CONNECT_JOB, job,
+           NetLog::PHASE_END, NULL);
+  AddEvent(&events, NetLog::TYPE_SOCKET_POOL_BOUND_TO_SOCKET, request,
+           NetLog::PHASE_NONE, socket_dependency);
+  AddEvent(&events, NetLog::TYPE_SOCKET_POOL, request,
+           NetLog::PHASE_END, NULL);
+  AddEvent(&events, NetLog::TYPE_HTTP_TRANSACTION_SEND_REQUEST, request,
+           NetLog::PHASE_BEGIN, NULL);
+  AddEvent(&events, NetLog::TYPE_HTTP_TRANSACTION_SEND_REQUEST_HEADERS,
+           request, NetLog::PHASE_NONE, url);
+  AddEvent(&events, NetLog::TYPE_SOCKET_BYTES_SENT, socket,
+           NetLog::PHASE_NONE, bytes);
+  AddEvent(&events, NetLog::TYPE_HTTP_TRANSACTION_SEND_REQUEST, request,
+           NetLog::PHASE_END, NULL);
+  AddEvent(&events, NetLog::TYPE_HTTP_TRANSACTION_READ_HEADERS, request,
+           NetLog::PHASE_BEGIN, NULL);
+  AddEvent(&events, NetLog::TYPE_SOCKET_BYTES_RECEIVED, socket,
+           NetLog::PHASE_NONE, bytes);
+  AddEvent(&events, NetLog::TYPE_HTTP_TRANSACTION_READ_HEADERS, request,
+           NetLog::PHASE_END, NULL);
+  AddEvent(&events, NetLog::TYPE_HTTP_TRANSACTION_READ_RESPONSE_HEADERS,
+           request, NetLog::PHASE_NONE, url);
+  AddEvent(&events, NetLog::TYPE_URL_REQUEST_START_JOB, request,
+           NetLog::PHASE_END, NULL);
+  for (int i = 0; i < 4; ++i) {
+    AddEvent(&events, NetLog::TYPE_HTTP_TRANSACTION_READ_BODY, request,
+             NetLog::PHASE_BEGIN, NULL);
+    AddEvent(&events, NetLog::TYPE_SOCKET_BYTES_RECEIVED, socket,
+             NetLog::PHASE_NONE, bytes);
+    AddEvent(&events, NetLog::TYPE_HTTP_TRANSACTION_READ_BODY, request,
+             NetLog::PHASE_END, NULL);
+  }
+  AddEvent(&events, NetLog::TYPE_REQUEST_ALIVE, request,
+           NetLog::PHASE_END, NULL);
+  return events;
+}
+
+// Logs |kNumRequests| URLRequests to |observer| and reports the time spent
+// per request.
+void RunObserverTest(const char* name, NetLog::ThreadSafeObserver* observer) {
+  std::vector<Event> events = URLRequestEvents();
+  base::TimeTicks now = base::TimeTicks::Now();
+
+  PerfTimer timer;
+  for (int i = 0; i < kNumRequests; ++i) {
+    for (size_t j = 0; j < events.size(); ++j) {
+      observer->OnAddEntry(events[j].type, now, events[j].source,
+                           events[j].phase, events[j].params);
+    }
+  }
+  double seconds = timer.Elapsed().InSecondsF();
+  LogPerfResult(name, seconds * 1000 * 1000 / kNumRequests, "us/request");
+}
+
+}  // namespace
+
+TEST(NetLogPerfTest, JSONLogger) {
+  JSONObserver observer;
+  RunObserverTest("NetLog_json", &observer);
+}
+
+TEST(NetLogPerfTest, FlightRecorder) {
+  NetLogFlightRecorder recorder(10000, NetLog::LOG_ALL_BUT_BYTES);
+  RunObserverTest("NetLog_flight_recorder", &recorder);
+
+  // The parameters are serialized when the recorder is dumped.
+  PerfTimer timer;
+  std::string data;
+  recorder.Serialize(&data);
+  double seconds = timer.Elapsed().InSecondsF();
+  LogPerfResult("NetLog_flight_recorder_dump", seconds * 1000, "ms");
+  LogPerfResult("NetLog_flight_recorder_dump_size", data.size() / 1024, "KB");
+}
+
+}  // namespace net
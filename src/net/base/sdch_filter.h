@@ -43,6 +43,10 @@ class NET_EXPORT_PRIVATE SdchFilter : public Filter {
   // written into the destination buffer.
   virtual FilterStatus ReadFilteredData(char* dest_buffer, int* dest_len);
 
+ protected:
+  // Filter implementation.
+  virtual bool IsPassThrough() const;
+
  private:
   // Internal status.  Once we enter an error state, we stop processing data.
   enum DecodingStatus {
@@ -10,7 +10,8 @@ namespace disk_cache {
 
 int Addr::start_block() const {
   DCHECK(is_block_file());
-  return value_ & kStartBlockMask;
+  return (value_ & kStartBlockMask) |
+         ((value_ & kStartBlockHighMask) >> kStartBlockHighOffset);
 }
 
 int Addr::num_blocks() const {
@@ -30,14 +31,7 @@ bool Addr::SanityCheck() const {
   if (!is_initialized())
     return !value_;
 
-  if (((value_ & kFileTypeMask) >> kFileTypeOffset) > 4)
-    return false;
-
-  if (is_separate_file())
-    return true;
-
-  const uint32 kReservedBitsMask = 0x0c000000;
-  return !(value_ & kReservedBitsMask);
+  return ((value_ & kFileTypeMask) >> kFileTypeOffset) <= BLOCK_64K;
 }
 
 }  // namespace disk_cache
@@ -20,13 +20,25 @@ enum FileType {
   BLOCK_256,
   BLOCK_1K,
   BLOCK_4K,
+  BLOCK_16K,
+  BLOCK_64K,
 };
 
-const int kMaxBlockSize = 4096 * 4;
+const int kMaxBlockSize = 65536 * 4;
 const int kMaxBlockFile = 255;
 const int kMaxNumBlocks = 4;
 const int kFirstAdditionalBlockFile = 4;
 
+// Before version 3.0, any data blob bigger than this was stored on a separate
+// file.
+const int kMaxSmallBlockSize = 4096 * 4;
+
+// The first file of the chain of files for BLOCK_16K and BLOCK_64K. These types
+// were added on version 3.0, and their files use the last file numbers so that
+// the files created by older versions can keep their names.
+const int kFirstBigBlockFile = kMaxBlockFile - 1;
+const int kLastAdditionalBlockFile = kFirstBigBlockFile - 1;
+
 // Defines a storage address for a cache record
 //
 // Header:
@@ -39,15 +51,20 @@ const int kFirstAdditionalBlockFile = 4;
 //   2 = 256 byte block file
 //   3 = 1k byte block file
 //   4 = 4k byte block file
+//   5 = 16k byte block file
+//   6 = 64k byte block file
 //
 // If separate file:
 //   0000 1111 1111 1111 1111 1111 1111 1111 : file#  0 - 268,435,456 (2^28)
 //
 // If block file:
-//   0000 1100 0000 0000 0000 0000 0000 0000 : reserved bits
+//   0000 1100 0000 0000 0000 0000 0000 0000 : high bits of the block#
 //   0000 0011 0000 0000 0000 0000 0000 0000 : number of contiguous blocks 1-4
 //   0000 0000 1111 1111 0000 0000 0000 0000 : file selector 0 - 255
-//   0000 0000 0000 0000 1111 1111 1111 1111 : block#  0 - 65,535 (2^16)
+//   0000 0000 0000 0000 1111 1111 1111 1111 : block#  0 - 262,143 (2^18)
+//
+// The high bits of the block number were reserved (zero) before version 3.0,
+// so addresses from older versions are still valid.
 class NET_EXPORT_PRIVATE Addr {
  public:
   Addr() : value_(0) {}
@@ -56,6 +73,7 @@ class NET_EXPORT_PRIVATE Addr {
     value_ = ((file_type << kFileTypeOffset) & kFileTypeMask) |
              (((max_blocks - 1) << kNumBlocksOffset) & kNumBlocksMask) |
              ((block_file << kFileSelectorOffset) & kFileSelectorMask) |
+             ((index << kStartBlockHighOffset) & kStartBlockHighMask) |
              (index  & kStartBlockMask) | kInitializedMask;
   }
 
@@ -104,6 +122,10 @@ class NET_EXPORT_PRIVATE Addr {
         return 1024;
       case BLOCK_4K:
         return 4096;
+      case BLOCK_16K:
+        return 16384;
+      case BLOCK_64K:
+        return 65536;
       default:
         return 0;
     }
@@ -116,6 +138,10 @@ class NET_EXPORT_PRIVATE Addr {
       return BLOCK_1K;
     else if (size <= 4096 * 4)
       return BLOCK_4K;
+    else if (size <= 16384 * 4)
+      return BLOCK_16K;
+    else if (size <= 65536 * 4)
+      return BLOCK_64K;
     else
       return EXTERNAL;
   }
@@ -124,15 +150,17 @@ class NET_EXPORT_PRIVATE Addr {
   bool SanityCheck() const;
 
  private:
-  static const uint32 kInitializedMask    = 0x80000000;
-  static const uint32 kFileTypeMask       = 0x70000000;
-  static const uint32 kFileTypeOffset     = 28;
-  static const uint32 kNumBlocksMask      = 0x03000000;
-  static const uint32 kNumBlocksOffset    = 24;
-  static const uint32 kFileSelectorMask   = 0x00ff0000;
-  static const uint32 kFileSelectorOffset = 16;
-  static const uint32 kStartBlockMask     = 0x0000FFFF;
-  static const uint32 kFileNameMask       = 0x0FFFFFFF;
+  static const uint32 kInitializedMask      = 0x80000000;
+  static const uint32 kFileTypeMask         = 0x70000000;
+  static const uint32 kFileTypeOffset       = 28;
+  static const uint32 kNumBlocksMask        = 0x03000000;
+  static const uint32 kNumBlocksOffset      = 24;
+  static const uint32 kFileSelectorMask     = 0x00ff0000;
+  static const uint32 kFileSelectorOffset   = 16;
+  static const uint32 kStartBlockMask       = 0x0000FFFF;
+  static const uint32 kStartBlockHighMask   = 0x0C000000;
+  static const uint32 kStartBlockHighOffset = 10;
+  static const uint32 kFileNameMask         = 0x0FFFFFFF;
 
   CacheAddr value_;
 };
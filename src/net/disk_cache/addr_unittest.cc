@@ -25,12 +25,35 @@ TEST_F(DiskCacheTest, CacheAddr_ValidValues) {
   EXPECT_EQ(1024, addr2.BlockSize());
 }
 
+TEST_F(DiskCacheTest, CacheAddr_BigBlocks) {
+  Addr addr1(BLOCK_16K, 2, 254, 0x3FFFF);
+  EXPECT_EQ(BLOCK_16K, addr1.file_type());
+  EXPECT_EQ(2, addr1.num_blocks());
+  EXPECT_EQ(254, addr1.FileNumber());
+  EXPECT_EQ(0x3FFFF, addr1.start_block());
+  EXPECT_EQ(16384, addr1.BlockSize());
+  EXPECT_TRUE(addr1.SanityCheck());
+
+  Addr addr2(BLOCK_64K, 4, 255, 0x10000);
+  EXPECT_EQ(BLOCK_64K, addr2.file_type());
+  EXPECT_EQ(4, addr2.num_blocks());
+  EXPECT_EQ(255, addr2.FileNumber());
+  EXPECT_EQ(0x10000, addr2.start_block());
+  EXPECT_EQ(65536, addr2.BlockSize());
+  EXPECT_TRUE(addr2.SanityCheck());
+
+  EXPECT_EQ(BLOCK_4K, Addr::RequiredFileType(4096 * 4));
+  EXPECT_EQ(BLOCK_16K, Addr::RequiredFileType(4096 * 4 + 1));
+  EXPECT_EQ(BLOCK_64K, Addr::RequiredFileType(65536 * 4));
+  EXPECT_EQ(EXTERNAL, Addr::RequiredFileType(65536 * 4 + 1));
+}
+
 TEST_F(DiskCacheTest, CacheAddr_InvalidValues) {
   Addr addr3(BLOCK_4K, 0x44, 0x41508, 0x952536);
   EXPECT_EQ(BLOCK_4K, addr3.file_type());
   EXPECT_EQ(4, addr3.num_blocks());
   EXPECT_EQ(8, addr3.FileNumber());
-  EXPECT_EQ(0x2536, addr3.start_block());
+  EXPECT_EQ(0x12536, addr3.start_block());
   EXPECT_EQ(4096, addr3.BlockSize());
 }
 
@@ -46,12 +69,12 @@ TEST_F(DiskCacheTest, CacheAddr_SanityCheck) {
   EXPECT_FALSE(Addr(0x10001000).SanityCheck());
 
   // Invalid file type.
-  EXPECT_FALSE(Addr(0xD0001000).SanityCheck());
+  EXPECT_FALSE(Addr(0xF0001000).SanityCheck());
   EXPECT_FALSE(Addr(0xF0000000).SanityCheck());
 
-  // Reserved bits.
-  EXPECT_FALSE(Addr(0x14000000).SanityCheck());
-  EXPECT_FALSE(Addr(0x18000000).SanityCheck());
+  // The bits reserved by version 2.0 are now part of the block number.
+  EXPECT_TRUE(Addr(0xC4000000).SanityCheck());
+  EXPECT_TRUE(Addr(0xE8000000).SanityCheck());
 }
 
 }  // namespace disk_cache
@@ -359,6 +359,18 @@ int PreferedCacheSize(int64 available) {
   return kint32max;
 }
 
+int DefaultMaxCacheSize(int64 available) {
+  if (available < 0)
+    return kDefaultCacheSize;
+
+  // Let's not use more than the default size while we tune-up the performance
+  // of bigger caches. TODO(rvargas): remove this limit.
+  int max_size = PreferedCacheSize(available);
+  if (max_size > kDefaultCacheSize * 4)
+    max_size = kDefaultCacheSize * 4;
+  return max_size;
+}
+
 // ------------------------------------------------------------------------
 
 BackendImpl::BackendImpl(const FilePath& path,
@@ -568,7 +580,7 @@ int BackendImpl::OpenPrevEntry(void** iter, Entry** prev_entry,
 
 int BackendImpl::SyncOpenEntry(const std::string& key, Entry** entry) {
   DCHECK(entry);
-  *entry = OpenEntryImpl(key);
+  *entry = OpenEntryImpl(key, true);
   return (*entry) ? net::OK : net::ERR_FAILED;
 }
 
@@ -582,7 +594,7 @@ int BackendImpl::SyncDoomEntry(const std::string& key) {
   if (disabled_)
     return net::ERR_FAILED;
 
-  EntryImpl* entry = OpenEntryImpl(key);
+  EntryImpl* entry = OpenEntryImpl(key, false);
   if (!entry)
     return net::ERR_FAILED;
 
@@ -700,7 +712,8 @@ void BackendImpl::SyncOnExternalCacheHit(const std::string& key) {
   }
 }
 
-EntryImpl* BackendImpl::OpenEntryImpl(const std::string& key) {
+EntryImpl* BackendImpl::OpenEntryImpl(const std::string& key,
+                                      bool read_ahead) {
   if (disabled_)
     return NULL;
 
@@ -725,6 +738,16 @@ EntryImpl* BackendImpl::OpenEntryImpl(const std::string& key) {
   eviction_.OnOpenEntry(cache_entry);
   entry_count_++;
 
+  // The caller is most likely going to read the headers and then the body, so
+  // get them from disk now, with as few system calls as possible.
+  if (read_ahead) {
+    int num_reads = cache_entry->ReadAhead();
+    if (num_reads) {
+      stats_.SetCounter(Stats::OPEN_IO,
+                        stats_.GetCounter(Stats::OPEN_IO) + num_reads);
+    }
+  }
+
   CACHE_UMA(AGE_MS, "OpenTime", GetSizeGroup(), start);
   stats_.OnEvent(Stats::OPEN_HIT);
   SIMPLE_STATS_COUNTER("disk_cache.hit");
@@ -1189,6 +1212,10 @@ void BackendImpl::OnWrite(int32 bytes) {
   OnRead(bytes);
 }
 
+void BackendImpl::OnEntryIO(int num_calls, int bytes) {
+  stats_.OnEntryIO(num_calls, bytes);
+}
+
 void BackendImpl::OnStatsTimer() {
   stats_.OnEvent(Stats::TIMER);
   int64 time = stats_.GetCounter(Stats::TIMER);
@@ -1249,6 +1276,11 @@ void BackendImpl::SetNewEviction() {
   new_eviction_ = true;
 }
 
+void BackendImpl::SetAdaptiveEviction() {
+  user_flags_ |= kAdaptiveEviction;
+  SetNewEviction();
+}
+
 void BackendImpl::SetFlags(uint32 flags) {
   user_flags_ |= flags;
 }
@@ -1407,9 +1439,9 @@ bool BackendImpl::CreateBackingStore(disk_cache::File* file) {
   IndexHeader header;
   header.table_len = DesiredIndexTableLen(max_size_);
 
-  // We need file version 2.1 for the new eviction algorithm.
+  // We need file version 3.1 for the new eviction algorithm.
   if (new_eviction_)
-    header.version = 0x20001;
+    header.version = 0x30001;
 
   header.create_time = Time::Now().ToInternalValue();
 
@@ -1478,12 +1510,7 @@ void BackendImpl::AdjustMaxCacheSize(int table_len) {
   if (table_len)
     available += data_->header.num_bytes;
 
-  max_size_ = PreferedCacheSize(available);
-
-  // Let's not use more than the default size while we tune-up the performance
-  // of bigger caches. TODO(rvargas): remove this limit.
-  if (max_size_ > kDefaultCacheSize * 4)
-    max_size_ = kDefaultCacheSize * 4;
+  max_size_ = DefaultMaxCacheSize(available);
 
   if (!table_len)
     return;
@@ -1563,6 +1590,7 @@ int BackendImpl::NewEntry(Addr address, EntryImpl** entry) {
   TimeTicks start = TimeTicks::Now();
   if (!cache_entry->entry()->Load())
     return ERR_READ_FAILURE;
+  OnEntryIO(1, static_cast<int>(cache_entry->entry()->size()));
 
   if (IsLoaded()) {
     CACHE_UMA(AGE_MS, "LoadTime", GetSizeGroup(), start);
@@ -1575,6 +1603,7 @@ int BackendImpl::NewEntry(Addr address, EntryImpl** entry) {
 
   if (!cache_entry->LoadNodeAddress())
     return ERR_READ_FAILURE;
+  OnEntryIO(1, static_cast<int>(cache_entry->rankings()->size()));
 
   // Prevent overwriting the dirty flag on the destructor.
   cache_entry->SetDirtyFlag(GetCurrentEntryId());
@@ -2022,11 +2051,23 @@ void BackendImpl::ReportStats() {
     block_files_.ReportStats();
 }
 
-void BackendImpl::UpgradeTo2_1() {
-  // 2.1 is basically the same as 2.0, except that new fields are actually
+bool BackendImpl::UpgradeTo3_0() {
+  // 3.0 only changed the format of the block files, so 2.0 becomes 3.0 and 2.1
+  // becomes 3.1. The index is updated last, so that an interrupted upgrade is
+  // resumed on the next run.
+  if (!block_files_.UpgradeFromVersion2()) {
+    LOG(ERROR) << "Unable to upgrade the block files";
+    return false;
+  }
+  data_->header.version += 0x10000;
+  return true;
+}
+
+void BackendImpl::UpgradeTo3_1() {
+  // 3.1 is basically the same as 3.0, except that new fields are actually
   // updated by the new eviction algorithm.
-  DCHECK(0x20000 == data_->header.version);
-  data_->header.version = 0x20001;
+  DCHECK(0x30000 == data_->header.version);
+  data_->header.version = 0x30001;
   data_->header.lru.sizes[Rankings::NO_USE] = data_->header.num_entries;
 }
 
@@ -2039,16 +2080,24 @@ bool BackendImpl::CheckIndex() {
     return false;
   }
 
+  // Copying every block file would stall the initialization of the cache, so
+  // a 2.x cache is discarded (and recreated) unless this is the upgrade tool.
+  if ((user_flags_ & kUpgradeMode) && kIndexMagic == data_->header.magic &&
+      2 == data_->header.version >> 16) {
+    if (!UpgradeTo3_0())
+      return false;
+  }
+
   if (new_eviction_) {
-    // We support versions 2.0 and 2.1, upgrading 2.0 to 2.1.
+    // We support versions 3.0 and 3.1, upgrading 3.0 to 3.1.
     if (kIndexMagic != data_->header.magic ||
         kCurrentVersion >> 16 != data_->header.version >> 16) {
       LOG(ERROR) << "Invalid file version or magic";
       return false;
     }
     if (kCurrentVersion == data_->header.version) {
-      // We need file version 2.1 for the new eviction algorithm.
-      UpgradeTo2_1();
+      // We need file version 3.1 for the new eviction algorithm.
+      UpgradeTo3_1();
     }
   } else {
     if (kIndexMagic != data_->header.magic ||
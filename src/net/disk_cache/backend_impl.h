@@ -34,7 +34,8 @@ enum BackendFlags {
   kNewEviction = 1 << 4,        // Use of new eviction was specified.
   kNoRandom = 1 << 5,           // Don't add randomness to the behavior.
   kNoLoadProtection = 1 << 6,   // Don't act conservatively under load.
-  kNoBuffering = 1 << 7         // Disable extended IO buffering.
+  kNoBuffering = 1 << 7,        // Disable extended IO buffering.
+  kAdaptiveEviction = 1 << 8    // Use of adaptive eviction was specified.
 };
 
 // This class implements the Backend interface. An object of this
@@ -81,8 +82,10 @@ class NET_EXPORT_PRIVATE BackendImpl : public Backend {
   void SyncEndEnumeration(void* iter);
   void SyncOnExternalCacheHit(const std::string& key);
 
-  // Open or create an entry for the given |key| or |iter|.
-  EntryImpl* OpenEntryImpl(const std::string& key);
+  // Open or create an entry for the given |key| or |iter|. If |read_ahead| is
+  // true, the beginning of the data of the entry is read right away, for a
+  // caller that is going to read it.
+  EntryImpl* OpenEntryImpl(const std::string& key, bool read_ahead);
   EntryImpl* CreateEntryImpl(const std::string& key);
   EntryImpl* OpenNextEntryImpl(void** iter);
   EntryImpl* OpenPrevEntryImpl(void** iter);
@@ -147,9 +150,6 @@ class NET_EXPORT_PRIVATE BackendImpl : public Backend {
   // Returns the id being used on this run of the cache.
   int32 GetCurrentEntryId() const;
 
-  // Returns the maximum size for a file to reside on the cache.
-  int MaxFileSize() const;
-
   // A user data block is being created, extended or truncated.
   void ModifyStorageSize(int32 old_size, int32 new_size);
 
@@ -206,6 +206,10 @@ class NET_EXPORT_PRIVATE BackendImpl : public Backend {
   void OnRead(int bytes);
   void OnWrite(int bytes);
 
+  // Keeps track of the system calls issued to read or write entries (including
+  // metadata).
+  void OnEntryIO(int num_calls, int bytes);
+
   // Timer callback to calculate usage statistics.
   void OnStatsTimer();
 
@@ -222,6 +226,11 @@ class NET_EXPORT_PRIVATE BackendImpl : public Backend {
   // Sets the eviction algorithm to version 2.
   void SetNewEviction();
 
+  // Sets the eviction algorithm to version 2, with the adaptive selection of
+  // the list to evict from (see eviction.cc). The adaptive policy is not part
+  // of the field trial, so it is only used when set here.
+  void SetAdaptiveEviction();
+
   // Sets an explicit set of BackendFlags.
   void SetFlags(uint32 flags);
 
@@ -249,6 +258,7 @@ class NET_EXPORT_PRIVATE BackendImpl : public Backend {
 
   // Backend interface.
   virtual int32 GetEntryCount() const;
+  virtual int MaxFileSize() const;
   virtual int OpenEntry(const std::string& key, Entry** entry,
                         OldCompletionCallback* callback);
   virtual int CreateEntry(const std::string& key, Entry** entry,
@@ -326,8 +336,12 @@ class NET_EXPORT_PRIVATE BackendImpl : public Backend {
   // Send UMA stats.
   void ReportStats();
 
-  // Upgrades the index file to version 2.1.
-  void UpgradeTo2_1();
+  // Upgrades a cache created by version 2.x to version 3.x. Returns false on
+  // failure. Only the upgrade tool does this; other users discard the cache.
+  bool UpgradeTo3_0();
+
+  // Upgrades the index file to version 3.1.
+  void UpgradeTo3_1();
 
   // Performs basic checks on the index file. Returns false on failure.
   bool CheckIndex();
@@ -385,6 +399,10 @@ class NET_EXPORT_PRIVATE BackendImpl : public Backend {
 // Returns the prefered max cache size given the available disk space.
 NET_EXPORT_PRIVATE int PreferedCacheSize(int64 available);
 
+// Returns the max cache size to use when the user does not set one, given the
+// available disk space (negative if it is unknown).
+NET_EXPORT_PRIVATE int DefaultMaxCacheSize(int64 available);
+
 }  // namespace disk_cache
 
 #endif  // NET_DISK_CACHE_BACKEND_IMPL_H_
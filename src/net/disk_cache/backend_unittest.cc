@@ -532,6 +532,73 @@ TEST_F(DiskCacheBackendTest, NewEvictionTrim) {
   entry->Close();
 }
 
+// Tests that a burst of entries that are used only once does not evict the
+// entries that are reused.
+TEST_F(DiskCacheBackendTest, AdaptiveEvictionTrim) {
+  SetAdaptiveEviction();
+  SetDirectMode();
+  InitCache();
+
+  disk_cache::Entry* entry;
+  for (int i = 0; i < 20; i++) {
+    std::string name(StringPrintf("Hot %d", i));
+    ASSERT_EQ(net::OK, CreateEntry(name, &entry));
+    entry->Close();
+    ASSERT_EQ(net::OK, OpenEntry(name, &entry));
+    entry->Close();
+  }
+  for (int i = 0; i < 100; i++) {
+    ASSERT_EQ(net::OK, CreateEntry(StringPrintf("Scan %d", i), &entry));
+    entry->Close();
+  }
+
+  for (int i = 0; i < 50; i++)
+    TrimForTest(false);
+
+  for (int i = 0; i < 20; i++) {
+    ASSERT_EQ(net::OK, OpenEntry(StringPrintf("Hot %d", i), &entry));
+    entry->Close();
+  }
+  EXPECT_NE(net::OK, OpenEntry("Scan 49", &entry));
+  ASSERT_EQ(net::OK, OpenEntry("Scan 50", &entry));
+  entry->Close();
+}
+
+// Tests that the list to evict from adapts when evicted entries come back.
+TEST_F(DiskCacheBackendTest, AdaptiveEvictionTarget) {
+  SetAdaptiveEviction();
+  SetDirectMode();
+  InitCache();
+
+  disk_cache::Entry* entry;
+  for (int i = 0; i < 2; i++) {
+    std::string name(StringPrintf("Hot %d", i));
+    ASSERT_EQ(net::OK, CreateEntry(name, &entry));
+    entry->Close();
+    ASSERT_EQ(net::OK, OpenEntry(name, &entry));
+    entry->Close();
+  }
+  for (int i = 0; i < 2; i++) {
+    ASSERT_EQ(net::OK, CreateEntry(StringPrintf("Cold %d", i), &entry));
+    entry->Close();
+  }
+
+  // The first eviction comes from the entries that were not reused.
+  TrimForTest(false);
+  EXPECT_NE(net::OK, OpenEntry("Cold 0", &entry));
+
+  // Seeing the evicted entry again makes room for one entry that is not
+  // reused, so the next eviction comes from the other entries.
+  ASSERT_EQ(net::OK, CreateEntry("Cold 0", &entry));
+  entry->Close();
+  TrimForTest(false);
+  EXPECT_NE(net::OK, OpenEntry("Hot 0", &entry));
+  ASSERT_EQ(net::OK, OpenEntry("Cold 1", &entry));
+  entry->Close();
+  ASSERT_EQ(net::OK, OpenEntry("Hot 1", &entry));
+  entry->Close();
+}
+
 // Before looking for invalid entries, let's check a valid entry.
 void DiskCacheBackendTest::BackendValidEntry() {
   SetDirectMode();
@@ -1358,6 +1425,28 @@ TEST_F(DiskCacheTest, DeleteOld) {
   delete cache;
 }
 
+// Caches created with version 2.x of the file format are discarded instead of
+// upgraded in place.
+TEST_F(DiskCacheTest, DeleteVersion2) {
+  ASSERT_TRUE(CopyOldTestCache("remove_load1"));
+  FilePath path = GetCacheFilePath();
+  base::Thread cache_thread("CacheThread");
+  ASSERT_TRUE(cache_thread.StartWithOptions(
+                  base::Thread::Options(MessageLoop::TYPE_IO, 0)));
+  TestOldCompletionCallback cb;
+
+  disk_cache::Backend* cache;
+  int rv = disk_cache::BackendImpl::CreateBackend(
+               path, true, 0, net::DISK_CACHE, disk_cache::kNoRandom,
+               cache_thread.message_loop_proxy(), NULL, &cache, &cb);
+  ASSERT_EQ(net::OK, cb.GetResult(rv));
+
+  ASSERT_TRUE(NULL != cache);
+  ASSERT_EQ(0, cache->GetEntryCount());
+
+  delete cache;
+}
+
 // We want to be able to deal with messed up entries on disk.
 void DiskCacheBackendTest::BackendInvalidEntry2() {
   ASSERT_TRUE(CopyTestCache("bad_entry"));
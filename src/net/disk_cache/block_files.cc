@@ -4,6 +4,8 @@
 
 #include "net/disk_cache/block_files.h"
 
+#include <algorithm>
+
 #include "base/file_util.h"
 #include "base/metrics/histogram.h"
 #include "base/string_util.h"
@@ -31,6 +33,35 @@ inline int GetMapBlockType(uint8 value) {
   return s_types[value];
 }
 
+// Returns the maximum number of blocks that the file with the given |header|
+// can store. Files of big blocks are limited to 2 GB.
+int MaxBlocks(const disk_cache::BlockFileHeader* header) {
+  if (header->entry_size <= 0)
+    return 0;
+  int max_blocks = (kint32max - disk_cache::kBlockHeaderSize) /
+                   header->entry_size / 32 * 32;
+  return std::min(max_blocks, disk_cache::kMaxBlocks);
+}
+
+// Returns the type of block stored by the file with the given |header|.
+disk_cache::FileType GetFileType(const disk_cache::BlockFileHeader* header) {
+  for (int i = disk_cache::RANKINGS; i <= disk_cache::BLOCK_64K; i++) {
+    disk_cache::FileType type = static_cast<disk_cache::FileType>(i);
+    if (disk_cache::Addr::BlockSizeForFileType(type) == header->entry_size)
+      return type;
+  }
+  NOTREACHED();
+  return disk_cache::EXTERNAL;
+}
+
+// Returns the number of the first file of the chain of files that store blocks
+// of the given type.
+int HeadFileIndex(disk_cache::FileType file_type) {
+  if (file_type < disk_cache::BLOCK_16K)
+    return file_type - disk_cache::RANKINGS;
+  return disk_cache::kFirstBigBlockFile + file_type - disk_cache::BLOCK_16K;
+}
+
 void FixAllocationCounters(disk_cache::BlockFileHeader* header);
 
 // Creates a new entry on the allocation map, updating the apropriate counters.
@@ -173,7 +204,7 @@ bool NeedToGrowBlockFile(const disk_cache::BlockFileHeader* header,
       have_space = true;
   }
 
-  if (header->next_file && (empty_blocks < disk_cache::kMaxBlocks / 10)) {
+  if (header->next_file && (empty_blocks < MaxBlocks(header) / 10)) {
     // This file is almost full but we already created another one, don't use
     // this file yet so that it is easier to find empty blocks when we start
     // using this file again.
@@ -182,6 +213,49 @@ bool NeedToGrowBlockFile(const disk_cache::BlockFileHeader* header,
   return !have_space;
 }
 
+// Rewrites the block file |name|, created by version 2.x, with the bigger
+// header of the current version. |header| holds the contents of the old header.
+bool UpgradeBlockFile(const FilePath& name,
+                      disk_cache::BlockFileHeader* header) {
+  scoped_refptr<disk_cache::File> file(new disk_cache::File(
+      base::CreatePlatformFile(
+          name, base::PLATFORM_FILE_OPEN | base::PLATFORM_FILE_READ, NULL,
+          NULL)));
+  FilePath temp_name = name.InsertBeforeExtensionASCII("_tmp");
+  int flags = base::PLATFORM_FILE_CREATE_ALWAYS | base::PLATFORM_FILE_WRITE |
+              base::PLATFORM_FILE_EXCLUSIVE_WRITE;
+  scoped_refptr<disk_cache::File> temp_file(new disk_cache::File(
+      base::CreatePlatformFile(temp_name, flags, NULL, NULL)));
+  if (!file->IsValid() || !temp_file->IsValid())
+    return false;
+
+  // The allocation bitmap of the old header is the start of the new one, and
+  // the rest of the bitmap is already zeroed.
+  header->version = disk_cache::kCurrentVersion;
+  if (!temp_file->Write(header, sizeof(*header), 0))
+    return false;
+
+  const size_t kBufferSize = 64 * 1024;
+  scoped_array<char> buffer(new char[kBufferSize]);
+  size_t file_len = file->GetLength();
+  size_t offset = disk_cache::kBlockHeaderSizeV2;
+  while (offset < file_len) {
+    size_t len = std::min(kBufferSize, file_len - offset);
+    if (!file->Read(buffer.get(), len, offset) ||
+        !temp_file->Write(buffer.get(), len, offset -
+                          disk_cache::kBlockHeaderSizeV2 +
+                          disk_cache::kBlockHeaderSize)) {
+      return false;
+    }
+    offset += len;
+  }
+
+  // Close both files before replacing the old one.
+  file = NULL;
+  temp_file = NULL;
+  return file_util::ReplaceFile(temp_name, name);
+}
+
 }  // namespace
 
 namespace disk_cache {
@@ -204,22 +278,72 @@ bool BlockFiles::Init(bool create_files) {
   thread_checker_.reset(new base::ThreadChecker);
 
   block_files_.resize(kFirstAdditionalBlockFile);
-  for (int i = 0; i < kFirstAdditionalBlockFile; i++) {
+  for (int i = RANKINGS; i <= BLOCK_64K; i++) {
+    FileType file_type = static_cast<FileType>(i);
+    int index = HeadFileIndex(file_type);
     if (create_files)
-      if (!CreateBlockFile(i, static_cast<FileType>(i + 1), true))
+      if (!CreateBlockFile(index, file_type, true))
         return false;
 
-    if (!OpenBlockFile(i))
+    if (!OpenBlockFile(index))
       return false;
 
     // Walk this chain of files removing empty ones.
-    RemoveEmptyFile(static_cast<FileType>(i + 1));
+    RemoveEmptyFile(file_type);
   }
 
   init_ = true;
   return true;
 }
 
+bool BlockFiles::UpgradeFromVersion2() {
+  DCHECK(!init_);
+  for (int i = 0; i <= kMaxBlockFile; i++) {
+    FilePath name = Name(i);
+    if (!file_util::PathExists(name))
+      continue;
+
+    int flags = base::PLATFORM_FILE_OPEN | base::PLATFORM_FILE_READ;
+    scoped_refptr<File> file(new File(
+        base::CreatePlatformFile(name, flags, NULL, NULL)));
+    if (!file->IsValid())
+      return false;
+
+    scoped_ptr<BlockFileHeader> header(new BlockFileHeader);
+    bool ok = file->Read(header.get(), kBlockHeaderSizeV2, 0);
+    file = NULL;
+    if (!ok || header->magic != kBlockMagic) {
+      LOG(ERROR) << "Invalid block file " << name.value();
+      return false;
+    }
+
+    // A previous attempt may have converted this file already.
+    if (header->version == kCurrentVersion)
+      continue;
+
+    // The file numbers of the new block types must be free.
+    if (header->version >> 16 != 2 || i >= kFirstBigBlockFile) {
+      LOG(ERROR) << "Invalid file version " << name.value();
+      return false;
+    }
+
+    if (!UpgradeBlockFile(name, header.get())) {
+      LOG(ERROR) << "Unable to upgrade " << name.value();
+      return false;
+    }
+  }
+
+  for (int i = BLOCK_16K; i <= BLOCK_64K; i++) {
+    FileType file_type = static_cast<FileType>(i);
+    int index = HeadFileIndex(file_type);
+    if (!file_util::PathExists(Name(index)) &&
+        !CreateBlockFile(index, file_type, false)) {
+      return false;
+    }
+  }
+  return true;
+}
+
 MappedFile* BlockFiles::GetFile(Addr address) {
   DCHECK(thread_checker_->CalledOnValidThread());
   DCHECK(block_files_.size() >= 4);
@@ -241,7 +365,7 @@ MappedFile* BlockFiles::GetFile(Addr address) {
 bool BlockFiles::CreateBlock(FileType block_type, int block_count,
                              Addr* block_address) {
   DCHECK(thread_checker_->CalledOnValidThread());
-  if (block_type < RANKINGS || block_type > BLOCK_4K ||
+  if (block_type < RANKINGS || block_type > BLOCK_64K ||
       block_count < 1 || block_count > 4)
     return false;
   if (!init_)
@@ -278,8 +402,8 @@ void BlockFiles::DeleteBlock(Addr address, bool deep) {
     return;
 
   if (!zero_buffer_) {
-    zero_buffer_ = new char[Addr::BlockSizeForFileType(BLOCK_4K) * 4];
-    memset(zero_buffer_, 0, Addr::BlockSizeForFileType(BLOCK_4K) * 4);
+    zero_buffer_ = new char[kMaxBlockSize];
+    memset(zero_buffer_, 0, kMaxBlockSize);
   }
   MappedFile* file = GetFile(address);
   if (!file)
@@ -298,10 +422,7 @@ void BlockFiles::DeleteBlock(Addr address, bool deep) {
 
   if (!header->num_entries) {
     // This file is now empty. Let's try to delete it.
-    FileType type = Addr::RequiredFileType(header->entry_size);
-    if (Addr::BlockSizeForFileType(RANKINGS) == header->entry_size)
-      type = RANKINGS;
-    RemoveEmptyFile(type);
+    RemoveEmptyFile(GetFileType(header));
   }
 }
 
@@ -355,7 +476,7 @@ bool BlockFiles::IsValid(Addr address) {
   static bool read_contents = false;
   if (read_contents) {
     scoped_array<char> buffer;
-    buffer.reset(new char[Addr::BlockSizeForFileType(BLOCK_4K) * 4]);
+    buffer.reset(new char[kMaxBlockSize]);
     size_t size = address.BlockSize() * address.num_blocks();
     size_t offset = address.start_block() * address.BlockSize() +
                     kBlockHeaderSize;
@@ -438,13 +559,14 @@ bool BlockFiles::OpenBlockFile(int index) {
 }
 
 bool BlockFiles::GrowBlockFile(MappedFile* file, BlockFileHeader* header) {
-  if (kMaxBlocks == header->max_entries)
+  int max_blocks = MaxBlocks(header);
+  if (max_blocks <= header->max_entries)
     return false;
 
   DCHECK(!header->empty[3]);
   int new_size = header->max_entries + 1024;
-  if (new_size > kMaxBlocks)
-    new_size = kMaxBlocks;
+  if (new_size > max_blocks)
+    new_size = max_blocks;
 
   int new_size_bytes = new_size * header->entry_size + sizeof(*header);
 
@@ -468,12 +590,12 @@ bool BlockFiles::GrowBlockFile(MappedFile* file, BlockFileHeader* header) {
 
 MappedFile* BlockFiles::FileForNewBlock(FileType block_type, int block_count) {
   COMPILE_ASSERT(RANKINGS == 1, invalid_fily_type);
-  MappedFile* file = block_files_[block_type - 1];
+  MappedFile* file = block_files_[HeadFileIndex(block_type)];
   BlockFileHeader* header = reinterpret_cast<BlockFileHeader*>(file->buffer());
 
   TimeTicks start = TimeTicks::Now();
   while (NeedToGrowBlockFile(header, block_count)) {
-    if (kMaxBlocks == header->max_entries) {
+    if (MaxBlocks(header) <= header->max_entries) {
       file = NextFile(file);
       if (!file)
         return NULL;
@@ -493,13 +615,7 @@ MappedFile* BlockFiles::NextFile(const MappedFile* file) {
   BlockFileHeader* header = reinterpret_cast<BlockFileHeader*>(file->buffer());
   int new_file = header->next_file;
   if (!new_file) {
-    // RANKINGS is not reported as a type for small entries, but we may be
-    // extending the rankings block file.
-    FileType type = Addr::RequiredFileType(header->entry_size);
-    if (header->entry_size == Addr::BlockSizeForFileType(RANKINGS))
-      type = RANKINGS;
-
-    new_file = CreateNextBlockFile(type);
+    new_file = CreateNextBlockFile(GetFileType(header));
     if (!new_file)
       return NULL;
 
@@ -513,7 +629,7 @@ MappedFile* BlockFiles::NextFile(const MappedFile* file) {
 }
 
 int BlockFiles::CreateNextBlockFile(FileType block_type) {
-  for (int i = kFirstAdditionalBlockFile; i <= kMaxBlockFile; i++) {
+  for (int i = kFirstAdditionalBlockFile; i <= kLastAdditionalBlockFile; i++) {
     if (CreateBlockFile(i, block_type, false))
       return i;
   }
@@ -523,7 +639,7 @@ int BlockFiles::CreateNextBlockFile(FileType block_type) {
 // We walk the list of files for this particular block type, deleting the ones
 // that are empty.
 void BlockFiles::RemoveEmptyFile(FileType block_type) {
-  MappedFile* file = block_files_[block_type - 1];
+  MappedFile* file = block_files_[HeadFileIndex(block_type)];
   BlockFileHeader* header = reinterpret_cast<BlockFileHeader*>(file->buffer());
 
   while (header->next_file) {
@@ -570,7 +686,8 @@ bool BlockFiles::FixBlockFileHeader(MappedFile* file) {
 
   int expected = header->entry_size * header->max_entries + sizeof(*header);
   if (file_size != expected) {
-    int max_expected = header->entry_size * kMaxBlocks + sizeof(*header);
+    int max_expected = header->entry_size * MaxBlocks(header) +
+                       sizeof(*header);
     if (file_size < expected || header->empty[3] || file_size > max_expected) {
       NOTREACHED();
       LOG(ERROR) << "Unexpected file size";
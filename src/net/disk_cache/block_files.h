@@ -33,6 +33,11 @@ class NET_EXPORT_PRIVATE BlockFiles {
   // files should be created or just open.
   bool Init(bool create_files);
 
+  // Converts the block files of a cache created by version 2.x to the current
+  // format, in place, and creates the files for the block types added by
+  // version 3.0. It must be called before Init().
+  bool UpgradeFromVersion2();
+
   // Returns the file that stores a given address.
   MappedFile* GetFile(Addr address);
 
@@ -96,6 +101,7 @@ class NET_EXPORT_PRIVATE BlockFiles {
   FRIEND_TEST_ALL_PREFIXES(DiskCacheTest, BlockFiles_TruncatedFile);
   FRIEND_TEST_ALL_PREFIXES(DiskCacheTest, BlockFiles_InvalidFile);
   FRIEND_TEST_ALL_PREFIXES(DiskCacheTest, BlockFiles_Stats);
+  FRIEND_TEST_ALL_PREFIXES(DiskCacheTest, BlockFiles_Upgrade);
 
   DISALLOW_COPY_AND_ASSIGN(BlockFiles);
 };
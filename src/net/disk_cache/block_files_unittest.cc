@@ -2,6 +2,8 @@
 // Use of this source code is governed by a BSD-style license that can be
 // found in the LICENSE file.
 
+#include <vector>
+
 #include "base/file_util.h"
 #include "net/disk_cache/block_files.h"
 #include "net/disk_cache/disk_cache.h"
@@ -35,14 +37,14 @@ TEST_F(DiskCacheTest, BlockFiles_Grow) {
   BlockFiles files(path);
   ASSERT_TRUE(files.Init(true));
 
-  const int kMaxSize = 35000;
-  Addr address[kMaxSize];
+  const int kMaxSize = 140000;
+  std::vector<Addr> address(kMaxSize);
 
   // Fill up the 32-byte block file (use three files).
   for (int i = 0; i < kMaxSize; i++) {
     EXPECT_TRUE(files.CreateBlock(RANKINGS, 4, &address[i]));
   }
-  EXPECT_EQ(6, NumberOfFiles(path));
+  EXPECT_EQ(8, NumberOfFiles(path));
 
   // Make sure we don't keep adding files.
   for (int i = 0; i < kMaxSize * 4; i += 2) {
@@ -50,7 +52,7 @@ TEST_F(DiskCacheTest, BlockFiles_Grow) {
     files.DeleteBlock(address[target], false);
     EXPECT_TRUE(files.CreateBlock(RANKINGS, 4, &address[target]));
   }
-  EXPECT_EQ(6, NumberOfFiles(path));
+  EXPECT_EQ(8, NumberOfFiles(path));
 }
 
 // We should be able to delete empty block files.
@@ -62,8 +64,8 @@ TEST_F(DiskCacheTest, BlockFiles_Shrink) {
   BlockFiles files(path);
   ASSERT_TRUE(files.Init(true));
 
-  const int kMaxSize = 35000;
-  Addr address[kMaxSize];
+  const int kMaxSize = 140000;
+  std::vector<Addr> address(kMaxSize);
 
   // Fill up the 32-byte block file (use three files).
   for (int i = 0; i < kMaxSize; i++) {
@@ -74,7 +76,7 @@ TEST_F(DiskCacheTest, BlockFiles_Shrink) {
   for (int i = 0; i < kMaxSize; i++) {
     files.DeleteBlock(address[i], false);
   }
-  EXPECT_EQ(4, NumberOfFiles(path));
+  EXPECT_EQ(6, NumberOfFiles(path));
 }
 
 // Handling of block files not properly closed.
@@ -249,6 +251,39 @@ TEST_F(DiskCacheTest, BlockFiles_Stats) {
   EXPECT_EQ(0, load);
 }
 
+// Tests that the block files of an old cache are converted to the current
+// format without losing their contents.
+TEST_F(DiskCacheTest, BlockFiles_Upgrade) {
+  ASSERT_TRUE(CopyOldTestCache("remove_load1"));
+  FilePath path = GetCacheFilePath();
+
+  BlockFiles files(path);
+  FilePath filename = files.Name(1);
+  std::string old_contents;
+  ASSERT_TRUE(file_util::ReadFileToString(filename, &old_contents));
+  ASSERT_FALSE(files.Init(false));
+  files.CloseFiles();
+
+  ASSERT_TRUE(files.UpgradeFromVersion2());
+  std::string new_contents;
+  ASSERT_TRUE(file_util::ReadFileToString(filename, &new_contents));
+  EXPECT_EQ(old_contents.substr(kBlockHeaderSizeV2),
+            new_contents.substr(kBlockHeaderSize));
+
+  // An upgraded cache is left alone.
+  ASSERT_TRUE(files.UpgradeFromVersion2());
+  EXPECT_TRUE(file_util::PathExists(files.Name(kFirstBigBlockFile)));
+  ASSERT_TRUE(files.Init(false));
+
+  const BlockFileHeader* header = reinterpret_cast<BlockFileHeader*>(
+      files.GetFile(Addr(BLOCK_256, 1, 1, 0))->buffer());
+  EXPECT_EQ(kCurrentVersion, header->version);
+
+  Addr address;
+  EXPECT_TRUE(files.CreateBlock(BLOCK_64K, 4, &address));
+  EXPECT_EQ(kMaxBlockFile, address.FileNumber());
+}
+
 // Tests that we add and remove blocks correctly.
 TEST_F(DiskCacheTest, AllocationMap) {
   FilePath path = GetCacheFilePath();
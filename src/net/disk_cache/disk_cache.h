@@ -13,6 +13,7 @@
 #include <vector>
 
 #include "base/basictypes.h"
+#include "base/memory/ref_counted.h"
 #include "base/time.h"
 #include "net/base/cache_type.h"
 #include "net/base/completion_callback.h"
@@ -56,6 +57,20 @@ NET_EXPORT int CreateCacheBackend(net::CacheType type, const FilePath& path,
                                   net::NetLog* net_log, Backend** backend,
                                   OldCompletionCallback* callback);
 
+// Returns an instance of a Backend that splits the cache stored under |path|
+// among |num_shards| independent sets of files, each one of them managed from
+// its own dedicated thread, so that operations on different entries can run
+// in parallel. The threads are owned by the returned object. |num_shards|
+// should be kept the same for a given |path| between runs. |max_bytes| is the
+// maximum size of the whole cache. If |type| is MEMORY_CACHE, this is the same
+// as CreateCacheBackend(). See CreateCacheBackend() for the other arguments.
+NET_EXPORT int CreateShardedCacheBackend(net::CacheType type,
+                                         const FilePath& path, int max_bytes,
+                                         bool force, int num_shards,
+                                         net::NetLog* net_log,
+                                         Backend** backend,
+                                         OldCompletionCallback* callback);
+
 // The root interface for a disk cache instance.
 class NET_EXPORT Backend {
  public:
@@ -70,6 +85,10 @@ class NET_EXPORT Backend {
   // Returns the number of entries in the cache.
   virtual int32 GetEntryCount() const = 0;
 
+  // Returns the maximum size of the data stream of an entry. Writes that would
+  // make a stream larger than that fail.
+  virtual int MaxFileSize() const = 0;
+
   // Opens an existing entry. Upon success, |entry| holds a pointer to an Entry
   // object representing the specified disk cache entry. When the entry pointer
   // is no longer needed, its Close method should be called. The return value is
@@ -180,6 +199,21 @@ class NET_EXPORT Entry {
   virtual int ReadData(int index, int offset, net::IOBuffer* buf, int buf_len,
                        OldCompletionCallback* completion_callback) = 0;
 
+  // Provides direct access to up to |buf_len| bytes of the cache data with the
+  // given index, starting at |offset|, without copying them. On success, |buf|
+  // receives a read-only buffer that points to the stored data and the return
+  // value is the number of bytes available on that buffer. If the data cannot
+  // be accessed this way (for instance because it is not stored on disk yet),
+  // this method returns ERR_CACHE_OPERATION_NOT_SUPPORTED and ReadData should
+  // be used instead. If completion_callback is null, this call blocks until
+  // the operation is complete. Otherwise, |buf| must remain valid until the
+  // callback is invoked. The stored data is not evicted or reused while the
+  // returned buffer is alive, even if this entry is closed or doomed, but new
+  // writes to the same stream may be visible through the buffer.
+  virtual int MapData(int index, int offset, int buf_len,
+                      scoped_refptr<net::IOBuffer>* buf,
+                      OldCompletionCallback* completion_callback) = 0;
+
   // Copies cache data from the given buffer of length |buf_len|.  If
   // completion_callback is null, then this call blocks until the write
   // operation is complete.  Otherwise, completion_callback will be
@@ -2,13 +2,17 @@
 // Use of this source code is governed by a BSD-style license that can be
 // found in the LICENSE file.
 
+#include <algorithm>
 #include <string>
+#include <vector>
 
 #include "base/basictypes.h"
 #include "base/file_path.h"
 #include "base/file_util.h"
+#include "base/memory/scoped_vector.h"
 #include "base/perftimer.h"
 #include "base/string_util.h"
+#include "base/stringprintf.h"
 #include "base/threading/thread.h"
 #include "base/test/test_file_util.h"
 #include "base/timer.h"
@@ -136,6 +140,183 @@ int BlockSize() {
   return (rand() & 0x3) + 1;
 }
 
+const int kNumLoadEntries = 5000;
+const int kLoadDataSize = 4096;
+const int kMaxInFlight = 64;
+
+// Writes or reads a set of entries keeping up to kMaxInFlight of them in
+// progress at the same time, the way a busy network stack would, so that the
+// cache threads always have work queued.
+class LoadGenerator {
+ public:
+  LoadGenerator(disk_cache::Backend* cache, bool write,
+                const std::vector<std::string>& keys)
+      : cache_(cache), write_(write), keys_(keys),
+        buffer_(new net::IOBuffer(kLoadDataSize)), next_key_(0),
+        in_flight_(0), failures_(0) {
+    CacheTestFillBuffer(buffer_->data(), kLoadDataSize, false);
+  }
+
+  // Runs the message loop until all the entries are done, and returns the
+  // number of entries that could not be written or read.
+  int Run() {
+    for (int i = 0; i < kMaxInFlight; i++)
+      transactions_.push_back(new Transaction(this));
+    for (size_t i = 0; i < transactions_.size(); i++)
+      StartNext(transactions_[i]);
+    if (in_flight_)
+      MessageLoop::current()->Run();
+    return failures_;
+  }
+
+ private:
+  // Creates and writes one entry, or opens and reads it, and closes it.
+  class Transaction {
+   public:
+    explicit Transaction(LoadGenerator* generator)
+        : generator_(generator), entry_(NULL), opened_(false),
+          ALLOW_THIS_IN_INITIALIZER_LIST(
+              callback_(this, &Transaction::OnIOComplete)) {
+    }
+
+    void Start(const std::string& key) {
+      opened_ = false;
+      int rv = generator_->write_ ?
+          generator_->cache_->CreateEntry(key, &entry_, &callback_) :
+          generator_->cache_->OpenEntry(key, &entry_, &callback_);
+      if (rv != net::ERR_IO_PENDING)
+        OnIOComplete(rv);
+    }
+
+   private:
+    void OnIOComplete(int result) {
+      if (!opened_ && result == net::OK) {
+        opened_ = true;
+        net::IOBuffer* buffer = generator_->buffer_;
+        int rv = generator_->write_ ?
+            entry_->WriteData(1, 0, buffer, kLoadDataSize, &callback_, false) :
+            entry_->ReadData(1, 0, buffer, kLoadDataSize, &callback_);
+        if (rv != net::ERR_IO_PENDING)
+          OnIOComplete(rv);
+        return;
+      }
+      if (opened_)
+        entry_->Close();
+      generator_->OnTransactionDone(this, result == kLoadDataSize);
+    }
+
+    LoadGenerator* generator_;
+    disk_cache::Entry* entry_;
+    bool opened_;
+    net::OldCompletionCallbackImpl<Transaction> callback_;
+
+    DISALLOW_COPY_AND_ASSIGN(Transaction);
+  };
+
+  void StartNext(Transaction* transaction) {
+    if (next_key_ == keys_.size())
+      return;
+    in_flight_++;
+    transaction->Start(keys_[next_key_++]);
+  }
+
+  void OnTransactionDone(Transaction* transaction, bool success) {
+    if (!success)
+      failures_++;
+    in_flight_--;
+    StartNext(transaction);
+    if (!in_flight_)
+      MessageLoop::current()->Quit();
+  }
+
+  disk_cache::Backend* cache_;
+  bool write_;
+  const std::vector<std::string>& keys_;
+  scoped_refptr<net::IOBuffer> buffer_;
+  ScopedVector<Transaction> transactions_;
+  size_t next_key_;
+  int in_flight_;
+  int failures_;
+
+  DISALLOW_COPY_AND_ASSIGN(LoadGenerator);
+};
+
+// Measures the number of entries per second that a cache with |num_shards|
+// shards can write and then read back.
+void TimeShardedCache(int num_shards) {
+  ScopedTestCache test_cache;
+  TestOldCompletionCallback cb;
+  disk_cache::Backend* cache;
+  int rv = disk_cache::CreateShardedCacheBackend(
+               net::DISK_CACHE, test_cache.path(), 0, false, num_shards, NULL,
+               &cache, &cb);
+  ASSERT_EQ(net::OK, cb.GetResult(rv));
+
+  std::vector<std::string> keys;
+  for (int i = 0; i < kNumLoadEntries; i++)
+    keys.push_back(GenerateKey(true));
+
+  const char* const kPhases[] = { "write", "read" };
+  for (int phase = 0; phase < 2; phase++) {
+    LoadGenerator generator(cache, phase == 0, keys);
+    PerfTimer timer;
+    EXPECT_EQ(0, generator.Run());
+    double seconds = timer.Elapsed().InSecondsF();
+    LogPerfResult(base::StringPrintf("sharded_cache_%s_%d_shards",
+                                     kPhases[phase], num_shards).c_str(),
+                  kNumLoadEntries / seconds, "ops/s");
+  }
+
+  MessageLoop::current()->RunAllPending();
+  delete cache;
+}
+
+const int kHitReadSize = 32 * 1024;
+const int kHitBytes = 64 * 1024 * 1024;
+
+// Reads the body of the entry stored under |key| |num_hits| times, the way the
+// HTTP cache serves a hit: one kHitReadSize chunk at a time. If |mapped| is
+// true the body is mapped once per hit and the chunks are copied from it.
+// Returns the number of bytes read.
+int64 TimeCacheHits(disk_cache::Backend* cache, const std::string& key,
+                    int body_size, int num_hits, bool mapped) {
+  scoped_refptr<net::IOBuffer> buffer(new net::IOBuffer(kHitReadSize));
+  TestOldCompletionCallback cb;
+  int64 total = 0;
+  for (int i = 0; i < num_hits; i++) {
+    disk_cache::Entry* entry;
+    int rv = cache->OpenEntry(key, &entry, &cb);
+    if (cb.GetResult(rv) != net::OK)
+      return 0;
+
+    scoped_refptr<net::IOBuffer> body;
+    if (mapped) {
+      rv = entry->MapData(1, 0, body_size, &body, &cb);
+      if (cb.GetResult(rv) != body_size) {
+        entry->Close();
+        return 0;
+      }
+    }
+    for (int offset = 0; offset < body_size;) {
+      int bytes;
+      if (mapped) {
+        bytes = std::min(kHitReadSize, body_size - offset);
+        memcpy(buffer->data(), body->data() + offset, bytes);
+      } else {
+        rv = entry->ReadData(1, offset, buffer, kHitReadSize, &cb);
+        bytes = cb.GetResult(rv);
+        if (bytes <= 0)
+          break;
+      }
+      offset += bytes;
+      total += bytes;
+    }
+    body = NULL;
+    entry->Close();
+  }
+  return total;
+}
+
 }  // namespace
 
 TEST_F(DiskCacheTest, Hash) {
@@ -201,6 +382,66 @@ TEST_F(DiskCacheTest, CacheBackendPerformance) {
   delete cache;
 }
 
+// Shows how the throughput of the cache scales with the number of shards when
+// many requests are in flight.
+TEST_F(DiskCacheTest, ShardedBackendPerformance) {
+  MessageLoopForIO message_loop;
+
+  int seed = static_cast<int>(Time::Now().ToInternalValue());
+  srand(seed);
+
+  for (int num_shards = 1; num_shards <= 8; num_shards *= 2)
+    TimeShardedCache(num_shards);
+}
+
+// Measures the throughput of cache hits for bodies between 1 KB and 1 MB, when
+// the data is copied with ReadData and when it is mapped with MapData.
+TEST_F(DiskCacheTest, CacheHitPerformance) {
+  MessageLoopForIO message_loop;
+
+  base::Thread cache_thread("CacheThread");
+  ASSERT_TRUE(cache_thread.StartWithOptions(
+                  base::Thread::Options(MessageLoop::TYPE_IO, 0)));
+
+  ScopedTestCache test_cache;
+  TestOldCompletionCallback cb;
+  disk_cache::Backend* cache;
+  int rv = disk_cache::CreateCacheBackend(
+               net::DISK_CACHE, test_cache.path(), 0, false,
+               cache_thread.message_loop_proxy(), NULL, &cache, &cb);
+  ASSERT_EQ(net::OK, cb.GetResult(rv));
+
+  for (int body_size = 1024; body_size <= 1024 * 1024; body_size *= 4) {
+    std::string key = base::StringPrintf("hit %d", body_size);
+    disk_cache::Entry* entry;
+    rv = cache->CreateEntry(key, &entry, &cb);
+    ASSERT_EQ(net::OK, cb.GetResult(rv));
+    scoped_refptr<net::IOBuffer> body(new net::IOBuffer(body_size));
+    CacheTestFillBuffer(body->data(), body_size, false);
+    rv = entry->WriteData(1, 0, body, body_size, &cb, false);
+    ASSERT_EQ(body_size, cb.GetResult(rv));
+    entry->Close();
+
+    // Warm up the entry so that both runs find it in the same state.
+    int num_hits = std::max(kHitBytes / body_size, 16);
+    ASSERT_EQ(body_size, TimeCacheHits(cache, key, body_size, 1, false));
+
+    const char* const kModes[] = { "read", "mapped" };
+    for (int mapped = 0; mapped < 2; mapped++) {
+      PerfTimer timer;
+      int64 bytes = TimeCacheHits(cache, key, body_size, num_hits, mapped != 0);
+      double seconds = timer.Elapsed().InSecondsF();
+      EXPECT_EQ(static_cast<int64>(body_size) * num_hits, bytes);
+      LogPerfResult(base::StringPrintf("cache_hit_%s_%dK", kModes[mapped],
+                                       body_size / 1024).c_str(),
+                    bytes / seconds / (1024 * 1024), "MB/s");
+    }
+  }
+
+  MessageLoop::current()->RunAllPending();
+  delete cache;
+}
+
 // Creating and deleting "entries" on a block-file is something quite frequent
 // (after all, almost everything is stored on block files). The operation is
 // almost free when the file is empty, but can be expensive if the file gets
@@ -26,6 +26,7 @@ DiskCacheTestWithCache::DiskCacheTestWithCache()
       implementation_(false),
       force_creation_(false),
       new_eviction_(false),
+      adaptive_eviction_(false),
       first_cleanup_(true),
       integrity_(true),
       use_current_thread_(false),
@@ -275,7 +276,9 @@ void DiskCacheTestWithCache::InitDiskCacheImpl(const FilePath& path) {
   if (size_)
     EXPECT_TRUE(cache_impl_->SetMaxSize(size_));
 
-  if (new_eviction_)
+  if (adaptive_eviction_)
+    cache_impl_->SetAdaptiveEviction();
+  else if (new_eviction_)
     cache_impl_->SetNewEviction();
 
   cache_impl_->SetType(type_);
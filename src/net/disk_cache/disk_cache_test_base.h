@@ -71,6 +71,11 @@ class DiskCacheTestWithCache : public DiskCacheTest {
     new_eviction_ = true;
   }
 
+  void SetAdaptiveEviction() {
+    new_eviction_ = true;
+    adaptive_eviction_ = true;
+  }
+
   void DisableFirstCleanup() {
     first_cleanup_ = false;
   }
@@ -131,6 +136,7 @@ class DiskCacheTestWithCache : public DiskCacheTest {
   bool implementation_;
   bool force_creation_;
   bool new_eviction_;
+  bool adaptive_eviction_;
   bool first_cleanup_;
   bool integrity_;
   bool use_current_thread_;
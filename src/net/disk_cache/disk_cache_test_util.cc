@@ -10,7 +10,9 @@
 #include "base/path_service.h"
 #include "net/base/net_errors.h"
 #include "net/disk_cache/backend_impl.h"
+#include "net/disk_cache/block_files.h"
 #include "net/disk_cache/cache_util.h"
+#include "net/disk_cache/disk_format.h"
 #include "net/disk_cache/file.h"
 
 using base::Time;
@@ -78,7 +80,7 @@ bool DeleteCache(const FilePath& path) {
   return true;
 }
 
-bool CopyTestCache(const std::string& name) {
+bool CopyOldTestCache(const std::string& name) {
   FilePath path;
   PathService::Get(base::DIR_SOURCE_ROOT, &path);
   path = path.AppendASCII("net");
@@ -92,6 +94,28 @@ bool CopyTestCache(const std::string& name) {
   return file_util::CopyDirectory(path, dest, false);
 }
 
+bool CopyTestCache(const std::string& name) {
+  if (!CopyOldTestCache(name))
+    return false;
+
+  // The test caches were created with version 2.x of the file format, and the
+  // backend only upgrades them in place in upgrade mode.
+  FilePath dest = GetCacheFilePath();
+  scoped_refptr<disk_cache::File> index(new disk_cache::File(false));
+  disk_cache::IndexHeader header;
+  if (!index->Init(dest.AppendASCII("index")) ||
+      !index->Read(&header, sizeof(header), 0) ||
+      header.magic != disk_cache::kIndexMagic || header.version >> 16 != 2) {
+    return true;
+  }
+
+  disk_cache::BlockFiles block_files(dest);
+  if (!block_files.UpgradeFromVersion2())
+    return false;
+  header.version += 0x10000;
+  return index->Write(&header, sizeof(header), 0);
+}
+
 bool CheckCacheIntegrity(const FilePath& path, bool new_eviction) {
   scoped_ptr<disk_cache::BackendImpl> cache(new disk_cache::BackendImpl(
       path, base::MessageLoopProxy::current(), NULL));
@@ -24,6 +24,10 @@ bool DeleteCache(const FilePath& path);
 // Copies a set of cache files from the data folder to the test folder.
 bool CopyTestCache(const std::string& name);
 
+// Same as CopyTestCache(), but the files are left in the format they have on
+// the data folder (version 2.x).
+bool CopyOldTestCache(const std::string& name);
+
 // Gets the path to the cache test folder.
 FilePath GetCacheFilePath();
 
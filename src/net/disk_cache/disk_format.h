@@ -17,20 +17,21 @@
 // The last element of the cache is the block-file. A block file is a file
 // designed to store blocks of data of a given size. It is able to store data
 // that spans from one to four consecutive "blocks", and it grows as needed to
-// store up to approximately 65000 blocks. It has a fixed size header used for
-// book keeping such as tracking free of blocks on the file. For example, a
-// block-file for 1KB blocks will grow from 8KB when totally empty to about 64MB
-// when completely full. At that point, data blocks of 1KB will be stored on a
-// second block file that will store the next set of 65000 blocks. The first
-// file contains the number of the second file, and the second file contains the
-// number of a third file, created when the second file reaches its limit. It is
-// important to remember that no matter how long the chain of files is, any
-// given block can be located directly by its address, which contains the file
-// number and starting block inside the file.
+// store up to approximately 260000 blocks (or 2 GB). It has a fixed size header
+// used for book keeping such as tracking free of blocks on the file. For
+// example, a block-file for 1KB blocks will grow from 32KB when totally empty
+// to about 255MB when completely full. At that point, data blocks of 1KB will
+// be stored on a second block file that will store the next set of blocks. The
+// first file contains the number of the second file, and the second file
+// contains the number of a third file, created when the second file reaches its
+// limit. It is important to remember that no matter how long the chain of files
+// is, any given block can be located directly by its address, which contains
+// the file number and starting block inside the file.
 //
-// A new cache is initialized with four block files (named data_0 through
-// data_3), each one dedicated to store blocks of a given size. The number at
-// the end of the file name is the block file number (in decimal).
+// A new cache is initialized with six block files (named data_0 through
+// data_3, data_254 and data_255), each one dedicated to store blocks of a given
+// size. The number at the end of the file name is the block file number (in
+// decimal).
 //
 // There are two "special" types of blocks: an entry and a rankings node. An
 // entry keeps track of all the information related to the same cache entry,
@@ -65,7 +66,7 @@ typedef uint32 CacheAddr;
 
 const int kIndexTablesize = 0x10000;
 const uint32 kIndexMagic = 0xC103CAC3;
-const uint32 kCurrentVersion = 0x20000;  // Version 2.0.
+const uint32 kCurrentVersion = 0x30000;  // Version 3.0.
 
 struct LruData {
   int32     pad1[2];
@@ -76,7 +77,9 @@ struct LruData {
   CacheAddr transaction;     // In-flight operation target.
   int32     operation;       // Actual in-flight operation.
   int32     operation_list;  // In-flight operation list.
-  int32     pad2[7];
+  int32     target_no_use;   // Adaptive eviction: target size of NO_USE.
+  int32     evicted[2];      // Evicted from NO_USE and from the other lists.
+  int32     pad2[4];
 };
 
 // Header for the master index file.
@@ -160,9 +163,12 @@ struct RankingsNode {
 COMPILE_ASSERT(sizeof(RankingsNode) == 36, bad_RankingsNode);
 
 const uint32 kBlockMagic = 0xC104CAC3;
-const int kBlockHeaderSize = 8192;  // Two pages: almost 64k entries
+const int kBlockHeaderSize = 32768;  // Eight pages: almost 256k entries
 const int kMaxBlocks = (kBlockHeaderSize - 80) * 8;
 
+// The size of the header of a block-file before version 3.0.
+const int kBlockHeaderSizeV2 = 8192;
+
 // Bitmap to track used blocks on a block-file.
 typedef uint32 AllocBitmap[kMaxBlocks / 32];
 
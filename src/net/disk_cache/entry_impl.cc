@@ -4,7 +4,9 @@
 
 #include "net/disk_cache/entry_impl.h"
 
+#include "base/bind.h"
 #include "base/message_loop.h"
+#include "base/message_loop_proxy.h"
 #include "base/metrics/histogram.h"
 #include "base/string_util.h"
 #include "net/base/io_buffer.h"
@@ -77,26 +79,89 @@ void SyncCallback::Discard() {
   OnFileIOComplete(0);
 }
 
+// Releases the reference that a MappedDataBuffer holds on |entry|. Runs on the
+// cache thread. If the backend is already gone the entry has been abandoned,
+// so there is nobody left to release it to.
+void ReleaseMappedEntry(base::WeakPtr<disk_cache::BackendImpl> backend,
+                        disk_cache::EntryImpl* entry) {
+  if (backend)
+    entry->Release();
+}
+
+// An IOBuffer that points to a region of a cache file mapped in memory. The
+// buffer keeps a reference to the entry that owns the data, so that the data
+// is not deleted or reused for another entry while the buffer is alive. It may
+// be destroyed on any thread.
+class MappedDataBuffer : public net::WrappedIOBuffer {
+ public:
+  MappedDataBuffer(char* data, int size, disk_cache::EntryImpl* entry,
+                   disk_cache::BackendImpl* backend)
+      : net::WrappedIOBuffer(data),
+        size_(size),
+        entry_(entry),
+        backend_(backend->GetWeakPtr()),
+        cache_thread_(backend->background_queue()->background_thread()) {
+    entry->AddRef();
+  }
+
+ private:
+  virtual ~MappedDataBuffer() {
+    disk_cache::File::UnmapRegion(data_, size_);
+    cache_thread_->PostTask(FROM_HERE, base::Bind(&ReleaseMappedEntry, backend_,
+                                                  base::Unretained(entry_)));
+  }
+
+  int size_;
+  disk_cache::EntryImpl* entry_;
+  base::WeakPtr<disk_cache::BackendImpl> backend_;
+  scoped_refptr<base::MessageLoopProxy> cache_thread_;
+
+  DISALLOW_COPY_AND_ASSIGN(MappedDataBuffer);
+};
+
 const int kMaxBufferSize = 1024 * 1024;  // 1 MB.
 
+// Number of streams read by ReadAhead(): the HTTP headers and the body.
+const int kReadAheadStreams = 2;
+
+// The most data ReadAhead() reads from each stream. The headers are read only
+// if they fit, and the body only up to this size: the rest of it may not be
+// read soon, or at all.
+const int kMaxReadAheadSize = 16 * 1024;
+
+// Returns true if the blocks of |next| immediately follow the blocks of
+// |address| on the same block file.
+bool IsAdjacent(disk_cache::Addr address, disk_cache::Addr next) {
+  return address.FileNumber() == next.FileNumber() &&
+         address.file_type() == next.file_type() &&
+         address.start_block() + address.num_blocks() == next.start_block();
+}
+
+// Returns true if |address| is stored before |other| on disk.
+bool IsStoredBefore(disk_cache::Addr address, disk_cache::Addr other) {
+  if (address.FileNumber() != other.FileNumber())
+    return address.FileNumber() < other.FileNumber();
+  return address.start_block() < other.start_block();
+}
+
 }  // namespace
 
 namespace disk_cache {
 
 // This class handles individual memory buffers that store data before it is
 // sent to disk. The buffer can start at any offset, but if we try to write to
-// anywhere in the first 16KB of the file (kMaxBlockSize), we set the offset to
-// zero. The buffer grows up to a size determined by the backend, to keep the
-// total memory used under control.
+// anywhere in the first 16KB of the file (kMaxSmallBlockSize), we set the
+// offset to zero. The buffer grows up to a size determined by the backend, to
+// keep the total memory used under control.
 class EntryImpl::UserBuffer {
  public:
   explicit UserBuffer(BackendImpl* backend)
       : backend_(backend->GetWeakPtr()), offset_(0), grow_allowed_(true) {
-    buffer_.reserve(kMaxBlockSize);
+    buffer_.reserve(kMaxSmallBlockSize);
   }
   ~UserBuffer() {
     if (backend_)
-      backend_->BufferDeleted(capacity() - kMaxBlockSize);
+      backend_->BufferDeleted(capacity() - kMaxSmallBlockSize);
   }
 
   // Returns true if we can handle writing |len| bytes to |offset|.
@@ -149,9 +214,9 @@ bool EntryImpl::UserBuffer::PreWrite(int offset, int len) {
   if (offset + len <= capacity())
     return true;
 
-  // If we are writing to the first 16K (kMaxBlockSize), we want to keep the
-  // buffer offset_ at 0.
-  if (!Size() && offset > kMaxBlockSize)
+  // If we are writing to the first 16K (kMaxSmallBlockSize), we want to keep
+  // the buffer offset_ at 0.
+  if (!Size() && offset > kMaxSmallBlockSize)
     return GrowBuffer(len, kMaxBufferSize);
 
   int required = offset - offset_ + len;
@@ -175,7 +240,7 @@ void EntryImpl::UserBuffer::Write(int offset, net::IOBuffer* buf, int len) {
   DCHECK_GE(offset, offset_);
   DVLOG(3) << "Buffer write at " << offset << " current " << offset_;
 
-  if (!Size() && offset > kMaxBlockSize)
+  if (!Size() && offset > kMaxSmallBlockSize)
     offset_ = offset;
 
   offset -= offset_;
@@ -253,11 +318,11 @@ int EntryImpl::UserBuffer::Read(int offset, net::IOBuffer* buf, int len) {
 void EntryImpl::UserBuffer::Reset() {
   if (!grow_allowed_) {
     if (backend_)
-      backend_->BufferDeleted(capacity() - kMaxBlockSize);
+      backend_->BufferDeleted(capacity() - kMaxSmallBlockSize);
     grow_allowed_ = true;
     std::vector<char> tmp;
     buffer_.swap(tmp);
-    buffer_.reserve(kMaxBlockSize);
+    buffer_.reserve(kMaxSmallBlockSize);
   }
   offset_ = 0;
   buffer_.clear();
@@ -275,7 +340,7 @@ bool EntryImpl::UserBuffer::GrowBuffer(int required, int limit) {
   if (!backend_)
     return false;
 
-  int to_add = std::max(required - current_size, kMaxBlockSize * 4);
+  int to_add = std::max(required - current_size, kMaxSmallBlockSize * 4);
   to_add = std::max(current_size, to_add);
   required = std::min(current_size + to_add, limit);
 
@@ -293,7 +358,7 @@ bool EntryImpl::UserBuffer::GrowBuffer(int required, int limit) {
 
 EntryImpl::EntryImpl(BackendImpl* backend, Addr address, bool read_only)
     : entry_(NULL, Addr(0)), node_(NULL, Addr(0)), backend_(backend),
-      doomed_(false), read_only_(read_only), dirty_(false) {
+      doomed_(false), read_only_(read_only), dirty_(false), closing_(false) {
   entry_.LazyInit(backend->File(address), address);
   for (int i = 0; i < kNumStreams; i++) {
     unreported_size_[i] = 0;
@@ -327,6 +392,64 @@ int EntryImpl::ReadDataImpl(int index, int offset, net::IOBuffer* buf,
   return result;
 }
 
+int EntryImpl::MapDataImpl(int index, int offset, int buf_len,
+                           scoped_refptr<net::IOBuffer>* buf) {
+  DCHECK(node_.Data()->dirty || read_only_);
+  if (index < 0 || index >= kNumStreams)
+    return net::ERR_INVALID_ARGUMENT;
+
+  int entry_size = entry_.Data()->data_size[index];
+  if (offset >= entry_size || offset < 0 || !buf_len)
+    return 0;
+
+  if (buf_len < 0)
+    return net::ERR_INVALID_ARGUMENT;
+
+  // Data that is still buffered in memory may not be on disk yet.
+  Addr address(entry_.Data()->data_addr[index]);
+  if (!address.is_initialized() || user_buffers_[index].get())
+    return net::ERR_CACHE_OPERATION_NOT_SUPPORTED;
+
+  File* file = GetBackingFile(address, index);
+  if (!file)
+    return net::ERR_CACHE_OPERATION_NOT_SUPPORTED;
+
+  TimeTicks start = TimeTicks::Now();
+
+  if (offset + buf_len > entry_size)
+    buf_len = entry_size - offset;
+
+  size_t file_offset = offset;
+  if (address.is_block_file()) {
+    DCHECK_LE(offset + buf_len, kMaxBlockSize);
+    file_offset += address.start_block() * address.BlockSize() +
+                   kBlockHeaderSize;
+  }
+
+  char* data = static_cast<char*>(file->MapRegion(buf_len, file_offset));
+  if (!data)
+    return net::ERR_CACHE_OPERATION_NOT_SUPPORTED;
+
+  // The buffer will be read from the IO thread, so bring the data in now
+  // instead of blocking that thread on page faults.
+  const int kPageSize = 4096;
+  volatile char touch = 0;
+  for (int i = 0; i < buf_len; i += kPageSize)
+    touch += data[i];
+
+  // The mapping makes the data read ahead when the entry was opened redundant.
+  read_ahead_[index] = NULL;
+
+  UpdateRank(false);
+  backend_->OnEvent(Stats::READ_DATA);
+  backend_->OnRead(buf_len);
+  backend_->OnEntryIO(1, buf_len);
+
+  *buf = new MappedDataBuffer(data, buf_len, this, backend_);
+  ReportIOTime(kRead, start);
+  return buf_len;
+}
+
 int EntryImpl::WriteDataImpl(int index, int offset, net::IOBuffer* buf,
                              int buf_len, OldCompletionCallback* callback,
                              bool truncate) {
@@ -527,6 +650,81 @@ bool EntryImpl::LoadNodeAddress() {
   return node_.Load();
 }
 
+int EntryImpl::ReadAhead() {
+  if (doomed_)
+    return 0;
+
+  // Find the streams that can be read ahead, sorted by their location.
+  int streams[kReadAheadStreams];
+  int num_streams = 0;
+  for (int index = 0; index < kReadAheadStreams; index++) {
+    Addr address(entry_.Data()->data_addr[index]);
+    int size = entry_.Data()->data_size[index];
+    if (!size || !address.is_initialized() || !address.is_block_file() ||
+        size > address.num_blocks() * address.BlockSize() ||
+        user_buffers_[index].get() || read_ahead_[index].get() ||
+        (index == 0 && size > kMaxReadAheadSize)) {
+      continue;
+    }
+
+    int i = num_streams++;
+    for (; i > 0; i--) {
+      Addr previous(entry_.Data()->data_addr[streams[i - 1]]);
+      if (!IsStoredBefore(address, previous))
+        break;
+      streams[i] = streams[i - 1];
+    }
+    streams[i] = index;
+  }
+
+  int num_reads = 0;
+  for (int first = 0; first < num_streams;) {
+    // Streams stored on consecutive blocks are read with a single call. All but
+    // the last stream of the group are read up to the end of their blocks, so
+    // that the next stream starts right where the previous buffer ends. That
+    // is only done for small blocks.
+    int end = first + 1;
+    while (end < num_streams) {
+      Addr previous(entry_.Data()->data_addr[streams[end - 1]]);
+      if (!IsAdjacent(previous, Addr(entry_.Data()->data_addr[streams[end]])) ||
+          previous.num_blocks() * previous.BlockSize() > kMaxReadAheadSize) {
+        break;
+      }
+      end++;
+    }
+
+    FileIOVector vectors[kReadAheadStreams];
+    scoped_refptr<net::IOBufferWithSize> buffers[kReadAheadStreams];
+    int bytes = 0;
+    for (int i = first; i < end; i++) {
+      Addr address(entry_.Data()->data_addr[streams[i]]);
+      int len = (i == end - 1) ?
+          std::min(entry_.Data()->data_size[streams[i]], kMaxReadAheadSize) :
+          address.num_blocks() * address.BlockSize();
+      buffers[i - first] = new net::IOBufferWithSize(len);
+      vectors[i - first].buffer = buffers[i - first]->data();
+      vectors[i - first].buffer_len = len;
+      bytes += len;
+    }
+
+    Addr address(entry_.Data()->data_addr[streams[first]]);
+    File* file = GetBackingFile(address, streams[first]);
+    if (!file)
+      return num_reads;
+
+    size_t offset = address.start_block() * address.BlockSize() +
+                    kBlockHeaderSize;
+    backend_->OnEntryIO(1, bytes);
+    num_reads++;
+    if (file->ReadVector(vectors, end - first, offset)) {
+      for (int i = first; i < end; i++)
+        read_ahead_[streams[i]] = buffers[i - first];
+    }
+    first = end;
+  }
+  return num_reads;
+}
+
 bool EntryImpl::Update() {
   DCHECK(node_.HasData());
 
@@ -603,7 +801,7 @@ bool EntryImpl::SanityCheck() {
     return false;
 
   if (key_addr.is_initialized() &&
-      ((stored->key_len < kMaxBlockSize && key_addr.is_separate_file()) ||
+      ((stored->key_len < kMaxSmallBlockSize && key_addr.is_separate_file()) ||
        (stored->key_len >= kMaxBlockSize && key_addr.is_block_file())))
     return false;
 
@@ -636,7 +834,7 @@ bool EntryImpl::DataSanityCheck() {
       return false;
     if (!data_size)
       continue;
-    if (data_size <= kMaxBlockSize && data_addr.is_separate_file())
+    if (data_size <= kMaxSmallBlockSize && data_addr.is_separate_file())
       return false;
     if (data_size > kMaxBlockSize && data_addr.is_block_file())
       return false;
@@ -655,7 +853,7 @@ void EntryImpl::FixForDelete() {
     Addr data_addr(stored->data_addr[i]);
     int data_size = stored->data_size[i];
     if (data_addr.is_initialized()) {
-      if ((data_size <= kMaxBlockSize && data_addr.is_separate_file()) ||
+      if ((data_size <= kMaxSmallBlockSize && data_addr.is_separate_file()) ||
           (data_size > kMaxBlockSize && data_addr.is_block_file()) ||
           !data_addr.SanityCheck()) {
         // The address is weird so don't attempt to delete it.
@@ -811,6 +1009,28 @@ int EntryImpl::ReadData(int index, int offset, net::IOBuffer* buf, int buf_len,
   return net::ERR_IO_PENDING;
 }
 
+int EntryImpl::MapData(int index, int offset, int buf_len,
+                       scoped_refptr<net::IOBuffer>* buf,
+                       net::OldCompletionCallback* callback) {
+  if (!callback)
+    return MapDataImpl(index, offset, buf_len, buf);
+
+  DCHECK(node_.Data()->dirty || read_only_);
+  if (index < 0 || index >= kNumStreams)
+    return net::ERR_INVALID_ARGUMENT;
+
+  int entry_size = entry_.Data()->data_size[index];
+  if (offset >= entry_size || offset < 0 || !buf_len)
+    return 0;
+
+  if (buf_len < 0)
+    return net::ERR_INVALID_ARGUMENT;
+
+  backend_->background_queue()->MapData(this, index, offset, buf_len, buf,
+                                        callback);
+  return net::ERR_IO_PENDING;
+}
+
 int EntryImpl::WriteData(int index, int offset, net::IOBuffer* buf, int buf_len,
                          OldCompletionCallback* callback, bool truncate) {
   if (!callback)
@@ -897,6 +1117,10 @@ EntryImpl::~EntryImpl() {
     DeleteEntryData(true);
   } else {
     net_log_.AddEvent(net::NetLog::TYPE_ENTRY_CLOSE, NULL);
+
+    // The changes to the entry made while saving the streams are stored at
+    // once, after all the data is on disk.
+    closing_ = true;
     bool ret = true;
     for (int index = 0; index < kNumStreams; index++) {
       if (user_buffers_[index].get()) {
@@ -910,13 +1134,20 @@ EntryImpl::~EntryImpl() {
       }
     }
 
+    if (entry_.modified()) {
+      backend_->OnEntryIO(1, static_cast<int>(entry_.size()));
+      entry_.Store();
+    }
+
     if (!ret) {
       // There was a failure writing the actual data. Mark the entry as dirty.
       int current_id = backend_->GetCurrentEntryId();
       node_.Data()->dirty = current_id == 1 ? -1 : current_id - 1;
+      backend_->OnEntryIO(1, static_cast<int>(node_.size()));
       node_.Store();
     } else if (node_.HasData() && !dirty_) {
       node_.Data()->dirty = 0;
+      backend_->OnEntryIO(1, static_cast<int>(node_.size()));
       node_.Store();
     }
   }
@@ -962,6 +1193,22 @@ int EntryImpl::InternalReadData(int index, int offset, net::IOBuffer* buf,
     return buf_len;
   }
 
+  if (read_ahead_[index].get()) {
+    int read_ahead_len = std::min(read_ahead_[index]->size(), entry_size);
+    if (offset + buf_len <= read_ahead_len) {
+      // Complete the operation with the data read when the entry was opened.
+      memcpy(buf->data(), read_ahead_[index]->data() + offset, buf_len);
+
+      // Streams are usually read only once, from start to end, so the rest of
+      // the data is not worth keeping in memory.
+      read_ahead_[index] = NULL;
+      ReportIOTime(kRead, start);
+      return buf_len;
+    }
+    // The reader is past the data read ahead.
+    read_ahead_[index] = NULL;
+  }
+
   address.set_value(entry_.Data()->data_addr[index]);
   DCHECK(address.is_initialized());
   if (!address.is_initialized()) {
@@ -988,6 +1235,7 @@ int EntryImpl::InternalReadData(int index, int offset, net::IOBuffer* buf,
                                    net::NetLog::TYPE_ENTRY_READ_DATA);
   }
 
+  backend_->OnEntryIO(1, buf_len);
   bool completed;
   if (!file->Read(buf->data(), buf_len, file_offset, io_callback, &completed)) {
     if (io_callback)
@@ -1033,7 +1281,11 @@ int EntryImpl::InternalWriteData(int index, int offset, net::IOBuffer* buf,
   bool extending = entry_size < offset + buf_len;
   truncate = truncate && entry_size > offset + buf_len;
   Trace("To PrepareTarget 0x%x", entry_.address().value());
-  if (!PrepareTarget(index, offset, buf_len, truncate))
+  bool prepared = PrepareTarget(index, offset, buf_len, truncate);
+
+  // Whatever was read ahead for this stream is stale now.
+  read_ahead_[index] = NULL;
+  if (!prepared)
     return net::ERR_FAILED;
 
   Trace("From PrepareTarget 0x%x", entry_.address().value());
@@ -1083,6 +1335,7 @@ int EntryImpl::InternalWriteData(int index, int offset, net::IOBuffer* buf,
                                    net::NetLog::TYPE_ENTRY_WRITE_DATA);
   }
 
+  backend_->OnEntryIO(1, buf_len);
   bool completed;
   if (!file->Write(buf->data(), buf_len, file_offset, io_callback,
                    &completed)) {
@@ -1104,11 +1357,27 @@ bool EntryImpl::CreateDataBlock(int index, int size) {
   DCHECK(index >= 0 && index < kNumStreams);
 
   Addr address(entry_.Data()->data_addr[index]);
-  if (!CreateBlock(size, &address))
+  // A stream bigger than kMaxSmallBlockSize is only stored on a block file if
+  // the buffer has all of it, because it has to be buffered again as a whole
+  // before it can be modified.
+  UserBuffer* buffer = user_buffers_[index].get();
+  if (size > kMaxSmallBlockSize &&
+      (!buffer || buffer->Start() || buffer->Size() != size)) {
+    if (size > backend_->MaxFileSize() ||
+        !backend_->CreateExternalFile(&address))
+      return false;
+  } else if (!CreateBlock(size, &address)) {
     return false;
+  }
 
   entry_.Data()->data_addr[index] = address.value();
-  entry_.Store();
+  if (closing_) {
+    // The destructor will store the entry.
+    entry_.set_modified();
+  } else {
+    backend_->OnEntryIO(1, static_cast<int>(entry_.size()));
+    entry_.Store();
+  }
   return true;
 }
 
@@ -1214,7 +1483,7 @@ bool EntryImpl::PrepareTarget(int index, int offset, int buf_len,
     if (address.is_block_file() && !MoveToLocalBuffer(index))
       return false;
 
-    if (!user_buffers_[index].get() && offset < kMaxBlockSize) {
+    if (!user_buffers_[index].get() && offset < kMaxSmallBlockSize) {
       // We are about to create a buffer for the first 16KB, make sure that we
       // preserve existing data.
       if (!CopyToLocalBuffer(index))
@@ -1282,7 +1551,7 @@ bool EntryImpl::HandleTruncation(int index, int offset, int buf_len) {
   DCHECK(!user_buffers_[index].get());
   DCHECK(address.is_initialized());
 
-  if (new_size > kMaxBlockSize)
+  if (new_size > kMaxSmallBlockSize)
     return true;  // Let the operation go directly to disk.
 
   return ImportSeparateFile(index, offset + buf_len);
@@ -1293,9 +1562,21 @@ bool EntryImpl::CopyToLocalBuffer(int index) {
   DCHECK(!user_buffers_[index].get());
   DCHECK(address.is_initialized());
 
-  int len = std::min(entry_.Data()->data_size[index], kMaxBlockSize);
+  // The whole stream is buffered when it lives on a block file, but only the
+  // first part of a separate file.
+  int max_len = address.is_block_file() ? kMaxBlockSize : kMaxSmallBlockSize;
+  int len = std::min(entry_.Data()->data_size[index], max_len);
   user_buffers_[index].reset(new UserBuffer(backend_));
-  user_buffers_[index]->Write(len, NULL, 0);
+  if (!user_buffers_[index]->PreWrite(0, len)) {
+    user_buffers_[index].reset();
+    return false;
+  }
+
+  if (read_ahead_[index].get() && read_ahead_[index]->size() >= len) {
+    // There is no need to go to disk.
+    user_buffers_[index]->Write(0, read_ahead_[index], len);
+    return true;
+  }
 
   File* file = GetBackingFile(address, index);
   int offset = 0;
@@ -1303,11 +1584,13 @@ bool EntryImpl::CopyToLocalBuffer(int index) {
   if (address.is_block_file())
     offset = address.start_block() * address.BlockSize() + kBlockHeaderSize;
 
-  if (!file ||
-      !file->Read(user_buffers_[index]->Data(), len, offset, NULL, NULL)) {
+  backend_->OnEntryIO(1, len);
+  scoped_refptr<net::IOBuffer> buffer(new net::IOBuffer(len));
+  if (!file || !file->Read(buffer->data(), len, offset, NULL, NULL)) {
     user_buffers_[index].reset();
     return false;
   }
+  user_buffers_[index]->Write(0, buffer, len);
   return true;
 }
 
@@ -1401,6 +1684,7 @@ bool EntryImpl::Flush(int index, int min_len) {
   if (!file)
     return false;
 
+  backend_->OnEntryIO(1, len);
   if (!file->Write(user_buffers_[index]->Data(), len, offset, NULL, NULL))
     return false;
   user_buffers_[index]->Reset();
@@ -1455,6 +1739,7 @@ void EntryImpl::GetData(int index, char** buffer, Addr* address) {
   // Bad news: we'd have to read the info from disk so instead we'll just tell
   // the caller where to read from.
   *buffer = NULL;
+  read_ahead_[index] = NULL;
   address->set_value(entry_.Data()->data_addr[index]);
   if (address->is_initialized()) {
     // Prevent us from deleting the block from the backing store.
@@ -6,12 +6,17 @@
 #define NET_DISK_CACHE_ENTRY_IMPL_H_
 #pragma once
 
+#include "base/memory/ref_counted.h"
 #include "base/memory/scoped_ptr.h"
 #include "net/base/net_log.h"
 #include "net/disk_cache/disk_cache.h"
 #include "net/disk_cache/storage_block.h"
 #include "net/disk_cache/storage_block-inl.h"
 
+namespace net {
+class IOBufferWithSize;
+}  // namespace net
+
 namespace disk_cache {
 
 class BackendImpl;
@@ -39,6 +44,8 @@ class NET_EXPORT_PRIVATE EntryImpl
   void DoomImpl();
   int ReadDataImpl(int index, int offset, net::IOBuffer* buf, int buf_len,
                    OldCompletionCallback* callback);
+  int MapDataImpl(int index, int offset, int buf_len,
+                  scoped_refptr<net::IOBuffer>* buf);
   int WriteDataImpl(int index, int offset, net::IOBuffer* buf, int buf_len,
                     OldCompletionCallback* callback, bool truncate);
   int ReadSparseDataImpl(int64 offset, net::IOBuffer* buf, int buf_len,
@@ -84,6 +91,12 @@ class NET_EXPORT_PRIVATE EntryImpl
   // Reloads the rankings node information.
   bool LoadNodeAddress();
 
+  // Reads the HTTP headers and the beginning of the body of this entry, when
+  // they are stored on block files, so that the first reads after opening the
+  // entry don't have to go to disk. Streams stored on adjacent blocks are read
+  // with a single system call. Returns the number of reads issued.
+  int ReadAhead();
+
   // Updates the stored data to reflect the run-time information for this entry.
   // Returns false if the data could not be updated. The purpose of this method
   // is to be able to detect entries that are currently in use.
@@ -146,6 +159,9 @@ class NET_EXPORT_PRIVATE EntryImpl
   virtual int32 GetDataSize(int index) const;
   virtual int ReadData(int index, int offset, net::IOBuffer* buf, int buf_len,
                        net::OldCompletionCallback* completion_callback);
+  virtual int MapData(int index, int offset, int buf_len,
+                      scoped_refptr<net::IOBuffer>* buf,
+                      net::OldCompletionCallback* completion_callback);
   virtual int WriteData(int index, int offset, net::IOBuffer* buf, int buf_len,
                         net::OldCompletionCallback* completion_callback,
                         bool truncate);
@@ -203,7 +219,7 @@ class NET_EXPORT_PRIVATE EntryImpl
   // stream.
   bool HandleTruncation(int index, int offset, int buf_len);
 
-  // Copies data from disk to the internal buffer.
+  // Copies data from disk (or from the data read ahead) to the internal buffer.
   bool CopyToLocalBuffer(int index);
 
   // Reads from a block data file to this object's memory buffer.
@@ -249,6 +265,9 @@ class NET_EXPORT_PRIVATE EntryImpl
   CacheRankingsBlock node_;   // Rankings related information for this entry.
   BackendImpl* backend_;      // Back pointer to the cache.
   scoped_ptr<UserBuffer> user_buffers_[kNumStreams];  // Stores user data.
+  // Data read by ReadAhead(), until the first read of the stream uses it or the
+  // stream is modified.
+  scoped_refptr<net::IOBufferWithSize> read_ahead_[kNumStreams];
   // Files to store external user data and key.
   scoped_refptr<File> files_[kNumStreams + 1];
   mutable std::string key_;           // Copy of the key.
@@ -256,6 +275,7 @@ class NET_EXPORT_PRIVATE EntryImpl
   bool doomed_;               // True if this entry was removed from the cache.
   bool read_only_;            // True if not yet writing.
   bool dirty_;                // True if we detected that this is a dirty entry.
+  bool closing_;              // True while the destructor saves the streams.
   scoped_ptr<SparseControl> sparse_;  // Support for sparse entries.
 
   net::BoundNetLog net_log_;
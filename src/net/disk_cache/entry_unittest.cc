@@ -4,6 +4,7 @@
 
 #include "base/basictypes.h"
 #include "base/file_util.h"
+#include "base/string_number_conversions.h"
 #include "base/threading/platform_thread.h"
 #include "base/timer.h"
 #include "base/string_util.h"
@@ -846,7 +847,7 @@ void DiskCacheEntryTest::Buffering() {
   EXPECT_TRUE(!memcmp(buffer2->data(), buffer1->data(), kSize));
 
   // Now go to an external file.
-  EXPECT_EQ(kSize, WriteData(entry, 1, 18000, buffer1, kSize, false));
+  EXPECT_EQ(kSize, WriteData(entry, 1, 268000, buffer1, kSize, false));
   entry->Close();
 
   // Write something else and verify old data.
@@ -859,43 +860,43 @@ void DiskCacheEntryTest::Buffering() {
   EXPECT_EQ(kSize, ReadData(entry, 1, 0, buffer2, kSize));
   EXPECT_TRUE(!memcmp(buffer2->data(), buffer1->data(), kSize));
   CacheTestFillBuffer(buffer2->data(), kSize, true);
-  EXPECT_EQ(kSize, ReadData(entry, 1, 18000, buffer2, kSize));
+  EXPECT_EQ(kSize, ReadData(entry, 1, 268000, buffer2, kSize));
   EXPECT_TRUE(!memcmp(buffer2->data(), buffer1->data(), kSize));
 
   // Extend the file some more.
-  EXPECT_EQ(kSize, WriteData(entry, 1, 23000, buffer1, kSize, false));
+  EXPECT_EQ(kSize, WriteData(entry, 1, 273000, buffer1, kSize, false));
   entry->Close();
 
   // And now make sure that we can deal with data in both places (ram/disk).
   ASSERT_EQ(net::OK, OpenEntry(key, &entry));
-  EXPECT_EQ(kSize, WriteData(entry, 1, 17000, buffer1, kSize, false));
+  EXPECT_EQ(kSize, WriteData(entry, 1, 267000, buffer1, kSize, false));
 
-  // We should not overwrite the data at 18000 with this.
-  EXPECT_EQ(kSize, WriteData(entry, 1, 19000, buffer1, kSize, false));
+  // We should not overwrite the data at 268000 with this.
+  EXPECT_EQ(kSize, WriteData(entry, 1, 269000, buffer1, kSize, false));
   CacheTestFillBuffer(buffer2->data(), kSize, true);
-  EXPECT_EQ(kSize, ReadData(entry, 1, 18000, buffer2, kSize));
+  EXPECT_EQ(kSize, ReadData(entry, 1, 268000, buffer2, kSize));
   EXPECT_TRUE(!memcmp(buffer2->data(), buffer1->data(), kSize));
   CacheTestFillBuffer(buffer2->data(), kSize, true);
-  EXPECT_EQ(kSize, ReadData(entry, 1, 17000, buffer2, kSize));
+  EXPECT_EQ(kSize, ReadData(entry, 1, 267000, buffer2, kSize));
   EXPECT_TRUE(!memcmp(buffer2->data(), buffer1->data(), kSize));
 
-  EXPECT_EQ(kSize, WriteData(entry, 1, 22900, buffer1, kSize, false));
+  EXPECT_EQ(kSize, WriteData(entry, 1, 272900, buffer1, kSize, false));
   CacheTestFillBuffer(buffer2->data(), kSize, true);
-  EXPECT_EQ(100, ReadData(entry, 1, 23000, buffer2, kSize));
+  EXPECT_EQ(100, ReadData(entry, 1, 273000, buffer2, kSize));
   EXPECT_TRUE(!memcmp(buffer2->data(), buffer1->data() + 100, 100));
 
   CacheTestFillBuffer(buffer2->data(), kSize, true);
-  EXPECT_EQ(100, ReadData(entry, 1, 23100, buffer2, kSize));
+  EXPECT_EQ(100, ReadData(entry, 1, 273100, buffer2, kSize));
   EXPECT_TRUE(!memcmp(buffer2->data(), buffer1->data() + 100, 100));
 
   // Extend the file again and read before without closing the entry.
-  EXPECT_EQ(kSize, WriteData(entry, 1, 25000, buffer1, kSize, false));
-  EXPECT_EQ(kSize, WriteData(entry, 1, 45000, buffer1, kSize, false));
+  EXPECT_EQ(kSize, WriteData(entry, 1, 275000, buffer1, kSize, false));
+  EXPECT_EQ(kSize, WriteData(entry, 1, 295000, buffer1, kSize, false));
   CacheTestFillBuffer(buffer2->data(), kSize, true);
-  EXPECT_EQ(kSize, ReadData(entry, 1, 25000, buffer2, kSize));
+  EXPECT_EQ(kSize, ReadData(entry, 1, 275000, buffer2, kSize));
   EXPECT_TRUE(!memcmp(buffer2->data(), buffer1->data(), kSize));
   CacheTestFillBuffer(buffer2->data(), kSize, true);
-  EXPECT_EQ(kSize, ReadData(entry, 1, 45000, buffer2, kSize));
+  EXPECT_EQ(kSize, ReadData(entry, 1, 295000, buffer2, kSize));
   EXPECT_TRUE(!memcmp(buffer2->data(), buffer1->data(), kSize));
 
   entry->Close();
@@ -1000,6 +1001,189 @@ TEST_F(DiskCacheEntryTest, SizeChangesNoBuffer) {
   SizeChanges();
 }
 
+// Returns the value of the stats item |name| of |cache|.
+static std::string GetStatsItem(disk_cache::Backend* cache,
+                                const std::string& name) {
+  std::vector<std::pair<std::string, std::string> > stats;
+  cache->GetStats(&stats);
+  for (size_t i = 0; i < stats.size(); i++) {
+    if (stats[i].first == name)
+      return stats[i].second;
+  }
+  return std::string();
+}
+
+// Tests that the headers and body of an entry are read when the entry is
+// opened, with a single system call when they are stored next to each other,
+// and that the data is not used after the entry is modified.
+TEST_F(DiskCacheEntryTest, ReadAhead) {
+  InitCache();
+  std::string key("the first key");
+  disk_cache::Entry* entry;
+  ASSERT_EQ(net::OK, CreateEntry(key, &entry));
+
+  // Both streams use two blocks of the same block file.
+  const int kHeadersSize = 300;
+  const int kBodySize = 400;
+  scoped_refptr<net::IOBuffer> headers(new net::IOBuffer(kHeadersSize));
+  scoped_refptr<net::IOBuffer> body(new net::IOBuffer(kBodySize));
+  scoped_refptr<net::IOBuffer> buffer(new net::IOBuffer(kBodySize));
+  CacheTestFillBuffer(headers->data(), kHeadersSize, false);
+  CacheTestFillBuffer(body->data(), kBodySize, false);
+  EXPECT_EQ(kHeadersSize,
+            WriteData(entry, 0, 0, headers, kHeadersSize, false));
+  EXPECT_EQ(kBodySize, WriteData(entry, 1, 0, body, kBodySize, false));
+  entry->Close();
+
+  ASSERT_EQ(net::OK, OpenEntry(key, &entry));
+  EXPECT_EQ("1.00", GetStatsItem(cache_, "Read ahead syscalls per open"));
+
+  // The data is already in memory.
+  std::string io_calls = GetStatsItem(cache_, "Entry IO");
+  EXPECT_EQ(kHeadersSize, ReadData(entry, 0, 0, buffer, kBodySize));
+  EXPECT_TRUE(!memcmp(buffer->data(), headers->data(), kHeadersSize));
+  EXPECT_EQ(kBodySize - 100, ReadData(entry, 1, 100, buffer, kBodySize));
+  EXPECT_TRUE(!memcmp(buffer->data(), body->data() + 100, kBodySize - 100));
+  EXPECT_EQ(io_calls, GetStatsItem(cache_, "Entry IO"));
+
+  // The data read ahead is released by the first read that uses it.
+  EXPECT_EQ(100, ReadData(entry, 1, 0, buffer, 100));
+  EXPECT_TRUE(!memcmp(buffer->data(), body->data(), 100));
+  EXPECT_NE(io_calls, GetStatsItem(cache_, "Entry IO"));
+
+  // Change the beginning of the body and read the rest of it.
+  CacheTestFillBuffer(body->data(), 100, false);
+  EXPECT_EQ(100, WriteData(entry, 1, 0, body, 100, false));
+  EXPECT_EQ(kBodySize, ReadData(entry, 1, 0, buffer, kBodySize));
+  EXPECT_TRUE(!memcmp(buffer->data(), body->data(), kBodySize));
+  entry->Close();
+
+  // The new data is read ahead the next time.
+  ASSERT_EQ(net::OK, OpenEntry(key, &entry));
+  io_calls = GetStatsItem(cache_, "Entry IO");
+  EXPECT_EQ(kBodySize, ReadData(entry, 1, 0, buffer, kBodySize));
+  EXPECT_TRUE(!memcmp(buffer->data(), body->data(), kBodySize));
+  EXPECT_EQ(io_calls, GetStatsItem(cache_, "Entry IO"));
+  entry->Close();
+}
+
+// Tests that only the beginning of a large body is read ahead, and that
+// dooming an entry doesn't read its data.
+TEST_F(DiskCacheEntryTest, ReadAheadLimit) {
+  InitCache();
+  std::string key("the first key");
+  disk_cache::Entry* entry;
+  ASSERT_EQ(net::OK, CreateEntry(key, &entry));
+
+  // Both streams use block files, and the body is larger than the data read
+  // ahead.
+  const int kHeadersSize = 2000;
+  const int kBodySize = 100000;
+  const int kReadSize = 16 * 1024;
+  scoped_refptr<net::IOBuffer> headers(new net::IOBuffer(kHeadersSize));
+  scoped_refptr<net::IOBuffer> body(new net::IOBuffer(kBodySize));
+  scoped_refptr<net::IOBuffer> buffer(new net::IOBuffer(kReadSize));
+  CacheTestFillBuffer(headers->data(), kHeadersSize, false);
+  CacheTestFillBuffer(body->data(), kBodySize, false);
+  EXPECT_EQ(kHeadersSize,
+            WriteData(entry, 0, 0, headers, kHeadersSize, false));
+  EXPECT_EQ(kBodySize, WriteData(entry, 1, 0, body, kBodySize, false));
+  entry->Close();
+
+  ASSERT_EQ(net::OK, OpenEntry(key, &entry));
+  std::string io_calls = GetStatsItem(cache_, "Entry IO");
+  EXPECT_EQ(kReadSize, ReadData(entry, 1, 0, buffer, kReadSize));
+  EXPECT_TRUE(!memcmp(buffer->data(), body->data(), kReadSize));
+  EXPECT_EQ(io_calls, GetStatsItem(cache_, "Entry IO"));
+
+  // The rest of the body comes from the disk.
+  EXPECT_EQ(kReadSize, ReadData(entry, 1, kReadSize, buffer, kReadSize));
+  EXPECT_TRUE(!memcmp(buffer->data(), body->data() + kReadSize, kReadSize));
+  EXPECT_NE(io_calls, GetStatsItem(cache_, "Entry IO"));
+  entry->Close();
+
+  int io_bytes_before = 0;
+  int io_bytes_after = 0;
+  ASSERT_TRUE(base::HexStringToInt(GetStatsItem(cache_, "Entry IO bytes"),
+                                   &io_bytes_before));
+  EXPECT_EQ(net::OK, DoomEntry(key));
+  ASSERT_TRUE(base::HexStringToInt(GetStatsItem(cache_, "Entry IO bytes"),
+                                   &io_bytes_after));
+  EXPECT_LT(io_bytes_after - io_bytes_before, kHeadersSize);
+}
+
+// Tests that stored data can be mapped, and that it stays valid after the entry
+// is closed and doomed.
+TEST_F(DiskCacheEntryTest, MapData) {
+  InitCache();
+  std::string key("the first key");
+  disk_cache::Entry* entry;
+  ASSERT_EQ(net::OK, CreateEntry(key, &entry));
+
+  // The first stream goes to a block file and the second to a separate file.
+  const int kSize1 = 20000;
+  const int kSize2 = 300000;
+  scoped_refptr<net::IOBuffer> buffer1(new net::IOBuffer(kSize1));
+  scoped_refptr<net::IOBuffer> buffer2(new net::IOBuffer(kSize2));
+  CacheTestFillBuffer(buffer1->data(), kSize1, false);
+  CacheTestFillBuffer(buffer2->data(), kSize2, false);
+  EXPECT_EQ(kSize1, WriteData(entry, 1, 0, buffer1, kSize1, false));
+  EXPECT_EQ(kSize2, WriteData(entry, 2, 0, buffer2, kSize2, false));
+
+  // The first stream is still buffered in memory.
+  TestOldCompletionCallback cb;
+  scoped_refptr<net::IOBuffer> mapped1;
+  int rv = entry->MapData(1, 0, kSize1, &mapped1, &cb);
+  EXPECT_EQ(net::ERR_CACHE_OPERATION_NOT_SUPPORTED, cb.GetResult(rv));
+  EXPECT_FALSE(mapped1.get());
+  entry->Close();
+
+  ASSERT_EQ(net::OK, OpenEntry(key, &entry));
+  rv = entry->MapData(1, 100, kSize1, &mapped1, &cb);
+  ASSERT_EQ(kSize1 - 100, cb.GetResult(rv));
+  EXPECT_TRUE(!memcmp(mapped1->data(), buffer1->data() + 100, kSize1 - 100));
+
+  scoped_refptr<net::IOBuffer> mapped2;
+  rv = entry->MapData(2, 1000, 5000, &mapped2, &cb);
+  ASSERT_EQ(5000, cb.GetResult(rv));
+  EXPECT_TRUE(!memcmp(mapped2->data(), buffer2->data() + 1000, 5000));
+
+  rv = entry->MapData(2, kSize2, 5000, &mapped2, &cb);
+  EXPECT_EQ(0, cb.GetResult(rv));
+  rv = entry->MapData(3, 0, 5000, &mapped2, &cb);
+  EXPECT_EQ(net::ERR_INVALID_ARGUMENT, cb.GetResult(rv));
+
+  // The data is still there after the entry goes away.
+  entry->Close();
+  ASSERT_EQ(net::OK, DoomEntry(key));
+  ASSERT_NE(net::OK, OpenEntry(key, &entry));
+  EXPECT_TRUE(!memcmp(mapped1->data(), buffer1->data() + 100, kSize1 - 100));
+  EXPECT_TRUE(!memcmp(mapped2->data(), buffer2->data() + 1000, 5000));
+
+  // Let the cache release the entry.
+  mapped1 = NULL;
+  mapped2 = NULL;
+  FlushQueueForTest();
+}
+
+TEST_F(DiskCacheEntryTest, MemoryOnlyMapData) {
+  SetMemoryOnlyMode();
+  InitCache();
+  disk_cache::Entry* entry;
+  ASSERT_EQ(net::OK, CreateEntry("the first key", &entry));
+
+  const int kSize = 200;
+  scoped_refptr<net::IOBuffer> buffer(new net::IOBuffer(kSize));
+  CacheTestFillBuffer(buffer->data(), kSize, false);
+  EXPECT_EQ(kSize, WriteData(entry, 1, 0, buffer, kSize, false));
+
+  TestOldCompletionCallback cb;
+  scoped_refptr<net::IOBuffer> mapped;
+  int rv = entry->MapData(1, 0, kSize, &mapped, &cb);
+  EXPECT_EQ(net::ERR_CACHE_OPERATION_NOT_SUPPORTED, cb.GetResult(rv));
+  entry->Close();
+}
+
 // Write more than the total cache capacity but to a single entry. |size| is the
 // amount of bytes to write each time.
 void DiskCacheEntryTest::ReuseEntry(int size) {
@@ -1255,7 +1439,7 @@ TEST_F(DiskCacheEntryTest, MissingData) {
   ASSERT_EQ(net::OK, CreateEntry(key, &entry));
 
   // Write to an external file.
-  const int kSize = 20000;
+  const int kSize = 270000;
   scoped_refptr<net::IOBuffer> buffer(new net::IOBuffer(kSize));
   CacheTestFillBuffer(buffer->data(), kSize, false);
   EXPECT_EQ(kSize, WriteData(entry, 0, 0, buffer, kSize, false));
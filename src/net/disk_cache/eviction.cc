@@ -26,8 +26,23 @@
 // size so that we have a chance to see an element again and move it to another
 // list.
 
+// The adaptive eviction policy (only used with kAdaptiveEviction) keeps the
+// lists of the new policy but selects the list to evict from the way ARC does. The
+// NO_USE list holds the entries that were seen only once (recency) and the
+// LOW_USE and HIGH_USE lists hold the entries that were reused (frequency).
+// The evicted entries that are still on the DELETED list remember which side
+// they were evicted from. We keep a target length for the NO_USE list, and
+// evict from it while it is longer than the target; otherwise we evict the
+// least recently used entry of the other two lists. Seeing again an entry that
+// was evicted from NO_USE means that the target is too small, so it grows;
+// seeing again one evicted from the other lists makes it shrink. A burst of
+// entries that are used only once never reaches the other lists, and it does
+// not move the target, so it cannot flush the entries that are reused.
+
 #include "net/disk_cache/eviction.h"
 
+#include <algorithm>
+
 #include "base/compiler_specific.h"
 #include "base/logging.h"
 #include "base/message_loop.h"
@@ -84,6 +99,7 @@ void Eviction::Init(BackendImpl* backend) {
   init_ = true;
   test_mode_ = false;
   in_experiment_ = (header_->experiment == EXPERIMENT_DELETED_LIST_IN);
+  adaptive_ = new_eviction_ && (backend->user_flags_ & kAdaptiveEviction);
 }
 
 void Eviction::Stop() {
@@ -106,6 +122,9 @@ void Eviction::TrimCache(bool empty) {
   if (!empty && !ShouldTrim())
     return PostDelayedTrim();
 
+  if (adaptive_ && !empty)
+    return TrimCacheAdaptive();
+
   if (new_eviction_)
     return TrimCacheV2(empty);
 
@@ -277,6 +296,7 @@ bool Eviction::EvictEntry(CacheRankingsBlock* node, bool empty,
     info->state = ENTRY_EVICTED;
     entry->entry()->Store();
     rankings_->Insert(entry->rankings(), true, Rankings::DELETED);
+    header_->lru.evicted[info->reuse_count ? 1 : 0]++;
     backend_->OnEvent(Stats::TRIM_ENTRY);
   }
   entry->Release();
@@ -351,7 +371,7 @@ void Eviction::TrimCacheV2(bool empty) {
 
   if (empty) {
     TrimDeleted(true);
-  } else if (header_->lru.sizes[Rankings::DELETED] > header_->num_entries / 4 &&
+  } else if (header_->lru.sizes[Rankings::DELETED] > MaxDeletedListLength() &&
              !test_mode_) {
     MessageLoop::current()->PostTask(FROM_HERE,
         factory_.NewRunnableMethod(&Eviction::TrimDeleted, empty));
@@ -402,6 +422,7 @@ void Eviction::OnCreateEntryV2(EntryImpl* entry) {
       break;
     };
     case ENTRY_EVICTED: {
+      OnEvictedEntryReused(info);
       if (info->refetch_count < kint32max)
         info->refetch_count++;
 
@@ -481,14 +502,8 @@ void Eviction::TrimDeleted(bool empty) {
       break;
   }
 
-  // Normally we use 25% for each list. The experiment doubles the number of
-  // deleted entries, so the total number of entries increases by 25%. Using
-  // 40% of that value for deleted entries leaves the size of the other three
-  // lists intact.
-  int max_length = in_experiment_ ? header_->num_entries * 2 / 5 :
-                                    header_->num_entries / 4;
   if (deleted && !empty && !test_mode_ &&
-      header_->lru.sizes[Rankings::DELETED] > max_length) {
+      header_->lru.sizes[Rankings::DELETED] > MaxDeletedListLength()) {
     MessageLoop::current()->PostTask(FROM_HERE,
         factory_.NewRunnableMethod(&Eviction::TrimDeleted, false));
   }
@@ -506,6 +521,8 @@ bool Eviction::RemoveDeletedNode(CacheRankingsBlock* node) {
   }
 
   bool doomed = (entry->entry()->Data()->state == ENTRY_DOOMED);
+  if (!doomed)
+    OnEvictedEntryRemoved(entry->entry()->Data());
   entry->entry()->Data()->state = ENTRY_DOOMED;
   entry->DoomImpl();
   entry->Release();
@@ -544,6 +561,20 @@ int Eviction::SelectListByLength(Rankings::ScopedRankingsBlock* next) {
   return list;
 }
 
+int Eviction::MaxDeletedListLength() {
+  // Adaptive eviction remembers as many evicted entries as there are entries
+  // with data, so the deleted entries use half of the total.
+  if (adaptive_)
+    return header_->num_entries / 2;
+
+  // Normally we use 25% for each list. The experiment doubles the number of
+  // deleted entries, so the total number of entries increases by 25%. Using
+  // 40% of that value for deleted entries leaves the size of the other three
+  // lists intact.
+  return in_experiment_ ? header_->num_entries * 2 / 5 :
+                          header_->num_entries / 4;
+}
+
 void Eviction::ReportListStats() {
   if (!new_eviction_)
     return;
@@ -571,4 +602,111 @@ void Eviction::ReportListStats() {
               Time::FromInternalValue(last4.get()->Data()->last_used));
 }
 
+// -----------------------------------------------------------------------
+
+void Eviction::TrimCacheAdaptive() {
+  Trace("*** Trim Cache (adaptive) ***");
+  trimming_ = true;
+  TimeTicks start = TimeTicks::Now();
+
+  const int kListsToSearch = 3;
+  Rankings::ScopedRankingsBlock next[kListsToSearch];
+  for (int i = 0; i < kListsToSearch; i++) {
+    next[i].set_rankings(rankings_);
+    next[i].reset(rankings_->GetPrev(NULL, static_cast<Rankings::List>(i)));
+  }
+
+  Rankings::ScopedRankingsBlock node(rankings_);
+  while (header_->num_bytes > max_size_ || test_mode_) {
+    int list = SelectListAdaptive(next);
+    if (Rankings::LAST_ELEMENT == list)
+      break;
+
+    // The iterator could be invalidated within EvictEntry().
+    if (!next[list]->HasData())
+      break;
+    node.reset(next[list].release());
+    next[list].reset(rankings_->GetPrev(node.get(),
+                                        static_cast<Rankings::List>(list)));
+    if (node->Data()->dirty != backend_->GetCurrentEntryId()) {
+      // This entry is not being used by anybody.
+      // Do NOT use node as an iterator after this point.
+      rankings_->TrackRankingsBlock(node.get(), false);
+      if (!EvictEntry(node.get(), false, static_cast<Rankings::List>(list)) &&
+          !test_mode_)
+        continue;
+
+      if (test_mode_)
+        break;
+
+      if ((TimeTicks::Now() - start).InMilliseconds() > 20) {
+        MessageLoop::current()->PostTask(FROM_HERE,
+            factory_.NewRunnableMethod(&Eviction::TrimCache, false));
+        break;
+      }
+    }
+  }
+
+  if (header_->lru.sizes[Rankings::DELETED] > MaxDeletedListLength() &&
+      !test_mode_) {
+    MessageLoop::current()->PostTask(FROM_HERE,
+        factory_.NewRunnableMethod(&Eviction::TrimDeleted, false));
+  }
+
+  CACHE_UMA(AGE_MS, "TotalTrimTimeAdaptive", backend_->GetSizeGroup(), start);
+
+  Trace("*** Trim Cache end ***");
+  trimming_ = false;
+  return;
+}
+
+int Eviction::SelectListAdaptive(Rankings::ScopedRankingsBlock* next) {
+  bool reused_entries = next[Rankings::LOW_USE].get() ||
+                        next[Rankings::HIGH_USE].get();
+  if (next[Rankings::NO_USE].get() &&
+      (header_->lru.sizes[Rankings::NO_USE] > header_->lru.target_no_use ||
+       !reused_entries)) {
+    return Rankings::NO_USE;
+  }
+
+  if (!reused_entries)
+    return Rankings::LAST_ELEMENT;
+
+  // LOW_USE and HIGH_USE behave as a single LRU list.
+  if (!next[Rankings::LOW_USE].get())
+    return Rankings::HIGH_USE;
+  if (!next[Rankings::HIGH_USE].get())
+    return Rankings::LOW_USE;
+  if (next[Rankings::HIGH_USE]->Data()->last_used <
+      next[Rankings::LOW_USE]->Data()->last_used) {
+    return Rankings::HIGH_USE;
+  }
+  return Rankings::LOW_USE;
+}
+
+// Called when an evicted entry is created again. The target and the counters
+// are updated even when the adaptive algorithm is not in use, so that they are
+// right if we start using it.
+void Eviction::OnEvictedEntryReused(EntryStore* info) {
+  // Entries that were evicted from NO_USE were never reused.
+  int side = info->reuse_count ? 1 : 0;
+  int evicted = std::max(header_->lru.evicted[side], 1);
+  int other = std::max(header_->lru.evicted[1 - side], 1);
+  int step = std::max(other / evicted, 1);
+  int data_entries = header_->num_entries -
+                     header_->lru.sizes[Rankings::DELETED];
+
+  int target = header_->lru.target_no_use;
+  target = side ? target - step : target + step;
+  header_->lru.target_no_use = std::min(std::max(target, 0), data_entries);
+
+  OnEvictedEntryRemoved(info);
+}
+
+void Eviction::OnEvictedEntryRemoved(EntryStore* info) {
+  int side = info->reuse_count ? 1 : 0;
+  if (header_->lru.evicted[side] > 0)
+    header_->lru.evicted[side]--;
+}
+
 }  // namespace disk_cache
@@ -67,8 +67,15 @@ class Eviction {
 
   bool NodeIsOldEnough(CacheRankingsBlock* node, int list);
   int SelectListByLength(Rankings::ScopedRankingsBlock* next);
+  int MaxDeletedListLength();
   void ReportListStats();
 
+  // Adaptive version of the new eviction algorithm.
+  void TrimCacheAdaptive();
+  int SelectListAdaptive(Rankings::ScopedRankingsBlock* next);
+  void OnEvictedEntryReused(EntryStore* info);
+  void OnEvictedEntryRemoved(EntryStore* info);
+
   BackendImpl* backend_;
   Rankings* rankings_;
   IndexHeader* header_;
@@ -81,6 +88,7 @@ class Eviction {
   bool init_;
   bool test_mode_;
   bool in_experiment_;
+  bool adaptive_;
   ScopedRunnableMethodFactory<Eviction> factory_;
 
   DISALLOW_COPY_AND_ASSIGN(Eviction);
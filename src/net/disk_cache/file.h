@@ -26,6 +26,12 @@ class FileIOCallback {
   virtual void OnFileIOComplete(int bytes_copied) = 0;
 };
 
+// One of the buffers of a vectored read.
+struct FileIOVector {
+  void* buffer;
+  size_t buffer_len;
+};
+
 // Simple wrapper around a file that allows asynchronous operations.
 class NET_EXPORT_PRIVATE File : public base::RefCounted<File> {
   friend class base::RefCounted<File>;
@@ -53,6 +59,19 @@ class NET_EXPORT_PRIVATE File : public base::RefCounted<File> {
   bool Read(void* buffer, size_t buffer_len, size_t offset);
   bool Write(const void* buffer, size_t buffer_len, size_t offset);
 
+  // Performs a synchronous scatter read: the |num_buffers| buffers are filled,
+  // in order, with consecutive bytes of the file, starting at |offset|, with a
+  // single system call (when the platform supports it). Returns true if all
+  // the buffers were filled.
+  bool ReadVector(const FileIOVector* buffers, int num_buffers,
+                  size_t offset);
+
+  // Maps |buffer_len| bytes of the file, starting at |offset|, in read-only
+  // mode. Returns the address of the first byte, or NULL on failure. The region
+  // must be released with UnmapRegion().
+  void* MapRegion(size_t buffer_len, size_t offset);
+  static void UnmapRegion(void* address, size_t buffer_len);
+
   // Performs asynchronous IO. callback will be called when the IO completes,
   // as an APC on the thread that queued the operation.
   bool Read(void* buffer, size_t buffer_len, size_t offset,
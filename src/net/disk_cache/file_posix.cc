@@ -5,10 +5,19 @@
 #include "net/disk_cache/file.h"
 
 #include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/uio.h>
+#include <unistd.h>
 
+#include <vector>
+
+#include "base/eintr_wrapper.h"
+#include "base/lazy_instance.h"
 #include "base/location.h"
 #include "base/logging.h"
+#include "base/threading/thread_local.h"
 #include "base/threading/worker_pool.h"
+#include "build/build_config.h"
 #include "net/base/net_errors.h"
 #include "net/disk_cache/disk_cache.h"
 #include "net/disk_cache/in_flight_io.h"
@@ -145,22 +154,28 @@ void FileInFlightIO::OnOperationComplete(disk_cache::BackgroundIO* operation,
   callback->OnFileIOComplete(bytes);
 }
 
-// A static object tha will broker all async operations.
-FileInFlightIO* s_file_operations = NULL;
+// The objects that broker all async operations. Each cache thread has its own
+// object, so that operations complete on the thread that started them even
+// when there is more than one cache (or cache shard) running.
+base::LazyInstance<base::ThreadLocalPointer<FileInFlightIO> >
+    s_file_operations(base::LINKER_INITIALIZED);
 
 // Returns the current FileInFlightIO.
 FileInFlightIO* GetFileInFlightIO() {
-  if (!s_file_operations) {
-    s_file_operations = new FileInFlightIO;
+  FileInFlightIO* file_operations = s_file_operations.Pointer()->Get();
+  if (!file_operations) {
+    file_operations = new FileInFlightIO;
+    s_file_operations.Pointer()->Set(file_operations);
   }
-  return s_file_operations;
+  return file_operations;
 }
 
 // Deletes the current FileInFlightIO.
 void DeleteFileInFlightIO() {
-  DCHECK(s_file_operations);
-  delete s_file_operations;
-  s_file_operations = NULL;
+  FileInFlightIO* file_operations = s_file_operations.Pointer()->Get();
+  DCHECK(file_operations);
+  delete file_operations;
+  s_file_operations.Pointer()->Set(NULL);
 }
 
 }  // namespace
@@ -224,6 +239,61 @@ bool File::Write(const void* buffer, size_t buffer_len, size_t offset) {
   return (static_cast<size_t>(ret) == buffer_len);
 }
 
+bool File::ReadVector(const FileIOVector* buffers, int num_buffers,
+                      size_t offset) {
+  DCHECK(init_);
+  DCHECK_GT(num_buffers, 0);
+  if (offset > static_cast<size_t>(kint32max))
+    return false;
+
+#if defined(OS_MACOSX)
+  // There is no preadv() here, so the buffers are read one at a time.
+  for (int i = 0; i < num_buffers; i++) {
+    if (!Read(buffers[i].buffer, buffers[i].buffer_len, offset))
+      return false;
+    offset += buffers[i].buffer_len;
+  }
+  return true;
+#else
+  std::vector<struct iovec> vectors(num_buffers);
+  size_t total_len = 0;
+  for (int i = 0; i < num_buffers; i++) {
+    vectors[i].iov_base = buffers[i].buffer;
+    vectors[i].iov_len = buffers[i].buffer_len;
+    total_len += buffers[i].buffer_len;
+  }
+  if (total_len > static_cast<size_t>(kint32max))
+    return false;
+
+  ssize_t ret = HANDLE_EINTR(preadv(platform_file_, &vectors[0], num_buffers,
+                                    offset));
+  return (ret >= 0 && static_cast<size_t>(ret) == total_len);
+#endif
+}
+
+void* File::MapRegion(size_t buffer_len, size_t offset) {
+  DCHECK(init_);
+  if (buffer_len > static_cast<size_t>(kint32max) ||
+      offset > static_cast<size_t>(kint32max)) {
+    return NULL;
+  }
+
+  // The mapping must start at a page boundary.
+  size_t delta = offset % sysconf(_SC_PAGESIZE);
+  void* view = mmap(NULL, buffer_len + delta, PROT_READ, MAP_SHARED,
+                    platform_file_, offset - delta);
+  if (view == MAP_FAILED)
+    return NULL;
+  return static_cast<char*>(view) + delta;
+}
+
+// Static.
+void File::UnmapRegion(void* address, size_t buffer_len) {
+  size_t delta = reinterpret_cast<uintptr_t>(address) % sysconf(_SC_PAGESIZE);
+  int ret = munmap(static_cast<char*>(address) - delta, buffer_len + delta);
+  DCHECK_EQ(0, ret);
+}
+
 // We have to increase the ref counter of the file before performing the IO to
 // prevent the completion to happen with an invalid handle (if the file is
 // closed while the IO is in flight).
@@ -62,6 +62,13 @@ MyOverlapped::MyOverlapped(disk_cache::File* file, size_t offset,
   callback_ = callback;
 }
 
+// Returns the alignment required for the offset of a view of a file.
+size_t GetAllocationGranularity() {
+  SYSTEM_INFO info;
+  GetSystemInfo(&info);
+  return info.dwAllocationGranularity;
+}
+
 }  // namespace
 
 namespace disk_cache {
@@ -154,6 +161,51 @@ bool File::Write(const void* buffer, size_t buffer_len, size_t offset) {
   return actual == size;
 }
 
+bool File::ReadVector(const FileIOVector* buffers, int num_buffers,
+                      size_t offset) {
+  DCHECK(init_);
+  DCHECK_GT(num_buffers, 0);
+
+  // ReadFileScatter() requires unbuffered IO and page-sized buffers, so the
+  // buffers are read one at a time.
+  for (int i = 0; i < num_buffers; i++) {
+    if (!Read(buffers[i].buffer, buffers[i].buffer_len, offset))
+      return false;
+    offset += buffers[i].buffer_len;
+  }
+  return true;
+}
+
+void* File::MapRegion(size_t buffer_len, size_t offset) {
+  DCHECK(init_);
+  if (buffer_len > ULONG_MAX || offset > ULONG_MAX)
+    return NULL;
+
+  HANDLE section = CreateFileMapping(sync_platform_file_, NULL, PAGE_READONLY,
+                                     0, 0, NULL);
+  if (!section)
+    return NULL;
+
+  size_t delta = offset % GetAllocationGranularity();
+  void* view = MapViewOfFile(section, FILE_MAP_READ, 0,
+                             static_cast<DWORD>(offset - delta),
+                             buffer_len + delta);
+
+  // The view keeps a reference to the section.
+  CloseHandle(section);
+  if (!view)
+    return NULL;
+  return static_cast<char*>(view) + delta;
+}
+
+// Static.
+void File::UnmapRegion(void* address, size_t buffer_len) {
+  size_t delta =
+      reinterpret_cast<uintptr_t>(address) % GetAllocationGranularity();
+  BOOL ret = UnmapViewOfFile(static_cast<char*>(address) - delta);
+  DCHECK(ret);
+}
+
 // We have to increase the ref counter of the file before performing the IO to
 // prevent the completion to happen with an invalid handle (if the file is
 // closed while the IO is in flight).
@@ -139,6 +139,16 @@ void BackendIO::ReadData(EntryImpl* entry, int index, int offset,
   buf_len_ = buf_len;
 }
 
+void BackendIO::MapData(EntryImpl* entry, int index, int offset, int buf_len,
+                        scoped_refptr<net::IOBuffer>* buf) {
+  operation_ = OP_MAP;
+  entry_ = entry;
+  index_ = index;
+  offset_ = offset;
+  buf_len_ = buf_len;
+  map_buf_ptr_ = buf;
+}
+
 void BackendIO::WriteData(EntryImpl* entry, int index, int offset,
                           net::IOBuffer* buf, int buf_len, bool truncate) {
   operation_ = OP_WRITE;
@@ -258,6 +268,9 @@ void BackendIO::ExecuteEntryOperation() {
       result_ = entry_->ReadDataImpl(index_, offset_, buf_, buf_len_,
                                      &my_callback_);
       break;
+    case OP_MAP:
+      result_ = entry_->MapDataImpl(index_, offset_, buf_len_, map_buf_ptr_);
+      break;
     case OP_WRITE:
       result_ = entry_->WriteDataImpl(index_, offset_, buf_, buf_len_,
                                       &my_callback_, truncate_);
@@ -405,6 +418,14 @@ void InFlightBackendIO::ReadData(EntryImpl* entry, int index, int offset,
   PostOperation(operation);
 }
 
+void InFlightBackendIO::MapData(EntryImpl* entry, int index, int offset,
+                                int buf_len, scoped_refptr<net::IOBuffer>* buf,
+                                OldCompletionCallback* callback) {
+  scoped_refptr<BackendIO> operation(new BackendIO(this, backend_, callback));
+  operation->MapData(entry, index, offset, buf_len, buf);
+  PostOperation(operation);
+}
+
 void InFlightBackendIO::WriteData(EntryImpl* entry, int index, int offset,
                                   net::IOBuffer* buf, int buf_len,
                                   bool truncate,
@@ -64,6 +64,8 @@ class BackendIO : public BackgroundIO {
   void RunTask(Task* task);
   void ReadData(EntryImpl* entry, int index, int offset, net::IOBuffer* buf,
                 int buf_len);
+  void MapData(EntryImpl* entry, int index, int offset, int buf_len,
+               scoped_refptr<net::IOBuffer>* buf);
   void WriteData(EntryImpl* entry, int index, int offset, net::IOBuffer* buf,
                  int buf_len, bool truncate);
   void ReadSparseData(EntryImpl* entry, int64 offset, net::IOBuffer* buf,
@@ -99,6 +101,7 @@ class BackendIO : public BackgroundIO {
     OP_RUN_TASK,
     OP_MAX_BACKEND,
     OP_READ,
+    OP_MAP,
     OP_WRITE,
     OP_READ_SPARSE,
     OP_WRITE_SPARSE,
@@ -129,6 +132,7 @@ class BackendIO : public BackgroundIO {
   int offset_;
   scoped_refptr<net::IOBuffer> buf_;
   int buf_len_;
+  scoped_refptr<net::IOBuffer>* map_buf_ptr_;
   bool truncate_;
   int64 offset64_;
   int64* start_;
@@ -170,6 +174,9 @@ class InFlightBackendIO : public InFlightIO {
   void RunTask(Task* task, net::OldCompletionCallback* callback);
   void ReadData(EntryImpl* entry, int index, int offset, net::IOBuffer* buf,
                 int buf_len, net::OldCompletionCallback* callback);
+  void MapData(EntryImpl* entry, int index, int offset, int buf_len,
+               scoped_refptr<net::IOBuffer>* buf,
+               net::OldCompletionCallback* callback);
   void WriteData(EntryImpl* entry, int index, int offset, net::IOBuffer* buf,
                  int buf_len, bool truncate, net::OldCompletionCallback* callback);
   void ReadSparseData(EntryImpl* entry, int64 offset, net::IOBuffer* buf,
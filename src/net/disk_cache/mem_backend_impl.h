@@ -50,9 +50,6 @@ class NET_EXPORT_PRIVATE MemBackendImpl : public Backend {
   // A user data block is being created, extended or truncated.
   void ModifyStorageSize(int32 old_size, int32 new_size);
 
-  // Returns the maximum size for a file to reside on the cache.
-  int MaxFileSize() const;
-
   // Insert an MemEntryImpl into the ranking list. This method is only called
   // from MemEntryImpl to insert child entries. The reference can be removed
   // by calling RemoveFromRankingList(|entry|).
@@ -64,6 +61,7 @@ class NET_EXPORT_PRIVATE MemBackendImpl : public Backend {
 
   // Backend interface.
   virtual int32 GetEntryCount() const;
+  virtual int MaxFileSize() const;
   virtual int OpenEntry(const std::string& key, Entry** entry,
                         OldCompletionCallback* callback);
   virtual int CreateEntry(const std::string& key, Entry** entry,
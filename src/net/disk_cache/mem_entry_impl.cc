@@ -185,6 +185,13 @@ int MemEntryImpl::ReadData(int index, int offset, net::IOBuffer* buf,
   return result;
 }
 
+int MemEntryImpl::MapData(int index, int offset, int buf_len,
+    scoped_refptr<net::IOBuffer>* buf,
+    net::OldCompletionCallback* completion_callback) {
+  // The data already lives in memory, so there is nothing to gain here.
+  return net::ERR_CACHE_OPERATION_NOT_SUPPORTED;
+}
+
 int MemEntryImpl::WriteData(int index, int offset, net::IOBuffer* buf,
     int buf_len, net::OldCompletionCallback* completion_callback, bool truncate) {
   if (net_log_.IsLoggingAllEvents()) {
@@ -100,6 +100,9 @@ class MemEntryImpl : public Entry {
   virtual int32 GetDataSize(int index) const;
   virtual int ReadData(int index, int offset, net::IOBuffer* buf, int buf_len,
                        net::OldCompletionCallback* completion_callback);
+  virtual int MapData(int index, int offset, int buf_len,
+                      scoped_refptr<net::IOBuffer>* buf,
+                      net::OldCompletionCallback* completion_callback);
   virtual int WriteData(int index, int offset, net::IOBuffer* buf, int buf_len,
                         net::OldCompletionCallback* completion_callback,
                         bool truncate);
@@ -0,0 +1,469 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/disk_cache/sharded_backend.h"
+
+#include "base/bind.h"
+#include "base/file_util.h"
+#include "base/logging.h"
+#include "base/message_loop_proxy.h"
+#include "base/stl_util.h"
+#include "base/stringprintf.h"
+#include "base/sys_info.h"
+#include "base/threading/thread.h"
+#include "net/base/net_errors.h"
+#include "net/disk_cache/backend_impl.h"
+#include "net/disk_cache/hash.h"
+#include "net/disk_cache/mem_backend_impl.h"
+#include "net/disk_cache/trace.h"
+
+namespace {
+
+// The position of an enumeration: the shard being enumerated and the iterator
+// of that shard.
+struct ShardIterator {
+  ShardIterator() : shard(0), shard_iter(NULL) {}
+
+  int shard;
+  void* shard_iter;
+};
+
+// Figures out the size of a sharded cache when the user does not set one.
+// Runs on a cache thread. The space used by existing shards counts as
+// available, the same way BackendImpl counts the space used by its own files.
+void ComputeMaxSize(const FilePath& path, int* max_bytes) {
+  int64 available = -1;
+  if (file_util::CreateDirectory(path)) {
+    available = base::SysInfo::AmountOfFreeDiskSpace(path);
+    if (available >= 0)
+      available += file_util::ComputeDirectorySize(path);
+  }
+  *max_bytes = disk_cache::DefaultMaxCacheSize(available);
+}
+
+}  // namespace
+
+namespace disk_cache {
+
+// ------------------------------------------------------------------------
+
+// This class takes care of starting the threads and creating the shards of a
+// ShardedBackend.
+class ShardedBackend::Creator {
+ public:
+  Creator(const FilePath& path, bool force, int max_bytes,
+          net::CacheType type, uint32 flags, int num_shards,
+          net::NetLog* net_log, Backend** backend,
+          OldCompletionCallback* callback)
+      : path_(path), force_(force), max_bytes_(max_bytes), type_(type),
+        flags_(flags), num_shards_(num_shards), net_log_(net_log),
+        backend_(backend), callback_(callback), cache_(NULL), pending_(0),
+        result_(net::OK),
+        ALLOW_THIS_IN_INITIALIZER_LIST(
+            my_callback_(this, &Creator::OnShardCreated)) {
+  }
+  ~Creator() {}
+
+  // Creates the backend.
+  int Run();
+
+ private:
+  void CreateShards();
+
+  // Callback implementation.
+  void OnShardCreated(int result);
+
+  void DoCallback(int result);
+
+  const FilePath path_;
+  bool force_;
+  int max_bytes_;
+  net::CacheType type_;
+  uint32 flags_;
+  int num_shards_;
+  net::NetLog* net_log_;
+  Backend** backend_;
+  OldCompletionCallback* callback_;
+  ShardedBackend* cache_;
+
+  // BackendImpl::CreateBackend() keeps a reference to the path of each shard
+  // until the shard is created, so the paths cannot move.
+  std::vector<FilePath> shard_paths_;
+
+  int pending_;  // Number of shards still being created.
+  int result_;   // First error reported by a shard.
+  net::OldCompletionCallbackImpl<Creator> my_callback_;
+
+  DISALLOW_COPY_AND_ASSIGN(Creator);
+};
+
+int ShardedBackend::Creator::Run() {
+  cache_ = new ShardedBackend();
+  cache_->trace_object_ = TraceObject::GetTraceObject();
+  for (int i = 0; i < num_shards_; i++) {
+    base::Thread* thread =
+        new base::Thread(base::StringPrintf("CacheThread_%d", i).c_str());
+    cache_->threads_.push_back(thread);
+    if (!thread->StartWithOptions(
+             base::Thread::Options(MessageLoop::TYPE_IO, 0))) {
+      LOG(ERROR) << "Unable to start the cache threads";
+      *backend_ = NULL;
+      delete cache_;
+      delete this;
+      return net::ERR_FAILED;
+    }
+    shard_paths_.push_back(
+        path_.AppendASCII(base::StringPrintf("shard_%d", i)));
+  }
+  cache_->shards_.resize(num_shards_, NULL);
+
+  if (max_bytes_) {
+    CreateShards();
+  } else {
+    cache_->threads_[0]->message_loop_proxy()->PostTaskAndReply(
+        FROM_HERE, base::Bind(&ComputeMaxSize, path_, &max_bytes_),
+        base::Bind(&Creator::CreateShards, base::Unretained(this)));
+  }
+  return net::ERR_IO_PENDING;
+}
+
+void ShardedBackend::Creator::CreateShards() {
+  // The shards receive about the same number of entries, so they get the same
+  // share of the space.
+  int shard_max_bytes = max_bytes_ / num_shards_;
+  pending_ = num_shards_;
+  for (int i = 0; i < num_shards_; i++) {
+    int rv = BackendImpl::CreateBackend(
+        shard_paths_[i], force_, shard_max_bytes, type_, flags_,
+        cache_->threads_[i]->message_loop_proxy(), net_log_,
+        &cache_->shards_[i], &my_callback_);
+    DCHECK_EQ(net::ERR_IO_PENDING, rv);
+  }
+}
+
+void ShardedBackend::Creator::OnShardCreated(int result) {
+  if (result != net::OK && result_ == net::OK)
+    result_ = result;
+  if (--pending_)
+    return;
+  DoCallback(result_);
+}
+
+void ShardedBackend::Creator::DoCallback(int result) {
+  DCHECK_NE(net::ERR_IO_PENDING, result);
+  if (result == net::OK) {
+    *backend_ = cache_;
+  } else {
+    LOG(ERROR) << "Unable to create sharded cache";
+    *backend_ = NULL;
+    delete cache_;
+  }
+  callback_->Run(result);
+  delete this;
+}
+
+// ------------------------------------------------------------------------
+
+// Base class for the operations that involve more than one shard. The
+// operation is deleted by the backend when it completes.
+class ShardedBackend::Operation {
+ public:
+  Operation(ShardedBackend* backend, OldCompletionCallback* callback)
+      : backend_(backend), user_callback_(callback),
+        ALLOW_THIS_IN_INITIALIZER_LIST(
+            callback_(this, &Operation::OnIOComplete)) {
+  }
+  virtual ~Operation() {}
+
+  // Starts the operation. Returns ERR_IO_PENDING if the user callback will be
+  // invoked later with the final result.
+  virtual int Start() = 0;
+
+ protected:
+  // Called with the result of each shard operation that returned
+  // ERR_IO_PENDING. Returns the final result of the operation, or
+  // ERR_IO_PENDING if it is not done yet.
+  virtual int OnShardComplete(int result) = 0;
+
+  ShardedBackend* backend_;
+  OldCompletionCallback* user_callback_;
+
+  // Passed to the shards.
+  net::OldCompletionCallbackImpl<Operation> callback_;
+
+ private:
+  void OnIOComplete(int result);
+
+  DISALLOW_COPY_AND_ASSIGN(Operation);
+};
+
+void ShardedBackend::Operation::OnIOComplete(int result) {
+  int rv = OnShardComplete(result);
+  if (rv == net::ERR_IO_PENDING)
+    return;
+
+  // The user callback may delete the backend.
+  OldCompletionCallback* callback = user_callback_;
+  backend_->OnOperationComplete(this);
+  callback->Run(rv);
+}
+
+// Dooms the entries of every shard that were used between two given times. A
+// null time means that the range is not bounded on that side.
+class ShardedBackend::DoomOperation : public ShardedBackend::Operation {
+ public:
+  DoomOperation(ShardedBackend* backend, const base::Time initial_time,
+                const base::Time end_time, OldCompletionCallback* callback)
+      : Operation(backend, callback), initial_time_(initial_time),
+        end_time_(end_time), pending_(0), result_(net::OK) {
+  }
+
+  virtual int Start();
+
+ protected:
+  virtual int OnShardComplete(int result);
+
+ private:
+  void RecordResult(int result) {
+    if (result != net::OK && result_ == net::OK)
+      result_ = result;
+  }
+
+  const base::Time initial_time_;
+  const base::Time end_time_;
+  int pending_;  // Number of shards that have not completed yet.
+  int result_;   // First error reported by a shard.
+};
+
+int ShardedBackend::DoomOperation::Start() {
+  // Keep one extra count until all the shards are started, so that a shard
+  // that completes right away cannot finish the operation early.
+  pending_ = 1;
+  for (size_t i = 0; i < backend_->shards_.size(); i++) {
+    Backend* shard = backend_->shards_[i];
+    int rv;
+    if (initial_time_.is_null() && end_time_.is_null())
+      rv = shard->DoomAllEntries(&callback_);
+    else
+      rv = shard->DoomEntriesBetween(initial_time_, end_time_, &callback_);
+
+    if (rv == net::ERR_IO_PENDING)
+      pending_++;
+    else
+      RecordResult(rv);
+  }
+  return --pending_ ? net::ERR_IO_PENDING : result_;
+}
+
+int ShardedBackend::DoomOperation::OnShardComplete(int result) {
+  RecordResult(result);
+  return --pending_ ? net::ERR_IO_PENDING : result_;
+}
+
+// Returns the next entry of an enumeration, moving on to the next shard when
+// the current one has no more entries.
+class ShardedBackend::EnumerationOperation : public ShardedBackend::Operation {
+ public:
+  EnumerationOperation(ShardedBackend* backend, void** iter,
+                       Entry** next_entry, OldCompletionCallback* callback)
+      : Operation(backend, callback), iter_(iter), next_entry_(next_entry) {
+  }
+
+  virtual int Start();
+
+ protected:
+  virtual int OnShardComplete(int result);
+
+ private:
+  ShardIterator* iterator() {
+    return reinterpret_cast<ShardIterator*>(*iter_);
+  }
+
+  // Asks the shards for the next entry, starting with the current shard.
+  int OpenNextEntry();
+
+  void** iter_;
+  Entry** next_entry_;
+};
+
+int ShardedBackend::EnumerationOperation::Start() {
+  if (!*iter_)
+    *iter_ = new ShardIterator;
+  return OpenNextEntry();
+}
+
+int ShardedBackend::EnumerationOperation::OnShardComplete(int result) {
+  if (result != net::ERR_FAILED)
+    return result;
+
+  // The shard has no more entries, and it already released its iterator.
+  DCHECK(!iterator()->shard_iter);
+  iterator()->shard++;
+  return OpenNextEntry();
+}
+
+int ShardedBackend::EnumerationOperation::OpenNextEntry() {
+  ShardIterator* iterator = this->iterator();
+  while (iterator->shard < backend_->num_shards()) {
+    Backend* shard = backend_->shards_[iterator->shard];
+    int rv = shard->OpenNextEntry(&iterator->shard_iter, next_entry_,
+                                  &callback_);
+    if (rv != net::ERR_FAILED)
+      return rv;
+    iterator->shard++;
+  }
+
+  delete iterator;
+  *iter_ = NULL;
+  return net::ERR_FAILED;
+}
+
+// ------------------------------------------------------------------------
+
+ShardedBackend::ShardedBackend() {
+}
+
+ShardedBackend::~ShardedBackend() {
+  // Deleting the shards cancels the callbacks of the operations in progress,
+  // and waits for the cache threads to finish their work.
+  STLDeleteElements(&shards_);
+  STLDeleteElements(&pending_ops_);
+}
+
+// Static.
+int ShardedBackend::CreateBackend(const FilePath& path, bool force,
+                                  int max_bytes, net::CacheType type,
+                                  uint32 flags, int num_shards,
+                                  net::NetLog* net_log, Backend** backend,
+                                  OldCompletionCallback* callback) {
+  DCHECK(callback);
+  DCHECK_NE(net::MEMORY_CACHE, type);
+  if (num_shards < 1 || num_shards > kMaxShards || max_bytes < 0)
+    return net::ERR_INVALID_ARGUMENT;
+
+  Creator* creator = new Creator(path, force, max_bytes, type, flags,
+                                 num_shards, net_log, backend, callback);
+  // This object will self-destroy when finished.
+  return creator->Run();
+}
+
+int ShardedBackend::ShardForKey(const std::string& key) const {
+  // Each shard finds the bucket of an entry in its index from the low bits of
+  // the hash, so the shard is picked from the high bits. Otherwise every shard
+  // would only use a fraction of its index.
+  return (Hash(key) >> 24) % shards_.size();
+}
+
+int32 ShardedBackend::GetEntryCount() const {
+  int32 count = 0;
+  for (size_t i = 0; i < shards_.size(); i++)
+    count += shards_[i]->GetEntryCount();
+  return count;
+}
+
+int ShardedBackend::MaxFileSize() const {
+  // The shards share the size of the cache evenly.
+  return shards_[0]->MaxFileSize();
+}
+
+int ShardedBackend::OpenEntry(const std::string& key, Entry** entry,
+                              OldCompletionCallback* callback) {
+  return shards_[ShardForKey(key)]->OpenEntry(key, entry, callback);
+}
+
+int ShardedBackend::CreateEntry(const std::string& key, Entry** entry,
+                                OldCompletionCallback* callback) {
+  return shards_[ShardForKey(key)]->CreateEntry(key, entry, callback);
+}
+
+int ShardedBackend::DoomEntry(const std::string& key,
+                              OldCompletionCallback* callback) {
+  return shards_[ShardForKey(key)]->DoomEntry(key, callback);
+}
+
+int ShardedBackend::DoomAllEntries(OldCompletionCallback* callback) {
+  return StartOperation(new DoomOperation(this, base::Time(), base::Time(),
+                                          callback));
+}
+
+int ShardedBackend::DoomEntriesBetween(const base::Time initial_time,
+                                       const base::Time end_time,
+                                       OldCompletionCallback* callback) {
+  return StartOperation(new DoomOperation(this, initial_time, end_time,
+                                          callback));
+}
+
+int ShardedBackend::DoomEntriesSince(const base::Time initial_time,
+                                     OldCompletionCallback* callback) {
+  return StartOperation(new DoomOperation(this, initial_time, base::Time(),
+                                          callback));
+}
+
+int ShardedBackend::OpenNextEntry(void** iter, Entry** next_entry,
+                                  OldCompletionCallback* callback) {
+  return StartOperation(new EnumerationOperation(this, iter, next_entry,
+                                                 callback));
+}
+
+void ShardedBackend::EndEnumeration(void** iter) {
+  ShardIterator* iterator = reinterpret_cast<ShardIterator*>(*iter);
+  if (!iterator)
+    return;
+
+  if (iterator->shard < num_shards())
+    shards_[iterator->shard]->EndEnumeration(&iterator->shard_iter);
+  delete iterator;
+  *iter = NULL;
+}
+
+void ShardedBackend::GetStats(
+    std::vector<std::pair<std::string, std::string> >* stats) {
+  for (size_t i = 0; i < shards_.size(); i++) {
+    std::vector<std::pair<std::string, std::string> > shard_stats;
+    shards_[i]->GetStats(&shard_stats);
+    for (size_t j = 0; j < shard_stats.size(); j++) {
+      stats->push_back(std::make_pair(
+          base::StringPrintf("Shard %d: %s", static_cast<int>(i),
+                             shard_stats[j].first.c_str()),
+          shard_stats[j].second));
+    }
+  }
+}
+
+void ShardedBackend::OnExternalCacheHit(const std::string& key) {
+  shards_[ShardForKey(key)]->OnExternalCacheHit(key);
+}
+
+int ShardedBackend::StartOperation(Operation* op) {
+  int rv = op->Start();
+  if (rv == net::ERR_IO_PENDING)
+    pending_ops_.insert(op);
+  else
+    delete op;
+  return rv;
+}
+
+void ShardedBackend::OnOperationComplete(Operation* op) {
+  DCHECK(pending_ops_.count(op));
+  pending_ops_.erase(op);
+  delete op;
+}
+
+// ------------------------------------------------------------------------
+
+int CreateShardedCacheBackend(net::CacheType type, const FilePath& path,
+                              int max_bytes, bool force, int num_shards,
+                              net::NetLog* net_log, Backend** backend,
+                              OldCompletionCallback* callback) {
+  DCHECK(callback);
+  if (type == net::MEMORY_CACHE) {
+    *backend = MemBackendImpl::CreateBackend(max_bytes, net_log);
+    return *backend ? net::OK : net::ERR_FAILED;
+  }
+
+  return ShardedBackend::CreateBackend(path, force, max_bytes, type, kNone,
+                                       num_shards, net_log, backend, callback);
+}
+
+}  // namespace disk_cache
@@ -0,0 +1,121 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// See net/disk_cache/disk_cache.h for the public interface of the cache.
+
+#ifndef NET_DISK_CACHE_SHARDED_BACKEND_H_
+#define NET_DISK_CACHE_SHARDED_BACKEND_H_
+#pragma once
+
+#include <set>
+#include <string>
+#include <vector>
+
+#include "base/file_path.h"
+#include "base/memory/ref_counted.h"
+#include "base/memory/scoped_vector.h"
+#include "net/base/net_export.h"
+#include "net/disk_cache/disk_cache.h"
+
+namespace base {
+class Thread;
+}
+
+namespace net {
+class NetLog;
+}  // namespace net
+
+namespace disk_cache {
+
+class TraceObject;
+
+// This class implements the Backend interface by splitting the key space among
+// a number of independent BackendImpl instances (shards). Every shard has its
+// own index, block files and cache thread, so operations on keys that map to
+// different shards run in parallel instead of queueing behind a single cache
+// thread. Shard |i| lives in the "shard_<i>" sub-folder of the cache folder.
+//
+// Operations on a single key go straight to the shard that owns the key.
+// Operations on the whole cache (dooming entries by time, enumerations,
+// statistics) are forwarded to every shard in turn.
+class NET_EXPORT_PRIVATE ShardedBackend : public Backend {
+ public:
+  // The largest number of shards that a cache can be split into.
+  static const int kMaxShards = 32;
+
+  virtual ~ShardedBackend();
+
+  // Performs general initialization for the sharded cache. |num_shards| must
+  // be between 1 and kMaxShards, and it should not change between runs for a
+  // given |path|, because entries would no longer be found on the shard that
+  // stores them. |max_bytes| is the maximum size of the whole cache, split
+  // evenly among the shards; if it is zero, the value is derived from the
+  // available disk space. See CreateCacheBackend() for the other arguments.
+  static int CreateBackend(const FilePath& path, bool force, int max_bytes,
+                           net::CacheType type, uint32 flags, int num_shards,
+                           net::NetLog* net_log, Backend** backend,
+                           OldCompletionCallback* callback);
+
+  int num_shards() const { return static_cast<int>(shards_.size()); }
+
+  // Returns the shard that stores the entry for |key|.
+  int ShardForKey(const std::string& key) const;
+
+  // Backend interface.
+  virtual int32 GetEntryCount() const;
+  virtual int MaxFileSize() const;
+  virtual int OpenEntry(const std::string& key, Entry** entry,
+                        OldCompletionCallback* callback);
+  virtual int CreateEntry(const std::string& key, Entry** entry,
+                          OldCompletionCallback* callback);
+  virtual int DoomEntry(const std::string& key,
+                        OldCompletionCallback* callback);
+  virtual int DoomAllEntries(OldCompletionCallback* callback);
+  virtual int DoomEntriesBetween(const base::Time initial_time,
+                                 const base::Time end_time,
+                                 OldCompletionCallback* callback);
+  virtual int DoomEntriesSince(const base::Time initial_time,
+                               OldCompletionCallback* callback);
+  virtual int OpenNextEntry(void** iter, Entry** next_entry,
+                            OldCompletionCallback* callback);
+  virtual void EndEnumeration(void** iter);
+  virtual void GetStats(
+      std::vector<std::pair<std::string, std::string> >* stats);
+  virtual void OnExternalCacheHit(const std::string& key);
+
+ private:
+  class Creator;
+  class Operation;
+  class DoomOperation;
+  class EnumerationOperation;
+  friend class Creator;
+  friend class Operation;
+
+  ShardedBackend();
+
+  // Starts |op| and returns its result, deleting it if it completed
+  // synchronously.
+  int StartOperation(Operation* op);
+
+  // Called by |op| when it completes after StartOperation() returned
+  // ERR_IO_PENDING.
+  void OnOperationComplete(Operation* op);
+
+  // Owned by this object. They are destroyed before |threads_|.
+  std::vector<Backend*> shards_;
+  ScopedVector<base::Thread> threads_;
+
+  // Operations that span several shards and have not completed yet.
+  std::set<Operation*> pending_ops_;
+
+  // The shards take and drop references to the trace object from different
+  // threads. Holding one here keeps it from being destroyed while they do.
+  scoped_refptr<TraceObject> trace_object_;
+
+  DISALLOW_COPY_AND_ASSIGN(ShardedBackend);
+};
+
+}  // namespace disk_cache
+
+#endif  // NET_DISK_CACHE_SHARDED_BACKEND_H_
@@ -0,0 +1,235 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <set>
+#include <string>
+
+#include "base/basictypes.h"
+#include "base/file_util.h"
+#include "base/stringprintf.h"
+#include "net/base/io_buffer.h"
+#include "net/base/net_errors.h"
+#include "net/base/test_completion_callback.h"
+#include "net/disk_cache/backend_impl.h"
+#include "net/disk_cache/disk_cache_test_base.h"
+#include "net/disk_cache/disk_cache_test_util.h"
+#include "net/disk_cache/sharded_backend.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+using base::Time;
+
+namespace {
+
+const int kNumShards = 4;
+const int kNumEntries = 100;
+
+class DiskCacheShardedBackendTest : public DiskCacheTest {
+ protected:
+  DiskCacheShardedBackendTest() : cache_(NULL) {}
+
+  virtual void TearDown() {
+    delete cache_;
+    cache_ = NULL;
+    MessageLoop::current()->RunAllPending();
+  }
+
+  int InitCache(int num_shards, int max_bytes) {
+    TestOldCompletionCallback cb;
+    int rv = disk_cache::ShardedBackend::CreateBackend(
+                 test_cache_.path(), false, max_bytes, net::DISK_CACHE,
+                 disk_cache::kNoRandom, num_shards, NULL, &cache_, &cb);
+    return cb.GetResult(rv);
+  }
+
+  void ReopenCache(int num_shards) {
+    delete cache_;
+    cache_ = NULL;
+    ASSERT_EQ(net::OK, InitCache(num_shards, 0));
+  }
+
+  // Creates |num_entries| entries, storing the key of each entry as its data.
+  void CreateEntries(int num_entries, std::set<std::string>* keys) {
+    for (int i = 0; i < num_entries; i++) {
+      std::string key = base::StringPrintf("the key %d", i);
+      disk_cache::Entry* entry;
+      TestOldCompletionCallback cb;
+      int rv = cache_->CreateEntry(key, &entry, &cb);
+      ASSERT_EQ(net::OK, cb.GetResult(rv));
+
+      scoped_refptr<net::StringIOBuffer> buffer(new net::StringIOBuffer(key));
+      rv = entry->WriteData(0, 0, buffer, buffer->size(), &cb, false);
+      EXPECT_EQ(buffer->size(), cb.GetResult(rv));
+      entry->Close();
+      if (keys)
+        keys->insert(key);
+    }
+  }
+
+  disk_cache::ShardedBackend* sharded_cache() {
+    return static_cast<disk_cache::ShardedBackend*>(cache_);
+  }
+
+  ScopedTestCache test_cache_;
+  disk_cache::Backend* cache_;
+};
+
+}  // namespace
+
+TEST_F(DiskCacheShardedBackendTest, InvalidArguments) {
+  EXPECT_EQ(net::ERR_INVALID_ARGUMENT, InitCache(0, 0));
+  EXPECT_EQ(net::ERR_INVALID_ARGUMENT,
+            InitCache(disk_cache::ShardedBackend::kMaxShards + 1, 0));
+  EXPECT_EQ(net::ERR_INVALID_ARGUMENT, InitCache(kNumShards, -1));
+  EXPECT_TRUE(cache_ == NULL);
+}
+
+TEST_F(DiskCacheShardedBackendTest, PublicAPI) {
+  TestOldCompletionCallback cb;
+  int rv = disk_cache::CreateShardedCacheBackend(
+               net::DISK_CACHE, test_cache_.path(), 0, false, kNumShards, NULL,
+               &cache_, &cb);
+  ASSERT_EQ(net::OK, cb.GetResult(rv));
+  ASSERT_TRUE(cache_ != NULL);
+  delete cache_;
+  cache_ = NULL;
+
+  rv = disk_cache::CreateShardedCacheBackend(
+           net::MEMORY_CACHE, FilePath(), 0, false, kNumShards, NULL, &cache_,
+           &cb);
+  ASSERT_EQ(net::OK, cb.GetResult(rv));
+  ASSERT_TRUE(cache_ != NULL);
+}
+
+TEST_F(DiskCacheShardedBackendTest, ShardFolders) {
+  ASSERT_EQ(net::OK, InitCache(kNumShards, 0));
+  EXPECT_EQ(kNumShards, sharded_cache()->num_shards());
+  for (int i = 0; i < kNumShards; i++) {
+    FilePath shard_path =
+        test_cache_.path().AppendASCII(base::StringPrintf("shard_%d", i));
+    EXPECT_TRUE(file_util::PathExists(shard_path.AppendASCII("index")));
+    EXPECT_TRUE(file_util::PathExists(shard_path.AppendASCII("data_0")));
+  }
+}
+
+TEST_F(DiskCacheShardedBackendTest, KeysSpreadAcrossShards) {
+  ASSERT_EQ(net::OK, InitCache(kNumShards, 0));
+
+  int entries_per_shard[kNumShards] = { 0 };
+  for (int i = 0; i < 1000; i++) {
+    std::string key = GenerateKey(true);
+    int shard = sharded_cache()->ShardForKey(key);
+    ASSERT_GE(shard, 0);
+    ASSERT_LT(shard, kNumShards);
+    EXPECT_EQ(shard, sharded_cache()->ShardForKey(key));
+    entries_per_shard[shard]++;
+  }
+  for (int i = 0; i < kNumShards; i++)
+    EXPECT_GT(entries_per_shard[i], 1000 / kNumShards / 2);
+}
+
+TEST_F(DiskCacheShardedBackendTest, Basics) {
+  ASSERT_EQ(net::OK, InitCache(kNumShards, 10 * 1024 * 1024));
+  CreateEntries(kNumEntries, NULL);
+  EXPECT_EQ(kNumEntries, cache_->GetEntryCount());
+
+  TestOldCompletionCallback cb;
+  disk_cache::Entry* entry;
+  int rv = cache_->CreateEntry("the key 1", &entry, &cb);
+  EXPECT_NE(net::OK, cb.GetResult(rv));
+
+  rv = cache_->DoomEntry("the key 1", &cb);
+  EXPECT_EQ(net::OK, cb.GetResult(rv));
+  rv = cache_->OpenEntry("the key 1", &entry, &cb);
+  EXPECT_NE(net::OK, cb.GetResult(rv));
+  EXPECT_EQ(kNumEntries - 1, cache_->GetEntryCount());
+
+  // The entries are still there after restarting the cache.
+  ReopenCache(kNumShards);
+  EXPECT_EQ(kNumEntries - 1, cache_->GetEntryCount());
+  for (int i = 2; i < kNumEntries; i++) {
+    std::string key = base::StringPrintf("the key %d", i);
+    rv = cache_->OpenEntry(key, &entry, &cb);
+    ASSERT_EQ(net::OK, cb.GetResult(rv));
+
+    scoped_refptr<net::IOBuffer> buffer(new net::IOBuffer(100));
+    rv = entry->ReadData(0, 0, buffer, 100, &cb);
+    ASSERT_EQ(static_cast<int>(key.size()), cb.GetResult(rv));
+    EXPECT_EQ(key, std::string(buffer->data(), key.size()));
+    entry->Close();
+  }
+}
+
+TEST_F(DiskCacheShardedBackendTest, Enumerations) {
+  ASSERT_EQ(net::OK, InitCache(kNumShards, 0));
+  std::set<std::string> keys;
+  CreateEntries(kNumEntries, &keys);
+
+  void* iter = NULL;
+  disk_cache::Entry* entry;
+  TestOldCompletionCallback cb;
+  int count = 0;
+  for (;;) {
+    int rv = cache_->OpenNextEntry(&iter, &entry, &cb);
+    if (cb.GetResult(rv) != net::OK)
+      break;
+    EXPECT_EQ(1u, keys.erase(entry->GetKey()));
+    entry->Close();
+    count++;
+  }
+  EXPECT_EQ(kNumEntries, count);
+  EXPECT_TRUE(keys.empty());
+  EXPECT_TRUE(iter == NULL);
+
+  // An enumeration can be abandoned halfway.
+  for (int i = 0; i < kNumEntries / 2; i++) {
+    int rv = cache_->OpenNextEntry(&iter, &entry, &cb);
+    ASSERT_EQ(net::OK, cb.GetResult(rv));
+    entry->Close();
+  }
+  cache_->EndEnumeration(&iter);
+  EXPECT_TRUE(iter == NULL);
+}
+
+TEST_F(DiskCacheShardedBackendTest, DoomEntries) {
+  ASSERT_EQ(net::OK, InitCache(kNumShards, 0));
+  CreateEntries(kNumEntries, NULL);
+
+  TestOldCompletionCallback cb;
+  int rv = cache_->DoomEntriesSince(Time::Now() + base::TimeDelta::FromHours(1),
+                                    &cb);
+  ASSERT_EQ(net::OK, cb.GetResult(rv));
+  EXPECT_EQ(kNumEntries, cache_->GetEntryCount());
+
+  rv = cache_->DoomEntriesBetween(Time(), Time::Now(), &cb);
+  ASSERT_EQ(net::OK, cb.GetResult(rv));
+  EXPECT_EQ(0, cache_->GetEntryCount());
+
+  CreateEntries(kNumEntries, NULL);
+  rv = cache_->DoomAllEntries(&cb);
+  ASSERT_EQ(net::OK, cb.GetResult(rv));
+  EXPECT_EQ(0, cache_->GetEntryCount());
+}
+
+// Deleting the cache cancels the operations in progress.
+TEST_F(DiskCacheShardedBackendTest, DeleteWithPendingOperations) {
+  ASSERT_EQ(net::OK, InitCache(kNumShards, 0));
+  CreateEntries(kNumEntries, NULL);
+
+  TestOldCompletionCallback cb;
+  EXPECT_EQ(net::ERR_IO_PENDING, cache_->DoomAllEntries(&cb));
+  delete cache_;
+  cache_ = NULL;
+  MessageLoop::current()->RunAllPending();
+  EXPECT_FALSE(cb.have_result());
+}
+
+TEST_F(DiskCacheShardedBackendTest, Stats) {
+  ASSERT_EQ(net::OK, InitCache(kNumShards, 0));
+  std::vector<std::pair<std::string, std::string> > stats;
+  cache_->GetStats(&stats);
+  ASSERT_FALSE(stats.empty());
+  EXPECT_EQ(0u, stats.front().first.find("Shard 0: "));
+  EXPECT_EQ(0u, stats.back().first.find(
+      base::StringPrintf("Shard %d: ", kNumShards - 1)));
+}
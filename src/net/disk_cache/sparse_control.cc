@@ -440,7 +440,7 @@ bool SparseControl::OpenChild() {
   if (!ChildPresent())
     return ContinueWithoutChild(key);
 
-  child_ = entry_->backend_->OpenEntryImpl(key);
+  child_ = entry_->backend_->OpenEntryImpl(key, false);
   if (!child_)
     return ContinueWithoutChild(key);
 
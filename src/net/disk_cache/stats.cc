@@ -60,7 +60,10 @@ static const char* kCounterNames[] = {
   "Fatal error",
   "Last report",
   "Last report timer",
-  "Doom recent entries"
+  "Doom recent entries",
+  "Entry IO",
+  "Entry IO bytes",
+  "Open IO"
 };
 COMPILE_ASSERT(arraysize(kCounterNames) == disk_cache::Stats::MAX_COUNTER,
                update_the_names);
@@ -189,6 +192,13 @@ int64 Stats::GetCounter(Counters counter) const {
   return counters_[counter];
 }
 
+void Stats::OnEntryIO(int num_calls, int bytes) {
+  DCHECK_GE(num_calls, 0);
+  DCHECK_GE(bytes, 0);
+  counters_[ENTRY_IO] += num_calls;
+  counters_[ENTRY_IO_BYTES] += bytes;
+}
+
 void Stats::GetItems(StatsItems* items) {
   std::pair<std::string, std::string> item;
   for (int i = 0; i < kDataSizesLength; i++) {
@@ -202,6 +212,14 @@ void Stats::GetItems(StatsItems* items) {
     item.second = base::StringPrintf("0x%" PRIx64, counters_[i]);
     items->push_back(item);
   }
+
+  item.first = "Read ahead syscalls per open";
+  item.second = GetAverage(OPEN_IO, OPEN_HIT);
+  items->push_back(item);
+
+  item.first = "Bytes per syscall";
+  item.second = GetAverage(ENTRY_IO_BYTES, ENTRY_IO);
+  items->push_back(item);
 }
 
 int Stats::GetHitRatio() const {
@@ -217,6 +235,10 @@ void Stats::ResetRatios() {
   SetCounter(OPEN_MISS, 0);
   SetCounter(RESURRECT_HIT, 0);
   SetCounter(CREATE_HIT, 0);
+
+  // Read ahead syscalls per open are measured over the same period as the hit
+  // ratio.
+  SetCounter(OPEN_IO, 0);
 }
 
 int Stats::GetLargeEntriesSize() {
@@ -326,4 +348,12 @@ int Stats::GetRatio(Counters hit, Counters miss) const {
   return static_cast<int>(ratio);
 }
 
+std::string Stats::GetAverage(Counters total, Counters count) const {
+  if (!GetCounter(count))
+    return "0";
+
+  return base::StringPrintf("%.2f", static_cast<double>(GetCounter(total)) /
+                                    GetCounter(count));
+}
+
 }  // namespace disk_cache
@@ -46,6 +46,9 @@ class Stats {
     LAST_REPORT,  // Time of the last time we sent a report.
     LAST_REPORT_TIMER,  // Timer count of the last time we sent a report.
     DOOM_RECENT,  // The cache was partially cleared.
+    ENTRY_IO,  // System calls issued to read or write entries.
+    ENTRY_IO_BYTES,  // Bytes moved by the ENTRY_IO calls.
+    OPEN_IO,  // ENTRY_IO calls issued by the read ahead of opened entries.
     MAX_COUNTER
   };
 
@@ -62,6 +65,10 @@ class Stats {
   void SetCounter(Counters counter, int64 value);
   int64 GetCounter(Counters counter) const;
 
+  // Tracks |num_calls| system calls that read or wrote |bytes| bytes of entry
+  // data or metadata.
+  void OnEntryIO(int num_calls, int bytes);
+
   void GetItems(StatsItems* items);
   int GetHitRatio() const;
   int GetResurrectRatio() const;
@@ -82,6 +89,9 @@ class Stats {
   int GetStatsBucket(int32 size);
   int GetRatio(Counters hit, Counters miss) const;
 
+  // Returns |total| / |count|, as a string.
+  std::string GetAverage(Counters total, Counters count) const;
+
   BackendImpl* backend_;
   uint32 storage_addr_;
   int data_sizes_[kDataSizesLength];
@@ -88,6 +88,10 @@ template<typename T> void StorageBlock<T>::set_modified() {
   modified_ = true;
 }
 
+template<typename T> bool StorageBlock<T>::modified() const {
+  return modified_;
+}
+
 template<typename T> T* StorageBlock<T>::Data() {
   if (!data_)
     AllocateData();
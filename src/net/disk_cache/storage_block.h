@@ -55,6 +55,9 @@ class StorageBlock : public FileBlock {
   // Sets the object to lazily save the in-memory data on destruction.
   void set_modified();
 
+  // Returns true if the in-memory data was modified and not saved yet.
+  bool modified() const;
+
   // Gets a pointer to the internal storage (allocates storage if needed).
   T* Data();
 
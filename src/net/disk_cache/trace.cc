@@ -9,7 +9,9 @@
 #include <windows.h>
 #endif
 
+#include "base/lazy_instance.h"
 #include "base/logging.h"
+#include "base/synchronization/lock.h"
 
 // Change this value to 1 to enable tracing on a release build. By default,
 // tracing is enabled only on debug builds.
@@ -50,8 +52,13 @@ namespace disk_cache {
 // must be straightforward to access the buffer from the debugger.
 static TraceObject* s_trace_object = NULL;
 
+// Protects s_trace_object and s_trace_buffer from concurrent access by caches
+// running on different threads.
+static base::LazyInstance<base::Lock> s_trace_lock(base::LINKER_INITIALIZED);
+
 // Static.
 TraceObject* TraceObject::GetTraceObject() {
+  base::AutoLock lock(s_trace_lock.Get());
   if (s_trace_object)
     return s_trace_object;
 
@@ -59,11 +66,13 @@ TraceObject* TraceObject::GetTraceObject() {
   return s_trace_object;
 }
 
+// The lock is already held by GetTraceObject().
 TraceObject::TraceObject() {
   InitTrace();
 }
 
 TraceObject::~TraceObject() {
+  base::AutoLock lock(s_trace_lock.Get());
   DestroyTrace();
 }
 
@@ -72,6 +81,7 @@ TraceObject::~TraceObject() {
 static TraceBuffer* s_trace_buffer = NULL;
 
 void InitTrace(void) {
+  s_trace_lock.Get().AssertAcquired();
   if (s_trace_buffer)
     return;
 
@@ -80,12 +90,14 @@ void InitTrace(void) {
 }
 
 void DestroyTrace(void) {
+  s_trace_lock.Get().AssertAcquired();
   delete s_trace_buffer;
   s_trace_buffer = NULL;
   s_trace_object = NULL;
 }
 
 void Trace(const char* format, ...) {
+  base::AutoLock lock(s_trace_lock.Get());
   if (!s_trace_buffer)
     return;
 
@@ -109,6 +121,7 @@ void Trace(const char* format, ...) {
 
 // Writes the last num_traces to the debugger output.
 void DumpTrace(int num_traces) {
+  base::AutoLock lock(s_trace_lock.Get());
   DCHECK(s_trace_buffer);
   DebugOutput("Last traces:\n");
 
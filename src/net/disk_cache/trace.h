@@ -22,8 +22,10 @@ void DestroyTrace(void);
 
 // Simple class to handle the trace buffer lifetime. Any object interested in
 // tracing should keep a reference to the object returned by GetTraceObject().
-class TraceObject : public base::RefCounted<TraceObject> {
-  friend class base::RefCounted<TraceObject>;
+// The trace buffer is shared by all the caches in the process, which may run
+// on different threads (see ShardedBackend).
+class TraceObject : public base::RefCountedThreadSafe<TraceObject> {
+  friend class base::RefCountedThreadSafe<TraceObject>;
  public:
   static TraceObject* GetTraceObject();
 
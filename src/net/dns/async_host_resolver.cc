@@ -8,6 +8,8 @@
 
 #include "base/bind.h"
 #include "base/logging.h"
+#include "base/memory/weak_ptr.h"
+#include "base/message_loop.h"
 #include "base/rand_util.h"
 #include "base/stl_util.h"
 #include "base/values.h"
@@ -20,9 +22,28 @@ namespace net {
 
 namespace {
 
-// TODO(agayev): fix this when IPv6 support is added.
-uint16 QueryTypeFromAddressFamily(AddressFamily address_family) {
-  return kDNS_A;
+// The smoothed round-trip time of a name server is updated with 1/8 of every
+// new sample, like the SRTT of TCP (RFC 2988).
+const int kSrttSampleWeight = 8;
+
+// When a name server doesn't answer, its round-trip time is doubled, to at
+// least the first timeout of DnsTransaction and at most a minute.
+const int kMinTimeoutPenaltyMs = 3000;
+const int kMaxSrttMs = 60000;
+
+// Every time another server is picked, the round-trip time of the others
+// decays by 2%, so that a server that was slow or didn't answer is eventually
+// tried again.
+const int kSrttDecayPercent = 98;
+
+// The number of dots in a hostname below which the suffixes of the search list
+// are tried first, when the configuration doesn't say; see DnsConfig::ndots.
+const int kDefaultNdots = 1;
+
+// Returns true if a query that failed with |result| should be sent to another
+// name server: the server didn't give a usable answer.
+bool ShouldTryNextServer(int result) {
+  return result != OK && result != ERR_NAME_NOT_RESOLVED;
 }
 
 class RequestParameters : public NetLog::EventParameters {
@@ -71,6 +92,23 @@ HostResolver* CreateAsyncHostResolver(size_t max_concurrent_resolves,
   return resolver;
 }
 
+HostResolver* CreateSystemAsyncHostResolver(size_t max_concurrent_resolves,
+                                            NetLog* net_log) {
+  size_t max_transactions = max_concurrent_resolves;
+  if (max_transactions == 0)
+    max_transactions = 20;
+  size_t max_pending_requests = max_transactions * 100;
+  HostResolver* resolver = new AsyncHostResolver(
+      DnsConfigService::CreateSystemService(),
+      max_transactions,
+      max_pending_requests,
+      base::Bind(&base::RandInt),
+      HostCache::CreateDefaultCache(),
+      NULL,
+      net_log);
+  return resolver;
+}
+
 //-----------------------------------------------------------------------------
 // Every call to Resolve() results in Request object being created.  Such a
 // call may complete either synchronously or asynchronously or it may get
@@ -99,9 +137,12 @@ class AsyncHostResolver::Request {
     DCHECK(addresses_);
     DCHECK(resolver_);
     resolver_->OnStart(this);
+    AddressFamily address_family = info.address_family();
+    if (address_family == ADDRESS_FAMILY_UNSPECIFIED)
+      address_family = resolver_->default_address_family_;
     std::string dns_name;
     if (DNSDomainFromDot(info.hostname(), &dns_name))
-      key_ = Key(dns_name, QueryTypeFromAddressFamily(info.address_family()));
+      key_ = Key(dns_name, address_family);
   }
 
   ~Request() {
@@ -120,12 +161,20 @@ class AsyncHostResolver::Request {
   const BoundNetLog& source_net_log() const { return source_net_log_; }
   const BoundNetLog& request_net_log() const { return request_net_log_; }
 
+  // The key of the result of this request in the HostCache.
+  HostCache::Key cache_key() const {
+    return HostCache::Key(info_.hostname(), key_.second,
+                          info_.host_resolver_flags());
+  }
+
   bool ResolveAsIp() {
     IPAddressNumber ip_number;
     if (!ParseIPLiteralToNumber(info_.hostname(), &ip_number))
       return false;
 
-    if (ip_number.size() != kIPv4AddressSize) {
+    // IPv6 literals are rejected when IPv6 has been disabled.
+    if (ip_number.size() != kIPv4AddressSize &&
+        resolver_->default_address_family_ == ADDRESS_FAMILY_IPV4) {
       result_ = ERR_NAME_NOT_RESOLVED;
     } else {
       *addresses_ = AddressList::CreateFromIPAddressWithCname(
@@ -142,27 +191,54 @@ class AsyncHostResolver::Request {
     if (!cache || !info_.allow_cached_response())
       return false;
 
-    HostCache::Key key(info_.hostname(), info_.address_family(),
-                       info_.host_resolver_flags());
     const HostCache::Entry* cache_entry = cache->Lookup(
-        key, base::TimeTicks::Now());
+        cache_key(), base::TimeTicks::Now());
     if (cache_entry) {
       request_net_log_.AddEvent(
           NetLog::TYPE_ASYNC_HOST_RESOLVER_CACHE_HIT, NULL);
-      DCHECK_EQ(OK, cache_entry->error);
       result_ = cache_entry->error;
-      *addresses_ =
-        CreateAddressListUsingPort(cache_entry->addrlist, info_.port());
+      if (result_ == OK) {
+        *addresses_ =
+            CreateAddressListUsingPort(cache_entry->addrlist, info_.port());
+      }
       return true;
     }
     return false;
   }
 
+  bool ServeFromHosts() {
+    const DnsHosts& hosts = resolver_->hosts_;
+    if (hosts.empty())
+      return false;
+
+    // For ADDRESS_FAMILY_UNSPECIFIED, the IPv4 address comes first.
+    IPAddressList ip_addresses;
+    if (key_.second != ADDRESS_FAMILY_IPV6) {
+      DnsHosts::const_iterator it =
+          hosts.find(DnsHostsKey(info_.hostname(), ADDRESS_FAMILY_IPV4));
+      if (it != hosts.end())
+        ip_addresses.push_back(it->second);
+    }
+    if (key_.second != ADDRESS_FAMILY_IPV4) {
+      DnsHosts::const_iterator it =
+          hosts.find(DnsHostsKey(info_.hostname(), ADDRESS_FAMILY_IPV6));
+      if (it != hosts.end())
+        ip_addresses.push_back(it->second);
+    }
+    if (ip_addresses.empty())
+      return false;
+
+    *addresses_ = AddressList::CreateFromIPAddressList(ip_addresses,
+                                                       info_.port());
+    result_ = OK;
+    return true;
+  }
+
   // Called when a request completes synchronously; we do not have an
   // AddressList argument, since in case of a successful synchronous
-  // completion, either ResolveAsIp or ServerFromCache would set the
-  // |addresses_| and in case of an unsuccessful synchronous completion, we
-  // do not touch |addresses_|.
+  // completion, either ResolveAsIp, ServeFromCache or ServeFromHosts would
+  // set the |addresses_| and in case of an unsuccessful synchronous
+  // completion, we do not touch |addresses_|.
   void OnSyncComplete(int result) {
     callback_ = NULL;
     resolver_->OnFinish(this, result);
@@ -196,6 +272,230 @@ class AsyncHostResolver::Request {
   int result_;
 };
 
+//-----------------------------------------------------------------------------
+// A Job looks up a Key for the requests attached to it. It sends a query for
+// every DNS type of the address family of the Key, in parallel, to the name
+// servers in the order given by the resolver: when a server doesn't answer, the
+// query is sent to the next one. If no query finds an address, the next name
+// of the search list is tried. A transaction that completes synchronously is
+// handled from a posted task, so that the callbacks of the requests are never
+// run from Resolve().
+class AsyncHostResolver::Job : public DnsTransaction::Delegate {
+ public:
+  Job(AsyncHostResolver* resolver, Request* request)
+      : resolver_(resolver),
+        key_(request->key()),
+        cache_key_(request->cache_key()),
+        request_net_log_(request->request_net_log()),
+        servers_(resolver->GetServerOrder()),
+        name_index_(0),
+        error_(OK),
+        negative_ttl_(kuint32max),
+        result_(ERR_UNEXPECTED),
+        ttl_(kuint32max),
+        ALLOW_THIS_IN_INITIALIZER_LIST(weak_factory_(this)) {
+    DCHECK(!servers_.empty());
+    requests_.push_back(request);
+
+    if (key_.second != ADDRESS_FAMILY_IPV6)
+      queries_.push_back(Query(kDNS_A));
+    if (key_.second != ADDRESS_FAMILY_IPV4)
+      queries_.push_back(Query(kDNS_AAAA));
+
+    // Like the system resolver, the hostname is tried as is before the
+    // search list if it has at least |ndots_| dots, or if it is fully
+    // qualified (it ends with a dot).
+    const std::string& hostname = request->info().hostname();
+    int ndots = static_cast<int>(
+        std::count(hostname.begin(), hostname.end(), '.'));
+    bool qualified = hostname[hostname.size() - 1] == '.';
+    if (qualified || ndots >= resolver->ndots_)
+      names_.push_back(key_.first);
+    if (!qualified) {
+      for (size_t i = 0; i < resolver->search_.size(); ++i) {
+        std::string dns_name;
+        if (DNSDomainFromDot(hostname + "." + resolver->search_[i],
+                             &dns_name)) {
+          names_.push_back(dns_name);
+        }
+      }
+      if (ndots < resolver->ndots_)
+        names_.push_back(key_.first);
+    }
+  }
+
+  virtual ~Job() {
+    STLDeleteElements(&requests_);
+    for (size_t i = 0; i < queries_.size(); ++i)
+      delete queries_[i].transaction;
+  }
+
+  const Key& key() const { return key_; }
+  const HostCache::Key& cache_key() const { return cache_key_; }
+  RequestList& requests() { return requests_; }
+
+  // Once the job has completed, its result, the addresses found (IPv4
+  // first) and how long the result may be cached, in seconds.
+  int result() const { return result_; }
+  const IPAddressList& ip_addresses() const { return ip_addresses_; }
+  uint32 ttl() const { return ttl_; }
+
+  void Start() {
+    StartQueries();
+  }
+
+  // DnsTransaction::Delegate interface
+  virtual void OnTransactionComplete(
+      int result,
+      const DnsTransaction* transaction,
+      const IPAddressList& ip_addresses) OVERRIDE {
+    resolver_->RecordServerResult(transaction->dns_server(), result,
+                                  transaction->rtt());
+
+    size_t i = 0;
+    while (queries_[i].transaction != transaction)
+      ++i;
+    Query& query = queries_[i];
+    if (ShouldTryNextServer(result) &&
+        query.server_index + 1 < servers_.size()) {
+      ++query.server_index;
+      StartTransaction(&query);
+      return;
+    }
+
+    query.result = result;
+    query.ttl = transaction->ttl();
+    query.ip_addresses = ip_addresses;
+    query.transaction = NULL;
+    delete transaction;
+
+    for (i = 0; i < queries_.size(); ++i) {
+      if (queries_[i].transaction)
+        return;
+    }
+    if (!OnQueriesComplete()) {
+      // The next name of the search list is being looked up.
+      return;
+    }
+    resolver_->OnJobComplete(this);
+  }
+
+ private:
+  // The state of the query for one DNS type.
+  struct Query {
+    explicit Query(uint16 qtype)
+        : qtype(qtype), transaction(NULL), server_index(0),
+          result(ERR_UNEXPECTED), ttl(0) {}
+
+    uint16 qtype;
+    DnsTransaction* transaction;
+    size_t server_index;
+    int result;
+    uint32 ttl;
+    IPAddressList ip_addresses;
+  };
+
+  // Starts the queries for the current name.
+  void StartQueries() {
+    DCHECK_LT(name_index_, names_.size());
+    for (size_t i = 0; i < queries_.size(); ++i) {
+      queries_[i].server_index = 0;
+      StartTransaction(&queries_[i]);
+    }
+  }
+
+  // Sends |query| for the current name to its current server.
+  void StartTransaction(Query* query) {
+    request_net_log_.AddEvent(
+        NetLog::TYPE_ASYNC_HOST_RESOLVER_CREATE_DNS_TRANSACTION, NULL);
+    delete query->transaction;
+    query->transaction = new DnsTransaction(
+        servers_[query->server_index],
+        names_[name_index_],
+        query->qtype,
+        resolver_->rand_int_cb_,
+        resolver_->factory_,
+        request_net_log_,
+        resolver_->net_log_);
+    query->transaction->SetDelegate(this);
+    int rv = query->transaction->Start();
+    if (rv != ERR_IO_PENDING) {
+      MessageLoop::current()->PostTask(
+          FROM_HERE,
+          base::Bind(&Job::OnTransactionStartComplete,
+                     weak_factory_.GetWeakPtr(), rv, query->transaction));
+    }
+  }
+
+  void OnTransactionStartComplete(int result, DnsTransaction* transaction) {
+    OnTransactionComplete(result, transaction, transaction->ip_addresses());
+  }
+
+  // Called when all the queries for the current name have completed. Returns
+  // true if the job has completed, or false if the next name is being looked
+  // up.
+  bool OnQueriesComplete() {
+    bool found = false;
+    for (size_t i = 0; i < queries_.size(); ++i) {
+      const Query& query = queries_[i];
+      if (query.result == OK) {
+        found = true;
+        ttl_ = std::min(ttl_, query.ttl);
+        ip_addresses_.insert(ip_addresses_.end(), query.ip_addresses.begin(),
+                             query.ip_addresses.end());
+      } else if (query.result == ERR_NAME_NOT_RESOLVED) {
+        negative_ttl_ = std::min(negative_ttl_, query.ttl);
+      } else if (error_ == OK) {
+        error_ = query.result;
+      }
+    }
+    if (found) {
+      result_ = OK;
+      return true;
+    }
+    if (++name_index_ < names_.size()) {
+      StartQueries();
+      return false;
+    }
+    // The name doesn't exist only if every answer said so; other errors are
+    // not cached.
+    if (error_ != OK) {
+      result_ = error_;
+      ttl_ = 0;
+    } else {
+      result_ = ERR_NAME_NOT_RESOLVED;
+      ttl_ = negative_ttl_;
+    }
+    return true;
+  }
+
+  AsyncHostResolver* resolver_;
+  const Key key_;
+  const HostCache::Key cache_key_;
+  BoundNetLog request_net_log_;
+  RequestList requests_;
+
+  // The name servers, the DNS names to try in turn, and the queries for the
+  // current name.
+  const std::vector<IPEndPoint> servers_;
+  std::vector<std::string> names_;
+  size_t name_index_;
+  std::vector<Query> queries_;
+
+  // The first error that wasn't a negative answer, and the smallest negative
+  // TTL.
+  int error_;
+  uint32 negative_ttl_;
+
+  int result_;
+  IPAddressList ip_addresses_;
+  uint32 ttl_;
+
+  base::WeakPtrFactory<Job> weak_factory_;
+
+  DISALLOW_COPY_AND_ASSIGN(Job);
+};
+
 //-----------------------------------------------------------------------------
 AsyncHostResolver::AsyncHostResolver(const IPEndPoint& dns_server,
                                      size_t max_transactions,
@@ -206,22 +506,44 @@ AsyncHostResolver::AsyncHostResolver(const IPEndPoint& dns_server,
                                      NetLog* net_log)
     : max_transactions_(max_transactions),
       max_pending_requests_(max_pending_requests),
-      dns_server_(dns_server),
+      servers_(1, ServerStats(dns_server)),
+      ndots_(kDefaultNdots),
+      default_address_family_(ADDRESS_FAMILY_UNSPECIFIED),
+      rand_int_cb_(rand_int_cb),
+      cache_(cache),
+      factory_(factory),
+      next_request_id_(0),
+      net_log_(net_log) {
+}
+
+AsyncHostResolver::AsyncHostResolver(DnsConfigService* config_service,
+                                     size_t max_transactions,
+                                     size_t max_pending_requests,
+                                     const RandIntCallback& rand_int_cb,
+                                     HostCache* cache,
+                                     ClientSocketFactory* factory,
+                                     NetLog* net_log)
+    : max_transactions_(max_transactions),
+      max_pending_requests_(max_pending_requests),
+      ndots_(kDefaultNdots),
+      default_address_family_(ADDRESS_FAMILY_UNSPECIFIED),
       rand_int_cb_(rand_int_cb),
       cache_(cache),
       factory_(factory),
+      config_service_(config_service),
       next_request_id_(0),
       net_log_(net_log) {
+  DCHECK(config_service_.get());
+  config_service_->Watch();
+  config_service_->AddObserver(this);
 }
 
 AsyncHostResolver::~AsyncHostResolver() {
-  // Destroy request lists.
-  for (KeyRequestListMap::iterator it = requestlist_map_.begin();
-       it != requestlist_map_.end(); ++it)
-    STLDeleteElements(&it->second);
+  if (config_service_.get())
+    config_service_->RemoveObserver(this);
 
-  // Destroy transactions.
-  STLDeleteElements(&transactions_);
+  // Destroy jobs, with their requests and transactions.
+  STLDeleteValues(&jobs_);
 
   // Destroy pending requests.
   for (size_t i = 0; i < arraysize(pending_requests_); ++i)
@@ -241,12 +563,13 @@ int AsyncHostResolver::Resolve(const RequestInfo& info,
   int rv = ERR_UNEXPECTED;
   if (!request->IsValid())
     rv = ERR_NAME_NOT_RESOLVED;
-  else if (request->ResolveAsIp() || request->ServeFromCache())
+  else if (request->ResolveAsIp() || request->ServeFromCache() ||
+           request->ServeFromHosts())
     rv = request->result();
-  else if (AttachToRequestList(request.get()))
+  else if (AttachToJob(request.get()))
     rv = ERR_IO_PENDING;
-  else if (transactions_.size() < max_transactions_)
-    rv = StartNewTransactionFor(request.get());
+  else if (jobs_.size() < max_transactions_ && !servers_.empty())
+    rv = StartNewJobFor(request.get());
   else
     rv = Enqueue(request.get());
 
@@ -268,7 +591,8 @@ int AsyncHostResolver::ResolveFromCache(const RequestInfo& info,
   int rv = ERR_UNEXPECTED;
   if (!request->IsValid())
     rv = ERR_NAME_NOT_RESOLVED;
-  else if (request->ResolveAsIp() || request->ServeFromCache())
+  else if (request->ResolveAsIp() || request->ServeFromCache() ||
+           request->ServeFromHosts())
     rv = request->result();
   else
     rv = ERR_DNS_CACHE_MISS;
@@ -327,9 +651,9 @@ void AsyncHostResolver::CancelRequest(RequestHandle req_handle) {
   scoped_ptr<Request> request(reinterpret_cast<Request*>(req_handle));
   DCHECK(request.get());
 
-  KeyRequestListMap::iterator it = requestlist_map_.find(request->key());
-  if (it != requestlist_map_.end())
-    it->second.remove(request.get());
+  KeyJobMap::iterator it = jobs_.find(request->key());
+  if (it != jobs_.end())
+    it->second->requests().remove(request.get());
   else
     pending_requests_[request->priority()].remove(request.get());
 }
@@ -344,67 +668,78 @@ void AsyncHostResolver::RemoveObserver(HostResolver::Observer* observer) {
 
 void AsyncHostResolver::SetDefaultAddressFamily(
     AddressFamily address_family) {
-  NOTIMPLEMENTED();
+  default_address_family_ = address_family;
 }
 
 AddressFamily AsyncHostResolver::GetDefaultAddressFamily() const {
-  return ADDRESS_FAMILY_IPV4;
+  return default_address_family_;
 }
 
 HostCache* AsyncHostResolver::GetHostCache() {
   return cache_.get();
 }
 
-void AsyncHostResolver::OnTransactionComplete(
-    int result,
-    const DnsTransaction* transaction,
-    const IPAddressList& ip_addresses) {
-  DCHECK(std::find(transactions_.begin(), transactions_.end(), transaction)
-         != transactions_.end());
-  DCHECK(requestlist_map_.find(transaction->key()) != requestlist_map_.end());
-
-  // If by the time requests that caused |transaction| are cancelled, we do
-  // not have a port number to associate with the result, therefore, we
-  // assume the most common port, otherwise we use the port number of the
-  // first request.
-  RequestList& requests = requestlist_map_[transaction->key()];
+void AsyncHostResolver::OnConfigChanged(const DnsConfig& config) {
+  // The jobs in progress keep using the previous servers.
+  servers_.clear();
+  for (size_t i = 0; i < config.nameservers.size(); ++i)
+    servers_.push_back(ServerStats(config.nameservers[i]));
+  search_ = config.search;
+  ndots_ = config.ndots;
+  hosts_ = config.hosts;
+
+  // The cached results may not be valid anymore.
+  if (cache_.get())
+    cache_->clear();
+
+  if (servers_.empty()) {
+    // Nothing can be looked up until the configuration has a name server.
+    while (Request* request = RemoveHighest()) {
+      request->OnAsyncComplete(ERR_NAME_NOT_RESOLVED, AddressList());
+      delete request;
+    }
+    return;
+  }
+
+  // Start the requests that were waiting for the configuration.
+  while (jobs_.size() < max_transactions_ && GetNumPending() > 0)
+    ProcessPending();
+}
+
+void AsyncHostResolver::OnJobComplete(Job* job) {
+  DCHECK(jobs_.find(job->key()) != jobs_.end());
+  DCHECK_EQ(job, jobs_[job->key()]);
+  jobs_.erase(job->key());
+
+  // If by the time requests that caused |job| are cancelled, we do not have
+  // a port number to associate with the result, therefore, we assume the
+  // most common port, otherwise we use the port number of the first request.
+  RequestList& requests = job->requests();
   int port = requests.empty() ? 80 : requests.front()->info().port();
 
-  // Run callback of every request that was depending on this transaction,
-  // also notify observers.
   AddressList addrlist;
-  if (result == OK)
-    addrlist = AddressList::CreateFromIPAddressList(ip_addresses, port);
-  for (RequestList::iterator it = requests.begin(); it != requests.end();
-       ++it)
-    (*it)->OnAsyncComplete(result, addrlist);
-
-  // It is possible that the requests that caused |transaction| to be
-  // created are cancelled by the time |transaction| completes.  In that
-  // case |requests| would be empty.  We are knowingly throwing away the
-  // result of a DNS resolution in that case, because (a) if there are no
-  // requests, we do not have info to obtain a key from, (b) DnsTransaction
-  // does not have info(), adding one into it just temporarily doesn't make
-  // sense, since HostCache will be replaced with RR cache soon, (c)
-  // recreating info from DnsTransaction::Key adds a lot of temporary
-  // code/functions (like converting back from qtype to AddressFamily.)
-  // Also, we only cache positive results.  All of this will change when RR
-  // cache is added.
-  if (result == OK && cache_.get() && !requests.empty()) {
-    Request* request = requests.front();
-    HostResolver::RequestInfo info = request->info();
-    HostCache::Key key(
-        info.hostname(), info.address_family(), info.host_resolver_flags());
-    cache_->Set(key, result, addrlist, base::TimeTicks::Now());
+  if (job->result() == OK)
+    addrlist = AddressList::CreateFromIPAddressList(job->ip_addresses(), port);
+
+  // The result is cached for the TTL of the records, even if the requests
+  // have been cancelled. Names that don't exist are cached for the negative
+  // TTL of their zone, and other errors are not cached.
+  if (cache_.get() && job->ttl() > 0 &&
+      (job->result() == OK || job->result() == ERR_NAME_NOT_RESOLVED)) {
+    cache_->Set(job->cache_key(), job->result(), addrlist,
+                base::TimeTicks::Now(),
+                base::TimeDelta::FromSeconds(job->ttl()));
   }
 
-  // Cleanup requests.
-  STLDeleteElements(&requests);
-  requestlist_map_.erase(transaction->key());
+  // Run callback of every request that was depending on this job, also
+  // notify observers.
+  for (RequestList::iterator it = requests.begin(); it != requests.end();
+       ++it)
+    (*it)->OnAsyncComplete(job->result(), addrlist);
 
-  // Cleanup transaction and start a new one if there are pending requests.
-  delete transaction;
-  transactions_.remove(transaction);
+  // Cleanup the job with its requests, and start a new one if there are
+  // pending requests.
+  delete job;
   ProcessPending();
 }
 
@@ -420,33 +755,22 @@ AsyncHostResolver::Request* AsyncHostResolver::CreateNewRequest(
       this, source_net_log, request_net_log, id, info, callback, addresses);
 }
 
-bool AsyncHostResolver::AttachToRequestList(Request* request) {
-  KeyRequestListMap::iterator it = requestlist_map_.find(request->key());
-  if (it == requestlist_map_.end())
+bool AsyncHostResolver::AttachToJob(Request* request) {
+  KeyJobMap::iterator it = jobs_.find(request->key());
+  if (it == jobs_.end())
     return false;
-  it->second.push_back(request);
+  it->second->requests().push_back(request);
   return true;
 }
 
-int AsyncHostResolver::StartNewTransactionFor(Request* request) {
-  DCHECK(requestlist_map_.find(request->key()) == requestlist_map_.end());
-  DCHECK(transactions_.size() < max_transactions_);
+int AsyncHostResolver::StartNewJobFor(Request* request) {
+  DCHECK(jobs_.find(request->key()) == jobs_.end());
+  DCHECK(jobs_.size() < max_transactions_);
 
-  request->request_net_log().AddEvent(
-      NetLog::TYPE_ASYNC_HOST_RESOLVER_CREATE_DNS_TRANSACTION, NULL);
-
-  requestlist_map_[request->key()].push_back(request);
-  DnsTransaction* transaction = new DnsTransaction(
-      dns_server_,
-      request->key().first,
-      request->key().second,
-      rand_int_cb_,
-      factory_,
-      request->request_net_log(),
-      net_log_);
-  transaction->SetDelegate(this);
-  transactions_.push_back(transaction);
-  return transaction->Start();
+  Job* job = new Job(this, request);
+  jobs_[request->key()] = job;
+  job->Start();
+  return ERR_IO_PENDING;
 }
 
 int AsyncHostResolver::Enqueue(Request* request) {
@@ -492,7 +816,7 @@ AsyncHostResolver::Request* AsyncHostResolver::RemoveLowest() {
 }
 
 AsyncHostResolver::Request* AsyncHostResolver::RemoveHighest() {
-  for (size_t i = 0; i < arraysize(pending_requests_) - 1; ++i) {
+  for (size_t i = 0; i < arraysize(pending_requests_); ++i) {
     RequestList& requests = pending_requests_[i];
     if (!requests.empty()) {
       Request* request = requests.front();
@@ -504,22 +828,67 @@ AsyncHostResolver::Request* AsyncHostResolver::RemoveHighest() {
 }
 
 void AsyncHostResolver::ProcessPending() {
+  if (servers_.empty())
+    return;
   Request* request = RemoveHighest();
   if (!request)
     return;
+  Job* job = new Job(this, request);
+  jobs_[request->key()] = job;
   for (size_t i = 0; i < arraysize(pending_requests_); ++i) {
     RequestList& requests = pending_requests_[i];
     RequestList::iterator it = requests.begin();
     while (it != requests.end()) {
       if (request->key() == (*it)->key()) {
-        requestlist_map_[request->key()].push_back(*it);
+        job->requests().push_back(*it);
         it = requests.erase(it);
       } else {
         ++it;
       }
     }
   }
-  StartNewTransactionFor(request);
+  job->Start();
+}
+
+std::vector<IPEndPoint> AsyncHostResolver::GetServerOrder() {
+  // A stable sort keeps the order of the configuration for the servers that
+  // haven't been queried yet, and they are tried first.
+  std::vector<std::pair<base::TimeDelta, size_t> > order;
+  for (size_t i = 0; i < servers_.size(); ++i)
+    order.push_back(std::make_pair(servers_[i].srtt, i));
+  std::stable_sort(order.begin(), order.end());
+
+  std::vector<IPEndPoint> servers;
+  for (size_t i = 0; i < order.size(); ++i) {
+    ServerStats& server = servers_[order[i].second];
+    servers.push_back(server.address);
+    if (i > 0)
+      server.srtt = server.srtt * kSrttDecayPercent / 100;
+  }
+  return servers;
+}
+
+void AsyncHostResolver::RecordServerResult(const IPEndPoint& server,
+                                           int result,
+                                           base::TimeDelta rtt) {
+  for (size_t i = 0; i < servers_.size(); ++i) {
+    ServerStats& stats = servers_[i];
+    if (!(stats.address == server))
+      continue;
+    if (!ShouldTryNextServer(result) && rtt > base::TimeDelta()) {
+      if (stats.srtt == base::TimeDelta()) {
+        stats.srtt = rtt;
+      } else {
+        stats.srtt += (rtt - stats.srtt) / kSrttSampleWeight;
+      }
+    } else {
+      stats.srtt = std::min(
+          std::max(stats.srtt * 2,
+                   base::TimeDelta::FromMilliseconds(kMinTimeoutPenaltyMs)),
+          base::TimeDelta::FromMilliseconds(kMaxSrttMs));
+    }
+    return;
+  }
 }
 
 }  // namespace net
@@ -8,7 +8,11 @@
 
 #include <list>
 #include <map>
+#include <string>
+#include <utility>
+#include <vector>
 
+#include "base/memory/scoped_ptr.h"
 #include "base/observer_list.h"
 #include "base/threading/non_thread_safe.h"
 #include "net/base/address_family.h"
@@ -17,6 +21,8 @@
 #include "net/base/ip_endpoint.h"
 #include "net/base/net_log.h"
 #include "net/base/rand_callback.h"
+#include "net/dns/dns_config_service.h"
+#include "net/dns/dns_hosts.h"
 #include "net/dns/dns_transaction.h"
 
 namespace net {
@@ -24,14 +30,37 @@ namespace net {
 class AddressesList;
 class ClientSocketFactory;
 
+// A HostResolver that sends its own DNS queries over UDP, without blocking a
+// thread per lookup like getaddrinfo(). The requests for the same hostname and
+// address family share a single lookup. A lookup for ADDRESS_FAMILY_UNSPECIFIED
+// sends the A and AAAA queries in parallel, and tries the suffixes of the
+// search list like the system resolver. The hosts file is looked at before
+// sending any query.
+//
+// The results are cached for the TTL of their records, and names that don't
+// exist are cached for the negative TTL of the zone (RFC 2308). When there are
+// several name servers, the queries are sent to the one that has answered the
+// fastest recently, and a query that gets no answer is retried on the others.
 class NET_EXPORT AsyncHostResolver
     : public HostResolver,
-      public DnsTransaction::Delegate,
+      public DnsConfigService::Observer,
       NON_EXPORTED_BASE(public base::NonThreadSafe) {
  public:
+  // Sends the queries to |dns_server|.
   AsyncHostResolver(const IPEndPoint& dns_server,
                     size_t max_transactions,
-                    size_t max_pending_requests_,
+                    size_t max_pending_requests,
+                    const RandIntCallback& rand_int,
+                    HostCache* cache,
+                    ClientSocketFactory* factory,
+                    NetLog* net_log);
+
+  // Takes the name servers, the search list and the hosts from
+  // |config_service|, which it takes ownership of and starts watching. The
+  // requests are queued until the configuration has been read.
+  AsyncHostResolver(DnsConfigService* config_service,
+                    size_t max_transactions,
+                    size_t max_pending_requests,
                     const RandIntCallback& rand_int,
                     HostCache* cache,
                     ClientSocketFactory* factory,
@@ -54,11 +83,8 @@ class NET_EXPORT AsyncHostResolver
   virtual AddressFamily GetDefaultAddressFamily() const OVERRIDE;
   virtual HostCache* GetHostCache() OVERRIDE;
 
-  // DnsTransaction::Delegate interface
-  virtual void OnTransactionComplete(
-      int result,
-      const DnsTransaction* transaction,
-      const IPAddressList& ip_addresses) OVERRIDE;
+  // DnsConfigService::Observer interface
+  virtual void OnConfigChanged(const DnsConfig& config) OVERRIDE;
 
  private:
   FRIEND_TEST_ALL_PREFIXES(AsyncHostResolverTest, QueuedLookup);
@@ -69,13 +95,25 @@ class NET_EXPORT AsyncHostResolver
                            OverflowQueueWithLowPriorityLookup);
   FRIEND_TEST_ALL_PREFIXES(AsyncHostResolverTest,
                            OverflowQueueWithHighPriorityLookup);
+  FRIEND_TEST_ALL_PREFIXES(AsyncHostResolverTest, ServerSelection);
+  FRIEND_TEST_ALL_PREFIXES(AsyncHostResolverTest, WaitForConfig);
 
+  class Job;
   class Request;
 
-  typedef DnsTransaction::Key Key;
+  // The DNS name and the address family of a lookup.
+  typedef std::pair<std::string, AddressFamily> Key;
   typedef std::list<Request*> RequestList;
-  typedef std::list<const DnsTransaction*> TransactionList;
-  typedef std::map<Key, RequestList> KeyRequestListMap;
+  typedef std::map<Key, Job*> KeyJobMap;
+
+  // A name server and its smoothed round-trip time, which is zero until it
+  // has been queried.
+  struct ServerStats {
+    explicit ServerStats(const IPEndPoint& address) : address(address) {}
+
+    IPEndPoint address;
+    base::TimeDelta srtt;
+  };
 
   // Create a new request for the incoming Resolve() call.
   Request* CreateNewRequest(const RequestInfo& info,
@@ -92,13 +130,17 @@ class NET_EXPORT AsyncHostResolver
   // Called when a request has been cancelled.
   void OnCancel(Request* request);
 
-  // If there is an in-progress transaction for Request->key(), this will
-  // attach |request| to the respective list.
-  bool AttachToRequestList(Request* request);
+  // If there is an in-progress job for Request->key(), this will attach
+  // |request| to its list of requests.
+  bool AttachToJob(Request* request);
 
-  // Will start a new transaction for |request|, will insert a new key in
-  // |requestlist_map_| and append |request| to the respective list.
-  int StartNewTransactionFor(Request* request);
+  // Will start a new job for |request|, will insert it in |jobs_| and append
+  // |request| to its list of requests.
+  int StartNewJobFor(Request* request);
+
+  // Called by |job| when it has completed: runs the callbacks of its
+  // requests, caches the result and deletes |job|.
+  void OnJobComplete(Job* job);
 
   // Will enqueue |request| in |pending_requests_|.
   int Enqueue(Request* request);
@@ -114,18 +156,27 @@ class NET_EXPORT AsyncHostResolver
   Request* RemoveLowest();
   Request* RemoveHighest();
 
-  // Once a transaction has completed, called to start a new transaction if
-  // there are pending requests.
+  // Once a job has completed, called to start a new job if there are pending
+  // requests.
   void ProcessPending();
 
-  // Maximum number of concurrent transactions.
-  size_t max_transactions_;
+  // Returns the name servers, in the order in which a new job should try
+  // them: the fastest first.
+  std::vector<IPEndPoint> GetServerOrder();
 
-  // List of current transactions.
-  TransactionList transactions_;
+  // Updates the round-trip time of |server| after a transaction sent to it
+  // completed with |result|. |rtt| is zero if the server didn't answer, and
+  // answers that are errors count as no answer.
+  void RecordServerResult(const IPEndPoint& server,
+                          int result,
+                          base::TimeDelta rtt);
+
+  // Maximum number of concurrent jobs.
+  size_t max_transactions_;
 
-  // A map from Key to a list of requests waiting for the Key to resolve.
-  KeyRequestListMap requestlist_map_;
+  // A map from Key to the job looking it up, which holds the requests
+  // waiting for the Key to resolve.
+  KeyJobMap jobs_;
 
   // Maximum number of pending requests.
   size_t max_pending_requests_;
@@ -133,8 +184,17 @@ class NET_EXPORT AsyncHostResolver
   // Queues based on priority for putting pending requests.
   RequestList pending_requests_[NUM_PRIORITIES];
 
-  // DNS server to which queries will be setn.
-  IPEndPoint dns_server_;
+  // DNS servers to which queries will be sent.
+  std::vector<ServerStats> servers_;
+
+  // The suffixes tried for hostnames with less than |ndots_| dots, and the
+  // hosts file; see DnsConfig.
+  std::vector<std::string> search_;
+  int ndots_;
+  DnsHosts hosts_;
+
+  // Address family to use when the request doesn't specify one.
+  AddressFamily default_address_family_;
 
   // Callback to be passed to DnsTransaction for generating DNS query ids.
   RandIntCallback rand_int_cb_;
@@ -146,6 +206,9 @@ class NET_EXPORT AsyncHostResolver
   // testing, outside of unit tests, its value is always NULL.
   ClientSocketFactory* factory_;
 
+  // The source of the configuration, if it isn't fixed.
+  scoped_ptr<DnsConfigService> config_service_;
+
   // The observers to notify when a request starts/ends.
   ObserverList<HostResolver::Observer> observers_;
 
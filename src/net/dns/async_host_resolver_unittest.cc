@@ -4,13 +4,19 @@
 
 #include "net/dns/async_host_resolver.h"
 
+#include <deque>
+
 #include "base/bind.h"
 #include "base/memory/scoped_ptr.h"
+#include "base/memory/scoped_vector.h"
+#include "net/base/dns_util.h"
 #include "net/base/host_cache.h"
 #include "net/base/net_log.h"
+#include "net/base/net_util.h"
 #include "net/base/rand_callback.h"
 #include "net/base/sys_addrinfo.h"
 #include "net/base/test_host_resolver_observer.h"
+#include "net/dns/dns_config_service.h"
 #include "net/dns/dns_test_util.h"
 #include "net/socket/socket_test_util.h"
 #include "testing/gtest/include/gtest/gtest.h"
@@ -30,22 +36,104 @@ void VerifyAddressList(const std::vector<const char*>& ip_addresses,
   for (std::vector<const char*>::const_iterator i = ip_addresses.begin();
        i != ip_addresses.end(); ++i, ainfo = ainfo->ai_next) {
     ASSERT_NE(static_cast<addrinfo*>(NULL), ainfo);
-    EXPECT_EQ(sizeof(struct sockaddr_in), ainfo->ai_addrlen);
 
     const struct sockaddr* sa = ainfo->ai_addr;
-    const struct sockaddr_in* sa_in = (const struct sockaddr_in*) sa;
-    EXPECT_TRUE(htons(port) == sa_in->sin_port);
+    EXPECT_EQ(port, GetPortFromSockaddr(sa, ainfo->ai_addrlen));
     EXPECT_STREQ(*i, NetAddressToString(sa, ainfo->ai_addrlen).c_str());
   }
   ASSERT_EQ(static_cast<addrinfo*>(NULL), ainfo);
 }
 
+void AppendU16(std::string* out, uint16 value) {
+  out->push_back(static_cast<char>(value >> 8));
+  out->push_back(static_cast<char>(value & 0xff));
+}
+
+void AppendU32(std::string* out, uint32 value) {
+  AppendU16(out, static_cast<uint16>(value >> 16));
+  AppendU16(out, static_cast<uint16>(value & 0xffff));
+}
+
+// Returns the query that a DnsTransaction sends for |hostname| and |qtype|,
+// with the id |id|.
+std::string BuildQuery(uint16 id, const std::string& hostname, uint16 qtype) {
+  std::string qname;
+  bool rv = DNSDomainFromDot(hostname, &qname);
+  DCHECK(rv);
+
+  std::string query;
+  AppendU16(&query, id);
+  AppendU16(&query, 0x0100);  // Recursion desired.
+  AppendU16(&query, 1);  // One question.
+  AppendU16(&query, 0);
+  AppendU16(&query, 0);
+  AppendU16(&query, 0);
+  query.append(qname);
+  AppendU16(&query, qtype);
+  AppendU16(&query, kClassIN);
+  return query;
+}
+
+// Returns a response to |query| with the result code |rcode|. Each address of
+// |ip_addresses| is an answer with a TTL of |ttl|. If |soa_minimum| is not 0,
+// the authority section has an SOA record of TTL 3600 with that MINIMUM.
+std::string BuildResponse(const std::string& query,
+                          uint8 rcode,
+                          const std::vector<const char*>& ip_addresses,
+                          uint32 ttl,
+                          uint32 soa_minimum) {
+  std::string response(query);
+  response[2] = static_cast<char>(0x81);  // Response, recursion desired.
+  response[3] = static_cast<char>(0x80 | rcode);  // Recursion available.
+  response[6] = 0;
+  response[7] = static_cast<char>(ip_addresses.size());
+  response[9] = soa_minimum ? 1 : 0;
+
+  for (size_t i = 0; i < ip_addresses.size(); ++i) {
+    IPAddressNumber ip;
+    bool rv = ParseIPLiteralToNumber(ip_addresses[i], &ip);
+    DCHECK(rv);
+    AppendU16(&response, 0xc00c);  // Pointer to the question name.
+    AppendU16(&response, ip.size() == 4 ? kDNS_A : kDNS_AAAA);
+    AppendU16(&response, kClassIN);
+    AppendU32(&response, ttl);
+    AppendU16(&response, static_cast<uint16>(ip.size()));
+    response.append(ip.begin(), ip.end());
+  }
+
+  if (soa_minimum) {
+    AppendU16(&response, 0xc00c);
+    AppendU16(&response, kDNS_SOA);
+    AppendU16(&response, kClassIN);
+    AppendU32(&response, 3600);
+    AppendU16(&response, 2 + 2 + 5 * 4);
+    AppendU16(&response, 0xc00c);  // MNAME.
+    AppendU16(&response, 0xc00c);  // RNAME.
+    AppendU32(&response, 1);  // SERIAL.
+    AppendU32(&response, 7200);  // REFRESH.
+    AppendU32(&response, 900);  // RETRY.
+    AppendU32(&response, 86400);  // EXPIRE.
+    AppendU32(&response, soa_minimum);  // MINIMUM.
+  }
+  return response;
+}
+
+// A DnsConfigService that is given its configuration by the test.
+class TestDnsConfigService : public DnsConfigService {
+ public:
+  void SetConfig(const DnsConfig& config) {
+    OnConfigRead(config);
+    OnHostsRead(config.hosts);
+  }
+};
+
 }  // namespace
 
 static const int kPortNum = 80;
 static const size_t kMaxTransactions = 2;
 static const size_t kMaxPendingRequests = 1;
 static int transaction_ids[] = {0, 1, 2, 3};
+static int scripted_transaction_ids[] = {0, 1, 2, 3, 4, 5, 6, 7};
 
 // The following fixture sets up an environment for four different lookups
 // with their data defined in dns_test_util.h.  All tests make use of these
@@ -72,9 +160,14 @@ class AsyncHostResolverTest : public testing::Test {
         ip_addresses3_(kT3IpAddresses,
             kT3IpAddresses + arraysize(kT3IpAddresses)),
         test_prng_(std::deque<int>(
-            transaction_ids, transaction_ids + arraysize(transaction_ids))) {
+            transaction_ids, transaction_ids + arraysize(transaction_ids))),
+        scripted_prng_(std::deque<int>(
+            scripted_transaction_ids,
+            scripted_transaction_ids + arraysize(scripted_transaction_ids))) {
     rand_int_cb_ = base::Bind(&TestPrng::GetNext,
                               base::Unretained(&test_prng_));
+    scripted_rand_int_cb_ = base::Bind(&TestPrng::GetNext,
+                                       base::Unretained(&scripted_prng_));
     // AF_INET only for now.
     info0_.set_address_family(ADDRESS_FAMILY_IPV4);
     info1_.set_address_family(ADDRESS_FAMILY_IPV4);
@@ -126,17 +219,40 @@ class AsyncHostResolverTest : public testing::Test {
     factory_.AddSocketDataProvider(data2_.get());
     factory_.AddSocketDataProvider(data3_.get());
 
-    IPEndPoint dns_server;
-    bool rv0 = CreateDnsAddress(kDnsIp, kDnsPort, &dns_server);
+    bool rv0 = CreateDnsAddress(kDnsIp, kDnsPort, &dns_server_);
     DCHECK(rv0);
 
     resolver_.reset(
         new AsyncHostResolver(
-            dns_server, kMaxTransactions, kMaxPendingRequests, rand_int_cb_,
+            dns_server_, kMaxTransactions, kMaxPendingRequests, rand_int_cb_,
             HostCache::CreateDefaultCache(), &factory_, NULL));
   }
 
  protected:
+  // Adds a socket to |scripted_factory_| that expects |query| and reads
+  // |response|. The sockets are used in the order they were added, and the
+  // ids of the queries are taken in order from |scripted_transaction_ids|.
+  void AddExchange(const std::string& query, const std::string& response) {
+    datagrams_.push_back(query);
+    scripted_writes_.push_back(MockWrite(true, datagrams_.back().data(),
+                                         datagrams_.back().size()));
+    datagrams_.push_back(response);
+    scripted_reads_.push_back(MockRead(true, datagrams_.back().data(),
+                                       datagrams_.back().size()));
+    StaticSocketDataProvider* data = new StaticSocketDataProvider(
+        &scripted_reads_.back(), 1, &scripted_writes_.back(), 1);
+    scripted_data_.push_back(data);
+    scripted_factory_.AddSocketDataProvider(data);
+  }
+
+  // Returns a resolver that uses the sockets added by AddExchange().
+  AsyncHostResolver* CreateScriptedResolver() {
+    return new AsyncHostResolver(
+        dns_server_, kMaxTransactions, kMaxPendingRequests,
+        scripted_rand_int_cb_, HostCache::CreateDefaultCache(),
+        &scripted_factory_, NULL);
+  }
+
   AddressList addrlist0_, addrlist1_, addrlist2_, addrlist3_;
   HostResolver::RequestInfo info0_, info1_, info2_, info3_;
   std::vector<MockWrite> writes0_, writes1_, writes2_, writes3_;
@@ -149,6 +265,17 @@ class AsyncHostResolverTest : public testing::Test {
   RandIntCallback rand_int_cb_;
   scoped_ptr<HostResolver> resolver_;
   TestOldCompletionCallback callback0_, callback1_, callback2_, callback3_;
+
+  IPEndPoint dns_server_;
+  // Deques don't move their elements when they grow, so the mock reads and
+  // writes can point into them.
+  std::deque<std::string> datagrams_;
+  std::deque<MockWrite> scripted_writes_;
+  std::deque<MockRead> scripted_reads_;
+  ScopedVector<StaticSocketDataProvider> scripted_data_;
+  MockClientSocketFactory scripted_factory_;
+  TestPrng scripted_prng_;
+  RandIntCallback scripted_rand_int_cb_;
 };
 
 TEST_F(AsyncHostResolverTest, EmptyHostLookup) {
@@ -172,9 +299,17 @@ TEST_F(AsyncHostResolverTest, IPv4LiteralLookup) {
 
 TEST_F(AsyncHostResolverTest, IPv6LiteralLookup) {
   info0_.set_host_port_pair(HostPortPair("2001:db8:0::42", kPortNum));
+  info0_.set_address_family(ADDRESS_FAMILY_UNSPECIFIED);
   int rv = resolver_->Resolve(info0_, &addrlist0_, &callback0_, NULL,
                               BoundNetLog());
-  // When support for IPv6 is added, this should succeed.
+  EXPECT_EQ(OK, rv);
+  std::vector<const char*> ip_addresses(1, "2001:db8::42");
+  VerifyAddressList(ip_addresses, kPortNum, addrlist0_);
+
+  // IPv6 literals are rejected when only IPv4 is wanted.
+  resolver_->SetDefaultAddressFamily(ADDRESS_FAMILY_IPV4);
+  rv = resolver_->Resolve(info0_, &addrlist0_, &callback0_, NULL,
+                          BoundNetLog());
   EXPECT_EQ(ERR_NAME_NOT_RESOLVED, rv);
 }
 
@@ -197,6 +332,249 @@ TEST_F(AsyncHostResolverTest, CachedLookup) {
   VerifyAddressList(ip_addresses0_, kPortNum, addrlist1_);
 }
 
+// The result is cached for the smallest TTL of the answers, 228 seconds.
+TEST_F(AsyncHostResolverTest, CachedLookupUsesTTL) {
+  int rv = resolver_->Resolve(info0_, &addrlist0_, &callback0_, NULL,
+                              BoundNetLog());
+  EXPECT_EQ(ERR_IO_PENDING, rv);
+  EXPECT_EQ(OK, callback0_.WaitForResult());
+
+  base::TimeTicks now = base::TimeTicks::Now();
+  HostCache::Key key(kT0HostName, ADDRESS_FAMILY_IPV4, 0);
+  HostCache* cache = resolver_->GetHostCache();
+  EXPECT_TRUE(cache->Lookup(key, now + base::TimeDelta::FromSeconds(227)));
+  EXPECT_FALSE(cache->Lookup(key, now + base::TimeDelta::FromSeconds(229)));
+}
+
+// A name that doesn't exist is cached for the negative TTL of its zone.
+TEST_F(AsyncHostResolverTest, NameErrorIsCached) {
+  const char kHostName[] = "missing.example.com";
+  std::string query = BuildQuery(0, kHostName, kDNS_A);
+  AddExchange(query, BuildResponse(query, 3, std::vector<const char*>(), 0,
+                                   300));
+  scoped_ptr<AsyncHostResolver> resolver(CreateScriptedResolver());
+
+  info0_.set_host_port_pair(HostPortPair(kHostName, kPortNum));
+  int rv = resolver->Resolve(info0_, &addrlist0_, &callback0_, NULL,
+                             BoundNetLog());
+  EXPECT_EQ(ERR_IO_PENDING, rv);
+  EXPECT_EQ(ERR_NAME_NOT_RESOLVED, callback0_.WaitForResult());
+
+  // The second lookup fails synchronously, without sending a query.
+  rv = resolver->Resolve(info0_, &addrlist0_, &callback0_, NULL,
+                         BoundNetLog());
+  EXPECT_EQ(ERR_NAME_NOT_RESOLVED, rv);
+  rv = resolver->ResolveFromCache(info0_, &addrlist0_, BoundNetLog());
+  EXPECT_EQ(ERR_NAME_NOT_RESOLVED, rv);
+  EXPECT_EQ(1u, scripted_factory_.udp_client_sockets().size());
+
+  base::TimeTicks now = base::TimeTicks::Now();
+  HostCache::Key key(kHostName, ADDRESS_FAMILY_IPV4, 0);
+  HostCache* cache = resolver->GetHostCache();
+  EXPECT_TRUE(cache->Lookup(key, now + base::TimeDelta::FromSeconds(299)));
+  EXPECT_FALSE(cache->Lookup(key, now + base::TimeDelta::FromSeconds(301)));
+}
+
+// Without an SOA record, a name error is not cached.
+TEST_F(AsyncHostResolverTest, NameErrorWithoutSOAIsNotCached) {
+  const char kHostName[] = "missing.example.com";
+  std::string query = BuildQuery(0, kHostName, kDNS_A);
+  AddExchange(query, BuildResponse(query, 3, std::vector<const char*>(), 0,
+                                   0));
+  scoped_ptr<AsyncHostResolver> resolver(CreateScriptedResolver());
+
+  info0_.set_host_port_pair(HostPortPair(kHostName, kPortNum));
+  int rv = resolver->Resolve(info0_, &addrlist0_, &callback0_, NULL,
+                             BoundNetLog());
+  EXPECT_EQ(ERR_IO_PENDING, rv);
+  EXPECT_EQ(ERR_NAME_NOT_RESOLVED, callback0_.WaitForResult());
+
+  rv = resolver->ResolveFromCache(info0_, &addrlist0_, BoundNetLog());
+  EXPECT_EQ(ERR_DNS_CACHE_MISS, rv);
+}
+
+// A lookup for any address family sends the A and AAAA queries in parallel,
+// and returns the IPv4 addresses first.
+TEST_F(AsyncHostResolverTest, UnspecifiedFamilyLookup) {
+  const char kHostName[] = "www.example.com";
+  std::string query_a = BuildQuery(0, kHostName, kDNS_A);
+  std::string query_aaaa = BuildQuery(1, kHostName, kDNS_AAAA);
+  AddExchange(query_a, BuildResponse(
+      query_a, 0, std::vector<const char*>(1, "192.0.2.1"), 100, 0));
+  AddExchange(query_aaaa, BuildResponse(
+      query_aaaa, 0, std::vector<const char*>(1, "2001:db8::1"), 50, 0));
+  scoped_ptr<AsyncHostResolver> resolver(CreateScriptedResolver());
+
+  HostResolver::RequestInfo info(HostPortPair(kHostName, kPortNum));
+  int rv = resolver->Resolve(info, &addrlist0_, &callback0_, NULL,
+                             BoundNetLog());
+  EXPECT_EQ(ERR_IO_PENDING, rv);
+  EXPECT_EQ(2u, scripted_factory_.udp_client_sockets().size());
+  EXPECT_EQ(OK, callback0_.WaitForResult());
+
+  std::vector<const char*> ip_addresses;
+  ip_addresses.push_back("192.0.2.1");
+  ip_addresses.push_back("2001:db8::1");
+  VerifyAddressList(ip_addresses, kPortNum, addrlist0_);
+
+  // The result is cached for the smaller TTL.
+  base::TimeTicks now = base::TimeTicks::Now();
+  HostCache::Key key(kHostName, ADDRESS_FAMILY_UNSPECIFIED, 0);
+  HostCache* cache = resolver->GetHostCache();
+  EXPECT_TRUE(cache->Lookup(key, now + base::TimeDelta::FromSeconds(49)));
+  EXPECT_FALSE(cache->Lookup(key, now + base::TimeDelta::FromSeconds(51)));
+}
+
+// A name with fewer dots than |ndots| is looked up with the suffixes of the
+// search list first.
+TEST_F(AsyncHostResolverTest, SearchList) {
+  std::string query0 = BuildQuery(0, "www.example.com", kDNS_A);
+  std::string query1 = BuildQuery(1, "www", kDNS_A);
+  AddExchange(query0, BuildResponse(query0, 3, std::vector<const char*>(), 0,
+                                    0));
+  AddExchange(query1, BuildResponse(
+      query1, 0, std::vector<const char*>(1, "192.0.2.2"), 100, 0));
+  scoped_ptr<AsyncHostResolver> resolver(CreateScriptedResolver());
+
+  DnsConfig config;
+  config.nameservers.push_back(dns_server_);
+  config.search.push_back("example.com");
+  resolver->OnConfigChanged(config);
+
+  info0_.set_host_port_pair(HostPortPair("www", kPortNum));
+  int rv = resolver->Resolve(info0_, &addrlist0_, &callback0_, NULL,
+                             BoundNetLog());
+  EXPECT_EQ(ERR_IO_PENDING, rv);
+  EXPECT_EQ(OK, callback0_.WaitForResult());
+  VerifyAddressList(std::vector<const char*>(1, "192.0.2.2"), kPortNum,
+                    addrlist0_);
+  EXPECT_EQ(2u, scripted_factory_.udp_client_sockets().size());
+}
+
+// The hosts file is used before sending any query.
+TEST_F(AsyncHostResolverTest, HostsLookup) {
+  scoped_ptr<AsyncHostResolver> resolver(CreateScriptedResolver());
+
+  DnsConfig config;
+  config.nameservers.push_back(dns_server_);
+  IPAddressNumber ip;
+  ASSERT_TRUE(ParseIPLiteralToNumber("::1", &ip));
+  config.hosts[DnsHostsKey("myhost", ADDRESS_FAMILY_IPV6)] = ip;
+  ASSERT_TRUE(ParseIPLiteralToNumber("10.0.0.1", &ip));
+  config.hosts[DnsHostsKey("myhost", ADDRESS_FAMILY_IPV4)] = ip;
+  resolver->OnConfigChanged(config);
+
+  HostResolver::RequestInfo info(HostPortPair("myhost", kPortNum));
+  int rv = resolver->Resolve(info, &addrlist0_, &callback0_, NULL,
+                             BoundNetLog());
+  EXPECT_EQ(OK, rv);
+  std::vector<const char*> ip_addresses;
+  ip_addresses.push_back("10.0.0.1");
+  ip_addresses.push_back("::1");
+  VerifyAddressList(ip_addresses, kPortNum, addrlist0_);
+  EXPECT_EQ(0u, scripted_factory_.udp_client_sockets().size());
+}
+
+// A query that the first server fails to answer is sent to the next one.
+TEST_F(AsyncHostResolverTest, NextServerOnFailure) {
+  const char kHostName[] = "www.example.com";
+  std::string query0 = BuildQuery(0, kHostName, kDNS_A);
+  std::string query1 = BuildQuery(1, kHostName, kDNS_A);
+  // SERVFAIL.
+  AddExchange(query0, BuildResponse(query0, 2, std::vector<const char*>(), 0,
+                                    0));
+  AddExchange(query1, BuildResponse(
+      query1, 0, std::vector<const char*>(1, "192.0.2.3"), 100, 0));
+  scoped_ptr<AsyncHostResolver> resolver(CreateScriptedResolver());
+
+  DnsConfig config;
+  IPEndPoint second_server;
+  ASSERT_TRUE(CreateDnsAddress("192.168.1.2", kDnsPort, &second_server));
+  config.nameservers.push_back(dns_server_);
+  config.nameservers.push_back(second_server);
+  resolver->OnConfigChanged(config);
+
+  info0_.set_host_port_pair(HostPortPair(kHostName, kPortNum));
+  int rv = resolver->Resolve(info0_, &addrlist0_, &callback0_, NULL,
+                             BoundNetLog());
+  EXPECT_EQ(ERR_IO_PENDING, rv);
+  EXPECT_EQ(OK, callback0_.WaitForResult());
+  VerifyAddressList(std::vector<const char*>(1, "192.0.2.3"), kPortNum,
+                    addrlist0_);
+  EXPECT_EQ(2u, scripted_factory_.udp_client_sockets().size());
+}
+
+// The server with the smallest smoothed RTT is tried first, a failure moves a
+// server to the end, and the servers that are not picked get another chance.
+TEST_F(AsyncHostResolverTest, ServerSelection) {
+  scoped_ptr<AsyncHostResolver> resolver(CreateScriptedResolver());
+
+  DnsConfig config;
+  IPEndPoint server0 = dns_server_;
+  IPEndPoint server1;
+  ASSERT_TRUE(CreateDnsAddress("192.168.1.2", kDnsPort, &server1));
+  config.nameservers.push_back(server0);
+  config.nameservers.push_back(server1);
+  resolver->OnConfigChanged(config);
+
+  // The order of the configuration is kept until the servers are measured.
+  std::vector<IPEndPoint> order = resolver->GetServerOrder();
+  ASSERT_EQ(2u, order.size());
+  EXPECT_TRUE(order[0] == server0);
+
+  resolver->RecordServerResult(server0, OK,
+                               base::TimeDelta::FromMilliseconds(100));
+  resolver->RecordServerResult(server1, OK,
+                               base::TimeDelta::FromMilliseconds(20));
+  order = resolver->GetServerOrder();
+  EXPECT_TRUE(order[0] == server1);
+
+  // A name error is an answer, not a failure of the server.
+  resolver->RecordServerResult(server1, ERR_NAME_NOT_RESOLVED,
+                               base::TimeDelta::FromMilliseconds(20));
+  order = resolver->GetServerOrder();
+  EXPECT_TRUE(order[0] == server1);
+
+  resolver->RecordServerResult(server1, ERR_DNS_TIMED_OUT, base::TimeDelta());
+  order = resolver->GetServerOrder();
+  EXPECT_TRUE(order[0] == server0);
+
+  // The penalized server is picked again once the RTT of the other one has
+  // decayed below its own.
+  int selections = 0;
+  while (selections < 1000 && resolver->GetServerOrder()[0] == server0)
+    ++selections;
+  EXPECT_LT(0, selections);
+  EXPECT_GT(1000, selections);
+}
+
+// The requests wait until the configuration has been read.
+TEST_F(AsyncHostResolverTest, WaitForConfig) {
+  const char kHostName[] = "www.example.com";
+  std::string query = BuildQuery(0, kHostName, kDNS_A);
+  AddExchange(query, BuildResponse(
+      query, 0, std::vector<const char*>(1, "192.0.2.4"), 100, 0));
+  TestDnsConfigService* service = new TestDnsConfigService;
+  scoped_ptr<AsyncHostResolver> resolver(new AsyncHostResolver(
+      service, kMaxTransactions, kMaxPendingRequests, scripted_rand_int_cb_,
+      HostCache::CreateDefaultCache(), &scripted_factory_, NULL));
+
+  info0_.set_host_port_pair(HostPortPair(kHostName, kPortNum));
+  int rv = resolver->Resolve(info0_, &addrlist0_, &callback0_, NULL,
+                             BoundNetLog());
+  EXPECT_EQ(ERR_IO_PENDING, rv);
+  EXPECT_EQ(1u, resolver->GetNumPending());
+  EXPECT_EQ(0u, scripted_factory_.udp_client_sockets().size());
+
+  DnsConfig config;
+  config.nameservers.push_back(dns_server_);
+  service->SetConfig(config);
+  EXPECT_EQ(0u, resolver->GetNumPending());
+  EXPECT_EQ(OK, callback0_.WaitForResult());
+  VerifyAddressList(std::vector<const char*>(1, "192.0.2.4"), kPortNum,
+                    addrlist0_);
+}
+
 TEST_F(AsyncHostResolverTest, InvalidHostNameLookup) {
   const std::string kHostName1(64, 'a');
   info0_.set_host_port_pair(HostPortPair(kHostName1, kPortNum));
@@ -4,6 +4,8 @@
 
 #include "net/dns/dns_response.h"
 
+#include <algorithm>
+
 #include "net/base/dns_util.h"
 #include "net/base/io_buffer.h"
 #include "net/base/net_errors.h"
@@ -17,7 +19,8 @@ static const int kMaxResponseSize = 512;
 
 DnsResponse::DnsResponse(DnsQuery* query)
     : query_(query),
-      io_buffer_(new IOBufferWithSize(kMaxResponseSize + 1)) {
+      io_buffer_(new IOBufferWithSize(kMaxResponseSize + 1)),
+      ttl_(0) {
   DCHECK(query_);
 }
 
@@ -25,12 +28,14 @@ DnsResponse::~DnsResponse() {
 }
 
 int DnsResponse::Parse(int nbytes, IPAddressList* ip_addresses) {
+  ttl_ = 0;
+
   // Response includes query, it should be at least that size.
   if (nbytes < query_->io_buffer()->size() || nbytes > kMaxResponseSize)
     return ERR_DNS_MALFORMED_RESPONSE;
 
   DnsResponseBuffer response(reinterpret_cast<uint8*>(io_buffer_->data()),
-                             io_buffer_->size());
+                             nbytes);
   uint16 id;
   if (!response.U16(&id) || id != query_->id()) // Make sure IDs match.
     return ERR_DNS_MALFORMED_RESPONSE;
@@ -64,10 +69,8 @@ int DnsResponse::Parse(int nbytes, IPAddressList* ip_addresses) {
     return ERR_DNS_MALFORMED_RESPONSE;
   }
 
-  if (answer_count < 1)
-    return ERR_NAME_NOT_RESOLVED;
-
   IPAddressList rdatas;
+  uint32 min_ttl = kuint32max;
   while (answer_count--) {
     uint32 ttl;
     uint16 rdlength, qtype, qclass;
@@ -78,6 +81,8 @@ int DnsResponse::Parse(int nbytes, IPAddressList* ip_addresses) {
         !response.U16(&rdlength)) {
       return ERR_DNS_MALFORMED_RESPONSE;
     }
+    // The addresses can't be cached longer than the CNAMEs leading to them.
+    min_ttl = std::min(min_ttl, ttl);
     if (qtype == query_->qtype() &&
         qclass == kClassIN &&
         (rdlength == kIPv4AddressSize || rdlength == kIPv6AddressSize)) {
@@ -89,12 +94,42 @@ int DnsResponse::Parse(int nbytes, IPAddressList* ip_addresses) {
       return ERR_DNS_MALFORMED_RESPONSE;
   }
 
-  if (rdatas.empty())
-    return ERR_NAME_NOT_RESOLVED;
+  if (!rdatas.empty()) {
+    ttl_ = min_ttl;
+    if (ip_addresses)
+      ip_addresses->swap(rdatas);
+    return OK;
+  }
 
-  if (ip_addresses)
-    ip_addresses->swap(rdatas);
-  return OK;
+  // The name doesn't exist or has no address of this type. The authority
+  // section is only used to find how long that may be cached, so a malformed
+  // one is not an error.
+  while (authority_count--) {
+    uint32 ttl;
+    uint16 rdlength, qtype, qclass;
+    if (!response.DNSName(NULL) ||
+        !response.U16(&qtype) ||
+        !response.U16(&qclass) ||
+        !response.U32(&ttl) ||
+        !response.U16(&rdlength)) {
+      break;
+    }
+    if (qtype == kDNS_SOA && qclass == kClassIN) {
+      // The SOA RDATA is MNAME, RNAME, SERIAL, REFRESH, RETRY, EXPIRE and
+      // MINIMUM.
+      uint32 minimum;
+      if (response.DNSName(NULL) &&
+          response.DNSName(NULL) &&
+          response.Skip(4 * sizeof(uint32)) &&
+          response.U32(&minimum)) {
+        ttl_ = std::min(ttl, minimum);
+      }
+      break;
+    }
+    if (!response.Skip(rdlength))
+      break;
+  }
+  return ERR_NAME_NOT_RESOLVED;
 }
 
 }  // namespace net
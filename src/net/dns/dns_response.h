@@ -34,6 +34,13 @@ class NET_EXPORT_PRIVATE DnsResponse {
   // returns net_error code in case of failure.
   int Parse(int nbytes, IPAddressList* ip_addresses);
 
+  // Returns how long the result of the last Parse() may be cached, in
+  // seconds. That is the smallest TTL of the answers if it returned OK. If it
+  // returned ERR_NAME_NOT_RESOLVED, that is the negative TTL of RFC 2308,
+  // section 5: the smaller of the TTL and the MINIMUM field of the SOA record
+  // in the authority section, or 0 if there is no SOA record.
+  uint32 ttl() const { return ttl_; }
+
  private:
   // The matching query; |this| is the response for |query_|.  We do not
   // own it, lifetime of |this| should be within the limits of lifetime of
@@ -43,6 +50,8 @@ class NET_EXPORT_PRIVATE DnsResponse {
   // Buffer into which response bytes are read.
   scoped_refptr<IOBufferWithSize> io_buffer_;
 
+  uint32 ttl_;
+
   DISALLOW_COPY_AND_ASSIGN(DnsResponse);
 };
 
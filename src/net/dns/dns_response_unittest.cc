@@ -138,6 +138,73 @@ TEST(DnsResponseTest, ResponseWithCnameA) {
   IPAddressList actual_ips;
   EXPECT_EQ(OK, r1.Parse(response_size, &actual_ips));
   EXPECT_EQ(expected_ips, actual_ips);
+
+  // The smallest TTL is the one of the A record.
+  EXPECT_EQ(53u, r1.ttl());
+}
+
+TEST(DnsResponseTest, NameErrorWithSoa) {
+  const std::string kQname("\007missing\007example\003com", 21);
+  DnsQuery q1(kQname, kDNS_A, base::Bind(&base::RandInt));
+
+  uint8 id_hi = q1.id() >> 8, id_lo = q1.id() & 0xff;
+
+  uint8 response_data[] = {
+    // Header
+    id_hi, id_lo,             // ID
+    0x81, 0x83,               // Standard query response, no such name
+    0x00, 0x01,               // 1 question
+    0x00, 0x00,               // 0 RRs (answers)
+    0x00, 0x01,               // 1 authority RR
+    0x00, 0x00,               // 0 additional RRs
+
+    // Question
+    0x07, 0x6d, 0x69, 0x73,   // This part is echoed back from the
+    0x73, 0x69, 0x6e, 0x67,   // respective query.
+    0x07, 0x65, 0x78, 0x61,
+    0x6d, 0x70, 0x6c, 0x65,
+    0x03, 0x63, 0x6f, 0x6d,
+    0x00,
+    0x00, 0x01,
+    0x00, 0x01,
+
+    // Authority 1
+    0xc0, 0x14,         // NAME is a pointer to example.com in Question.
+    0x00, 0x06,         // TYPE is SOA.
+    0x00, 0x01,         // CLASS is IN.
+    0x00, 0x00,         // TTL (4 bytes) is 1 hour.
+    0x0e, 0x10,
+    0x00, 0x1b,         // RDLENGTH is 27 bytes.
+    0x02, 0x6e, 0x73,   // MNAME is ns.example.com.
+    0xc0, 0x14,
+    0xc0, 0x14,         // RNAME is example.com.
+    0x00, 0x00,         // SERIAL
+    0x00, 0x01,
+    0x00, 0x00,         // REFRESH
+    0x1c, 0x20,
+    0x00, 0x00,         // RETRY
+    0x0e, 0x10,
+    0x00, 0x12,         // EXPIRE
+    0x75, 0x00,
+    0x00, 0x00,         // MINIMUM is 5 minutes.
+    0x01, 0x2c,
+  };
+
+  DnsResponse r1(&q1);
+  memcpy(r1.io_buffer()->data(), &response_data[0], arraysize(response_data));
+
+  // The name doesn't exist, and that can be cached for the MINIMUM of the
+  // SOA record, which is smaller than its TTL.
+  int response_size = arraysize(response_data);
+  IPAddressList actual_ips;
+  EXPECT_EQ(ERR_NAME_NOT_RESOLVED, r1.Parse(response_size, &actual_ips));
+  EXPECT_TRUE(actual_ips.empty());
+  EXPECT_EQ(300u, r1.ttl());
+
+  // Without the authority section, the negative TTL is unknown.
+  r1.io_buffer()->data()[9] = 0x00;
+  EXPECT_EQ(ERR_NAME_NOT_RESOLVED, r1.Parse(response_size, &actual_ips));
+  EXPECT_EQ(0u, r1.ttl());
 }
 
 }  // namespace net
@@ -148,6 +148,7 @@ DnsTransaction::DnsTransaction(const IPEndPoint& dns_server,
                                NetLog* net_log)
     : dns_server_(dns_server),
       key_(dns_name, query_type),
+      ttl_(0),
       delegate_(NULL),
       query_(new DnsQuery(dns_name, query_type, rand_int)),
       attempts_(0),
@@ -270,6 +271,7 @@ int DnsTransaction::DoConnectComplete(int rv) {
 
 int DnsTransaction::DoSendQuery() {
   next_state_ = STATE_SEND_QUERY_COMPLETE;
+  send_time_ = base::TimeTicks::Now();
   return socket_->Write(query_->io_buffer(),
                         query_->io_buffer()->size(),
                         &io_callback_);
@@ -302,9 +304,12 @@ int DnsTransaction::DoReadResponseComplete(int rv) {
     return rv;
 
   DCHECK(rv);
+  rtt_ = base::TimeTicks::Now() - send_time_;
   // TODO(agayev): when supporting EDNS0 we may need to do multiple reads
   // to read the whole response.
-  return response_->Parse(rv, &ip_addresses_);
+  rv = response_->Parse(rv, &ip_addresses_);
+  ttl_ = response_->ttl();
+  return rv;
 }
 
 void DnsTransaction::StartTimer(base::TimeDelta delay) {
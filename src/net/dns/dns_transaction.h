@@ -77,6 +77,19 @@ class NET_EXPORT_PRIVATE DnsTransaction :
   ~DnsTransaction();
   void SetDelegate(Delegate* delegate);
   const Key& key() const { return key_; }
+  const IPEndPoint& dns_server() const { return dns_server_; }
+
+  // Once the transaction has completed, returns the addresses it found. Used
+  // when Start() completes synchronously.
+  const IPAddressList& ip_addresses() const { return ip_addresses_; }
+
+  // Once the transaction has completed, returns how long its result may be
+  // cached, in seconds (see DnsResponse::ttl()).
+  uint32 ttl() const { return ttl_; }
+
+  // Once the transaction has completed with a response, returns the time it
+  // took the server to answer the last query that was sent.
+  base::TimeDelta rtt() const { return rtt_; }
 
   // Starts the resolution process.  Will return ERR_IO_PENDING and will
   // notify the caller via |delegate|.  Should only be called once.
@@ -120,6 +133,9 @@ class NET_EXPORT_PRIVATE DnsTransaction :
   const IPEndPoint dns_server_;
   Key key_;
   IPAddressList ip_addresses_;
+  uint32 ttl_;
+  base::TimeTicks send_time_;
+  base::TimeDelta rtt_;
   Delegate* delegate_;
 
   scoped_ptr<DnsQuery> query_;
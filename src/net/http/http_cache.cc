@@ -40,6 +40,9 @@ namespace net {
 
 namespace {
 
+// The size of the buffer the shared writers read the response body into.
+const int kSharedWriterBufferSize = 32 * 1024;
+
 HttpNetworkSession* CreateNetworkSession(
     HostResolver* host_resolver,
     CertVerifier* cert_verifier,
@@ -52,6 +55,7 @@ HttpNetworkSession* CreateNetworkSession(
     HttpAuthHandlerFactory* http_auth_handler_factory,
     NetworkDelegate* network_delegate,
     HttpServerProperties* http_server_properties,
+    SSLSessionCache::PersistentStore* ssl_session_store,
     NetLog* net_log) {
   HttpNetworkSession::Params params;
   params.host_resolver = host_resolver;
@@ -61,6 +65,7 @@ HttpNetworkSession* CreateNetworkSession(
   params.dns_cert_checker = dns_cert_checker;
   params.proxy_service = proxy_service;
   params.ssl_host_info_factory = ssl_host_info_factory;
+  params.ssl_session_store = ssl_session_store;
   params.ssl_config_service = ssl_config_service;
   params.http_auth_handler_factory = http_auth_handler_factory;
   params.network_delegate = network_delegate;
@@ -106,6 +111,8 @@ HttpCache::ActiveEntry::ActiveEntry(disk_cache::Entry* entry)
 }
 
 HttpCache::ActiveEntry::~ActiveEntry() {
+  // The shared writer may have a pending write to |disk_entry|.
+  shared_writer.reset();
   if (disk_entry) {
     disk_entry->Close();
     disk_entry = NULL;
@@ -295,6 +302,168 @@ void HttpCache::MetadataWriter::OnIOComplete(int result) {
 
 //-----------------------------------------------------------------------------
 
+// This class reads the response body from a network transaction and appends
+// it to the entry, for all the transactions that read the entry meanwhile.
+// It is owned by the ActiveEntry, and lets the cache know about its progress
+// through ProcessPendingQueue(), so it is never deleted from its own callbacks.
+class HttpCache::SharedWriter {
+ public:
+  SharedWriter(HttpCache* cache, ActiveEntry* entry,
+               HttpTransaction* network_trans);
+  ~SharedWriter();
+
+  // Starts reading from the network.
+  void Start();
+
+  // Returns true until the whole body is stored, or writing it failed.
+  bool is_writing() const { return result_ == ERR_IO_PENDING; }
+
+  // Returns OK if the whole body is stored, or the error that stopped it.
+  int result() const { return result_; }
+
+  // Returns the number of body bytes that are stored.
+  int data_size() const { return data_size_; }
+
+ private:
+  enum State {
+    STATE_NONE,
+    STATE_NETWORK_READ,
+    STATE_NETWORK_READ_COMPLETE,
+    STATE_CACHE_WRITE_DATA,
+    STATE_CACHE_WRITE_DATA_COMPLETE
+  };
+
+  int DoLoop(int result);
+  int DoNetworkRead();
+  int DoNetworkReadComplete(int result);
+  int DoCacheWriteData(int num_bytes);
+  int DoCacheWriteDataComplete(int result);
+
+  void OnIOComplete(int result);
+
+  HttpCache* cache_;
+  ActiveEntry* entry_;
+  scoped_ptr<HttpTransaction> network_trans_;
+  State next_state_;
+  int result_;
+  int data_size_;
+  int write_len_;
+  scoped_refptr<IOBuffer> buf_;
+  OldCompletionCallbackImpl<SharedWriter> io_callback_;
+  // The disk cache may complete a write after we are gone.
+  scoped_refptr<CancelableOldCompletionCallback<SharedWriter> >
+      write_callback_;
+
+  DISALLOW_COPY_AND_ASSIGN(SharedWriter);
+};
+
+HttpCache::SharedWriter::SharedWriter(HttpCache* cache, ActiveEntry* entry,
+                                      HttpTransaction* network_trans)
+    : cache_(cache),
+      entry_(entry),
+      network_trans_(network_trans),
+      next_state_(STATE_NONE),
+      result_(ERR_IO_PENDING),
+      data_size_(entry->disk_entry->GetDataSize(kResponseContentIndex)),
+      write_len_(0),
+      buf_(new IOBuffer(kSharedWriterBufferSize)),
+      ALLOW_THIS_IN_INITIALIZER_LIST(
+          io_callback_(this, &SharedWriter::OnIOComplete)),
+      ALLOW_THIS_IN_INITIALIZER_LIST(
+          write_callback_(new CancelableOldCompletionCallback<SharedWriter>(
+              this, &SharedWriter::OnIOComplete))) {
+}
+
+HttpCache::SharedWriter::~SharedWriter() {
+  write_callback_->Cancel();
+}
+
+void HttpCache::SharedWriter::Start() {
+  DCHECK_EQ(STATE_NONE, next_state_);
+  next_state_ = STATE_NETWORK_READ;
+  DoLoop(OK);
+}
+
+int HttpCache::SharedWriter::DoLoop(int result) {
+  DCHECK(next_state_ != STATE_NONE);
+
+  int rv = result;
+  do {
+    State state = next_state_;
+    next_state_ = STATE_NONE;
+    switch (state) {
+      case STATE_NETWORK_READ:
+        DCHECK_EQ(OK, rv);
+        rv = DoNetworkRead();
+        break;
+      case STATE_NETWORK_READ_COMPLETE:
+        rv = DoNetworkReadComplete(rv);
+        break;
+      case STATE_CACHE_WRITE_DATA:
+        rv = DoCacheWriteData(rv);
+        break;
+      case STATE_CACHE_WRITE_DATA_COMPLETE:
+        rv = DoCacheWriteDataComplete(rv);
+        break;
+      default:
+        NOTREACHED() << "bad state";
+        rv = ERR_FAILED;
+        break;
+    }
+  } while (rv != ERR_IO_PENDING && next_state_ != STATE_NONE);
+
+  if (rv != ERR_IO_PENDING) {
+    // Done: the cache deals with the readers and with the entry.
+    result_ = rv;
+    network_trans_.reset();
+    cache_->ProcessPendingQueue(entry_);
+  }
+  return rv;
+}
+
+int HttpCache::SharedWriter::DoNetworkRead() {
+  next_state_ = STATE_NETWORK_READ_COMPLETE;
+  return network_trans_->Read(buf_, kSharedWriterBufferSize, &io_callback_);
+}
+
+int HttpCache::SharedWriter::DoNetworkReadComplete(int result) {
+  // The end of the body, or an error.
+  if (result <= 0)
+    return result;
+
+  next_state_ = STATE_CACHE_WRITE_DATA;
+  return result;
+}
+
+int HttpCache::SharedWriter::DoCacheWriteData(int num_bytes) {
+  next_state_ = STATE_CACHE_WRITE_DATA_COMPLETE;
+  write_len_ = num_bytes;
+  write_callback_->AddRef();  // Balanced in DoCacheWriteDataComplete.
+  return entry_->disk_entry->WriteData(kResponseContentIndex, data_size_, buf_,
+                                       num_bytes, write_callback_, true);
+}
+
+int HttpCache::SharedWriter::DoCacheWriteDataComplete(int result) {
+  write_callback_->Release();  // Balance the AddRef from DoCacheWriteData.
+  if (result != write_len_) {
+    DLOG(ERROR) << "failed to write response data to cache";
+    return ERR_CACHE_WRITE_FAILURE;
+  }
+
+  data_size_ += result;
+  if (!entry_->data_waiters.empty())
+    cache_->ProcessPendingQueue(entry_);
+
+  next_state_ = STATE_NETWORK_READ;
+  return OK;
+}
+
+void HttpCache::SharedWriter::OnIOComplete(int result) {
+  DoLoop(result);
+}
+
+//-----------------------------------------------------------------------------
+
 class HttpCache::SSLHostInfoFactoryAdaptor : public SSLHostInfoFactory {
  public:
   SSLHostInfoFactoryAdaptor(CertVerifier* cert_verifier, HttpCache* http_cache)
@@ -324,6 +493,7 @@ HttpCache::HttpCache(HostResolver* host_resolver,
                      HttpAuthHandlerFactory* http_auth_handler_factory,
                      NetworkDelegate* network_delegate,
                      HttpServerProperties* http_server_properties,
+                     SSLSessionCache::PersistentStore* ssl_session_store,
                      NetLog* net_log,
                      BackendFactory* backend_factory)
     : net_log_(net_log),
@@ -347,6 +517,7 @@ HttpCache::HttpCache(HostResolver* host_resolver,
                   http_auth_handler_factory,
                   network_delegate,
                   http_server_properties,
+                  ssl_session_store,
                   net_log))),
       ALLOW_THIS_IN_INITIALIZER_LIST(task_factory_(this)) {
 }
@@ -824,7 +995,15 @@ int HttpCache::AddTransactionToEntry(ActiveEntry* entry, Transaction* trans) {
     return ERR_IO_PENDING;
   }
 
-  if (trans->mode() & Transaction::WRITE) {
+  if (entry->shared_writer.get() && entry->shared_writer->is_writing()) {
+    // The response is being stored for the current readers, which read it as
+    // it arrives. Transactions that can't do that wait for it to be complete.
+    if (!CanJoinSharedWriter(entry, trans)) {
+      entry->pending_queue.push_back(trans);
+      return ERR_IO_PENDING;
+    }
+    entry->readers.push_back(trans);
+  } else if (trans->mode() & Transaction::WRITE) {
     // transaction needs exclusive access to the entry
     if (entry->readers.empty()) {
       entry->writer = trans;
@@ -906,6 +1085,10 @@ void HttpCache::DoneReadingFromEntry(ActiveEntry* entry, Transaction* trans) {
 
   entry->readers.erase(it);
 
+  it = std::find(entry->data_waiters.begin(), entry->data_waiters.end(), trans);
+  if (it != entry->data_waiters.end())
+    entry->data_waiters.erase(it);
+
   ProcessPendingQueue(entry);
 }
 
@@ -922,6 +1105,49 @@ void HttpCache::ConvertWriterToReader(ActiveEntry* entry) {
   ProcessPendingQueue(entry);
 }
 
+void HttpCache::StartSharedWriting(ActiveEntry* entry,
+                                   HttpTransaction* network_trans) {
+  DCHECK(entry->writer);
+  DCHECK(entry->readers.empty());
+  DCHECK(!entry->shared_writer.get());
+
+  Transaction* trans = entry->writer;
+  entry->writer = NULL;
+  entry->readers.push_back(trans);
+
+  entry->shared_writer.reset(new SharedWriter(this, entry, network_trans));
+  entry->shared_writer->Start();
+
+  ProcessPendingQueue(entry);
+}
+
+bool HttpCache::CanJoinSharedWriter(ActiveEntry* entry, Transaction* trans) {
+  return entry->shared_writer.get() && entry->shared_writer->is_writing() &&
+         trans->CanReadWhileWriting();
+}
+
+int HttpCache::WaitForEntryData(ActiveEntry* entry, Transaction* trans,
+                                int offset) {
+  SharedWriter* shared_writer = entry->shared_writer.get();
+  if (!shared_writer) {
+    int data_size = entry->disk_entry->GetDataSize(kResponseContentIndex);
+    return std::max(data_size - offset, 0);
+  }
+
+  if (shared_writer->data_size() > offset)
+    return shared_writer->data_size() - offset;
+
+  if (!shared_writer->is_writing()) {
+    // OK means that we are at the end of the response.
+    return shared_writer->result();
+  }
+
+  DCHECK(std::find(entry->data_waiters.begin(), entry->data_waiters.end(),
+                   trans) == entry->data_waiters.end());
+  entry->data_waiters.push_back(trans);
+  return ERR_IO_PENDING;
+}
+
 LoadState HttpCache::GetLoadStateForPendingTransaction(
       const Transaction* trans) {
   ActiveEntriesMap::const_iterator i = active_entries_.find(trans->key());
@@ -1018,16 +1244,65 @@ void HttpCache::OnProcessPendingQueue(ActiveEntry* entry) {
   entry->will_process_pending_queue = false;
   DCHECK(!entry->writer);
 
+  SharedWriter* shared_writer = entry->shared_writer.get();
+  if (shared_writer && !shared_writer->is_writing()) {
+    if (shared_writer->result() == OK) {
+      // The whole response is stored, so this is a regular entry now.
+      entry->shared_writer.reset();
+    } else if (!entry->pending_queue.empty() || !entry->doomed) {
+      // The response can't be completed. The readers fail when they reach the
+      // end of the stored data, and the transactions that were waiting for
+      // the entry have to start over with a new one.
+      TransactionList pending_queue;
+      pending_queue.swap(entry->pending_queue);
+
+      bool destroy_entry = entry->readers.empty();
+      if (!entry->doomed) {
+        if (destroy_entry)
+          entry->disk_entry->Doom();
+        else
+          DoomEntry(entry->disk_entry->GetKey(), NULL);
+      }
+      if (destroy_entry)
+        DestroyEntry(entry);
+
+      while (!pending_queue.empty()) {
+        // ERR_CACHE_RACE causes the transaction to restart the whole process.
+        pending_queue.front()->io_callback()->Run(ERR_CACHE_RACE);
+        pending_queue.pop_front();
+      }
+      if (destroy_entry)
+        return;
+    }
+  }
+
+  // Let the readers that caught up with the shared writer read the new data,
+  // or find out how the response ended. The ones that read all the data wait
+  // again at the end of the list.
+  size_t num_waiters = entry->data_waiters.size();
+  for (size_t i = 0; i < num_waiters && !entry->data_waiters.empty(); ++i) {
+    Transaction* trans = entry->data_waiters.front();
+    entry->data_waiters.pop_front();
+    trans->io_callback()->Run(OK);
+  }
+  if (entry->will_process_pending_queue)
+    return;  // A reader went away; there will be another pass.
+
   // If no one is interested in this entry, then we can de-activate it.
   if (entry->pending_queue.empty()) {
-    if (entry->readers.empty())
+    if (entry->readers.empty()) {
+      // A response that is still being written won't be complete.
+      if (entry->shared_writer.get() && entry->shared_writer->is_writing())
+        entry->disk_entry->Doom();
       DestroyEntry(entry);
+    }
     return;
   }
 
   // Promote next transaction from the pending queue.
   Transaction* next = entry->pending_queue.front();
-  if ((next->mode() & Transaction::WRITE) && !entry->readers.empty())
+  if ((next->mode() & Transaction::WRITE) && !entry->readers.empty() &&
+      !CanJoinSharedWriter(entry, next))
     return;  // Have to wait.
 
   entry->pending_queue.erase(entry->pending_queue.begin());
@@ -33,6 +33,7 @@
 #include "net/base/load_states.h"
 #include "net/base/net_export.h"
 #include "net/http/http_transaction_factory.h"
+#include "net/socket/ssl_session_cache.h"
 
 class GURL;
 
@@ -131,6 +132,7 @@ class NET_EXPORT HttpCache : public HttpTransactionFactory,
             HttpAuthHandlerFactory* http_auth_handler_factory,
             NetworkDelegate* network_delegate,
             HttpServerProperties* http_server_properties,
+            SSLSessionCache::PersistentStore* ssl_session_store,
             NetLog* net_log,
             BackendFactory* backend_factory);
 
@@ -213,6 +215,7 @@ class NET_EXPORT HttpCache : public HttpTransactionFactory,
 
   class BackendCallback;
   class MetadataWriter;
+  class SharedWriter;
   class SSLHostInfoFactoryAdaptor;
   class Transaction;
   class WorkItem;
@@ -232,6 +235,12 @@ class NET_EXPORT HttpCache : public HttpTransactionFactory,
     TransactionList    pending_queue;
     bool               will_process_pending_queue;
     bool               doomed;
+
+    // Set when the response body is stored by a SharedWriter instead of
+    // |writer|, so that the readers can stream it while it is written.
+    scoped_ptr<SharedWriter> shared_writer;
+    // The readers waiting for |shared_writer| to store more data.
+    TransactionList    data_waiters;
   };
 
   typedef base::hash_map<std::string, ActiveEntry*> ActiveEntriesMap;
@@ -327,6 +336,24 @@ class NET_EXPORT HttpCache : public HttpTransactionFactory,
   // transactions can start reading from this entry.
   void ConvertWriterToReader(ActiveEntry* entry);
 
+  // Converts the active writer transaction to a reader of the response body
+  // that |network_trans| keeps writing to the entry, so that other
+  // transactions can read the response without waiting for the whole body.
+  // Takes ownership of |network_trans|.
+  void StartSharedWriting(ActiveEntry* entry, HttpTransaction* network_trans);
+
+  // Returns true if |trans| can be added as a reader of |entry| while its
+  // shared writer is storing the response.
+  bool CanJoinSharedWriter(ActiveEntry* entry, Transaction* trans);
+
+  // Returns the number of bytes of the response body of |entry| that can be
+  // read from |offset|. If a shared writer is storing the response and has not
+  // stored data past |offset| yet, returns ERR_IO_PENDING and |trans| will be
+  // notified via its IO callback when there is more data; if the shared
+  // writer failed, its error is returned once |offset| reaches the end of the
+  // stored data.
+  int WaitForEntryData(ActiveEntry* entry, Transaction* trans, int offset);
+
   // Returns the LoadState of the provided pending transaction.
   LoadState GetLoadStateForPendingTransaction(const Transaction* trans);
 
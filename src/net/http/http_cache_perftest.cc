@@ -0,0 +1,124 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <algorithm>
+#include <string>
+
+#include "base/basictypes.h"
+#include "base/memory/ref_counted.h"
+#include "base/memory/scoped_ptr.h"
+#include "base/memory/scoped_vector.h"
+#include "base/message_loop.h"
+#include "base/perftimer.h"
+#include "base/stringprintf.h"
+#include "base/time.h"
+#include "net/base/io_buffer.h"
+#include "net/base/net_errors.h"
+#include "net/base/net_log.h"
+#include "net/http/http_cache.h"
+#include "net/http/http_transaction_unittest.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace {
+
+const int kNumRequests = 100;
+const int kBodySize = 50 * 1024 * 1024;
+const int kReadSize = 32 * 1024;
+
+// Starts a request and reads the whole response, like a consumer that keeps up
+// with the data, recording how long it took for the first bytes to arrive.
+class FirstByteRequest : public CallbackRunner< Tuple1<int> > {
+ public:
+  FirstByteRequest() : done_(false), result_(net::OK) {}
+
+  bool done() const { return done_; }
+  int result() const { return result_; }
+  base::TimeDelta time_to_first_byte() const {
+    return first_byte_time_ - start_time_;
+  }
+
+  void Start(net::HttpCache* cache, const MockHttpRequest& request) {
+    start_time_ = base::TimeTicks::Now();
+    int rv = cache->CreateTransaction(&trans_);
+    if (rv == net::OK)
+      rv = trans_->Start(&request, this, net::BoundNetLog());
+    if (rv != net::ERR_IO_PENDING)
+      OnIOComplete(rv);
+  }
+
+  virtual void RunWithParams(const Tuple1<int>& params) {
+    OnIOComplete(params.a);
+  }
+
+ private:
+  // The first call completes Start(), the next ones complete Read().
+  void OnIOComplete(int result) {
+    bool started = !buf_;
+    if (started)
+      buf_ = new net::IOBuffer(kReadSize);
+    while (result > 0 || (started && result == net::OK)) {
+      if (result > 0 && first_byte_time_.is_null())
+        first_byte_time_ = base::TimeTicks::Now();
+      started = false;
+      result = trans_->Read(buf_, kReadSize, this);
+      if (result == net::ERR_IO_PENDING)
+        return;
+    }
+    result_ = result;
+    done_ = true;
+    trans_.reset();
+  }
+
+  scoped_ptr<net::HttpTransaction> trans_;
+  scoped_refptr<net::IOBuffer> buf_;
+  base::TimeTicks start_time_;
+  base::TimeTicks first_byte_time_;
+  bool done_;
+  int result_;
+};
+
+}  // namespace
+
+// Requests the same large resource many times while it is not in the cache.
+// All the requests are served by a single network transaction; the others
+// only have to wait for the beginning of the response to be stored.
+TEST(HttpCachePerfTest, ConcurrentTimeToFirstByte) {
+  MessageLoopForIO message_loop;
+  // The cache must be able to store the whole response in one entry, which is
+  // up to an eighth of its size.
+  net::HttpCache cache(new MockNetworkLayer(), NULL,
+                       net::HttpCache::DefaultBackend::InMemory(8 * kBodySize));
+
+  std::string body(kBodySize, 'x');
+  std::string headers = base::StringPrintf(
+      "%sContent-Length: %d\n", kSimpleGET_Transaction.response_headers,
+      kBodySize);
+  ScopedMockTransaction transaction(kSimpleGET_Transaction);
+  transaction.response_headers = headers.c_str();
+  transaction.data = body.c_str();
+  MockHttpRequest request(transaction);
+
+  PerfTimer timer;
+  ScopedVector<FirstByteRequest> requests;
+  for (int i = 0; i < kNumRequests; ++i) {
+    requests.push_back(new FirstByteRequest());
+    requests[i]->Start(&cache, request);
+  }
+  MessageLoop::current()->RunAllPending();
+  double total_ms = timer.Elapsed().InMillisecondsF();
+
+  double sum_ms = 0;
+  double max_ms = 0;
+  for (int i = 0; i < kNumRequests; ++i) {
+    ASSERT_TRUE(requests[i]->done());
+    EXPECT_EQ(net::OK, requests[i]->result());
+    double ms = requests[i]->time_to_first_byte().InMillisecondsF();
+    sum_ms += ms;
+    max_ms = std::max(max_ms, ms);
+  }
+
+  LogPerfResult("HttpCache_concurrent_ttfb_mean", sum_ms / kNumRequests, "ms");
+  LogPerfResult("HttpCache_concurrent_ttfb_max", max_ms, "ms");
+  LogPerfResult("HttpCache_concurrent_total", total_ms, "ms");
+}
@@ -10,6 +10,7 @@
 #include <unistd.h>
 #endif
 
+#include <algorithm>
 #include <string>
 
 #include "base/compiler_specific.h"
@@ -77,6 +78,9 @@ static const HeaderNameAndValue kForceValidateHeaders[] = {
   { NULL, NULL }
 };
 
+// The largest amount of response data that is mapped from the cache at once.
+static const int kMaxMappedDataSize = 1024 * 1024;
+
 static bool HeaderMatches(const HttpRequestHeaders& headers,
                           const HeaderNameAndValue* search) {
   for (; search->name; ++search) {
@@ -98,6 +102,23 @@ static bool HeaderMatches(const HttpRequestHeaders& headers,
 
 //-----------------------------------------------------------------------------
 
+// The completion callback for disk_cache::Entry::MapData().  It owns the buffer
+// that receives the mapped data, so if the transaction goes away while the
+// operation is in progress, the mapping is released with the callback.
+class HttpCache::Transaction::MapDataCallback
+    : public CancelableOldCompletionCallback<Transaction> {
+ public:
+  explicit MapDataCallback(Transaction* transaction)
+      : CancelableOldCompletionCallback<Transaction>(
+            transaction, &Transaction::OnIOComplete) {
+  }
+
+  scoped_refptr<IOBuffer>* buf() { return &buf_; }
+
+ private:
+  scoped_refptr<IOBuffer> buf_;
+};
+
 HttpCache::Transaction::Transaction(HttpCache* cache)
     : next_state_(STATE_NONE),
       request_(NULL),
@@ -118,6 +139,9 @@ HttpCache::Transaction::Transaction(HttpCache* cache)
       cache_pending_(false),
       done_reading_(false),
       read_offset_(0),
+      mapped_offset_(0),
+      mapped_len_(0),
+      map_failed_(false),
       effective_load_flags_(0),
       write_len_(0),
       final_upload_progress_(0),
@@ -160,6 +184,8 @@ HttpCache::Transaction::~Transaction() {
   // does nothing.
   cache_callback_->Cancel();
   write_headers_callback_->Cancel();
+  if (map_callback_)
+    map_callback_->Cancel();
 
   // We could still have a cache read or write in progress, so we just null the
   // cache_ pointer to signal that we are dead.  See DoCacheReadCompleted.
@@ -203,6 +229,14 @@ bool HttpCache::Transaction::AddTruncatedFlag() {
   return true;
 }
 
+bool HttpCache::Transaction::CanReadWhileWriting() const {
+  // Range requests deal with the stored data by themselves, and there is no
+  // point in revalidating a response that is still being received.
+  return (mode_ == READ || mode_ == READ_WRITE) && !partial_.get() &&
+         !range_requested_ &&
+         !(effective_load_flags_ & LOAD_VALIDATE_CACHE);
+}
+
 LoadState HttpCache::Transaction::GetWriterLoadState() const {
   if (network_trans_.get())
     return network_trans_->GetLoadState();
@@ -331,6 +365,15 @@ int HttpCache::Transaction::Read(IOBuffer* buf, int buf_len,
     mode_ = NONE;
   }
 
+  // Instead of making the transactions that wait for this entry wait for the
+  // whole body, let them read it from the entry as it arrives, like we do.
+  if (mode_ == WRITE && ShouldShareWriting()) {
+    final_upload_progress_ = network_trans_->GetUploadProgress();
+    read_offset_ = entry_->disk_entry->GetDataSize(kResponseContentIndex);
+    cache_->StartSharedWriting(entry_, network_trans_.release());
+    mode_ = READ;
+  }
+
   reading_ = true;
   int rv;
 
@@ -620,6 +663,9 @@ int HttpCache::Transaction::DoLoop(int result) {
         DCHECK_EQ(OK, rv);
         rv = DoCacheReadData();
         break;
+      case STATE_CACHE_MAP_DATA_COMPLETE:
+        rv = DoCacheMapDataComplete(rv);
+        break;
       case STATE_CACHE_READ_DATA_COMPLETE:
         rv = DoCacheReadDataComplete(rv);
         break;
@@ -1304,6 +1350,37 @@ int HttpCache::Transaction::DoCacheQueryDataComplete(int result) {
 
 int HttpCache::Transaction::DoCacheReadData() {
   DCHECK(entry_);
+  int remaining_len = 0;
+  if (!partial_.get()) {
+    // If the response is still being written, only the data that is already
+    // stored can be read.
+    remaining_len = cache_->WaitForEntryData(entry_, this, read_offset_);
+    if (remaining_len == ERR_IO_PENDING) {
+      next_state_ = STATE_CACHE_READ_DATA;
+      return ERR_IO_PENDING;
+    }
+    if (remaining_len < 0)
+      return remaining_len;
+  }
+
+  if (!partial_.get() && !map_failed_ && !HasMappedData() &&
+      remaining_len > io_buf_len_) {
+    // Map a large chunk of the response, so that the next reads are served
+    // straight from it instead of going to the cache thread one at a time.
+    // The rest of the response fits in a single ReadData() otherwise, which
+    // is cheaper than setting up the mapping.
+    next_state_ = STATE_CACHE_MAP_DATA_COMPLETE;
+    mapped_buf_ = NULL;
+    map_callback_ = new MapDataCallback(this);
+    map_callback_->AddRef();  // Balanced in DoCacheMapDataComplete.
+    return entry_->disk_entry->MapData(
+        kResponseContentIndex, read_offset_,
+        std::min(remaining_len, kMaxMappedDataSize), map_callback_->buf(),
+        map_callback_);
+  }
+  if (remaining_len > 0 && remaining_len < io_buf_len_)
+    io_buf_len_ = remaining_len;
+
   next_state_ = STATE_CACHE_READ_DATA_COMPLETE;
   cache_callback_->AddRef();  // Balanced in DoCacheReadDataComplete.
 
@@ -1314,10 +1391,32 @@ int HttpCache::Transaction::DoCacheReadData() {
                                cache_callback_);
   }
 
+  if (HasMappedData())
+    return ReadMappedData();
+
   return entry_->disk_entry->ReadData(kResponseContentIndex, read_offset_,
                                       read_buf_, io_buf_len_, cache_callback_);
 }
 
+int HttpCache::Transaction::DoCacheMapDataComplete(int result) {
+  map_callback_->Release();  // Balance the AddRef from DoCacheReadData.
+  if (result > 0) {
+    mapped_buf_.swap(*map_callback_->buf());
+    mapped_offset_ = read_offset_;
+    mapped_len_ = result;
+  } else {
+    // Let ReadData() deal with the end of the data or with the error.
+    map_failed_ = true;
+  }
+  map_callback_ = NULL;
+
+  if (!cache_)
+    return ERR_UNEXPECTED;
+
+  next_state_ = STATE_CACHE_READ_DATA;
+  return OK;
+}
+
 int HttpCache::Transaction::DoCacheReadDataComplete(int result) {
   cache_callback_->Release();  // Balance the AddRef from DoCacheReadData.
   if (net_log_.IsLoggingAllEvents()) {
@@ -1334,6 +1433,7 @@ int HttpCache::Transaction::DoCacheReadDataComplete(int result) {
   if (result > 0) {
     read_offset_ += result;
   } else if (result == 0) {  // End of file.
+    mapped_buf_ = NULL;
     cache_->DoneReadingFromEntry(entry_, this);
     entry_ = NULL;
   }
@@ -1559,11 +1659,20 @@ int HttpCache::Transaction::BeginCacheValidation() {
       next_state_ = STATE_PARTIAL_HEADERS_RECEIVED;
       return OK;
     }
-    cache_->ConvertWriterToReader(entry_);
+    // We may have joined a shared writer as a reader already.
+    if (entry_->writer == this)
+      cache_->ConvertWriterToReader(entry_);
     mode_ = READ;
 
     if (entry_->disk_entry->GetDataSize(kMetadataIndex))
       next_state_ = STATE_CACHE_READ_METADATA;
+  } else if (entry_->writer != this) {
+    // We joined a shared writer and can't use the response it is storing, nor
+    // update the entry: bypass the cache.
+    cache_->DoneReadingFromEntry(entry_, this);
+    entry_ = NULL;
+    mode_ = NONE;
+    next_state_ = STATE_SEND_REQUEST;
   } else {
     // Make the network request conditional, to see if we may reuse our cached
     // response.  If we cannot do so, then we just resort to a normal fetch.
@@ -1693,6 +1802,30 @@ int HttpCache::Transaction::RestartNetworkRequestWithAuth(
   return rv;
 }
 
+bool HttpCache::Transaction::ShouldShareWriting() const {
+  if (!entry_ || entry_->writer != this || !network_trans_.get() ||
+      partial_.get() || done_reading_ || !response_.headers ||
+      response_.headers->response_code() != 200) {
+    return false;
+  }
+
+  // The readers can't get the response from anywhere else than the entry, so
+  // it must fit there. Otherwise we keep the response for ourselves, and stop
+  // writing it when the cache refuses more data.
+  int64 content_length = response_.headers->GetContentLength();
+  int64 max_size = cache_->disk_cache_->MaxFileSize() -
+      entry_->disk_entry->GetDataSize(kResponseContentIndex);
+  if (content_length < 0 || content_length > max_size)
+    return false;
+
+  for (TransactionList::const_iterator it = entry_->pending_queue.begin();
+       it != entry_->pending_queue.end(); ++it) {
+    if ((*it)->CanReadWhileWriting())
+      return true;
+  }
+  return false;
+}
+
 bool HttpCache::Transaction::RequiresValidation() {
   // TODO(darin): need to do more work here:
   //  - make sure we have a matching request method
@@ -1783,6 +1916,18 @@ bool HttpCache::Transaction::ConditionalizeRequest() {
   return true;
 }
 
+bool HttpCache::Transaction::HasMappedData() const {
+  return mapped_buf_ && read_offset_ >= mapped_offset_ &&
+         read_offset_ < mapped_offset_ + mapped_len_;
+}
+
+int HttpCache::Transaction::ReadMappedData() {
+  int num = std::min(io_buf_len_, mapped_offset_ + mapped_len_ - read_offset_);
+  memcpy(read_buf_->data(), mapped_buf_->data() + read_offset_ - mapped_offset_,
+         num);
+  return num;
+}
+
 // We just received some headers from the server. We may have asked for a range,
 // in which case partial_ has an object. This could be the first network request
 // we make to fulfill the original request, or we may be already reading (from
@@ -87,6 +87,10 @@ class HttpCache::Transaction : public HttpTransaction {
   // success.
   bool AddTruncatedFlag();
 
+  // Returns true if this transaction can read the response from its entry
+  // while a shared writer is still storing it.
+  bool CanReadWhileWriting() const;
+
   // Returns the LoadState of the writer transaction of a given ActiveEntry. In
   // other words, returns the LoadState of this transaction without asking the
   // http cache, because this transaction should be the one currently writing
@@ -115,6 +119,8 @@ class HttpCache::Transaction : public HttpTransaction {
   virtual uint64 GetUploadProgress(void) const;
 
  private:
+  class MapDataCallback;
+
   static const size_t kNumValidationHeaders = 2;
   // Helper struct to pair a header name with its value, for
   // headers used to validate cache entries.
@@ -163,6 +169,7 @@ class HttpCache::Transaction : public HttpTransaction {
     STATE_CACHE_QUERY_DATA,
     STATE_CACHE_QUERY_DATA_COMPLETE,
     STATE_CACHE_READ_DATA,
+    STATE_CACHE_MAP_DATA_COMPLETE,
     STATE_CACHE_READ_DATA_COMPLETE,
     STATE_CACHE_WRITE_DATA,
     STATE_CACHE_WRITE_DATA_COMPLETE
@@ -217,6 +224,7 @@ class HttpCache::Transaction : public HttpTransaction {
   int DoCacheQueryData();
   int DoCacheQueryDataComplete(int result);
   int DoCacheReadData();
+  int DoCacheMapDataComplete(int result);
   int DoCacheReadDataComplete(int result);
   int DoCacheWriteData(int num_bytes);
   int DoCacheWriteDataComplete(int result);
@@ -261,6 +269,12 @@ class HttpCache::Transaction : public HttpTransaction {
   int RestartNetworkRequestWithAuth(const string16& username,
                                     const string16& password);
 
+  // Returns true if the transactions waiting for the entry should be able to
+  // read the response while it is written, instead of waiting for this
+  // transaction to be done with the body. That requires a response whose
+  // length is known, and that the cache can store whole.
+  bool ShouldShareWriting() const;
+
   // Called to determine if we need to validate the cache entry before using it.
   bool RequiresValidation();
 
@@ -268,6 +282,14 @@ class HttpCache::Transaction : public HttpTransaction {
   // copy is valid).  Returns true if able to make the request conditional.
   bool ConditionalizeRequest();
 
+  // Returns true if the response data at |read_offset_| is available on
+  // |mapped_buf_|.
+  bool HasMappedData() const;
+
+  // Copies the response data at |read_offset_| from |mapped_buf_| to
+  // |read_buf_|.  Returns the number of bytes copied.
+  int ReadMappedData();
+
   // Makes sure that a 206 response is expected.  Returns true on success.
   // On success, handling_206_ will be set to true if we are processing a
   // partial entry.
@@ -355,6 +377,10 @@ class HttpCache::Transaction : public HttpTransaction {
   scoped_refptr<IOBuffer> read_buf_;
   int io_buf_len_;
   int read_offset_;
+  scoped_refptr<IOBuffer> mapped_buf_;  // Response data mapped from the cache.
+  int mapped_offset_;  // The offset of |mapped_buf_| on the response data.
+  int mapped_len_;
+  bool map_failed_;  // The cache cannot map the response data.
   int effective_load_flags_;
   int write_len_;
   scoped_ptr<PartialData> partial_;  // We are dealing with range requests.
@@ -363,6 +389,7 @@ class HttpCache::Transaction : public HttpTransaction {
   scoped_refptr<CancelableOldCompletionCallback<Transaction> > cache_callback_;
   scoped_refptr<CancelableOldCompletionCallback<Transaction> >
       write_headers_callback_;
+  scoped_refptr<MapDataCallback> map_callback_;
 };
 
 }  // namespace net
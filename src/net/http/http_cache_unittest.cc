@@ -136,6 +136,35 @@ class MockDiskEntry : public disk_cache::Entry,
     return net::ERR_IO_PENDING;
   }
 
+  virtual int MapData(int index, int offset, int buf_len,
+                      scoped_refptr<net::IOBuffer>* buf,
+                      net::OldCompletionCallback* callback) {
+    DCHECK(index >= 0 && index < kNumCacheEntryDataIndices);
+    DCHECK(callback);
+
+    if (!map_data_)
+      return net::ERR_CACHE_OPERATION_NOT_SUPPORTED;
+
+    if (fail_requests_)
+      return net::ERR_CACHE_READ_FAILURE;
+
+    if (offset < 0 || offset > static_cast<int>(data_[index].size()))
+      return net::ERR_FAILED;
+    if (static_cast<size_t>(offset) == data_[index].size())
+      return 0;
+
+    // There is no file to map here, so just hand out a copy of the data.
+    int num = std::min(buf_len, static_cast<int>(data_[index].size()) - offset);
+    *buf = new net::IOBuffer(num);
+    memcpy((*buf)->data(), &data_[index][offset], num);
+
+    if (GetEffectiveTestMode(test_mode_) & TEST_MODE_SYNC_CACHE_READ)
+      return num;
+
+    CallbackLater(callback, num);
+    return net::ERR_IO_PENDING;
+  }
+
   virtual int WriteData(int index, int offset, net::IOBuffer* buf, int buf_len,
                         net::OldCompletionCallback* callback, bool truncate) {
     DCHECK(index >= 0 && index < kNumCacheEntryDataIndices);
@@ -284,6 +313,10 @@ class MockDiskEntry : public disk_cache::Entry,
   // Fail most subsequent requests.
   void set_fail_requests() { fail_requests_ = true; }
 
+  // If |value| is false, MapData() is not supported by any entry.  Caution:
+  // remember to enable it again or subsequent tests will not use it.
+  static void EnableMapData(bool value) { map_data_ = value; }
+
   // If |value| is true, don't deliver any completion callbacks until called
   // again with |value| set to false.  Caution: remember to enable callbacks
   // again or all subsequent tests will fail.
@@ -362,11 +395,13 @@ class MockDiskEntry : public disk_cache::Entry,
   bool delayed_;
   static bool cancel_;
   static bool ignore_callbacks_;
+  static bool map_data_;
 };
 
 // Statics.
 bool MockDiskEntry::cancel_ = false;
 bool MockDiskEntry::ignore_callbacks_ = false;
+bool MockDiskEntry::map_data_ = true;
 
 class MockDiskCache : public disk_cache::Backend {
  public:
@@ -383,6 +418,10 @@ class MockDiskCache : public disk_cache::Backend {
     return static_cast<int32>(entries_.size());
   }
 
+  virtual int MaxFileSize() const {
+    return kint32max;
+  }
+
   virtual int OpenEntry(const std::string& key, disk_cache::Entry** entry,
                         net::OldCompletionCallback* callback) {
     DCHECK(callback);
@@ -1271,6 +1310,86 @@ TEST(HttpCache, SimpleGET_LoadOnlyFromCache_Hit) {
   EXPECT_EQ(1, cache.disk_cache()->create_count());
 }
 
+// Reads the response of |trans| |chunk_size| bytes at a time.
+static std::string ReadInChunks(net::HttpTransaction* trans, int chunk_size) {
+  scoped_refptr<net::IOBuffer> buf(new net::IOBuffer(chunk_size));
+  TestOldCompletionCallback callback;
+  std::string content;
+  for (;;) {
+    int rv = trans->Read(buf, chunk_size, &callback);
+    rv = callback.GetResult(rv);
+    EXPECT_GE(rv, 0);
+    if (rv <= 0)
+      break;
+    content.append(buf->data(), rv);
+  }
+  return content;
+}
+
+// Tests that cache hits are served both when the cache can map the response
+// data and when it cannot.
+TEST(HttpCache, SimpleGET_LoadOnlyFromCache_MapData) {
+  MockHttpCache cache;
+
+  // Write to the cache.
+  RunTransactionTest(cache.http_cache(), kSimpleGET_Transaction);
+
+  // Force this transaction to read from the cache.
+  MockTransaction transaction(kSimpleGET_Transaction);
+  transaction.load_flags |= net::LOAD_ONLY_FROM_CACHE;
+  MockHttpRequest request(transaction);
+
+  for (int i = 0; i < 2; i++) {
+    MockDiskEntry::EnableMapData(i == 0);
+    TestOldCompletionCallback callback;
+    scoped_ptr<net::HttpTransaction> trans;
+    int rv = cache.http_cache()->CreateTransaction(&trans);
+    EXPECT_EQ(net::OK, rv);
+    rv = trans->Start(&request, &callback, net::BoundNetLog());
+    ASSERT_EQ(net::OK, callback.GetResult(rv));
+
+    // Small reads make the transaction map the data.
+    EXPECT_EQ(std::string(transaction.data), ReadInChunks(trans.get(), 5));
+
+    // Let the entry be closed, so that the next transaction opens it again.
+    trans.reset();
+    MessageLoop::current()->RunAllPending();
+  }
+  MockDiskEntry::EnableMapData(true);
+
+  EXPECT_EQ(1, cache.network_layer()->transaction_count());
+  EXPECT_EQ(2, cache.disk_cache()->open_count());
+  EXPECT_EQ(1, cache.disk_cache()->create_count());
+}
+
+// Tests that a transaction can be deleted while it maps the response data.
+TEST(HttpCache, SimpleGET_DeleteWhileMappingData) {
+  MockHttpCache cache;
+
+  // Write to the cache.
+  RunTransactionTest(cache.http_cache(), kSimpleGET_Transaction);
+
+  MockTransaction transaction(kSimpleGET_Transaction);
+  transaction.load_flags |= net::LOAD_ONLY_FROM_CACHE;
+  MockHttpRequest request(transaction);
+  TestOldCompletionCallback callback;
+
+  scoped_ptr<net::HttpTransaction> trans;
+  int rv = cache.http_cache()->CreateTransaction(&trans);
+  EXPECT_EQ(net::OK, rv);
+  rv = trans->Start(&request, &callback, net::BoundNetLog());
+  EXPECT_EQ(net::OK, callback.GetResult(rv));
+
+  scoped_refptr<net::IOBuffer> buf(new net::IOBuffer(5));
+  rv = trans->Read(buf, 5, &callback);
+  EXPECT_EQ(net::ERR_IO_PENDING, rv);
+  trans.reset();
+
+  // The pending operation should complete without reaching the transaction.
+  MessageLoop::current()->RunAllPending();
+  EXPECT_FALSE(callback.have_result());
+}
+
 TEST(HttpCache, SimpleGET_LoadOnlyFromCache_Miss) {
   MockHttpCache cache;
 
@@ -1988,6 +2107,218 @@ TEST(HttpCache, SimpleGET_ManyWriters_DeleteCache) {
   }
 }
 
+// Returns a response body of |size| bytes that is easy to tell apart from a
+// shifted copy of itself.
+static std::string MakeSharedWritingBody(int size) {
+  std::string body;
+  body.reserve(size);
+  for (int i = 0; i < size; ++i)
+    body.push_back('a' + (i * 7 + i / 26) % 26);
+  return body;
+}
+
+// Returns the response headers of kSimpleGET_Transaction, with the length of a
+// body of |size| bytes. The cache shares only responses of a known length.
+static std::string MakeSharedWritingHeaders(int size) {
+  return base::StringPrintf("%sContent-Length: %d\n",
+                            kSimpleGET_Transaction.response_headers, size);
+}
+
+// Completion callback that records how much of the response body was stored
+// when it ran. The entry for |key| must open synchronously.
+class BodySizeCallback : public TestOldCompletionCallback {
+ public:
+  BodySizeCallback(MockDiskCache* disk_cache, const std::string& key)
+      : disk_cache_(disk_cache), key_(key), body_size_(-1) {}
+
+  int body_size() const { return body_size_; }
+
+  virtual void RunWithParams(const Tuple1<int>& params) {
+    disk_cache::Entry* entry;
+    TestOldCompletionCallback callback;
+    if (disk_cache_->OpenEntry(key_, &entry, &callback) == net::OK) {
+      body_size_ = entry->GetDataSize(1);
+      entry->Close();
+    }
+    TestOldCompletionCallback::RunWithParams(params);
+  }
+
+ private:
+  MockDiskCache* disk_cache_;
+  std::string key_;
+  int body_size_;
+};
+
+// Starts |num_transactions| requests for |request|, and starts reading the
+// response from the first one. That hands the download over to the cache,
+// and lets the others read the entry while it is being written.
+static void StartSharedWriting(MockHttpCache* cache,
+                               const MockHttpRequest& request,
+                               int num_transactions,
+                               std::vector<Context*>* context_list) {
+  for (int i = 0; i < num_transactions; ++i) {
+    context_list->push_back(new Context());
+    Context* c = context_list->back();
+
+    c->result = cache->http_cache()->CreateTransaction(&c->trans);
+    EXPECT_EQ(net::OK, c->result);
+
+    c->result = c->trans->Start(&request, &c->callback, net::BoundNetLog());
+  }
+
+  // The first request should be a writer at this point, and the subsequent
+  // requests should be pending.
+  MessageLoop::current()->RunAllPending();
+  EXPECT_EQ(1, cache->network_layer()->transaction_count());
+
+  Context* c = (*context_list)[0];
+  ASSERT_EQ(net::OK, c->callback.GetResult(c->result));
+  scoped_refptr<net::IOBuffer> buf(new net::IOBuffer(1024));
+  EXPECT_EQ(net::ERR_IO_PENDING, c->trans->Read(buf, 1024, &c->callback));
+}
+
+// Tests that requests waiting for the writer read the response while it is
+// still being downloaded, and that a single network transaction serves them.
+TEST(HttpCache, SimpleGET_SharedWriting) {
+  MockHttpCache cache;
+
+  const int kBodySize = 512 * 1024;
+  std::string body = MakeSharedWritingBody(kBodySize);
+  std::string headers = MakeSharedWritingHeaders(kBodySize);
+  ScopedMockTransaction transaction(kSimpleGET_Transaction);
+  transaction.response_headers = headers.c_str();
+  transaction.data = body.c_str();
+  transaction.test_mode = TEST_MODE_SYNC_CACHE_START;
+  MockHttpRequest request(transaction);
+
+  const int kNumTransactions = 3;
+  scoped_ptr<net::HttpTransaction> trans[kNumTransactions];
+  ScopedVector<BodySizeCallback> callbacks;
+  for (int i = 0; i < kNumTransactions; ++i) {
+    callbacks.push_back(
+        new BodySizeCallback(cache.disk_cache(), request.url.spec()));
+    EXPECT_EQ(net::OK, cache.http_cache()->CreateTransaction(&trans[i]));
+    int rv = trans[i]->Start(&request, callbacks[i], net::BoundNetLog());
+    if (i == 0)
+      EXPECT_EQ(net::OK, callbacks[i]->GetResult(rv));
+  }
+
+  // Reading from the writer lets everybody in before the whole response is
+  // stored.
+  scoped_refptr<net::IOBuffer> buf(new net::IOBuffer(1024));
+  int rv = trans[0]->Read(buf, 1024, callbacks[0]);
+  EXPECT_EQ(1024, callbacks[0]->GetResult(rv));
+  EXPECT_EQ(body.substr(0, 1024), std::string(buf->data(), 1024));
+  for (int i = 0; i < kNumTransactions; ++i) {
+    EXPECT_GE(callbacks[i]->body_size(), 0);
+    EXPECT_LT(callbacks[i]->body_size(), kBodySize);
+  }
+
+  for (int i = 0; i < kNumTransactions; ++i) {
+    std::string content;
+    EXPECT_EQ(net::OK, ReadTransaction(trans[i].get(), &content));
+    EXPECT_EQ(body.substr(i ? 0 : 1024), content);
+    trans[i].reset();
+  }
+
+  EXPECT_EQ(1, cache.network_layer()->transaction_count());
+  EXPECT_EQ(1, cache.disk_cache()->create_count());
+
+  // The stored response is complete.
+  RunTransactionTest(cache.http_cache(), transaction);
+  EXPECT_EQ(1, cache.network_layer()->transaction_count());
+}
+
+// Tests that deleting the transaction that started the download does not stop
+// it for the others.
+TEST(HttpCache, SimpleGET_SharedWriting_CancelFirst) {
+  MockHttpCache cache;
+
+  std::string body = MakeSharedWritingBody(256 * 1024);
+  std::string headers = MakeSharedWritingHeaders(256 * 1024);
+  ScopedMockTransaction transaction(kSimpleGET_Transaction);
+  transaction.response_headers = headers.c_str();
+  transaction.data = body.c_str();
+  MockHttpRequest request(transaction);
+
+  std::vector<Context*> context_list;
+  const int kNumTransactions = 3;
+  StartSharedWriting(&cache, request, kNumTransactions, &context_list);
+  delete context_list[0];
+
+  for (int i = 1; i < kNumTransactions; ++i) {
+    Context* c = context_list[i];
+    ASSERT_EQ(net::OK, c->callback.GetResult(c->result));
+    ReadAndVerifyTransaction(c->trans.get(), transaction);
+    delete c;
+  }
+
+  EXPECT_EQ(1, cache.network_layer()->transaction_count());
+  EXPECT_EQ(0, cache.disk_cache()->open_count());
+  EXPECT_EQ(1, cache.disk_cache()->create_count());
+}
+
+// Tests that the download stops when nobody reads it anymore, and that the
+// incomplete response is not stored.
+TEST(HttpCache, SimpleGET_SharedWriting_CancelAll) {
+  MockHttpCache cache;
+
+  std::string body = MakeSharedWritingBody(256 * 1024);
+  std::string headers = MakeSharedWritingHeaders(256 * 1024);
+  ScopedMockTransaction transaction(kSimpleGET_Transaction);
+  transaction.response_headers = headers.c_str();
+  transaction.data = body.c_str();
+  MockHttpRequest request(transaction);
+
+  std::vector<Context*> context_list;
+  const int kNumTransactions = 2;
+  StartSharedWriting(&cache, request, kNumTransactions, &context_list);
+  for (int i = 0; i < kNumTransactions; ++i)
+    delete context_list[i];
+  MessageLoop::current()->RunAllPending();
+
+  RunTransactionTest(cache.http_cache(), transaction);
+
+  EXPECT_EQ(2, cache.network_layer()->transaction_count());
+  EXPECT_EQ(0, cache.disk_cache()->open_count());
+  EXPECT_EQ(2, cache.disk_cache()->create_count());
+}
+
+// Tests that a response that is too large for the cache is not shared, so the
+// requests for it don't fail when the cache stops storing it.
+TEST(HttpCache, SimpleGET_SharedWriting_TooLarge) {
+  // The memory cache stores up to 128 KB per entry.
+  MockHttpCache cache(net::HttpCache::DefaultBackend::InMemory(1024 * 1024));
+
+  const int kBodySize = 512 * 1024;
+  std::string body = MakeSharedWritingBody(kBodySize);
+  std::string headers = MakeSharedWritingHeaders(kBodySize);
+  ScopedMockTransaction transaction(kSimpleGET_Transaction);
+  transaction.response_headers = headers.c_str();
+  transaction.data = body.c_str();
+  MockHttpRequest request(transaction);
+
+  std::vector<Context*> context_list;
+  const int kNumTransactions = 3;
+  for (int i = 0; i < kNumTransactions; ++i) {
+    context_list.push_back(new Context());
+    Context* c = context_list[i];
+    ASSERT_EQ(net::OK, cache.http_cache()->CreateTransaction(&c->trans));
+    c->result = c->trans->Start(&request, &c->callback, net::BoundNetLog());
+  }
+
+  // Each transaction reads the response from the network once the one before
+  // it fails to store it.
+  for (int i = 0; i < kNumTransactions; ++i) {
+    Context* c = context_list[i];
+    ASSERT_EQ(net::OK, c->callback.GetResult(c->result));
+    ReadAndVerifyTransaction(c->trans.get(), transaction);
+    delete c;
+  }
+
+  EXPECT_EQ(kNumTransactions, cache.network_layer()->transaction_count());
+}
+
 // Tests that we queue requests when initializing the backend.
 TEST(HttpCache, SimpleGET_WaitForBackend) {
   MockBlockingBackendFactory* factory = new MockBlockingBackendFactory();
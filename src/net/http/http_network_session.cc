@@ -30,6 +30,7 @@ HttpNetworkSession::HttpNetworkSession(const Params& params)
       http_auth_handler_factory_(params.http_auth_handler_factory),
       proxy_service_(params.proxy_service),
       ssl_config_service_(params.ssl_config_service),
+      ssl_session_cache_(params.ssl_session_store),
       socket_pool_manager_(params.net_log,
                            params.client_socket_factory ?
                                params.client_socket_factory :
@@ -40,6 +41,7 @@ HttpNetworkSession::HttpNetworkSession(const Params& params)
                            params.dnsrr_resolver,
                            params.dns_cert_checker,
                            params.ssl_host_info_factory,
+                           &ssl_session_cache_,
                            params.proxy_service,
                            params.ssl_config_service),
       spdy_session_pool_(params.host_resolver, params.ssl_config_service),
@@ -16,6 +16,7 @@
 #include "net/http/http_auth_cache.h"
 #include "net/http/http_stream_factory.h"
 #include "net/socket/client_socket_pool_manager.h"
+#include "net/socket/ssl_session_cache.h"
 #include "net/spdy/spdy_session_pool.h"
 #include "net/spdy/spdy_settings_storage.h"
 
@@ -56,6 +57,7 @@ class NET_EXPORT HttpNetworkSession
           dns_cert_checker(NULL),
           proxy_service(NULL),
           ssl_host_info_factory(NULL),
+          ssl_session_store(NULL),
           ssl_config_service(NULL),
           http_auth_handler_factory(NULL),
           network_delegate(NULL),
@@ -70,6 +72,8 @@ class NET_EXPORT HttpNetworkSession
     DnsCertProvenanceChecker* dns_cert_checker;
     ProxyService* proxy_service;
     SSLHostInfoFactory* ssl_host_info_factory;
+    // Where the TLS sessions are persisted, or NULL to keep them in memory.
+    SSLSessionCache::PersistentStore* ssl_session_store;
     SSLConfigService* ssl_config_service;
     HttpAuthHandlerFactory* http_auth_handler_factory;
     NetworkDelegate* network_delegate;
@@ -83,6 +87,7 @@ class NET_EXPORT HttpNetworkSession
   SSLClientAuthCache* ssl_client_auth_cache() {
     return &ssl_client_auth_cache_;
   }
+  SSLSessionCache* ssl_session_cache() { return &ssl_session_cache_; }
 
   void AddResponseDrainer(HttpResponseBodyDrainer* drainer);
 
@@ -154,6 +159,7 @@ class NET_EXPORT HttpNetworkSession
 
   HttpAuthCache http_auth_cache_;
   SSLClientAuthCache ssl_client_auth_cache_;
+  SSLSessionCache ssl_session_cache_;
   ClientSocketPoolManager socket_pool_manager_;
   SpdySessionPool spdy_session_pool_;
   scoped_ptr<HttpStreamFactory> http_stream_factory_;
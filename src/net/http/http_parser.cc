@@ -0,0 +1,338 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/http/http_parser.h"
+
+#include <string.h>
+
+#include <algorithm>
+
+#include "base/logging.h"
+#include "net/base/net_errors.h"
+#include "net/http/http_util.h"
+
+using base::StringPiece;
+
+namespace net {
+
+namespace {
+
+// Returns the value of the hex digit |c|, or -1.
+inline int HexDigitValue(char c) {
+  if (c >= '0' && c <= '9')
+    return c - '0';
+  if (c >= 'a' && c <= 'f')
+    return c - 'a' + 10;
+  if (c >= 'A' && c <= 'F')
+    return c - 'A' + 10;
+  return -1;
+}
+
+inline bool IsLineTerminator(char c) {
+  return c == '\r' || c == '\n';
+}
+
+// Returns the first line terminator in [|begin|, |end|), or |end|.
+inline const char* FindLineTerminator(const char* begin, const char* end) {
+  const char* lf = static_cast<const char*>(memchr(begin, '\n', end - begin));
+  if (!lf)
+    lf = end;
+  const char* cr = static_cast<const char*>(memchr(begin, '\r', lf - begin));
+  return cr ? cr : lf;
+}
+
+// Splits a header line into its name and value. Only lines with a non-empty
+// name that doesn't start with LWS are headers (and can be continued).
+void SplitHeaderLine(const StringPiece& line, StringPiece* name,
+                     StringPiece* value) {
+  const char* colon_ptr =
+      static_cast<const char*>(memchr(line.data(), ':', line.size()));
+  if (!colon_ptr || colon_ptr == line.data() || HttpUtil::IsLWS(line[0]))
+    return;
+  size_t colon = colon_ptr - line.data();
+
+  size_t name_end = colon;
+  while (HttpUtil::IsLWS(line[name_end - 1]))
+    --name_end;
+  *name = StringPiece(line.data(), name_end);
+
+  size_t value_begin = colon + 1;
+  size_t value_end = line.size();
+  while (value_begin < value_end && HttpUtil::IsLWS(line[value_begin]))
+    ++value_begin;
+  while (value_end > value_begin && HttpUtil::IsLWS(line[value_end - 1]))
+    --value_end;
+  *value = StringPiece(line.data() + value_begin, value_end - value_begin);
+}
+
+}  // namespace
+
+HttpParser::HttpParser(Visitor* visitor) : visitor_(visitor) {
+  Reset();
+}
+
+HttpParser::~HttpParser() {
+}
+
+void HttpParser::Reset() {
+  headers_scanned_ = 0;
+  headers_was_lf_ = false;
+  headers_last_char_ = '\0';
+  chunk_state_ = CHUNK_SIZE;
+  chunk_remaining_ = 0;
+  chunk_size_found_ = false;
+  in_trailer_ = false;
+  bytes_after_body_ = 0;
+}
+
+int HttpParser::FindEndOfHeaders(const char* buf, int buf_len, int i) {
+  bool was_lf = headers_was_lf_;
+  char last_c = headers_last_char_;
+  for (i = std::max(i, headers_scanned_); i < buf_len; ++i) {
+    // Nothing but a LF can start the end of the headers.
+    if (!was_lf) {
+      const void* lf = memchr(buf + i, '\n', buf_len - i);
+      if (!lf) {
+        i = buf_len;
+        break;
+      }
+      i = static_cast<const char*>(lf) - buf;
+    }
+
+    char c = buf[i];
+    if (c == '\n') {
+      if (was_lf)
+        return i + 1;
+      was_lf = true;
+    } else if (c != '\r' || last_c != '\n') {
+      was_lf = false;
+    }
+    last_c = c;
+  }
+
+  headers_scanned_ = i;
+  headers_was_lf_ = was_lf;
+  headers_last_char_ = last_c;
+  return -1;
+}
+
+void HttpParser::ParseHeaders(const char* buf, int buf_len) {
+  if (!visitor_)
+    return;
+
+  const char* end = buf + buf_len;
+  int status_line_begin = HttpUtil::LocateStartOfStatusLine(buf, buf_len);
+  if (status_line_begin != -1)
+    buf += status_line_begin;
+
+  const char* cur = FindLineTerminator(buf, end);
+  visitor_->OnStartLine(StringPiece(buf, cur - buf));
+
+  // Every other line is a header line, or the continuation of the value of
+  // the previous header if it starts with LWS. Empty lines are skipped.
+  bool prev_line_continuable = false;
+  while (true) {
+    while (cur != end && IsLineTerminator(*cur))
+      ++cur;
+    if (cur == end)
+      break;
+
+    const char* line_begin = cur;
+    cur = FindLineTerminator(cur, end);
+    StringPiece line(line_begin, cur - line_begin);
+
+    if (prev_line_continuable && HttpUtil::IsLWS(line[0])) {
+      size_t value_begin = 1;
+      while (value_begin < line.size() && HttpUtil::IsLWS(line[value_begin]))
+        ++value_begin;
+      visitor_->OnHeaderContinuation(line.substr(value_begin));
+      continue;
+    }
+
+    StringPiece name;
+    StringPiece value;
+    SplitHeaderLine(line, &name, &value);
+    prev_line_continuable = !name.empty();
+    visitor_->OnHeaderLine(line, name, value);
+  }
+}
+
+int HttpParser::ParseChunkedBody(const char* buf, int buf_len) {
+  int data_len;
+  return DecodeChunkedBody(buf, buf_len, NULL, &data_len);
+}
+
+int HttpParser::FilterChunkedBody(char* buf, int buf_len) {
+  if (chunk_state_ == CHUNK_DONE) {
+    bytes_after_body_ += buf_len;
+    return 0;
+  }
+
+  int data_len;
+  int rv = DecodeChunkedBody(buf, buf_len, buf, &data_len);
+  if (rv < 0)
+    return rv;
+  if (rv < buf_len) {
+    memmove(buf + data_len, buf + rv, buf_len - rv);
+    bytes_after_body_ += buf_len - rv;
+  }
+  return data_len;
+}
+
+void HttpParser::SkipChunkData(int len) {
+  DCHECK_LE(len, chunk_data_remaining());
+  chunk_remaining_ -= len;
+  if (chunk_state_ == CHUNK_DATA && !chunk_remaining_)
+    chunk_state_ = CHUNK_DATA_TERMINATOR;
+}
+
+// The chunk-size is parsed as strictly as possible, while not breaking known
+// sites. Some sites pad it with trailing spaces (for example "819b   "), but
+// leading spaces, tabs, a "0x" prefix or a sign are not accepted: ^\X+[ ]*$,
+// where \X is a hex digit. Chunks larger than 2GB are not supported.
+int HttpParser::DecodeChunkedBody(const char* buf, int buf_len, char* out,
+                                  int* data_len) {
+  *data_len = 0;
+  if (chunk_state_ == CHUNK_INVALID)
+    return ERR_INVALID_CHUNKED_ENCODING;
+
+  const char* cur = buf;
+  const char* end = buf + buf_len;
+  const char* trailer_begin = in_trailer_ ? buf : NULL;
+  while (cur < end && chunk_state_ != CHUNK_DONE &&
+         chunk_state_ != CHUNK_INVALID) {
+    switch (chunk_state_) {
+      case CHUNK_SIZE:
+      case CHUNK_SIZE_SPACES:
+      case CHUNK_SIZE_CR: {
+        char c = *cur++;
+        int digit = HexDigitValue(c);
+        // The length is reported as soon as the chunk-size ends.
+        if (chunk_state_ == CHUNK_SIZE && digit < 0 && chunk_size_found_ &&
+            visitor_) {
+          visitor_->OnChunkLength(chunk_remaining_);
+        }
+        if (chunk_state_ == CHUNK_SIZE && digit >= 0) {
+          if (chunk_remaining_ > (kint32max - digit) / 16) {
+            chunk_state_ = CHUNK_INVALID;  // Too big.
+            break;
+          }
+          chunk_remaining_ = chunk_remaining_ * 16 + digit;
+          chunk_size_found_ = true;
+        } else if (c == '\n') {
+          if (!chunk_size_found_) {
+            chunk_state_ = CHUNK_INVALID;  // Missing chunk-size.
+            break;
+          }
+          chunk_size_found_ = false;
+          chunk_state_ =
+              chunk_remaining_ ? CHUNK_DATA : CHUNK_TRAILER_LINE_START;
+        } else if (chunk_state_ == CHUNK_SIZE_CR) {
+          chunk_state_ = CHUNK_INVALID;
+        } else if (c == '\r') {
+          chunk_state_ = CHUNK_SIZE_CR;
+        } else if (c == ' ' && chunk_size_found_) {
+          chunk_state_ = CHUNK_SIZE_SPACES;
+        } else if (c == ';' && chunk_size_found_) {
+          chunk_state_ = CHUNK_EXTENSIONS;
+        } else {
+          chunk_state_ = CHUNK_INVALID;
+        }
+        break;
+      }
+
+      case CHUNK_EXTENSIONS: {
+        // The extensions are ignored, up to the end of the line.
+        const char* lf = static_cast<const char*>(memchr(cur, '\n', end - cur));
+        const char* extensions_end = lf ? lf : end;
+        if (lf && extensions_end > cur && extensions_end[-1] == '\r')
+          --extensions_end;
+        if (visitor_ && extensions_end > cur)
+          visitor_->OnChunkExtensions(StringPiece(cur, extensions_end - cur));
+        if (!lf) {
+          cur = end;
+          break;
+        }
+        cur = lf;
+        chunk_state_ = CHUNK_SIZE_CR;
+        break;
+      }
+
+      case CHUNK_DATA: {
+        int len = std::min(chunk_remaining_, static_cast<int>(end - cur));
+        if (out) {
+          memmove(out + *data_len, cur, len);
+        } else if (visitor_) {
+          visitor_->OnBodyData(StringPiece(cur, len));
+        }
+        *data_len += len;
+        cur += len;
+        chunk_remaining_ -= len;
+        if (!chunk_remaining_)
+          chunk_state_ = CHUNK_DATA_TERMINATOR;
+        break;
+      }
+
+      case CHUNK_DATA_TERMINATOR:
+      case CHUNK_DATA_TERMINATOR_CR: {
+        // The data must be followed by an empty line.
+        char c = *cur++;
+        if (c == '\n') {
+          chunk_state_ = CHUNK_SIZE;
+        } else if (c == '\r' && chunk_state_ == CHUNK_DATA_TERMINATOR) {
+          chunk_state_ = CHUNK_DATA_TERMINATOR_CR;
+        } else {
+          chunk_state_ = CHUNK_INVALID;
+        }
+        break;
+      }
+
+      case CHUNK_TRAILER_LINE_START:
+      case CHUNK_TRAILER_LINE_START_CR: {
+        // An empty line ends the body; anything else is a trailer line.
+        char c = *cur;
+        if (c == '\n') {
+          chunk_state_ = CHUNK_DONE;
+          ++cur;
+        } else if (c == '\r' && chunk_state_ == CHUNK_TRAILER_LINE_START) {
+          chunk_state_ = CHUNK_TRAILER_LINE_START_CR;
+          ++cur;
+        } else {
+          if (!trailer_begin) {
+            trailer_begin =
+                (chunk_state_ == CHUNK_TRAILER_LINE_START_CR && cur > buf) ?
+                cur - 1 : cur;
+          }
+          in_trailer_ = true;
+          chunk_state_ = CHUNK_TRAILER;
+        }
+        break;
+      }
+
+      case CHUNK_TRAILER: {
+        const char* lf = static_cast<const char*>(memchr(cur, '\n', end - cur));
+        if (!lf) {
+          cur = end;
+          break;
+        }
+        cur = lf + 1;
+        chunk_state_ = CHUNK_TRAILER_LINE_START;
+        break;
+      }
+
+      default:
+        NOTREACHED();
+        chunk_state_ = CHUNK_INVALID;
+        break;
+    }
+  }
+
+  if (chunk_state_ == CHUNK_INVALID)
+    return ERR_INVALID_CHUNKED_ENCODING;
+  if (trailer_begin && visitor_)
+    visitor_->OnTrailer(StringPiece(trailer_begin, cur - trailer_begin));
+  return cur - buf;
+}
+
+}  // namespace net
@@ -0,0 +1,177 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef NET_HTTP_HTTP_PARSER_H_
+#define NET_HTTP_HTTP_PARSER_H_
+#pragma once
+
+#include "base/basictypes.h"
+#include "base/string_piece.h"
+#include "net/base/net_export.h"
+
+namespace net {
+
+// HttpParser is an incremental HTTP/1.x message parser that works on the
+// buffers the message is read into. It doesn't copy the message or allocate
+// memory: the parts of the message are reported to a Visitor as pieces of
+// those buffers. It is used by HttpStreamParser and HttpUtil, and the BalsaFrame
+// of the flip server uses it to decode chunked bodies.
+//
+// The headers of a message have to be kept in a single buffer, which grows as
+// more data is read. FindEndOfHeaders() only scans the bytes that it hasn't
+// seen before, and once the end is found, ParseHeaders() reports the start
+// line and the header lines.
+//
+// A chunked body can be decoded in pieces of any size, either by reporting the
+// data of every chunk with ParseChunkedBody(), or in place with
+// FilterChunkedBody(). From RFC 2616 section 3.6.1, the chunked transfer
+// coding is defined as:
+//
+//   Chunked-Body    = *chunk
+//                     last-chunk
+//                     trailer
+//                     CRLF
+//   chunk           = chunk-size [ chunk-extension ] CRLF
+//                     chunk-data CRLF
+//   chunk-size      = 1*HEX
+//   last-chunk      = 1*("0") [ chunk-extension ] CRLF
+//
+//   chunk-extension = *( ";" chunk-ext-name [ "=" chunk-ext-val ] )
+//   chunk-ext-name  = token
+//   chunk-ext-val   = token | quoted-string
+//   chunk-data      = chunk-size(OCTET)
+//   trailer         = *(entity-header CRLF)
+//
+// Lines may also end with a bare LF. The trailer is reported but not parsed,
+// since it is not used on the web.
+class NET_EXPORT_PRIVATE HttpParser {
+ public:
+  class NET_EXPORT_PRIVATE Visitor {
+   public:
+    // Called with the first line of the message (the status line of a
+    // response), without the line terminator.
+    virtual void OnStartLine(const base::StringPiece& line) {}
+
+    // Called for every header line, without the line terminator. If the line
+    // is a header, |name| is its name and |value| its value, without leading
+    // or trailing LWS. Otherwise both are empty.
+    virtual void OnHeaderLine(const base::StringPiece& line,
+                              const base::StringPiece& name,
+                              const base::StringPiece& value) {}
+
+    // Called for a line that continues the value of the previous header (it
+    // starts with LWS), with the leading LWS removed.
+    virtual void OnHeaderContinuation(const base::StringPiece& value) {}
+
+    // Called when the size of a chunk has been read, before its extensions.
+    virtual void OnChunkLength(int length) {}
+
+    // Called with (a part of) the extensions of a chunk, after the ';'.
+    virtual void OnChunkExtensions(const base::StringPiece& extensions) {}
+
+    // Called with (a part of) the data of a chunk, by ParseChunkedBody().
+    virtual void OnBodyData(const base::StringPiece& data) {}
+
+    // Called with (a part of) the trailer, including the final empty line.
+    virtual void OnTrailer(const base::StringPiece& trailer) {}
+
+   protected:
+    virtual ~Visitor() {}
+  };
+
+  // |visitor| may be NULL if no callbacks are needed.
+  explicit HttpParser(Visitor* visitor);
+  ~HttpParser();
+
+  // Resets the parser for a new message.
+  void Reset();
+
+  // Looks for the end of the headers (an empty line) in |buf|, starting at
+  // offset |i|. Every call must pass the same buffer contents as the previous
+  // one, followed by any data received since then: only the new bytes are
+  // scanned. Returns the offset just past the end of the headers, or -1 if it
+  // hasn't been found yet. For compatibility with servers that only send LFs,
+  // LF[CR]LF is accepted as the end of the headers.
+  int FindEndOfHeaders(const char* buf, int buf_len, int i);
+
+  // Reports the start line and the header lines in |buf| to the visitor.
+  // |buf_len| is usually the value returned by FindEndOfHeaders(), but the
+  // headers don't have to be complete. Up to 4 bytes of junk before the
+  // status line are skipped (like HttpUtil::LocateStartOfStatusLine()), and
+  // the line terminators are [CR]LF, a bare CR or any combination of them.
+  void ParseHeaders(const char* buf, int buf_len);
+
+  // Decodes |buf_len| bytes of a chunked body, reporting the data of every
+  // chunk to the visitor. Returns the number of bytes consumed, which is less
+  // than |buf_len| when the body ends before the end of |buf|, or
+  // ERR_INVALID_CHUNKED_ENCODING.
+  int ParseChunkedBody(const char* buf, int buf_len);
+
+  // Decodes |buf_len| bytes of a chunked body in place: the data of every
+  // chunk is moved to the start of |buf|. Returns the number of bytes of data,
+  // or ERR_INVALID_CHUNKED_ENCODING. Any bytes after the end of the body are
+  // moved right after the data, see bytes_after_body().
+  int FilterChunkedBody(char* buf, int buf_len);
+
+  // Returns true once the whole chunked body has been decoded.
+  bool IsChunkedBodyComplete() const { return chunk_state_ == CHUNK_DONE; }
+
+  // Returns the number of bytes passed to FilterChunkedBody() after the end of
+  // the body: either extraneous data or the start of the next response.
+  int bytes_after_body() const { return bytes_after_body_; }
+
+  // Returns the number of bytes of data left in the current chunk, which can
+  // be consumed without decoding them (see SkipChunkData()).
+  int chunk_data_remaining() const {
+    return chunk_state_ == CHUNK_DATA ? chunk_remaining_ : 0;
+  }
+
+  // Consumes |len| bytes of data of the current chunk, which must not be more
+  // than chunk_data_remaining().
+  void SkipChunkData(int len);
+
+ private:
+  enum ChunkState {
+    CHUNK_SIZE,
+    CHUNK_SIZE_SPACES,
+    CHUNK_SIZE_CR,
+    CHUNK_EXTENSIONS,
+    CHUNK_DATA,
+    CHUNK_DATA_TERMINATOR,
+    CHUNK_DATA_TERMINATOR_CR,
+    CHUNK_TRAILER_LINE_START,
+    CHUNK_TRAILER_LINE_START_CR,
+    CHUNK_TRAILER,
+    CHUNK_DONE,
+    CHUNK_INVALID,
+  };
+
+  // Decodes a chunked body. The data is moved to |out| if it is not NULL, or
+  // reported to the visitor otherwise. Returns the number of bytes consumed
+  // and stores the number of bytes of data in |data_len|, or returns
+  // ERR_INVALID_CHUNKED_ENCODING.
+  int DecodeChunkedBody(const char* buf, int buf_len, char* out,
+                        int* data_len);
+
+  Visitor* visitor_;
+
+  // State of FindEndOfHeaders(): the offset of the next byte to scan, and
+  // whether the last line seen was empty so far.
+  int headers_scanned_;
+  bool headers_was_lf_;
+  char headers_last_char_;
+
+  ChunkState chunk_state_;
+  // The size of the chunk being read, then the bytes left in its data.
+  int chunk_remaining_;
+  bool chunk_size_found_;
+  bool in_trailer_;
+  int bytes_after_body_;
+
+  DISALLOW_COPY_AND_ASSIGN(HttpParser);
+};
+
+}  // namespace net
+
+#endif  // NET_HTTP_HTTP_PARSER_H_
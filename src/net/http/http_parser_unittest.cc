@@ -0,0 +1,500 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <string.h>
+
+#include <algorithm>
+#include <string>
+
+#include "base/basictypes.h"
+#include "base/string_piece.h"
+#include "base/stringprintf.h"
+#include "net/base/net_errors.h"
+#include "net/http/http_parser.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+using base::StringPiece;
+using base::StringPrintf;
+
+namespace {
+
+void RunTest(const char* inputs[], size_t num_inputs,
+             const char* expected_output,
+             bool expected_eof,
+             int bytes_after_eof) {
+  net::HttpParser parser(NULL);
+  EXPECT_FALSE(parser.IsChunkedBodyComplete());
+
+  std::string result;
+
+  for (size_t i = 0; i < num_inputs; ++i) {
+    std::string input = inputs[i];
+    int n = parser.FilterChunkedBody(&input[0], static_cast<int>(input.size()));
+    EXPECT_GE(n, 0);
+    if (n > 0)
+      result.append(input.data(), n);
+  }
+
+  EXPECT_EQ(expected_output, result);
+  EXPECT_EQ(expected_eof, parser.IsChunkedBodyComplete());
+  EXPECT_EQ(bytes_after_eof, parser.bytes_after_body());
+}
+
+// Feed the inputs to the parser, until it returns an error.
+void RunTestUntilFailure(const char* inputs[],
+                         size_t num_inputs,
+                         size_t fail_index) {
+  net::HttpParser parser(NULL);
+  EXPECT_FALSE(parser.IsChunkedBodyComplete());
+
+  for (size_t i = 0; i < num_inputs; ++i) {
+    std::string input = inputs[i];
+    int n = parser.FilterChunkedBody(&input[0], static_cast<int>(input.size()));
+    if (n < 0) {
+      EXPECT_EQ(net::ERR_INVALID_CHUNKED_ENCODING, n);
+      EXPECT_EQ(fail_index, i);
+      return;
+    }
+  }
+  FAIL(); // We should have failed on the i'th iteration of the loop.
+}
+
+// Records the callbacks of HttpParser as a string.
+class RecordingVisitor : public net::HttpParser::Visitor {
+ public:
+  virtual void OnStartLine(const StringPiece& line) {
+    Append("start", line);
+  }
+  virtual void OnHeaderLine(const StringPiece& line, const StringPiece& name,
+                            const StringPiece& value) {
+    if (name.empty()) {
+      Append("line", line);
+    } else {
+      Append("header", name);
+      Append("value", value);
+    }
+  }
+  virtual void OnHeaderContinuation(const StringPiece& value) {
+    Append("continuation", value);
+  }
+  virtual void OnChunkLength(int length) {
+    events_.append(StringPrintf("[length:%d]", length));
+  }
+  virtual void OnChunkExtensions(const StringPiece& extensions) {
+    Append("extensions", extensions);
+  }
+  virtual void OnBodyData(const StringPiece& data) {
+    body_.append(data.data(), data.size());
+  }
+  virtual void OnTrailer(const StringPiece& trailer) {
+    trailer_.append(trailer.data(), trailer.size());
+  }
+
+  const std::string& events() const { return events_; }
+  const std::string& body() const { return body_; }
+  const std::string& trailer() const { return trailer_; }
+
+ private:
+  void Append(const char* event, const StringPiece& data) {
+    events_.append(StringPrintf("[%s:%s]", event, data.as_string().c_str()));
+  }
+
+  std::string events_;
+  std::string body_;
+  std::string trailer_;
+};
+
+}  // namespace
+
+TEST(HttpParserTest, ChunkedBasic) {
+  const char* inputs[] = {
+    "5\r\nhello\r\n0\r\n\r\n"
+  };
+  RunTest(inputs, arraysize(inputs), "hello", true, 0);
+}
+
+TEST(HttpParserTest, ChunkedOneChunk) {
+  const char* inputs[] = {
+    "5\r\nhello\r\n"
+  };
+  RunTest(inputs, arraysize(inputs), "hello", false, 0);
+}
+
+TEST(HttpParserTest, ChunkedTypical) {
+  const char* inputs[] = {
+    "5\r\nhello\r\n",
+    "1\r\n \r\n",
+    "5\r\nworld\r\n",
+    "0\r\n\r\n"
+  };
+  RunTest(inputs, arraysize(inputs), "hello world", true, 0);
+}
+
+TEST(HttpParserTest, ChunkedIncremental) {
+  const char* inputs[] = {
+    "5",
+    "\r",
+    "\n",
+    "hello",
+    "\r",
+    "\n",
+    "0",
+    "\r",
+    "\n",
+    "\r",
+    "\n"
+  };
+  RunTest(inputs, arraysize(inputs), "hello", true, 0);
+}
+
+TEST(HttpParserTest, ChunkedLF_InsteadOf_CRLF) {
+  // Compatibility: [RFC 2616 - Invalid]
+  // {Firefox3} - Valid
+  // {IE7, Safari3.1, Opera9.51} - Invalid
+  const char* inputs[] = {
+    "5\nhello\n",
+    "1\n \n",
+    "5\nworld\n",
+    "0\n\n"
+  };
+  RunTest(inputs, arraysize(inputs), "hello world", true, 0);
+}
+
+TEST(HttpParserTest, ChunkedExtensions) {
+  const char* inputs[] = {
+    "5;x=0\r\nhello\r\n",
+    "0;y=\"2 \"\r\n\r\n"
+  };
+  RunTest(inputs, arraysize(inputs), "hello", true, 0);
+}
+
+TEST(HttpParserTest, ChunkedTrailers) {
+  const char* inputs[] = {
+    "5\r\nhello\r\n",
+    "0\r\n",
+    "Foo: 1\r\n",
+    "Bar: 2\r\n",
+    "\r\n"
+  };
+  RunTest(inputs, arraysize(inputs), "hello", true, 0);
+}
+
+TEST(HttpParserTest, ChunkedTrailersUnfinished) {
+  const char* inputs[] = {
+    "5\r\nhello\r\n",
+    "0\r\n",
+    "Foo: 1\r\n"
+  };
+  RunTest(inputs, arraysize(inputs), "hello", false, 0);
+}
+
+TEST(HttpParserTest, ChunkedInvalidChunkSize_TooBig) {
+  const char* inputs[] = {
+    // This chunked body is not terminated.
+    // However we will fail decoding because the chunk-size
+    // number is larger than we can handle.
+    "48469410265455838241\r\nhello\r\n",
+    "0\r\n\r\n"
+  };
+  RunTestUntilFailure(inputs, arraysize(inputs), 0);
+}
+
+TEST(HttpParserTest, ChunkedInvalidChunkSize_0X) {
+  const char* inputs[] = {
+    // Compatibility [RFC 2616 - Invalid]:
+    // {Safari3.1, IE7} - Invalid
+    // {Firefox3, Opera 9.51} - Valid
+    "0x5\r\nhello\r\n",
+    "0\r\n\r\n"
+  };
+  RunTestUntilFailure(inputs, arraysize(inputs), 0);
+}
+
+TEST(HttpParserTest, ChunkedChunkSize_TrailingSpace) {
+  const char* inputs[] = {
+    // Compatibility [RFC 2616 - Invalid]:
+    // {IE7, Safari3.1, Firefox3, Opera 9.51} - Valid
+    //
+    // At least yahoo.com depends on this being valid.
+    "5      \r\nhello\r\n",
+    "0\r\n\r\n"
+  };
+  RunTest(inputs, arraysize(inputs), "hello", true, 0);
+}
+
+TEST(HttpParserTest, ChunkedInvalidChunkSize_TrailingTab) {
+  const char* inputs[] = {
+    // Compatibility [RFC 2616 - Invalid]:
+    // {IE7, Safari3.1, Firefox3, Opera 9.51} - Valid
+    "5\t\r\nhello\r\n",
+    "0\r\n\r\n"
+  };
+  RunTestUntilFailure(inputs, arraysize(inputs), 0);
+}
+
+TEST(HttpParserTest, ChunkedInvalidChunkSize_TrailingFormFeed) {
+  const char* inputs[] = {
+    // Compatibility [RFC 2616- Invalid]:
+    // {Safari3.1} - Invalid
+    // {IE7, Firefox3, Opera 9.51} - Valid
+    "5\f\r\nhello\r\n",
+    "0\r\n\r\n"
+  };
+  RunTestUntilFailure(inputs, arraysize(inputs), 0);
+}
+
+TEST(HttpParserTest, ChunkedInvalidChunkSize_TrailingVerticalTab) {
+  const char* inputs[] = {
+    // Compatibility [RFC 2616 - Invalid]:
+    // {Safari 3.1} - Invalid
+    // {IE7, Firefox3, Opera 9.51} - Valid
+    "5\v\r\nhello\r\n",
+    "0\r\n\r\n"
+  };
+  RunTestUntilFailure(inputs, arraysize(inputs), 0);
+}
+
+TEST(HttpParserTest, ChunkedInvalidChunkSize_TrailingNonHexDigit) {
+  const char* inputs[] = {
+    // Compatibility [RFC 2616 - Invalid]:
+    // {Safari 3.1} - Invalid
+    // {IE7, Firefox3, Opera 9.51} - Valid
+    "5H\r\nhello\r\n",
+    "0\r\n\r\n"
+  };
+  RunTestUntilFailure(inputs, arraysize(inputs), 0);
+}
+
+TEST(HttpParserTest, ChunkedInvalidChunkSize_LeadingSpace) {
+  const char* inputs[] = {
+    // Compatibility [RFC 2616 - Invalid]:
+    // {IE7} - Invalid
+    // {Safari 3.1, Firefox3, Opera 9.51} - Valid
+    " 5\r\nhello\r\n",
+    "0\r\n\r\n"
+  };
+  RunTestUntilFailure(inputs, arraysize(inputs), 0);
+}
+
+TEST(HttpParserTest, ChunkedInvalidLeadingSeparator) {
+  const char* inputs[] = {
+    "\r\n5\r\nhello\r\n",
+    "0\r\n\r\n"
+  };
+  RunTestUntilFailure(inputs, arraysize(inputs), 0);
+}
+
+TEST(HttpParserTest, ChunkedInvalidChunkSize_NoSeparator) {
+  const char* inputs[] = {
+    "5\r\nhello",
+    "1\r\n \r\n",
+    "0\r\n\r\n"
+  };
+  RunTestUntilFailure(inputs, arraysize(inputs), 1);
+}
+
+TEST(HttpParserTest, ChunkedInvalidChunkSize_Negative) {
+  const char* inputs[] = {
+    "8\r\n12345678\r\n-5\r\nhello\r\n",
+    "0\r\n\r\n"
+  };
+  RunTestUntilFailure(inputs, arraysize(inputs), 0);
+}
+
+TEST(HttpParserTest, ChunkedInvalidChunkSize_Plus) {
+  const char* inputs[] = {
+    // Compatibility [RFC 2616 - Invalid]:
+    // {IE7, Safari 3.1} - Invalid
+    // {Firefox3, Opera 9.51} - Valid
+    "+5\r\nhello\r\n",
+    "0\r\n\r\n"
+  };
+  RunTestUntilFailure(inputs, arraysize(inputs), 0);
+}
+
+TEST(HttpParserTest, ChunkedInvalidConsecutiveCRLFs) {
+  const char* inputs[] = {
+    "5\r\nhello\r\n",
+    "\r\n\r\n\r\n\r\n",
+    "0\r\n\r\n"
+  };
+  RunTestUntilFailure(inputs, arraysize(inputs), 1);
+}
+
+TEST(HttpParserTest, ChunkedExcessiveChunkLen) {
+  const char* inputs[] = {
+    "c0000000\r\nhello\r\n"
+  };
+  RunTestUntilFailure(inputs, arraysize(inputs), 0);
+}
+
+TEST(HttpParserTest, ChunkedBasicExtraData) {
+  const char* inputs[] = {
+    "5\r\nhello\r\n0\r\n\r\nextra bytes"
+  };
+  RunTest(inputs, arraysize(inputs), "hello", true, 11);
+}
+
+TEST(HttpParserTest, ChunkedIncrementalExtraData) {
+  const char* inputs[] = {
+    "5",
+    "\r",
+    "\n",
+    "hello",
+    "\r",
+    "\n",
+    "0",
+    "\r",
+    "\n",
+    "\r",
+    "\nextra bytes"
+  };
+  RunTest(inputs, arraysize(inputs), "hello", true, 11);
+}
+
+TEST(HttpParserTest, ChunkedMultipleExtraDataBlocks) {
+  const char* inputs[] = {
+    "5\r\nhello\r\n0\r\n\r\nextra",
+    " bytes"
+  };
+  RunTest(inputs, arraysize(inputs), "hello", true, 11);
+}
+
+TEST(HttpParserTest, FindEndOfHeaders) {
+  struct {
+    const char* input;
+    int expected_result;
+  } tests[] = {
+    { "foo\r\nbar\r\n\r\n", 12 },
+    { "foo\nbar\n\n", 9 },
+    { "foo\r\nbar\r\n\r\njunk", 12 },
+    { "foo\nbar\n\njunk", 9 },
+    { "foo\nbar\n\r\njunk", 10 },
+    { "foo\nbar\r\n\njunk", 10 },
+    { "foo\r\nbar\r\n", -1 },
+    { "foo\r\nbar\r\r\n", -1 },
+  };
+  for (size_t i = 0; i < arraysize(tests); ++i) {
+    int input_len = static_cast<int>(strlen(tests[i].input));
+    net::HttpParser parser(NULL);
+    EXPECT_EQ(tests[i].expected_result,
+              parser.FindEndOfHeaders(tests[i].input, input_len, 0));
+
+    // Feeding the input one byte at a time gives the same result.
+    net::HttpParser incremental_parser(NULL);
+    int result = -1;
+    for (int len = 1; len <= input_len && result == -1; ++len)
+      result = incremental_parser.FindEndOfHeaders(tests[i].input, len, 0);
+    EXPECT_EQ(tests[i].expected_result, result);
+  }
+}
+
+TEST(HttpParserTest, FindEndOfHeadersAfterReset) {
+  const char kInput[] = "HTTP/1.1 100 Continue\r\n\r\nHTTP/1.1 200 OK\r\n\r\n";
+  net::HttpParser parser(NULL);
+  int end = parser.FindEndOfHeaders(kInput, arraysize(kInput) - 1, 0);
+  EXPECT_EQ(25, end);
+
+  parser.Reset();
+  EXPECT_EQ(19, parser.FindEndOfHeaders(kInput + end,
+                                        arraysize(kInput) - 1 - end, 0));
+}
+
+TEST(HttpParserTest, ParseHeaders) {
+  const char kInput[] =
+      "junkHTTP/1.1 200 OK\r\n"
+      "Content-Type: text/html \r\n"
+      "Foo :bar\r\n"
+      " baz \r\n"
+      "\t qux\r\n"
+      "\r\n\r\n"
+      "not a header\n"
+      " not a continuation\r"
+      ":empty\r\n\r\n";
+  RecordingVisitor visitor;
+  net::HttpParser parser(&visitor);
+  parser.ParseHeaders(kInput, arraysize(kInput) - 1);
+  EXPECT_EQ("[start:HTTP/1.1 200 OK]"
+            "[header:Content-Type][value:text/html]"
+            "[header:Foo][value:bar]"
+            "[continuation:baz ]"
+            "[continuation:qux]"
+            "[line:not a header]"
+            "[line: not a continuation]"
+            "[line::empty]",
+            visitor.events());
+}
+
+TEST(HttpParserTest, ParseHeadersNoStatusLine) {
+  const char kInput[] = "Foo: bar\r\n\r\n";
+  RecordingVisitor visitor;
+  net::HttpParser parser(&visitor);
+  parser.ParseHeaders(kInput, arraysize(kInput) - 1);
+  EXPECT_EQ("[start:Foo: bar]", visitor.events());
+}
+
+TEST(HttpParserTest, ParseChunkedBody) {
+  const char kInput[] =
+      "5;name=value\r\nhello\r\n"
+      "6\r\n world\r\n"
+      "0;last\r\n"
+      "Foo: 1\r\n"
+      "Bar: 2\r\n"
+      "\r\n"
+      "HTTP/1.1";
+  const int kInputLen = arraysize(kInput) - 1;
+  const int kBodyLen = kInputLen - strlen("HTTP/1.1");
+
+  // The result must not depend on how the body is split.
+  for (int step = 1; step <= kInputLen; ++step) {
+    RecordingVisitor visitor;
+    net::HttpParser parser(&visitor);
+    int consumed = 0;
+    for (int i = 0; i < kInputLen && !parser.IsChunkedBodyComplete();
+         i += step) {
+      int rv = parser.ParseChunkedBody(kInput + i,
+                                       std::min(step, kInputLen - i));
+      ASSERT_GE(rv, 0);
+      consumed += rv;
+    }
+    EXPECT_TRUE(parser.IsChunkedBodyComplete());
+    EXPECT_EQ(kBodyLen, consumed);
+    EXPECT_EQ("hello world", visitor.body());
+    EXPECT_EQ("Foo: 1\r\nBar: 2\r\n\r\n", visitor.trailer());
+    if (step == kInputLen) {
+      EXPECT_EQ("[length:5][extensions:name=value][length:6][length:0]"
+                "[extensions:last]", visitor.events());
+    }
+  }
+}
+
+TEST(HttpParserTest, SkipChunkData) {
+  const char kInput[] = "5\r\nhello\r\n0\r\n\r\n";
+  RecordingVisitor visitor;
+  net::HttpParser parser(&visitor);
+  EXPECT_EQ(0, parser.chunk_data_remaining());
+  EXPECT_EQ(3, parser.ParseChunkedBody(kInput, 3));
+  EXPECT_EQ(5, parser.chunk_data_remaining());
+
+  // The data can be consumed without going through the parser.
+  parser.SkipChunkData(2);
+  EXPECT_EQ(3, parser.chunk_data_remaining());
+  parser.SkipChunkData(3);
+  EXPECT_EQ(0, parser.chunk_data_remaining());
+
+  EXPECT_EQ(7, parser.ParseChunkedBody(kInput + 8, 7));
+  EXPECT_TRUE(parser.IsChunkedBodyComplete());
+  EXPECT_EQ("", visitor.body());
+  EXPECT_EQ("[length:5][length:0]", visitor.events());
+}
+
+TEST(HttpParserTest, ChunkedErrorIsFinal) {
+  char input[] = "5x\r\nhello\r\n";
+  net::HttpParser parser(NULL);
+  EXPECT_EQ(net::ERR_INVALID_CHUNKED_ENCODING,
+            parser.FilterChunkedBody(input, arraysize(input) - 1));
+  char next[] = "0\r\n\r\n";
+  EXPECT_EQ(net::ERR_INVALID_CHUNKED_ENCODING,
+            parser.FilterChunkedBody(next, arraysize(next) - 1));
+}
@@ -447,6 +447,11 @@ int HttpProxyClientSocketPool::IdleSocketCountInGroup(
   return base_.IdleSocketCountInGroup(group_name);
 }
 
+int HttpProxyClientSocketPool::ActiveSocketCountInGroup(
+    const std::string& group_name) const {
+  return base_.ActiveSocketCountInGroup(group_name);
+}
+
 LoadState HttpProxyClientSocketPool::GetLoadState(
     const std::string& group_name, const ClientSocketHandle* handle) const {
   return base_.GetLoadState(group_name, handle);
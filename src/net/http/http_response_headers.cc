@@ -11,6 +11,7 @@
 
 #include <algorithm>
 
+#include "base/hash.h"
 #include "base/logging.h"
 #include "base/metrics/histogram.h"
 #include "base/pickle.h"
@@ -114,6 +115,21 @@ int MapHttpResponseCode(int code) {
   return 0;
 }
 
+// Returns a case-insensitive hash (FNV-1a) of the header name in the range
+// [|name_begin|, |name_end|). Setting bit 5 folds the case of letters; other
+// characters may collide, which is fine because names are compared anyway.
+uint32 HashHeaderName(std::string::const_iterator name_begin,
+                      std::string::const_iterator name_end) {
+  uint32 hash = base::kFNV1aOffsetBasis;
+  for (std::string::const_iterator i = name_begin; i != name_end; ++i)
+    hash = base::HashFNV1aByte(hash, static_cast<uint8>(*i) | 0x20);
+  return hash;
+}
+
+// The number of offsets stored by Persist() with PERSIST_PARSED for every
+// ParsedHeader.
+const size_t kOffsetsPerHeader = 4;
+
 void CheckDoesNotHaveEmbededNulls(const std::string& str) {
   // Care needs to be taken when adding values to the raw headers string to
   // make sure it does not contain embeded NULLs. Any embeded '\0' may be
@@ -132,6 +148,12 @@ struct HttpResponseHeaders::ParsedHeader {
   std::string::const_iterator name_end;
   std::string::const_iterator value_begin;
   std::string::const_iterator value_end;
+
+  // Set by BuildIndex() for headers that are not continuations: the hash of
+  // the name, and the position in |parsed_| of the next header with the same
+  // name, or -1.
+  uint32 name_hash;
+  int next;
 };
 
 //-----------------------------------------------------------------------------
@@ -165,6 +187,15 @@ HttpResponseHeaders::HttpResponseHeaders(const Pickle& pickle, void** iter)
     Parse(raw_input);
 }
 
+// static
+scoped_refptr<HttpResponseHeaders> HttpResponseHeaders::CreateFromParsedPickle(
+    const Pickle& pickle, void** iter) {
+  scoped_refptr<HttpResponseHeaders> headers(new HttpResponseHeaders);
+  if (!headers->InitFromParsedPickle(pickle, iter))
+    return NULL;
+  return headers;
+}
+
 void HttpResponseHeaders::Persist(Pickle* pickle, PersistOptions options) {
   if (options == PERSIST_RAW) {
     pickle->WriteString(raw_headers_);
@@ -197,6 +228,10 @@ void HttpResponseHeaders::Persist(Pickle* pickle, PersistOptions options) {
   // so this just copies the first header line.
   blob.assign(raw_headers_.c_str(), strlen(raw_headers_.c_str()) + 1);
 
+  // With PERSIST_PARSED, the position of every stored header in |blob|.
+  bool store_offsets = (options & PERSIST_PARSED) == PERSIST_PARSED;
+  std::vector<uint32> offsets;
+
   for (size_t i = 0; i < parsed_.size(); ++i) {
     DCHECK(!parsed_[i].is_continuation());
 
@@ -209,6 +244,26 @@ void HttpResponseHeaders::Persist(Pickle* pickle, PersistOptions options) {
     StringToLowerASCII(&header_name);
 
     if (filter_headers.find(header_name) == filter_headers.end()) {
+      if (store_offsets) {
+        // The lines are copied verbatim, so the headers only move by the
+        // distance between the line in |raw_headers_| and in |blob|.
+        const std::string::const_iterator& line_begin = parsed_[i].name_begin;
+        for (size_t j = i; j <= k; ++j) {
+          uint32 name_offset = 0;
+          uint32 name_end_offset = 0;
+          if (!parsed_[j].is_continuation()) {
+            name_offset = blob.size() + (parsed_[j].name_begin - line_begin);
+            name_end_offset = blob.size() + (parsed_[j].name_end - line_begin);
+          }
+          offsets.push_back(name_offset);
+          offsets.push_back(name_end_offset);
+          offsets.push_back(blob.size() +
+                            (parsed_[j].value_begin - line_begin));
+          offsets.push_back(blob.size() +
+                            (parsed_[j].value_end - line_begin));
+        }
+      }
+
       // Make sure there is a null after the value.
       blob.append(parsed_[i].name_begin, parsed_[k].value_end);
       blob.push_back('\0');
@@ -219,6 +274,75 @@ void HttpResponseHeaders::Persist(Pickle* pickle, PersistOptions options) {
   blob.push_back('\0');
 
   pickle->WriteString(blob);
+  if (!store_offsets)
+    return;
+
+  pickle->WriteInt(response_code_);
+  pickle->WriteUInt16(http_version_.major_value());
+  pickle->WriteUInt16(http_version_.minor_value());
+  pickle->WriteUInt16(parsed_http_version_.major_value());
+  pickle->WriteUInt16(parsed_http_version_.minor_value());
+  pickle->WriteData(
+      offsets.empty() ? NULL : reinterpret_cast<const char*>(&offsets[0]),
+      offsets.size() * sizeof(offsets[0]));
+}
+
+bool HttpResponseHeaders::InitFromParsedPickle(const Pickle& pickle,
+                                               void** iter) {
+  uint16 major, minor, parsed_major, parsed_minor;
+  const char* data;
+  int length;
+  if (!pickle.ReadString(iter, &raw_headers_) ||
+      !pickle.ReadInt(iter, &response_code_) ||
+      !pickle.ReadUInt16(iter, &major) ||
+      !pickle.ReadUInt16(iter, &minor) ||
+      !pickle.ReadUInt16(iter, &parsed_major) ||
+      !pickle.ReadUInt16(iter, &parsed_minor) ||
+      !pickle.ReadData(iter, &data, &length)) {
+    return false;
+  }
+  http_version_ = HttpVersion(major, minor);
+  parsed_http_version_ = HttpVersion(parsed_major, parsed_minor);
+
+  // The status line and the final empty line.
+  size_t status_line_end = raw_headers_.find('\0');
+  if (response_code_ < 0 || status_line_end == std::string::npos ||
+      raw_headers_[raw_headers_.size() - 1] != '\0') {
+    return false;
+  }
+
+  const size_t kHeaderSize = kOffsetsPerHeader * sizeof(uint32);
+  if (length < 0 || length % kHeaderSize != 0)
+    return false;
+  std::vector<uint32> offsets(length / sizeof(uint32));
+  if (length)
+    memcpy(&offsets[0], data, length);
+
+  // Don't trust the offsets: the pickle comes from the disk.
+  parsed_.resize(length / kHeaderSize);
+  for (size_t i = 0; i < parsed_.size(); ++i) {
+    const uint32* header = &offsets[i * kOffsetsPerHeader];
+    if (header[0] > header[1] || header[1] > header[2] ||
+        header[2] > header[3] || header[3] > raw_headers_.size() ||
+        (header[0] != header[1] && header[0] <= status_line_end) ||
+        (i == 0 && header[0] == header[1])) {
+      parsed_.clear();
+      return false;
+    }
+
+    ParsedHeader& parsed = parsed_[i];
+    if (header[0] == header[1]) {
+      parsed.name_begin = parsed.name_end = raw_headers_.end();
+    } else {
+      parsed.name_begin = raw_headers_.begin() + header[0];
+      parsed.name_end = raw_headers_.begin() + header[1];
+    }
+    parsed.value_begin = raw_headers_.begin() + header[2];
+    parsed.value_end = raw_headers_.begin() + header[3];
+  }
+
+  BuildIndex();
+  return true;
 }
 
 void HttpResponseHeaders::Update(const HttpResponseHeaders& new_headers) {
@@ -334,6 +458,7 @@ void HttpResponseHeaders::ReplaceStatusLine(const std::string& new_status) {
 
 void HttpResponseHeaders::Parse(const std::string& raw_input) {
   raw_headers_.reserve(raw_input.size());
+  header_index_.clear();
 
   // ParseStatusLine adds a normalized status line to raw_headers_
   std::string::const_iterator line_begin = raw_input.begin();
@@ -361,6 +486,10 @@ void HttpResponseHeaders::Parse(const std::string& raw_input) {
   // Adjust to point at the null byte following the status line
   line_end = raw_headers_.begin() + status_line_len - 1;
 
+  // Every line is terminated by a null byte, so this is about the number of
+  // headers, unless some of them have several values.
+  parsed_.reserve(std::count(raw_input.begin(), raw_input.end(), '\0'));
+
   HttpUtil::HeadersIterator headers(line_end + 1, raw_headers_.end(),
                                     std::string(1, '\0'));
   while (headers.GetNext()) {
@@ -369,6 +498,8 @@ void HttpResponseHeaders::Parse(const std::string& raw_input) {
               headers.values_begin(),
               headers.values_end());
   }
+
+  BuildIndex();
 }
 
 // Append all of our headers to the final output string.
@@ -502,7 +633,20 @@ bool HttpResponseHeaders::EnumerateHeader(void** iter, const std::string& name,
     if (i >= parsed_.size()) {
       i = std::string::npos;
     } else if (!parsed_[i].is_continuation()) {
-      i = FindHeader(i, name);
+      // Continue with the next header that has the name of the one that was
+      // just enumerated, without looking the name up again.
+      size_t last = i - 1;
+      while (last > 0 && parsed_[last].is_continuation())
+        --last;
+      const ParsedHeader& header = parsed_[last];
+      if (static_cast<size_t>(header.name_end - header.name_begin) ==
+              name.size() &&
+          std::equal(header.name_begin, header.name_end, name.begin(),
+                     base::CaseInsensitiveCompareASCII<char>())) {
+        i = header.next == -1 ? std::string::npos : header.next;
+      } else {
+        i = FindHeader(i, name);
+      }
     }
   }
 
@@ -664,18 +808,67 @@ void HttpResponseHeaders::ParseStatusLine(
 
 size_t HttpResponseHeaders::FindHeader(size_t from,
                                        const std::string& search) const {
-  for (size_t i = from; i < parsed_.size(); ++i) {
-    if (parsed_[i].is_continuation())
-      continue;
-    const std::string::const_iterator& name_begin = parsed_[i].name_begin;
-    const std::string::const_iterator& name_end = parsed_[i].name_end;
-    if (static_cast<size_t>(name_end - name_begin) == search.size() &&
-        std::equal(name_begin, name_end, search.begin(),
-                   base::CaseInsensitiveCompare<char>()))
-      return i;
+  if (header_index_.empty())
+    return std::string::npos;
+
+  uint32 hash = HashHeaderName(search.begin(), search.end());
+  size_t mask = header_index_.size() - 1;
+  for (size_t bucket = hash & mask; ; bucket = (bucket + 1) & mask) {
+    int i = header_index_[bucket];
+    if (i == -1)
+      return std::string::npos;
+    const ParsedHeader& header = parsed_[i];
+    if (header.name_hash == hash &&
+        static_cast<size_t>(header.name_end - header.name_begin) ==
+            search.size() &&
+        std::equal(header.name_begin, header.name_end, search.begin(),
+                   base::CaseInsensitiveCompareASCII<char>())) {
+      while (i != -1 && static_cast<size_t>(i) < from)
+        i = parsed_[i].next;
+      return i == -1 ? std::string::npos : i;
+    }
   }
+}
+
+void HttpResponseHeaders::BuildIndex() {
+  header_index_.clear();
+  if (parsed_.empty())
+    return;
+
+  // Keep the table at most half full, so that probe sequences stay short.
+  size_t num_buckets = 8;
+  while (num_buckets < parsed_.size() * 2)
+    num_buckets *= 2;
+  size_t mask = num_buckets - 1;
+  header_index_.assign(num_buckets, -1);
 
-  return std::string::npos;
+  // The last header of each chain, so that headers are linked in order.
+  std::vector<int> last(num_buckets, -1);
+  for (size_t i = 0; i < parsed_.size(); ++i) {
+    ParsedHeader& header = parsed_[i];
+    if (header.is_continuation())
+      continue;
+    header.name_hash = HashHeaderName(header.name_begin, header.name_end);
+    header.next = -1;
+    for (size_t bucket = header.name_hash & mask; ;
+         bucket = (bucket + 1) & mask) {
+      int first = header_index_[bucket];
+      if (first == -1) {
+        header_index_[bucket] = last[bucket] = i;
+        break;
+      }
+      const ParsedHeader& other = parsed_[first];
+      if (other.name_hash == header.name_hash &&
+          other.name_end - other.name_begin ==
+              header.name_end - header.name_begin &&
+          std::equal(header.name_begin, header.name_end, other.name_begin,
+                     base::CaseInsensitiveCompareASCII<char>())) {
+        parsed_[last[bucket]].next = i;
+        last[bucket] = i;
+        break;
+      }
+    }
+  }
 }
 
 void HttpResponseHeaders::AddHeader(std::string::const_iterator name_begin,
@@ -37,6 +37,10 @@ class NET_EXPORT HttpResponseHeaders
   static const PersistOptions PERSIST_SANS_HOP_BY_HOP = 1 << 2;
   static const PersistOptions PERSIST_SANS_NON_CACHEABLE = 1 << 3;
   static const PersistOptions PERSIST_SANS_RANGES = 1 << 4;
+  // Also stores where each header is found, so that CreateFromParsedPickle()
+  // can restore the headers without parsing them again. It can be combined
+  // with the other options, except PERSIST_RAW.
+  static const PersistOptions PERSIST_PARSED = 1 << 5;
 
   // Parses the given raw_headers.  raw_headers should be formatted thus:
   // includes the http status response line, each line is \0-terminated, and
@@ -53,6 +57,11 @@ class NET_EXPORT HttpResponseHeaders
   // be passed to the pickle's various Read* methods.
   HttpResponseHeaders(const Pickle& pickle, void** pickle_iter);
 
+  // Creates an object from a representation stored by Persist() with the
+  // PERSIST_PARSED option. Returns NULL if the pickle is not valid.
+  static scoped_refptr<HttpResponseHeaders> CreateFromParsedPickle(
+      const Pickle& pickle, void** pickle_iter);
+
   // Appends a representation of this object to the given pickle.
   // The options argument can be a combination of PersistOptions.
   void Persist(Pickle* pickle, PersistOptions options);
@@ -280,6 +289,13 @@ class NET_EXPORT HttpResponseHeaders
   // index |from|.  Returns string::npos if not found.
   size_t FindHeader(size_t from, const std::string& name) const;
 
+  // Builds |header_index_| for the current contents of |parsed_|.
+  void BuildIndex();
+
+  // Restores |raw_headers_| and |parsed_| from a pickle written by Persist()
+  // with PERSIST_PARSED. Returns false if the pickle is not valid.
+  bool InitFromParsedPickle(const Pickle& pickle, void** pickle_iter);
+
   // Add a header->value pair to our list.  If we already have header in our
   // list, append the value to it.
   void AddHeader(std::string::const_iterator name_begin,
@@ -322,6 +338,13 @@ class NET_EXPORT HttpResponseHeaders
   // header-value pairs within raw_headers_.
   HeaderList parsed_;
 
+  // A hash table (with open addressing) of the header names, see BuildIndex().
+  // Each bucket holds the position in |parsed_| of the first header with a
+  // given name, or -1, and the headers with the same name are linked through
+  // ParsedHeader::next. This turns FindHeader() into a hash lookup instead of
+  // a case-insensitive scan of every header.
+  std::vector<int> header_index_;
+
   // The raw_headers_ consists of the normalized status line (terminated with a
   // null byte) and then followed by the raw null-terminated headers from the
   // input that was passed to our constructor.  We preserve the input [*] to
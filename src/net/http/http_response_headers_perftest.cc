@@ -0,0 +1,215 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <string>
+#include <vector>
+
+#include "base/basictypes.h"
+#include "base/memory/ref_counted.h"
+#include "base/perftimer.h"
+#include "base/pickle.h"
+#include "base/stringprintf.h"
+#include "base/time.h"
+#include "net/http/http_response_headers.h"
+#include "net/http/http_util.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+using net::HttpResponseHeaders;
+
+namespace {
+
+const int kNumIterations = 20000;
+
+// A few typical responses from popular sites, as received from the network.
+const char* const kResponses[] = {
+  "HTTP/1.1 200 OK\r\n"
+  "Date: Wed, 14 Sep 2011 12:12:12 GMT\r\n"
+  "Expires: -1\r\n"
+  "Cache-Control: private, max-age=0\r\n"
+  "Content-Type: text/html; charset=UTF-8\r\n"
+  "Set-Cookie: PREF=ID=0123456789abcdef:FF=0:TM=1316000000; "
+  "expires=Fri, 13-Sep-2013 12:12:12 GMT; path=/; domain=.example.com\r\n"
+  "Set-Cookie: NID=51=abcdefghijklmnopqrstuvwxyz; "
+  "expires=Thu, 15-Mar-2012 12:12:12 GMT; path=/; domain=.example.com; "
+  "HttpOnly\r\n"
+  "P3P: CP=\"This is not a P3P policy!\"\r\n"
+  "Content-Encoding: gzip\r\n"
+  "Server: gws\r\n"
+  "Content-Length: 14432\r\n"
+  "X-XSS-Protection: 1; mode=block\r\n"
+  "X-Frame-Options: SAMEORIGIN\r\n\r\n",
+
+  "HTTP/1.1 200 OK\r\n"
+  "Server: Apache\r\n"
+  "Last-Modified: Mon, 12 Sep 2011 10:00:00 GMT\r\n"
+  "ETag: \"4e6dd8a0-1a2b\"\r\n"
+  "Accept-Ranges: bytes\r\n"
+  "Content-Type: image/png\r\n"
+  "Content-Length: 6699\r\n"
+  "Cache-Control: public, max-age=31536000\r\n"
+  "Expires: Thu, 13 Sep 2012 12:12:12 GMT\r\n"
+  "Date: Wed, 14 Sep 2011 12:12:12 GMT\r\n"
+  "Connection: keep-alive\r\n"
+  "Vary: Accept-Encoding\r\n"
+  "Age: 1234\r\n\r\n",
+
+  "HTTP/1.1 301 Moved Permanently\r\n"
+  "Location: http://www.example.com/\r\n"
+  "Content-Type: text/html; charset=UTF-8\r\n"
+  "Date: Wed, 14 Sep 2011 12:12:12 GMT\r\n"
+  "Expires: Fri, 14 Oct 2011 12:12:12 GMT\r\n"
+  "Cache-Control: public, max-age=2592000\r\n"
+  "Server: gws\r\n"
+  "Content-Length: 219\r\n\r\n",
+
+  "HTTP/1.1 200 OK\r\n"
+  "Content-Type: application/javascript\r\n"
+  "Transfer-Encoding: chunked\r\n"
+  "Connection: keep-alive\r\n"
+  "Vary: Accept-Encoding\r\n"
+  "Vary: User-Agent\r\n"
+  "Date: Wed, 14 Sep 2011 12:12:12 GMT\r\n"
+  "Cache-Control: max-age=600, must-revalidate\r\n"
+  "Content-Encoding: gzip\r\n"
+  "X-Cache: HIT from proxy.example.com\r\n"
+  "X-Cache-Lookup: HIT from proxy.example.com:3128\r\n"
+  "Via: 1.1 proxy.example.com (squid/3.1.12)\r\n\r\n",
+};
+
+// The headers that the network stack looks at for every response.
+const char* const kLookups[] = {
+  "cache-control", "content-type", "content-length", "content-encoding",
+  "date", "expires", "last-modified", "etag", "location", "vary", "pragma",
+  "set-cookie", "transfer-encoding", "connection", "age", "x-missing",
+};
+
+void LogNanosecondsPerOp(const char* test_name, const base::TimeTicks& start,
+                         int ops) {
+  base::TimeDelta elapsed = base::TimeTicks::Now() - start;
+  LogPerfResult(test_name,
+                elapsed.InMicroseconds() * 1000.0 / ops, "ns/op");
+}
+
+class HttpResponseHeadersPerfTest : public testing::Test {
+ protected:
+  virtual void SetUp() {
+    for (size_t i = 0; i < arraysize(kResponses); ++i) {
+      raw_headers_.push_back(net::HttpUtil::AssembleRawHeaders(
+          kResponses[i], strlen(kResponses[i])));
+      headers_.push_back(new HttpResponseHeaders(raw_headers_.back()));
+    }
+  }
+
+  std::vector<std::string> raw_headers_;
+  std::vector<scoped_refptr<HttpResponseHeaders> > headers_;
+};
+
+}  // namespace
+
+TEST_F(HttpResponseHeadersPerfTest, Parse) {
+  int ops = 0;
+  base::TimeTicks start = base::TimeTicks::Now();
+  for (int i = 0; i < kNumIterations; ++i) {
+    for (size_t j = 0; j < raw_headers_.size(); ++j, ++ops) {
+      scoped_refptr<HttpResponseHeaders> headers(
+          new HttpResponseHeaders(raw_headers_[j]));
+      EXPECT_NE(-1, headers->response_code());
+    }
+  }
+  LogNanosecondsPerOp("HttpResponseHeaders_parse", start, ops);
+}
+
+TEST_F(HttpResponseHeadersPerfTest, Lookup) {
+  int ops = 0;
+  int found = 0;
+  base::TimeTicks start = base::TimeTicks::Now();
+  for (int i = 0; i < kNumIterations; ++i) {
+    for (size_t j = 0; j < headers_.size(); ++j) {
+      for (size_t k = 0; k < arraysize(kLookups); ++k, ++ops) {
+        if (headers_[j]->HasHeader(kLookups[k]))
+          found++;
+      }
+    }
+  }
+  LogNanosecondsPerOp("HttpResponseHeaders_lookup", start, ops);
+  EXPECT_LT(0, found);
+
+  ops = 0;
+  std::string value;
+  start = base::TimeTicks::Now();
+  for (int i = 0; i < kNumIterations; ++i) {
+    for (size_t j = 0; j < headers_.size(); ++j, ++ops) {
+      void* iter = NULL;
+      while (headers_[j]->EnumerateHeader(&iter, "cache-control", &value)) {}
+    }
+  }
+  LogNanosecondsPerOp("HttpResponseHeaders_enumerate", start, ops);
+}
+
+// Responses with many headers (for example, from some CDNs and proxies) are
+// where a linear search for every lookup hurts the most.
+TEST_F(HttpResponseHeadersPerfTest, LookupManyHeaders) {
+  std::string response("HTTP/1.1 200 OK\r\n");
+  for (int i = 0; i < 60; ++i)
+    response.append(base::StringPrintf("X-Header-%d: value %d\r\n", i, i));
+  response.append(kResponses[1] + strlen("HTTP/1.1 200 OK\r\n"));
+  scoped_refptr<HttpResponseHeaders> headers(new HttpResponseHeaders(
+      net::HttpUtil::AssembleRawHeaders(response.data(), response.size())));
+
+  int ops = 0;
+  int found = 0;
+  base::TimeTicks start = base::TimeTicks::Now();
+  for (int i = 0; i < kNumIterations; ++i) {
+    for (size_t k = 0; k < arraysize(kLookups); ++k, ++ops) {
+      if (headers->HasHeader(kLookups[k]))
+        found++;
+    }
+  }
+  LogNanosecondsPerOp("HttpResponseHeaders_lookup_many", start, ops);
+  EXPECT_LT(0, found);
+}
+
+// Compares restoring the headers of a cache entry by parsing them again with
+// restoring them from the stored locations of every header.
+TEST_F(HttpResponseHeadersPerfTest, Restore) {
+  const HttpResponseHeaders::PersistOptions kOptions =
+      HttpResponseHeaders::PERSIST_SANS_COOKIES |
+      HttpResponseHeaders::PERSIST_SANS_CHALLENGES |
+      HttpResponseHeaders::PERSIST_SANS_HOP_BY_HOP |
+      HttpResponseHeaders::PERSIST_SANS_NON_CACHEABLE |
+      HttpResponseHeaders::PERSIST_SANS_RANGES;
+
+  std::vector<Pickle> pickles(headers_.size());
+  std::vector<Pickle> parsed_pickles(headers_.size());
+  for (size_t i = 0; i < headers_.size(); ++i) {
+    headers_[i]->Persist(&pickles[i], kOptions);
+    headers_[i]->Persist(&parsed_pickles[i],
+                         kOptions | HttpResponseHeaders::PERSIST_PARSED);
+  }
+
+  int ops = 0;
+  base::TimeTicks start = base::TimeTicks::Now();
+  for (int i = 0; i < kNumIterations; ++i) {
+    for (size_t j = 0; j < pickles.size(); ++j, ++ops) {
+      void* iter = NULL;
+      scoped_refptr<HttpResponseHeaders> headers(
+          new HttpResponseHeaders(pickles[j], &iter));
+      EXPECT_NE(-1, headers->response_code());
+    }
+  }
+  LogNanosecondsPerOp("HttpResponseHeaders_restore", start, ops);
+
+  ops = 0;
+  start = base::TimeTicks::Now();
+  for (int i = 0; i < kNumIterations; ++i) {
+    for (size_t j = 0; j < parsed_pickles.size(); ++j, ++ops) {
+      void* iter = NULL;
+      scoped_refptr<HttpResponseHeaders> headers(
+          HttpResponseHeaders::CreateFromParsedPickle(parsed_pickles[j],
+                                                      &iter));
+      ASSERT_TRUE(headers.get());
+    }
+  }
+  LogNanosecondsPerOp("HttpResponseHeaders_restore_parsed", start, ops);
+}
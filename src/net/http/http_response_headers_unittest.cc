@@ -470,7 +470,126 @@ TEST(HttpResponseHeadersTest, Persist) {
     std::string h2;
     parsed2->GetNormalizedHeaders(&h2);
     EXPECT_EQ(std::string(tests[i].expected_headers), h2);
+
+    if (tests[i].options == net::HttpResponseHeaders::PERSIST_RAW)
+      continue;
+
+    // The parsed form must restore the same headers without parsing them.
+    Pickle parsed_pickle;
+    parsed1->Persist(&parsed_pickle,
+                     tests[i].options |
+                         net::HttpResponseHeaders::PERSIST_PARSED);
+    iter = NULL;
+    scoped_refptr<net::HttpResponseHeaders> parsed3(
+        net::HttpResponseHeaders::CreateFromParsedPickle(parsed_pickle,
+                                                         &iter));
+    ASSERT_TRUE(parsed3.get());
+
+    std::string h3;
+    parsed3->GetNormalizedHeaders(&h3);
+    EXPECT_EQ(std::string(tests[i].expected_headers), h3);
+    EXPECT_EQ(parsed2->raw_headers(), parsed3->raw_headers());
+    EXPECT_EQ(parsed2->response_code(), parsed3->response_code());
+    EXPECT_TRUE(parsed2->GetHttpVersion() == parsed3->GetHttpVersion());
+    EXPECT_TRUE(parsed2->GetParsedHttpVersion() ==
+                parsed3->GetParsedHttpVersion());
+  }
+}
+
+TEST(HttpResponseHeadersTest, PersistParsedLookups) {
+  std::string headers =
+      "HTTP/1.0 404 Not Found\n"
+      "Set-Cookie: a=1\n"
+      "Cache-Control: private, max-age=10\n"
+      "Content-Type: text/html\n"
+      "set-cookie: b=2\n"
+      "Vary: Accept-Encoding\n"
+      "CACHE-control: no-transform\n";
+  HeadersToRaw(&headers);
+  scoped_refptr<net::HttpResponseHeaders> parsed1(
+      new net::HttpResponseHeaders(headers));
+
+  Pickle pickle;
+  parsed1->Persist(&pickle, net::HttpResponseHeaders::PERSIST_SANS_COOKIES |
+                                net::HttpResponseHeaders::PERSIST_PARSED);
+  void* iter = NULL;
+  scoped_refptr<net::HttpResponseHeaders> parsed2(
+      net::HttpResponseHeaders::CreateFromParsedPickle(pickle, &iter));
+  ASSERT_TRUE(parsed2.get());
+  EXPECT_EQ(404, parsed2->response_code());
+  EXPECT_EQ("HTTP/1.0 404 Not Found", parsed2->GetStatusLine());
+
+  EXPECT_FALSE(parsed2->HasHeader("set-cookie"));
+  EXPECT_TRUE(parsed2->HasHeader("VARY"));
+  EXPECT_TRUE(parsed2->HasHeaderValue("cache-control", "max-age=10"));
+
+  std::string value;
+  EXPECT_TRUE(parsed2->GetNormalizedHeader("Cache-Control", &value));
+  EXPECT_EQ("private, max-age=10, no-transform", value);
+
+  iter = NULL;
+  const char* const kExpected[] = { "private", "max-age=10", "no-transform" };
+  for (size_t i = 0; i < arraysize(kExpected); ++i) {
+    EXPECT_TRUE(parsed2->EnumerateHeader(&iter, "cache-control", &value));
+    EXPECT_EQ(kExpected[i], value);
   }
+  EXPECT_FALSE(parsed2->EnumerateHeader(&iter, "cache-control", &value));
+
+  // The restored headers can be changed like any others.
+  parsed2->AddHeader("Content-Length: 100");
+  EXPECT_EQ(100, parsed2->GetContentLength());
+  parsed2->RemoveHeader("cache-control");
+  EXPECT_FALSE(parsed2->HasHeader("Cache-Control"));
+  EXPECT_TRUE(parsed2->HasHeader("content-type"));
+}
+
+TEST(HttpResponseHeadersTest, PersistParsedBadOffsets) {
+  std::string blob("HTTP/1.1 200 OK");
+  blob.push_back('\0');
+  blob.append("Foo: 1");
+  blob.push_back('\0');
+  blob.push_back('\0');
+
+  const struct {
+    uint32 offsets[4];
+    bool valid;
+  } tests[] = {
+    { { 16, 19, 21, 22 }, true },
+    // Out of bounds.
+    { { 16, 19, 21, 100 }, false },
+    // Not in order.
+    { { 19, 16, 21, 22 }, false },
+    // A name in the status line.
+    { { 0, 4, 21, 22 }, false },
+    // The first header can't be a continuation.
+    { { 0, 0, 21, 22 }, false },
+  };
+
+  for (size_t i = 0; i < arraysize(tests); ++i) {
+    Pickle pickle;
+    pickle.WriteString(blob);
+    pickle.WriteInt(200);
+    pickle.WriteUInt16(1);
+    pickle.WriteUInt16(1);
+    pickle.WriteUInt16(1);
+    pickle.WriteUInt16(1);
+    pickle.WriteData(reinterpret_cast<const char*>(tests[i].offsets),
+                     sizeof(tests[i].offsets));
+
+    void* iter = NULL;
+    scoped_refptr<net::HttpResponseHeaders> parsed(
+        net::HttpResponseHeaders::CreateFromParsedPickle(pickle, &iter));
+    EXPECT_EQ(tests[i].valid, parsed.get() != NULL) << i;
+    if (parsed.get())
+      EXPECT_TRUE(parsed->HasHeaderValue("foo", "1"));
+  }
+
+  // A truncated pickle.
+  Pickle pickle;
+  pickle.WriteString(blob);
+  void* iter = NULL;
+  EXPECT_TRUE(net::HttpResponseHeaders::CreateFromParsedPickle(pickle,
+                                                               &iter) == NULL);
 }
 
 TEST(HttpResponseHeadersTest, EnumerateHeader_Coalesced) {
@@ -22,7 +22,7 @@ namespace net {
 // serialized HttpResponseInfo.
 enum {
   // The version of the response info used when persisting response info.
-  RESPONSE_INFO_VERSION = 2,
+  RESPONSE_INFO_VERSION = 3,
 
   // The minimum version supported for deserializing response info.
   RESPONSE_INFO_MINIMUM_VERSION = 1,
@@ -62,6 +62,10 @@ enum {
   // protocol version, compression method and whether SSLv3 fallback was used.
   RESPONSE_INFO_HAS_SSL_CONNECTION_STATUS = 1 << 16,
 
+  // This bit is set if the response headers were stored with the location of
+  // every header, so that they don't have to be parsed again (version 3).
+  RESPONSE_INFO_HAS_PARSED_HEADERS = 1 << 17,
+
   // TODO(darin): Add other bits to indicate alternate request methods.
   // For now, we don't support storing those.
 };
@@ -137,7 +141,13 @@ bool HttpResponseInfo::InitFromPickle(const Pickle& pickle,
   response_time = Time::FromInternalValue(time_val);
 
   // read response-headers
-  headers = new HttpResponseHeaders(pickle, &iter);
+  if (flags & RESPONSE_INFO_HAS_PARSED_HEADERS) {
+    headers = HttpResponseHeaders::CreateFromParsedPickle(pickle, &iter);
+    if (!headers.get())
+      return false;
+  } else {
+    headers = new HttpResponseHeaders(pickle, &iter);
+  }
   if (headers->response_code() == -1)
     return false;
 
@@ -223,6 +233,8 @@ void HttpResponseInfo::Persist(Pickle* pickle,
     flags |= RESPONSE_INFO_WAS_NPN;
   if (was_fetched_via_proxy)
     flags |= RESPONSE_INFO_WAS_PROXY;
+  if (skip_transient_headers)
+    flags |= RESPONSE_INFO_HAS_PARSED_HEADERS;
 
   pickle->WriteInt(flags);
   pickle->WriteInt64(request_time.ToInternalValue());
@@ -237,7 +249,8 @@ void HttpResponseInfo::Persist(Pickle* pickle,
         net::HttpResponseHeaders::PERSIST_SANS_CHALLENGES |
         net::HttpResponseHeaders::PERSIST_SANS_HOP_BY_HOP |
         net::HttpResponseHeaders::PERSIST_SANS_NON_CACHEABLE |
-        net::HttpResponseHeaders::PERSIST_SANS_RANGES;
+        net::HttpResponseHeaders::PERSIST_SANS_RANGES |
+        net::HttpResponseHeaders::PERSIST_PARSED;
   }
 
   headers->Persist(pickle, persist_options);
@@ -35,4 +35,18 @@ std::string PortAlternateProtocolPair::ToString() const {
                             AlternateProtocolToString(protocol));
 }
 
+ConnectionStats::ConnectionStats()
+    : peak_concurrency(0),
+      window_peak_concurrency(0),
+      window_requests(0),
+      requests(0),
+      idle_socket_requests(0) {
+}
+
+double ConnectionStats::GetIdleSocketRate() const {
+  if (!requests)
+    return 0.0;
+  return static_cast<double>(idle_socket_requests) / requests;
+}
+
 }  // namespace net
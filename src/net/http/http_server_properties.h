@@ -8,6 +8,7 @@
 #include <map>
 #include <string>
 #include "base/basictypes.h"
+#include "base/time.h"
 #include "net/base/host_port_pair.h"
 #include "net/base/net_export.h"
 
@@ -34,6 +35,30 @@ struct NET_EXPORT PortAlternateProtocolPair {
 
 typedef std::map<HostPortPair, PortAlternateProtocolPair> AlternateProtocolMap;
 
+// How the connections to a server have been used recently.
+struct NET_EXPORT ConnectionStats {
+  ConnectionStats();
+
+  // Returns the fraction of the requests that got an idle socket from the
+  // pool, instead of waiting for a new connection.
+  double GetIdleSocketRate() const;
+
+  // The largest number of sockets used in parallel in the last full window
+  // of requests, and so far in the current window.
+  int peak_concurrency;
+  int window_peak_concurrency;
+  // The number of requests in the current window.
+  int window_requests;
+
+  // The number of requests, and the number of them that got an idle socket.
+  // Both decay by half at the end of every window.
+  int requests;
+  int idle_socket_requests;
+
+  // A moving average of the time spent waiting for new connections.
+  base::TimeDelta connect_time;
+};
+
 extern const char kAlternateProtocolHeader[];
 extern const char* const kAlternateProtocolStrings[NUM_ALTERNATE_PROTOCOLS];
 
@@ -41,6 +66,7 @@ extern const char* const kAlternateProtocolStrings[NUM_ALTERNATE_PROTOCOLS];
 // Currently, this class manages servers':
 // * SPDY support (based on NPN results)
 // * Alternate-Protocol support
+// * How many connections are used in parallel (not persisted)
 class NET_EXPORT HttpServerProperties {
  public:
   HttpServerProperties() {}
@@ -76,6 +102,19 @@ class NET_EXPORT HttpServerProperties {
   // Returns all Alternate-Protocol mappings.
   virtual const AlternateProtocolMap& alternate_protocol_map() const = 0;
 
+  // Records that a request to |server| got a socket while |concurrency|
+  // sockets of the same pool group were in use, including its own.
+  // |idle_socket| is true if the socket was idle in the pool; otherwise
+  // |connect_wait| is the time spent waiting for the connection.
+  virtual void RecordSocketUse(const HostPortPair& server,
+                               int concurrency,
+                               bool idle_socket,
+                               base::TimeDelta connect_wait) = 0;
+
+  // Returns what has been learned about the connections to |server|, or
+  // empty stats if nothing is known.
+  virtual ConnectionStats GetConnectionStats(const HostPortPair& server) = 0;
+
  private:
   DISALLOW_COPY_AND_ASSIGN(HttpServerProperties);
 };
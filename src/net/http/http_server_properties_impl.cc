@@ -4,6 +4,8 @@
 
 #include "net/http/http_server_properties_impl.h"
 
+#include <algorithm>
+
 #include "base/logging.h"
 #include "base/memory/scoped_ptr.h"
 #include "base/stl_util.h"
@@ -11,7 +13,23 @@
 
 namespace net {
 
-HttpServerPropertiesImpl::HttpServerPropertiesImpl() {
+namespace {
+
+// The number of servers whose connection stats are kept.
+const size_t kMaxConnectionStatsServers = 1000;
+
+// The number of requests after which the peak concurrency of a server is
+// replaced by the one of the last window, so that it follows the changes of
+// the pages loaded from the server.
+const int kConnectionStatsWindow = 64;
+
+// The weight of a new sample in the moving average of the connect time.
+const int kConnectTimeWeight = 8;
+
+}  // namespace
+
+HttpServerPropertiesImpl::HttpServerPropertiesImpl()
+    : connection_stats_map_(kMaxConnectionStatsServers) {
 }
 
 HttpServerPropertiesImpl::~HttpServerPropertiesImpl() {
@@ -88,6 +106,7 @@ void HttpServerPropertiesImpl::Clear() {
   DCHECK(CalledOnValidThread());
   spdy_servers_table_.clear();
   alternate_protocol_map_.clear();
+  connection_stats_map_.Clear();
 }
 
 bool HttpServerPropertiesImpl::SupportsSpdy(
@@ -190,4 +209,45 @@ HttpServerPropertiesImpl::alternate_protocol_map() const {
   return alternate_protocol_map_;
 }
 
+void HttpServerPropertiesImpl::RecordSocketUse(const HostPortPair& server,
+                                               int concurrency,
+                                               bool idle_socket,
+                                               base::TimeDelta connect_wait) {
+  DCHECK(CalledOnValidThread());
+  ConnectionStatsMap::iterator it = connection_stats_map_.Get(server);
+  if (it == connection_stats_map_.end())
+    it = connection_stats_map_.Put(server, ConnectionStats());
+  ConnectionStats& stats = it->second;
+
+  stats.peak_concurrency = std::max(stats.peak_concurrency, concurrency);
+  stats.window_peak_concurrency =
+      std::max(stats.window_peak_concurrency, concurrency);
+  stats.requests++;
+  if (idle_socket) {
+    stats.idle_socket_requests++;
+  } else if (stats.connect_time == base::TimeDelta()) {
+    stats.connect_time = connect_wait;
+  } else {
+    stats.connect_time +=
+        (connect_wait - stats.connect_time) / kConnectTimeWeight;
+  }
+
+  if (++stats.window_requests < kConnectionStatsWindow)
+    return;
+  stats.peak_concurrency = stats.window_peak_concurrency;
+  stats.window_peak_concurrency = 0;
+  stats.window_requests = 0;
+  stats.requests /= 2;
+  stats.idle_socket_requests /= 2;
+}
+
+ConnectionStats HttpServerPropertiesImpl::GetConnectionStats(
+    const HostPortPair& server) {
+  DCHECK(CalledOnValidThread());
+  ConnectionStatsMap::iterator it = connection_stats_map_.Peek(server);
+  if (it == connection_stats_map_.end())
+    return ConnectionStats();
+  return it->second;
+}
+
 }  // namespace net
@@ -11,6 +11,7 @@
 #include "base/basictypes.h"
 #include "base/gtest_prod_util.h"
 #include "base/hash_tables.h"
+#include "base/memory/mru_cache.h"
 #include "base/threading/non_thread_safe.h"
 #include "base/values.h"
 #include "net/base/host_port_pair.h"
@@ -87,7 +88,19 @@ class NET_EXPORT HttpServerPropertiesImpl
   // Returns all Alternate-Protocol mappings.
   virtual const AlternateProtocolMap& alternate_protocol_map() const OVERRIDE;
 
+  // Records the use of a socket to |server|.
+  virtual void RecordSocketUse(const HostPortPair& server,
+                               int concurrency,
+                               bool idle_socket,
+                               base::TimeDelta connect_wait) OVERRIDE;
+
+  // Returns the connection stats of |server|.
+  virtual ConnectionStats GetConnectionStats(
+      const HostPortPair& server) OVERRIDE;
+
  private:
+  typedef base::MRUCache<HostPortPair, ConnectionStats> ConnectionStatsMap;
+
   // |spdy_servers_table_| has flattened representation of servers (host/port
   // pair) that either support or not support SPDY protocol.
   typedef base::hash_map<std::string, bool> SpdyServerHostPortTable;
@@ -95,6 +108,9 @@ class NET_EXPORT HttpServerPropertiesImpl
 
   AlternateProtocolMap alternate_protocol_map_;
 
+  // The stats of the most recently used servers.
+  ConnectionStatsMap connection_stats_map_;
+
   DISALLOW_COPY_AND_ASSIGN(HttpServerPropertiesImpl);
 };
 
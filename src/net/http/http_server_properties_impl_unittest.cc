@@ -279,6 +279,142 @@ TEST_F(AlternateProtocolServerPropertiesTest, Forced) {
       impl_.HasAlternateProtocol(test_host_port_pair2));
 }
 
+typedef HttpServerPropertiesImplTest ConnectionStatsTest;
+
+TEST_F(ConnectionStatsTest, Basic) {
+  HostPortPair server("www.example.com", 80);
+  ConnectionStats stats = impl_.GetConnectionStats(server);
+  EXPECT_EQ(0, stats.peak_concurrency);
+  EXPECT_EQ(0, stats.requests);
+  EXPECT_EQ(0.0, stats.GetIdleSocketRate());
+
+  impl_.RecordSocketUse(server, 1, false,
+                        base::TimeDelta::FromMilliseconds(80));
+  impl_.RecordSocketUse(server, 3, false,
+                        base::TimeDelta::FromMilliseconds(160));
+  impl_.RecordSocketUse(server, 2, true, base::TimeDelta());
+  impl_.RecordSocketUse(server, 1, true, base::TimeDelta());
+
+  stats = impl_.GetConnectionStats(server);
+  EXPECT_EQ(3, stats.peak_concurrency);
+  EXPECT_EQ(4, stats.requests);
+  EXPECT_EQ(2, stats.idle_socket_requests);
+  EXPECT_DOUBLE_EQ(0.5, stats.GetIdleSocketRate());
+  // The first connect time is taken as is, the next ones are averaged in.
+  EXPECT_EQ(base::TimeDelta::FromMilliseconds(90), stats.connect_time);
+
+  // Other servers are not affected.
+  EXPECT_EQ(0, impl_.GetConnectionStats(
+      HostPortPair("www.example.com", 443)).peak_concurrency);
+
+  impl_.Clear();
+  EXPECT_EQ(0, impl_.GetConnectionStats(server).peak_concurrency);
+}
+
+// The peak concurrency follows the last full window of 64 requests, so that
+// it goes down when a server stops needing as many connections.
+TEST_F(ConnectionStatsTest, WindowDecay) {
+  HostPortPair server("www.example.com", 80);
+  impl_.RecordSocketUse(server, 6, false,
+                        base::TimeDelta::FromMilliseconds(100));
+  for (int i = 1; i < 64; ++i)
+    impl_.RecordSocketUse(server, 2, true, base::TimeDelta());
+
+  ConnectionStats stats = impl_.GetConnectionStats(server);
+  EXPECT_EQ(6, stats.peak_concurrency);
+  EXPECT_EQ(0, stats.window_requests);
+  EXPECT_EQ(32, stats.requests);
+  EXPECT_EQ(31, stats.idle_socket_requests);
+
+  for (int i = 0; i < 63; ++i)
+    impl_.RecordSocketUse(server, 2, true, base::TimeDelta());
+  EXPECT_EQ(6, impl_.GetConnectionStats(server).peak_concurrency);
+  impl_.RecordSocketUse(server, 1, true, base::TimeDelta());
+  EXPECT_EQ(2, impl_.GetConnectionStats(server).peak_concurrency);
+}
+
+// A synthetic, hand-written sequence of page loads from a few example.com and
+// example.org servers; it is not a recording of real traffic.  Each page load
+// is the number of requests issued in parallel to a server, the number of
+// requests that followed once those were done, and the connect time.
+struct SyntheticPageLoad {
+  const char* host;
+  int parallel_requests;
+  int following_requests;
+  int connect_ms;
+};
+
+const SyntheticPageLoad kSyntheticPageLoads[] = {
+  { "www.example.com", 6, 14, 95 },
+  { "static.example.com", 4, 30, 40 },
+  { "news.example.org", 6, 40, 120 },
+  { "www.example.com", 6, 12, 90 },
+  { "img.example.org", 2, 5, 60 },
+  { "static.example.com", 4, 28, 45 },
+  { "news.example.org", 5, 38, 110 },
+  { "www.example.com", 6, 16, 100 },
+  { "img.example.org", 2, 3, 55 },
+  { "news.example.org", 6, 41, 130 },
+  { "static.example.com", 3, 25, 40 },
+  { "www.example.com", 5, 13, 85 },
+};
+
+// Simulates the synthetic page loads, and connects as many sockets as the
+// learned peak concurrency before every page load, like the socket warm-up
+// of HttpStreamFactoryImpl does. The idle sockets are assumed to time out
+// between page loads.
+void SimulatePageLoads(HttpServerPropertiesImpl* impl, bool warm_up,
+                     int* new_connections, base::TimeDelta* connect_wait) {
+  *new_connections = 0;
+  *connect_wait = base::TimeDelta();
+  for (size_t i = 0; i < arraysize(kSyntheticPageLoads); ++i) {
+    const SyntheticPageLoad& load = kSyntheticPageLoads[i];
+    HostPortPair server(load.host, 80);
+    int warm_sockets =
+        warm_up ? impl->GetConnectionStats(server).peak_concurrency : 0;
+    base::TimeDelta connect_time =
+        base::TimeDelta::FromMilliseconds(load.connect_ms);
+
+    for (int j = 0; j < load.parallel_requests; ++j) {
+      bool idle_socket = j < warm_sockets;
+      if (!idle_socket) {
+        ++*new_connections;
+        *connect_wait += connect_time;
+      }
+      impl->RecordSocketUse(server, j + 1, idle_socket,
+                            idle_socket ? base::TimeDelta() : connect_time);
+    }
+    for (int j = 0; j < load.following_requests; ++j) {
+      impl->RecordSocketUse(server, load.parallel_requests, true,
+                            base::TimeDelta());
+    }
+  }
+}
+
+TEST_F(ConnectionStatsTest, SyntheticPageLoads) {
+  int new_connections;
+  base::TimeDelta connect_wait;
+  SimulatePageLoads(&impl_, false, &new_connections, &connect_wait);
+  EXPECT_EQ(55, new_connections);
+
+  HttpServerPropertiesImpl warm_impl;
+  int warm_new_connections;
+  base::TimeDelta warm_connect_wait;
+  SimulatePageLoads(&warm_impl, true, &warm_new_connections,
+                    &warm_connect_wait);
+  // Only the first page load from every server has to wait for connections.
+  EXPECT_EQ(6 + 4 + 6 + 2, warm_new_connections);
+  EXPECT_LT(warm_connect_wait.InMilliseconds() * 3,
+            connect_wait.InMilliseconds());
+
+  // The learned stats match the synthetic page loads.
+  ConnectionStats stats =
+      warm_impl.GetConnectionStats(HostPortPair("news.example.org", 80));
+  EXPECT_EQ(6, stats.peak_concurrency);
+  EXPECT_GT(stats.GetIdleSocketRate(), 0.9);
+  EXPECT_GT(stats.connect_time, base::TimeDelta::FromMilliseconds(100));
+}
+
 }  // namespace
 
 }  // namespace net
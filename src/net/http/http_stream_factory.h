@@ -228,6 +228,13 @@ class NET_EXPORT HttpStreamFactory {
 
   static void SetHostMappingRules(const std::string& rules);
 
+  // Controls whether the sockets that the servers are expected to need are
+  // connected ahead of time, see HttpStreamFactoryImpl::WarmUpSockets().
+  static void set_warm_up_sockets(bool value) {
+    warm_up_sockets_ = value;
+  }
+  static bool warm_up_sockets() { return warm_up_sockets_; }
+
  protected:
   HttpStreamFactory();
 
@@ -242,6 +249,7 @@ class NET_EXPORT HttpStreamFactory {
   static bool force_spdy_always_;
   static std::list<HostPortPair>* forced_spdy_exclusions_;
   static bool ignore_certificate_errors_;
+  static bool warm_up_sockets_;
 
   DISALLOW_COPY_AND_ASSIGN(HttpStreamFactory);
 };
@@ -4,6 +4,7 @@
 
 #include "net/http/http_stream_factory_impl.h"
 
+#include "base/metrics/histogram.h"
 #include "base/string_number_conversions.h"
 #include "base/stl_util.h"
 #include "googleurl/src/gurl.h"
@@ -19,6 +20,12 @@ namespace net {
 
 namespace {
 
+// The minimum time between two warm-ups of the sockets of a server.
+const int kWarmUpIntervalSeconds = 10;
+
+// The number of servers whose last warm-up time is kept.
+const size_t kMaxWarmUpServers = 1000;
+
 GURL UpgradeUrlToHttps(const GURL& original_url, int port) {
   GURL::Replacements replacements;
   // new_sheme and new_port need to be in scope here because GURL::Replacements
@@ -56,6 +63,9 @@ HttpStreamRequest* HttpStreamFactoryImpl::RequestStream(
     const SSLConfig& proxy_ssl_config,
     HttpStreamRequest::Delegate* delegate,
     const BoundNetLog& net_log) {
+  if (HttpStreamFactory::warm_up_sockets())
+    WarmUpSockets(request_info, server_ssl_config, proxy_ssl_config, net_log);
+
   Request* request = new Request(request_info.url, this, delegate, net_log);
 
   GURL alternate_url;
@@ -113,6 +123,49 @@ void HttpStreamFactoryImpl::PreconnectStreams(
   job->Preconnect(num_streams);
 }
 
+void HttpStreamFactoryImpl::WarmUpSockets(
+    const HttpRequestInfo& request_info,
+    const SSLConfig& server_ssl_config,
+    const SSLConfig& proxy_ssl_config,
+    const BoundNetLog& net_log) {
+  HostPortPair origin(request_info.url.HostNoBrackets(),
+                      request_info.url.EffectiveIntPort());
+  ApplyHostMappingRules(request_info.url, &origin);
+
+  HttpServerProperties* http_server_properties =
+      session_->http_server_properties();
+  if (http_server_properties->SupportsSpdy(origin))
+    return;
+  ConnectionStats stats = http_server_properties->GetConnectionStats(origin);
+  // A single socket is connected by the request itself.
+  if (stats.peak_concurrency < 2)
+    return;
+
+  base::TimeTicks now = base::TimeTicks::Now();
+  std::map<HostPortPair, base::TimeTicks>::iterator it =
+      warm_up_times_.find(origin);
+  if (it != warm_up_times_.end() &&
+      now - it->second < base::TimeDelta::FromSeconds(kWarmUpIntervalSeconds)) {
+    return;
+  }
+  if (it == warm_up_times_.end() && warm_up_times_.size() >= kMaxWarmUpServers)
+    warm_up_times_.clear();
+  warm_up_times_[origin] = now;
+
+  UMA_HISTOGRAM_COUNTS_100("Net.SocketWarmUp.Sockets",
+                           stats.peak_concurrency);
+
+  HttpRequestInfo warm_up_request_info;
+  warm_up_request_info.url = request_info.url;
+  warm_up_request_info.method = "GET";
+  warm_up_request_info.extra_headers = request_info.extra_headers;
+  warm_up_request_info.load_flags = request_info.load_flags;
+  warm_up_request_info.priority = request_info.priority;
+  warm_up_request_info.motivation = HttpRequestInfo::PRECONNECT_MOTIVATED;
+  PreconnectStreams(stats.peak_concurrency, warm_up_request_info,
+                    server_ssl_config, proxy_ssl_config, net_log);
+}
+
 void HttpStreamFactoryImpl::AddTLSIntolerantServer(const HostPortPair& server) {
   tls_intolerant_servers_.insert(server);
 }
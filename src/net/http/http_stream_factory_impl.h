@@ -9,6 +9,7 @@
 #include <set>
 
 #include "base/memory/ref_counted.h"
+#include "base/time.h"
 #include "net/base/host_port_pair.h"
 #include "net/http/http_stream_factory.h"
 #include "net/base/net_log.h"
@@ -50,6 +51,15 @@ class NET_EXPORT_PRIVATE HttpStreamFactoryImpl : public HttpStreamFactory {
   bool GetAlternateProtocolRequestFor(const GURL& original_url,
                                       GURL* alternate_url) const;
 
+  // Connects ahead of time as many sockets to the server of |request_info|
+  // as it used in parallel recently, so that the requests that follow find
+  // idle sockets instead of waiting for new connections. This is done at most
+  // once every few seconds per server, and not for SPDY servers.
+  void WarmUpSockets(const HttpRequestInfo& request_info,
+                     const SSLConfig& server_ssl_config,
+                     const SSLConfig& proxy_ssl_config,
+                     const BoundNetLog& net_log);
+
   // Detaches |job| from |request|.
   void OrphanJob(Job* job, const Request* request);
 
@@ -101,6 +111,9 @@ class NET_EXPORT_PRIVATE HttpStreamFactoryImpl : public HttpStreamFactory {
   // deleted when the factory is destroyed.
   std::set<const Job*> preconnect_job_set_;
 
+  // The last time the sockets of every server were warmed up.
+  std::map<HostPortPair, base::TimeTicks> warm_up_times_;
+
   DISALLOW_COPY_AND_ASSIGN(HttpStreamFactoryImpl);
 };
 
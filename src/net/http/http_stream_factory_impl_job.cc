@@ -727,6 +727,7 @@ int HttpStreamFactoryImpl::Job::DoInitConnectionComplete(int result) {
 
   if (connection_->socket()) {
     LogHttpConnectedMetrics(*connection_);
+    RecordSocketUse();
 
     // We officially have a new connection.  Record the type.
     if (!connection_->is_reused()) {
@@ -1093,6 +1094,30 @@ void HttpStreamFactoryImpl::Job::LogHttpConnectedMetrics(
   }
 }
 
+void HttpStreamFactoryImpl::Job::RecordSocketUse() {
+  // A SPDY session multiplexes the requests on one socket.
+  if (using_spdy_)
+    return;
+
+  HttpServerProperties* http_server_properties =
+      session_->http_server_properties();
+  ClientSocketHandle::SocketReuseType reuse_type = connection_->reuse_type();
+  if (reuse_type == ClientSocketHandle::UNUSED_IDLE &&
+      HttpStreamFactory::warm_up_sockets()) {
+    // The socket may have been connected ahead of time by the warm-up, so it
+    // saved about the time it usually takes to connect to this server.
+    ConnectionStats stats = http_server_properties->GetConnectionStats(origin_);
+    if (stats.connect_time > connection_->setup_time()) {
+      UMA_HISTOGRAM_TIMES("Net.SocketWarmUp.ConnectWaitSaved",
+                          stats.connect_time - connection_->setup_time());
+    }
+  }
+
+  http_server_properties->RecordSocketUse(
+      origin_, connection_->GetActiveSocketCountInGroup(),
+      reuse_type != ClientSocketHandle::UNUSED, connection_->setup_time());
+}
+
 bool HttpStreamFactoryImpl::Job::IsPreconnecting() const {
   DCHECK_GE(num_streams_, 0);
   return num_streams_ > 0;
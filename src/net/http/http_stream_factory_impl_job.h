@@ -200,6 +200,10 @@ class HttpStreamFactoryImpl::Job {
   // Record histograms of latency until Connect() completes.
   static void LogHttpConnectedMetrics(const ClientSocketHandle& handle);
 
+  // Records how the socket of |connection_| was obtained in the server
+  // properties, from which the warm-up learns how many sockets to connect.
+  void RecordSocketUse();
+
   void HACKCrashHereToDebug80095();
 
   Request* request_;
@@ -230,6 +230,10 @@ class CapturePreconnectsSocketPool : public ParentPool {
     ADD_FAILURE();
     return 0;
   }
+  virtual int ActiveSocketCountInGroup(const std::string& group_name) const {
+    ADD_FAILURE();
+    return 0;
+  }
   virtual LoadState GetLoadState(const std::string& group_name,
                                  const ClientSocketHandle* handle) const {
     ADD_FAILURE();
@@ -268,7 +272,7 @@ template<>
 CapturePreconnectsSSLSocketPool::CapturePreconnectsSocketPool(
     HostResolver* host_resolver, CertVerifier* cert_verifier)
     : SSLClientSocketPool(0, 0, NULL, host_resolver, cert_verifier, NULL, NULL,
-                          NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL),
+                          NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL),
       last_num_streams_(-1) {}
 
 TEST(HttpStreamFactoryTest, PreconnectDirect) {
@@ -418,6 +422,53 @@ TEST(HttpStreamFactoryTest, JobNotifiesProxy) {
   EXPECT_TRUE(iter != retry_info.end());
 }
 
+TEST(HttpStreamFactoryTest, WarmUpSockets) {
+  SessionDependencies session_deps(ProxyService::CreateDirect());
+  StaticSocketDataProvider socket_data[3];
+  for (size_t i = 0; i < arraysize(socket_data); ++i) {
+    socket_data[i].set_connect_data(MockConnect(true, OK));
+    session_deps.socket_factory.AddSocketDataProvider(&socket_data[i]);
+  }
+  scoped_refptr<HttpNetworkSession> session(CreateSession(&session_deps));
+  HttpNetworkSessionPeer peer(session);
+  MockHttpStreamFactoryImpl* mock_factory =
+      new MockHttpStreamFactoryImpl(session);
+  peer.SetHttpStreamFactory(mock_factory);
+
+  // The server has been seen using up to 3 sockets in parallel.
+  HostPortPair server("www.google.com", 80);
+  HttpServerProperties* http_server_properties =
+      session->http_server_properties();
+  for (int i = 1; i <= 3; ++i) {
+    http_server_properties->RecordSocketUse(
+        server, i, false, base::TimeDelta::FromMilliseconds(50));
+  }
+
+  HttpStreamFactory::set_warm_up_sockets(true);
+  HttpRequestInfo request_info;
+  request_info.method = "GET";
+  request_info.url = GURL("http://www.google.com");
+  request_info.load_flags = 0;
+
+  SSLConfig ssl_config;
+  StreamRequestWaiter waiter;
+  scoped_ptr<HttpStreamRequest> request(
+      session->http_stream_factory()->RequestStream(request_info, ssl_config,
+                                                    ssl_config, &waiter,
+                                                    BoundNetLog()));
+  waiter.WaitForStream();
+  mock_factory->WaitForPreconnects();
+  MessageLoop::current()->RunAllPending();
+  HttpStreamFactory::set_warm_up_sockets(false);
+
+  // The request got one of the sockets, and the other two are left idle for
+  // the requests that follow.
+  TransportClientSocketPool* pool = session->transport_socket_pool();
+  EXPECT_EQ(1, pool->ActiveSocketCountInGroup(server.ToString()));
+  EXPECT_EQ(2, pool->IdleSocketCountInGroup(server.ToString()));
+  EXPECT_EQ(4, http_server_properties->GetConnectionStats(server).requests);
+}
+
 }  // namespace
 
 }  // namespace net
@@ -74,7 +74,8 @@ HttpStreamParser::HttpStreamParser(ClientSocketHandle* connection,
       response_header_start_offset_(-1),
       response_body_length_(-1),
       response_body_read_(0),
-      chunked_decoder_(NULL),
+      response_parser_(NULL),
+      chunked_(false),
       user_read_buf_(NULL),
       user_read_buf_len_(0),
       user_callback_(NULL),
@@ -473,6 +474,7 @@ int HttpStreamParser::DoReadHeadersComplete(int result) {
       // tunnel.
       io_state_ = STATE_REQUEST_SENT;
       response_header_start_offset_ = -1;
+      response_parser_.Reset();
     } else {
       io_state_ = STATE_BODY_PENDING;
       CalculateResponseBodySize();
@@ -539,9 +541,10 @@ int HttpStreamParser::DoReadBodyComplete(int result) {
     result = ERR_CONNECTION_CLOSED;
 
   // Filter incoming data if appropriate.  FilterBuf may return an error.
-  if (result > 0 && chunked_decoder_.get()) {
-    result = chunked_decoder_->FilterBuf(user_read_buf_->data(), result);
-    if (result == 0 && !chunked_decoder_->reached_eof()) {
+  if (result > 0 && chunked_) {
+    result = response_parser_.FilterChunkedBody(user_read_buf_->data(),
+                                                result);
+    if (result == 0 && !response_parser_.IsChunkedBodyComplete()) {
       // Don't signal completion of the Read call yet or else it'll look like
       // we received end-of-file.  Wait for more data.
       io_state_ = STATE_READ_BODY;
@@ -562,8 +565,8 @@ int HttpStreamParser::DoReadBodyComplete(int result) {
     // start first.
     int additional_save_amount = read_buf_->offset() - read_buf_unused_offset_;
     int save_amount = 0;
-    if (chunked_decoder_.get()) {
-      save_amount = chunked_decoder_->bytes_after_eof();
+    if (chunked_) {
+      save_amount = response_parser_.bytes_after_body();
     } else if (response_body_length_ >= 0) {
       int64 extra_data_read = response_body_read_ - response_body_length_;
       if (extra_data_read > 0) {
@@ -610,7 +613,7 @@ int HttpStreamParser::ParseResponseHeaders() {
   }
 
   if (response_header_start_offset_ >= 0) {
-    end_offset = HttpUtil::LocateEndOfHeaders(
+    end_offset = response_parser_.FindEndOfHeaders(
         read_buf_->StartOfBuffer() + read_buf_unused_offset_,
         read_buf_->offset() - read_buf_unused_offset_,
         response_header_start_offset_);
@@ -701,7 +704,7 @@ void HttpStreamParser::CalculateResponseBodySize() {
     // "Content-Length: N"
     if (response_->headers->GetHttpVersion() >= HttpVersion(1, 1) &&
         response_->headers->HasHeaderValue("Transfer-Encoding", "chunked")) {
-      chunked_decoder_.reset(new HttpChunkedDecoder());
+      chunked_ = true;
     } else {
       response_body_length_ = response_->headers->GetContentLength();
       // If response_body_length_ is still -1, then we have to wait
@@ -722,8 +725,8 @@ HttpResponseInfo* HttpStreamParser::GetResponseInfo() {
 }
 
 bool HttpStreamParser::IsResponseBodyComplete() const {
-  if (chunked_decoder_.get())
-    return chunked_decoder_->reached_eof();
+  if (chunked_)
+    return response_parser_.IsChunkedBodyComplete();
   if (response_body_length_ != -1)
     return response_body_read_ >= response_body_length_;
 
@@ -731,7 +734,7 @@ bool HttpStreamParser::IsResponseBodyComplete() const {
 }
 
 bool HttpStreamParser::CanFindEndOfResponse() const {
-  return chunked_decoder_.get() || response_body_length_ >= 0;
+  return chunked_ || response_body_length_ >= 0;
 }
 
 bool HttpStreamParser::IsMoreDataBuffered() const {
@@ -12,7 +12,7 @@
 #include "net/base/completion_callback.h"
 #include "net/base/net_log.h"
 #include "net/base/upload_data_stream.h"
-#include "net/http/http_chunked_decoder.h"
+#include "net/http/http_parser.h"
 
 namespace net {
 
@@ -159,15 +159,19 @@ class HttpStreamParser  : public ChunkCallback {
   HttpResponseInfo* response_;
 
   // Indicates the content length.  If this value is less than zero
-  // (and chunked_decoder_ is null), then we must read until the server
+  // (and the body is not chunked), then we must read until the server
   // closes the connection.
   int64 response_body_length_;
 
   // Keep track of the number of response body bytes read so far.
   int64 response_body_read_;
 
-  // Helper if the data is chunked.
-  scoped_ptr<HttpChunkedDecoder> chunked_decoder_;
+  // Finds the end of the response headers without rescanning the data that
+  // has already been read, and decodes the body if it is chunked.
+  HttpParser response_parser_;
+
+  // True if the response body uses the chunked transfer coding.
+  bool chunked_;
 
   // Where the caller wants the body data.
   scoped_refptr<IOBuffer> user_read_buf_;
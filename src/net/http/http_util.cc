@@ -15,6 +15,7 @@
 #include "base/string_number_conversions.h"
 #include "base/string_piece.h"
 #include "base/string_util.h"
+#include "net/http/http_parser.h"
 
 using std::string;
 
@@ -391,10 +392,6 @@ bool HttpUtil::IsNonCoalescingHeader(string::const_iterator name_begin,
   return false;
 }
 
-bool HttpUtil::IsLWS(char c) {
-  return strchr(HTTP_LWS, c) != NULL;
-}
-
 void HttpUtil::TrimLWS(string::const_iterator* begin,
                        string::const_iterator* end) {
   // leading whitespace
@@ -492,110 +489,54 @@ int HttpUtil::LocateStartOfStatusLine(const char* buf, int buf_len) {
 }
 
 int HttpUtil::LocateEndOfHeaders(const char* buf, int buf_len, int i) {
-  bool was_lf = false;
-  char last_c = '\0';
-  for (; i < buf_len; ++i) {
-    char c = buf[i];
-    if (c == '\n') {
-      if (was_lf)
-        return i + 1;
-      was_lf = true;
-    } else if (c != '\r' || last_c != '\n') {
-      was_lf = false;
-    }
-    last_c = c;
-  }
-  return -1;
+  HttpParser parser(NULL);
+  return parser.FindEndOfHeaders(buf, buf_len, i);
 }
 
-// In order for a line to be continuable, it must specify a
-// non-blank header-name. Line continuations are specifically for
-// header values -- do not allow headers names to span lines.
-static bool IsLineSegmentContinuable(const char* begin, const char* end) {
-  if (begin == end)
-    return false;
+namespace {
 
-  const char* colon = std::find(begin, end, ':');
-  if (colon == end)
-    return false;
+// Builds the "raw headers" from the lines reported by HttpParser. Every line
+// is terminated by a '\n', and continuations are joined to the previous line
+// with a single SP.
+class RawHeadersBuilder : public HttpParser::Visitor {
+ public:
+  explicit RawHeadersBuilder(std::string* raw_headers)
+      : raw_headers_(raw_headers) {}
 
-  const char* name_begin = begin;
-  const char* name_end = colon;
+  virtual void OnStartLine(const base::StringPiece& line) {
+    line.AppendToString(raw_headers_);
+  }
 
-  // Name can't be empty.
-  if (name_begin == name_end)
-    return false;
+  virtual void OnHeaderLine(const base::StringPiece& line,
+                            const base::StringPiece& name,
+                            const base::StringPiece& value) {
+    raw_headers_->push_back('\n');
+    line.AppendToString(raw_headers_);
+  }
 
-  // Can't start with LWS (this would imply the segment is a continuation)
-  if (HttpUtil::IsLWS(*name_begin))
-    return false;
+  virtual void OnHeaderContinuation(const base::StringPiece& value) {
+    raw_headers_->push_back(' ');
+    value.AppendToString(raw_headers_);
+  }
 
-  return true;
-}
+ private:
+  std::string* raw_headers_;
 
-// Helper used by AssembleRawHeaders, to find the end of the status line.
-static const char* FindStatusLineEnd(const char* begin, const char* end) {
-  size_t i = base::StringPiece(begin, end - begin).find_first_of("\r\n");
-  if (i == base::StringPiece::npos)
-    return end;
-  return begin + i;
-}
+  DISALLOW_COPY_AND_ASSIGN(RawHeadersBuilder);
+};
 
-// Helper used by AssembleRawHeaders, to skip past leading LWS.
-static const char* FindFirstNonLWS(const char* begin, const char* end) {
-  for (const char* cur = begin; cur != end; ++cur) {
-    if (!HttpUtil::IsLWS(*cur))
-      return cur;
-  }
-  return end;  // Not found.
-}
+}  // namespace
 
 std::string HttpUtil::AssembleRawHeaders(const char* input_begin,
                                          int input_len) {
   std::string raw_headers;
   raw_headers.reserve(input_len);
 
-  const char* input_end = input_begin + input_len;
-
-  // Skip any leading slop, since the consumers of this output
+  // HttpParser skips any leading slop, since the consumers of this output
   // (HttpResponseHeaders) don't deal with it.
-  int status_begin_offset = LocateStartOfStatusLine(input_begin, input_len);
-  if (status_begin_offset != -1)
-    input_begin += status_begin_offset;
-
-  // Copy the status line.
-  const char* status_line_end = FindStatusLineEnd(input_begin, input_end);
-  raw_headers.append(input_begin, status_line_end);
-
-  // After the status line, every subsequent line is a header line segment.
-  // Should a segment start with LWS, it is a continuation of the previous
-  // line's field-value.
-
-  // TODO(ericroman): is this too permissive? (delimits on [\r\n]+)
-  CStringTokenizer lines(status_line_end, input_end, "\r\n");
-
-  // This variable is true when the previous line was continuable.
-  bool prev_line_continuable = false;
-
-  while (lines.GetNext()) {
-    const char* line_begin = lines.token_begin();
-    const char* line_end = lines.token_end();
-
-    if (prev_line_continuable && IsLWS(*line_begin)) {
-      // Join continuation; reduce the leading LWS to a single SP.
-      raw_headers.push_back(' ');
-      raw_headers.append(FindFirstNonLWS(line_begin, line_end), line_end);
-    } else {
-      // Terminate the previous line.
-      raw_headers.push_back('\n');
-
-      // Copy the raw data to output.
-      raw_headers.append(line_begin, line_end);
-
-      // Check if the current line can be continued.
-      prev_line_continuable = IsLineSegmentContinuable(line_begin, line_end);
-    }
-  }
+  RawHeadersBuilder builder(&raw_headers);
+  HttpParser parser(&builder);
+  parser.ParseHeaders(input_begin, input_len);
 
   raw_headers.append("\n\n", 2);
 
@@ -94,7 +94,9 @@ class NET_EXPORT HttpUtil {
   // Return true if the character is HTTP "linear white space" (SP | HT).
   // This definition corresponds with the HTTP_LWS macro, and does not match
   // newlines.
-  static bool IsLWS(char c);
+  static bool IsLWS(char c) {
+    return c == ' ' || c == '\t';
+  }
 
   // Trim HTTP_LWS chars from the beginning and end of the string.
   static void TrimLWS(std::string::const_iterator* begin,
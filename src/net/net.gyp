@@ -156,6 +156,8 @@
         'base/net_log.cc',
         'base/net_log.h',
         'base/net_log_event_type_list.h',
+        'base/net_log_flight_recorder.cc',
+        'base/net_log_flight_recorder.h',
         'base/net_log_source_type_list.h',
         'base/net_module.cc',
         'base/net_module.h',
@@ -299,6 +301,8 @@
         'disk_cache/net_log_parameters.h',
         'disk_cache/rankings.cc',
         'disk_cache/rankings.h',
+        'disk_cache/sharded_backend.cc',
+        'disk_cache/sharded_backend.h',
         'disk_cache/sparse_control.cc',
         'disk_cache/sparse_control.h',
         'disk_cache/stats.cc',
@@ -400,8 +404,6 @@
         'http/http_cache.h',
         'http/http_cache_transaction.cc',
         'http/http_cache_transaction.h',
-        'http/http_chunked_decoder.cc',
-        'http/http_chunked_decoder.h',
         'http/http_mac_signature.cc',
         'http/http_mac_signature.h',
         'http/http_net_log_params.cc',
@@ -414,6 +416,8 @@
         'http/http_network_session_peer.h',
         'http/http_network_transaction.cc',
         'http/http_network_transaction.h',
+        'http/http_parser.cc',
+        'http/http_parser.h',
         'http/http_proxy_client_socket.cc',
         'http/http_proxy_client_socket.h',
         'http/http_proxy_client_socket_pool.cc',
@@ -569,6 +573,8 @@
         'socket/ssl_server_socket_nss.cc',
         'socket/ssl_server_socket_nss.h',
         'socket/ssl_server_socket_openssl.cc',
+        'socket/ssl_session_cache.cc',
+        'socket/ssl_session_cache.h',
         'socket/stream_socket.cc',
         'socket/stream_socket.h',
         'socket/tcp_client_socket.cc',
@@ -960,6 +966,7 @@
         'base/mime_util_unittest.cc',
         'base/mock_filter_context.cc',
         'base/mock_filter_context.h',
+        'base/net_log_flight_recorder_unittest.cc',
         'base/net_log_unittest.cc',
         'base/net_log_unittest.h',
         'base/net_util_unittest.cc',
@@ -992,6 +999,7 @@
         'disk_cache/disk_cache_test_base.h',
         'disk_cache/entry_unittest.cc',
         'disk_cache/mapped_file_unittest.cc',
+        'disk_cache/sharded_backend_unittest.cc',
         'disk_cache/storage_block_unittest.cc',
         'dns/async_host_resolver_unittest.cc',
         'dns/dns_config_service_posix_unittest.cc',
@@ -1029,10 +1037,10 @@
         'http/http_auth_unittest.cc',
         'http/http_byte_range_unittest.cc',
         'http/http_cache_unittest.cc',
-        'http/http_chunked_decoder_unittest.cc',
         'http/http_mac_signature_unittest.cc',
         'http/http_network_layer_unittest.cc',
         'http/http_network_transaction_unittest.cc',
+        'http/http_parser_unittest.cc',
         'http/http_proxy_client_socket_pool_unittest.cc',
         'http/http_request_headers_unittest.cc',
         'http/http_response_body_drainer_unittest.cc',
@@ -1075,6 +1083,7 @@
         'socket/ssl_client_socket_unittest.cc',
         'socket/ssl_client_socket_pool_unittest.cc',
         'socket/ssl_server_socket_unittest.cc',
+        'socket/ssl_session_cache_unittest.cc',
         'socket/tcp_client_socket_unittest.cc',
         'socket/tcp_server_socket_unittest.cc',
         'socket/transport_client_socket_pool_unittest.cc',
@@ -1213,8 +1222,15 @@
       ],
       'sources': [
         'base/cookie_monster_perftest.cc',
+        'base/gzip_filter_perftest.cc',
+        'base/net_log_perftest.cc',
         'disk_cache/disk_cache_perftest.cc',
+        'http/http_cache_perftest.cc',
+        'http/http_response_headers_perftest.cc',
+        'http/http_transaction_unittest.cc',
+        'http/http_transaction_unittest.h',
         'proxy/proxy_resolver_perftest.cc',
+        'spdy/spdy_framer_perftest.cc',
       ],
       'conditions': [
         # This is needed to trigger the dll copy step on windows.
@@ -1251,6 +1267,18 @@
         'tools/tld_cleanup/tld_cleanup.cc',
       ],
     },
+    {
+      'target_name': 'cache_replay',
+      'type': 'executable',
+      'dependencies': [
+        'net',
+        'net_test_support',
+        '../base/base.gyp:base',
+      ],
+      'sources': [
+        'tools/cache_replay/cache_replay.cc',
+      ],
+    },
     {
       'target_name': 'crash_cache',
       'type': 'executable',
@@ -1526,6 +1554,73 @@
              'tools/flip_server/string_piece_utils.h',
            ],
          },
+         {
+           'target_name': 'flip_send_benchmark',
+           'type': 'executable',
+           'cflags': [
+             '-Wno-deprecated',
+           ],
+           'dependencies': [
+             '../base/base.gyp:base',
+             'net',
+             '../third_party/openssl/openssl.gyp:openssl',
+           ],
+           'sources': [
+             'tools/dump_cache/url_to_filename_encoder.cc',
+             'tools/dump_cache/url_utilities.cc',
+             'tools/flip_server/acceptor_thread.cc',
+             'tools/flip_server/balsa_frame.cc',
+             'tools/flip_server/balsa_headers.cc',
+             'tools/flip_server/balsa_headers_token_utils.cc',
+             'tools/flip_server/create_listener.cc',
+             'tools/flip_server/epoll_server.cc',
+             'tools/flip_server/flip_config.cc',
+             'tools/flip_server/flip_send_benchmark.cc',
+             'tools/flip_server/http_interface.cc',
+             'tools/flip_server/http_message_constants.cc',
+             'tools/flip_server/mem_cache.cc',
+             'tools/flip_server/output_ordering.cc',
+             'tools/flip_server/ring_buffer.cc',
+             'tools/flip_server/simple_buffer.cc',
+             'tools/flip_server/sm_connection.cc',
+             'tools/flip_server/split.cc',
+             'tools/flip_server/spdy_ssl.cc',
+             'tools/flip_server/spdy_interface.cc',
+             'tools/flip_server/spdy_util.cc',
+             'tools/flip_server/streamer_interface.cc',
+           ],
+         },
+         {
+           'target_name': 'dns_benchmark',
+           'type': 'executable',
+           'dependencies': [
+             '../base/base.gyp:base',
+             'net',
+           ],
+           'sources': [
+             'tools/dns_benchmark/dns_benchmark.cc',
+           ],
+         },
+         {
+           'target_name': 'http_parser_benchmark',
+           'type': 'executable',
+           'cflags': [
+             '-Wno-deprecated',
+           ],
+           'dependencies': [
+             '../base/base.gyp:base',
+             'net',
+           ],
+           'sources': [
+             'tools/flip_server/balsa_frame.cc',
+             'tools/flip_server/balsa_headers.cc',
+             'tools/flip_server/balsa_headers_token_utils.cc',
+             'tools/flip_server/http_message_constants.cc',
+             'tools/flip_server/http_parser_benchmark.cc',
+             'tools/flip_server/simple_buffer.cc',
+             'tools/flip_server/split.cc',
+           ],
+         },
          {
            'target_name': 'curvecp',
            'type': 'static_library',
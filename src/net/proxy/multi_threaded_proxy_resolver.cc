@@ -65,6 +65,8 @@ class MultiThreadedProxyResolver::Executor
 
   ProxyResolver* resolver() { return resolver_.get(); }
 
+  MultiThreadedProxyResolver* coordinator() { return coordinator_; }
+
   int thread_number() const { return thread_number_; }
 
  private:
@@ -271,6 +273,7 @@ class MultiThreadedProxyResolver::GetProxyForURLJob
     if (!was_cancelled()) {
       if (result_code >= OK) {  // Note: unit-tests use values > 0.
         results_->Use(results_buf_);
+        executor()->coordinator()->OnProxyResolved(url_, results_buf_);
       }
       RunUserCallback(result_code);
     }
@@ -405,6 +408,17 @@ int MultiThreadedProxyResolver::GetProxyForURL(const GURL& url,
   DCHECK(current_script_data_.get())
       << "Resolver is un-initialized. Must call SetPacScript() first!";
 
+  if (result_cache_.get()) {
+    ResultCache::iterator it = result_cache_->Get(GetResultCacheKey(url));
+    if (it != result_cache_->end()) {
+      if (it->second.expiration > base::TimeTicks::Now()) {
+        results->Use(it->second.results);
+        return OK;
+      }
+      result_cache_->Erase(it);
+    }
+  }
+
   scoped_refptr<GetProxyForURLJob> job(
       new GetProxyForURLJob(url, results, callback, net_log));
 
@@ -473,6 +487,8 @@ void MultiThreadedProxyResolver::CancelSetPacScript() {
 
 void MultiThreadedProxyResolver::PurgeMemory() {
   DCHECK(CalledOnValidThread());
+  if (result_cache_.get())
+    result_cache_->Clear();
   for (ExecutorList::iterator it = executors_.begin();
        it != executors_.end(); ++it) {
     Executor* executor = *it;
@@ -489,6 +505,10 @@ int MultiThreadedProxyResolver::SetPacScript(
   // Save the script details, so we can provision new executors later.
   current_script_data_ = script_data;
 
+  // The results of the previous script are meaningless.
+  if (result_cache_.get())
+    result_cache_->Clear();
+
   // The user should not have any outstanding requests when they call
   // SetPacScript().
   CheckNoOutstandingUserRequests();
@@ -503,6 +523,35 @@ int MultiThreadedProxyResolver::SetPacScript(
   return ERR_IO_PENDING;
 }
 
+void MultiThreadedProxyResolver::EnableResultCache(size_t max_entries,
+                                                   base::TimeDelta ttl) {
+  DCHECK(CalledOnValidThread());
+  DCHECK_GT(max_entries, 0u);
+  result_cache_.reset(new ResultCache(max_entries));
+  result_cache_ttl_ = ttl;
+}
+
+// static
+std::string MultiThreadedProxyResolver::GetResultCacheKey(const GURL& url) {
+  // GetOrigin() is empty for the schemes without a host.
+  return url.GetOrigin().spec();
+}
+
+void MultiThreadedProxyResolver::OnProxyResolved(const GURL& url,
+                                                 const ProxyInfo& results) {
+  DCHECK(CalledOnValidThread());
+  if (!result_cache_.get())
+    return;
+
+  std::string key = GetResultCacheKey(url);
+  if (key.empty())
+    return;
+  CachedResult cached_result;
+  cached_result.results.Use(results);
+  cached_result.expiration = base::TimeTicks::Now() + result_cache_ttl_;
+  result_cache_->Put(key, cached_result);
+}
+
 void MultiThreadedProxyResolver::CheckNoOutstandingUserRequests() const {
   DCHECK(CalledOnValidThread());
   CHECK_EQ(0u, pending_jobs_.size());
@@ -7,13 +7,17 @@
 #pragma once
 
 #include <deque>
+#include <string>
 #include <vector>
 
 #include "base/basictypes.h"
+#include "base/memory/mru_cache.h"
 #include "base/memory/ref_counted.h"
 #include "base/memory/scoped_ptr.h"
 #include "base/threading/non_thread_safe.h"
+#include "base/time.h"
 #include "net/base/net_export.h"
+#include "net/proxy/proxy_info.h"
 #include "net/proxy/proxy_resolver.h"
 
 namespace base {
@@ -72,6 +76,9 @@ class ProxyResolverFactory {
 //     a global counter and using that to make a decision. In the
 //     multi-threaded model, each thread may have a different value for this
 //     counter, so it won't globally be seen as monotonically increasing!
+//
+// Optionally, the results can be cached by origin (see EnableResultCache()),
+// so that the script only runs for the first request to every server.
 class NET_EXPORT_PRIVATE MultiThreadedProxyResolver
     : public ProxyResolver,
       NON_EXPORTED_BASE(public base::NonThreadSafe) {
@@ -91,6 +98,14 @@ class NET_EXPORT_PRIVATE MultiThreadedProxyResolver
 
   virtual ~MultiThreadedProxyResolver();
 
+  // Caches up to |max_entries| results of the PAC script for |ttl|, keyed by
+  // the origin (scheme, host and port) of the URL, and completes the requests
+  // that hit the cache synchronously. Like the proxy result cache of Internet
+  // Explorer, this assumes that the script doesn't depend on the path of the
+  // URL (or changes its mind faster than |ttl|). The cache is emptied when a
+  // new PAC script is set, which is also what happens on network changes.
+  void EnableResultCache(size_t max_entries, base::TimeDelta ttl);
+
   // ProxyResolver implementation:
   virtual int GetProxyForURL(const GURL& url,
                              ProxyInfo* results,
@@ -114,6 +129,20 @@ class NET_EXPORT_PRIVATE MultiThreadedProxyResolver
   typedef std::deque<scoped_refptr<Job> > PendingJobsQueue;
   typedef std::vector<scoped_refptr<Executor> > ExecutorList;
 
+  struct CachedResult {
+    ProxyInfo results;
+    base::TimeTicks expiration;
+  };
+  typedef base::MRUCache<std::string, CachedResult> ResultCache;
+
+  // Returns the key of |url| in |result_cache_|, or an empty string if the
+  // results for |url| can't be cached.
+  static std::string GetResultCacheKey(const GURL& url);
+
+  // Called by the GetProxyForURL jobs that succeeded, with the |results| of
+  // the PAC script for |url|.
+  void OnProxyResolved(const GURL& url, const ProxyInfo& results);
+
   // Asserts that there are no outstanding user-initiated jobs on any of the
   // worker threads.
   void CheckNoOutstandingUserRequests() const;
@@ -136,6 +165,10 @@ class NET_EXPORT_PRIVATE MultiThreadedProxyResolver
   PendingJobsQueue pending_jobs_;
   ExecutorList executors_;
   scoped_refptr<ProxyResolverScriptData> current_script_data_;
+
+  // NULL unless EnableResultCache() was called.
+  scoped_ptr<ResultCache> result_cache_;
+  base::TimeDelta result_cache_ttl_;
 };
 
 }  // namespace net
@@ -325,6 +325,64 @@ TEST(MultiThreadedProxyResolverTest, SingleThread_Basic) {
   EXPECT_EQ(1, mock->purge_count());
 }
 
+// Tests that the results are cached by origin, until the PAC script changes.
+TEST(MultiThreadedProxyResolverTest, SingleThread_ResultCache) {
+  const size_t kNumThreads = 1u;
+  scoped_ptr<MockProxyResolver> mock(new MockProxyResolver);
+  MultiThreadedProxyResolver resolver(
+      new ForwardingProxyResolverFactory(mock.get()), kNumThreads);
+  resolver.EnableResultCache(10, base::TimeDelta::FromMinutes(5));
+
+  TestOldCompletionCallback set_script_callback;
+  int rv = resolver.SetPacScript(
+      ProxyResolverScriptData::FromUTF8("pac script bytes"),
+      &set_script_callback);
+  EXPECT_EQ(ERR_IO_PENDING, rv);
+  EXPECT_EQ(OK, set_script_callback.WaitForResult());
+
+  // The first request for an origin runs the script.
+  TestOldCompletionCallback callback0;
+  ProxyInfo results0;
+  rv = resolver.GetProxyForURL(
+      GURL("http://request0/a"), &results0, &callback0, NULL, BoundNetLog());
+  EXPECT_EQ(ERR_IO_PENDING, rv);
+  EXPECT_EQ(0, callback0.WaitForResult());
+  EXPECT_EQ("PROXY request0:80", results0.ToPacString());
+
+  // The next ones complete synchronously, whatever their path.
+  TestOldCompletionCallback callback1;
+  ProxyInfo results1;
+  rv = resolver.GetProxyForURL(
+      GURL("http://request0/b"), &results1, &callback1, NULL, BoundNetLog());
+  EXPECT_EQ(OK, rv);
+  EXPECT_EQ("PROXY request0:80", results1.ToPacString());
+
+  // Another port is another origin.
+  TestOldCompletionCallback callback2;
+  ProxyInfo results2;
+  rv = resolver.GetProxyForURL(
+      GURL("http://request0:8080/a"), &results2, &callback2, NULL,
+      BoundNetLog());
+  EXPECT_EQ(ERR_IO_PENDING, rv);
+  EXPECT_EQ(1, callback2.WaitForResult());
+
+  // Setting a new script invalidates the results.
+  rv = resolver.SetPacScript(
+      ProxyResolverScriptData::FromUTF8("new pac script bytes"),
+      &set_script_callback);
+  EXPECT_EQ(ERR_IO_PENDING, rv);
+  EXPECT_EQ(OK, set_script_callback.WaitForResult());
+
+  TestOldCompletionCallback callback3;
+  ProxyInfo results3;
+  rv = resolver.GetProxyForURL(
+      GURL("http://request0/a"), &results3, &callback3, NULL, BoundNetLog());
+  EXPECT_EQ(ERR_IO_PENDING, rv);
+  EXPECT_EQ(2, callback3.WaitForResult());
+  EXPECT_EQ("PROXY request0:80", results3.ToPacString());
+  EXPECT_EQ(3, mock->request_count());
+}
+
 // Tests that the NetLog is updated to include the time the request was waiting
 // to be scheduled to a thread.
 TEST(MultiThreadedProxyResolverTest,
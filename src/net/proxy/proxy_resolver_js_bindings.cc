@@ -6,6 +6,7 @@
 
 #include "base/compiler_specific.h"
 #include "base/logging.h"
+#include "base/memory/mru_cache.h"
 #include "base/string_util.h"
 #include "base/values.h"
 #include "net/base/address_list.h"
@@ -23,6 +24,12 @@ namespace net {
 
 namespace {
 
+// The successful resolves are remembered across requests for a short time,
+// since PAC scripts typically call dnsResolve() and myIpAddress() for every
+// URL, with the same few hosts.
+const size_t kMaxDnsMemoEntries = 100;
+const int kDnsMemoTTLSeconds = 60;
+
 // Event parameters for a PAC error message (line number + message).
 class ErrorNetlogParams : public NetLog::EventParameters {
  public:
@@ -72,7 +79,8 @@ class DefaultJSBindings : public ProxyResolverJSBindings {
                     ProxyResolverErrorObserver* error_observer)
       : host_resolver_(host_resolver),
         net_log_(net_log),
-        error_observer_(error_observer) {
+        error_observer_(error_observer),
+        dns_memo_(kMaxDnsMemoEntries) {
   }
 
   // Handler for "alert(message)".
@@ -166,6 +174,12 @@ class DefaultJSBindings : public ProxyResolverJSBindings {
   }
 
  private:
+  struct DnsMemoEntry {
+    AddressList addrlist;
+    base::TimeTicks expiration;
+  };
+  typedef base::MRUCache<HostCache::Key, DnsMemoEntry> DnsMemo;
+
   bool MyIpAddressImpl(std::string* first_ip_address) {
     std::string my_hostname = GetHostName();
     if (my_hostname.empty())
@@ -234,7 +248,7 @@ class DefaultJSBindings : public ProxyResolverJSBindings {
   }
 
   // Helper to execute a synchronous DNS resolve, using the per-request
-  // DNS cache if there is one.
+  // DNS cache if there is one, then the results of the previous requests.
   int DnsResolveHelper(const HostResolver::RequestInfo& info,
                        AddressList* address_list) {
     HostCache::Key cache_key(info.hostname(),
@@ -257,9 +271,31 @@ class DefaultJSBindings : public ProxyResolverJSBindings {
       }
     }
 
+    base::TimeTicks now = base::TimeTicks::Now();
+    DnsMemo::iterator it = dns_memo_.Get(cache_key);
+    if (it != dns_memo_.end()) {
+      if (it->second.expiration > now) {
+        *address_list = it->second.addrlist;
+        if (host_cache)
+          host_cache->Set(cache_key, OK, *address_list, now);
+        return OK;
+      }
+      dns_memo_.Erase(it);
+    }
+
     // Otherwise ask the host resolver.
     int result = host_resolver_->Resolve(info, address_list);
 
+    // Failures are not remembered across requests, since they are often
+    // transient.
+    if (result == OK) {
+      DnsMemoEntry entry;
+      entry.addrlist = *address_list;
+      entry.expiration =
+          now + base::TimeDelta::FromSeconds(kDnsMemoTTLSeconds);
+      dns_memo_.Put(cache_key, entry);
+    }
+
     // Save the result back to the per-request DNS cache.
     if (host_cache) {
       host_cache->Set(cache_key, result, *address_list,
@@ -296,6 +332,12 @@ class DefaultJSBindings : public ProxyResolverJSBindings {
   scoped_ptr<SyncHostResolver> host_resolver_;
   NetLog* net_log_;
   scoped_ptr<ProxyResolverErrorObserver> error_observer_;
+
+  // The successful resolves of the previous requests. The bindings of a
+  // resolver are only used on its thread, and they are recreated with the
+  // resolver when the network changes.
+  DnsMemo dns_memo_;
+
   DISALLOW_COPY_AND_ASSIGN(DefaultJSBindings);
 };
 
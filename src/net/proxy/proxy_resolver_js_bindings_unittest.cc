@@ -92,12 +92,13 @@ class MockFailingHostResolver : public SyncHostResolver {
 
 class MockSyncHostResolver : public SyncHostResolver {
  public:
-  MockSyncHostResolver() {
+  MockSyncHostResolver() : count_(0) {
     resolver_.set_synchronous_mode(true);
   }
 
   virtual int Resolve(const HostResolver::RequestInfo& info,
                       AddressList* addresses) OVERRIDE {
+    count_++;
     return resolver_.Resolve(info, addresses, NULL, NULL, BoundNetLog());
   }
 
@@ -107,8 +108,12 @@ class MockSyncHostResolver : public SyncHostResolver {
     return resolver_.rules();
   }
 
+  // Returns the number of times Resolve() has been called.
+  int count() const { return count_; }
+
  private:
   MockHostResolver resolver_;
+  int count_;
 };
 
 TEST(ProxyResolverJSBindingsTest, DnsResolve) {
@@ -284,6 +289,36 @@ TEST(ProxyResolverJSBindingsTest, PerRequestDNSCache) {
   bindings->set_current_request_context(NULL);
 }
 
+// Tests that the successful resolves are remembered across requests.
+TEST(ProxyResolverJSBindingsTest, DnsMemo) {
+  MockSyncHostResolver* host_resolver = new MockSyncHostResolver;
+
+  // Get a hold of a DefaultJSBindings* (it is a hidden impl class).
+  scoped_ptr<ProxyResolverJSBindings> bindings(
+      ProxyResolverJSBindings::CreateDefault(host_resolver, NULL, NULL));
+
+  host_resolver->rules()->AddRule("foo", "192.168.1.1");
+  std::string ip_address;
+
+  // No request context: every call is a separate request.
+  EXPECT_TRUE(bindings->DnsResolve("foo", &ip_address));
+  EXPECT_EQ("192.168.1.1", ip_address);
+  EXPECT_TRUE(bindings->DnsResolve("foo", &ip_address));
+  EXPECT_EQ("192.168.1.1", ip_address);
+  EXPECT_EQ(1, host_resolver->count());
+
+  EXPECT_TRUE(bindings->MyIpAddress(&ip_address));
+  EXPECT_TRUE(bindings->MyIpAddress(&ip_address));
+  EXPECT_EQ("127.0.0.1", ip_address);
+  EXPECT_EQ(2, host_resolver->count());
+
+  // The "Ex" version uses a different address family.
+  EXPECT_TRUE(bindings->DnsResolveEx("foo", &ip_address));
+  EXPECT_EQ(3, host_resolver->count());
+  EXPECT_TRUE(bindings->DnsResolveEx("foo", &ip_address));
+  EXPECT_EQ(3, host_resolver->count());
+}
+
 // Test that when a binding is called, it logs to the per-request NetLog.
 TEST(ProxyResolverJSBindingsTest, NetLog) {
   MockFailingHostResolver* host_resolver = new MockFailingHostResolver;
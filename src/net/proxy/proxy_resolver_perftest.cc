@@ -5,11 +5,15 @@
 #include "base/base_paths.h"
 #include "base/compiler_specific.h"
 #include "base/file_util.h"
+#include "base/message_loop.h"
 #include "base/path_service.h"
 #include "base/perftimer.h"
 #include "base/string_util.h"
+#include "base/stringprintf.h"
 #include "net/base/mock_host_resolver.h"
 #include "net/base/net_errors.h"
+#include "net/base/test_completion_callback.h"
+#include "net/proxy/multi_threaded_proxy_resolver.h"
 #include "net/proxy/proxy_info.h"
 #include "net/proxy/proxy_resolver_js_bindings.h"
 #include "net/proxy/proxy_resolver_v8.h"
@@ -202,6 +206,86 @@ TEST(ProxyResolverPerfTest, ProxyResolverMac) {
 }
 #endif
 
+// The number of rules of the generated PAC script, which is about 200KB like
+// the scripts of some large corporate networks.
+const int kNumLargeScriptRules = 1400;
+
+// The number of distinct hosts queried with the generated PAC script.
+const int kNumLargeScriptHosts = 20;
+
+class LargeScriptProxyResolverFactory : public net::ProxyResolverFactory {
+ public:
+  LargeScriptProxyResolverFactory() : net::ProxyResolverFactory(true) {}
+
+  virtual net::ProxyResolver* CreateProxyResolver() OVERRIDE {
+    return new net::ProxyResolverV8(
+        net::ProxyResolverJSBindings::CreateDefault(
+            new MockSyncHostResolver, NULL, NULL));
+  }
+};
+
+// Returns a PAC script that matches the host against |kNumLargeScriptRules|
+// domains, one after the other.
+std::string GenerateLargePacScript() {
+  std::string script = "function FindProxyForURL(url, host) {\n";
+  for (int i = 0; i < kNumLargeScriptRules; ++i) {
+    base::StringAppendF(
+        &script,
+        "  if (dnsDomainIs(host, \".domain%d.example.com\") ||\n"
+        "      shExpMatch(url, \"*/domain%d/*\"))\n"
+        "    return \"PROXY proxy%d.example.com:8080\";\n",
+        i, i, i);
+  }
+  script += "  return \"DIRECT\";\n}\n";
+  return script;
+}
+
+// Measures the number of calls per second through MultiThreadedProxyResolver
+// with a large PAC script, with and without the result cache. The queried
+// hosts are spread over the rules, so that an average query runs through
+// half of the script.
+void RunLargeScriptTest(bool enable_result_cache) {
+  MessageLoop message_loop;
+  net::MultiThreadedProxyResolver resolver(
+      new LargeScriptProxyResolverFactory, 1);
+  if (enable_result_cache)
+    resolver.EnableResultCache(1000, base::TimeDelta::FromMinutes(5));
+
+  TestOldCompletionCallback set_script_callback;
+  int rv = resolver.SetPacScript(
+      net::ProxyResolverScriptData::FromUTF8(GenerateLargePacScript()),
+      &set_script_callback);
+  ASSERT_EQ(net::OK, set_script_callback.GetResult(rv));
+
+  std::string test_name = enable_result_cache ?
+      "MultiThreadedProxyResolver_large.pac_cached" :
+      "MultiThreadedProxyResolver_large.pac";
+  PerfTimer timer;
+
+  for (int i = 0; i < kNumIterations; ++i) {
+    int rule = (i % kNumLargeScriptHosts) *
+        (kNumLargeScriptRules / kNumLargeScriptHosts);
+    GURL url(base::StringPrintf("http://www.domain%d.example.com/%d",
+                                rule, i));
+
+    net::ProxyInfo proxy_info;
+    TestOldCompletionCallback callback;
+    rv = resolver.GetProxyForURL(url, &proxy_info, &callback, NULL,
+                                 net::BoundNetLog());
+    ASSERT_EQ(net::OK, callback.GetResult(rv));
+    ASSERT_EQ(base::StringPrintf("PROXY proxy%d.example.com:8080", rule),
+              proxy_info.ToPacString());
+  }
+
+  LogPerfResult(test_name.c_str(),
+                kNumIterations / timer.Elapsed().InSecondsF(), "calls/s");
+}
+
+TEST(ProxyResolverPerfTest, MultiThreadedProxyResolverLargeScript) {
+  RunLargeScriptTest(false);
+  RunLargeScriptTest(true);
+}
+
 TEST(ProxyResolverPerfTest, ProxyResolverV8) {
   net::ProxyResolverJSBindings* js_bindings =
       net::ProxyResolverJSBindings::CreateDefault(
@@ -48,6 +48,11 @@ namespace {
 const size_t kMaxNumNetLogEntries = 100;
 const size_t kDefaultNumPacThreads = 4;
 
+// When requested, the results of the PAC script are cached by origin for a few
+// minutes (see MultiThreadedProxyResolver::EnableResultCache()).
+const size_t kMaxNumCachedPacResults = 1000;
+const int kCachedPacResultTTLMinutes = 5;
+
 // When the IP address changes we don't immediately re-run proxy auto-config.
 // Instead, we  wait for |kNumMillisToStallAfterNetworkChanges| before
 // attempting to re-valuate proxy auto-config.
@@ -436,6 +441,7 @@ ProxyService::ProxyService(ProxyConfigService* config_service,
 ProxyService* ProxyService::CreateUsingV8ProxyResolver(
     ProxyConfigService* proxy_config_service,
     size_t num_pac_threads,
+    bool cache_pac_results,
     ProxyScriptFetcher* proxy_script_fetcher,
     DhcpProxyScriptFetcher* dhcp_proxy_script_fetcher,
     HostResolver* host_resolver,
@@ -457,8 +463,13 @@ ProxyService* ProxyService::CreateUsingV8ProxyResolver(
           net_log,
           network_delegate);
 
-  ProxyResolver* proxy_resolver =
+  MultiThreadedProxyResolver* proxy_resolver =
       new MultiThreadedProxyResolver(sync_resolver_factory, num_pac_threads);
+  if (cache_pac_results) {
+    proxy_resolver->EnableResultCache(
+        kMaxNumCachedPacResults,
+        base::TimeDelta::FromMinutes(kCachedPacResultTTLMinutes));
+  }
 
   ProxyService* proxy_service =
       new ProxyService(proxy_config_service, proxy_resolver, net_log);
@@ -178,6 +178,11 @@ class NET_EXPORT ProxyService : public NetworkChangeNotifier::IPAddressObserver,
   // should use for any DNS queries. It must remain valid throughout the
   // lifetime of the ProxyService.
   //
+  // If |cache_pac_results| is true, the results of the PAC script are cached
+  // by origin for a few minutes (see
+  // MultiThreadedProxyResolver::EnableResultCache()). This is only correct
+  // for PAC scripts that don't look at the path of the URL.
+  //
   // ##########################################################################
   // # See the warnings in net/proxy/proxy_resolver_v8.h describing the
   // # multi-threading model. In order for this to be safe to use, *ALL* the
@@ -186,6 +191,7 @@ class NET_EXPORT ProxyService : public NetworkChangeNotifier::IPAddressObserver,
   static ProxyService* CreateUsingV8ProxyResolver(
       ProxyConfigService* proxy_config_service,
       size_t num_pac_threads,
+      bool cache_pac_results,
       ProxyScriptFetcher* proxy_script_fetcher,
       DhcpProxyScriptFetcher* dhcp_proxy_script_fetcher,
       HostResolver* host_resolver,
@@ -72,6 +72,12 @@ LoadState ClientSocketHandle::GetLoadState() const {
   return pool_->GetLoadState(group_name_, this);
 }
 
+int ClientSocketHandle::GetActiveSocketCountInGroup() const {
+  if (!pool_)
+    return 0;
+  return pool_->ActiveSocketCountInGroup(group_name_);
+}
+
 void ClientSocketHandle::OnIOComplete(int result) {
   OldCompletionCallback* callback = user_callback_;
   user_callback_ = NULL;
@@ -92,6 +92,10 @@ class NET_EXPORT ClientSocketHandle {
   // initialized the ClientSocketHandle.
   LoadState GetLoadState() const;
 
+  // Returns the number of sockets of the pool group of this handle that are
+  // handed out, including its own once it is initialized.
+  int GetActiveSocketCountInGroup() const;
+
   // Returns true when Init() has completed successfully.
   bool is_initialized() const { return is_initialized_; }
 
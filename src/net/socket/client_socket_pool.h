@@ -119,6 +119,11 @@ class NET_EXPORT ClientSocketPool {
   // The total number of idle sockets in a connection group.
   virtual int IdleSocketCountInGroup(const std::string& group_name) const = 0;
 
+  // The number of sockets of a connection group that are handed out to
+  // clients.
+  virtual int ActiveSocketCountInGroup(
+      const std::string& group_name) const = 0;
+
   // Determine the LoadState of a connecting ClientSocketHandle.
   virtual LoadState GetLoadState(const std::string& group_name,
                                  const ClientSocketHandle* handle) const = 0;
@@ -273,6 +273,10 @@ class NET_EXPORT_PRIVATE ClientSocketPoolBaseHelper
   // function.
   int IdleSocketCountInGroup(const std::string& group_name) const;
 
+  // See ClientSocketPool::ActiveSocketCountInGroup() for documentation on this
+  // function.
+  int ActiveSocketCountInGroup(const std::string& group_name) const;
+
   // See ClientSocketPool::GetLoadState() for documentation on this function.
   LoadState GetLoadState(const std::string& group_name,
                          const ClientSocketHandle* handle) const;
@@ -684,6 +688,10 @@ class ClientSocketPoolBase {
     return helper_.IdleSocketCountInGroup(group_name);
   }
 
+  int ActiveSocketCountInGroup(const std::string& group_name) const {
+    return helper_.ActiveSocketCountInGroup(group_name);
+  }
+
   LoadState GetLoadState(const std::string& group_name,
                          const ClientSocketHandle* handle) const {
     return helper_.GetLoadState(group_name, handle);
@@ -455,6 +455,10 @@ class TestClientSocketPool : public ClientSocketPool {
     return base_.IdleSocketCountInGroup(group_name);
   }
 
+  virtual int ActiveSocketCountInGroup(const std::string& group_name) const {
+    return base_.ActiveSocketCountInGroup(group_name);
+  }
+
   virtual LoadState GetLoadState(const std::string& group_name,
                                  const ClientSocketHandle* handle) const {
     return base_.GetLoadState(group_name, handle);
@@ -261,6 +261,7 @@ ClientSocketPoolManager::ClientSocketPoolManager(
     DnsRRResolver* dnsrr_resolver,
     DnsCertProvenanceChecker* dns_cert_checker,
     SSLHostInfoFactory* ssl_host_info_factory,
+    SSLSessionCache* ssl_session_cache,
     ProxyService* proxy_service,
     SSLConfigService* ssl_config_service)
     : net_log_(net_log),
@@ -271,6 +272,7 @@ ClientSocketPoolManager::ClientSocketPoolManager(
       dnsrr_resolver_(dnsrr_resolver),
       dns_cert_checker_(dns_cert_checker),
       ssl_host_info_factory_(ssl_host_info_factory),
+      ssl_session_cache_(ssl_session_cache),
       proxy_service_(proxy_service),
       ssl_config_service_(ssl_config_service),
       transport_pool_histograms_("TCP"),
@@ -290,6 +292,7 @@ ClientSocketPoolManager::ClientSocketPoolManager(
           dnsrr_resolver,
           dns_cert_checker,
           ssl_host_info_factory,
+          ssl_session_cache,
           socket_factory,
           transport_socket_pool_.get(),
           NULL /* no socks proxy */,
@@ -495,6 +498,7 @@ HttpProxyClientSocketPool* ClientSocketPoolManager::GetSocketPoolForHTTPProxy(
                   dnsrr_resolver_,
                   dns_cert_checker_,
                   ssl_host_info_factory_,
+                  ssl_session_cache_,
                   socket_factory_,
                   tcp_https_ret.first->second /* https proxy */,
                   NULL /* no socks proxy */,
@@ -533,6 +537,7 @@ SSLClientSocketPool* ClientSocketPoolManager::GetSocketPoolForSSLWithProxy(
       dnsrr_resolver_,
       dns_cert_checker_,
       ssl_host_info_factory_,
+      ssl_session_cache_,
       socket_factory_,
       NULL, /* no tcp pool, we always go through a proxy */
       GetSocketPoolForSOCKSProxy(proxy_server),
@@ -51,6 +51,7 @@ class SOCKSClientSocketPool;
 class SSLClientSocketPool;
 class SSLConfigService;
 class SSLHostInfoFactory;
+class SSLSessionCache;
 class TransportClientSocketPool;
 
 struct SSLConfig;
@@ -88,6 +89,7 @@ class ClientSocketPoolManager : public base::NonThreadSafe,
                           DnsRRResolver* dnsrr_resolver,
                           DnsCertProvenanceChecker* dns_cert_checker,
                           SSLHostInfoFactory* ssl_host_info_factory,
+                          SSLSessionCache* ssl_session_cache,
                           ProxyService* proxy_service,
                           SSLConfigService* ssl_config_service);
   virtual ~ClientSocketPoolManager();
@@ -195,6 +197,7 @@ class ClientSocketPoolManager : public base::NonThreadSafe,
   DnsRRResolver* const dnsrr_resolver_;
   DnsCertProvenanceChecker* const dns_cert_checker_;
   SSLHostInfoFactory* const ssl_host_info_factory_;
+  SSLSessionCache* const ssl_session_cache_;
   ProxyService* const proxy_service_;
   const scoped_refptr<SSLConfigService> ssl_config_service_;
 
@@ -259,6 +259,11 @@ int SOCKSClientSocketPool::IdleSocketCountInGroup(
   return base_.IdleSocketCountInGroup(group_name);
 }
 
+int SOCKSClientSocketPool::ActiveSocketCountInGroup(
+    const std::string& group_name) const {
+  return base_.ActiveSocketCountInGroup(group_name);
+}
+
 LoadState SOCKSClientSocketPool::GetLoadState(
     const std::string& group_name, const ClientSocketHandle* handle) const {
   return base_.GetLoadState(group_name, handle);
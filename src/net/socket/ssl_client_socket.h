@@ -27,6 +27,7 @@ class SSLCertRequestInfo;
 class SSLHostInfo;
 class SSLHostInfoFactory;
 class SSLInfo;
+class SSLSessionCache;
 struct RRResponse;
 
 // DNSSECProvider is an interface to an object that can return DNSSEC data.
@@ -53,24 +54,30 @@ struct SSLClientSocketContext {
         origin_bound_cert_service(NULL),
         dnsrr_resolver(NULL),
         dns_cert_checker(NULL),
-        ssl_host_info_factory(NULL) {}
+        ssl_host_info_factory(NULL),
+        ssl_session_cache(NULL) {}
 
   SSLClientSocketContext(CertVerifier* cert_verifier_arg,
                          OriginBoundCertService* origin_bound_cert_service_arg,
                          DnsRRResolver* dnsrr_resolver_arg,
                          DnsCertProvenanceChecker* dns_cert_checker_arg,
-                         SSLHostInfoFactory* ssl_host_info_factory_arg)
+                         SSLHostInfoFactory* ssl_host_info_factory_arg,
+                         SSLSessionCache* ssl_session_cache_arg)
       : cert_verifier(cert_verifier_arg),
         origin_bound_cert_service(origin_bound_cert_service_arg),
         dnsrr_resolver(dnsrr_resolver_arg),
         dns_cert_checker(dns_cert_checker_arg),
-        ssl_host_info_factory(ssl_host_info_factory_arg) {}
+        ssl_host_info_factory(ssl_host_info_factory_arg),
+        ssl_session_cache(ssl_session_cache_arg) {}
 
   CertVerifier* cert_verifier;
   OriginBoundCertService* origin_bound_cert_service;
   DnsRRResolver* dnsrr_resolver;
   DnsCertProvenanceChecker* dns_cert_checker;
   SSLHostInfoFactory* ssl_host_info_factory;
+  // May be NULL, in which case the sessions are only cached by the SSL
+  // library, in memory.
+  SSLSessionCache* ssl_session_cache;
 };
 
 // A client socket that uses SSL as the transport layer.
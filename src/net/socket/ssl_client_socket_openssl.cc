@@ -22,6 +22,7 @@
 #include "net/base/ssl_connection_status_flags.h"
 #include "net/base/ssl_info.h"
 #include "net/socket/ssl_error_params.h"
+#include "net/socket/ssl_session_cache.h"
 
 namespace net {
 
@@ -200,9 +201,9 @@ int NoOpVerifyCallback(X509_STORE_CTX*, void *) {
 // OpenSSL manages a cache of SSL_SESSION, this class provides the application
 // side policy for that cache about session re-use: we retain one session per
 // unique HostPortPair.
-class SSLSessionCache {
+class OpenSSLSessionCache {
  public:
-  SSLSessionCache() {}
+  OpenSSLSessionCache() {}
 
   void OnSessionAdded(const HostPortPair& host_and_port, SSL_SESSION* session) {
     // Declare the session cleaner-upper before the lock, so any call into
@@ -277,14 +278,14 @@ class SSLSessionCache {
   // Protects access to both the above maps.
   base::Lock lock_;
 
-  DISALLOW_COPY_AND_ASSIGN(SSLSessionCache);
+  DISALLOW_COPY_AND_ASSIGN(OpenSSLSessionCache);
 };
 
 class SSLContext {
  public:
   static SSLContext* GetInstance() { return Singleton<SSLContext>::get(); }
   SSL_CTX* ssl_ctx() { return ssl_ctx_.get(); }
-  SSLSessionCache* session_cache() { return &session_cache_; }
+  OpenSSLSessionCache* session_cache() { return &session_cache_; }
 
   SSLClientSocketOpenSSL* GetClientSocketFromSSL(SSL* ssl) {
     DCHECK(ssl);
@@ -329,6 +330,7 @@ class SSLContext {
   int NewSessionCallback(SSL* ssl, SSL_SESSION* session) {
     SSLClientSocketOpenSSL* socket = GetClientSocketFromSSL(ssl);
     session_cache_.OnSessionAdded(socket->host_and_port(), session);
+    socket->OnNewSession(session);
     return 1;  // 1 => We took ownership of |session|.
   }
 
@@ -360,7 +362,7 @@ class SSLContext {
   int ssl_socket_data_index_;
 
   crypto::ScopedOpenSSL<SSL_CTX, SSL_CTX_free> ssl_ctx_;
-  SSLSessionCache session_cache_;
+  OpenSSLSessionCache session_cache_;
 };
 
 // Utility to construct the appropriate set & clear masks for use the OpenSSL
@@ -400,6 +402,7 @@ SSLClientSocketOpenSSL::SSLClientSocketOpenSSL(
       transport_(transport_socket),
       host_and_port_(host_and_port),
       ssl_config_(ssl_config),
+      ssl_session_cache_(context.ssl_session_cache),
       trying_cached_session_(false),
       npn_status_(kNextProtoUnsupported),
       net_log_(transport_socket->socket()->NetLog()) {
@@ -423,8 +426,26 @@ bool SSLClientSocketOpenSSL::Init() {
   if (!SSL_set_tlsext_host_name(ssl_, host_and_port_.host().c_str()))
     return false;
 
-  trying_cached_session_ =
-      context->session_cache()->SetSSLSession(ssl_, host_and_port_);
+  // The shared cache, when there is one, has the last word on the sessions:
+  // it survives restarts, and sessions removed from it (for example when the
+  // user clears the browsing data) must not be resumed.
+  if (ssl_session_cache_) {
+    std::string session_data;
+    if (ssl_session_cache_->Lookup(host_and_port_, &session_data)) {
+      const unsigned char* p =
+          reinterpret_cast<const unsigned char*>(session_data.data());
+      crypto::ScopedOpenSSL<SSL_SESSION, SSL_SESSION_free> session(
+          d2i_SSL_SESSION(NULL, &p, session_data.size()));
+      if (session.get()) {
+        trying_cached_session_ = SSL_set_session(ssl_, session.get()) == 1;
+      } else {
+        ssl_session_cache_->Remove(host_and_port_);
+      }
+    }
+  } else {
+    trying_cached_session_ =
+        context->session_cache()->SetSSLSession(ssl_, host_and_port_);
+  }
 
   BIO* ssl_bio = NULL;
   // 0 => use default buffer sizes.
@@ -548,6 +569,21 @@ int SSLClientSocketOpenSSL::ClientCertRequestCallback(SSL* ssl,
   return 0;
 }
 
+void SSLClientSocketOpenSSL::OnNewSession(SSL_SESSION* session) {
+  if (!ssl_session_cache_)
+    return;
+
+  int len = i2d_SSL_SESSION(session, NULL);
+  if (len <= 0)
+    return;
+  std::string session_data(len, '\0');
+  unsigned char* p = reinterpret_cast<unsigned char*>(&session_data[0]);
+  i2d_SSL_SESSION(session, &p);
+  base::Time expiration = base::Time::FromTimeT(
+      SSL_SESSION_get_time(session) + SSL_SESSION_get_timeout(session));
+  ssl_session_cache_->Insert(host_and_port_, session_data, expiration);
+}
+
 // SSLClientSocket methods
 
 void SSLClientSocketOpenSSL::GetSSLInfo(SSLInfo* ssl_info) {
@@ -563,6 +599,8 @@ void SSLClientSocketOpenSSL::GetSSLInfo(SSLInfo* ssl_info) {
     server_cert_verify_result_.public_key_hashes;
   ssl_info->client_cert_sent =
       ssl_config_.send_client_cert && ssl_config_.client_cert;
+  ssl_info->handshake_type = SSL_session_reused(ssl_) ?
+      SSLInfo::HANDSHAKE_RESUME : SSLInfo::HANDSHAKE_FULL;
 
   const SSL_CIPHER* cipher = SSL_get_current_cipher(ssl_);
   CHECK(cipher);
@@ -751,8 +789,14 @@ int SSLClientSocketOpenSSL::DoHandshake() {
         int rv = SSL_CTX_remove_session(SSL_get_SSL_CTX(ssl_), session);
         LOG_IF(WARNING, !rv) << "Couldn't invalidate SSL session: " << session;
       }
+      if (ssl_session_cache_)
+        ssl_session_cache_->Remove(host_and_port_);
     }
   } else if (rv == 1) {
+    if (trying_cached_session_) {
+      UMA_HISTOGRAM_BOOLEAN("Net.SSLSessionCache.SessionResumed",
+                            !!SSL_session_reused(ssl_));
+    }
     if (trying_cached_session_ && logging::DEBUG_MODE) {
       DVLOG(2) << "Result of session reuse for " << host_and_port_.ToString()
                << " is: " << (SSL_session_reused(ssl_) ? "Success" : "Fail");
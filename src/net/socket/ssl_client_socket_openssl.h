@@ -19,6 +19,7 @@
 typedef struct bio_st BIO;
 typedef struct evp_pkey_st EVP_PKEY;
 typedef struct ssl_st SSL;
+typedef struct ssl_session_st SSL_SESSION;
 typedef struct x509_st X509;
 
 namespace net {
@@ -28,6 +29,7 @@ class SingleRequestCertVerifier;
 class SSLCertRequestInfo;
 class SSLConfig;
 class SSLInfo;
+class SSLSessionCache;
 
 // An SSL client socket implemented with OpenSSL.
 class SSLClientSocketOpenSSL : public SSLClientSocket {
@@ -48,6 +50,10 @@ class SSLClientSocketOpenSSL : public SSLClientSocket {
   // a certificate for this client.
   int ClientCertRequestCallback(SSL* ssl, X509** x509, EVP_PKEY** pkey);
 
+  // Callback from the SSL layer when a new session has been negotiated with
+  // the server, which can be resumed by the next connections.
+  void OnNewSession(SSL_SESSION* session);
+
   // Callback from the SSL layer to check which NPN protocol we are supporting
   int SelectNextProtoCallback(unsigned char** out, unsigned char* outlen,
                               const unsigned char* in, unsigned int inlen);
@@ -151,6 +157,10 @@ class SSLClientSocketOpenSSL : public SSLClientSocket {
   const HostPortPair host_and_port_;
   SSLConfig ssl_config_;
 
+  // The sessions shared with the other sockets of the HttpNetworkSession,
+  // which outlive the process. May be NULL.
+  SSLSessionCache* const ssl_session_cache_;
+
   // Used for session cache diagnostics.
   bool trying_cached_session_;
 
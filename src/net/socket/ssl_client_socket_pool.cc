@@ -449,6 +449,7 @@ SSLClientSocketPool::SSLClientSocketPool(
     DnsRRResolver* dnsrr_resolver,
     DnsCertProvenanceChecker* dns_cert_checker,
     SSLHostInfoFactory* ssl_host_info_factory,
+    SSLSessionCache* ssl_session_cache,
     ClientSocketFactory* client_socket_factory,
     TransportClientSocketPool* transport_pool,
     SOCKSClientSocketPool* socks_pool,
@@ -471,7 +472,8 @@ SSLClientSocketPool::SSLClientSocketPool(
                                          origin_bound_cert_service,
                                          dnsrr_resolver,
                                          dns_cert_checker,
-                                         ssl_host_info_factory),
+                                         ssl_host_info_factory,
+                                         ssl_session_cache),
                                      net_log)),
       ssl_config_service_(ssl_config_service) {
   if (ssl_config_service_)
@@ -544,6 +546,11 @@ int SSLClientSocketPool::IdleSocketCountInGroup(
   return base_.IdleSocketCountInGroup(group_name);
 }
 
+int SSLClientSocketPool::ActiveSocketCountInGroup(
+    const std::string& group_name) const {
+  return base_.ActiveSocketCountInGroup(group_name);
+}
+
 LoadState SSLClientSocketPool::GetLoadState(
     const std::string& group_name, const ClientSocketHandle* handle) const {
   return base_.GetLoadState(group_name, handle);
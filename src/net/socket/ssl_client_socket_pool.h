@@ -34,6 +34,7 @@ class SOCKSClientSocketPool;
 class SOCKSSocketParams;
 class SSLClientSocket;
 class SSLHostInfoFactory;
+class SSLSessionCache;
 class TransportSocketParams;
 class TransportClientSocketPool;
 struct RRResponse;
@@ -182,6 +183,7 @@ class NET_EXPORT_PRIVATE SSLClientSocketPool
       DnsRRResolver* dnsrr_resolver,
       DnsCertProvenanceChecker* dns_cert_checker,
       SSLHostInfoFactory* ssl_host_info_factory,
+      SSLSessionCache* ssl_session_cache,
       ClientSocketFactory* client_socket_factory,
       TransportClientSocketPool* transport_pool,
       SOCKSClientSocketPool* socks_pool,
@@ -219,6 +221,8 @@ class NET_EXPORT_PRIVATE SSLClientSocketPool
 
   virtual int IdleSocketCountInGroup(const std::string& group_name) const;
 
+  virtual int ActiveSocketCountInGroup(const std::string& group_name) const;
+
   virtual LoadState GetLoadState(const std::string& group_name,
                                  const ClientSocketHandle* handle) const;
 
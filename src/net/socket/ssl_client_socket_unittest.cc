@@ -12,10 +12,12 @@
 #include "net/base/net_log_unittest.h"
 #include "net/base/net_errors.h"
 #include "net/base/ssl_config_service.h"
+#include "net/base/ssl_info.h"
 #include "net/base/test_completion_callback.h"
 #include "net/socket/client_socket_factory.h"
 #include "net/socket/client_socket_handle.h"
 #include "net/socket/socket_test_util.h"
+#include "net/socket/ssl_session_cache.h"
 #include "net/socket/tcp_client_socket.h"
 #include "net/test/test_server.h"
 #include "testing/gtest/include/gtest/gtest.h"
@@ -749,3 +751,77 @@ TEST_F(SSLClientSocketTest, ClientSocketHandleNotFromPool) {
     rv = callback.WaitForResult();
   EXPECT_EQ(net::OK, rv);
 }
+
+#if defined(USE_OPENSSL)
+// Only the OpenSSL sockets can restore the sessions of an SSLSessionCache.
+class SSLClientSocketSessionCacheTest : public SSLClientSocketTest {
+ protected:
+  // Connects to |test_server| with |session_cache| and returns the type of
+  // the handshake.
+  net::SSLInfo::HandshakeType Connect(const net::TestServer& test_server,
+                                      net::SSLSessionCache* session_cache) {
+    net::AddressList addr;
+    EXPECT_TRUE(test_server.GetAddressList(&addr));
+
+    TestOldCompletionCallback callback;
+    net::StreamSocket* transport = new net::TCPClientSocket(
+        addr, NULL, net::NetLog::Source());
+    int rv = transport->Connect(&callback);
+    if (rv == net::ERR_IO_PENDING)
+      rv = callback.WaitForResult();
+    EXPECT_EQ(net::OK, rv);
+
+    net::SSLClientSocketContext context;
+    context.cert_verifier = cert_verifier_.get();
+    context.ssl_session_cache = session_cache;
+    scoped_ptr<net::SSLClientSocket> sock(
+        socket_factory_->CreateSSLClientSocket(
+            transport, test_server.host_port_pair(), kDefaultSSLConfig,
+            NULL, context));
+    rv = sock->Connect(&callback);
+    if (rv == net::ERR_IO_PENDING)
+      rv = callback.WaitForResult();
+    EXPECT_EQ(net::OK, rv);
+
+    net::SSLInfo ssl_info;
+    sock->GetSSLInfo(&ssl_info);
+    return ssl_info.handshake_type;
+  }
+};
+
+TEST_F(SSLClientSocketSessionCacheTest, ResumeSession) {
+  net::TestServer test_server(net::TestServer::TYPE_HTTPS, FilePath());
+  ASSERT_TRUE(test_server.Start());
+
+  net::SSLSessionCache session_cache(NULL);
+  EXPECT_EQ(net::SSLInfo::HANDSHAKE_FULL, Connect(test_server, &session_cache));
+  EXPECT_EQ(1u, session_cache.size());
+  EXPECT_EQ(net::SSLInfo::HANDSHAKE_RESUME,
+            Connect(test_server, &session_cache));
+
+  // Sessions removed from the cache aren't resumed.
+  session_cache.Clear();
+  EXPECT_EQ(net::SSLInfo::HANDSHAKE_FULL, Connect(test_server, &session_cache));
+}
+
+TEST_F(SSLClientSocketSessionCacheTest, ResumeRestoredSession) {
+  net::TestServer test_server(net::TestServer::TYPE_HTTPS, FilePath());
+  ASSERT_TRUE(test_server.Start());
+
+  std::string session_data;
+  {
+    net::SSLSessionCache session_cache(NULL);
+    EXPECT_EQ(net::SSLInfo::HANDSHAKE_FULL,
+              Connect(test_server, &session_cache));
+    ASSERT_TRUE(session_cache.Lookup(test_server.host_port_pair(),
+                                     &session_data));
+  }
+
+  // Like after a restart, the serialized session is all there is.
+  net::SSLSessionCache session_cache(NULL);
+  session_cache.Insert(test_server.host_port_pair(), session_data,
+                       base::Time::Now() + base::TimeDelta::FromHours(1));
+  EXPECT_EQ(net::SSLInfo::HANDSHAKE_RESUME,
+            Connect(test_server, &session_cache));
+}
+#endif  // defined(USE_OPENSSL)
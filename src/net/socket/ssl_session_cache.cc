@@ -0,0 +1,210 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/socket/ssl_session_cache.h"
+
+#include "base/bind.h"
+#include "base/logging.h"
+#include "base/memory/scoped_ptr.h"
+#include "base/message_loop.h"
+#include "base/metrics/histogram.h"
+
+namespace net {
+
+// static
+const size_t SSLSessionCache::kMaxSessions = 1000;
+
+SSLSessionCache::SSLSessionCache(PersistentStore* store)
+    : initialized_(false),
+      loaded_(false),
+      cleared_while_loading_(false),
+      store_(store),
+      sessions_(SessionMap::NO_AUTO_EVICT),
+      ALLOW_THIS_IN_INITIALIZER_LIST(weak_factory_(this)) {
+}
+
+SSLSessionCache::~SSLSessionCache() {
+  base::AutoLock autolock(lock_);
+  for (SessionMap::iterator it = sessions_.begin(); it != sessions_.end();
+       ++it) {
+    delete it->second;
+  }
+}
+
+bool SSLSessionCache::Lookup(const HostPortPair& host_and_port,
+                             std::string* session_data) {
+  base::AutoLock autolock(lock_);
+  InitIfNecessary();
+
+  // Waiting for the stored sessions would block the caller on the disk, so
+  // connections made before they are loaded do a full handshake.
+  if (!loaded_) {
+    UMA_HISTOGRAM_BOOLEAN("Net.SSLSessionCache.Hit", false);
+    return false;
+  }
+
+  SessionMap::iterator it = sessions_.Get(host_and_port);
+  if (it != sessions_.end() && it->second->expiration() <= base::Time::Now()) {
+    InternalErase(it);
+    it = sessions_.end();
+  }
+  UMA_HISTOGRAM_BOOLEAN("Net.SSLSessionCache.Hit", it != sessions_.end());
+  if (it == sessions_.end())
+    return false;
+
+  *session_data = it->second->data();
+  return true;
+}
+
+void SSLSessionCache::Insert(const HostPortPair& host_and_port,
+                             const std::string& session_data,
+                             base::Time expiration) {
+  base::AutoLock autolock(lock_);
+  InitIfNecessary();
+
+  if (!loaded_)
+    changed_while_loading_.insert(host_and_port);
+  SessionMap::iterator it = sessions_.Peek(host_and_port);
+  if (it != sessions_.end())
+    InternalErase(it);
+  InternalInsert(new Session(host_and_port, session_data, expiration), false);
+}
+
+void SSLSessionCache::Remove(const HostPortPair& host_and_port) {
+  base::AutoLock autolock(lock_);
+  InitIfNecessary();
+
+  if (!loaded_)
+    changed_while_loading_.insert(host_and_port);
+  SessionMap::iterator it = sessions_.Peek(host_and_port);
+  if (it != sessions_.end())
+    InternalErase(it);
+}
+
+void SSLSessionCache::Clear() {
+  base::AutoLock autolock(lock_);
+  InitIfNecessary();
+
+  if (!loaded_)
+    cleared_while_loading_ = true;
+  SessionMap::iterator it = sessions_.begin();
+  while (it != sessions_.end())
+    it = InternalErase(it);
+}
+
+size_t SSLSessionCache::size() {
+  base::AutoLock autolock(lock_);
+  InitIfNecessary();
+
+  return sessions_.size();
+}
+
+void SSLSessionCache::FlushStore(Task* completion_task) {
+  base::AutoLock autolock(lock_);
+
+  if (initialized_ && store_)
+    store_->Flush(completion_task);
+  else if (completion_task)
+    MessageLoop::current()->PostTask(FROM_HERE, completion_task);
+}
+
+void SSLSessionCache::InitIfNecessary() {
+  lock_.AssertAcquired();
+  if (initialized_)
+    return;
+  initialized_ = true;
+  if (!store_) {
+    loaded_ = true;
+    return;
+  }
+
+  // The store calls back asynchronously, so it is fine to hold the lock.
+  store_->Load(base::Bind(&SSLSessionCache::OnLoaded,
+                          weak_factory_.GetWeakPtr()));
+}
+
+// static
+void SSLSessionCache::OnLoaded(base::WeakPtr<SSLSessionCache> cache,
+                               const std::vector<Session*>& sessions) {
+  if (cache) {
+    cache->StoreLoadedSessions(sessions);
+    return;
+  }
+  for (size_t i = 0; i < sessions.size(); ++i)
+    delete sessions[i];
+}
+
+void SSLSessionCache::StoreLoadedSessions(
+    const std::vector<Session*>& sessions) {
+  base::AutoLock autolock(lock_);
+  DCHECK(initialized_);
+  DCHECK(!loaded_);
+
+  // The sessions are loaded in no particular order, so the expired ones are
+  // dropped and the rest are considered equally recent. They are older than
+  // the ones inserted in the meantime, which are already in the store.
+  base::Time now = base::Time::Now();
+  size_t num_loaded = 0;
+  for (std::vector<Session*>::const_iterator it = sessions.begin();
+       it != sessions.end(); ++it) {
+    scoped_ptr<Session> session(*it);
+    const HostPortPair& host_and_port = session->host_and_port();
+    if (sessions_.Peek(host_and_port) != sessions_.end())
+      continue;
+    if (session->expiration() <= now || cleared_while_loading_ ||
+        changed_while_loading_.count(host_and_port) ||
+        sessions_.size() >= kMaxSessions) {
+      store_->DeleteSession(*session);
+      continue;
+    }
+    InternalInsert(session.release(), true);
+    ++num_loaded;
+  }
+
+  loaded_ = true;
+  changed_while_loading_.clear();
+  cleared_while_loading_ = false;
+  UMA_HISTOGRAM_COUNTS_10000("Net.SSLSessionCache.LoadedSessions", num_loaded);
+}
+
+SSLSessionCache::SessionMap::iterator SSLSessionCache::InternalErase(
+    SessionMap::iterator it) {
+  lock_.AssertAcquired();
+
+  Session* session = it->second;
+  if (store_)
+    store_->DeleteSession(*session);
+  delete session;
+  return sessions_.Erase(it);
+}
+
+void SSLSessionCache::InternalInsert(Session* session, bool from_store) {
+  lock_.AssertAcquired();
+  DCHECK(sessions_.Peek(session->host_and_port()) == sessions_.end());
+
+  while (sessions_.size() >= kMaxSessions) {
+    SessionMap::iterator oldest = sessions_.end();
+    --oldest;
+    InternalErase(oldest);
+  }
+  if (store_ && !from_store)
+    store_->AddSession(*session);
+  sessions_.Put(session->host_and_port(), session);
+}
+
+SSLSessionCache::Session::Session() {}
+
+SSLSessionCache::Session::Session(const HostPortPair& host_and_port,
+                                  const std::string& data,
+                                  base::Time expiration)
+    : host_and_port_(host_and_port),
+      data_(data),
+      expiration_(expiration) {
+}
+
+SSLSessionCache::Session::~Session() {}
+
+SSLSessionCache::PersistentStore::PersistentStore() {}
+
+}  // namespace net
@@ -0,0 +1,189 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef NET_SOCKET_SSL_SESSION_CACHE_H_
+#define NET_SOCKET_SSL_SESSION_CACHE_H_
+#pragma once
+
+#include <set>
+#include <string>
+#include <vector>
+
+#include "base/basictypes.h"
+#include "base/callback.h"
+#include "base/memory/mru_cache.h"
+#include "base/memory/ref_counted.h"
+#include "base/memory/weak_ptr.h"
+#include "base/synchronization/lock.h"
+#include "base/time.h"
+#include "net/base/host_port_pair.h"
+#include "net/base/net_export.h"
+
+class Task;
+
+namespace net {
+
+// SSLSessionCache keeps the TLS session of every server recently connected
+// to, keyed by host:port, so that the next connections to the server can
+// resume it with an abbreviated handshake. It is shared by all the
+// SSLClientSocketPools of an HttpNetworkSession.
+//
+// The sessions are opaque: they are serialized and restored by the
+// SSLClientSocket implementation. Modelled after the CookieMonster class,
+// the cache synchronizes the sessions to an optional permanent storage that
+// implements the PersistentStore interface, so that they survive restarts.
+// The stored sessions are loaded in the background on first use; until they
+// are, lookups miss.
+//
+// This class can be accessed by multiple threads.
+class NET_EXPORT SSLSessionCache {
+ public:
+  class Session;
+  class PersistentStore;
+
+  // The maximum number of sessions kept; the least recently used ones are
+  // evicted first.
+  static const size_t kMaxSessions;
+
+  // The store passed in should not have had Init() called on it yet. This
+  // class will take care of initializing it. If |store| is NULL, then no
+  // backing store will be updated.
+  explicit SSLSessionCache(PersistentStore* store);
+  ~SSLSessionCache();
+
+  // Copies the session of |host_and_port| to |session_data| and returns true
+  // if there is one that hasn't expired.
+  bool Lookup(const HostPortPair& host_and_port, std::string* session_data);
+
+  // Replaces the session of |host_and_port| by |session_data|, which can be
+  // resumed until |expiration|.
+  void Insert(const HostPortPair& host_and_port,
+              const std::string& session_data,
+              base::Time expiration);
+
+  // Removes the session of |host_and_port|, for example because the server
+  // requested a client certificate.
+  void Remove(const HostPortPair& host_and_port);
+
+  // Removes all the sessions, including the ones in the backing store.
+  void Clear();
+
+  // Returns the number of sessions.
+  size_t size();
+
+  // Flush the backing store (if any) to disk and post the given task when done.
+  // WARNING: THE CALLBACK WILL RUN ON A RANDOM THREAD. IT MUST BE THREAD SAFE.
+  void FlushStore(Task* completion_task);
+
+ private:
+  typedef base::MRUCache<HostPortPair, Session*> SessionMap;
+
+  // Called by all non-static functions to ensure that the sessions are being
+  // loaded from the backing store. This is not done during creation so it
+  // doesn't block the startup.
+  // Note: this method should always be called with lock_ held.
+  void InitIfNecessary();
+
+  // Called when the backing store has loaded |sessions|. Takes ownership of
+  // them, and deletes them if |cache| is gone.
+  static void OnLoaded(base::WeakPtr<SSLSessionCache> cache,
+                       const std::vector<Session*>& sessions);
+
+  // Adds the |sessions| loaded from the backing store, except the ones that
+  // are out of date.
+  void StoreLoadedSessions(const std::vector<Session*>& sessions);
+
+  // Removes the session that |it| points to from the memory and from
+  // |store_|. Returns the next iterator.
+  SessionMap::iterator InternalErase(SessionMap::iterator it);
+
+  // Takes ownership of |session| and adds it to the memory, and to |store_|
+  // unless |from_store| is true. Evicts the least recently used session if
+  // there are too many.
+  void InternalInsert(Session* session, bool from_store);
+
+  // True once the sessions were requested from |store_|.
+  bool initialized_;
+
+  // True once the sessions of |store_| are in |sessions_|, or if there is no
+  // store.
+  bool loaded_;
+
+  // The servers whose session was inserted or removed while |store_| was
+  // loading, and whether all the sessions were. The loaded sessions of these
+  // servers are out of date.
+  std::set<HostPortPair> changed_while_loading_;
+  bool cleared_while_loading_;
+
+  scoped_refptr<PersistentStore> store_;
+
+  SessionMap sessions_;
+
+  // Lock for thread-safety.
+  base::Lock lock_;
+
+  base::WeakPtrFactory<SSLSessionCache> weak_factory_;
+
+  DISALLOW_COPY_AND_ASSIGN(SSLSessionCache);
+};
+
+// A serialized TLS session, and the server it was negotiated with.
+class NET_EXPORT SSLSessionCache::Session {
+ public:
+  Session();
+  Session(const HostPortPair& host_and_port,
+          const std::string& data,
+          base::Time expiration);
+  ~Session();
+
+  const HostPortPair& host_and_port() const { return host_and_port_; }
+  const std::string& data() const { return data_; }
+  base::Time expiration() const { return expiration_; }
+
+ private:
+  HostPortPair host_and_port_;
+  std::string data_;
+  base::Time expiration_;
+};
+
+typedef base::RefCountedThreadSafe<SSLSessionCache::PersistentStore>
+    RefcountedSSLSessionStore;
+
+class NET_EXPORT SSLSessionCache::PersistentStore
+    : public RefcountedSSLSessionStore {
+ public:
+  virtual ~PersistentStore() {}
+
+  typedef base::Callback<void(const std::vector<SSLSessionCache::Session*>&)>
+      LoadedCallback;
+
+  // Initializes the store and retrieves the existing sessions. This will be
+  // called only once, on the first use of the cache. |loaded_callback| is run
+  // with the sessions once they are loaded, never from within Load(). Note
+  // that the sessions are individually allocated and that ownership is
+  // transferred to the callback.
+  virtual void Load(const LoadedCallback& loaded_callback) = 0;
+
+  // Adds |session|, replacing any session of the same server.
+  virtual void AddSession(const Session& session) = 0;
+
+  virtual void DeleteSession(const Session& session) = 0;
+
+  // Sets the value of the user preference whether the persistent storage
+  // must be deleted upon destruction.
+  virtual void SetClearLocalStateOnExit(bool clear_local_state) = 0;
+
+  // Flush the store and post the given Task when complete.
+  virtual void Flush(Task* completion_task) = 0;
+
+ protected:
+  PersistentStore();
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(PersistentStore);
+};
+
+}  // namespace net
+
+#endif  // NET_SOCKET_SSL_SESSION_CACHE_H_
@@ -0,0 +1,246 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "net/socket/ssl_session_cache.h"
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "base/compiler_specific.h"
+#include "base/logging.h"
+#include "base/stringprintf.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace net {
+
+namespace {
+
+// Loads the sessions when FinishLoad() is called.
+class MockPersistentStore : public SSLSessionCache::PersistentStore {
+ public:
+  MockPersistentStore() : load_count_(0) {}
+  virtual ~MockPersistentStore() {}
+
+  // SSLSessionCache::PersistentStore implementation.
+  virtual void Load(const LoadedCallback& loaded_callback) OVERRIDE {
+    ++load_count_;
+    loaded_callback_ = loaded_callback;
+  }
+  virtual void AddSession(const SSLSessionCache::Session& session) OVERRIDE {
+    sessions_[session.host_and_port().ToString()] = session;
+  }
+  virtual void DeleteSession(const SSLSessionCache::Session& session) OVERRIDE {
+    sessions_.erase(session.host_and_port().ToString());
+  }
+  virtual void SetClearLocalStateOnExit(bool clear_local_state) OVERRIDE {}
+  virtual void Flush(Task* completion_task) OVERRIDE {
+    NOTREACHED();
+  }
+
+  // Passes a copy of the stored sessions to the pending Load() call.
+  void FinishLoad() {
+    std::vector<SSLSessionCache::Session*> sessions;
+    for (SessionMap::iterator it = sessions_.begin(); it != sessions_.end();
+         ++it) {
+      sessions.push_back(new SSLSessionCache::Session(it->second));
+    }
+    LoadedCallback loaded_callback = loaded_callback_;
+    loaded_callback_.Reset();
+    loaded_callback.Run(sessions);
+  }
+
+  int load_count() const { return load_count_; }
+  size_t size() const { return sessions_.size(); }
+  bool Has(const HostPortPair& host_and_port) const {
+    return sessions_.count(host_and_port.ToString()) > 0;
+  }
+
+ private:
+  typedef std::map<std::string, SSLSessionCache::Session> SessionMap;
+
+  int load_count_;
+  LoadedCallback loaded_callback_;
+  SessionMap sessions_;
+};
+
+base::Time InOneHour() {
+  return base::Time::Now() + base::TimeDelta::FromHours(1);
+}
+
+}  // namespace
+
+TEST(SSLSessionCacheTest, InsertAndLookup) {
+  SSLSessionCache cache(NULL);
+  HostPortPair a("a.com", 443);
+  HostPortPair b("b.com", 443);
+  std::string data;
+
+  EXPECT_FALSE(cache.Lookup(a, &data));
+
+  cache.Insert(a, "session a", InOneHour());
+  cache.Insert(b, "session b", InOneHour());
+  EXPECT_EQ(2u, cache.size());
+  ASSERT_TRUE(cache.Lookup(a, &data));
+  EXPECT_EQ("session a", data);
+  ASSERT_TRUE(cache.Lookup(b, &data));
+  EXPECT_EQ("session b", data);
+
+  // The same host on another port is another server.
+  EXPECT_FALSE(cache.Lookup(HostPortPair("a.com", 8443), &data));
+
+  // A new session replaces the previous one.
+  cache.Insert(a, "session a2", InOneHour());
+  EXPECT_EQ(2u, cache.size());
+  ASSERT_TRUE(cache.Lookup(a, &data));
+  EXPECT_EQ("session a2", data);
+
+  cache.Remove(a);
+  EXPECT_FALSE(cache.Lookup(a, &data));
+  EXPECT_EQ(1u, cache.size());
+
+  cache.Clear();
+  EXPECT_EQ(0u, cache.size());
+}
+
+TEST(SSLSessionCacheTest, Expiration) {
+  SSLSessionCache cache(NULL);
+  HostPortPair a("a.com", 443);
+  std::string data;
+
+  cache.Insert(a, "session a",
+               base::Time::Now() - base::TimeDelta::FromSeconds(1));
+  EXPECT_FALSE(cache.Lookup(a, &data));
+  // The expired session is dropped.
+  EXPECT_EQ(0u, cache.size());
+}
+
+TEST(SSLSessionCacheTest, EvictLeastRecentlyUsed) {
+  SSLSessionCache cache(NULL);
+  std::string data;
+
+  for (size_t i = 0; i < SSLSessionCache::kMaxSessions; ++i) {
+    cache.Insert(HostPortPair(base::StringPrintf("%d.com", static_cast<int>(i)),
+                              443),
+                 "session", InOneHour());
+  }
+  EXPECT_EQ(SSLSessionCache::kMaxSessions, cache.size());
+
+  // Using the first session makes the second one the least recently used.
+  EXPECT_TRUE(cache.Lookup(HostPortPair("0.com", 443), &data));
+  cache.Insert(HostPortPair("new.com", 443), "session", InOneHour());
+  EXPECT_EQ(SSLSessionCache::kMaxSessions, cache.size());
+  EXPECT_TRUE(cache.Lookup(HostPortPair("0.com", 443), &data));
+  EXPECT_FALSE(cache.Lookup(HostPortPair("1.com", 443), &data));
+  EXPECT_TRUE(cache.Lookup(HostPortPair("2.com", 443), &data));
+  EXPECT_TRUE(cache.Lookup(HostPortPair("new.com", 443), &data));
+}
+
+TEST(SSLSessionCacheTest, PersistentStore) {
+  scoped_refptr<MockPersistentStore> store(new MockPersistentStore);
+  HostPortPair a("a.com", 443);
+  HostPortPair b("b.com", 443);
+  std::string data;
+
+  {
+    SSLSessionCache cache(store);
+    cache.Insert(a, "session a", InOneHour());
+    cache.Insert(b, "session b", InOneHour());
+    EXPECT_EQ(1, store->load_count());
+    EXPECT_EQ(2u, store->size());
+    store->FinishLoad();
+    EXPECT_EQ(2u, cache.size());
+
+    cache.Remove(b);
+    EXPECT_TRUE(store->Has(a));
+    EXPECT_FALSE(store->Has(b));
+  }
+
+  // After a restart, the sessions are loaded from the store. Lookups miss
+  // until they are.
+  {
+    SSLSessionCache cache(store);
+    EXPECT_FALSE(cache.Lookup(a, &data));
+    store->FinishLoad();
+    ASSERT_TRUE(cache.Lookup(a, &data));
+    EXPECT_EQ("session a", data);
+    EXPECT_FALSE(cache.Lookup(b, &data));
+    EXPECT_EQ(2, store->load_count());
+    EXPECT_EQ(1u, store->size());
+
+    cache.Clear();
+    EXPECT_EQ(0u, store->size());
+  }
+}
+
+TEST(SSLSessionCacheTest, LoadDropsExpiredSessions) {
+  scoped_refptr<MockPersistentStore> store(new MockPersistentStore);
+  HostPortPair a("a.com", 443);
+  HostPortPair b("b.com", 443);
+  std::string data;
+
+  store->AddSession(SSLSessionCache::Session(a, "session a", InOneHour()));
+  store->AddSession(SSLSessionCache::Session(
+      b, "session b", base::Time::Now() - base::TimeDelta::FromSeconds(1)));
+
+  SSLSessionCache cache(store);
+  EXPECT_EQ(0u, cache.size());
+  store->FinishLoad();
+  EXPECT_EQ(1u, cache.size());
+  EXPECT_TRUE(cache.Lookup(a, &data));
+  EXPECT_FALSE(cache.Lookup(b, &data));
+  EXPECT_TRUE(store->Has(a));
+  EXPECT_FALSE(store->Has(b));
+}
+
+// Tests that the sessions inserted or removed while the store is loading win
+// over the loaded ones.
+TEST(SSLSessionCacheTest, ChangesWhileLoading) {
+  scoped_refptr<MockPersistentStore> store(new MockPersistentStore);
+  HostPortPair a("a.com", 443);
+  HostPortPair b("b.com", 443);
+  HostPortPair c("c.com", 443);
+  std::string data;
+
+  store->AddSession(SSLSessionCache::Session(a, "old a", InOneHour()));
+  store->AddSession(SSLSessionCache::Session(b, "old b", InOneHour()));
+  store->AddSession(SSLSessionCache::Session(c, "old c", InOneHour()));
+
+  {
+    SSLSessionCache cache(store);
+    cache.Insert(a, "new a", InOneHour());
+    cache.Remove(b);
+    EXPECT_FALSE(cache.Lookup(a, &data));
+    store->FinishLoad();
+
+    ASSERT_TRUE(cache.Lookup(a, &data));
+    EXPECT_EQ("new a", data);
+    EXPECT_FALSE(cache.Lookup(b, &data));
+    ASSERT_TRUE(cache.Lookup(c, &data));
+    EXPECT_EQ("old c", data);
+    EXPECT_EQ(2u, cache.size());
+    EXPECT_EQ(2u, store->size());
+    EXPECT_FALSE(store->Has(b));
+  }
+
+  // Clearing the cache while it is loading clears the store too.
+  {
+    SSLSessionCache cache(store);
+    cache.Clear();
+    store->FinishLoad();
+    EXPECT_EQ(0u, cache.size());
+    EXPECT_EQ(0u, store->size());
+  }
+
+  // The sessions loaded after the cache is gone are dropped.
+  store->AddSession(SSLSessionCache::Session(a, "old a", InOneHour()));
+  {
+    SSLSessionCache cache(store);
+    EXPECT_EQ(0u, cache.size());
+  }
+  store->FinishLoad();
+  EXPECT_EQ(1u, store->size());
+}
+
+}  // namespace net
@@ -467,6 +467,11 @@ int TransportClientSocketPool::IdleSocketCountInGroup(
   return base_.IdleSocketCountInGroup(group_name);
 }
 
+int TransportClientSocketPool::ActiveSocketCountInGroup(
+    const std::string& group_name) const {
+  return base_.ActiveSocketCountInGroup(group_name);
+}
+
 LoadState TransportClientSocketPool::GetLoadState(
     const std::string& group_name, const ClientSocketHandle* handle) const {
   return base_.GetLoadState(group_name, handle);
@@ -173,6 +173,8 @@ class NET_EXPORT_PRIVATE TransportClientSocketPool : public ClientSocketPool {
 
   virtual int IdleSocketCountInGroup(const std::string& group_name) const;
 
+  virtual int ActiveSocketCountInGroup(const std::string& group_name) const;
+
   virtual LoadState GetLoadState(const std::string& group_name,
                                  const ClientSocketHandle* handle) const;
 
@@ -8,6 +8,7 @@
 
 #include "net/spdy/spdy_framer.h"
 
+#include "base/lazy_instance.h"
 #include "base/memory/scoped_ptr.h"
 #include "base/metrics/stats_counters.h"
 #include "base/third_party/valgrind/memcheck.h"
@@ -56,6 +57,7 @@ const int SpdyFramer::kDictionarySize = arraysize(kDictionary);
 
 // By default is compression on or off.
 bool SpdyFramer::compression_default_ = true;
+bool SpdyFramer::lean_compression_default_ = false;
 int SpdyFramer::spdy_version_ = kSpdyProtocolVersion;
 
 // The initial size of the control frame buffer; this is used internally
@@ -84,6 +86,61 @@ const size_t SpdyFramer::kHeaderDataChunkMaxSize = 1024;
 #define CHANGE_STATE(newstate) (state_ = newstate)
 #endif
 
+namespace {
+
+// A header compressor primed with the SPDY dictionary. Priming hashes the
+// whole dictionary, so new header compressors start as a copy of this one
+// instead. The object is never modified after construction, so it can be
+// copied from any thread.
+class PrimedHeaderCompressor {
+ public:
+  PrimedHeaderCompressor() : valid_(false) {
+    memset(&compressor_, 0, sizeof(compressor_));
+    int success = deflateInit2(&compressor_,
+                               kCompressorLevel,
+                               Z_DEFLATED,
+                               kCompressorWindowSizeInBits,
+                               kCompressorMemLevel,
+                               Z_DEFAULT_STRATEGY);
+    if (success != Z_OK) {
+      LOG(WARNING) << "deflateInit failure: " << success;
+      return;
+    }
+    valid_ = true;
+    success = deflateSetDictionary(
+        &compressor_, reinterpret_cast<const Bytef*>(SpdyFramer::kDictionary),
+        SpdyFramer::kDictionarySize);
+    if (success != Z_OK) {
+      LOG(WARNING) << "deflateSetDictionary failure: " << success;
+      deflateEnd(&compressor_);
+      valid_ = false;
+    }
+  }
+
+  ~PrimedHeaderCompressor() {
+    if (valid_)
+      deflateEnd(&compressor_);
+  }
+
+  // Initializes |compressor| as a copy of the primed compressor.
+  int CopyTo(z_stream* compressor) {
+    if (!valid_)
+      return Z_STREAM_ERROR;
+    return deflateCopy(compressor, &compressor_);
+  }
+
+ private:
+  z_stream compressor_;
+  bool valid_;
+
+  DISALLOW_COPY_AND_ASSIGN(PrimedHeaderCompressor);
+};
+
+base::LazyInstance<PrimedHeaderCompressor> g_primed_header_compressor(
+    base::LINKER_INITIALIZED);
+
+}  // namespace
+
 int DecompressHeaderBlockInZStream(z_stream* decompressor) {
   int rv = inflate(decompressor, Z_SYNC_FLUSH);
   if (rv == Z_NEED_DICT) {
@@ -147,6 +204,7 @@ SpdyFramer::SpdyFramer()
       current_frame_capacity_(0),
       validate_control_frame_sizes_(true),
       enable_compression_(compression_default_),
+      lean_compression_(lean_compression_default_),
       visitor_(NULL) {
 }
 
@@ -286,6 +344,8 @@ size_t SpdyFramer::ProcessInput(const char* data, size_t len) {
     }
   }
  bottom:
+  if (lean_compression_)
+    ReleaseIdleControlFrameBuffer();
   return original_len - len;
 }
 
@@ -296,11 +356,16 @@ void SpdyFramer::Reset() {
   remaining_control_payload_ = 0;
   remaining_control_header_ = 0;
   current_frame_len_ = 0;
-  if (current_frame_capacity_ != kControlFrameBufferInitialSize) {
+  // The lean mode starts every frame with the smallest buffer, and lets
+  // ProcessControlFrameHeader() grow it when the frame has a payload.
+  size_t initial_size = lean_compression_ ?
+      kUncompressedControlFrameBufferInitialSize :
+      kControlFrameBufferInitialSize;
+  if (current_frame_capacity_ != initial_size + SpdyFrame::size()) {
     delete [] current_frame_buffer_;
     current_frame_buffer_ = 0;
     current_frame_capacity_ = 0;
-    ExpandControlFrameBuffer(kControlFrameBufferInitialSize);
+    ExpandControlFrameBuffer(initial_size);
   }
 }
 
@@ -891,6 +956,14 @@ void SpdyFramer::set_enable_compression_default(bool value) {
   compression_default_ = value;
 }
 
+void SpdyFramer::set_lean_compression(bool value) {
+  lean_compression_ = value;
+}
+
+void SpdyFramer::set_lean_compression_default(bool value) {
+  lean_compression_default_ = value;
+}
+
 size_t SpdyFramer::ProcessCommonHeader(const char* data, size_t len) {
   // This should only be called when we're in the SPDY_READING_COMMON_HEADER
   // state.
@@ -1116,18 +1189,10 @@ z_stream* SpdyFramer::GetHeaderCompressor() {
   header_compressor_.reset(new z_stream);
   memset(header_compressor_.get(), 0, sizeof(z_stream));
 
-  int success = deflateInit2(header_compressor_.get(),
-                             kCompressorLevel,
-                             Z_DEFLATED,
-                             kCompressorWindowSizeInBits,
-                             kCompressorMemLevel,
-                             Z_DEFAULT_STRATEGY);
-  if (success == Z_OK)
-    success = deflateSetDictionary(header_compressor_.get(),
-                                   reinterpret_cast<const Bytef*>(kDictionary),
-                                   kDictionarySize);
+  int success = g_primed_header_compressor.Get().CopyTo(
+      header_compressor_.get());
   if (success != Z_OK) {
-    LOG(WARNING) << "deflateSetDictionary failure: " << success;
+    LOG(WARNING) << "deflateCopy failure: " << success;
     header_compressor_.reset(NULL);
     return NULL;
   }
@@ -1150,7 +1215,11 @@ z_stream* SpdyFramer::GetHeaderDecompressor() {
                             kDictionarySize);
   }
 
-  int success = inflateInit(header_decompressor_.get());
+  // In the lean mode, start with the window size used by our own compressor.
+  // FitHeaderDecompressorWindow() makes it larger if the peer needs it.
+  int success = lean_compression_ ?
+      inflateInit2(header_decompressor_.get(), kCompressorWindowSizeInBits) :
+      inflateInit(header_decompressor_.get());
   if (success != Z_OK) {
     LOG(WARNING) << "inflateInit failure: " << success;
     header_decompressor_.reset(NULL);
@@ -1159,6 +1228,40 @@ z_stream* SpdyFramer::GetHeaderDecompressor() {
   return header_decompressor_.get();
 }
 
+bool SpdyFramer::FitHeaderDecompressorWindow(z_stream* decompressor) {
+  // Only the first byte of the stream says which window size it needs.
+  if (!lean_compression_ || decompressor->total_in || !decompressor->avail_in)
+    return true;
+
+  // The high nibble of the first byte of a zlib stream is the base two
+  // logarithm of the window size, minus eight.
+  int window_bits = (decompressor->next_in[0] >> 4) + 8;
+  if (window_bits <= kCompressorWindowSizeInBits || window_bits > MAX_WBITS)
+    return true;  // inflate() rejects invalid headers by itself.
+
+  // inflateInit2() does not touch the input.
+  inflateEnd(decompressor);
+  int success = inflateInit2(decompressor, window_bits);
+  if (success != Z_OK) {
+    LOG(WARNING) << "inflateInit failure: " << success;
+    return false;
+  }
+  return true;
+}
+
+void SpdyFramer::ReleaseIdleControlFrameBuffer() {
+  if (state_ != SPDY_RESET && state_ != SPDY_AUTO_RESET)
+    return;
+  if (current_frame_capacity_ <=
+      kUncompressedControlFrameBufferInitialSize + SpdyFrame::size()) {
+    return;
+  }
+  delete [] current_frame_buffer_;
+  current_frame_buffer_ = NULL;
+  current_frame_len_ = 0;
+  current_frame_capacity_ = 0;
+}
+
 z_stream* SpdyFramer::GetStreamCompressor(SpdyStreamId stream_id) {
   CompressorMap::iterator it = stream_compressors_.find(stream_id);
   if (it != stream_compressors_.end())
@@ -1245,6 +1348,10 @@ bool SpdyFramer::IncrementallyDecompressControlFrameHeaderData(
   }
   decomp->next_in = reinterpret_cast<Bytef*>(const_cast<char*>(payload));
   decomp->avail_in = payload_length;
+  if (!FitHeaderDecompressorWindow(decomp)) {
+    set_error(SPDY_DECOMPRESS_FAILURE);
+    return false;
+  }
   const SpdyStreamId stream_id = GetControlFrameStreamId(control_frame);
   DCHECK_LT(0u, stream_id);
   while (more && read_successfully) {
@@ -1292,6 +1399,10 @@ bool SpdyFramer::IncrementallyDecompressControlFrameHeaderData(
 
   decomp->next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data));
   decomp->avail_in = len;
+  if (!FitHeaderDecompressorWindow(decomp)) {
+    set_error(SPDY_DECOMPRESS_FAILURE);
+    return false;
+  }
   const SpdyStreamId stream_id = GetControlFrameStreamId(control_frame);
   DCHECK_LT(0u, stream_id);
   while (decomp->avail_in > 0 && processed_successfully) {
@@ -1520,6 +1631,11 @@ SpdyFrame* SpdyFramer::DecompressFrameWithZStream(const SpdyFrame& frame,
       header_length;
   decompressor->avail_out = decompressed_max_size;
 
+  if (decompressor == header_decompressor_.get() &&
+      !FitHeaderDecompressorWindow(decompressor)) {
+    return NULL;
+  }
+
   int rv = inflate(decompressor, Z_SYNC_FLUSH);
   if (rv == Z_NEED_DICT) {
     // Need to try again with the right dictionary.
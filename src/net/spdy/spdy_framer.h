@@ -304,6 +304,13 @@ class NET_EXPORT_PRIVATE SpdyFramer {
   void set_validate_control_frame_sizes(bool value);
   static void set_enable_compression_default(bool value);
 
+  // The memory-lean mode is meant for servers that keep many sessions open,
+  // most of them idle. In this mode the framer releases its control frame
+  // buffer between frames, and the header decompressor uses the window size
+  // requested by the peer's compressor instead of the largest one.
+  void set_lean_compression(bool value);
+  static void set_lean_compression_default(bool value);
+
   // For debugging.
   static const char* StateToString(int state);
   static const char* ErrorCodeToString(int error_code);
@@ -320,6 +327,7 @@ class NET_EXPORT_PRIVATE SpdyFramer {
   FRIEND_TEST_ALL_PREFIXES(SpdyFramerTest, DataCompression);
   FRIEND_TEST_ALL_PREFIXES(SpdyFramerTest, ExpandBuffer_HeapSmash);
   FRIEND_TEST_ALL_PREFIXES(SpdyFramerTest, HugeHeaderBlock);
+  FRIEND_TEST_ALL_PREFIXES(SpdyFramerTest, LeanCompression);
   FRIEND_TEST_ALL_PREFIXES(SpdyFramerTest, UnclosedStreamDataCompressors);
   FRIEND_TEST_ALL_PREFIXES(SpdyFramerTest,
                            UncompressLargerThanFrameBufferInitialSize);
@@ -366,6 +374,14 @@ class NET_EXPORT_PRIVATE SpdyFramer {
   // Get (and lazily initialize) the ZLib state.
   z_stream* GetHeaderCompressor();
   z_stream* GetHeaderDecompressor();
+
+  // In the memory-lean mode, makes sure that the header decompressor has a
+  // window that is large enough for the stream that it is about to read.
+  // Returns false on failure.
+  bool FitHeaderDecompressorWindow(z_stream* decompressor);
+
+  // Releases the control frame buffer if there is no frame in progress.
+  void ReleaseIdleControlFrameBuffer();
   z_stream* GetStreamCompressor(SpdyStreamId id);
   z_stream* GetStreamDecompressor(SpdyStreamId id);
 
@@ -462,6 +478,7 @@ class NET_EXPORT_PRIVATE SpdyFramer {
 
   bool validate_control_frame_sizes_;
   bool enable_compression_;  // Controls all compression
+  bool lean_compression_;  // Use the memory-lean mode.
   // SPDY header compressors.
   scoped_ptr<z_stream> header_compressor_;
   scoped_ptr<z_stream> header_decompressor_;
@@ -473,6 +490,7 @@ class NET_EXPORT_PRIVATE SpdyFramer {
   SpdyFramerVisitorInterface* visitor_;
 
   static bool compression_default_;
+  static bool lean_compression_default_;
   static int spdy_version_;
 };
 
@@ -0,0 +1,139 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <string>
+#include <vector>
+
+#include "base/basictypes.h"
+#include "base/memory/scoped_ptr.h"
+#include "base/memory/scoped_vector.h"
+#include "base/perftimer.h"
+#include "base/process_util.h"
+#include "base/string_number_conversions.h"
+#include "base/stringprintf.h"
+#include "net/spdy/spdy_framer.h"
+#include "net/spdy/spdy_protocol.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+using spdy::CONTROL_FLAG_NONE;
+using spdy::SpdyFramer;
+using spdy::SpdyHeaderBlock;
+using spdy::SpdySynReplyControlFrame;
+using spdy::SpdySynStreamControlFrame;
+
+namespace {
+
+const int kNumSessions = 2000;
+const int kNumFrames = 20000;
+
+void GetRequestHeaders(int id, SpdyHeaderBlock* headers) {
+  (*headers)["method"] = "GET";
+  (*headers)["url"] = base::StringPrintf("http://www.example.com/%d.html", id);
+  (*headers)["version"] = "HTTP/1.1";
+  (*headers)["user-agent"] =
+      "Mozilla/5.0 (X11; Linux x86_64) AppleWebKit/535.1 (KHTML, like Gecko)";
+  (*headers)["accept"] = "text/html,application/xhtml+xml,*/*;q=0.8";
+  (*headers)["accept-encoding"] = "gzip,deflate,sdch";
+  (*headers)["accept-language"] = "en-US,en;q=0.8";
+  (*headers)["cookie"] = "PREF=ID=0123456789abcdef:FF=0:TM=1316000000";
+}
+
+void GetResponseHeaders(int id, SpdyHeaderBlock* headers) {
+  (*headers)["status"] = "200 OK";
+  (*headers)["version"] = "HTTP/1.1";
+  (*headers)["content-type"] = "text/html; charset=utf-8";
+  (*headers)["content-length"] = base::IntToString(1000 + id);
+  (*headers)["cache-control"] = "private, max-age=0";
+  (*headers)["date"] = "Wed, 14 Sep 2011 12:12:12 GMT";
+  (*headers)["server"] = "SpdyServer 1.0";
+}
+
+size_t GetProcessMemory() {
+#if defined(OS_MACOSX)
+  scoped_ptr<base::ProcessMetrics> metrics(
+      base::ProcessMetrics::CreateProcessMetrics(
+          base::GetCurrentProcessHandle(), NULL));
+#else
+  scoped_ptr<base::ProcessMetrics> metrics(
+      base::ProcessMetrics::CreateProcessMetrics(
+          base::GetCurrentProcessHandle()));
+#endif
+  return metrics->GetPagefileUsage();
+}
+
+// Simulates the server side of |kNumSessions| sessions that receive one
+// request and send one reply each, and reports the memory that every idle
+// session keeps. The sessions are added to |sessions|, so that the memory of
+// the next run is not taken from the blocks released by this one.
+void TimeSessions(bool lean, const char* test_name,
+                  ScopedVector<SpdyFramer>* sessions) {
+  SpdyHeaderBlock request;
+  SpdyHeaderBlock response;
+  GetRequestHeaders(0, &request);
+  GetResponseHeaders(0, &response);
+
+  size_t memory = GetProcessMemory();
+  PerfTimeLogger timer(test_name);
+  for (int i = 0; i < kNumSessions; i++) {
+    SpdyFramer client;
+    scoped_ptr<SpdySynStreamControlFrame> syn_stream(
+        client.CreateSynStream(1, 0, 0, CONTROL_FLAG_NONE, true, &request));
+
+    SpdyFramer* server = new SpdyFramer;
+    server->set_lean_compression(lean);
+    sessions->push_back(server);
+    SpdyHeaderBlock headers;
+    EXPECT_TRUE(server->ParseHeaderBlock(syn_stream.get(), &headers));
+    scoped_ptr<SpdySynReplyControlFrame> syn_reply(
+        server->CreateSynReply(1, CONTROL_FLAG_NONE, true, &response));
+    EXPECT_TRUE(syn_reply.get() != NULL);
+  }
+  timer.Done();
+
+  size_t session_memory = (GetProcessMemory() - memory) / kNumSessions;
+  LogPerfResult(base::StringPrintf("%s_memory", test_name).c_str(),
+                static_cast<double>(session_memory), "bytes");
+}
+
+// Compresses and decompresses |kNumFrames| header blocks on a single session.
+void TimeHeaderCompression(bool lean, const char* test_name) {
+  std::vector<SpdyHeaderBlock> requests(kNumFrames);
+  for (int i = 0; i < kNumFrames; i++)
+    GetRequestHeaders(i, &requests[i]);
+
+  SpdyFramer client;
+  SpdyFramer server;
+  client.set_lean_compression(lean);
+  server.set_lean_compression(lean);
+  ScopedVector<SpdySynStreamControlFrame> frames;
+
+  PerfTimeLogger compress_timer(
+      base::StringPrintf("%s_compress", test_name).c_str());
+  for (int i = 0; i < kNumFrames; i++) {
+    frames.push_back(client.CreateSynStream(i * 2 + 1, 0, 0, CONTROL_FLAG_NONE,
+                                            true, &requests[i]));
+  }
+  compress_timer.Done();
+
+  PerfTimeLogger decompress_timer(
+      base::StringPrintf("%s_decompress", test_name).c_str());
+  for (int i = 0; i < kNumFrames; i++) {
+    SpdyHeaderBlock headers;
+    EXPECT_TRUE(server.ParseHeaderBlock(frames[i], &headers));
+  }
+  decompress_timer.Done();
+}
+
+}  // namespace
+
+TEST(SpdyFramerPerfTest, Sessions) {
+  ScopedVector<SpdyFramer> sessions;
+  TimeSessions(false, "SpdyFramer_sessions", &sessions);
+  TimeSessions(true, "SpdyFramer_sessions_lean", &sessions);
+}
+
+TEST(SpdyFramerPerfTest, HeaderCompression) {
+  TimeHeaderCompression(false, "SpdyFramer_headers");
+  TimeHeaderCompression(true, "SpdyFramer_headers_lean");
+}
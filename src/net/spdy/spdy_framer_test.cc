@@ -11,6 +11,12 @@
 #include "net/spdy/spdy_frame_builder.h"
 #include "testing/platform_test.h"
 
+#if defined(USE_SYSTEM_ZLIB)
+#include <zlib.h>
+#else
+#include "third_party/zlib/zlib.h"
+#endif
+
 namespace spdy {
 
 namespace test {
@@ -452,6 +458,70 @@ TEST_F(SpdyFramerTest, DecompressUncompressedFrame) {
   EXPECT_EQ(NULL, frame2.get());
 }
 
+TEST_F(SpdyFramerTest, LeanCompression) {
+  SpdyHeaderBlock headers;
+  headers["server"] = "SpdyServer 1.0";
+  headers["date"] = "Mon 12 Jan 2009 12:12:12 PST";
+  headers["status"] = "200";
+  headers["version"] = "HTTP/1.1";
+
+  SpdyFramer framer;
+  SpdyFramer lean_framer;
+  FramerSetEnableCompressionHelper(&framer, true);
+  FramerSetEnableCompressionHelper(&lean_framer, true);
+  lean_framer.set_lean_compression(true);
+
+  // The lean mode does not change what goes on the wire.
+  scoped_ptr<SpdySynStreamControlFrame>
+      frame1(framer.CreateSynStream(1, 0, 1, CONTROL_FLAG_NONE, true,
+                                    &headers));
+  scoped_ptr<SpdySynStreamControlFrame>
+      frame2(lean_framer.CreateSynStream(1, 0, 1, CONTROL_FLAG_NONE, true,
+                                         &headers));
+  ASSERT_EQ(frame1->length(), frame2->length());
+  EXPECT_EQ(0, memcmp(frame1->data(), frame2->data(),
+                      SpdyFrame::size() + frame1->length()));
+
+  SpdyHeaderBlock new_headers;
+  EXPECT_TRUE(lean_framer.ParseHeaderBlock(frame1.get(), &new_headers));
+  EXPECT_EQ(headers, new_headers);
+
+  // A peer that compresses with the largest window is also understood.
+  SpdyFramer big_window_framer;
+  FramerSetEnableCompressionHelper(&big_window_framer, true);
+  big_window_framer.header_compressor_.reset(new z_stream);
+  memset(big_window_framer.header_compressor_.get(), 0, sizeof(z_stream));
+  ASSERT_EQ(Z_OK, deflateInit2(big_window_framer.header_compressor_.get(),
+                               9, Z_DEFLATED, MAX_WBITS, 8,
+                               Z_DEFAULT_STRATEGY));
+  ASSERT_EQ(Z_OK, deflateSetDictionary(
+      big_window_framer.header_compressor_.get(),
+      reinterpret_cast<const Bytef*>(SpdyFramer::kDictionary),
+      SpdyFramer::kDictionarySize));
+  scoped_ptr<SpdySynStreamControlFrame>
+      frame3(big_window_framer.CreateSynStream(1, 0, 1, CONTROL_FLAG_NONE,
+                                               true, &headers));
+  SpdyFramer lean_framer2;
+  FramerSetEnableCompressionHelper(&lean_framer2, true);
+  lean_framer2.set_lean_compression(true);
+  new_headers.clear();
+  EXPECT_TRUE(lean_framer2.ParseHeaderBlock(frame3.get(), &new_headers));
+  EXPECT_EQ(headers, new_headers);
+
+  // The control frame buffer is released between frames.
+  scoped_ptr<SpdySynStreamControlFrame>
+      frame4(framer.CreateSynStream(1, 0, 1, CONTROL_FLAG_NONE, false,
+                                    &headers));
+  TestSpdyVisitor visitor;
+  visitor.framer_.set_lean_compression(true);
+  visitor.SimulateInFramer(
+      reinterpret_cast<unsigned char*>(frame4->data()),
+      frame4->length() + SpdyControlFrame::size());
+  EXPECT_EQ(0, visitor.error_count_);
+  EXPECT_EQ(1, visitor.syn_frame_count_);
+  EXPECT_EQ(0u, visitor.framer_.current_frame_capacity_);
+}
+
 TEST_F(SpdyFramerTest, Basic) {
   const unsigned char input[] = {
     0x80, 0x02, 0x00, 0x01,   // SYN Stream #1
@@ -0,0 +1,251 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// This command-line program replays a trace of cache requests against the disk
+// cache, once for every eviction policy, and reports the hit ratio and byte hit
+// ratio that each policy achieves for a given cache size.
+//
+// The trace is a text file with one request per line:
+//
+//   <timestamp> <key> <size>
+//
+// where |timestamp| is only used to verify that the requests are in order (the
+// cache sees the time of the replay, not the time of the trace), |key| is the
+// key of the resource (without white space) and |size| is the size of the
+// resource, in bytes. Lines that start with '#' are ignored.
+//
+// A request is a hit if the entry is in the cache with the same size. Otherwise
+// the entry is (re)written with the new size.
+//
+// Usage: cache_replay <trace file> <cache size in bytes>
+
+#include <stdio.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "base/at_exit.h"
+#include "base/file_path.h"
+#include "base/file_util.h"
+#include "base/format_macros.h"
+#include "base/memory/scoped_ptr.h"
+#include "base/message_loop.h"
+#include "base/scoped_temp_dir.h"
+#include "base/string_number_conversions.h"
+#include "base/string_split.h"
+#include "base/string_util.h"
+#include "base/threading/thread.h"
+#include "base/utf_string_conversions.h"
+#include "net/base/io_buffer.h"
+#include "net/base/net_errors.h"
+#include "net/base/test_completion_callback.h"
+#include "net/disk_cache/backend_impl.h"
+#include "net/disk_cache/disk_cache.h"
+
+namespace {
+
+enum Errors {
+  GENERIC = -1,
+  ALL_GOOD = 0,
+  INVALID_ARGUMENT = 1,
+  INVALID_TRACE,
+};
+
+enum Policy {
+  POLICY_LRU = 0,
+  POLICY_NEW_EVICTION,
+  POLICY_ADAPTIVE,
+  POLICY_MAX
+};
+
+const char* const kPolicyNames[] = {
+  "lru",
+  "new eviction",
+  "adaptive",
+};
+
+// The stream used to store the data of every entry.
+const int kDataIndex = 1;
+
+// Data is written in chunks of this size.
+const int kChunkSize = 64 * 1024;
+
+struct Request {
+  int64 timestamp;
+  std::string key;
+  int size;
+};
+
+struct Results {
+  Results() : requests(0), hits(0), bytes(0), hit_bytes(0) {}
+
+  int64 requests;
+  int64 hits;
+  int64 bytes;
+  int64 hit_bytes;
+};
+
+// Reads the trace stored at |path| into |requests|.
+bool ReadTrace(const FilePath& path, std::vector<Request>* requests) {
+  std::string contents;
+  if (!file_util::ReadFileToString(path, &contents))
+    return false;
+
+  std::vector<std::string> lines;
+  base::SplitString(contents, '\n', &lines);
+  int64 last_timestamp = 0;
+  for (size_t i = 0; i < lines.size(); i++) {
+    if (lines[i].empty() || lines[i][0] == '#')
+      continue;
+
+    std::vector<std::string> fields;
+    base::SplitStringAlongWhitespace(lines[i], &fields);
+    Request request;
+    if (fields.size() != 3 ||
+        !base::StringToInt64(fields[0], &request.timestamp) ||
+        !base::StringToInt(fields[2], &request.size) || request.size < 0 ||
+        request.timestamp < last_timestamp) {
+      printf("Invalid trace record at line %d\n", static_cast<int>(i + 1));
+      return false;
+    }
+    request.key = fields[1];
+    last_timestamp = request.timestamp;
+    requests->push_back(request);
+  }
+  return true;
+}
+
+// Writes |size| bytes of data to |entry|.
+bool WriteData(disk_cache::Entry* entry, int size, net::IOBuffer* buffer) {
+  TestOldCompletionCallback cb;
+  int offset = 0;
+  do {
+    int len = std::min(size - offset, kChunkSize);
+    int rv = entry->WriteData(kDataIndex, offset, buffer, len, &cb,
+                              offset == 0);
+    if (cb.GetResult(rv) != len)
+      return false;
+    offset += len;
+  } while (offset < size);
+  return true;
+}
+
+// Replays |requests| against a cache of |max_size| bytes, stored at |path|,
+// that uses the eviction |policy|.
+bool Replay(const FilePath& path, int max_size, Policy policy,
+            const std::vector<Request>& requests, base::Thread* cache_thread,
+            Results* results) {
+  scoped_ptr<disk_cache::BackendImpl> cache(
+      new disk_cache::BackendImpl(path, cache_thread->message_loop_proxy(),
+                                  NULL));
+  if (!cache->SetMaxSize(max_size))
+    return false;
+  cache->SetFlags(disk_cache::kNoRandom | disk_cache::kNoLoadProtection);
+  if (policy == POLICY_NEW_EVICTION)
+    cache->SetNewEviction();
+  else if (policy == POLICY_ADAPTIVE)
+    cache->SetAdaptiveEviction();
+
+  TestOldCompletionCallback cb;
+  int rv = cache->Init(&cb);
+  if (cb.GetResult(rv) != net::OK)
+    return false;
+
+  scoped_refptr<net::IOBuffer> buffer(new net::IOBuffer(kChunkSize));
+  memset(buffer->data(), 0, kChunkSize);
+
+  for (size_t i = 0; i < requests.size(); i++) {
+    const Request& request = requests[i];
+    results->requests++;
+    results->bytes += request.size;
+
+    disk_cache::Entry* entry;
+    rv = cache->OpenEntry(request.key, &entry, &cb);
+    if (cb.GetResult(rv) == net::OK) {
+      if (entry->GetDataSize(kDataIndex) == request.size) {
+        results->hits++;
+        results->hit_bytes += request.size;
+        entry->Close();
+        continue;
+      }
+      entry->Doom();
+      entry->Close();
+    }
+
+    rv = cache->CreateEntry(request.key, &entry, &cb);
+    if (cb.GetResult(rv) != net::OK)
+      return false;
+    bool success = WriteData(entry, request.size, buffer);
+    entry->Close();
+    if (!success)
+      return false;
+
+    // Let the cache thread catch up, so that evictions happen when they would
+    // happen for a real user.
+    rv = cache->FlushQueueForTest(&cb);
+    cb.GetResult(rv);
+  }
+  return true;
+}
+
+void PrintResults(Policy policy, const Results& results) {
+  double hit_ratio = results.requests ?
+      static_cast<double>(results.hits) / results.requests : 0;
+  double byte_hit_ratio = results.bytes ?
+      static_cast<double>(results.hit_bytes) / results.bytes : 0;
+  printf("%-14s requests: %" PRId64 ", hits: %" PRId64 ", hit ratio: %.4f, "
+         "byte hit ratio: %.4f\n", kPolicyNames[policy], results.requests,
+         results.hits, hit_ratio, byte_hit_ratio);
+}
+
+}  // namespace
+
+int main(int argc, const char* argv[]) {
+  // Setup an AtExitManager so Singleton objects will be destructed.
+  base::AtExitManager at_exit_manager;
+  COMPILE_ASSERT(arraysize(kPolicyNames) == POLICY_MAX, policy_names);
+
+  int max_size;
+  if (argc != 3 || !base::StringToInt(argv[2], &max_size) || max_size <= 0) {
+    printf("Usage: cache_replay <trace file> <cache size in bytes>\n");
+    return INVALID_ARGUMENT;
+  }
+
+#if defined(OS_WIN)
+  FilePath trace_path(ASCIIToWide(argv[1]));
+#else
+  FilePath trace_path(argv[1]);
+#endif
+  std::vector<Request> requests;
+  if (!ReadTrace(trace_path, &requests))
+    return INVALID_TRACE;
+
+  MessageLoopForIO message_loop;
+  base::Thread cache_thread("CacheThread");
+  if (!cache_thread.StartWithOptions(
+          base::Thread::Options(MessageLoop::TYPE_IO, 0)))
+    return GENERIC;
+
+  for (int i = 0; i < POLICY_MAX; i++) {
+    Policy policy = static_cast<Policy>(i);
+    ScopedTempDir folder;
+    if (!folder.CreateUniqueTempDir())
+      return GENERIC;
+
+    Results results;
+    if (!Replay(folder.path(), max_size, policy, requests, &cache_thread,
+                &results)) {
+      printf("Unable to replay the trace with the %s policy\n",
+             kPolicyNames[policy]);
+      return GENERIC;
+    }
+    PrintResults(policy, results);
+
+    // Let the cache thread finish the work for the old cache.
+    message_loop.RunAllPending();
+  }
+
+  return ALL_GOOD;
+}
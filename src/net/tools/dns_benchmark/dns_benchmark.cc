@@ -0,0 +1,448 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// This command-line program compares the two ways the network stack resolves
+// hostnames: HostResolverImpl, which blocks a worker thread for every lookup
+// (like getaddrinfo() does), and AsyncHostResolver, which sends the DNS
+// queries from the IO thread. Both send their queries to a name server on the
+// same machine that answers every A query with 127.0.0.1, optionally after a
+// delay that stands for the round trip to a real server. The same number of
+// lookups are kept in flight for both resolvers, and the results are not
+// cached. For each resolver it reports the number of lookups per second and
+// the latency of the lookups.
+//
+// Usage: dns_benchmark [--lookups=<number of lookups>]
+//                      [--parallelism=<lookups in flight>]
+//                      [--delay=<milliseconds before each answer>]
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <stdio.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <deque>
+#include <string>
+#include <vector>
+
+#include "base/at_exit.h"
+#include "base/atomicops.h"
+#include "base/bind.h"
+#include "base/command_line.h"
+#include "base/compiler_specific.h"
+#include "base/eintr_wrapper.h"
+#include "base/memory/scoped_ptr.h"
+#include "base/message_loop.h"
+#include "base/rand_util.h"
+#include "base/string_number_conversions.h"
+#include "base/stringprintf.h"
+#include "base/synchronization/cancellation_flag.h"
+#include "base/threading/simple_thread.h"
+#include "base/time.h"
+#include "net/base/address_list.h"
+#include "net/base/dns_util.h"
+#include "net/base/host_cache.h"
+#include "net/base/host_resolver_impl.h"
+#include "net/base/host_resolver_proc.h"
+#include "net/base/io_buffer.h"
+#include "net/base/ip_endpoint.h"
+#include "net/base/net_errors.h"
+#include "net/base/net_util.h"
+#include "net/dns/async_host_resolver.h"
+#include "net/dns/dns_query.h"
+#include "net/dns/dns_response.h"
+
+namespace {
+
+enum Errors {
+  GENERIC = -1,
+  ALL_GOOD = 0,
+  INVALID_ARGUMENT = 1,
+};
+
+// The size of the DNS header.
+const size_t kHeaderSize = 12;
+
+// The TTL of the answers of the server.
+const uint32 kAnswerTTL = 300;
+
+// How long the blocking lookups wait for an answer.
+const int kReadTimeoutSeconds = 5;
+
+// The id of the last query sent by BlockingDnsProc.
+base::subtle::Atomic32 g_last_query_id = 0;
+
+// Returns the id of the next query sent by BlockingDnsProc. base::RandInt()
+// can't be used on the worker threads, which are not joinable.
+int NextQueryId(int min, int max) {
+  int id = base::subtle::NoBarrier_AtomicIncrement(&g_last_query_id, 1);
+  return min + id % (max - min + 1);
+}
+
+void AppendU16(std::string* out, uint16 value) {
+  out->push_back(static_cast<char>(value >> 8));
+  out->push_back(static_cast<char>(value & 0xff));
+}
+
+// A name server that answers every A query with 127.0.0.1, and the other
+// queries with no records. The answers are sent |delay| after the queries
+// were received.
+class LocalDnsServer : public base::SimpleThread {
+ public:
+  explicit LocalDnsServer(base::TimeDelta delay)
+      : base::SimpleThread("LocalDnsServer"),
+        delay_(delay),
+        fd_(-1) {}
+
+  virtual ~LocalDnsServer() {
+    if (fd_ != -1)
+      close(fd_);
+  }
+
+  // Binds the socket of the server to a port of 127.0.0.1. Returns false on
+  // failure.
+  bool Bind() {
+    fd_ = socket(AF_INET, SOCK_DGRAM, 0);
+    if (fd_ == -1)
+      return false;
+    struct sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t address_len = sizeof(address);
+    if (bind(fd_, reinterpret_cast<struct sockaddr*>(&address),
+             address_len) < 0 ||
+        getsockname(fd_, reinterpret_cast<struct sockaddr*>(&address),
+                    &address_len) < 0) {
+      return false;
+    }
+    return endpoint_.FromSockAddr(
+        reinterpret_cast<struct sockaddr*>(&address), address_len);
+  }
+
+  const net::IPEndPoint& endpoint() const { return endpoint_; }
+
+  // Asks the server thread to exit. Join() must be called after.
+  void Quit() { quit_.Set(); }
+
+  // SimpleThread:
+  virtual void Run() {
+    char buffer[512];
+    while (!quit_.IsSet()) {
+      // Wake up in time for the next answer, or to check |quit_|.
+      int timeout_ms = 50;
+      if (!answers_.empty()) {
+        base::TimeDelta wait = answers_.front().time - base::TimeTicks::Now();
+        timeout_ms = std::max(0, static_cast<int>(wait.InMilliseconds()));
+      }
+      struct pollfd poll_fd = { fd_, POLLIN, 0 };
+      int rv = HANDLE_EINTR(poll(&poll_fd, 1, timeout_ms));
+      if (rv > 0) {
+        Answer answer;
+        socklen_t address_len = sizeof(answer.address);
+        ssize_t len = HANDLE_EINTR(recvfrom(
+            fd_, buffer, sizeof(buffer), 0,
+            reinterpret_cast<struct sockaddr*>(&answer.address),
+            &address_len));
+        if (len > 0 && BuildResponse(std::string(buffer, len),
+                                     &answer.response)) {
+          answer.time = base::TimeTicks::Now() + delay_;
+          answers_.push_back(answer);
+        }
+      }
+      SendDueAnswers();
+    }
+  }
+
+ private:
+  struct Answer {
+    base::TimeTicks time;
+    struct sockaddr_in address;
+    std::string response;
+  };
+
+  // Builds the response to |query|. Returns false if it isn't a query.
+  static bool BuildResponse(const std::string& query, std::string* response) {
+    size_t qname_end = query.find('\0', kHeaderSize);
+    if (query.size() < kHeaderSize || qname_end == std::string::npos ||
+        qname_end + 5 != query.size()) {
+      return false;
+    }
+    uint16 qtype = (static_cast<uint8>(query[qname_end + 1]) << 8) |
+                   static_cast<uint8>(query[qname_end + 2]);
+
+    response->assign(query);
+    (*response)[2] = static_cast<char>(0x81);  // Response, recursion desired.
+    (*response)[3] = static_cast<char>(0x80);  // Recursion available.
+    if (qtype != net::kDNS_A)
+      return true;
+
+    (*response)[7] = 1;  // One answer.
+    AppendU16(response, 0xc00c);  // Pointer to the question name.
+    AppendU16(response, net::kDNS_A);
+    AppendU16(response, net::kClassIN);
+    AppendU16(response, kAnswerTTL >> 16);
+    AppendU16(response, kAnswerTTL & 0xffff);
+    AppendU16(response, 4);
+    response->append("\x7f\x00\x00\x01", 4);
+    return true;
+  }
+
+  void SendDueAnswers() {
+    base::TimeTicks now = base::TimeTicks::Now();
+    // The answers are queued in the order they are due.
+    while (!answers_.empty() && answers_.front().time <= now) {
+      const Answer& answer = answers_.front();
+      HANDLE_EINTR(sendto(
+          fd_, answer.response.data(), answer.response.size(), 0,
+          reinterpret_cast<const struct sockaddr*>(&answer.address),
+          sizeof(answer.address)));
+      answers_.pop_front();
+    }
+  }
+
+  const base::TimeDelta delay_;
+  int fd_;
+  net::IPEndPoint endpoint_;
+  std::deque<Answer> answers_;
+  base::CancellationFlag quit_;
+
+  DISALLOW_COPY_AND_ASSIGN(LocalDnsServer);
+};
+
+// A HostResolverProc that sends an A query to |server| and blocks until the
+// answer is received, the way getaddrinfo() blocks the worker threads of
+// HostResolverImpl.
+class BlockingDnsProc : public net::HostResolverProc {
+ public:
+  explicit BlockingDnsProc(const net::IPEndPoint& server)
+      : net::HostResolverProc(NULL),
+        server_(server) {}
+
+  virtual int Resolve(const std::string& host,
+                      net::AddressFamily address_family,
+                      net::HostResolverFlags host_resolver_flags,
+                      net::AddressList* addrlist,
+                      int* os_error) {
+    std::string qname;
+    if (!net::DNSDomainFromDot(host, &qname))
+      return net::ERR_NAME_NOT_RESOLVED;
+    net::DnsQuery query(qname, net::kDNS_A, base::Bind(&NextQueryId));
+    net::DnsResponse response(&query);
+
+    struct sockaddr_storage address;
+    size_t address_len = sizeof(address);
+    if (!server_.ToSockAddr(reinterpret_cast<struct sockaddr*>(&address),
+                            &address_len)) {
+      return net::ERR_UNEXPECTED;
+    }
+    int fd = socket(AF_INET, SOCK_DGRAM, 0);
+    if (fd == -1)
+      return net::ERR_UNEXPECTED;
+    struct timeval timeout = { kReadTimeoutSeconds, 0 };
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+    int rv = net::ERR_DNS_TIMED_OUT;
+    ssize_t len = -1;
+    if (HANDLE_EINTR(connect(fd, reinterpret_cast<struct sockaddr*>(&address),
+                             address_len)) == 0 &&
+        HANDLE_EINTR(send(fd, query.io_buffer()->data(),
+                          query.io_buffer()->size(), 0)) > 0) {
+      len = HANDLE_EINTR(recv(fd, response.io_buffer()->data(),
+                              response.io_buffer()->size(), 0));
+    }
+    close(fd);
+
+    if (len > 0) {
+      net::IPAddressList ip_addresses;
+      rv = response.Parse(len, &ip_addresses);
+      if (rv == net::OK)
+        *addrlist = net::AddressList::CreateFromIPAddressList(ip_addresses, 0);
+    }
+    return rv;
+  }
+
+ private:
+  virtual ~BlockingDnsProc() {}
+
+  const net::IPEndPoint server_;
+
+  DISALLOW_COPY_AND_ASSIGN(BlockingDnsProc);
+};
+
+// Runs |lookups| lookups of distinct hostnames with |resolver|, keeping
+// |parallelism| of them in flight, and records their latencies.
+class LookupRunner {
+ public:
+  LookupRunner(net::HostResolver* resolver, int lookups, int parallelism)
+      : resolver_(resolver),
+        lookups_(lookups),
+        parallelism_(parallelism),
+        started_(0),
+        completed_(0),
+        errors_(0) {}
+
+  ~LookupRunner() {
+    for (size_t i = 0; i < slots_.size(); ++i)
+      delete slots_[i];
+  }
+
+  // Runs the lookups and returns the time they took.
+  base::TimeDelta Run() {
+    base::TimeTicks start = base::TimeTicks::Now();
+    for (int i = 0; i < parallelism_ && i < lookups_; ++i) {
+      slots_.push_back(new Slot(this));
+      StartLookup(slots_.back());
+    }
+    if (completed_ < lookups_)
+      MessageLoop::current()->Run();
+    return base::TimeTicks::Now() - start;
+  }
+
+  int errors() const { return errors_; }
+
+  // Returns the latency below which |percentile| percent of the lookups
+  // completed.
+  base::TimeDelta GetLatency(int percentile) {
+    DCHECK(!latencies_.empty());
+    std::sort(latencies_.begin(), latencies_.end());
+    size_t i = (latencies_.size() - 1) * percentile / 100;
+    return latencies_[i];
+  }
+
+ private:
+  // The state of one of the lookups in flight.
+  struct Slot {
+    explicit Slot(LookupRunner* runner)
+        : runner(runner),
+          ALLOW_THIS_IN_INITIALIZER_LIST(
+              callback(this, &Slot::OnLookupComplete)) {}
+
+    void OnLookupComplete(int result) {
+      runner->OnLookupComplete(this, result);
+    }
+
+    LookupRunner* const runner;
+    net::OldCompletionCallbackImpl<Slot> callback;
+    net::AddressList addresses;
+    base::TimeTicks start;
+  };
+
+  void StartLookup(Slot* slot) {
+    while (started_ < lookups_) {
+      // A distinct hostname for every lookup, so that none is merged with
+      // another one.
+      net::HostResolver::RequestInfo info(net::HostPortPair(
+          base::StringPrintf("host%d.example.com", started_++), 80));
+      info.set_address_family(net::ADDRESS_FAMILY_IPV4);
+      slot->start = base::TimeTicks::Now();
+      int rv = resolver_->Resolve(info, &slot->addresses, &slot->callback,
+                                  NULL, net::BoundNetLog());
+      if (rv == net::ERR_IO_PENDING)
+        return;
+      RecordResult(slot, rv);
+    }
+  }
+
+  void OnLookupComplete(Slot* slot, int result) {
+    RecordResult(slot, result);
+    if (completed_ == lookups_) {
+      MessageLoop::current()->Quit();
+      return;
+    }
+    StartLookup(slot);
+  }
+
+  void RecordResult(Slot* slot, int result) {
+    latencies_.push_back(base::TimeTicks::Now() - slot->start);
+    ++completed_;
+    if (result != net::OK)
+      ++errors_;
+  }
+
+  net::HostResolver* const resolver_;
+  const int lookups_;
+  const int parallelism_;
+  int started_;
+  int completed_;
+  int errors_;
+  std::vector<Slot*> slots_;
+  std::vector<base::TimeDelta> latencies_;
+
+  DISALLOW_COPY_AND_ASSIGN(LookupRunner);
+};
+
+// Runs the lookups with |resolver| and prints the results for |name|.
+bool RunBenchmark(const char* name, net::HostResolver* resolver, int lookups,
+                  int parallelism) {
+  LookupRunner runner(resolver, lookups, parallelism);
+  base::TimeDelta elapsed = runner.Run();
+  printf("%-9s lookups: %d, time: %.2fs, %.0f lookups/s, latency p50: "
+         "%.2fms, p99: %.2fms, max: %.2fms, errors: %d\n", name, lookups,
+         elapsed.InSecondsF(), lookups / elapsed.InSecondsF(),
+         runner.GetLatency(50).InMillisecondsF(),
+         runner.GetLatency(99).InMillisecondsF(),
+         runner.GetLatency(100).InMillisecondsF(), runner.errors());
+  return runner.errors() == 0;
+}
+
+// Returns a cache that doesn't keep any result.
+net::HostCache* CreateDisabledCache() {
+  return new net::HostCache(0, base::TimeDelta(), base::TimeDelta());
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  base::AtExitManager at_exit_manager;
+  CommandLine::Init(argc, argv);
+  const CommandLine& command_line = *CommandLine::ForCurrentProcess();
+
+  int lookups = 20000;
+  int parallelism = 8;
+  int delay_ms = 0;
+  if ((command_line.HasSwitch("lookups") &&
+       !base::StringToInt(command_line.GetSwitchValueASCII("lookups"),
+                          &lookups)) ||
+      (command_line.HasSwitch("parallelism") &&
+       !base::StringToInt(command_line.GetSwitchValueASCII("parallelism"),
+                          &parallelism)) ||
+      (command_line.HasSwitch("delay") &&
+       !base::StringToInt(command_line.GetSwitchValueASCII("delay"),
+                          &delay_ms)) ||
+      lookups <= 0 || parallelism <= 0 || delay_ms < 0) {
+    printf("Usage: dns_benchmark [--lookups=<number of lookups>] "
+           "[--parallelism=<lookups in flight>] "
+           "[--delay=<milliseconds before each answer>]\n");
+    return INVALID_ARGUMENT;
+  }
+
+  MessageLoopForIO message_loop;
+  LocalDnsServer server(base::TimeDelta::FromMilliseconds(delay_ms));
+  if (!server.Bind())
+    return GENERIC;
+  server.Start();
+
+  bool success;
+  {
+    // One worker thread per lookup in flight.
+    net::HostResolverImpl threaded_resolver(
+        new BlockingDnsProc(server.endpoint()), CreateDisabledCache(),
+        parallelism, 0, NULL);
+    success = RunBenchmark("threaded", &threaded_resolver, lookups,
+                           parallelism);
+  }
+  if (success) {
+    net::AsyncHostResolver async_resolver(
+        server.endpoint(), parallelism, lookups, base::Bind(&base::RandInt),
+        CreateDisabledCache(), NULL, NULL);
+    success = RunBenchmark("async", &async_resolver, lookups, parallelism);
+  }
+
+  server.Quit();
+  server.Join();
+  return success ? ALL_GOOD : GENERIC;
+}
@@ -30,6 +30,8 @@ int DumpContents(const std::wstring& input_path);
 int DumpHeaders(const std::wstring& input_path);
 int RunSlave(const std::wstring& input_path, const std::wstring& pipe_number);
 int CopyCache(const std::wstring& output_path, HANDLE pipe, bool copy_to_text);
+int UpgradeFromVersion2(const std::wstring& input_path,
+                        const std::wstring& output_path);
 HANDLE CreateServer(std::wstring* pipe_number);
 
 const char kUpgradeHelp[] =
@@ -133,6 +135,11 @@ int main(int argc, const char* argv[]) {
   if (!version)
     return FILE_ACCESS_ERROR;
 
+  // The current code knows how to convert files from version 2.x, so there is
+  // no need for another version of this tool.
+  if (upgrade && version == 2 && !command_line.HasSwitch(kSlave))
+    return UpgradeFromVersion2(input_path, output_path);
+
   if (version != disk_cache::kCurrentVersion >> 16) {
     if (command_line.HasSwitch(kSlave)) {
       printf("Unknown version\n");
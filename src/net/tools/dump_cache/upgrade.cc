@@ -3,6 +3,7 @@
 // found in the LICENSE file.
 
 #include "base/file_path.h"
+#include "base/file_util.h"
 #include "base/logging.h"
 #include "base/memory/scoped_ptr.h"
 #include "base/message_loop.h"
@@ -929,3 +930,43 @@ int RunSlave(const std::wstring& input_path, const std::wstring& pipe_number) {
   loop.Run();
   return 0;
 }
+
+// Upgrades a cache created with version 2.x of the file format. Version 3.0
+// only changed the block files, and the current code converts them when the
+// cache is opened in upgrade mode, so the files are copied to |output_path| and
+// opened there.
+int UpgradeFromVersion2(const std::wstring& input_path,
+                        const std::wstring& output_path) {
+  FilePath input = FilePath::FromWStringHack(input_path);
+  FilePath output = FilePath::FromWStringHack(output_path);
+  if (!file_util::CreateDirectory(output)) {
+    printf("Unable to create the output folder\n");
+    return -1;
+  }
+
+  file_util::FileEnumerator iter(input, false,
+                                 file_util::FileEnumerator::FILES);
+  for (FilePath file = iter.Next(); !file.empty(); file = iter.Next()) {
+    if (!file_util::CopyFile(file, output.Append(file.BaseName()))) {
+      printf("Unable to copy %ls\n", file.value().c_str());
+      return -1;
+    }
+  }
+
+  MessageLoop loop(MessageLoop::TYPE_IO);
+  base::Thread cache_thread("cache");
+  CHECK(cache_thread.StartWithOptions(
+      base::Thread::Options(MessageLoop::TYPE_IO, 0)));
+
+  scoped_ptr<disk_cache::BackendImpl> cache(
+      new disk_cache::BackendImpl(output, cache_thread.message_loop_proxy(),
+                                  NULL));
+  cache->SetUpgradeMode();
+  TestOldCompletionCallback cb;
+  int rv = cache->Init(&cb);
+  if (cb.GetResult(rv) != net::OK) {
+    printf("Unable to upgrade the cache files\n");
+    return -1;
+  }
+  return 0;
+}
@@ -4,13 +4,18 @@
 
 #include "build/build_config.h"
 
+#include <algorithm>
+#include <vector>
+
 #include "base/at_exit.h"
+#include "base/bind.h"
 #include "base/command_line.h"
 #include "base/lazy_instance.h"
 #include "base/message_loop.h"
 #include "base/metrics/stats_counters.h"
 #include "base/string_number_conversions.h"
 #include "base/string_util.h"
+#include "base/time.h"
 #include "net/base/cert_verifier.h"
 #include "net/base/completion_callback.h"
 #include "net/base/host_resolver.h"
@@ -27,8 +32,10 @@
 #include "net/proxy/proxy_service.h"
 
 void usage(const char* program_name) {
-  printf("usage: %s --url=<url>  [--n=<clients>] [--stats] [--use_cache]\n",
-         program_name);
+  printf("usage: %s --url=<url>  [--n=<clients>] [--requests=<requests>] "
+         "[--stats] [--use_cache]\n", program_name);
+  printf("  Every client issues <requests> requests (default 1) in a row. The\n"
+         "  request rate and latency percentiles are reported at the end.\n");
   exit(1);
 }
 
@@ -36,7 +43,8 @@ void usage(const char* program_name) {
 class Driver {
  public:
   Driver()
-      : clients_(0) {}
+      : clients_(0),
+        errors_(0) {}
 
   void ClientStarted() { clients_++; }
   void ClientStopped() {
@@ -45,8 +53,32 @@ class Driver {
     }
   }
 
+  void RequestCompleted(int result, base::TimeDelta latency) {
+    if (result < 0) {
+      errors_++;
+      return;
+    }
+    latencies_.push_back(latency);
+  }
+
+  int errors() const { return errors_; }
+
+  // Returns the latency that |percentile| percent of the successful requests
+  // did not exceed.
+  base::TimeDelta GetLatencyPercentile(int percentile) {
+    if (latencies_.empty())
+      return base::TimeDelta();
+    size_t index = latencies_.size() * percentile / 100;
+    index = std::min(index, latencies_.size() - 1);
+    std::nth_element(latencies_.begin(), latencies_.begin() + index,
+                     latencies_.end());
+    return latencies_[index];
+  }
+
  private:
   int clients_;
+  int errors_;
+  std::vector<base::TimeDelta> latencies_;
 };
 
 static base::LazyInstance<Driver> g_driver(base::LINKER_INITIALIZED);
@@ -54,37 +86,49 @@ static base::LazyInstance<Driver> g_driver(base::LINKER_INITIALIZED);
 // A network client
 class Client {
  public:
-  Client(net::HttpTransactionFactory* factory, const std::string& url) :
+  Client(net::HttpTransactionFactory* factory, const std::string& url,
+         int requests) :
+      factory_(factory),
       url_(url),
+      requests_left_(requests),
       buffer_(new net::IOBuffer(kBufferSize)),
       ALLOW_THIS_IN_INITIALIZER_LIST(
           connect_callback_(this, &Client::OnConnectComplete)),
       ALLOW_THIS_IN_INITIALIZER_LIST(
           read_callback_(this, &Client::OnReadComplete)) {
-    int rv = factory->CreateTransaction(&transaction_);
-    DCHECK_EQ(net::OK, rv);
     buffer_->AddRef();
     g_driver.Get().ClientStarted();
     request_info_.url = url_;
     request_info_.method = "GET";
-    int state = transaction_->Start(
-        &request_info_, &connect_callback_, net::BoundNetLog());
-    DCHECK(state == net::ERR_IO_PENDING);
+    StartRequest();
   };
 
  private:
+  void StartRequest() {
+    int rv = factory_->CreateTransaction(&transaction_);
+    DCHECK_EQ(net::OK, rv);
+    start_time_ = base::TimeTicks::Now();
+    int state = transaction_->Start(
+        &request_info_, &connect_callback_, net::BoundNetLog());
+    if (state != net::ERR_IO_PENDING)
+      OnConnectComplete(state);
+  }
+
   void OnConnectComplete(int result) {
+    if (result < 0) {
+      OnRequestComplete(result);
+      return;
+    }
+
     // Do work here.
     int state = transaction_->Read(buffer_.get(), kBufferSize, &read_callback_);
     if (state == net::ERR_IO_PENDING)
       return;  // IO has started.
-    if (state < 0)
-      return;  // ERROR!
     OnReadComplete(state);
   }
 
   void OnReadComplete(int result) {
-    if (result == 0) {
+    if (result <= 0) {
       OnRequestComplete(result);
       return;
     }
@@ -97,20 +141,33 @@ class Client {
     int state = transaction_->Read(buffer_.get(), kBufferSize, &read_callback_);
     if (state == net::ERR_IO_PENDING)
       return;  // IO has started.
-    if (state < 0)
-      return;  // ERROR!
     OnReadComplete(state);
   }
 
   void OnRequestComplete(int result) {
-    base::StatsCounter requests("FetchClient.requests");
-    requests.Increment();
+    g_driver.Get().RequestCompleted(result,
+                                    base::TimeTicks::Now() - start_time_);
+    if (result == net::OK) {
+      base::StatsCounter requests("FetchClient.requests");
+      requests.Increment();
+    }
+    if (--requests_left_ > 0) {
+      // The transaction is still running our callback, so it is replaced from
+      // a new task.
+      MessageLoop::current()->PostTask(
+          FROM_HERE,
+          base::Bind(&Client::StartRequest, base::Unretained(this)));
+      return;
+    }
     g_driver.Get().ClientStopped();
     printf(".");
   }
 
   static const int kBufferSize = (16 * 1024);
+  net::HttpTransactionFactory* factory_;
   GURL url_;
+  int requests_left_;
+  base::TimeTicks start_time_;
   net::HttpRequestInfo request_info_;
   scoped_ptr<net::HttpTransaction> transaction_;
   scoped_refptr<net::IOBuffer> buffer_;
@@ -133,6 +190,11 @@ int main(int argc, char** argv) {
     base::StringToInt(parsed_command_line.GetSwitchValueASCII("n"),
                       &client_limit);
   }
+  int requests_per_client = 1;
+  if (parsed_command_line.HasSwitch("requests")) {
+    base::StringToInt(parsed_command_line.GetSwitchValueASCII("requests"),
+                      &requests_per_client);
+  }
   bool use_cache = parsed_command_line.HasSwitch("use-cache");
 
   // Do work here.
@@ -176,21 +238,30 @@ int main(int argc, char** argv) {
 
     Client** clients = new Client*[client_limit];
     for (int i = 0; i < client_limit; i++)
-      clients[i] = new Client(factory, url);
+      clients[i] = new Client(factory, url, requests_per_client);
 
     MessageLoop::current()->Run();
   }
 
   // Print Statistics here.
-  int num_clients = table.GetCounterValue("c:FetchClient.requests");
+  int num_requests = table.GetCounterValue("c:FetchClient.requests");
   int test_time = table.GetCounterValue("t:FetchClient.total_time");
   int bytes_read = table.GetCounterValue("c:FetchClient.bytes_read");
 
   printf("\n");
-  printf("Clients     : %d\n", num_clients);
+  printf("Clients     : %d\n", client_limit);
+  printf("Requests    : %d\n", num_requests);
+  printf("Errors      : %d\n", g_driver.Get().errors());
   printf("Time        : %dms\n", test_time);
   printf("Bytes Read  : %d\n", bytes_read);
   if (test_time > 0) {
+    printf("Requests/s  : %.1f\n",
+           num_requests / (static_cast<double>(test_time) / 1000.0));
+    printf("Latency p50 : %.2fms\n",
+           g_driver.Get().GetLatencyPercentile(50).InMillisecondsF());
+    printf("Latency p99 : %.2fms\n",
+           g_driver.Get().GetLatencyPercentile(99).InMillisecondsF());
+
     const char *units = "bps";
     double bps = static_cast<float>(bytes_read * 8) /
         (static_cast<float>(test_time) / 1000.0);
@@ -9,6 +9,7 @@
 #include <string>
 #include <vector>
 
+#include "base/memory/scoped_ptr.h"
 #include "base/threading/simple_thread.h"
 #include "net/tools/flip_server/epoll_server.h"
 #include "net/tools/flip_server/sm_interface.h"
@@ -45,9 +46,22 @@ class SMAcceptorThread : public base::SimpleThread,
                          public EpollCallbackInterface,
                          public SMConnectionPoolInterface {
  public:
-  SMAcceptorThread(FlipAcceptor *acceptor, MemoryCache* memory_cache);
+  // Accepts the connections for |acceptor| that arrive at |listen_fd|. Several
+  // threads may serve the same acceptor, either sharing the listening socket
+  // or each one with its own SO_REUSEPORT socket.
+  SMAcceptorThread(FlipAcceptor *acceptor, int listen_fd,
+                   MemoryCache* memory_cache);
   virtual ~SMAcceptorThread();
 
+  // Pins the thread to |cpu| once it starts running. The default, -1, lets the
+  // thread run on any CPU.
+  void set_cpu(int cpu) { cpu_ = cpu; }
+
+  // If true, the thread serves from its own copy of the memory cache instead
+  // of the shared one. The copy is made by the thread itself (after it is
+  // pinned to its CPU), so its memory is allocated close to that CPU.
+  void set_copy_memory_cache(bool copy) { copy_memory_cache_ = copy; }
+
   // EpollCallbackInteface interface
   virtual void OnRegistration(EpollServer* eps, int fd, int event_mask) {}
   virtual void OnModification(int fd, int event_mask) {}
@@ -75,11 +89,18 @@ class SMAcceptorThread : public base::SimpleThread,
   virtual void Run();
 
  private:
+  // Binds the calling thread to |cpu_|.
+  void SetAffinity();
+
   EpollServer epoll_server_;
   FlipAcceptor* acceptor_;
+  int listen_fd_;
   SSLState* ssl_state_;
   bool use_ssl_;
   int idle_socket_timeout_s_;
+  time_t oldest_idle_time_;
+  int cpu_;
+  bool copy_memory_cache_;
 
   std::vector<SMConnection*> unused_server_connections_;
   std::vector<SMConnection*> tmp_unused_server_connections_;
@@ -87,6 +108,7 @@ class SMAcceptorThread : public base::SimpleThread,
   std::list<SMConnection*> active_server_connections_;
   Notification quitting_;
   MemoryCache* memory_cache_;
+  scoped_ptr<MemoryCache> local_memory_cache_;
 };
 
 }  // namespace net
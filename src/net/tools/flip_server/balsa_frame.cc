@@ -15,6 +15,7 @@
 #include <utility>
 #include <vector>
 
+#include "base/compiler_specific.h"
 #include "base/logging.h"
 #include "base/port.h"
 #include "base/string_piece.h"
@@ -39,13 +40,13 @@ BalsaFrame::BalsaFrame()
     : last_char_was_slash_r_(false),
       saw_non_newline_char_(false),
       start_was_space_(true),
-      chunk_length_character_extracted_(false),
       is_request_(true),
       request_was_head_(false),
       max_header_length_(16 * 1024),
       max_request_uri_length_(2048),
       visitor_(&do_nothing_visitor_),
-      chunk_length_remaining_(0),
+      ALLOW_THIS_IN_INITIALIZER_LIST(chunk_visitor_(this)),
+      chunk_parser_(&chunk_visitor_),
       content_length_remaining_(0),
       last_slash_n_loc_(NULL),
       last_recorded_slash_n_loc_(NULL),
@@ -62,13 +63,12 @@ void BalsaFrame::Reset() {
   last_char_was_slash_r_ = false;
   saw_non_newline_char_ = false;
   start_was_space_ = true;
-  chunk_length_character_extracted_ = false;
   // is_request_ = true;               // not reset between messages.
   // request_was_head_ = false;        // not reset between messages.
   // max_header_length_ = 4096;        // not reset between messages.
   // max_request_uri_length_ = 2048;   // not reset between messages.
   // visitor_ = &do_nothing_visitor_;  // not reset between messages.
-  chunk_length_remaining_ = 0;
+  chunk_parser_.Reset();
   content_length_remaining_ = 0;
   last_slash_n_loc_ = NULL;
   last_recorded_slash_n_loc_ = NULL;
@@ -1180,7 +1180,7 @@ size_t BalsaFrame::ProcessHeaders(const char* message_start,
 size_t BalsaFrame::BytesSafeToSplice() const {
   switch (parse_state_) {
     case BalsaFrameEnums::READING_CHUNK_DATA:
-      return chunk_length_remaining_;
+      return chunk_parser_.chunk_data_remaining();
     case BalsaFrameEnums::READING_UNTIL_CLOSE:
       return std::numeric_limits<size_t>::max();
     case BalsaFrameEnums::READING_CONTENT:
@@ -1193,9 +1193,10 @@ size_t BalsaFrame::BytesSafeToSplice() const {
 void BalsaFrame::BytesSpliced(size_t bytes_spliced) {
   switch (parse_state_) {
     case BalsaFrameEnums::READING_CHUNK_DATA:
-      if (chunk_length_remaining_ >= bytes_spliced) {
-        chunk_length_remaining_ -= bytes_spliced;
-        if (chunk_length_remaining_ == 0) {
+      if (static_cast<size_t>(chunk_parser_.chunk_data_remaining()) >=
+          bytes_spliced) {
+        chunk_parser_.SkipChunkData(bytes_spliced);
+        if (chunk_parser_.chunk_data_remaining() == 0) {
           parse_state_ = BalsaFrameEnums::READING_CHUNK_TERM;
         }
         return;
@@ -1232,15 +1233,63 @@ void BalsaFrame::BytesSpliced(size_t bytes_spliced) {
   visitor_->HandleBodyError(this);
 };
 
-// You may note that the state-machine contained within this function has both
-// switch and goto labels for nearly the same thing. For instance, the
-// following two labels refer to the same code block:
-//   label_reading_chunk_data:
-//   case BalsaFrameEnums::READING_CHUNK_DATA:
-// The 'case' statement is required for the switch statement which occurs when
-// ProcessInput is invoked. The goto label is required as the state-machine
-// does not use a computed goto in any subsequent operations.
-//
+void BalsaFrame::ChunkedBodyVisitor::FlushBodyInput(const char* end) {
+  if (end > input_) {
+    framer_->visitor_->ProcessBodyInput(input_, end - input_);
+    input_ = end;
+  }
+}
+
+void BalsaFrame::ChunkedBodyVisitor::OnChunkLength(int length) {
+  framer_->visitor_->ProcessChunkLength(length);
+}
+
+void BalsaFrame::ChunkedBodyVisitor::OnChunkExtensions(
+    const base::StringPiece& extensions) {
+  framer_->visitor_->ProcessChunkExtensions(extensions.data(),
+                                            extensions.size());
+}
+
+void BalsaFrame::ChunkedBodyVisitor::OnBodyData(
+    const base::StringPiece& data) {
+  FlushBodyInput(data.data() + data.size());
+  framer_->visitor_->ProcessBodyData(data.data(), data.size());
+}
+
+void BalsaFrame::ChunkedBodyVisitor::OnTrailer(
+    const base::StringPiece& trailer) {
+  FlushBodyInput(trailer.data());
+  framer_->visitor_->ProcessTrailerInput(trailer.data(), trailer.size());
+  input_ = trailer.data() + trailer.size();
+}
+
+// The chunked body is decoded by the same parser as the one used by the HTTP
+// stream of the network stack. Its state is reflected in parse_state_ only
+// as far as the users of the framer need it: whether the body is complete,
+// and whether chunk data can be spliced.
+size_t BalsaFrame::ProcessChunkedBody(const char* input, size_t size) {
+  chunk_visitor_.set_input(input);
+  int rv = chunk_parser_.ParseChunkedBody(input, static_cast<int>(size));
+  if (rv < 0) {
+    chunk_visitor_.FlushBodyInput(input + size);
+    parse_state_ = BalsaFrameEnums::PARSE_ERROR;
+    last_error_ = BalsaFrameEnums::INVALID_CHUNK_LENGTH;
+    visitor_->HandleChunkingError(this);
+    return size;
+  }
+
+  chunk_visitor_.FlushBodyInput(input + rv);
+  if (chunk_parser_.IsChunkedBodyComplete()) {
+    parse_state_ = BalsaFrameEnums::MESSAGE_FULLY_READ;
+    visitor_->MessageDone();
+  } else if (chunk_parser_.chunk_data_remaining() > 0) {
+    parse_state_ = BalsaFrameEnums::READING_CHUNK_DATA;
+  } else {
+    parse_state_ = BalsaFrameEnums::READING_CHUNK_LENGTH;
+  }
+  return rv;
+}
+
 // Since several states exit the state machine for various reasons, there is
 // also one label at the bottom of the function. When it is appropriate to
 // return from the function, that part of the state machine instead issues a
@@ -1249,7 +1298,6 @@ void BalsaFrame::BytesSpliced(size_t bytes_spliced) {
 // to be invoked when the function is exiting.
 size_t BalsaFrame::ProcessInput(const char* input, size_t size) {
   const char* current = input;
-  const char* on_entry = current;
   const char* end = current + size;
 #if DEBUGFRAMER
   LOG(INFO) << "\n=============="
@@ -1303,230 +1351,14 @@ size_t BalsaFrame::ProcessInput(const char* input, size_t size) {
 
   while (current < end) {
     switch (parse_state_) {
- label_reading_chunk_length:
       case BalsaFrameEnums::READING_CHUNK_LENGTH:
-        // In this state we read the chunk length.
-        // Note that once we hit a character which is not in:
-        // [0-9;A-Fa-f\n], we transition to a different state.
-        //
-        {
-          // If we used strtol, etc, we'd have to buffer this line.
-          // This is more annoying than simply doing the conversion
-          // here. This code accounts for overflow.
-          static const signed char buf[] = {
-            // %0  %1  %2  %3  %4  %5  %6  %7  %8  \t  \n  %b  %c  \r  %e  %f
-               -1, -1, -1, -1, -1, -1, -1, -1, -1, -2, -2, -1, -1, -2, -1, -1,
-            // %10 %11 %12 %13 %14 %15 %16 %17 %18 %19 %1a %1b %1c %1d %1e %1f
-               -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
-            // ' ' %21 %22 %23 %24 %25 %26 %27 %28 %29 %2a %2b %2c %2d %2e %2f
-               -2, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
-            // %30 %31 %32 %33 %34 %35 %36 %37 %38 %39 %3a ';' %3c %3d %3e %3f
-                0,  1,  2,  3,  4,  5,  6,  7,  8,  9, -1, -2, -1, -1, -1, -1,
-            // %40 'A' 'B' 'C' 'D' 'E' 'F' %47 %48 %49 %4a %4b %4c %4d %4e %4f
-               -1, 10, 11, 12, 13, 14, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1,
-            // %50 %51 %52 %53 %54 %55 %56 %57 %58 %59 %5a %5b %5c %5d %5e %5f
-               -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
-            // %60 'a' 'b' 'c' 'd' 'e' 'f' %67 %68 %69 %6a %6b %6c %6d %6e %6f
-               -1, 10, 11, 12, 13, 14, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1,
-            // %70 %71 %72 %73 %74 %75 %76 %77 %78 %79 %7a %7b %7c %7d %7e %7f
-               -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
-          };
-          // valid cases:
-          //  "09123\n"                      // -> 09123
-          //  "09123\r\n"                    // -> 09123
-          //  "09123  \n"                    // -> 09123
-          //  "09123  \r\n"                  // -> 09123
-          //  "09123  12312\n"               // -> 09123
-          //  "09123  12312\r\n"             // -> 09123
-          //  "09123; foo=bar\n"             // -> 09123
-          //  "09123; foo=bar\r\n"           // -> 09123
-          //  "FFFFFFFFFFFFFFFF\r\n"         // -> FFFFFFFFFFFFFFFF
-          //  "FFFFFFFFFFFFFFFF 22\r\n"      // -> FFFFFFFFFFFFFFFF
-          // invalid cases:
-          // "[ \t]+[^\n]*\n"
-          // "FFFFFFFFFFFFFFFFF\r\n"  (would overflow)
-          // "\r\n"
-          // "\n"
-          while (current < end) {
-            const char c = *current;
-            ++current;
-            const signed char addition = buf[static_cast<int>(c)];
-            if (addition >= 0) {
-              chunk_length_character_extracted_ = true;
-              size_t length_x_16 = chunk_length_remaining_ * 16;
-              const size_t kMaxDiv16 = std::numeric_limits<size_t>::max() / 16;
-              if ((chunk_length_remaining_ > kMaxDiv16) ||
-                  ((std::numeric_limits<size_t>::max() - length_x_16) <
-                   static_cast<size_t>(addition))) {
-                // overflow -- asked for a chunk-length greater than 2^64 - 1!!
-                parse_state_ = BalsaFrameEnums::PARSE_ERROR;
-                last_error_ = BalsaFrameEnums::CHUNK_LENGTH_OVERFLOW;
-                visitor_->ProcessBodyInput(on_entry, current - on_entry);
-                visitor_->HandleChunkingError(this);
-                goto bottom;
-              }
-              chunk_length_remaining_ = length_x_16 + addition;
-              continue;
-            }
-
-            if (!chunk_length_character_extracted_ || addition == -1) {
-              // ^[0-9;A-Fa-f][ \t\n] -- was not matched, either because no
-              // characters were converted, or an unexpected character was
-              // seen.
-              parse_state_ = BalsaFrameEnums::PARSE_ERROR;
-              last_error_ = BalsaFrameEnums::INVALID_CHUNK_LENGTH;
-              visitor_->ProcessBodyInput(on_entry, current - on_entry);
-              visitor_->HandleChunkingError(this);
-              goto bottom;
-            }
-
-            --current;
-            parse_state_ = BalsaFrameEnums::READING_CHUNK_EXTENSION;
-            visitor_->ProcessChunkLength(chunk_length_remaining_);
-            goto label_reading_chunk_extension;
-          }
-        }
-        visitor_->ProcessBodyInput(on_entry, current - on_entry);
-        goto bottom;  // case BalsaFrameEnums::READING_CHUNK_LENGTH
-
- label_reading_chunk_extension:
       case BalsaFrameEnums::READING_CHUNK_EXTENSION:
-        {
-          // TODO(phython): Convert this scanning to be 16 bytes at a time if
-          // there is data to be read.
-          const char* extensions_start = current;
-          size_t extensions_length = 0;
-          while (current < end) {
-            const char c = *current;
-            if (c == '\r' || c == '\n') {
-              extensions_length =
-                  (extensions_start == current) ?
-                  0 :
-                  current - extensions_start - 1;
-            }
-
-            ++current;
-            if (c == '\n') {
-              chunk_length_character_extracted_ = false;
-              visitor_->ProcessChunkExtensions(
-                  extensions_start, extensions_length);
-              if (chunk_length_remaining_ != 0) {
-                parse_state_ = BalsaFrameEnums::READING_CHUNK_DATA;
-                goto label_reading_chunk_data;
-              }
-              HeaderFramingFound('\n');
-              parse_state_ = BalsaFrameEnums::READING_LAST_CHUNK_TERM;
-              goto label_reading_last_chunk_term;
-            }
-          }
-          visitor_->ProcessChunkExtensions(
-              extensions_start, extensions_length);
-        }
-
-        visitor_->ProcessBodyInput(on_entry, current - on_entry);
-        goto bottom;  // case BalsaFrameEnums::READING_CHUNK_EXTENSION
-
- label_reading_chunk_data:
       case BalsaFrameEnums::READING_CHUNK_DATA:
-        while (current < end) {
-          if (chunk_length_remaining_ == 0) {
-            break;
-          }
-          // read in the chunk
-          size_t bytes_remaining = end - current;
-          size_t consumed_bytes = (chunk_length_remaining_ < bytes_remaining) ?
-            chunk_length_remaining_ : bytes_remaining;
-          const char* tmp_current = current + consumed_bytes;
-          visitor_->ProcessBodyInput(on_entry, tmp_current - on_entry);
-          visitor_->ProcessBodyData(current, consumed_bytes);
-          on_entry = current = tmp_current;
-          chunk_length_remaining_ -= consumed_bytes;
-        }
-        if (chunk_length_remaining_ == 0) {
-          parse_state_ = BalsaFrameEnums::READING_CHUNK_TERM;
-          goto label_reading_chunk_term;
-        }
-        visitor_->ProcessBodyInput(on_entry, current - on_entry);
-        goto bottom;  // case BalsaFrameEnums::READING_CHUNK_DATA
-
- label_reading_chunk_term:
       case BalsaFrameEnums::READING_CHUNK_TERM:
-        while (current < end) {
-          const char c = *current;
-          ++current;
-
-          if (c == '\n') {
-            parse_state_ = BalsaFrameEnums::READING_CHUNK_LENGTH;
-            goto label_reading_chunk_length;
-          }
-        }
-        visitor_->ProcessBodyInput(on_entry, current - on_entry);
-        goto bottom;  // case BalsaFrameEnums::READING_CHUNK_TERM
-
- label_reading_last_chunk_term:
       case BalsaFrameEnums::READING_LAST_CHUNK_TERM:
-        while (current < end) {
-          const char c = *current;
-
-          if (!HeaderFramingFound(c)) {
-            // If not, however, since the spec only suggests that the
-            // client SHOULD indicate the presence of trailers, we get to
-            // *test* that they did or didn't.
-            // If all of the bytes we've seen since:
-            //   OPTIONAL_WS 0 OPTIONAL_STUFF CRLF
-            // are either '\r', or '\n', then we can assume that we don't yet
-            // know if we need to parse headers, or if the next byte will make
-            // the HeaderFramingFound condition (above) true.
-            if (HeaderFramingMayBeFound()) {
-              // If true, then we have seen only characters '\r' or '\n'.
-              ++current;
-
-              // Lets try again! There is no state change here.
-              continue;
-            } else {
-              // If (!HeaderFramingMayBeFound()), then we know that we must be
-              // reading the first non CRLF character of a trailer.
-              parse_state_ = BalsaFrameEnums::READING_TRAILER;
-              visitor_->ProcessBodyInput(on_entry, current - on_entry);
-              on_entry = current;
-              goto label_reading_trailer;
-            }
-          } else {
-            // If we've found a "\r\n\r\n", then the message
-            // is done.
-            ++current;
-            parse_state_ = BalsaFrameEnums::MESSAGE_FULLY_READ;
-            visitor_->ProcessBodyInput(on_entry, current - on_entry);
-            visitor_->MessageDone();
-            goto bottom;
-          }
-          break;  // from while loop
-        }
-        visitor_->ProcessBodyInput(on_entry, current - on_entry);
-        goto bottom;  // case BalsaFrameEnums::READING_LAST_CHUNK_TERM
-
- label_reading_trailer:
       case BalsaFrameEnums::READING_TRAILER:
-        while (current < end) {
-          const char c = *current;
-          ++current;
-          // TODO(fenix): If we ever care about trailers as part of framing,
-          // deal with them here (see below for part of the 'solution')
-          // if (LineFramingFound(c)) {
-          // trailer_lines_.push_back(make_pair(start_of_line_,
-          //                                   trailer_length_ - 1));
-          // start_of_line_ = trailer_length_;
-          // }
-          if (HeaderFramingFound(c)) {
-            // ProcessTrailers(visitor_, &trailers_);
-            parse_state_ = BalsaFrameEnums::MESSAGE_FULLY_READ;
-            visitor_->ProcessTrailerInput(on_entry, current - on_entry);
-            visitor_->MessageDone();
-            goto bottom;
-          }
-        }
-        visitor_->ProcessTrailerInput(on_entry, current - on_entry);
-        break;  // case BalsaFrameEnums::READING_TRAILER
+        current += ProcessChunkedBody(current, end - current);
+        goto bottom;
 
         // Note that there is no label:
         //   'label_reading_until_close'
@@ -12,6 +12,8 @@
 #include <vector>
 
 #include "base/port.h"
+#include "base/string_piece.h"
+#include "net/http/http_parser.h"
 #include "net/tools/flip_server/balsa_enums.h"
 #include "net/tools/flip_server/balsa_headers.h"
 #include "net/tools/flip_server/balsa_visitor_interface.h"
@@ -166,6 +168,10 @@ class BalsaFrame {
 
   void AssignParseStateAfterHeadersHaveBeenParsed();
 
+  // Decodes a part of a chunked body with |chunk_parser_|. Returns the number
+  // of bytes consumed.
+  size_t ProcessChunkedBody(const char* input, size_t size);
+
   inline bool LineFramingFound(char current_char) {
     return current_char == '\n';
   }
@@ -202,6 +208,30 @@ class BalsaFrame {
   }
 
  private:
+  // Forwards the chunked body decoded by |chunk_parser_| to the visitor of
+  // the framer. The framing bytes are reported as body input along with the
+  // data, in order.
+  class ChunkedBodyVisitor : public HttpParser::Visitor {
+   public:
+    explicit ChunkedBodyVisitor(BalsaFrame* framer)
+        : framer_(framer), input_(NULL) {}
+
+    void set_input(const char* input) { input_ = input; }
+
+    // Reports the input up to |end| that hasn't been reported yet.
+    void FlushBodyInput(const char* end);
+
+    virtual void OnChunkLength(int length);
+    virtual void OnChunkExtensions(const base::StringPiece& extensions);
+    virtual void OnBodyData(const base::StringPiece& data);
+    virtual void OnTrailer(const base::StringPiece& trailer);
+
+   private:
+    BalsaFrame* framer_;
+    // The first byte of input not reported to the visitor yet.
+    const char* input_;
+  };
+
   class DoNothingBalsaVisitor : public BalsaVisitorInterface {
     virtual void ProcessBodyInput(const char *input, size_t size) {}
     virtual void ProcessBodyData(const char *input, size_t size) {}
@@ -237,13 +267,13 @@ class BalsaFrame {
   bool last_char_was_slash_r_;
   bool saw_non_newline_char_;
   bool start_was_space_;
-  bool chunk_length_character_extracted_;
   bool is_request_;                // This is not reset in Reset()
   bool request_was_head_;          // This is not reset in Reset()
   size_t max_header_length_;       // This is not reset in Reset()
   size_t max_request_uri_length_;  // This is not reset in Reset()
   BalsaVisitorInterface* visitor_;
-  size_t chunk_length_remaining_;
+  ChunkedBodyVisitor chunk_visitor_;
+  HttpParser chunk_parser_;
   size_t content_length_remaining_;
   const char* last_slash_n_loc_;
   const char* last_recorded_slash_n_loc_;
@@ -13,6 +13,9 @@ const int kSpdyOverhead = spdy::SpdyFrame::size();
 const int kInitialDataSendersThreshold = (2 * kMSS) - kSpdyOverhead;
 const int kSSLSegmentSize = (1 * kMSS) - kSSLOverhead;
 const int kSpdySegmentSize = kSSLSegmentSize - kSpdyOverhead;
+// Mapped bodies are sent in larger segments, because plain connections send
+// them with sendfile() instead of copying each segment.
+const int kMappedBodySegmentSize = 256 * 1024;
 
 #define ACCEPTOR_CLIENT_IDENT \
     acceptor_->listen_ip_ << ":" \
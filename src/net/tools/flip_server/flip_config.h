@@ -42,6 +42,12 @@ class FlipAcceptor {
                void *memory_cache);
   ~FlipAcceptor();
 
+  // Returns a socket for one more acceptor thread to accept connections on.
+  // With SO_REUSEPORT, this is a new socket bound to the same address, and the
+  // kernel spreads the incoming connections among all of them. Otherwise every
+  // thread shares |listen_fd_|. Returns -1 on failure.
+  int GetListenFDForThread();
+
   enum FlipHandlerType flip_handler_type_;
   std::string listen_ip_;
   std::string listen_port_;
@@ -56,10 +62,17 @@ class FlipAcceptor {
   bool disable_nagle_;
   int accepts_per_wake_;
   int listen_fd_;
+  bool reuseport_;
+  bool wait_for_iface_;
   void* memory_cache_;
   int ssl_session_expiry_;
   bool ssl_disable_compression_;
   int idle_socket_timeout_s_;
+
+ private:
+  // Creates a listening socket for |listen_ip_|:|listen_port_| and stores it
+  // in |listen_fd|. Returns false on failure.
+  bool CreateListenFD(int* listen_fd);
 };
 
 class FlipConfig {
@@ -14,7 +14,9 @@
 #include "base/command_line.h"
 #include "base/logging.h"
 #include "base/synchronization/lock.h"
+#include "base/sys_info.h"
 #include "base/timer.h"
+#include "net/spdy/spdy_framer.h"
 #include "net/tools/flip_server/acceptor_thread.h"
 #include "net/tools/flip_server/constants.h"
 #include "net/tools/flip_server/flip_config.h"
@@ -46,6 +48,22 @@ int32 FLAGS_accept_backlog_size = 1024;
 //  SO_REUSEPORT);
 bool FLAGS_reuseport = false;
 
+// The number of threads that accept and serve the connections of each
+//  acceptor. Every thread runs its own epoll loop.
+int32 FLAGS_acceptor_threads = 1;
+
+// If true, each acceptor thread is pinned to its own cpu (round-robin
+//  over the available cpus).
+bool FLAGS_cpu_affinity = false;
+
+// If true, each acceptor thread of the spdy and http servers serves from
+//  its own copy of the memory cache instead of the shared one.
+bool FLAGS_per_thread_cache = false;
+
+// If true, the memory caches map the capture files, and plain http
+//  connections send the bodies with sendfile().
+bool FLAGS_mmap_cache = false;
+
 // Flag to force spdy, even if NPN is not negotiated.
 bool FLAGS_force_spdy = false;
 
@@ -203,7 +221,23 @@ int main (int argc, char**argv)
          << " raised.\n";
     cout << "\t--ssl-session-expiry=<seconds> (default is 300)\n";
     cout << "\t--ssl-disable-compression\n";
+    cout << "\t--spdy-lean-compression\n";
+    cout << "\t  * Trade some CPU for less memory per idle SPDY session.\n";
     cout << "\t--idle-timeout=<seconds> (default is 300)\n";
+    cout << "\t--acceptor-threads=<n> (default is 1)\n";
+    cout << "\t  * The number of threads that serve each acceptor.\n";
+    cout << "\t--reuseport\n";
+    cout << "\t  * Give every acceptor thread its own SO_REUSEPORT listen"
+         << " socket.\n";
+    cout << "\t--cpu-affinity\n";
+    cout << "\t  * Pin every acceptor thread to its own cpu.\n";
+    cout << "\t--mmap-cache\n";
+    cout << "\t  * Map the cached files and send the bodies of plain http"
+         << " responses\n"
+         << "\t    with sendfile().\n";
+    cout << "\t--per-thread-cache\n";
+    cout << "\t  * Give every server thread its own copy of the memory"
+         << " cache.\n";
     cout << "\t--pidfile=<filepath> (default /var/run/flip-server.pid)\n";
     cout << "\t--help\n";
     exit(0);
@@ -264,6 +298,9 @@ int main (int argc, char**argv)
     g_proxy_config.ssl_disable_compression_ = true;
   }
 
+  if (cl.HasSwitch("spdy-lean-compression"))
+    spdy::SpdyFramer::set_lean_compression_default(true);
+
   if (cl.HasSwitch("idle-timeout")) {
     g_proxy_config.idle_socket_timeout_s_ =
       atoi(cl.GetSwitchValueASCII("idle-timeout").c_str());
@@ -272,6 +309,25 @@ int main (int argc, char**argv)
   if (cl.HasSwitch("force_spdy"))
     net::SMConnection::set_force_spdy(true);
 
+  if (cl.HasSwitch("acceptor-threads")) {
+    FLAGS_acceptor_threads =
+      atoi(cl.GetSwitchValueASCII("acceptor-threads").c_str());
+    if (FLAGS_acceptor_threads < 1)
+      FLAGS_acceptor_threads = 1;
+  }
+
+  if (cl.HasSwitch("reuseport"))
+    FLAGS_reuseport = true;
+
+  if (cl.HasSwitch("cpu-affinity"))
+    FLAGS_cpu_affinity = true;
+
+  if (cl.HasSwitch("per-thread-cache"))
+    FLAGS_per_thread_cache = true;
+
+  if (cl.HasSwitch("mmap-cache"))
+    FLAGS_mmap_cache = true;
+
   InitLogging(g_proxy_config.log_filename_.c_str(),
               g_proxy_config.log_destination_,
               logging::DONT_LOCK_LOG_FILE,
@@ -297,8 +353,17 @@ int main (int argc, char**argv)
             << g_proxy_config.ssl_session_expiry_;
   LOG(INFO) << "SSL disable compression : "
             << g_proxy_config.ssl_disable_compression_;
+  LOG(INFO) << "SPDY lean compression   : "
+            << (cl.HasSwitch("spdy-lean-compression")?"true":"false");
   LOG(INFO) << "Connection idle timeout : "
             << g_proxy_config.idle_socket_timeout_s_;
+  LOG(INFO) << "Acceptor threads        : " << FLAGS_acceptor_threads;
+  LOG(INFO) << "CPU affinity            : "
+            << (FLAGS_cpu_affinity?"true":"false");
+  LOG(INFO) << "Per thread cache        : "
+            << (FLAGS_per_thread_cache?"true":"false");
+  LOG(INFO) << "Mmap cache              : "
+            << (FLAGS_mmap_cache?"true":"false");
 
   // Proxy Acceptors
   while (true) {
@@ -331,6 +396,7 @@ int main (int argc, char**argv)
   // Spdy Server Acceptor
   net::MemoryCache spdy_memory_cache;
   if (cl.HasSwitch("spdy-server")) {
+    spdy_memory_cache.set_map_files(FLAGS_mmap_cache);
     spdy_memory_cache.AddFiles();
     std::string value = cl.GetSwitchValueASCII("spdy-server");
     std::vector<std::string> valueArgs = split(value, ',');
@@ -352,6 +418,7 @@ int main (int argc, char**argv)
   // Spdy Server Acceptor
   net::MemoryCache http_memory_cache;
   if (cl.HasSwitch("http-server")) {
+    http_memory_cache.set_map_files(FLAGS_mmap_cache);
     http_memory_cache.AddFiles();
     std::string value = cl.GetSwitchValueASCII("http-server");
     std::vector<std::string> valueArgs = split(value, ',');
@@ -372,22 +439,29 @@ int main (int argc, char**argv)
 
   std::vector<net::SMAcceptorThread*> sm_worker_threads_;
 
+  int num_cpus = base::SysInfo::NumberOfProcessors();
   for (i = 0; i < g_proxy_config.acceptors_.size(); i++) {
     net::FlipAcceptor *acceptor = g_proxy_config.acceptors_[i];
 
-    sm_worker_threads_.push_back(
-        new net::SMAcceptorThread(acceptor,
-                                  (net::MemoryCache *)acceptor->memory_cache_));
-    // Note that spdy_memory_cache is not threadsafe, it is merely
-    // thread compatible. Thus, if ever we are to spawn multiple threads,
-    // we either must make the MemoryCache threadsafe, or use
-    // a separate MemoryCache for each thread.
-    //
-    // The latter is what is currently being done as we spawn
-    // a separate thread for each http and spdy server acceptor.
-
-    sm_worker_threads_.back()->InitWorker();
-    sm_worker_threads_.back()->Start();
+    // The MemoryCache is filled before any thread starts and it is read-only
+    // afterwards, so all the threads of an acceptor can share it.
+    for (int j = 0; j < FLAGS_acceptor_threads; j++) {
+      int listen_fd = j ? acceptor->GetListenFDForThread() :
+                          acceptor->listen_fd_;
+      if (listen_fd == -1)
+        break;
+      net::MemoryCache* memory_cache =
+          static_cast<net::MemoryCache*>(acceptor->memory_cache_);
+      net::SMAcceptorThread* thread =
+          new net::SMAcceptorThread(acceptor, listen_fd, memory_cache);
+      if (FLAGS_cpu_affinity)
+        thread->set_cpu(sm_worker_threads_.size() % num_cpus);
+      thread->set_copy_memory_cache(FLAGS_per_thread_cache);
+      sm_worker_threads_.push_back(thread);
+
+      thread->InitWorker();
+      thread->Start();
+    }
   }
 
   while (!wantExit) {
@@ -0,0 +1,220 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// This command-line program measures how fast the flip server sends a large
+// static response over plain HTTP. The response is sent by an acceptor thread
+// of the server to a client on the same machine, first from a memory cache
+// that keeps the body in the heap (the body is copied into every data frame),
+// and then from a memory cache that maps the file (the body is sent with
+// sendfile(), see --mmap-cache). For each mode it reports the throughput and
+// the CPU time used by the server thread per GB of body sent.
+//
+// Usage: flip_send_benchmark [--size=<body bytes>] [--total=<bytes to send>]
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <stdio.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <string>
+#include <vector>
+
+#include "base/at_exit.h"
+#include "base/command_line.h"
+#include "base/eintr_wrapper.h"
+#include "base/file_path.h"
+#include "base/file_util.h"
+#include "base/format_macros.h"
+#include "base/memory/scoped_ptr.h"
+#include "base/scoped_temp_dir.h"
+#include "base/string_number_conversions.h"
+#include "base/string_split.h"
+#include "base/stringprintf.h"
+#include "base/time.h"
+#include "net/tools/flip_server/acceptor_thread.h"
+#include "net/tools/flip_server/flip_config.h"
+#include "net/tools/flip_server/mem_cache.h"
+
+// Defined in mem_cache.cc.
+extern std::string FLAGS_cache_base_dir;
+
+namespace {
+
+enum Errors {
+  GENERIC = -1,
+  ALL_GOOD = 0,
+  INVALID_ARGUMENT = 1,
+};
+
+const char kHost[] = "www.example.com";
+const char kFile[] = "body.html";
+
+// The end of a chunked response.
+const char kLastChunk[] = "\r\n0\r\n\r\n";
+
+const int kReadBufferSize = 256 * 1024;
+
+// Returns the CPU time, in seconds, used so far by the thread |tid| of this
+// process, or a negative value on failure.
+double GetThreadCpuTime(base::PlatformThreadId tid) {
+  std::string stat;
+  FilePath path(base::StringPrintf("/proc/self/task/%d/stat", tid));
+  if (!file_util::ReadFileToString(path, &stat))
+    return -1;
+
+  // The command name is in parentheses and may contain spaces. utime and
+  // stime are the 12th and 13th fields after it.
+  size_t end = stat.rfind(')');
+  if (end == std::string::npos)
+    return -1;
+  std::vector<std::string> fields;
+  base::SplitStringAlongWhitespace(stat.substr(end + 1), &fields);
+  int64 utime, stime;
+  if (fields.size() < 13 || !base::StringToInt64(fields[11], &utime) ||
+      !base::StringToInt64(fields[12], &stime)) {
+    return -1;
+  }
+  return static_cast<double>(utime + stime) / sysconf(_SC_CLK_TCK);
+}
+
+// Writes a capture of a |size| bytes response to the cache folder at |path|.
+bool WriteCapture(const FilePath& path, int size) {
+  FilePath folder = path.AppendASCII("GET_").AppendASCII(kHost);
+  if (!file_util::CreateDirectory(folder))
+    return false;
+
+  // Without a Content-Length, the rest of the capture is the body, so that it
+  // can be served from the mapped file.
+  std::string capture("HTTP/1.1 200 OK\r\nContent-Type: text/html\r\n\r\n");
+  capture.append(size, 'x');
+  int written = file_util::WriteFile(folder.AppendASCII(kFile), capture.data(),
+                                     capture.size());
+  return written == static_cast<int>(capture.size());
+}
+
+bool WriteAll(int fd, const std::string& data) {
+  size_t offset = 0;
+  while (offset < data.size()) {
+    ssize_t rv = HANDLE_EINTR(write(fd, data.data() + offset,
+                                    data.size() - offset));
+    if (rv <= 0)
+      return false;
+    offset += rv;
+  }
+  return true;
+}
+
+// Reads a chunked response from |fd|. Returns false on failure.
+bool ReadResponse(int fd, char* buffer) {
+  const size_t kTailSize = sizeof(kLastChunk) - 1;
+  std::string tail;
+  while (true) {
+    ssize_t rv = HANDLE_EINTR(read(fd, buffer, kReadBufferSize));
+    if (rv <= 0)
+      return false;
+    if (static_cast<size_t>(rv) >= kTailSize) {
+      tail.assign(buffer + rv - kTailSize, kTailSize);
+    } else {
+      tail.append(buffer, rv);
+      if (tail.size() > kTailSize)
+        tail.erase(0, tail.size() - kTailSize);
+    }
+    if (tail == kLastChunk)
+      return true;
+  }
+}
+
+// Requests the response from a server that uses |cache| until |total| bytes
+// of body have been received, and prints the results for |mode|.
+bool RunBenchmark(const char* mode, net::MemoryCache* cache, int size,
+                  int64 total) {
+  net::FlipAcceptor acceptor(net::FLIP_HANDLER_HTTP_SERVER, "127.0.0.1", "0",
+                             "", "", "", "", "", "", 0, 1024, true, 0, false,
+                             false, cache);
+  if (acceptor.listen_fd_ == -1)
+    return false;
+  struct sockaddr_in address;
+  socklen_t address_len = sizeof(address);
+  if (getsockname(acceptor.listen_fd_,
+                  reinterpret_cast<struct sockaddr*>(&address),
+                  &address_len) < 0) {
+    return false;
+  }
+
+  net::SMAcceptorThread thread(&acceptor, acceptor.listen_fd_, cache);
+  thread.InitWorker();
+  thread.Start();
+
+  int fd = socket(AF_INET, SOCK_STREAM, 0);
+  bool success = fd != -1 &&
+      connect(fd, reinterpret_cast<struct sockaddr*>(&address),
+              address_len) == 0;
+
+  std::string request = base::StringPrintf(
+      "GET /%s/%s HTTP/1.1\r\nHost: 127.0.0.1\r\n\r\n", kHost, kFile);
+  scoped_array<char> buffer(new char[kReadBufferSize]);
+  int64 received = 0;
+  double cpu_start = GetThreadCpuTime(thread.tid());
+  base::TimeTicks start = base::TimeTicks::Now();
+  while (success && received < total) {
+    success = WriteAll(fd, request) && ReadResponse(fd, buffer.get());
+    received += size;
+  }
+  base::TimeDelta elapsed = base::TimeTicks::Now() - start;
+  double cpu = GetThreadCpuTime(thread.tid()) - cpu_start;
+
+  if (fd != -1)
+    close(fd);
+  thread.Quit();
+  thread.Join();
+  close(acceptor.listen_fd_);
+  if (!success)
+    return false;
+
+  double gigabytes = static_cast<double>(received) / (1024 * 1024 * 1024);
+  printf("%-6s bytes: %" PRId64 ", time: %.2fs, throughput: %.1f MB/s, "
+         "server cpu: %.2fs per GB\n", mode, received, elapsed.InSecondsF(),
+         gigabytes * 1024 / elapsed.InSecondsF(), cpu / gigabytes);
+  return true;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  base::AtExitManager at_exit_manager;
+  CommandLine::Init(argc, argv);
+  const CommandLine& command_line = *CommandLine::ForCurrentProcess();
+
+  int size = 16 * 1024 * 1024;
+  int64 total = 2LL * 1024 * 1024 * 1024;
+  if ((command_line.HasSwitch("size") &&
+       !base::StringToInt(command_line.GetSwitchValueASCII("size"), &size)) ||
+      (command_line.HasSwitch("total") &&
+       !base::StringToInt64(command_line.GetSwitchValueASCII("total"),
+                            &total)) ||
+      size <= 0 || total <= 0) {
+    printf("Usage: flip_send_benchmark [--size=<body bytes>] "
+           "[--total=<bytes to send>]\n");
+    return INVALID_ARGUMENT;
+  }
+
+  ScopedTempDir folder;
+  if (!folder.CreateUniqueTempDir() || !WriteCapture(folder.path(), size))
+    return GENERIC;
+  FLAGS_cache_base_dir = folder.path().value();
+
+  net::MemoryCache copy_cache;
+  copy_cache.AddFiles();
+  if (!RunBenchmark("copy", &copy_cache, size, total))
+    return GENERIC;
+
+  net::MemoryCache mapped_cache;
+  mapped_cache.set_map_files(true);
+  mapped_cache.AddFiles();
+  if (!RunBenchmark("mapped", &mapped_cache, size, total))
+    return GENERIC;
+
+  return ALL_GOOD;
+}
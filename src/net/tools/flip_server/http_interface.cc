@@ -173,7 +173,7 @@ void HttpSM::ResetForNewConnection() {
   }
   // Message has not been fully read, either it is incomplete or the
   // server is closing the connection to signal message end.
-  if (!MessageFullyRead()) {
+  if (sm_spdy_interface_ && !MessageFullyRead()) {
     VLOG(2) << "HTTP response closed before end of file detected. "
             << "Sending EOF to spdy.";
     sm_spdy_interface_->SendEOF(stream_id_);
@@ -317,6 +317,31 @@ void HttpSM::SendDataFrameImpl(uint32 stream_id, const char* data, int64 len,
   EnqueueDataFrame(df);
 }
 
+void HttpSM::SendMappedDataFrame(const FileData* file_data, size_t offset,
+                                 size_t len) {
+  char chunk_buf[128];
+  snprintf(chunk_buf, sizeof(chunk_buf), "%x\r\n", (unsigned int)len);
+  DataFrame* df = new DataFrame;
+  df->size = strlen(chunk_buf);
+  char* buffer = new char[df->size];
+  df->data = buffer;
+  df->delete_when_done = true;
+  memcpy(buffer, chunk_buf, df->size);
+  EnqueueDataFrame(df);
+
+  df = new DataFrame;
+  df->data = file_data->mapped_body + offset;
+  df->size = len;
+  df->file_fd = file_data->fd;
+  df->file_offset = file_data->body_offset + offset;
+  EnqueueDataFrame(df);
+
+  df = new DataFrame;
+  df->data = "\r\n";
+  df->size = 2;
+  EnqueueDataFrame(df);
+}
+
 void HttpSM::EnqueueDataFrame(DataFrame* df) {
   VLOG(2) << ACCEPTOR_CLIENT_IDENT << "HttpSM: Enqueue data frame: stream "
           << stream_id_;
@@ -338,7 +363,7 @@ void HttpSM::GetOutput() {
             << "header stream_id: [" << mci->stream_id << "]";
     return;
   }
-  if (mci->body_bytes_consumed >= mci->file_data->body.size()) {
+  if (mci->body_bytes_consumed >= mci->file_data->body_size()) {
     SendEOF(mci->stream_id);
     output_ordering_.RemoveStreamId(mci->stream_id);
     VLOG(2) << ACCEPTOR_CLIENT_IDENT << "GetOutput remove_stream_id: ["
@@ -346,13 +371,19 @@ void HttpSM::GetOutput() {
     return;
   }
   size_t num_to_write =
-    mci->file_data->body.size() - mci->body_bytes_consumed;
-  if (num_to_write > mci->max_segment_size)
-    num_to_write = mci->max_segment_size;
-
-  SendDataFrame(mci->stream_id,
-                mci->file_data->body.data() + mci->body_bytes_consumed,
-                num_to_write, 0, true);
+    mci->file_data->body_size() - mci->body_bytes_consumed;
+  if (mci->file_data->mapped_body) {
+    if (num_to_write > static_cast<size_t>(kMappedBodySegmentSize))
+      num_to_write = kMappedBodySegmentSize;
+    SendMappedDataFrame(mci->file_data, mci->body_bytes_consumed,
+                        num_to_write);
+  } else {
+    if (num_to_write > mci->max_segment_size)
+      num_to_write = mci->max_segment_size;
+    SendDataFrame(mci->stream_id,
+                  mci->file_data->body_data() + mci->body_bytes_consumed,
+                  num_to_write, 0, true);
+  }
   VLOG(2) << ACCEPTOR_CLIENT_IDENT << "HttpSM: GetOutput SendDataFrame["
           << mci->stream_id << "]: " << num_to_write;
   mci->body_bytes_consumed += num_to_write;
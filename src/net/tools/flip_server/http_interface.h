@@ -20,6 +20,7 @@ class DataFrame;
 class EpollServer;
 class FlipAcceptor;
 class MemoryCache;
+struct FileData;
 
 class HttpSM : public BalsaVisitorInterface,
                public SMInterface {
@@ -111,6 +112,11 @@ class HttpSM : public BalsaVisitorInterface,
   size_t SendSynStreamImpl(uint32 stream_id, const BalsaHeaders& headers);
   void SendDataFrameImpl(uint32 stream_id, const char* data, int64 len,
                          uint32 flags, bool compress);
+  // Sends |len| bytes of the mapped body of |file_data|, starting at
+  // |offset|, as one chunk. The body is not copied: the frame refers to the
+  // mapping and to the file, so that plain connections can use sendfile().
+  void SendMappedDataFrame(const FileData* file_data, size_t offset,
+                           size_t len);
   void EnqueueDataFrame(DataFrame* df);
   virtual void GetOutput();
 
@@ -0,0 +1,278 @@
+// Copyright (c) 2011 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// This command-line program measures how fast HTTP responses are parsed by
+// the BalsaFrame of the flip server, by HttpParser alone (the start line and
+// header lines are reported to a visitor that does nothing with them), and by
+// the code that HttpStreamParser runs for every response: HttpParser, the
+// HttpResponseHeaders built from the assembled headers, and the chunked body
+// decoded in place. For each parser it reports the throughput and the number
+// of memory allocations per response.
+//
+// Usage: http_parser_benchmark [--requests=<number of responses to parse>]
+//                              [--body=<body bytes per response>]
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <algorithm>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "base/at_exit.h"
+#include "base/command_line.h"
+#include "base/logging.h"
+#include "base/memory/ref_counted.h"
+#include "base/string_number_conversions.h"
+#include "base/stringprintf.h"
+#include "base/time.h"
+#include "net/http/http_parser.h"
+#include "net/http/http_response_headers.h"
+#include "net/http/http_util.h"
+#include "net/tools/flip_server/balsa_frame.h"
+#include "net/tools/flip_server/balsa_headers.h"
+
+namespace {
+
+// The number of calls to operator new so far.
+int g_allocations = 0;
+
+}  // namespace
+
+void* operator new(size_t size) throw(std::bad_alloc) {
+  ++g_allocations;
+  void* p = malloc(size ? size : 1);
+  CHECK(p);
+  return p;
+}
+
+void operator delete(void* p) throw() {
+  free(p);
+}
+
+void* operator new[](size_t size) throw(std::bad_alloc) {
+  return operator new(size);
+}
+
+void operator delete[](void* p) throw() {
+  operator delete(p);
+}
+
+namespace {
+
+enum Errors {
+  GENERIC = -1,
+  ALL_GOOD = 0,
+  INVALID_ARGUMENT = 1,
+};
+
+const char kHeaders[] =
+    "HTTP/1.1 200 OK\r\n"
+    "Date: Wed, 14 Sep 2011 12:12:12 GMT\r\n"
+    "Expires: -1\r\n"
+    "Cache-Control: private, max-age=0\r\n"
+    "Content-Type: text/html; charset=UTF-8\r\n"
+    "Set-Cookie: PREF=ID=0123456789abcdef:FF=0:TM=1316000000; "
+    "expires=Fri, 13-Sep-2013 12:12:12 GMT; path=/; domain=.example.com\r\n"
+    "P3P: CP=\"This is not a P3P policy!\"\r\n"
+    "Server: gws\r\n"
+    "Transfer-Encoding: chunked\r\n"
+    "X-XSS-Protection: 1; mode=block\r\n"
+    "X-Frame-Options: SAMEORIGIN\r\n\r\n";
+
+// The size of the chunks of the body.
+const int kChunkSize = 4096;
+
+// Returns a response with a chunked body of |body_size| bytes.
+std::string BuildResponse(int body_size) {
+  std::string response(kHeaders);
+  while (body_size > 0) {
+    int chunk_size = std::min(body_size, kChunkSize);
+    response.append(base::StringPrintf("%x\r\n", chunk_size));
+    response.append(chunk_size, 'x');
+    response.append("\r\n");
+    body_size -= chunk_size;
+  }
+  response.append("0\r\n\r\n");
+  return response;
+}
+
+// Ignores everything but the body data.
+class BodyCounter : public net::BalsaVisitorInterface,
+                    public net::HttpParser::Visitor {
+ public:
+  BodyCounter() : body_bytes_(0) {}
+
+  int64 body_bytes() const { return body_bytes_; }
+
+  // BalsaVisitorInterface:
+  virtual void ProcessBodyInput(const char* input, size_t size) {}
+  virtual void ProcessBodyData(const char* input, size_t size) {
+    body_bytes_ += size;
+  }
+  virtual void ProcessHeaderInput(const char* input, size_t size) {}
+  virtual void ProcessTrailerInput(const char* input, size_t size) {}
+  virtual void ProcessHeaders(const net::BalsaHeaders& headers) {}
+  virtual void ProcessRequestFirstLine(const char* line_input,
+                                       size_t line_length,
+                                       const char* method_input,
+                                       size_t method_length,
+                                       const char* request_uri_input,
+                                       size_t request_uri_length,
+                                       const char* version_input,
+                                       size_t version_length) {}
+  virtual void ProcessResponseFirstLine(const char* line_input,
+                                        size_t line_length,
+                                        const char* version_input,
+                                        size_t version_length,
+                                        const char* status_input,
+                                        size_t status_length,
+                                        const char* reason_input,
+                                        size_t reason_length) {}
+  virtual void ProcessChunkLength(size_t chunk_length) {}
+  virtual void ProcessChunkExtensions(const char* input, size_t size) {}
+  virtual void HeaderDone() {}
+  virtual void MessageDone() {}
+  virtual void HandleHeaderError(net::BalsaFrame* framer) {}
+  virtual void HandleHeaderWarning(net::BalsaFrame* framer) {}
+  virtual void HandleChunkingError(net::BalsaFrame* framer) {}
+  virtual void HandleBodyError(net::BalsaFrame* framer) {}
+
+  // HttpParser::Visitor:
+  virtual void OnBodyData(const base::StringPiece& data) {
+    body_bytes_ += data.size();
+  }
+
+ private:
+  int64 body_bytes_;
+};
+
+// Parses |requests| copies of |response| with BalsaFrame.
+bool ParseWithBalsa(const std::string& response, int requests,
+                    int64* body_bytes) {
+  BodyCounter counter;
+  net::BalsaHeaders headers;
+  net::BalsaFrame framer;
+  framer.set_balsa_headers(&headers);
+  framer.set_balsa_visitor(&counter);
+  framer.set_is_request(false);
+  for (int i = 0; i < requests; ++i) {
+    framer.Reset();
+    size_t consumed = framer.ProcessInput(response.data(), response.size());
+    if (consumed < response.size())
+      consumed += framer.ProcessInput(response.data() + consumed,
+                                      response.size() - consumed);
+    if (consumed != response.size() || !framer.MessageFullyRead())
+      return false;
+  }
+  *body_bytes = counter.body_bytes();
+  return true;
+}
+
+// Parses |requests| copies of |response| with HttpParser.
+bool ParseWithHttpParser(const std::string& response, int requests,
+                         int64* body_bytes) {
+  BodyCounter counter;
+  net::HttpParser parser(&counter);
+  for (int i = 0; i < requests; ++i) {
+    parser.Reset();
+    int end = parser.FindEndOfHeaders(response.data(), response.size(), 0);
+    if (end < 0)
+      return false;
+    parser.ParseHeaders(response.data(), end);
+    int rv = parser.ParseChunkedBody(response.data() + end,
+                                     response.size() - end);
+    if (rv != static_cast<int>(response.size()) - end ||
+        !parser.IsChunkedBodyComplete()) {
+      return false;
+    }
+  }
+  *body_bytes = counter.body_bytes();
+  return true;
+}
+
+// Parses |requests| copies of |response| like HttpStreamParser does.
+bool ParseWithStreamParser(const std::string& response, int requests,
+                           int64* body_bytes) {
+  // The body is decoded in place in the read buffer.
+  std::vector<char> buffer(response.begin(), response.end());
+  net::HttpParser parser(NULL);
+  *body_bytes = 0;
+  for (int i = 0; i < requests; ++i) {
+    parser.Reset();
+    std::copy(response.begin(), response.end(), buffer.begin());
+    int end = parser.FindEndOfHeaders(&buffer[0], buffer.size(), 0);
+    if (end < 0)
+      return false;
+    scoped_refptr<net::HttpResponseHeaders> headers(
+        new net::HttpResponseHeaders(
+            net::HttpUtil::AssembleRawHeaders(&buffer[0], end)));
+    if (!headers->HasHeaderValue("Transfer-Encoding", "chunked"))
+      return false;
+    int rv = parser.FilterChunkedBody(&buffer[end], buffer.size() - end);
+    if (rv < 0 || !parser.IsChunkedBodyComplete())
+      return false;
+    *body_bytes += rv;
+  }
+  return true;
+}
+
+typedef bool (*ParseFunction)(const std::string& response, int requests,
+                              int64* body_bytes);
+
+// Runs |function| and prints the results for |name|. |body_size| is the size
+// of the body of |response|.
+bool RunBenchmark(const char* name, ParseFunction function,
+                  const std::string& response, int body_size, int requests) {
+  int64 body_bytes = 0;
+  int allocations = g_allocations;
+  base::TimeTicks start = base::TimeTicks::Now();
+  if (!function(response, requests, &body_bytes))
+    return false;
+  base::TimeDelta elapsed = base::TimeTicks::Now() - start;
+  allocations = g_allocations - allocations;
+
+  double megabytes =
+      static_cast<double>(response.size()) * requests / (1024 * 1024);
+  printf("%-14s responses: %d, time: %.2fs, throughput: %.1f MB/s, "
+         "%.1f us/response, allocations: %.2f per response\n", name, requests,
+         elapsed.InSecondsF(), megabytes / elapsed.InSecondsF(),
+         elapsed.InMicroseconds() / static_cast<double>(requests),
+         static_cast<double>(allocations) / requests);
+  return body_bytes == static_cast<int64>(body_size) * requests;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  base::AtExitManager at_exit_manager;
+  CommandLine::Init(argc, argv);
+  const CommandLine& command_line = *CommandLine::ForCurrentProcess();
+
+  int requests = 200000;
+  int body_size = 16 * 1024;
+  if ((command_line.HasSwitch("requests") &&
+       !base::StringToInt(command_line.GetSwitchValueASCII("requests"),
+                          &requests)) ||
+      (command_line.HasSwitch("body") &&
+       !base::StringToInt(command_line.GetSwitchValueASCII("body"),
+                          &body_size)) ||
+      requests <= 0 || body_size < 0) {
+    printf("Usage: http_parser_benchmark [--requests=<number of responses>] "
+           "[--body=<body bytes per response>]\n");
+    return INVALID_ARGUMENT;
+  }
+
+  std::string response = BuildResponse(body_size);
+  if (!RunBenchmark("balsa", &ParseWithBalsa, response, body_size,
+                    requests) ||
+      !RunBenchmark("http_parser", &ParseWithHttpParser, response, body_size,
+                    requests) ||
+      !RunBenchmark("stream_parser", &ParseWithStreamParser, response,
+                    body_size, requests)) {
+    return GENERIC;
+  }
+  return ALL_GOOD;
+}
@@ -8,8 +8,10 @@
 #include <errno.h>
 #include <fcntl.h>
 #include <stdio.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
 #include <sys/types.h>
+#include <unistd.h>
 
 #include <deque>
 
@@ -46,10 +48,21 @@ void StoreBodyAndHeadersVisitor::HandleBodyError(BalsaFrame* framer) {
 }
 
 FileData::FileData(BalsaHeaders* h, const std::string& b)
-    : headers(h), body(b) {
+    : headers(h),
+      body(b),
+      mapped_body(NULL),
+      mapped_body_size(0),
+      fd(-1),
+      body_offset(0) {
 }
 
-FileData::FileData() {}
+FileData::FileData()
+    : headers(NULL),
+      mapped_body(NULL),
+      mapped_body_size(0),
+      fd(-1),
+      body_offset(0) {
+}
 
 FileData::~FileData() {}
 
@@ -59,9 +72,13 @@ void FileData::CopyFrom(const FileData& file_data) {
     filename = file_data.filename;
     related_files = file_data.related_files;
     body = file_data.body;
+    mapped_body = file_data.mapped_body;
+    mapped_body_size = file_data.mapped_body_size;
+    fd = file_data.fd;
+    body_offset = file_data.body_offset;
   }
 
-MemoryCache::MemoryCache() {}
+MemoryCache::MemoryCache() : map_files_(false) {}
 
 MemoryCache::~MemoryCache() {}
 
@@ -201,6 +218,35 @@ void MemoryCache::ReadAndStoreFileContents(const char* filename) {
   fd = FileData(headers, visitor.body);
   fd.filename = std::string(filename_stripped,
                             filename_stripped.find_first_of('/'));
+
+  // The body can only be served from the file if it was stored verbatim (not
+  // chunked) at the end of the capture.
+  if (map_files_ && !fd.body.empty() &&
+      filename_contents.size() >= fd.body.size() &&
+      filename_contents.compare(filename_contents.size() - fd.body.size(),
+                                fd.body.size(), fd.body) == 0) {
+    MapBody(filename, filename_contents.size(), &fd);
+  }
+}
+
+bool MemoryCache::MapBody(const char* filename, size_t file_size,
+                          FileData* file_data) {
+  int fd = open(filename, O_RDONLY);
+  if (fd == -1)
+    return false;
+  void* address = mmap(NULL, file_size, PROT_READ, MAP_SHARED, fd, 0);
+  if (address == MAP_FAILED) {
+    LOG(ERROR) << "Unable to map " << filename << ": " << strerror(errno);
+    close(fd);
+    return false;
+  }
+  file_data->body_offset = file_size - file_data->body.size();
+  file_data->mapped_body = static_cast<const char*>(address) +
+                           file_data->body_offset;
+  file_data->mapped_body_size = file_data->body.size();
+  file_data->fd = fd;
+  std::string().swap(file_data->body);
+  return true;
 }
 
 FileData* MemoryCache::GetFileData(const std::string& filename) {
@@ -5,10 +5,12 @@
 #ifndef NET_TOOLS_FLIP_SERVER_MEM_CACHE_H_
 #define NET_TOOLS_FLIP_SERVER_MEM_CACHE_H_
 
-#include <map>
+#include <sys/types.h>
+
 #include <string>
 #include <vector>
 
+#include "base/hash_tables.h"
 #include "net/tools/flip_server/balsa_headers.h"
 #include "net/tools/flip_server/balsa_visitor_interface.h"
 #include "net/tools/flip_server/constants.h"
@@ -66,11 +68,28 @@ struct FileData {
   ~FileData();
   void CopyFrom(const FileData& file_data);
 
+  // The body of the response, either |body| or the mapped region of the
+  // capture file.
+  const char* body_data() const {
+    return mapped_body ? mapped_body : body.data();
+  }
+  size_t body_size() const {
+    return mapped_body ? mapped_body_size : body.size();
+  }
+
   BalsaHeaders* headers;
   std::string filename;
   // priority, filename
   std::vector< std::pair<int, std::string> > related_files;
   std::string body;
+
+  // Set instead of |body| when the cache maps its files. The body is found at
+  // |body_offset| of the capture file, which stays open as |fd| so that plain
+  // connections can send it with sendfile().
+  const char* mapped_body;
+  size_t mapped_body_size;
+  int fd;
+  off_t body_offset;
 };
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -104,14 +123,26 @@ class MemCacheIter {
 
 ////////////////////////////////////////////////////////////////////////////////
 
+// Holds the responses served by the SPDY and HTTP server acceptors, indexed by
+// file name. The cache is filled by AddFiles() before the acceptor threads
+// start, and it is only read afterwards, so any number of threads can look up
+// files concurrently without taking a lock. Lookups are done for every
+// request, so the index is a hash table rather than a sorted map.
 class MemoryCache {
  public:
-  typedef std::map<std::string, FileData> Files;
+  typedef base::hash_map<std::string, FileData> Files;
 
  public:
   MemoryCache();
   ~MemoryCache();
 
+  // If true, AddFiles() maps the capture files instead of copying the bodies
+  // to the heap. The mappings are shared by the copies made by CloneFrom(),
+  // and they are kept for the life of the process.
+  void set_map_files(bool map_files) { map_files_ = map_files; }
+
+  // Makes a deep copy of |mc|, so that an acceptor thread can serve from a
+  // copy of the cache that is local to its memory node.
   void CloneFrom(const MemoryCache& mc);
 
   void AddFiles();
@@ -126,6 +157,14 @@ class MemoryCache {
 
   Files files_;
   std::string cwd_;
+
+ private:
+  // Maps |filename|, whose last |file_data|->body.size() bytes are the body,
+  // and makes |file_data| serve the body from the mapping. Returns false if
+  // the file cannot be mapped, in which case |file_data| is not modified.
+  bool MapBody(const char* filename, size_t file_size, FileData* file_data);
+
+  bool map_files_;
 };
 
 class NotifierInterface {
@@ -6,6 +6,7 @@
 
 #include <errno.h>
 #include <netinet/tcp.h>
+#include <sys/sendfile.h>
 #include <sys/socket.h>
 
 #include <list>
@@ -224,6 +225,15 @@ int SMConnection::Send(const char* data, int len, int flags) {
   return rv;
 }
 
+int SMConnection::SendFile(int file_fd, off_t offset, int len, int flags) {
+  DCHECK(!ssl_);
+  CorkSocket();
+  int rv = sendfile(fd_, file_fd, &offset, len);
+  if (!(flags & MSG_MORE))
+    UncorkSocket();
+  return rv;
+}
+
 void SMConnection::OnRegistration(EpollServer* eps, int fd, int event_mask) {
   registered_in_epoll_server_ = true;
 }
@@ -575,7 +585,14 @@ bool SMConnection::DoWrite() {
       flags |= MSG_MORE;
     }
     VLOG(2) << log_prefix_ << "Attempting to send " << size << " bytes.";
-    ssize_t bytes_written = Send(bytes, size, flags);
+    ssize_t bytes_written;
+    if (data_frame->file_fd != -1 && !ssl_) {
+      bytes_written = SendFile(data_frame->file_fd,
+                               data_frame->file_offset + data_frame->index,
+                               size, flags);
+    } else {
+      bytes_written = Send(bytes, size, flags);
+    }
     int stored_errno = errno;
     if (bytes_written == -1) {
       switch (stored_errno) {
@@ -31,7 +31,17 @@ class DataFrame {
   size_t size;
   bool delete_when_done;
   size_t index;
-  DataFrame() : data(NULL), size(0), delete_when_done(false), index(0) {}
+  // If not -1, |data| is a mapping of |file_fd| at |file_offset|, and plain
+  // connections send the frame with sendfile() instead.
+  int file_fd;
+  off_t file_offset;
+  DataFrame()
+      : data(NULL),
+        size(0),
+        delete_when_done(false),
+        index(0),
+        file_fd(-1),
+        file_offset(0) {}
   virtual ~DataFrame();
 };
 
@@ -78,6 +88,10 @@ class SMConnection : public SMConnectionInterface,
 
   int Send(const char* data, int len, int flags);
 
+  // Sends |len| bytes of |file_fd|, starting at |offset|, with sendfile().
+  // Only for connections without SSL.
+  int SendFile(int file_fd, off_t offset, int len, int flags);
+
   // EpollCallbackInterface interface.
   virtual void OnRegistration(EpollServer* eps, int fd, int event_mask);
   virtual void OnModification(int fd, int event_mask) {}
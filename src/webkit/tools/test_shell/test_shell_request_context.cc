@@ -97,7 +97,7 @@ void TestShellRequestContext::Init(
                          origin_bound_cert_service(), NULL, NULL,
                          proxy_service(), ssl_config_service(),
                          http_auth_handler_factory(), NULL,
-                         http_server_properties(), NULL,
+                         http_server_properties(), NULL, NULL,
                          backend);
 
   cache->set_mode(cache_mode);